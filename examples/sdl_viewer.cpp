@@ -23,9 +23,6 @@
 # endif
 
 # include <iostream>
-# include <fstream>
-# include <boost/algorithm/string/predicate.hpp>
-# include <boost/utility.hpp>
 # include <SDL.h>
 # include <openvrml/browser.h>
 # include <openvrml/gl/viewer.h>
@@ -39,13 +36,6 @@ extern "C" Uint32 update_timer_callback(Uint32 interval, void * param);
 
 namespace {
 
-    class resource_fetcher : public openvrml::resource_fetcher {
-    private:
-        virtual std::auto_ptr<openvrml::resource_istream>
-        do_get_resource(const std::string & uri);
-    };
-
-
     class sdl_error : public std::runtime_error {
     public:
         explicit sdl_error(const std::string & message);
@@ -103,7 +93,7 @@ int main(int argc, char * argv[])
         const string url = argv[1];
 
         sdl_viewer v(url);
-        resource_fetcher fetcher;
+        openvrml::file_resource_fetcher fetcher;
         openvrml::browser b(fetcher, std::cout, std::cerr);
         b.viewer(&v);
 
@@ -137,119 +127,6 @@ int main(int argc, char * argv[])
 
 namespace {
 
-    std::auto_ptr<openvrml::resource_istream>
-    resource_fetcher::do_get_resource(const std::string & uri)
-    {
-        using std::auto_ptr;
-        using std::invalid_argument;
-        using std::string;
-        using openvrml::resource_istream;
-
-        class file_resource_istream : public resource_istream {
-            std::string url_;
-            std::filebuf buf_;
-
-        public:
-            explicit file_resource_istream(const std::string & path):
-                resource_istream(&this->buf_)
-            {
-                if (!this->buf_.open(path.c_str(),
-                                     ios_base::in | ios_base::binary)) {
-                    this->setstate(ios_base::badbit);
-                }
-            }
-
-            void url(const std::string & str) throw (std::bad_alloc)
-            {
-                this->url_ = str;
-            }
-
-        private:
-            virtual const std::string do_url() const throw ()
-            {
-                return this->url_;
-            }
-
-            virtual const std::string do_type() const throw ()
-            {
-                //
-                // A real application should use OS facilities for this.  This
-                // is a crude hack because sdl-viewer uses std::filebuf in
-                // order to remain simple and portable.
-                //
-                using std::find;
-                using std::string;
-                using boost::algorithm::iequals;
-                string media_type = "application/octet-stream";
-                const string::const_reverse_iterator dot_pos =
-                    find(this->url_.rbegin(), this->url_.rend(), '.');
-                if (dot_pos == this->url_.rend()
-                    || boost::next(dot_pos.base()) == this->url_.end()) {
-                    return media_type;
-                }
-                const string::const_iterator hash_pos =
-                    find(boost::next(dot_pos.base()), this->url_.end(), '#');
-                const string ext(dot_pos.base(), hash_pos);
-                if (iequals(ext, "wrl")) {
-                    media_type = openvrml::vrml_media_type;
-                } else if (iequals(ext, "x3dv")) {
-                    media_type = openvrml::x3d_vrml_media_type;
-                } else if (iequals(ext, "png")) {
-                    media_type = "image/png";
-                } else if (iequals(ext, "jpg") || iequals(ext, "jpeg")) {
-                    media_type = "image/jpeg";
-                } else if (iequals(ext, "class")) {
-                    media_type = "application/java";
-                } else if (iequals(ext, "js")) {
-                    media_type = "application/javascript";
-                }
-                return media_type;
-            }
-
-            virtual bool do_data_available() const throw ()
-            {
-                return !!(*this);
-            }
-        };
-
-        const string scheme = uri.substr(0, uri.find_first_of(':'));
-        if (scheme != "file") {
-            throw invalid_argument('\"' + scheme + "\" URI scheme not "
-                                   "supported");
-        }
-
-        //
-        // file://
-        //        ^
-        // 01234567
-        static const string::size_type authority_start_index = 7;
-
-        //
-        // On Windows we want to start at the drive letter, which is after the
-        // first slash in the path.
-        //
-        // We ignore the content of the authority; a smarter implementation
-        // should confirm that it is localhost, the machine name, or zero
-        // length.
-        //
-        // We also don't do any translation of URI-encoded characters here.
-        // That means that things like paths with spaces in them aren't going
-        // to work.  Oh, well.
-        //
-        string::size_type path_start_index =
-# ifdef _WIN32
-            uri.find_first_of('/', authority_start_index) + 1;
-# else
-            uri.find_first_of('/', authority_start_index);
-# endif
-        string path = uri.substr(path_start_index);
-
-        auto_ptr<resource_istream> in(new file_resource_istream(path));
-        static_cast<file_resource_istream *>(in.get())->url(uri);
-
-        return in;
-    }
-
     sdl_error::sdl_error(const std::string & message):
         std::runtime_error(message)
     {}
@@ -0,0 +1,1237 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# include "geometry_cache.h"
+# include <boost/scoped_ptr.hpp>
+# include <algorithm>
+# include <cassert>
+# include <cstddef>
+# include <cstdio>
+# include <cstring>
+# include <string>
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+# if defined(_WIN32)
+// wglGetProcAddress is declared in <windows.h>.
+# elif defined(HAVE_GL_GLX_H)
+#   include <GL/glx.h>
+# elif defined(__APPLE__)
+#   include <dlfcn.h>
+# endif
+
+# if (defined(__CYGWIN__) && defined(X_DISPLAY_MISSING)) || defined(__MINGW32__)
+#   define OPENVRML_GL_APIENTRY_ __attribute__ ((__stdcall__))
+# elif defined (_WIN32)
+#   define OPENVRML_GL_APIENTRY_ APIENTRY
+# else
+#   define OPENVRML_GL_APIENTRY_
+# endif
+
+# ifndef GL_ARRAY_BUFFER
+#   define GL_ARRAY_BUFFER 0x8892
+# endif
+# ifndef GL_ELEMENT_ARRAY_BUFFER
+#   define GL_ELEMENT_ARRAY_BUFFER 0x8893
+# endif
+# ifndef GL_STATIC_DRAW
+#   define GL_STATIC_DRAW 0x88E4
+# endif
+
+extern "C" {
+    typedef void (OPENVRML_GL_APIENTRY_ * gl_proc_t)();
+    typedef void (OPENVRML_GL_APIENTRY_ * gl_gen_buffers_t)(GLsizei,
+                                                            GLuint *);
+    typedef void (OPENVRML_GL_APIENTRY_ * gl_delete_buffers_t)(
+        GLsizei, const GLuint *);
+    typedef void (OPENVRML_GL_APIENTRY_ * gl_bind_buffer_t)(GLenum, GLuint);
+    typedef void (OPENVRML_GL_APIENTRY_ * gl_buffer_data_t)(GLenum,
+                                                            std::ptrdiff_t,
+                                                            const GLvoid *,
+                                                            GLenum);
+    typedef void (OPENVRML_GL_APIENTRY_ * gl_buffer_sub_data_t)(
+        GLenum, std::ptrdiff_t, std::ptrdiff_t, const GLvoid *);
+}
+
+namespace {
+
+    OPENVRML_GL_LOCAL gl_proc_t get_proc_address(const std::string & name)
+    {
+# if defined(_WIN32)
+        return reinterpret_cast<gl_proc_t>(wglGetProcAddress(name.c_str()));
+# elif defined(HAVE_GL_GLX_H)
+        return reinterpret_cast<gl_proc_t>(
+            glXGetProcAddressARB(
+                reinterpret_cast<const GLubyte *>(name.c_str())));
+# elif defined(__APPLE__)
+        return reinterpret_cast<gl_proc_t>(dlsym(RTLD_DEFAULT, name.c_str()));
+# else
+        static_cast<void>(name);
+        return 0;
+# endif
+    }
+
+    //
+    // Buffer object entry points.  These are core in OpenGL 1.5; earlier
+    // implementations may provide them through GL_ARB_vertex_buffer_object.
+    //
+    class OPENVRML_GL_LOCAL buffer_functions {
+    public:
+        bool available;
+        gl_gen_buffers_t gen_buffers;
+        gl_delete_buffers_t delete_buffers;
+        gl_bind_buffer_t bind_buffer;
+        gl_buffer_data_t buffer_data;
+        gl_buffer_sub_data_t buffer_sub_data;
+
+        static const buffer_functions & instance()
+            OPENVRML_THROW1(std::bad_alloc);
+
+    private:
+        static boost::scoped_ptr<const buffer_functions> instance_;
+
+        buffer_functions();
+    };
+
+    boost::scoped_ptr<const buffer_functions> buffer_functions::instance_;
+
+    const buffer_functions & buffer_functions::instance()
+        OPENVRML_THROW1(std::bad_alloc)
+    {
+        if (!buffer_functions::instance_) {
+            buffer_functions::instance_.reset(new buffer_functions);
+        }
+        return *buffer_functions::instance_;
+    }
+
+    buffer_functions::buffer_functions():
+        available(false),
+        gen_buffers(0),
+        delete_buffers(0),
+        bind_buffer(0),
+        buffer_data(0),
+        buffer_sub_data(0)
+    {
+        const char * const version =
+            reinterpret_cast<const char *>(glGetString(GL_VERSION));
+        const char * const extensions =
+            reinterpret_cast<const char *>(glGetString(GL_EXTENSIONS));
+        int major = 0, minor = 0;
+        if (version) { std::sscanf(version, "%d.%d", &major, &minor); }
+
+        std::string suffix;
+        if (major < 1 || (major == 1 && minor < 5)) {
+            if (!extensions
+                || !std::strstr(extensions, "GL_ARB_vertex_buffer_object")) {
+                return;
+            }
+            suffix = "ARB";
+        }
+
+        this->gen_buffers = reinterpret_cast<gl_gen_buffers_t>(
+            get_proc_address("glGenBuffers" + suffix));
+        this->delete_buffers = reinterpret_cast<gl_delete_buffers_t>(
+            get_proc_address("glDeleteBuffers" + suffix));
+        this->bind_buffer = reinterpret_cast<gl_bind_buffer_t>(
+            get_proc_address("glBindBuffer" + suffix));
+        this->buffer_data = reinterpret_cast<gl_buffer_data_t>(
+            get_proc_address("glBufferData" + suffix));
+        this->buffer_sub_data = reinterpret_cast<gl_buffer_sub_data_t>(
+            get_proc_address("glBufferSubData" + suffix));
+        this->available = this->gen_buffers
+            && this->delete_buffers
+            && this->bind_buffer
+            && this->buffer_data
+            && this->buffer_sub_data;
+    }
+}
+
+
+/**
+ * @namespace openvrml::gl::local
+ *
+ * @internal
+ *
+ * @brief Implementation details of the OpenGL renderer.
+ */
+
+/**
+ * @internal
+ *
+ * @struct openvrml::gl::local::interleaved_vertex openvrml/gl/local/geometry_cache.h
+ *
+ * @brief A vertex as it is stored in a vertex buffer.
+ *
+ * The layout is that of @c GL_T2F_C3F_N3F_V3F, if there were such a thing;
+ * the arrays are set up with @c glTexCoordPointer, @c glColorPointer,
+ * @c glNormalPointer, and @c glVertexPointer, so that the attributes that
+ * were never given can be left disabled.
+ */
+
+/**
+ * @internal
+ *
+ * @class openvrml::gl::local::vertex_array_builder openvrml/gl/local/geometry_cache.h
+ *
+ * @brief Collects geometry specified in the manner of OpenGL immediate mode
+ *        into indexed vertex arrays.
+ *
+ * The functions mirror @c glBegin, @c glEnd, @c glColor3fv, @c glNormal3f,
+ * @c glTexCoord2f, and @c glVertex3f: each vertex takes the current color,
+ * normal, and texture coordinate.  Each primitive is converted to
+ * independent points, lines, or triangles, preserving its winding and its
+ * provoking vertex (so that flat shading is unchanged).  The few state
+ * changes geometry makes (the front face, the shade model, and disabling
+ * culling, lighting, or texturing) are recorded rather than executed.
+ */
+
+/**
+ * @internal
+ *
+ * @brief Construct.
+ */
+openvrml::gl::local::vertex_array_builder::vertex_array_builder()
+    OPENVRML_NOTHROW:
+    attributes_(0),
+    front_face_(GL_CCW),
+    shade_model_(GL_SMOOTH),
+    disabled_(0),
+    mode_(GL_POINTS),
+    primitive_begin_(0)
+{
+    static const interleaved_vertex initial = {
+        { 0.0f, 0.0f },
+        { 1.0f, 1.0f, 1.0f },
+        { 0.0f, 0.0f, 1.0f },
+        { 0.0f, 0.0f, 0.0f }
+    };
+    this->current_ = initial;
+}
+
+/**
+ * @internal
+ *
+ * @brief Record the front face.
+ *
+ * @param[in] mode  @c GL_CCW or @c GL_CW.
+ */
+void openvrml::gl::local::vertex_array_builder::front_face(const GLenum mode)
+    OPENVRML_NOTHROW
+{
+    this->front_face_ = mode;
+}
+
+/**
+ * @internal
+ *
+ * @brief Record the shade model.
+ *
+ * @param[in] mode  @c GL_SMOOTH or @c GL_FLAT.
+ */
+void openvrml::gl::local::vertex_array_builder::shade_model(const GLenum mode)
+    OPENVRML_NOTHROW
+{
+    this->shade_model_ = mode;
+}
+
+/**
+ * @internal
+ *
+ * @brief Record that a capability is disabled.
+ *
+ * @param[in] cap   @c GL_CULL_FACE, @c GL_LIGHTING, or @c GL_TEXTURE_2D.
+ */
+void openvrml::gl::local::vertex_array_builder::disable(const GLenum cap)
+    OPENVRML_NOTHROW
+{
+    switch (cap) {
+    case GL_CULL_FACE:
+        this->disabled_ |= cull_face_capability;
+        break;
+    case GL_LIGHTING:
+        this->disabled_ |= lighting_capability;
+        break;
+    case GL_TEXTURE_2D:
+        this->disabled_ |= texture_2d_capability;
+        break;
+    default:
+        assert(false);
+    }
+}
+
+/**
+ * @internal
+ *
+ * @brief Begin a primitive.
+ *
+ * @param[in] mode  the primitive type, as for @c glBegin.
+ */
+void openvrml::gl::local::vertex_array_builder::begin(const GLenum mode)
+    OPENVRML_NOTHROW
+{
+    this->mode_ = mode;
+    this->primitive_begin_ = this->vertices_.size();
+}
+
+/**
+ * @internal
+ *
+ * @brief End a primitive.
+ *
+ * Incomplete primitives are dropped, as OpenGL drops them.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void openvrml::gl::local::vertex_array_builder::end()
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    const GLuint v = GLuint(this->primitive_begin_);
+    const std::size_t n = this->vertices_.size() - this->primitive_begin_;
+    const std::size_t first = this->indices_.size();
+    std::vector<GLuint> & index = this->indices_;
+
+    GLenum mode = GL_TRIANGLES;
+    switch (this->mode_) {
+    case GL_POINTS:
+        mode = GL_POINTS;
+        for (GLuint i = 0; i < n; ++i) { index.push_back(v + i); }
+        break;
+    case GL_LINES:
+        mode = GL_LINES;
+        for (GLuint i = 0; i + 1 < n; i += 2) {
+            index.push_back(v + i);
+            index.push_back(v + i + 1);
+        }
+        break;
+    case GL_LINE_STRIP:
+    case GL_LINE_LOOP:
+        mode = GL_LINES;
+        for (GLuint i = 0; i + 1 < n; ++i) {
+            index.push_back(v + i);
+            index.push_back(v + i + 1);
+        }
+        if (this->mode_ == GL_LINE_LOOP && n > 2) {
+            index.push_back(GLuint(v + n - 1));
+            index.push_back(v);
+        }
+        break;
+    case GL_TRIANGLES:
+        for (GLuint i = 0; i + 2 < n; i += 3) {
+            index.push_back(v + i);
+            index.push_back(v + i + 1);
+            index.push_back(v + i + 2);
+        }
+        break;
+    case GL_TRIANGLE_STRIP:
+        for (GLuint i = 0; i + 2 < n; ++i) {
+            index.push_back(v + ((i % 2) ? i + 1 : i));
+            index.push_back(v + ((i % 2) ? i : i + 1));
+            index.push_back(v + i + 2);
+        }
+        break;
+    case GL_TRIANGLE_FAN:
+        for (GLuint i = 1; i + 1 < n; ++i) {
+            index.push_back(v);
+            index.push_back(v + i);
+            index.push_back(v + i + 1);
+        }
+        break;
+    case GL_POLYGON:
+        //
+        // The provoking vertex of a polygon is its first.
+        //
+        for (GLuint i = 1; i + 1 < n; ++i) {
+            index.push_back(v + i);
+            index.push_back(v + i + 1);
+            index.push_back(v);
+        }
+        break;
+    case GL_QUADS:
+        for (GLuint i = 0; i + 3 < n; i += 4) {
+            index.push_back(v + i);
+            index.push_back(v + i + 1);
+            index.push_back(v + i + 3);
+            index.push_back(v + i + 1);
+            index.push_back(v + i + 2);
+            index.push_back(v + i + 3);
+        }
+        break;
+    case GL_QUAD_STRIP:
+        for (GLuint i = 0; i + 3 < n; i += 2) {
+            index.push_back(v + i);
+            index.push_back(v + i + 1);
+            index.push_back(v + i + 3);
+            index.push_back(v + i + 2);
+            index.push_back(v + i);
+            index.push_back(v + i + 3);
+        }
+        break;
+    default:
+        assert(false);
+    }
+
+    this->add_batch(mode, this->indices_.size() - first);
+}
+
+/**
+ * @internal
+ *
+ * @brief Append indices to the last batch, or start a new one.
+ *
+ * @param[in] mode  the primitive type of the indices.
+ * @param[in] count the number of indices.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void
+openvrml::gl::local::vertex_array_builder::add_batch(const GLenum mode,
+                                                     const std::size_t count)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    if (count == 0) { return; }
+    if (!this->batches_.empty() && this->batches_.back().mode == mode) {
+        this->batches_.back().count += count;
+        return;
+    }
+    const batch b = { mode, this->indices_.size() - count, count };
+    this->batches_.push_back(b);
+}
+
+/**
+ * @internal
+ *
+ * @brief Set the current color.
+ *
+ * @param[in] rgb   a color.
+ */
+void
+openvrml::gl::local::vertex_array_builder::color(const GLfloat * const rgb)
+    OPENVRML_NOTHROW
+{
+    std::copy(rgb, rgb + 3, this->current_.color);
+    this->attributes_ |= color_attribute;
+}
+
+/**
+ * @internal
+ *
+ * @brief Set the current normal.
+ *
+ * @param[in] x x-component.
+ * @param[in] y y-component.
+ * @param[in] z z-component.
+ */
+void openvrml::gl::local::vertex_array_builder::normal(const GLfloat x,
+                                                       const GLfloat y,
+                                                       const GLfloat z)
+    OPENVRML_NOTHROW
+{
+    this->current_.normal[0] = x;
+    this->current_.normal[1] = y;
+    this->current_.normal[2] = z;
+    this->attributes_ |= normal_attribute;
+}
+
+/**
+ * @internal
+ *
+ * @brief Set the current normal.
+ *
+ * @param[in] n a normal.
+ */
+void
+openvrml::gl::local::vertex_array_builder::normal(const GLfloat * const n)
+    OPENVRML_NOTHROW
+{
+    this->normal(n[0], n[1], n[2]);
+}
+
+/**
+ * @internal
+ *
+ * @brief Set the current texture coordinate.
+ *
+ * @param[in] s s-component.
+ * @param[in] t t-component.
+ */
+void openvrml::gl::local::vertex_array_builder::tex_coord(const GLfloat s,
+                                                          const GLfloat t)
+    OPENVRML_NOTHROW
+{
+    this->current_.tex_coord[0] = s;
+    this->current_.tex_coord[1] = t;
+    this->attributes_ |= tex_coord_attribute;
+}
+
+/**
+ * @internal
+ *
+ * @brief Set the current texture coordinate.
+ *
+ * @param[in] st    a texture coordinate.
+ */
+void
+openvrml::gl::local::vertex_array_builder::tex_coord(const GLfloat * const st)
+    OPENVRML_NOTHROW
+{
+    this->tex_coord(st[0], st[1]);
+}
+
+/**
+ * @internal
+ *
+ * @brief Add a vertex with the current attributes.
+ *
+ * @param[in] x x-coordinate.
+ * @param[in] y y-coordinate.
+ * @param[in] z z-coordinate.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void openvrml::gl::local::vertex_array_builder::vertex(const GLfloat x,
+                                                       const GLfloat y,
+                                                       const GLfloat z)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    this->current_.coord[0] = x;
+    this->current_.coord[1] = y;
+    this->current_.coord[2] = z;
+    this->vertices_.push_back(this->current_);
+}
+
+/**
+ * @internal
+ *
+ * @brief Add a vertex with the current attributes.
+ *
+ * @param[in] v a coordinate.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void
+openvrml::gl::local::vertex_array_builder::vertex(const GLfloat * const v)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    this->vertex(v[0], v[1], v[2]);
+}
+
+/**
+ * @internal
+ *
+ * @brief Add a vertex with the current attributes.
+ *
+ * @param[in] v a coordinate.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void
+openvrml::gl::local::vertex_array_builder::vertex(const GLdouble * const v)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    this->vertex(GLfloat(v[0]), GLfloat(v[1]), GLfloat(v[2]));
+}
+
+/**
+ * @internal
+ *
+ * @brief Add the triangles of a @c compiled_mesh.
+ *
+ * The mesh's vertices are added with the attributes it has; its
+ * orientation and whether it is solid are recorded as the front face and
+ * whether culling is disabled.
+ *
+ * @param[in] mesh  a mesh.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void
+openvrml::gl::local::vertex_array_builder::
+triangles(const compiled_mesh & mesh)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    this->front_face(mesh.ccw ? GL_CCW : GL_CW);
+    if (!mesh.solid) { this->disable(GL_CULL_FACE); }
+
+    const GLuint first = GLuint(this->vertices_.size());
+    for (std::size_t i = 0; i < mesh.coord.size(); ++i) {
+        if (!mesh.color.empty()) { this->color(&mesh.color[i][0]); }
+        if (!mesh.normal.empty()) { this->normal(&mesh.normal[i][0]); }
+        if (!mesh.tex_coord.empty()) {
+            this->tex_coord(&mesh.tex_coord[i][0]);
+        }
+        this->vertex(&mesh.coord[i][0]);
+    }
+
+    for (std::size_t i = 0; i < mesh.triangle_index.size(); ++i) {
+        this->indices_.push_back(first + GLuint(mesh.triangle_index[i]));
+    }
+    this->add_batch(GL_TRIANGLES, mesh.triangle_index.size());
+}
+
+/**
+ * @internal
+ *
+ * @brief The vertices.
+ *
+ * @return the vertices.
+ */
+const std::vector<openvrml::gl::local::interleaved_vertex> &
+openvrml::gl::local::vertex_array_builder::vertices() const OPENVRML_NOTHROW
+{
+    return this->vertices_;
+}
+
+/**
+ * @internal
+ *
+ * @brief The indices of the points, lines, and triangles.
+ *
+ * @return the indices.
+ */
+std::vector<GLuint> &
+openvrml::gl::local::vertex_array_builder::indices() OPENVRML_NOTHROW
+{
+    return this->indices_;
+}
+
+/**
+ * @internal
+ *
+ * @brief The ranges of @c #indices to draw with each primitive type.
+ *
+ * @return the batches.
+ */
+const std::vector<openvrml::gl::local::vertex_array_builder::batch> &
+openvrml::gl::local::vertex_array_builder::batches() const OPENVRML_NOTHROW
+{
+    return this->batches_;
+}
+
+/**
+ * @internal
+ *
+ * @brief The vertex attributes that were given.
+ *
+ * @return a bit mask of @c #attribute values.
+ */
+unsigned int openvrml::gl::local::vertex_array_builder::attributes() const
+    OPENVRML_NOTHROW
+{
+    return this->attributes_;
+}
+
+/**
+ * @internal
+ *
+ * @brief The front face.
+ *
+ * @return the front face.
+ */
+GLenum openvrml::gl::local::vertex_array_builder::front_face() const
+    OPENVRML_NOTHROW
+{
+    return this->front_face_;
+}
+
+/**
+ * @internal
+ *
+ * @brief The shade model.
+ *
+ * @return the shade model.
+ */
+GLenum openvrml::gl::local::vertex_array_builder::shade_model() const
+    OPENVRML_NOTHROW
+{
+    return this->shade_model_;
+}
+
+/**
+ * @internal
+ *
+ * @brief The capabilities to disable.
+ *
+ * @return a bit mask of @c #capability values.
+ */
+unsigned int openvrml::gl::local::vertex_array_builder::disabled() const
+    OPENVRML_NOTHROW
+{
+    return this->disabled_;
+}
+
+/**
+ * @internal
+ *
+ * @brief Compare batches for equality.
+ *
+ * @param[in] lhs
+ * @param[in] rhs
+ *
+ * @return @c true if @p lhs and @p rhs are equal; @c false otherwise.
+ */
+bool
+openvrml::gl::local::operator==(const vertex_array_builder::batch & lhs,
+                                const vertex_array_builder::batch & rhs)
+    OPENVRML_NOTHROW
+{
+    return lhs.mode == rhs.mode
+        && lhs.first == rhs.first
+        && lhs.count == rhs.count;
+}
+
+
+/**
+ * @internal
+ *
+ * @class openvrml::gl::local::buffer_pool openvrml/gl/local/geometry_cache.h
+ *
+ * @brief Suballocates buffer objects.
+ *
+ * Creating a buffer object for each geometry means a bind for each draw and
+ * a great many small allocations in the driver.  A @c buffer_pool instead
+ * creates buffer objects (&ldquo;pages&rdquo;) of a fixed size and hands
+ * out ranges of them first-fit.  Geometry larger than a page gets a page to
+ * itself.
+ *
+ * If the implementation does not support buffer objects, the pages are kept
+ * in client memory and used as ordinary vertex arrays.
+ */
+
+/**
+ * @internal
+ *
+ * @brief Construct.
+ *
+ * No OpenGL calls are made until the first allocation.
+ *
+ * @param[in] target    @c GL_ARRAY_BUFFER or @c GL_ELEMENT_ARRAY_BUFFER.
+ * @param[in] page_size the size of a page in bytes.
+ */
+openvrml::gl::local::buffer_pool::buffer_pool(const GLenum target,
+                                              const std::size_t page_size)
+    OPENVRML_NOTHROW:
+    target_(target),
+    page_size_(page_size)
+{}
+
+/**
+ * @internal
+ *
+ * @brief Allocate a range.
+ *
+ * @param[in] size  the size of the range in bytes.
+ *
+ * @return the range.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+const openvrml::gl::local::buffer_pool::range
+openvrml::gl::local::buffer_pool::allocate(std::size_t size)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    typedef std::map<std::size_t, std::size_t> free_map;
+
+    //
+    // Keep every range 4-byte aligned.
+    //
+    size = (size + 3) & ~std::size_t(3);
+    if (size == 0) { size = 4; }
+
+    for (std::size_t p = 0; p < this->pages_.size(); ++p) {
+        free_map & free = this->pages_[p].free;
+        for (free_map::iterator block = free.begin();
+             block != free.end();
+             ++block) {
+            if (block->second < size) { continue; }
+            const range r = { p, block->first, size };
+            if (block->second > size) {
+                free.insert(std::make_pair(block->first + size,
+                                           block->second - size));
+            }
+            free.erase(block);
+            return r;
+        }
+    }
+
+    const std::size_t p = this->add_page(std::max(size, this->page_size_));
+    free_map & free = this->pages_[p].free;
+    free.clear();
+    if (this->pages_[p].size > size) {
+        free.insert(std::make_pair(size, this->pages_[p].size - size));
+    }
+    const range r = { p, 0, size };
+    return r;
+}
+
+/**
+ * @internal
+ *
+ * @brief Create a page.
+ *
+ * A page left empty by @c #deallocate is reused.
+ *
+ * @param[in] size  the size of the page in bytes.
+ *
+ * @return the index of the page.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+std::size_t openvrml::gl::local::buffer_pool::add_page(const std::size_t size)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    std::size_t p = 0;
+    while (p < this->pages_.size() && this->pages_[p].size != 0) { ++p; }
+    if (p == this->pages_.size()) {
+        const page empty = { 0, 0, std::vector<unsigned char>(),
+                             std::map<std::size_t, std::size_t>() };
+        this->pages_.push_back(empty);
+    }
+
+    page & pg = this->pages_[p];
+    const buffer_functions & gl = buffer_functions::instance();
+    if (gl.available) {
+        gl.gen_buffers(1, &pg.name);
+        gl.bind_buffer(this->target_, pg.name);
+        gl.buffer_data(this->target_, std::ptrdiff_t(size), 0,
+                       GL_STATIC_DRAW);
+        gl.bind_buffer(this->target_, 0);
+    } else {
+        pg.client_data.resize(size);
+    }
+    pg.size = size;
+    return p;
+}
+
+/**
+ * @internal
+ *
+ * @brief Return a range to the pool.
+ *
+ * A page other than the first that is left empty is released.
+ *
+ * @param[in] r a range returned by @c #allocate.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void openvrml::gl::local::buffer_pool::deallocate(const range & r)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    typedef std::map<std::size_t, std::size_t> free_map;
+
+    assert(r.page < this->pages_.size());
+    page & pg = this->pages_[r.page];
+    free_map & free = pg.free;
+
+    free_map::iterator block =
+        free.insert(std::make_pair(r.offset, r.size)).first;
+
+    //
+    // Coalesce with the following and preceding free blocks.
+    //
+    free_map::iterator next = block;
+    ++next;
+    if (next != free.end() && block->first + block->second == next->first) {
+        block->second += next->second;
+        free.erase(next);
+    }
+    if (block != free.begin()) {
+        free_map::iterator prev = block;
+        --prev;
+        if (prev->first + prev->second == block->first) {
+            prev->second += block->second;
+            free.erase(block);
+            block = prev;
+        }
+    }
+
+    if (r.page != 0 && block->first == 0 && block->second == pg.size) {
+        if (pg.name) {
+            buffer_functions::instance().delete_buffers(1, &pg.name);
+        }
+        pg.name = 0;
+        pg.size = 0;
+        std::vector<unsigned char>().swap(pg.client_data);
+        free.clear();
+    }
+}
+
+/**
+ * @internal
+ *
+ * @brief Write data to a range.
+ *
+ * @param[in] r     a range returned by @c #allocate.
+ * @param[in] data  the data.
+ * @param[in] size  the number of bytes to write; no more than the size of
+ *                  @p r.
+ */
+void openvrml::gl::local::buffer_pool::write(const range & r,
+                                             const void * const data,
+                                             const std::size_t size)
+    OPENVRML_NOTHROW
+{
+    assert(r.page < this->pages_.size());
+    assert(size <= r.size);
+    page & pg = this->pages_[r.page];
+    if (pg.name) {
+        const buffer_functions & gl = buffer_functions::instance();
+        gl.bind_buffer(this->target_, pg.name);
+        gl.buffer_sub_data(this->target_,
+                           std::ptrdiff_t(r.offset),
+                           std::ptrdiff_t(size),
+                           data);
+        gl.bind_buffer(this->target_, 0);
+    } else {
+        std::memcpy(&pg.client_data[r.offset], data, size);
+    }
+}
+
+/**
+ * @internal
+ *
+ * @brief Bind the page holding a range.
+ *
+ * @param[in] r a range returned by @c #allocate.
+ *
+ * @return the pointer to pass to @c gl*Pointer or @c glDrawElements for the
+ *         start of @p r.
+ */
+const GLvoid * openvrml::gl::local::buffer_pool::bind(const range & r) const
+    OPENVRML_NOTHROW
+{
+    assert(r.page < this->pages_.size());
+    const page & pg = this->pages_[r.page];
+    if (pg.name) {
+        buffer_functions::instance().bind_buffer(this->target_, pg.name);
+        return reinterpret_cast<const GLvoid *>(r.offset);
+    }
+    return &pg.client_data[r.offset];
+}
+
+/**
+ * @internal
+ *
+ * @brief Unbind any page bound by @c #bind.
+ */
+void openvrml::gl::local::buffer_pool::unbind() const OPENVRML_NOTHROW
+{
+    const buffer_functions & gl = buffer_functions::instance();
+    if (gl.available) { gl.bind_buffer(this->target_, 0); }
+}
+
+/**
+ * @internal
+ *
+ * @brief Release all pages.
+ *
+ * @pre The OpenGL context the pages were created in is current.
+ */
+void openvrml::gl::local::buffer_pool::clear() OPENVRML_NOTHROW
+{
+    for (std::deque<page>::iterator pg = this->pages_.begin();
+         pg != this->pages_.end();
+         ++pg) {
+        if (pg->name) {
+            buffer_functions::instance().delete_buffers(1, &pg->name);
+        }
+    }
+    this->pages_.clear();
+}
+
+
+/**
+ * @internal
+ *
+ * @class openvrml::gl::local::geometry_cache openvrml/gl/local/geometry_cache.h
+ *
+ * @brief The vertex and index buffers of each geometry node.
+ *
+ * When a geometry node changes, the viewer is told to remove it and then to
+ * insert it again.  Removing only marks its buffers stale; if the geometry
+ * inserted next has the same primitives and vertex attributes (as when a
+ * CoordinateInterpolator changes the coordinates of an IndexedFaceSet), the
+ * new vertices are written over the old ones with @c glBufferSubData and the
+ * index buffer is left alone.  Buffers still stale at the end of a frame are
+ * released.
+ */
+
+/**
+ * @internal
+ *
+ * @brief Construct.
+ */
+openvrml::gl::local::geometry_cache::geometry_object::geometry_object()
+    OPENVRML_NOTHROW:
+    vertex_count(0),
+    attributes(0),
+    front_face(GL_CCW),
+    shade_model(GL_SMOOTH),
+    disabled(0),
+    stale(false)
+{
+    const buffer_pool::range none = { 0, 0, 0 };
+    this->vertex_range = none;
+    this->index_range = none;
+}
+
+/**
+ * @internal
+ *
+ * @brief Construct.
+ */
+openvrml::gl::local::geometry_cache::geometry_cache() OPENVRML_NOTHROW:
+    vertex_buffers_(GL_ARRAY_BUFFER, 1024 * 1024),
+    index_buffers_(GL_ELEMENT_ARRAY_BUFFER, 256 * 1024)
+{}
+
+/**
+ * @internal
+ *
+ * @brief Whether there are current buffers for a node.
+ *
+ * @param[in] n a geometry node.
+ *
+ * @return @c true if @p n has been inserted and not removed since; @c false
+ *         otherwise.
+ */
+bool openvrml::gl::local::geometry_cache::cached(const node & n) const
+    OPENVRML_NOTHROW
+{
+    const object_map::const_iterator obj = this->objects_.find(&n);
+    return obj != this->objects_.end() && !obj->second.stale;
+}
+
+/**
+ * @internal
+ *
+ * @brief Draw a node's geometry.
+ *
+ * The front face, the shade model, and enabled capabilities are changed as
+ * the geometry requires; the caller is responsible for restoring them.
+ *
+ * @param[in] n a geometry node.
+ *
+ * @pre @c #cached(n)
+ */
+void openvrml::gl::local::geometry_cache::draw(const node & n) const
+    OPENVRML_NOTHROW
+{
+    const object_map::const_iterator pos = this->objects_.find(&n);
+    assert(pos != this->objects_.end());
+    const geometry_object & obj = pos->second;
+
+    glFrontFace(obj.front_face);
+    glShadeModel(obj.shade_model);
+    if (obj.disabled & vertex_array_builder::cull_face_capability) {
+        glDisable(GL_CULL_FACE);
+    }
+    if (obj.disabled & vertex_array_builder::lighting_capability) {
+        glDisable(GL_LIGHTING);
+    }
+    if (obj.disabled & vertex_array_builder::texture_2d_capability) {
+        glDisable(GL_TEXTURE_2D);
+    }
+
+    if (obj.batches.empty()) { return; }
+
+    glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+
+    const GLubyte * const vertices = static_cast<const GLubyte *>(
+        this->vertex_buffers_.bind(obj.vertex_range));
+    static const GLsizei stride = sizeof (interleaved_vertex);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, stride,
+                    vertices + offsetof(interleaved_vertex, coord));
+    if (obj.attributes & vertex_array_builder::color_attribute) {
+        glEnableClientState(GL_COLOR_ARRAY);
+        glColorPointer(3, GL_FLOAT, stride,
+                       vertices + offsetof(interleaved_vertex, color));
+    }
+    if (obj.attributes & vertex_array_builder::normal_attribute) {
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glNormalPointer(GL_FLOAT, stride,
+                        vertices + offsetof(interleaved_vertex, normal));
+    }
+    if (obj.attributes & vertex_array_builder::tex_coord_attribute) {
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexCoordPointer(2, GL_FLOAT, stride,
+                          vertices + offsetof(interleaved_vertex, tex_coord));
+    }
+
+    const GLubyte * const indices = static_cast<const GLubyte *>(
+        this->index_buffers_.bind(obj.index_range));
+    for (std::vector<vertex_array_builder::batch>::const_iterator batch =
+             obj.batches.begin();
+         batch != obj.batches.end();
+         ++batch) {
+        glDrawElements(batch->mode,
+                       GLsizei(batch->count),
+                       GL_UNSIGNED_INT,
+                       indices + batch->first * sizeof (GLuint));
+    }
+
+    this->index_buffers_.unbind();
+    this->vertex_buffers_.unbind();
+    glPopClientAttrib();
+}
+
+/**
+ * @internal
+ *
+ * @brief Load a node's geometry into buffers.
+ *
+ * @param[in] n         a geometry node.
+ * @param[in,out] builder   the geometry.  Its indices are taken.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ *
+ * @post @c #cached(n)
+ */
+void
+openvrml::gl::local::geometry_cache::insert(const node & n,
+                                            vertex_array_builder & builder)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    object_map::iterator pos = this->objects_.find(&n);
+    if (pos == this->objects_.end()) {
+        pos = this->objects_.insert(std::make_pair(&n, geometry_object()))
+            .first;
+    }
+    geometry_object & obj = pos->second;
+
+    const std::vector<interleaved_vertex> & vertices = builder.vertices();
+    const std::size_t vertex_bytes =
+        vertices.size() * sizeof (interleaved_vertex);
+
+    try {
+        const bool same_primitives =
+            obj.vertex_count == vertices.size()
+            && obj.attributes == builder.attributes()
+            && obj.batches == builder.batches()
+            && obj.indices == builder.indices();
+        if (!same_primitives) {
+            this->release(obj);
+            std::vector<GLuint> & indices = builder.indices();
+            if (!vertices.empty()) {
+                obj.vertex_range =
+                    this->vertex_buffers_.allocate(vertex_bytes);
+            }
+            if (!indices.empty()) {
+                const std::size_t index_bytes =
+                    indices.size() * sizeof (GLuint);
+                obj.index_range = this->index_buffers_.allocate(index_bytes);
+                this->index_buffers_.write(obj.index_range,
+                                           &indices[0],
+                                           index_bytes);
+            }
+            obj.vertex_count = vertices.size();
+            obj.attributes = builder.attributes();
+            obj.batches = builder.batches();
+            obj.indices.swap(indices);
+        }
+    } catch (std::bad_alloc &) {
+        this->release(obj);
+        this->objects_.erase(pos);
+        throw;
+    }
+
+    if (!vertices.empty()) {
+        this->vertex_buffers_.write(obj.vertex_range,
+                                    &vertices[0],
+                                    vertex_bytes);
+    }
+    obj.front_face = builder.front_face();
+    obj.shade_model = builder.shade_model();
+    obj.disabled = builder.disabled();
+    obj.stale = false;
+}
+
+/**
+ * @internal
+ *
+ * @brief Mark a node's buffers stale.
+ *
+ * @param[in] n a geometry node.
+ */
+void openvrml::gl::local::geometry_cache::remove(const node & n)
+    OPENVRML_NOTHROW
+{
+    const object_map::iterator obj = this->objects_.find(&n);
+    if (obj != this->objects_.end()) { obj->second.stale = true; }
+}
+
+/**
+ * @internal
+ *
+ * @brief Release the buffers of nodes removed and not inserted again.
+ */
+void openvrml::gl::local::geometry_cache::release_stale() OPENVRML_NOTHROW
+{
+    object_map::iterator obj = this->objects_.begin();
+    while (obj != this->objects_.end()) {
+        if (obj->second.stale) {
+            this->release(obj->second);
+            this->objects_.erase(obj++);
+        } else {
+            ++obj;
+        }
+    }
+}
+
+/**
+ * @internal
+ *
+ * @brief Release all buffers.
+ *
+ * @pre The OpenGL context the buffers were created in is current.
+ */
+void openvrml::gl::local::geometry_cache::clear() OPENVRML_NOTHROW
+{
+    this->objects_.clear();
+    this->vertex_buffers_.clear();
+    this->index_buffers_.clear();
+}
+
+/**
+ * @internal
+ *
+ * @brief Return a geometry object's ranges to their pools.
+ *
+ * @param[in,out] obj   a geometry object.
+ */
+void openvrml::gl::local::geometry_cache::release(geometry_object & obj)
+    OPENVRML_NOTHROW
+{
+    try {
+        if (obj.vertex_range.size != 0) {
+            this->vertex_buffers_.deallocate(obj.vertex_range);
+        }
+        if (obj.index_range.size != 0) {
+            this->index_buffers_.deallocate(obj.index_range);
+        }
+    } catch (std::bad_alloc &) {
+        //
+        // The ranges are lost to the pool until it is cleared.
+        //
+    }
+    obj = geometry_object();
+}
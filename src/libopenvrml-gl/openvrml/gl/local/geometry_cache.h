@@ -0,0 +1,203 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# ifndef OPENVRML_GL_LOCAL_GEOMETRY_CACHE_H
+#   define OPENVRML_GL_LOCAL_GEOMETRY_CACHE_H
+
+#   include <openvrml/gl/viewer.h>
+#   include <openvrml/compiled_mesh.h>
+#   include <boost/utility.hpp>
+#   include <deque>
+#   include <map>
+#   include <vector>
+
+namespace openvrml {
+
+    namespace gl {
+
+        namespace local {
+
+            struct OPENVRML_GL_LOCAL interleaved_vertex {
+                GLfloat tex_coord[2];
+                GLfloat color[3];
+                GLfloat normal[3];
+                GLfloat coord[3];
+            };
+
+
+            class OPENVRML_GL_LOCAL vertex_array_builder :
+                boost::noncopyable {
+            public:
+                enum attribute {
+                    color_attribute     = 0x1,
+                    normal_attribute    = 0x2,
+                    tex_coord_attribute = 0x4
+                };
+
+                enum capability {
+                    cull_face_capability  = 0x1,
+                    lighting_capability   = 0x2,
+                    texture_2d_capability = 0x4
+                };
+
+                struct batch {
+                    GLenum mode;
+                    std::size_t first;
+                    std::size_t count;
+                };
+
+            private:
+                std::vector<interleaved_vertex> vertices_;
+                std::vector<GLuint> indices_;
+                std::vector<batch> batches_;
+                unsigned int attributes_;
+                GLenum front_face_;
+                GLenum shade_model_;
+                unsigned int disabled_;
+                interleaved_vertex current_;
+                GLenum mode_;
+                std::size_t primitive_begin_;
+
+            public:
+                vertex_array_builder() OPENVRML_NOTHROW;
+
+                void front_face(GLenum mode) OPENVRML_NOTHROW;
+                void shade_model(GLenum mode) OPENVRML_NOTHROW;
+                void disable(GLenum cap) OPENVRML_NOTHROW;
+
+                void begin(GLenum mode) OPENVRML_NOTHROW;
+                void end() OPENVRML_THROW1(std::bad_alloc);
+
+                void color(const GLfloat * rgb) OPENVRML_NOTHROW;
+                void normal(GLfloat x, GLfloat y, GLfloat z) OPENVRML_NOTHROW;
+                void normal(const GLfloat * n) OPENVRML_NOTHROW;
+                void tex_coord(GLfloat s, GLfloat t) OPENVRML_NOTHROW;
+                void tex_coord(const GLfloat * st) OPENVRML_NOTHROW;
+                void vertex(GLfloat x, GLfloat y, GLfloat z)
+                    OPENVRML_THROW1(std::bad_alloc);
+                void vertex(const GLfloat * v)
+                    OPENVRML_THROW1(std::bad_alloc);
+                void vertex(const GLdouble * v)
+                    OPENVRML_THROW1(std::bad_alloc);
+
+                void triangles(const compiled_mesh & mesh)
+                    OPENVRML_THROW1(std::bad_alloc);
+
+                const std::vector<interleaved_vertex> & vertices() const
+                    OPENVRML_NOTHROW;
+                std::vector<GLuint> & indices() OPENVRML_NOTHROW;
+                const std::vector<batch> & batches() const OPENVRML_NOTHROW;
+                unsigned int attributes() const OPENVRML_NOTHROW;
+                GLenum front_face() const OPENVRML_NOTHROW;
+                GLenum shade_model() const OPENVRML_NOTHROW;
+                unsigned int disabled() const OPENVRML_NOTHROW;
+
+            private:
+                void add_batch(GLenum mode, std::size_t count)
+                    OPENVRML_THROW1(std::bad_alloc);
+            };
+
+            OPENVRML_GL_LOCAL bool
+            operator==(const vertex_array_builder::batch & lhs,
+                       const vertex_array_builder::batch & rhs)
+                OPENVRML_NOTHROW;
+
+
+            class OPENVRML_GL_LOCAL buffer_pool : boost::noncopyable {
+            public:
+                struct range {
+                    std::size_t page;
+                    std::size_t offset;
+                    std::size_t size;
+                };
+
+            private:
+                struct page {
+                    GLuint name;
+                    std::size_t size;
+                    std::vector<unsigned char> client_data;
+                    std::map<std::size_t, std::size_t> free;
+                };
+
+                GLenum target_;
+                std::size_t page_size_;
+                std::deque<page> pages_;
+
+            public:
+                buffer_pool(GLenum target, std::size_t page_size)
+                    OPENVRML_NOTHROW;
+
+                const range allocate(std::size_t size)
+                    OPENVRML_THROW1(std::bad_alloc);
+                void deallocate(const range & r)
+                    OPENVRML_THROW1(std::bad_alloc);
+                void write(const range & r, const void * data,
+                           std::size_t size) OPENVRML_NOTHROW;
+                const GLvoid * bind(const range & r) const OPENVRML_NOTHROW;
+                void unbind() const OPENVRML_NOTHROW;
+                void clear() OPENVRML_NOTHROW;
+
+            private:
+                std::size_t add_page(std::size_t size)
+                    OPENVRML_THROW1(std::bad_alloc);
+            };
+
+
+            class OPENVRML_GL_LOCAL geometry_cache : boost::noncopyable {
+                struct geometry_object {
+                    buffer_pool::range vertex_range;
+                    buffer_pool::range index_range;
+                    std::size_t vertex_count;
+                    unsigned int attributes;
+                    std::vector<vertex_array_builder::batch> batches;
+                    std::vector<GLuint> indices;
+                    GLenum front_face;
+                    GLenum shade_model;
+                    unsigned int disabled;
+                    bool stale;
+
+                    geometry_object() OPENVRML_NOTHROW;
+                };
+
+                typedef std::map<const node *, geometry_object> object_map;
+
+                buffer_pool vertex_buffers_;
+                buffer_pool index_buffers_;
+                object_map objects_;
+
+            public:
+                geometry_cache() OPENVRML_NOTHROW;
+
+                bool cached(const node & n) const OPENVRML_NOTHROW;
+                void draw(const node & n) const OPENVRML_NOTHROW;
+                void insert(const node & n, vertex_array_builder & builder)
+                    OPENVRML_THROW1(std::bad_alloc);
+                void remove(const node & n) OPENVRML_NOTHROW;
+                void release_stale() OPENVRML_NOTHROW;
+                void clear() OPENVRML_NOTHROW;
+
+            private:
+                void release(geometry_object & obj) OPENVRML_NOTHROW;
+            };
+        }
+    }
+}
+
+# endif // ifndef OPENVRML_GL_LOCAL_GEOMETRY_CACHE_H
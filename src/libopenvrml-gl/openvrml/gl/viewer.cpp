@@ -26,7 +26,9 @@
  */
 
 # include "viewer.h"
+# include "local/geometry_cache.h"
 # include <openvrml/browser.h>
+# include <openvrml/compiled_mesh.h>
 # include <cmath>
 # include <limits>
 # ifndef NDEBUG
@@ -59,14 +61,6 @@
             } while (false)
 #   endif
 
-# if (defined(__CYGWIN__) && defined(X_DISPLAY_MISSING)) || defined(__MINGW32__)
-#   define OPENVRML_GL_CALLBACK_ __attribute__ ((__stdcall__))
-# elif defined (_WIN32)
-#   define OPENVRML_GL_CALLBACK_ CALLBACK
-# else
-#   define OPENVRML_GL_CALLBACK_
-# endif
-
 namespace {
 
     const double pi     = 3.14159265358979323846;
@@ -122,208 +116,6 @@ namespace {
         glGetIntegerv(GL_MAX_TEXTURE_SIZE,
                       &this->max_texture_size);
     }
-
-
-    struct OPENVRML_GL_LOCAL vertex_data {
-        GLdouble coord[3];
-        const openvrml::color * color;
-        const openvrml::vec3f * normal;
-        const openvrml::vec2f * tex_coord;
-
-        vertex_data();
-    };
-
-    vertex_data::vertex_data():
-        color(0),
-        normal(0),
-        tex_coord(0)
-    {}
-
-
-    struct OPENVRML_GL_LOCAL combined_vertex_data_ {
-        openvrml::color color;
-        openvrml::vec3f normal;
-        openvrml::vec2f tex_coord;
-    };
-
-
-    struct OPENVRML_GL_LOCAL shell_tess_user_data {
-        size_t face_index;
-        const std::vector<openvrml::color> * face_color;
-        const std::vector<openvrml::int32> * face_color_index;
-        const std::vector<openvrml::vec3f> * face_normal;
-        const std::vector<openvrml::int32> * face_normal_index;
-        std::list<vertex_data> combined_vertices;
-        std::list<combined_vertex_data_> combined_vertex_data;
-
-        shell_tess_user_data();
-    };
-
-    shell_tess_user_data::shell_tess_user_data():
-        face_index(0),
-        face_color(0),
-        face_color_index(0),
-        face_normal(0),
-        face_normal_index(0)
-    {}
-
-
-    /**
-     * @internal
-     */
-    struct OPENVRML_GL_LOCAL ShellData {
-        unsigned int mask;
-        const std::vector<openvrml::vec3f> & coord;
-        const std::vector<openvrml::int32> & coordIndex;
-        const std::vector<openvrml::color> & color;
-        const std::vector<openvrml::int32> & colorIndex;
-        const std::vector<openvrml::vec3f> & normal;
-        const std::vector<openvrml::int32> & normalIndex;
-        const std::vector<openvrml::vec2f> & texCoord;
-        const std::vector<openvrml::int32> & texCoordIndex;
-        int (&texAxes)[2];
-        float *texParams;
-        size_t nf, i;
-
-        ShellData(unsigned int mask,
-                  const std::vector<openvrml::vec3f> & coord,
-                  const std::vector<openvrml::int32> & coordIndex,
-                  const std::vector<openvrml::color> & color,
-                  const std::vector<openvrml::int32> & colorIndex,
-                  const std::vector<openvrml::vec3f> & normal,
-                  const std::vector<openvrml::int32> & normalIndex,
-                  const std::vector<openvrml::vec2f> & texCoord,
-                  const std::vector<openvrml::int32> & texCoordIndex,
-                  int (&texAxes)[2], float * texParams, size_t nf, size_t i);
-    };
-
-    ShellData::ShellData(unsigned int mask,
-                         const std::vector<openvrml::vec3f> & coord,
-                         const std::vector<openvrml::int32> & coordIndex,
-                         const std::vector<openvrml::color> & color,
-                         const std::vector<openvrml::int32> & colorIndex,
-                         const std::vector<openvrml::vec3f> & normal,
-                         const std::vector<openvrml::int32> & normalIndex,
-                         const std::vector<openvrml::vec2f> & texCoord,
-                         const std::vector<openvrml::int32> & texCoordIndex,
-                         int (&texAxes)[2],
-                         float * texParams,
-                         size_t nf,
-                         size_t i):
-        mask(mask),
-        coord(coord),
-        coordIndex(coordIndex),
-        color(color),
-        colorIndex(colorIndex),
-        normal(normal),
-        normalIndex(normalIndex),
-        texCoord(texCoord),
-        texCoordIndex(texCoordIndex),
-        texAxes(texAxes),
-        texParams(texParams),
-        nf(nf),
-        i(i)
-    {}
-
-    // Generate a normal from 3 indexed points.
-    OPENVRML_GL_LOCAL const openvrml::vec3f
-    indexFaceNormal(const size_t i1,
-                    const size_t i2,
-                    const size_t i3,
-                    const std::vector<openvrml::vec3f> & points)
-    {
-        using openvrml::vec3f;
-        const vec3f v1 = points[i2] - points[i3];
-        const vec3f v2 = points[i2] - points[i1];
-        return (v1 * v2).normalize();
-    }
-}
-
-extern "C" void OPENVRML_GL_CALLBACK_ shell_tess_begin(const GLenum type,
-                                                       void * const user_data)
-{
-    shell_tess_user_data & user_data_ =
-        *static_cast<shell_tess_user_data *>(user_data);
-
-    glBegin(type);
-
-    if (user_data_.face_color) {
-        const size_t color_index =
-            (user_data_.face_color_index
-             && user_data_.face_index < user_data_.face_color_index->size())
-            ? (*user_data_.face_color_index)[user_data_.face_index]
-            : user_data_.face_index;
-        if (color_index < user_data_.face_color->size()) {
-            glColor3fv(&(*user_data_.face_color)[color_index][0]);
-        }
-    }
-
-    if (user_data_.face_normal) {
-        const size_t normal_index =
-            (user_data_.face_normal_index
-             && user_data_.face_index < user_data_.face_normal_index->size())
-            ? (*user_data_.face_normal_index)[user_data_.face_index]
-            : user_data_.face_index;
-        if (normal_index < user_data_.face_normal->size()) {
-            glNormal3fv(&(*user_data_.face_normal)[normal_index][0]);
-        }
-    }
-}
-
-extern "C" void OPENVRML_GL_CALLBACK_ shell_tess_vertex(void * vertex_data)
-{
-    ::vertex_data & vertex_data_ = *static_cast< ::vertex_data *>(vertex_data);
-
-    if (vertex_data_.color) {
-        glColor3fv(&(*vertex_data_.color)[0]);
-    }
-    if (vertex_data_.normal) {
-        glNormal3fv(&(*vertex_data_.normal)[0]);
-    }
-    if (vertex_data_.tex_coord) {
-        glTexCoord2fv(&(*vertex_data_.tex_coord)[0]);
-    }
-
-    glVertex3dv(vertex_data_.coord);
-}
-
-extern "C" void OPENVRML_GL_CALLBACK_
-shell_tess_combine(GLdouble coords[3],
-                   void *[4],
-                   GLfloat[4],
-                   void ** outData,
-                   void * user_data)
-{
-    try {
-        using std::list;
-        assert(user_data);
-        shell_tess_user_data & user_data_ =
-            *static_cast<shell_tess_user_data *>(user_data);
-        user_data_.combined_vertices.push_back(::vertex_data());
-        ::vertex_data & new_vertex = user_data_.combined_vertices.back();
-        new_vertex.coord[0] = coords[0];
-        new_vertex.coord[1] = coords[1];
-        new_vertex.coord[2] = coords[2];
-        *outData = &new_vertex;
-    } catch (std::bad_alloc &) {
-        *outData = 0;
-    }
-}
-
-extern "C" void OPENVRML_GL_CALLBACK_ shell_tess_end(void * user_data)
-{
-    shell_tess_user_data & user_data_ =
-        *static_cast<shell_tess_user_data *>(user_data);
-    ++user_data_.face_index;
-    glEnd();
-}
-
-extern "C" void OPENVRML_GL_CALLBACK_ tess_error(const GLenum error_code)
-{
-    const GLubyte * const error_str = gluErrorString(error_code);
-    const GLubyte * end;
-    for (end = error_str; *end; ++end) {}
-    OPENVRML_GL_PRINT_MESSAGE_(std::string(error_str, end));
 }
 
 
@@ -900,6 +692,7 @@ namespace {
  * @brief Construct a viewer for the specified browser.
  */
 openvrml::gl::viewer::viewer():
+    geometry_cache_(new local::geometry_cache),
     gl_initialized(false),
     blend(true),
     lit(true),
@@ -909,7 +702,6 @@ openvrml::gl::viewer::viewer():
     win_height(1),
     objects(0),
     nested_objects(0),
-    tesselator(0),
     sensitive(0),
     active_sensitive(0),
     over_sensitive(0),
@@ -944,9 +736,6 @@ void openvrml::gl::viewer::initialize()
 {
     if (this->gl_initialized) { return; }
 
-    assert(!this->tesselator);
-    this->tesselator = gluNewTess();
-
     glEnable(GL_DEPTH_TEST);
     glDepthFunc(GL_LEQUAL);
 
@@ -977,9 +766,9 @@ struct OPENVRML_LOCAL openvrml::gl::viewer::delete_list {
 };
 
 struct OPENVRML_LOCAL openvrml::gl::viewer::delete_texture {
-    void operator()(const texture_map_t::value_type & value) const
+    void operator()(const texture_object_map_t::value_type & value) const
     {
-        glDeleteTextures(1, &value.second);
+        glDeleteTextures(1, &value.second.name);
     }
 };
 
@@ -992,13 +781,14 @@ void openvrml::gl::viewer::shutdown()
                   delete_list());
     this->list_map_.clear();
 
-    std::for_each(this->texture_map_.begin(), this->texture_map_.end(),
+    this->geometry_cache_->clear();
+
+    std::for_each(this->texture_objects_.begin(),
+                  this->texture_objects_.end(),
                   delete_texture());
+    this->texture_objects_.clear();
     this->texture_map_.clear();
 
-    if (this->tesselator) { gluDeleteTess(this->tesselator); }
-    this->tesselator = 0;
-
     this->gl_initialized = false;
 }
 
@@ -1120,6 +910,96 @@ void openvrml::gl::viewer::end_geometry()
     glMatrixMode(GL_MODELVIEW);
 }
 
+/**
+ * @brief Draw geometry from the geometry cache.
+ *
+ * @param[in] n a geometry node.
+ *
+ * @return @c true if @p n's geometry was cached and has been drawn; @c false
+ *         otherwise.
+ */
+bool openvrml::gl::viewer::draw_cached_geometry(const node & n)
+{
+    if (!this->geometry_cache_->cached(n)) { return false; }
+    this->begin_geometry();
+    this->geometry_cache_->draw(n);
+    this->end_geometry();
+    return true;
+}
+
+/**
+ * @brief Load geometry into the geometry cache and draw it.
+ *
+ * Buffers are loaded once and drawn from on each frame until the node is
+ * removed; a node that changes only its vertex positions gets its vertex
+ * buffer rewritten in place.
+ *
+ * @param[in] n         a geometry node.
+ * @param[in,out] geometry  the geometry of @p n.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void
+openvrml::gl::viewer::insert_geometry(const node & n,
+                                      local::vertex_array_builder & geometry)
+{
+    this->geometry_cache_->insert(n, geometry);
+    this->draw_cached_geometry(n);
+}
+
+/**
+ * @brief Draw a geometry node's compiled mesh.
+ *
+ * The mesh is drawn from the geometry cache if it has been loaded there;
+ * otherwise, if the @c browser's @c compiled_mesh_cache has a mesh for the
+ * node (compiled for another viewer, or compiled ahead of time), it is
+ * loaded into the geometry cache.
+ *
+ * @param[in] n a geometry node.
+ *
+ * @return @c true if @p n's mesh has been drawn; @c false if @p n has not
+ *         been compiled.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+bool openvrml::gl::viewer::draw_compiled_mesh(const geometry_node & n)
+{
+    if (this->draw_cached_geometry(n)) { return true; }
+
+    assert(this->browser());
+    const boost::shared_ptr<const compiled_mesh> mesh =
+        this->browser()->compiled_meshes().find(n);
+    if (!mesh) { return false; }
+
+    local::vertex_array_builder geometry;
+    geometry.triangles(*mesh);
+    this->insert_geometry(n, geometry);
+    return true;
+}
+
+/**
+ * @brief Add a geometry node's newly compiled mesh to the @c browser's
+ *        @c compiled_mesh_cache, load it into the geometry cache, and draw
+ *        it.
+ *
+ * @param[in] n     a geometry node.
+ * @param[in] mesh  the mesh compiled for @p n.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void
+openvrml::gl::viewer::
+insert_compiled_mesh(const geometry_node & n,
+                     const boost::shared_ptr<compiled_mesh> & mesh)
+{
+    assert(this->browser());
+    this->browser()->compiled_meshes().insert(n, mesh);
+
+    local::vertex_array_builder geometry;
+    geometry.triangles(*mesh);
+    this->insert_geometry(n, geometry);
+}
+
 /**
  * @brief Rendering mode.
  *
@@ -1432,7 +1312,7 @@ void openvrml::gl::viewer::do_insert_background(const background_node & n)
 }
 
 /**
- * @brief Insert a box into a display list.
+ * @brief Insert a box into the geometry cache.
  *
  * @param[in] n     the @c geometry_node corresponding to the box.
  * @param[in] size  box dimensions.
@@ -1440,145 +1320,15 @@ void openvrml::gl::viewer::do_insert_background(const background_node & n)
 void openvrml::gl::viewer::do_insert_box(const geometry_node & n,
                                          const vec3f & size)
 {
-    const list_map_t::const_iterator list = this->list_map_.find(&n);
-    if (list != this->list_map_.end()) {
-        glCallList(list->second);
-        return;
-    }
-
-    GLuint glid = 0;
-
-    if (!this->select_mode) {
-        glid = glGenLists(1);
-        glNewList(glid, GL_COMPILE_AND_EXECUTE);
-    }
-
-    static const GLint faces[6][4] =
-    {
-        {0, 1, 2, 3},
-        {1, 5, 6, 2},
-        {5, 4, 7, 6},
-        {4, 0, 3, 7},
-        {2, 6, 7, 3},
-        {0, 4, 5, 1}
-    };
-
-    static const GLfloat normal[6][3] =        // normals
-    {
-        {-1.0, 0.0, 0.0},
-        {0.0, 0.0, 1.0},
-        {1.0, 0.0, 0.0},
-        {0.0, 0.0, -1.0},
-        {0.0, 1.0, 0.0},
-        {0.0, -1.0, 0.0}
-    };
-
-    GLfloat v[8][3];
-    GLint i;
-
-    v[0][0] = v[1][0] = v[2][0] = v[3][0] = -size.x() / 2;
-    v[4][0] = v[5][0] = v[6][0] = v[7][0] = size.x() / 2;
-    v[0][1] = v[1][1] = v[4][1] = v[5][1] = -size.y() / 2;
-    v[2][1] = v[3][1] = v[6][1] = v[7][1] = size.y() / 2;
-    v[0][2] = v[3][2] = v[4][2] = v[7][2] = -size.z() / 2;
-    v[1][2] = v[2][2] = v[5][2] = v[6][2] = size.z() / 2;
-
-    begin_geometry();
-    glShadeModel(GL_FLAT);
-
-    glBegin(GL_QUADS);
-    for (i = 0; i < 6; ++i) {
-        glNormal3fv(&normal[i][0]);
-
-        //glTexCoord2f(0.0, 1.0);
-        glTexCoord2f(0.0, 0.0);
-        glVertex3fv(&v[faces[i][0]][0]);
-
-        //glTexCoord2f(1.0, 1.0);
-        glTexCoord2f(1.0, 0.0);
-        glVertex3fv(&v[faces[i][1]][0]);
-
-        //glTexCoord2f(1.0, 0.0);
-        glTexCoord2f(1.0, 1.0);
-        glVertex3fv(&v[faces[i][2]][0]);
-
-        //glTexCoord2f(0.0, 0.0);
-        glTexCoord2f(0.0, 1.0);
-        glVertex3fv(&v[faces[i][3]][0]);
-    }
-    glEnd();
-
-    end_geometry();
-    if (glid) {
-        glEndList();
-        this->list_map_.insert(std::make_pair(&n, glid));
-    }
-}
-
-namespace {
-
-    /**
-     * @brief Build a cylinder object.
-     *
-     * @param[in] height    the height for the cylinder.
-     * @param[in] radius    the radius for the cylinder.
-     * @param[in] numFacets the number of facets for the sides of the cylinder.
-     * @param[out] c        the coordinates.
-     * @param[out] tc       the texture coordinates.
-     * @param[out] faces    the faces.
-     *
-     * It might be smarter to do just one, and reference it with scaling (but
-     * the world creator could just as easily do that with DEF/USE ...).
-     */
-    OPENVRML_GL_LOCAL void computeCylinder(const double height,
-                                           const double radius,
-                                           const int numFacets,
-                                           float (*c)[3],
-                                           float (*tc)[3],
-                                           int * faces)
-    {
-        double angle, x, y;
-        int i, polyIndex;
-
-        // Compute coordinates, texture coordinates:
-        for (i = 0; i < numFacets; ++i) {
-            angle = i * 2 * pi / numFacets;
-            x = cos(angle);
-            y = sin(angle);
-            c[i][0] = float(radius * x);
-            c[i][1] = float(0.5 * height);
-            c[i][2] = float(radius * y);
-            c[numFacets+i][0] = float(radius * x);
-            c[numFacets+i][1] = float(-0.5 * height);
-            c[numFacets+i][2] = float(radius * y);
-
-            if (tc) {
-                float u = float(0.75 - float(i) / numFacets);
-                //double u = ((float) i) / numFacets + 0.25;
-                //if ( u > 1.0 ) u -= 1.0;
-                tc[i][0] = u; // ((float) i) / numFacets;
-                tc[i][1] = 1.0;
-                tc[i][2] = 0.0;
-                tc[numFacets+i][0] = u; //((float) i) / numFacets;
-                tc[numFacets+i][1] = 0.0;
-                tc[numFacets+i][2] = 0.0;
-            }
-        }
+    if (this->draw_compiled_mesh(n)) { return; }
 
-        // And compute indices:
-        for (i = 0; i < numFacets; ++i) {
-            polyIndex = 5*i;
-            faces[polyIndex + 0] = i;
-            faces[polyIndex + 1] = (i+1) % numFacets;
-            faces[polyIndex + 2] = (i+1) % numFacets + numFacets;
-            faces[polyIndex + 3] = i + numFacets;
-            faces[polyIndex + 4] = -1;
-        }
-    }
+    const boost::shared_ptr<compiled_mesh> mesh(new compiled_mesh);
+    compile_box(size, *mesh);
+    this->insert_compiled_mesh(n, mesh);
 }
 
 /**
- * @brief Insert a cone into a display list.
+ * @brief Insert a cone into the geometry cache.
  *
  * @param[in] n         the @c geometry_node corresponding to the cone.
  * @param[in] height    height.
@@ -1592,84 +1342,15 @@ void openvrml::gl::viewer::do_insert_cone(const geometry_node & n,
                                           const bool bottom,
                                           const bool side)
 {
-    const list_map_t::const_iterator list = this->list_map_.find(&n);
-    if (list != this->list_map_.end()) {
-        glCallList(list->second);
-        return;
-    }
-
-    GLuint glid = 0;
-
-    if (!this->select_mode) {
-        glid = glGenLists(1);
-        glNewList( glid, GL_COMPILE_AND_EXECUTE );
-    }
-
-    begin_geometry();
-    if (!bottom || !side) { glDisable(GL_CULL_FACE); }
-
-    if (bottom || side) {
-        static const size_t nfacets = 11; // Number of polygons for sides
-        static const size_t npts = 2 * nfacets;
-        static const size_t nfaces = nfacets * 5;
-
-        float c[npts][3];                // coordinates
-        float tc[npts][3];                // texture coordinates
-        int faces[nfaces];                // face lists
-
-        // should only compute tc if a texture is present...
-        computeCylinder(height, radius, nfacets, c, tc, faces);
-
-        for (size_t i = 0; i < nfacets; ++i) { c[i][0] = c[i][2] = 0.0; }
-
-        if (side) {
-            float Ny = radius * radius / height;
-            glBegin(GL_QUAD_STRIP);
-            for (size_t i = 0; i < nfacets; ++i) {
-                glNormal3f(c[i + nfacets][0], Ny, c[i + nfacets][2]);
-                glTexCoord2fv(&tc[i + nfacets][0]);
-                glVertex3fv(&c[i + nfacets][0]);
-                glTexCoord2fv(&tc[i][0]);
-                glVertex3fv(&c[i][0]);
-            }
-
-            glNormal3f(c[nfacets][0], Ny, c[nfacets][2]);
-            glTexCoord2f(tc[nfacets][0] - 1.0f, tc[nfacets][1]);
-            glVertex3fv(&c[nfacets][0]);
-            glTexCoord2f(tc[0][0] - 1.0f, tc[0][1]);
-            glVertex3fv(&c[0][0]);
-            glEnd();
-        }
-
-        if (bottom) {
-            glBegin(GL_TRIANGLE_FAN);
-            glNormal3f(0.0, -1.0, 0.0);
-            glTexCoord2f(0.5, 0.5);
-            glVertex3f(0.0, GLfloat(-0.5 * height), 0.0);
-
-            float angle = float(0.5 * pi); // First v is at max x
-            float aincr = float(2.0 * pi / nfacets);
-            for (size_t i = 0; i < nfacets; ++i, angle += aincr) {
-                glTexCoord2f(GLfloat(0.5 * (1.0 + sin(angle))),
-                             GLfloat(1.0 - 0.5 * (1.0 + cos(angle))));
-                glVertex3fv(&c[i + nfacets][0]);
-            }
-            glTexCoord2f(GLfloat(0.5 * (1.0 + sin(angle))),
-                         GLfloat(1.0 - 0.5 * (1.0 + cos(angle))));
-            glVertex3fv(&c[nfacets][0]);
-            glEnd();
-        }
-    }
+    if (this->draw_compiled_mesh(n)) { return; }
 
-    end_geometry();
-    if (glid) {
-        glEndList();
-        this->list_map_.insert(std::make_pair(&n, glid));
-    }
+    const boost::shared_ptr<compiled_mesh> mesh(new compiled_mesh);
+    compile_cone(height, radius, bottom, side, *mesh);
+    this->insert_compiled_mesh(n, mesh);
 }
 
 /**
- * @brief Insert a cylinder into a display list.
+ * @brief Insert a cylinder into the geometry cache.
  *
  * @param[in] n         the @c geometry_node corresponding to the cylinder.
  * @param[in] height    height.
@@ -1685,141 +1366,15 @@ void openvrml::gl::viewer::do_insert_cylinder(const geometry_node & n,
                                               const bool side,
                                               const bool top)
 {
-    const list_map_t::const_iterator list = this->list_map_.find(&n);
-    if (list != this->list_map_.end()) {
-        glCallList(list->second);
-        return;
-    }
-
-    GLuint glid = 0;
-
-    if (!this->select_mode) {
-        glid = glGenLists(1);
-        glNewList(glid, GL_COMPILE_AND_EXECUTE);
-    }
-
-    begin_geometry();
-    if (!bottom || !side || !top) { glDisable(GL_CULL_FACE); }
-
-    if (bottom || side || top) {
-        static const size_t nfacets = 8; // Number of polygons for sides
-        static const size_t npts = 2 * nfacets;
-        static const size_t nfaces = nfacets * 5;
-
-        float c[npts][3];                // coordinates
-        float tc[npts][3];                // texture coordinates
-        int faces[nfaces];                // face lists
-
-        // should only compute tc if a texture is present...
-        computeCylinder(height, radius, nfacets, c, tc, faces);
-
-        if (side) {
-            glBegin(GL_QUAD_STRIP);
-            for (size_t i = 0; i < nfacets; ++i) {
-                glNormal3f(c[i + nfacets][0], 0.0, c[i + nfacets][2]);
-                glTexCoord2fv(&tc[i + nfacets][0]);
-                glVertex3fv(&c[i + nfacets][0]);
-                glTexCoord2fv(&tc[i][0]);
-                glVertex3fv(&c[i][0]);
-            }
-
-            glNormal3f(c[nfacets][0], 0.0, c[nfacets][2]);
-            glTexCoord2f(tc[nfacets][0] - 1.0f, tc[nfacets][1]);
-            glVertex3fv(&c[nfacets][0]);
-            glTexCoord2f(tc[0][0] - 1.0f, tc[0][1]);
-            glVertex3fv(&c[0][0]);
-            glEnd();
-        }
-
-        if (bottom) {                // tex coords...
-            glBegin(GL_TRIANGLE_FAN);
-            glNormal3f(0.0, -1.0, 0.0);
-            glTexCoord2f(0.5, 0.5);
-            glVertex3f(0.0, GLfloat(-0.5 * height), 0.0);
-
-            float angle = float(0.5 * pi); // First v is at max x
-            const float aincr = float(2.0 * pi / nfacets);
-            for (size_t i = 0; i < nfacets; ++i, angle += aincr) {
-                glTexCoord2f(GLfloat(0.5 * (1.0 + sin(angle))),
-                             GLfloat(1.0 - 0.5 * (1.0 + cos(angle))));
-                glVertex3fv(&c[i + nfacets][0]);
-            }
-            glTexCoord2f(GLfloat(0.5 * (1.0 + sin(angle))),
-                         GLfloat(1.0 - 0.5 * (1.0 + cos(angle))));
-            glVertex3fv(&c[nfacets][0]);
-            glEnd();
-        }
-
-        if (top) {                // tex coords...
-            glBegin(GL_TRIANGLE_FAN);
-            glNormal3f(0.0, 1.0, 0.0);
-            glTexCoord2f(0.5, 0.5);
-            glVertex3f(0.0, GLfloat(0.5 * height), 0.0);
-
-            float angle = float(0.75 * pi);
-            const float aincr = float(2.0 * pi / nfacets);
-            for (size_t i = nfacets; i > 0; --i, angle += aincr) {
-                glTexCoord2f(GLfloat(0.5 * (1.0 + sin(angle))),
-                             GLfloat(1.0 - 0.5 * (1.0 + cos(angle))));
-                glVertex3fv(&c[i - 1][0]);
-            }
-            glTexCoord2f(GLfloat(0.5 * (1.0 + sin(angle))),
-                         GLfloat(1.0 - 0.5 * (1.0 + cos(angle))));
-            glVertex3fv(&c[nfacets - 1][0]);
-            glEnd();
-        }
-    }
-
-    end_geometry();
-    if (glid) {
-        glEndList();
-        this->list_map_.insert(std::make_pair(&n, glid));
-    }
-}
-
-namespace {
+    if (this->draw_compiled_mesh(n)) { return; }
 
-    // Compute a normal at vert i,j of an ElevationGrid.
-
-    OPENVRML_GL_LOCAL const openvrml::vec3f elevationVertexNormal(
-            const int i, const int j,
-            const int nx, const int nz,
-            const float dx, const float dz,
-            const std::vector<float>::const_iterator height)
-    {
-        openvrml::vec3f Vx, Vz;
-
-        if (i > 0 && i < nx - 1) {
-            Vx.x(float(2.0 * dx));
-            Vx.y(*(height + 1) - *(height - 1));
-        } else if (i == 0) {
-            Vx.x(dx);
-            Vx.y(*(height + 1) - *(height));
-        } else {
-            Vx.x(dx);
-            Vx.y(*(height) - *(height - 1));
-        }
-        Vx.z(0.0);
-
-        Vz.x(0.0);
-        if (j > 0 && j < nz - 1) {
-            Vz.y(*(height + nx) - *(height - nx));
-            Vz.z(float(2.0 * dz));
-        } else if (j == 0) {
-            Vz.y(*(height+nx) - *(height));
-            Vz.z(dz);
-        } else {
-            Vz.y(*(height) - *(height - nx));
-            Vz.z(dz);
-        }
-
-        return Vz * Vx;
-    }
+    const boost::shared_ptr<compiled_mesh> mesh(new compiled_mesh);
+    compile_cylinder(height, radius, bottom, side, top, *mesh);
+    this->insert_compiled_mesh(n, mesh);
 }
 
-
 /**
- * @brief Insert an elevation grid into a display list.
+ * @brief Insert an elevation grid into the geometry cache.
  *
  * @param[in] node          the @c geometry_node corresponding to the elevation
  *                          grid.
@@ -1846,876 +1401,101 @@ do_insert_elevation_grid(const geometry_node & node,
                          const std::vector<vec3f> & normal,
                          const std::vector<vec2f> & texCoord)
 {
-    const list_map_t::const_iterator list = this->list_map_.find(&node);
-    if (list != this->list_map_.end()) {
-        glCallList(list->second);
-        return;
-    }
-
-    int32 i, j;
-    float x, z;
-
-    GLuint glid = 0;
+    if (this->draw_compiled_mesh(node)) { return; }
 
-    if (!this->select_mode) {
-        glid = glGenLists(1);
-        glNewList( glid, GL_COMPILE_AND_EXECUTE );
-    }
-
-    this->begin_geometry();
+    const boost::shared_ptr<compiled_mesh> mesh(new compiled_mesh);
+    compile_elevation_grid(mask,
+                           height,
+                           xDimension,
+                           zDimension,
+                           xSpacing,
+                           zSpacing,
+                           color,
+                           normal,
+                           texCoord,
+                           *mesh);
+    this->insert_compiled_mesh(node, mesh);
+}
 
-    // Face orientation & culling
-    glFrontFace((mask & mask_ccw) ? GL_CCW : GL_CW);
-    if (!(mask & mask_solid)) { glDisable(GL_CULL_FACE); }
+/**
+ * @brief Insert an extrusion into the geometry cache.
+ *
+ * @param[in] n             the @c geometry_node corresponding to the extrusion.
+ * @param[in] mask
+ * @param[in] spine         spine points.
+ * @param[in] crossSection  cross-sections.
+ * @param[in] orientation   cross-section orientations.
+ * @param[in] scale         cross-section scales.
+ */
+void
+openvrml::gl::viewer::
+do_insert_extrusion(const geometry_node & n,
+                    unsigned int mask,
+                    const std::vector<vec3f> & spine,
+                    const std::vector<vec2f> & crossSection,
+                    const std::vector<openvrml::rotation> & orientation,
+                    const std::vector<vec2f> & scale)
+{
+    if (this->draw_compiled_mesh(n)) { return; }
 
-    std::vector<float>::const_iterator h = height.begin();
-    std::vector<openvrml::color>::const_iterator c = color.begin();
-    std::vector<vec3f>::const_iterator n = normal.begin();
-    std::vector<vec2f>::const_iterator tc = texCoord.begin();
+    const boost::shared_ptr<compiled_mesh> mesh(new compiled_mesh);
+    compile_extrusion(mask, spine, crossSection, orientation, scale, *mesh);
+    this->insert_compiled_mesh(n, mesh);
+}
 
-    // x varies fastest
-    for (j = 0; j < zDimension - 1; ++j) {
-        float s0, s1, t0 = 0.0, t1 = 0.0;
+/**
+ * @brief Insert a line set into the geometry cache.
+ *
+ * @param[in] n                 the @c geometry_node corresponding to the line
+ *                              set.
+ * @param[in] coord             coordinates.
+ * @param[in] coordIndex        coordinate indices.
+ * @param[in] colorPerVertex    whether colors are applied per-vertex or per-
+ *                              face.
+ * @param[in] color             colors.
+ * @param[in] colorIndex        color indices.
+ */
+void
+openvrml::gl::viewer::do_insert_line_set(const geometry_node & n,
+                                         const std::vector<vec3f> & coord,
+                                         const std::vector<int32> & coordIndex,
+                                         bool colorPerVertex,
+                                         const std::vector<color> & color,
+                                         const std::vector<int32> & colorIndex)
+{
+    if (this->draw_cached_geometry(n)) { return; }
 
-        z = zSpacing * j;
-        if (texCoord.empty()) {
-            t0 = float(j)     / (zDimension - 1);
-            t1 = float(j + 1) / (zDimension - 1);
-        }
+    if (coord.size() < 2) { return; }
 
-        glBegin(GL_QUAD_STRIP);
+    local::vertex_array_builder geometry;
 
-        for (i = 0; i < xDimension; ++i) {
-            x = xSpacing * i;
+    // Lighting, texturing don't apply to line sets
+    geometry.disable(GL_LIGHTING);
+    geometry.disable(GL_TEXTURE_2D);
+    const bool color_per_face = (!color.empty() && !colorPerVertex);
+    if (color_per_face) { geometry.shade_model(GL_FLAT); }
 
-            if (!color.empty() && ((mask & mask_color_per_vertex)
-                                    || (i < xDimension - 1))) {
-                glColor3fv(&(*c)[0]);
-            }
-
-            if (!normal.empty() && ((mask & mask_normal_per_vertex)
-                                    || (i < xDimension - 1))) {
-                glNormal3fv(&(*n)[0]);
-            } else if (normal.empty()) {
-                if (mask & mask_normal_per_vertex) {
-                    const vec3f N =
-                            elevationVertexNormal(i, j,
-                                                  xDimension, zDimension,
-                                                  xSpacing, zSpacing,
-                                                  h);
-                    glNormal3fv(&N[0]);
-                } else if (i < xDimension - 1) {
-                    //
-                    // Normal per face.
-                    //
-                    const vec3f vx = make_vec3f(xSpacing, *(h + 1) - *h, 0.0);
-                    const vec3f vz = make_vec3f(0.0,
-                                                *(h + xDimension) - *h,
-                                                zSpacing);
-                    glNormal3fv(&(vx * vz)[0]);
-                }
-            }
-
-            if (!texCoord.empty()) {
-                s0 = tc->x();
-                t0 = tc->y();
-                s1 = (tc + xDimension * 2)->x();
-                t1 = (tc + xDimension * 2)->y();
-                ++tc;
-            } else {
-                s0 = s1 = float(i) / (xDimension - 1);
-            }
-
-            glTexCoord2f(s0, t0);
-            glVertex3f(x, *h, z);
-
-            // Vertex from next row
-            if (!color.empty() && (mask & mask_color_per_vertex)) {
-                glColor3fv(&(*(c + xDimension))[0]);
-            }
-
-            if (mask & mask_normal_per_vertex) {
-                if (!normal.empty()) {
-                    glNormal3fv(&(*(n + xDimension))[0]);
-                } else {
-                    const vec3f N =
-                            elevationVertexNormal(i, j + 1,
-                                                  xDimension, zDimension,
-                                                  xSpacing, zSpacing,
-                                                  h + xDimension);
-                    glNormal3fv(&N[0]);
-                }
-            }
-
-            glTexCoord2f(s1, t1);
-            glVertex3f(x, *(h + xDimension), z + zSpacing);
-
-            ++h;
-            if (!color.empty()) { ++c; }
-            if (!normal.empty()) { ++n; }
-        }
-
-        glEnd();
-    }
-
-    this->end_geometry();
-    if (glid) {
-        glEndList();
-        this->list_map_.insert(list_map_t::value_type(&node, glid));
-    }
-}
-
-
-namespace {
-
-    // Extrusion cap tessellation for non-convex shapes
-
-    struct OPENVRML_GL_LOCAL TessExtrusion {
-        const float * c; // coordinates array [nVerts * 3]
-        const float * crossSection; // crossSection coordinates [nCrossSection * 2]
-        float tcDeltaU, tcDeltaV;
-        float tcScaleU, tcScaleV;
-        size_t vOffset;
-        openvrml::vec3f N; // Normal
-
-        TessExtrusion(const float * c, const float * crossSection,
-                      float tcDeltaU, float tcDeltaV,
-                      float tcScaleU, float tcScaleV,
-                      size_t vOffset, const openvrml::vec3f & N);
-    };
-
-    TessExtrusion::TessExtrusion(const float * const c,
-                                 const float * const crossSection,
-                                 const float tcDeltaU,
-                                 const float tcDeltaV,
-                                 const float tcScaleU,
-                                 const float tcScaleV,
-                                 const size_t vOffset,
-                                 const openvrml::vec3f & N):
-        c(c),
-        crossSection(crossSection),
-        tcDeltaU(tcDeltaU),
-        tcDeltaV(tcDeltaV),
-        tcScaleU(tcScaleU),
-        tcScaleV(tcScaleV),
-        vOffset(vOffset),
-        N(N)
-    {}
-}
-
-extern "C" {
-    /**
-     * @internal
-     *
-     * @brief Tesselator callback.
-     *
-     * As the type of callback functions given to OpenGL, this type must have
-     * C linkage.
-     */
-# ifdef HAVE_VARARGS_GLU_TESSCB
-    typedef GLvoid (OPENVRML_GL_CALLBACK_* TessCB)(...);
-# else
-    typedef GLvoid (OPENVRML_GL_CALLBACK_* TessCB)();
-# endif
-
-    /**
-     * @internal
-     */
-    void OPENVRML_GL_CALLBACK_ tessExtrusionBegin(const GLenum type,
-                                                  void * const pdata)
-    {
-        const TessExtrusion & p = *static_cast<TessExtrusion *>(pdata);
-        glBegin(type);
-        glNormal3fv(&p.N[0]);
-    }
-
-    /**
-     * @internal
-     */
-    void OPENVRML_GL_CALLBACK_ tessExtrusionVertex(void * const vdata,
-                                                   void * const pdata)
-    {
-        const size_t j = *static_cast<size_t *>(vdata);
-        const TessExtrusion & p = *static_cast<TessExtrusion *>(pdata);
-
-        glTexCoord2f((p.crossSection[2 * j] - p.tcDeltaU) * p.tcScaleU,
-                     (p.crossSection[2 * j + 1] - p.tcDeltaV) * p.tcScaleV);
-        glVertex3fv(&(p.c[3 * (j + p.vOffset)]));
-    }
-}
-
-namespace {
-
-    OPENVRML_GL_LOCAL void
-    insertExtrusionCaps(GLUtesselator & tesselator,
-                        const unsigned int mask,
-                        const size_t nSpine,
-                        const std::vector<openvrml::vec3f> & c,
-                        const std::vector<openvrml::vec2f> & cs)
-    {
-        using std::vector;
-        using openvrml::vec2f;
-        using openvrml::vec3f;
-        using openvrml::gl::viewer;
-
-        // Determine x,z ranges for top & bottom tex coords
-        float xz[4] = { cs[0].x(), cs[0].x(), cs[0].y(), cs[0].y() };
-        vector<vec2f>::const_iterator csp = cs.begin();
-        for (vector<vec2f>::size_type nn = 1; nn < cs.size(); ++nn, ++csp) {
-            if (csp->x() < xz[0]) {
-                xz[0] = csp->x();
-            } else if (csp->x() > xz[1]) {
-                xz[1] = csp->x();
-            }
-            if (csp->y() < xz[2]) {
-                xz[2] = csp->y();
-            } else if (csp->y() > xz[3]) {
-                xz[3] = csp->y();
-            }
-        }
-
-        float dx = xz[1] - xz[0];
-        float dz = xz[3] - xz[2];
-        if (!fequal(dx, 0.0f)) { dx = float(1.0 / dx); }
-        if (!fequal(dz, 0.0f)) { dz = float(1.0 / dz); }
-
-        // If geometry is in dlists, should just always use the tesselator...
-
-        const bool equalEndpts = cs.front() == cs.back();
-
-        if (!(mask & viewer::mask_convex)) {
-            gluTessCallback(&tesselator, GLU_TESS_BEGIN_DATA,
-                            reinterpret_cast<TessCB>(tessExtrusionBegin));
-            gluTessCallback(&tesselator, GLU_TESS_VERTEX_DATA,
-                            reinterpret_cast<TessCB>(tessExtrusionVertex));
-            gluTessCallback(&tesselator, GLU_TESS_END,
-                            reinterpret_cast<TessCB>(glEnd));
-
-            if (mask & viewer::mask_bottom) {
-                TessExtrusion bottom(&c[0][0],
-                                     &cs[0][0],
-                                     xz[0], xz[2],
-                                     dx, dz,
-                                     0,
-                                     indexFaceNormal(0, 1, 2, c));
-
-                gluTessBeginPolygon(&tesselator, &bottom);
-                gluTessBeginContour(&tesselator);
-                GLdouble v[3];
-                // Mesa tesselator doesn;t like closed polys
-                size_t j = equalEndpts ? cs.size() - 2 : cs.size() - 1;
-                for (; j > 0; --j) {
-                    const size_t index = j - 1;
-                    v[0] = c[index].x();
-                    v[1] = c[index].y();
-                    v[2] = c[index].z();
-                    gluTessVertex(&tesselator,
-                                  v,
-                                  const_cast<GLvoid *>(
-                                      static_cast<const GLvoid *>(&index)));
-                }
-                gluTessEndContour(&tesselator);
-                gluTessEndPolygon(&tesselator);
-            }
-
-            if (mask & viewer::mask_top) {
-                size_t n = (nSpine - 1) * cs.size();
-                TessExtrusion top(&c[0][0],
-                                  &cs[0][0],
-                                  xz[0], xz[2],
-                                  dx, dz,
-                                  n,
-                                  indexFaceNormal(n + 2, n + 1, n, c));
-
-                gluTessBeginPolygon(&tesselator, &top);
-                gluTessBeginContour(&tesselator);
-
-                GLdouble v[3];
-                // Mesa tesselator doesn;t like closed polys
-                size_t j = equalEndpts ? 1ul : 0ul;
-                for (; j < cs.size(); ++j) {
-                    v[0] = c[j + n].x();
-                    v[1] = c[j + n].y();
-                    v[2] = c[j + n].z();
-                    gluTessVertex(&tesselator, v, &j);
-                }
-                gluTessEndContour(&tesselator);
-                gluTessEndPolygon(&tesselator);
-            }
-        } else {
-            //
-            // Convex (or not GLU1.2 ...)
-            //
-            vec3f N; // Normal
-
-            if (mask & viewer::mask_bottom) {
-                glBegin(GL_POLYGON);
-                N = indexFaceNormal(0, 1, 2, c);
-                glNormal3fv(&N[0]);
-
-                for (size_t j = cs.size(); j > 0; --j) {
-                    const size_t index = j - 1;
-                    glTexCoord2f((cs[index].x() - xz[0]) * dx,
-                                 (cs[index].y() - xz[2]) * dz);
-                    glVertex3fv(&c[index][0]);
-                }
-                glEnd();
-            }
-
-            if (mask & viewer::mask_top) {
-                size_t n = (nSpine - 1) * cs.size();
-                glBegin(GL_POLYGON);
-                N = indexFaceNormal(n + 2, n + 1, n, c);
-                glNormal3fv(&N[0]);
-
-                for (size_t j = 0; j < cs.size(); ++j) {
-                    glTexCoord2f((cs[j].x() - xz[0]) * dx,
-                                 (cs[j].y() - xz[2]) * dz);
-                    glVertex3fv(&c[j + n][0]);
-                }
-                glEnd();
-            }
-        }
-    }
-
-    /**
-     * @brief Get the length of an Extrusion spine.
-     *
-     * The length of the spine is used in computing texture coordinates for an
-     * Extrusion.  In order to determine the texture coordinates at a given
-     * point on the Extrusion cross-section, the distance from the start of
-     * the spine is divided by its total length.  As such, this function
-     * returns 1.0 if the length of the spine is 0 (to avoid dividing by
-     * zero).
-     *
-     * @param[in] spine Extrusion spine.
-     *
-     * @return the length of the Extrusion spine described by @p spine; or 1.0
-     *         if the length is 0.
-     */
-    OPENVRML_GL_LOCAL
-    float get_spine_length(const std::vector<openvrml::vec3f> & spine)
-    {
-        using std::vector;
-        using openvrml::vec3f;
-
-        float result = 0.0;
-        for (vector<vec3f>::const_iterator point = spine.begin();
-             point < spine.end() - 1;
-             ++point) {
-            result += (*(point + 1) - *point).length();
-        }
-        return result == 0.0f ? 1.0f : result;
-    }
-
-    /**
-     * @brief Get the length of an Extrusion cross-section.
-     *
-     * The length of the cross-section is used in computing texture
-     * coordinates for an Extrusion.  In order to determine the texture
-     * coordinates at a given point on the Extrusion cross-section, the
-     * distance from the start of the cross-section is divided by its total
-     * length.  As such, this function returns 1.0 if the length of the
-     * cross-section is 0 (to avoid dividing by zero).
-     *
-     * @param[in] cross_section Extrusion cross-section.
-     *
-     * @return the length of the Extrusion cross-section described by
-     *         @p cross_section; or 1.0 if the length is 0.
-     */
-    OPENVRML_GL_LOCAL
-    float
-    get_cross_section_length(
-        const std::vector<openvrml::vec2f> & cross_section)
-    {
-        using std::vector;
-        using openvrml::vec2f;
-
-        float result = 0.0;
-        for (vector<vec2f>::const_iterator point = cross_section.begin();
-             point != cross_section.end() - 1;
-             ++point) {
-            result += (*(point + 1) - *point).length();
-        }
-        return result == 0.0f ? 1.0f : result;
-    }
-
-    /**
-     * @brief Compute the <var>y</var>-axis of the spine-aligned cross-section
-     *        plane.
-     *
-     * @param[in] point an arbitrary point in the extrusion spine.
-     * @param[in] first the first point in the extrusion spine.
-     * @param[in] last  the last point in the extrusion spine.
-     *
-     * @return the <var>y</var>-axis of the spine-aligned cross-section plane
-     *         at @p point.
-     */
-    OPENVRML_GL_LOCAL
-    const openvrml::vec3f
-    compute_scp_y_axis(
-        const std::vector<openvrml::vec3f>::const_iterator & point,
-        const std::vector<openvrml::vec3f>::const_iterator & first,
-        const std::vector<openvrml::vec3f>::const_iterator & last,
-        const openvrml::vec3f & prev)
-    {
-        if (point != first && point != last) {
-            if (*point == *(point - 1)) { return prev; }
-            return (*(point + 1) - *(point - 1)).normalize();
-        }
-
-        //
-        // From here on, we're dealing with the first or last point.
-        //
-        const bool spine_closed = (*first == *last);
-
-        if (spine_closed) {
-            return (*(first + 1) - *(last - 1)).normalize();
-        }
-
-        //
-        // The spine is not closed.
-        //
-        if (point == first) {
-            return (*(first + 1) - *first).normalize();
-        }
-
-        assert(point == last);
-        assert(last - first > 0);
-        return (*last - *(last - 1)).normalize();
-    }
-
-    /**
-     * @brief Compute the <var>z</var>-axis of the spine-aligned cross-section
-     *        plane.
-     *
-     * @param[in] point an arbitrary point in the extrusion spine.
-     * @param[in] first the first point in the extrusion spine.
-     * @param[in] last  the last point in the extrusion spine.
-     * @param[in] prev  the <var>z</var>-axis of the spine-aligned
-     *                  cross-section plane for the previous spine point.
-     *
-     * @return the <var>z</var>axis of the spine-aligned cross-section plane
-     *         at @p point.
-     */
-    OPENVRML_GL_LOCAL
-    const openvrml::vec3f
-    compute_scp_z_axis(
-        const std::vector<openvrml::vec3f>::const_iterator & point,
-        const std::vector<openvrml::vec3f>::const_iterator & first,
-        const std::vector<openvrml::vec3f>::const_iterator & last,
-        const openvrml::vec3f & prev)
-    {
-        using openvrml::vec3f;
-        using openvrml::make_vec3f;
-
-        vec3f z0, z1;
-
-        if (point != first && point != last) {
-            if (*point == *(point - 1)) { return prev; }
-            z0 = *(point + 1) - *point;
-            z1 = *(point - 1) - *point;
-        } else {
-
-            //
-            // From here on, we're dealing with the first or last point.
-            //
-            const bool spine_closed = (*first == *last);
-
-            if (spine_closed) {
-                z0 = *(first + 1) - *first;
-                z1 = *(last - 1) - *first;
-            } else {
-                if (last - first == 1) { return prev; }
-                if (point == first) {
-                    //
-                    // The spine is not closed.
-                    //
-                    z0 = *(first + 2) - *(first + 1);
-                    z1 = *first - *(first + 1);
-                } else {
-                    assert(point == last);
-                    assert(last - first > 0);
-                    z0 = *(last - 2) - *(last - 1);
-                    z1 = *last - *(last - 1);
-                }
-            }
-        }
-
-        if (fequal(z0.dot(z1), 1.0f)) { return prev; }
-
-        const vec3f z = (z0 * z1).normalize();
-        if (z == make_vec3f(0.0, 0.0, 0.0)) { return prev; }
-
-        return (z.dot(prev) < 0) ? -z : z;
-    }
-
-    /**
-     * @brief Determine if the extrusion spine points are collinear.
-     *
-     * If this function returns @c true, @p scp_x, @p scp_y, and @p scp_z are
-     * the axes of the spine-aligned cross-section plane that should be used
-     * for the extent of the extrusion.
-     *
-     * @param[in] spine     the extrusion spine.
-     * @param[out] scp_x    the initial spine-aligned cross-section plane
-     *                      <var>x</var>-axis.
-     * @param[out] scp_y    the initial spine-aligned cross-section plane
-     *                      <var>y</var>-axis.
-     * @param[out] scp_z    the initial spine-aligned cross-section plane
-     *                      <var>z</var>-axis.
-     *
-     * @return @c true if the points in @p spine are collinear; @c false
-     *         otherwise.
-     */
-    OPENVRML_GL_LOCAL
-    bool
-    check_spine_points_collinear(const std::vector<openvrml::vec3f> & spine,
-                                 openvrml::vec3f & scp_x,
-                                 openvrml::vec3f & scp_y,
-                                 openvrml::vec3f & scp_z)
-    {
-        using std::vector;
-        using openvrml::mat4f;
-        using openvrml::make_rotation_mat4f;
-        using openvrml::make_scale_mat4f;
-        using openvrml::rotation;
-        using openvrml::make_rotation;
-        using openvrml::vec3f;
-        using openvrml::make_vec3f;
-
-        //
-        // First, iterate over the spine points until either the y- or z-axis
-        // for the spine-aligned cross-section plane (SCP) is valid (i.e.,
-        // nonzero).  We bail out of the loop as soon as we get a valid y- or
-        // z-axis; because that means we've hit the first noncollinear point.
-        // If the points are all collinear, we won't have a valid z-axis (or
-        // y-axis) when we're done.
-        //
-        static const vec3f zero = make_vec3f();
-        scp_y = zero;
-        scp_z = zero;
-        vec3f prev_scp_y = zero, prev_scp_z = zero;
-        for (vector<vec3f>::const_iterator point = spine.begin();
-             point < spine.end() && (prev_scp_y == zero || prev_scp_z == zero);
-             ++point) {
-            if (prev_scp_y == zero) {
-                scp_y = compute_scp_y_axis(point,
-                                           spine.begin(),
-                                           spine.end() - 1,
-                                           prev_scp_y);
-                if (scp_y != zero) { prev_scp_y = scp_y; }
-            }
-            if (prev_scp_z == zero) {
-                scp_z = compute_scp_z_axis(point,
-                                           spine.begin(),
-                                           spine.end() - 1,
-                                           prev_scp_z);
-                if (scp_z != zero) { prev_scp_z = scp_z; }
-            }
-        }
-
-        //
-        // If all the points are coincident, prev_scp_y will be invalid
-        // (zero).  Set it to (0 1 0).
-        //
-        if (prev_scp_y == zero) { prev_scp_y = make_vec3f(0.0, 1.0, 0.0); }
-
-        //
-        // If all the points are collinear, prev_scp_z will be invalid (zero).
-        // Default it to (0 0 1); then, per 6.18.3 of VRML97:
-        //
-        //   If the entire spine is collinear, the SCP is computed by finding
-        //   the rotation of a vector along the positive Y-axis (v1) to the
-        //   vector formed by the spine points (v2).  The Y=0 plane is then
-        //   rotated by this value.
-        //
-        bool spine_points_collinear = false;
-        if (prev_scp_z == zero) {
-            spine_points_collinear = true;
-            prev_scp_z = make_vec3f(0.0, 0.0, 1.0);
-            if (prev_scp_y != make_vec3f(0.0, 1.0, 0.0)) {
-                const mat4f rot_mat =
-                    make_rotation_mat4f(
-                        make_rotation(make_vec3f(0.0, 1.0, 0.0),
-                                      prev_scp_y));
-                prev_scp_z *= rot_mat;
-            }
-        }
-
-        if (spine_points_collinear) {
-            scp_y = prev_scp_y;
-            scp_z = prev_scp_z;
-            scp_x = (scp_y * scp_z).normalize();
-        }
-
-        return spine_points_collinear;
-    }
-
-    /**
-     * @brief Compute the coordinates and texture coordinates for an extrusion.
-     *
-     * @param[in] cross_section
-     * @param[in] spine
-     * @param[in] scale
-     * @param[in] orientation
-     * @param[out] coord
-     * @param[out] texcoord
-     */
-    OPENVRML_GL_LOCAL void
-    compute_extrusion_coords_(
-        const std::vector<openvrml::vec2f> & cross_section,
-        const std::vector<openvrml::vec3f> & spine,
-        const std::vector<openvrml::vec2f> & scale,
-        const std::vector<openvrml::rotation> & orientation,
-        std::vector<openvrml::vec3f> & coord,
-        std::vector<openvrml::vec2f> & texcoord)
-    {
-        using std::vector;
-        using openvrml::rotation;
-        using openvrml::vec2f;
-        using openvrml::make_vec2f;
-        using openvrml::vec3f;
-        using openvrml::make_vec3f;
-        using openvrml::mat4f;
-        using openvrml::make_mat4f;
-
-        coord.resize(spine.size() * cross_section.size());
-        texcoord.resize(spine.size() * cross_section.size());
-
-        //
-        // Check if the spine points are collinear.  If they are collinear,
-        // the spine-aligned cross-section plane computed for the first point
-        // will be used for the entire extrusion.
-        //
-        vec3f scp_x = make_vec3f(), scp_y = make_vec3f(), scp_z = make_vec3f();
-        const bool spine_points_collinear =
-            check_spine_points_collinear(spine, scp_x, scp_y, scp_z);
-
-        const float spine_length = get_spine_length(spine);
-        const float cross_section_length =
-            get_cross_section_length(cross_section);
-        float current_spine_length = 0.0;
-        for (vector<vec3f>::const_iterator spine_point = spine.begin();
-             spine_point != spine.end();
-             ++spine_point) {
-            if (!spine_points_collinear) {
-                scp_y = compute_scp_y_axis(spine_point,
-                                           spine.begin(),
-                                           spine.end() - 1,
-                                           scp_y);
-                scp_z = compute_scp_z_axis(spine_point,
-                                           spine.begin(),
-                                           spine.end() - 1,
-                                           scp_z);
-                scp_x = (scp_y * scp_z).normalize();
-            }
-
-            mat4f mat =
-                make_mat4f(
-                    scp_x.x(),        scp_x.y(),        scp_x.z(),        0.0,
-                    scp_y.x(),        scp_y.y(),        scp_y.z(),        0.0,
-                    scp_z.x(),        scp_z.y(),        scp_z.z(),        0.0,
-                    spine_point->x(), spine_point->y(), spine_point->z(), 1.0);
-
-            const vector<vec3f>::size_type spine_index =
-                static_cast<std::size_t>(std::distance(spine.begin(),
-                                                       spine_point));
-
-            if (!orientation.empty()) {
-                const vector<rotation>::size_type index =
-                    spine_index < orientation.size()
-                    ? spine_index
-                    : orientation.size() - 1;
-                mat = make_rotation_mat4f(orientation[index]) * mat;
-            }
-
-            if (!scale.empty()) {
-                const vector<vec2f>::size_type index =
-                    spine_index < scale.size()
-                    ? spine_index
-                    : scale.size() - 1;
-                mat = (make_scale_mat4f(make_vec3f(scale[index].x(),
-                                                   1.0,
-                                                   scale[index].y()))
-                       * mat);
-            }
-
-            float current_cross_section_length = 0.0;
-            for (vector<vec2f>::size_type i = 0;
-                 i < cross_section.size();
-                 ++i) {
-                vec3f cross_section_point = make_vec3f(cross_section[i].x(),
-                                                       0.0,
-                                                       cross_section[i].y());
-                cross_section_point *= mat;
-                const size_t coord_index =
-                    spine_index * cross_section.size() + i;
-                coord[coord_index] = cross_section_point;
-                texcoord[coord_index] =
-                    make_vec2f(
-                        current_cross_section_length / cross_section_length,
-                        current_spine_length / spine_length);
-
-                if (i < cross_section.size() - 1) {
-                    current_cross_section_length +=
-                        (cross_section[i + 1] - cross_section[i]).length();
-                }
-            }
-            if (spine_point < spine.end() - 1) {
-                current_spine_length +=
-                    (*(spine_point + 1) - *spine_point).length();
-            }
-        }
-    }
-}
-
-/**
- * @brief Insert an extrusion into a display list.
- *
- * @param[in] n             the @c geometry_node corresponding to the extrusion.
- * @param[in] mask
- * @param[in] spine         spine points.
- * @param[in] crossSection  cross-sections.
- * @param[in] orientation   cross-section orientations.
- * @param[in] scale         cross-section scales.
- */
-void
-openvrml::gl::viewer::
-do_insert_extrusion(const geometry_node & n,
-                    unsigned int mask,
-                    const std::vector<vec3f> & spine,
-                    const std::vector<vec2f> & crossSection,
-                    const std::vector<openvrml::rotation> & orientation,
-                    const std::vector<vec2f> & scale)
-{
-    const list_map_t::const_iterator list = this->list_map_.find(&n);
-    if (list != this->list_map_.end()) {
-        glCallList(list->second);
-        return;
-    }
-
-    using std::vector;
-    vector<vec3f> c(crossSection.size() * spine.size());
-    vector<vec2f> tc(crossSection.size() * spine.size());
-
-    compute_extrusion_coords_(crossSection, spine, scale, orientation, c, tc);
-
-    GLuint glid = 0;
-
-    if (!this->select_mode) {
-        glid = glGenLists(1);
-        glNewList(glid, GL_COMPILE_AND_EXECUTE);
-    }
-
-    this->begin_geometry();
-
-    // Face orientation & culling
-    glFrontFace((mask & mask_ccw) ? GL_CCW : GL_CW);
-    if (!(mask & mask_solid)) { glDisable(GL_CULL_FACE); }
-
-    // Handle creaseAngle, correct normals, ...
-    size_t section = 0;
-    for (vector<vec3f>::size_type i = 0;
-         i < spine.size() - 1;
-         ++i, section += crossSection.size()) {
-        glBegin(GL_QUAD_STRIP);
-        for (size_t j = 0; j < crossSection.size(); ++j) {
-            // Compute normals
-            vec3f v1 = j < crossSection.size() - 1
-                     ? c[section + j + 1] - c[section + j]
-                     : c[section + j] - c[section + j - 1];
-            vec3f v2 = c[section + j + crossSection.size()] - c[section + j];
-            v1 *= v2;
-            glNormal3fv(&v1[0]);
-
-            glTexCoord2fv(&tc[section + j + crossSection.size()][0]);
-            glVertex3fv(&c[section + j + crossSection.size()][0]);
-            glTexCoord2fv(&tc[section + j][0]);
-            glVertex3fv(&c[section + j][0]);
-        }
-        glEnd();
-    }
-
-    // Draw caps. Convex can only impact the caps of an extrusion.
-    if (mask & (mask_bottom | mask_top)) {
-        insertExtrusionCaps(*this->tesselator,
-                            mask,
-                            spine.size(),
-                            c,
-                            crossSection);
-    }
-
-    this->end_geometry();
-    if (glid) {
-        glEndList();
-        this->list_map_.insert(list_map_t::value_type(&n, glid));
-    }
-}
-
-/**
- * @brief Insert a line set into a display list.
- *
- * @param[in] n                 the @c geometry_node corresponding to the line
- *                              set.
- * @param[in] coord             coordinates.
- * @param[in] coordIndex        coordinate indices.
- * @param[in] colorPerVertex    whether colors are applied per-vertex or per-
- *                              face.
- * @param[in] color             colors.
- * @param[in] colorIndex        color indices.
- */
-void
-openvrml::gl::viewer::do_insert_line_set(const geometry_node & n,
-                                         const std::vector<vec3f> & coord,
-                                         const std::vector<int32> & coordIndex,
-                                         bool colorPerVertex,
-                                         const std::vector<color> & color,
-                                         const std::vector<int32> & colorIndex)
-{
-    const list_map_t::const_iterator list = this->list_map_.find(&n);
-    if (list != this->list_map_.end()) {
-        glCallList(list->second);
-        return;
-    }
-
-    GLuint glid = 0;
-
-    if (coord.size() < 2) { return; }
-
-    if (!this->select_mode) {
-        glid = glGenLists(1);
-        glNewList(glid, GL_COMPILE_AND_EXECUTE);
-    }
-
-    this->begin_geometry();
-
-    // Lighting, texturing don't apply to line sets
-    glDisable(GL_LIGHTING);
-    glDisable(GL_TEXTURE_2D);
-    const bool color_per_face = (!color.empty() && !colorPerVertex);
-    if (color_per_face) { glShadeModel(GL_FLAT); }
-
-    glBegin(GL_LINE_STRIP);
+    geometry.begin(GL_LINE_STRIP);
     if (!color.empty() && color_per_face) {
         const size_t color_index = !colorIndex.empty()
                                  ? static_cast<std::size_t>(colorIndex.front())
                                  : 0ul;
-        glColor3fv(&color[color_index][0]);
+        geometry.color(&color[color_index][0]);
     }
 
     size_t nl = 0;
     for (size_t i = 0; i < coordIndex.size(); ++i) {
         if (coordIndex[i] == -1) {
-            glEnd();
-            glBegin(GL_LINE_STRIP);
+            geometry.end();
+            geometry.begin(GL_LINE_STRIP);
             ++nl;
             if (i < coordIndex.size() - 1 && color_per_face) {
                 const int32 index = !colorIndex.empty()
                                   ? int32(colorIndex[nl])
                                   : int32(nl);
                 if (size_t(index) < color.size()) {
-                    glColor3fv(&color[static_cast<std::size_t>(index)][0]);
+                    geometry.color(
+                        &color[static_cast<std::size_t>(index)][0]);
                 }
             }
         } else {
@@ -2724,28 +1504,24 @@ openvrml::gl::viewer::do_insert_line_set(const geometry_node & n,
                                   ? colorIndex[i]
                                   : coordIndex[i];
                 if (size_t(index) < color.size()) {
-                    glColor3fv(&color[static_cast<std::size_t>(index)][0]);
+                    geometry.color(
+                        &color[static_cast<std::size_t>(index)][0]);
                 }
             }
             if (size_t(coordIndex[i]) < coord.size()) {
-                glVertex3fv(
+                geometry.vertex(
                     &coord[static_cast<std::size_t>(coordIndex[i])][0]);
             }
         }
     }
 
-    glEnd();
+    geometry.end();
 
-    this->end_geometry();
-
-    if (glid) {
-        glEndList();
-        this->list_map_.insert(list_map_t::value_type(&n, glid));
-    }
+    this->insert_geometry(n, geometry);
 }
 
 /**
- * @brief Insert a point set into a display list.
+ * @brief Insert a point set into the geometry cache.
  *
  * @param[in] n         the @c geometry_node corresponding to the point set.
  * @param[in] coord     points.
@@ -2756,294 +1532,27 @@ openvrml::gl::viewer::do_insert_point_set(const geometry_node & n,
                                           const std::vector<vec3f> & coord,
                                           const std::vector<color> & color)
 {
-    const list_map_t::const_iterator list = this->list_map_.find(&n);
-    if (list != this->list_map_.end()) {
-        glCallList(list->second);
-        return;
-    }
+    if (this->draw_cached_geometry(n)) { return; }
 
-    GLuint glid = 0;
-
-    if (!this->select_mode) {
-        glid = glGenLists(1);
-        glNewList(glid, GL_COMPILE_AND_EXECUTE);
-    }
-
-    this->begin_geometry();
+    local::vertex_array_builder geometry;
 
     // Lighting, texturing don't apply to points
-    glDisable(GL_LIGHTING);
-    glDisable(GL_TEXTURE_2D);
+    geometry.disable(GL_LIGHTING);
+    geometry.disable(GL_TEXTURE_2D);
 
-    glBegin(GL_POINTS);
+    geometry.begin(GL_POINTS);
 
     for (size_t i = 0; i < coord.size(); ++i) {
-        if (i < color.size()) { glColor3fv(&color[i][0]); }
-        glVertex3fv(&coord[i][0]);
+        if (i < color.size()) { geometry.color(&color[i][0]); }
+        geometry.vertex(&coord[i][0]);
     }
 
-    glEnd();
-    this->end_geometry();
-    if (glid) {
-        glEndList();
-        this->list_map_.insert(list_map_t::value_type(&n, glid));
-    }
+    geometry.end();
+    this->insert_geometry(n, geometry);
 }
 
-namespace {
-
-    OPENVRML_GL_LOCAL void computeBounds(size_t npoints,
-                                         const float * points,
-                                         float (&bounds)[6])
-    {
-        if (npoints == 0) {
-            std::fill(bounds, bounds + 6, 0.0f);
-        } else {
-            bounds[0] = bounds[1] = points[0]; // xmin, xmax
-            bounds[2] = bounds[3] = points[1]; // ymin, ymax
-            bounds[4] = bounds[5] = points[2]; // zmin, zmax
-
-            for (size_t i = 1; i < npoints; ++i) {
-                points += 3;
-                if (points[0] < bounds[0])      bounds[0] = points[0];
-                else if (points[0] > bounds[1]) bounds[1] = points[0];
-                if (points[1] < bounds[2])      bounds[2] = points[1];
-                else if (points[1] > bounds[3]) bounds[3] = points[1];
-                if (points[2] < bounds[4])      bounds[4] = points[2];
-                else if (points[2] > bounds[5]) bounds[5] = points[2];
-            }
-        }
-    }
-
-    OPENVRML_GL_LOCAL void texGenParams(float (&bounds)[6],  // xmin,xmax, ymin,ymax, zmin,zmax
-                                        int (&axes)[2],     // s, t
-                                        float (&params)[4]) // s0, 1/sSize, t0, 1/tSize
-    {
-        axes[0] = 0;
-        axes[1] = 1;
-        params[0] = params[1] = params[2] = params[3] = 0.0;
-
-        for (int nb = 0; nb < 3; ++nb) {
-            float db = bounds[2 * nb + 1] - bounds[2 * nb];
-            if (db > params[1]) {
-                axes[1] = axes[0];
-                axes[0] = nb;
-                params[2] = params[0];
-                params[3] = params[1];
-                params[0] = bounds[2 * nb];
-                params[1] = db;
-            } else if (db > params[3]) {
-                axes[1] = nb;
-                params[2] = bounds[2 * nb];
-                params[3] = db;
-            }
-        }
-
-        // If two of the dimensions are zero, give up.
-        if (fequal(params[1], 0.0f) || fequal(params[3], 0.0f)) { return; }
-
-        params[1] = float(1.0 / params[1]);
-        params[3] = float(1.0 / params[3]);
-    }
-
-    OPENVRML_GL_LOCAL void insertShellConvex(ShellData * const s)
-    {
-        using openvrml::vec3f;
-        using openvrml::gl::viewer;
-
-        vec3f N;
-        size_t i, nf = 0;                        // Number of faces
-
-        for (i = 0; i < s->coordIndex.size(); ++i) {
-            if (i == 0 || s->coordIndex[i] == -1) {
-                if (i > 0) { glEnd(); }
-                if (i == s->coordIndex.size() - 1) { break; }
-
-                glBegin(GL_POLYGON);
-
-                // Per-face attributes
-                const size_t color_index = (nf < s->colorIndex.size())
-                                         ? s->colorIndex[nf]
-                                         : nf;
-                if (color_index < s->color.size()
-                    && !(s->mask & viewer::mask_color_per_vertex)) {
-                    glColor3fv(&s->color[color_index][0]);
-                }
-
-                if (! (s->mask & viewer::mask_normal_per_vertex)) {
-                    size_t i1 = (i == 0)
-                           ? 0
-                           : i + 1;
-                    const size_t normal_index = (nf < s->normalIndex.size())
-                                              ? s->normalIndex[nf]
-                                              : nf;
-                    if (normal_index < s->normal.size()) {
-                        glNormal3fv(&s->normal[normal_index][0]);
-                    } else if (i < s->coordIndex.size() - 4
-                        && s->coordIndex[i1] >= 0
-                        && s->coordIndex[i1 + 1] >= 0
-                        && s->coordIndex[i1 + 2] >= 0) {
-                        N =
-                            indexFaceNormal(
-                                static_cast<std::size_t>(s->coordIndex[i1]),
-                                static_cast<std::size_t>(s->coordIndex[i1 + 1]),
-                                static_cast<std::size_t>(s->coordIndex[i1 + 2]),
-                                s->coord);
-
-                        // Flip normal if primitiv-orientation is clockwise
-                        if (!(s->mask & viewer::mask_ccw)) { N = -N; }
-                        glNormal3fv(&N[0]);
-                    }
-                }
-
-                ++nf;
-            }
-
-            if (s->coordIndex[i] >= 0) {
-                // Per-vertex attributes
-                const size_t color_index =
-                    static_cast<std::size_t>(
-                        (i < s->colorIndex.size()) ? s->colorIndex[i]
-                                                   : s->coordIndex[i]);
-                if (color_index < s->color.size()
-                    && (s->mask & viewer::mask_color_per_vertex)) {
-                    glColor3fv(&s->color[color_index][0]);
-                }
-
-                if (s->mask & viewer::mask_normal_per_vertex) {
-                    const size_t normal_index =
-                        static_cast<std::size_t>(
-                            (i < s->normalIndex.size()) ? s->normalIndex[i]
-                                                        : s->coordIndex[i]);
-                    if (normal_index < s->normal.size()) {
-                        glNormal3fv(&s->normal[normal_index][0]);
-                    } else {
-                        ; // Generate per-vertex normal here...
-                    }
-                }
-
-                const vec3f & v =
-                    s->coord[static_cast<std::size_t>(s->coordIndex[i])];
-                const size_t tex_coord_index =
-                    static_cast<std::size_t>(
-                        (i < s->texCoordIndex.size()) ? s->texCoordIndex[i]
-                                                      : s->coordIndex[i]);
-                if (tex_coord_index < s->texCoord.size()) {
-                    glTexCoord2fv(&s->texCoord[tex_coord_index][0]);
-                } else {
-                    float c0, c1;
-                    c0 = (v[static_cast<std::size_t>(s->texAxes[0])]
-                          - s->texParams[0])
-                        * s->texParams[1];
-                    c1 = (v[static_cast<std::size_t>(s->texAxes[1])]
-                          - s->texParams[2])
-                        * s->texParams[3];
-                    glTexCoord2f(c0, c1);
-                }
-
-                glVertex3fv(&v[0]);
-            }
-        }
-
-        // Watch out for no terminating -1 in face list
-        // two ways to break out:
-        //   i > 0 && i == coordIndex.size() - 1 && coordIndex[i] == -1
-        //   i == coordIndex.size()
-        //
-        if (i >= s->coordIndex.size()) {
-            if (s->coordIndex[i - 1] >= 0) { glEnd(); }
-        } else {
-            if (s->coordIndex[i] >= 0) { glEnd(); }
-        }
-    }
-
-    OPENVRML_GL_LOCAL void
-    insertShellTess(GLUtesselator & tessobj,
-                    const std::vector<vertex_data> & vertices,
-                    const std::vector<openvrml::int32> & coord_index,
-                    const bool color_per_face,
-                    const std::vector<openvrml::color> & color,
-                    const std::vector<openvrml::int32> & color_index,
-                    const bool normal_per_face,
-                    const std::vector<openvrml::vec3f> & normal,
-                    const std::vector<openvrml::int32> & normal_index)
-    {
-        using std::vector;
-        gluTessCallback(&tessobj,
-                        GLU_TESS_BEGIN_DATA,
-                        reinterpret_cast<TessCB>(shell_tess_begin));
-        gluTessCallback(&tessobj,
-                        GLU_TESS_VERTEX,
-                        reinterpret_cast<TessCB>(shell_tess_vertex));
-        gluTessCallback(&tessobj,
-                        GLU_TESS_COMBINE_DATA,
-                        reinterpret_cast<TessCB>(shell_tess_combine));
-        gluTessCallback(&tessobj,
-                        GLU_TESS_END_DATA,
-                        reinterpret_cast<TessCB>(shell_tess_end));
-        gluTessCallback(&tessobj, GLU_TESS_ERROR,
-                        reinterpret_cast<TessCB>(tess_error));
-
-        shell_tess_user_data user_data;
-        if (color_per_face) {
-            if (!color.empty()) {
-                user_data.face_color = &color;
-            }
-            if (!color_index.empty()) {
-                user_data.face_color_index = &color_index;
-            }
-        }
-        if (normal_per_face) {
-            if (!normal.empty()) {
-                user_data.face_normal = &normal;
-            }
-            if (!normal_index.empty()) {
-                user_data.face_normal_index = &normal_index;
-            }
-        }
-
-        gluTessBeginPolygon(&tessobj, &user_data);
-        gluTessBeginContour(&tessobj);
-        for (vector<openvrml::int32>::size_type i = 0;
-             i < coord_index.size();
-             ++i) {
-            using openvrml::int32;
-            if (!(coord_index[i] < int32(vertices.size()))) {
-                //
-                // We've encountered an invalid coordinate index.  Advance to
-                // the next polygon.
-                //
-                while (coord_index[i + 1] != -1) { ++i; }
-            } else if (coord_index[i] != -1) {
-                gluTessVertex(
-                    &tessobj,
-                    const_cast<GLdouble *>(
-                        vertices[
-                            static_cast<std::size_t>(coord_index[i])].coord),
-                    &const_cast<vertex_data &>(
-                        vertices[
-                            static_cast<std::size_t>(coord_index[i])]));
-            } else {
-                gluTessEndContour(&tessobj);
-                gluTessEndPolygon(&tessobj);
-                if (i != coord_index.size() - 1) {
-                    gluTessBeginPolygon(&tessobj, &user_data);
-                    gluTessBeginContour(&tessobj);
-                }
-            }
-        }
-
-        // Watch out for no terminating -1 in face list
-        if (coord_index.back() != -1) {
-            gluTessEndContour(&tessobj);
-            gluTessEndPolygon(&tessobj);
-        }
-    }
-}
-
-
 /**
- * @brief Insert a shell into a display list.
+ * @brief Insert a shell into the geometry cache.
  *
  * @param[in] n                 the @c geometry_node corresponding to the shell.
  * @param[in] mask
@@ -3069,202 +1578,20 @@ do_insert_shell(const geometry_node & n,
                 const std::vector<vec2f> & tex_coord,
                 const std::vector<int32> & tex_coord_index)
 {
-    const list_map_t::const_iterator list = this->list_map_.find(&n);
-    if (list != this->list_map_.end()) {
-        glCallList(list->second);
-        return;
-    }
-
-    using std::vector;
-    if (coord_index.size() < 4) { return; } // 3 pts and a trailing -1
-
-    // Texture coordinate generation parameters.
-    int texAxes[2] = { 0, 1 };         // Map s,t to x,y,z
-    float texParams[4] = {};           // s0, 1/sSize, t0, 1/tSize
-
-    // Compute bounding box for texture coord generation and lighting.
-    if (tex_coord.empty()) { // || any positional lights are active...
-        float bounds[6]; // xmin,xmax, ymin,ymax, zmin,zmax
-        computeBounds(coord.size(), &coord[0][0], bounds);
-
-        // do the bounds intersect the radius of any active positional lights.
-        texGenParams(bounds, texAxes, texParams);
-        if (fequal(texParams[1], 0.0f) || fequal(texParams[3], 0.0f)) {
-            return;
-        }
-    }
-
-    GLuint glid = 0;
-
-    if (!this->select_mode) {
-        glid = glGenLists(1);
-        glNewList(glid, GL_COMPILE_AND_EXECUTE);
-    }
-
-    this->begin_geometry();
-
-    // Face orientation & culling
-    glFrontFace((mask & mask_ccw) ? GL_CCW : GL_CW);
-    if (!(mask & mask_solid)) { glDisable(GL_CULL_FACE); }
-
-    // Color per face
-    if (!color.empty() && ! (mask & mask_color_per_vertex)) {
-        glShadeModel(GL_FLAT);
-    }
-
-    // -------------------------------------------------------
+    if (this->draw_compiled_mesh(n)) { return; }
 
-    // Generation of per vertex normals isn't implemented yet...
-    if (normal.empty() && (mask & mask_normal_per_vertex)) {
-        mask &= ~mask_normal_per_vertex;
-    }
-
-    // Handle non-convex polys
-    if (mask & mask_convex) {
-        ShellData s(mask,
-                    coord, coord_index,
-                    color, color_index,
-                    normal, normal_index,
-                    tex_coord, tex_coord_index,
-                    texAxes, texParams, 0, 0);
-
-        insertShellConvex(&s);
-    } else {
-        vector<vertex_data> vertices(coord.size()); // Throws std::bad_alloc.
-        for (vector<vertex_data>::size_type i = 0; i < vertices.size(); ++i) {
-            vertices[i].coord[0] = coord[i].x();
-            vertices[i].coord[1] = coord[i].y();
-            vertices[i].coord[2] = coord[i].z();
-        }
-
-        if (mask & mask_color_per_vertex) {
-            if (color_index.empty()) {
-                for (vector<openvrml::color>::size_type i = 0;
-                     i < color.size();
-                     ++i) {
-                    vertices[i].color = &color[i];
-                }
-            } else if (color_index.size() == coord_index.size()) {
-                for (vector<int32>::size_type i = 0;
-                     i < color_index.size();
-                     ++i) {
-                    if (color_index[i] < 0) { continue; }
-                    if (!(size_t(coord_index[i]) < coord.size())) { continue; }
-                    vertices[static_cast<std::size_t>(coord_index[i])].color =
-                        &color[static_cast<std::size_t>(color_index[i])];
-                }
-            }
-        }
-        if (mask & mask_normal_per_vertex) {
-            if (normal_index.empty()) {
-                for (vector<openvrml::vec3f>::size_type i = 0;
-                     i < normal.size();
-                     ++i) {
-                    vertices[i].normal = &normal[i];
-                }
-            } else if (normal_index.size() == coord_index.size()) {
-                for (vector<int32>::size_type i = 0;
-                     i < normal_index.size();
-                     ++i) {
-                    if (normal_index[i] < 0) { continue; }
-                    if (!(size_t(coord_index[i]) < coord.size())) { continue; }
-                    vertices[static_cast<std::size_t>(coord_index[i])].normal =
-                        &normal[static_cast<std::size_t>(normal_index[i])];
-                }
-            }
-        }
-
-        if (tex_coord_index.empty()) {
-            for (vector<openvrml::vec2f>::size_type i = 0;
-                 i < tex_coord.size();
-                 ++i) {
-                vertices[i].tex_coord = &tex_coord[i];
-            }
-        } else {
-            for (vector<int32>::size_type i = 0;
-                 i < tex_coord_index.size();
-                 ++i) {
-                if (tex_coord_index[i] < 0) { continue; }
-                vertices[static_cast<std::size_t>(tex_coord_index[i])]
-                    .tex_coord =
-                        &tex_coord[static_cast<std::size_t>(
-                            tex_coord_index[i])];
-            }
-        }
-
-        const bool color_per_face = !(mask & mask_color_per_vertex);
-        const bool normal_per_face = !(mask & mask_color_per_vertex);
-        insertShellTess(*this->tesselator,
-                        vertices,
-                        coord_index,
-                        color_per_face,
-                        color,
-                        color_index,
-                        normal_per_face,
-                        normal,
-                        normal_index);
-    }
-
-    this->end_geometry();
-
-    if (glid) {
-        glEndList();
-        this->list_map_.insert(list_map_t::value_type(&n, glid));
-    }
-}
-
-namespace {
-
-    OPENVRML_GL_LOCAL void computeSphere(const double radius,
-                                         const int numLatLong,
-                                         float (*c)[3],
-                                         float (*tc)[3],
-                                         int *faces)
-    {
-        double r, angle, x, y, z;
-        int i, j, polyIndex;
-
-        // Compute coordinates, texture coordinates:
-        for (i = 0; i < numLatLong; ++i) {
-            /*y = 2.0 * ( ((double)i) / (numLatLong-1) ) - 1.0;*/
-            angle = ( i * pi / (numLatLong-1) ) - pi_2;
-            y = sin( angle );
-            r = sqrt( 1.0 - y*y );
-            for (j = 0; j < numLatLong; ++j) {
-                angle = 2 * pi * ((double)j) / numLatLong;
-                x = - sin(angle)*r;
-                z = - cos(angle)*r;
-                c[i * numLatLong + j][0] = float(radius * x);
-                c[i * numLatLong + j][1] = float(radius * y);
-                c[i * numLatLong + j][2] = float(radius * z);
-                if (tc) {
-                    tc[i * numLatLong + j][0] = float(j) / numLatLong;
-                    tc[i * numLatLong + j][1] = float(i) / numLatLong;
-                    tc[i * numLatLong + j][2] = 0.0;
-                }
-            }
-        }
-
-        // And compute indices:
-        if (faces) {
-            for (i = 0; i < numLatLong-1; ++i) {
-                for (j = 0; j < numLatLong; ++j) {
-                    polyIndex = 5 * (i * numLatLong + j);
-                    faces[polyIndex + 0] = i * numLatLong + j;
-                    faces[polyIndex + 1] = i * numLatLong
-                                           + (j + 1) % numLatLong;
-                    faces[polyIndex + 2] = (i + 1) * numLatLong
-                                           + (j + 1) % numLatLong;
-                    faces[polyIndex + 3] = (i + 1) * numLatLong + j;
-                    faces[polyIndex + 4] = -1;  // quad
-                }
-            }
-        }
-    }
+    const boost::shared_ptr<compiled_mesh> mesh(new compiled_mesh);
+    compile_shell(mask,
+                  coord, coord_index,
+                  color, color_index,
+                  normal, normal_index,
+                  tex_coord, tex_coord_index,
+                  *mesh);
+    this->insert_compiled_mesh(n, mesh);
 }
 
 /**
- * @brief Insert a sphere into a display list.
+ * @brief Insert a sphere into the geometry cache.
  *
  * @param[in] n         the @c geometry_node corresponding to the sphere.
  * @param[in] radius    sphere radius.
@@ -3273,61 +1600,31 @@ void
 openvrml::gl::viewer::do_insert_sphere(const geometry_node & n,
                                        const float radius)
 {
-    const list_map_t::const_iterator list = this->list_map_.find(&n);
-    if (list != this->list_map_.end()) {
-        glCallList(list->second);
-        return;
-    }
-
-    GLuint glid = 0;
-
-    if (!this->select_mode) {
-        glid = glGenLists(1);
-        glNewList(glid, GL_COMPILE_AND_EXECUTE);
-    }
-
-    static const size_t numLatLong = 10;
-    static const size_t npts = numLatLong * numLatLong;
+    if (this->draw_compiled_mesh(n)) { return; }
 
-    float c[npts][3];
-    float tc[npts][3];
-
-    // should only compute tc if a texture is present...
-    computeSphere(radius, numLatLong, c, tc, 0);
-
-    this->begin_geometry();
-
-    for (size_t i = 0; i < numLatLong - 1; ++i) {
-        size_t n = i * numLatLong;
-
-        glBegin(GL_QUAD_STRIP);
-
-        for (size_t j = 0; j < numLatLong; ++j) {
-            glTexCoord2f(tc[n + j + numLatLong][0], tc[n + j + numLatLong][1]);
-            glNormal3fv(&c[n + j + numLatLong][0]);
-            glVertex3fv(&c[n + j + numLatLong][0]);
-
-            glTexCoord2f(tc[n+j][0], tc[n+j][1]);
-            glNormal3fv(&c[n+j][0]);
-            glVertex3fv(&c[n+j][0]);
-        }
-
-        glTexCoord2f(1.0, tc[n + numLatLong][1]);
-        glNormal3fv(&c[n + numLatLong][0]);
-        glVertex3fv(&c[n + numLatLong][0]);
-
-        glTexCoord2f(1.0, tc[n][1]);
-        glNormal3fv(&c[n][0]);
-        glVertex3fv(&c[n][0]);
+    const boost::shared_ptr<compiled_mesh> mesh(new compiled_mesh);
+    compile_sphere(radius, *mesh);
+    this->insert_compiled_mesh(n, mesh);
+}
 
-        glEnd();
-    }
+/**
+ * @brief Insert a compiled mesh into the geometry cache.
+ *
+ * The mesh is loaded into the geometry cache unless @p n's geometry is
+ * there already.
+ *
+ * @param[in] n     a @c geometry_node.
+ * @param[in] mesh  the mesh compiled for @p n.
+ */
+void
+openvrml::gl::viewer::do_insert_mesh(const geometry_node & n,
+                                     const compiled_mesh & mesh)
+{
+    if (this->draw_cached_geometry(n)) { return; }
 
-    this->end_geometry();
-    if (glid) {
-        glEndList();
-        this->list_map_.insert(list_map_t::value_type(&n, glid));
-    }
+    local::vertex_array_builder geometry;
+    geometry.triangles(mesh);
+    this->insert_geometry(n, geometry);
 }
 
 /**
@@ -3510,6 +1807,8 @@ void openvrml::gl::viewer::do_insert_spot_light(const float ambientIntensity,
  */
 void openvrml::gl::viewer::do_remove_object(const node & ref)
 {
+    this->geometry_cache_->remove(ref);
+
     const list_map_t::const_iterator list = this->list_map_.find(&ref);
     if (list == this->list_map_.end()) { return; }
     glDeleteLists(list->second, 1);
@@ -3688,9 +1987,34 @@ namespace {
     }
 }
 
+/**
+ * @brief Whether @p img is what was last uploaded to the texture object.
+ *
+ * A decoder publishes an image by swapping a new pixel buffer into it, so
+ * the address of the pixels identifies the content along with the
+ * dimensions.
+ *
+ * @param[in] img   an image.
+ *
+ * @return @c true if @p img is what was last uploaded; @c false otherwise.
+ */
+bool
+openvrml::gl::viewer::texture_object::uploaded(const image & img) const
+    OPENVRML_NOTHROW
+{
+    return this->x == img.x() && this->y == img.y() && this->comp == img.comp()
+        && this->pixels == (img.array().empty() ? 0 : &img.array()[0]);
+}
+
 /**
  * @brief Create a texture object.
  *
+ * Texture objects are keyed on the @c image rather than on the
+ * @c texture_node, so that nodes sharing an image share a texture object.
+ * Since the wrap mode is a property of the node, it is set each time the
+ * texture object is bound.  The texture is uploaded again if the image has
+ * changed since it was uploaded, or if a node using it has been modified.
+ *
  * @param[in] n             texture.
  * @param[in] retainHint    whether the texture is likely to be reused.
  */
@@ -3706,12 +2030,33 @@ void openvrml::gl::viewer::do_insert_texture(const texture_node & n,
         GL_RGBA             // 4 components
     };
 
-    const texture_map_t::const_iterator texture = this->texture_map_.find(&n);
-    if (texture != this->texture_map_.end()) {
+    const texture_map_t::iterator texture = this->texture_map_.find(&n);
+    if (texture != this->texture_map_.end()
+        && texture->second != &n.image()) {
+        this->release_texture(texture);
+    }
+
+    const texture_object_map_t::iterator texture_object =
+        this->texture_objects_.find(&n.image());
+    if (texture_object != this->texture_objects_.end()) {
+        if (this->texture_map_.insert(
+                texture_map_t::value_type(&n, &n.image())).second) {
+            ++texture_object->second.users;
+        }
+    }
+    if (texture_object != this->texture_objects_.end()
+        && !texture_object->second.stale
+        && texture_object->second.uploaded(n.image())) {
         // Enable blending if needed.
         const int32 comp = static_cast<int32>(n.image().comp());
         if (this->blend && (comp == 2 || comp == 4)) { glEnable(GL_BLEND); }
-        glBindTexture(GL_TEXTURE_2D, texture->second);
+        glBindTexture(GL_TEXTURE_2D, texture_object->second.name);
+        glTexParameteri(GL_TEXTURE_2D,
+                        GL_TEXTURE_WRAP_S,
+                        n.repeat_s() ? GL_REPEAT : GL_CLAMP);
+        glTexParameteri(GL_TEXTURE_2D,
+                        GL_TEXTURE_WRAP_T,
+                        n.repeat_t() ? GL_REPEAT : GL_CLAMP);
         return;
     }
 
@@ -3769,7 +2114,10 @@ void openvrml::gl::viewer::do_insert_texture(const texture_node & n,
             glEnable(GL_BLEND);
         }
 
-        if (retainHint) {
+        if (texture_object != this->texture_objects_.end()) {
+            glid = texture_object->second.name;
+            glBindTexture(GL_TEXTURE_2D, glid);
+        } else if (retainHint) {
             glGenTextures(1, &glid);
             glBindTexture(GL_TEXTURE_2D, glid);
         }
@@ -3801,24 +2149,67 @@ void openvrml::gl::viewer::do_insert_texture(const texture_node & n,
     }
 
     if (glid) {
-        this->texture_map_.insert(texture_map_t::value_type(&n, glid));
+        viewer::texture_object object = {
+            glid,
+            1,
+            false,
+            n.image().x(),
+            n.image().y(),
+            n.image().comp(),
+            &n.image().array()[0]
+        };
+        if (texture_object != this->texture_objects_.end()) {
+            object.users = texture_object->second.users;
+            texture_object->second = object;
+        } else {
+            this->texture_objects_.insert(
+                texture_object_map_t::value_type(&n.image(), object));
+            this->texture_map_.insert(
+                texture_map_t::value_type(&n, &n.image()));
+        }
     }
 }
 
 /**
  * @brief Remove a texture from the display list.
  *
+ * Other nodes may still share the texture object; it is marked stale so that
+ * it is uploaded again the next time any of them inserts it.
+ *
  * @param[in] ref   texture handle.
  */
 void openvrml::gl::viewer::do_remove_texture_object(const texture_node & ref)
 {
     const texture_map_t::iterator texture = this->texture_map_.find(&ref);
     if (texture != this->texture_map_.end()) {
-        glDeleteTextures(1, &texture->second);
-        this->texture_map_.erase(texture);
+        const texture_object_map_t::iterator texture_object =
+            this->texture_objects_.find(texture->second);
+        assert(texture_object != this->texture_objects_.end());
+        texture_object->second.stale = true;
+        this->release_texture(texture);
     }
 }
 
+/**
+ * @brief Release a node's reference to a texture object.
+ *
+ * The texture object is deleted when no node refers to it.
+ *
+ * @param[in] texture   an entry in @c #texture_map_.
+ */
+void
+openvrml::gl::viewer::release_texture(const texture_map_t::iterator texture)
+{
+    const texture_object_map_t::iterator texture_object =
+        this->texture_objects_.find(texture->second);
+    assert(texture_object != this->texture_objects_.end());
+    if (--texture_object->second.users == 0) {
+        glDeleteTextures(1, &texture_object->second.name);
+        this->texture_objects_.erase(texture_object);
+    }
+    this->texture_map_.erase(texture);
+}
+
 /**
  * @brief Set the texture transform.
  *
@@ -4028,6 +2419,11 @@ void openvrml::gl::viewer::redraw()
 
     this->browser()->render();
 
+    //
+    // Geometry removed during the frame and not inserted again is gone.
+    //
+    this->geometry_cache_->release_stale();
+
     this->swap_buffers();
 
     this->render_time1 = this->render_time;
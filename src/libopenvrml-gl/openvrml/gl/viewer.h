@@ -36,22 +36,47 @@
 #   else
 #     error must define OPENVRML_GL_HAVE_GL_GLU_H or OPENVRML_GL_HAVE_OPENGL_GLU_H
 #   endif
+#   include <boost/scoped_ptr.hpp>
+#   include <boost/shared_ptr.hpp>
 #   include <map>
 #   include <stack>
 
 namespace openvrml {
 
+    class compiled_mesh;
+
     namespace gl {
 
+        namespace local {
+            class geometry_cache;
+            class vertex_array_builder;
+        }
+
         class OPENVRML_GL_API viewer : public openvrml::viewer {
             typedef std::map<const node *, GLuint> list_map_t;
             struct delete_list;
             list_map_t list_map_;
 
-            typedef std::map<const texture_node *, GLuint> texture_map_t;
-            struct delete_texture;
+            typedef std::map<const texture_node *, const image *>
+                texture_map_t;
             texture_map_t texture_map_;
 
+            struct texture_object {
+                GLuint name;
+                std::size_t users;
+                bool stale;
+                std::size_t x, y, comp;
+                const unsigned char * pixels;
+
+                bool uploaded(const image & img) const OPENVRML_NOTHROW;
+            };
+            typedef std::map<const image *, texture_object>
+                texture_object_map_t;
+            struct delete_texture;
+            texture_object_map_t texture_objects_;
+
+            boost::scoped_ptr<local::geometry_cache> geometry_cache_;
+
         public:
             enum { max_lights = 8 };
 
@@ -126,8 +151,6 @@ namespace openvrml {
 
             size_t objects, nested_objects;
 
-            GLUtesselator * tesselator;
-
             size_t sensitive;
             size_t active_sensitive;
             size_t over_sensitive;
@@ -153,6 +176,13 @@ namespace openvrml {
 
             void begin_geometry();
             void end_geometry();
+            bool draw_cached_geometry(const node & n);
+            void insert_geometry(const node & n,
+                                 local::vertex_array_builder & geometry);
+            bool draw_compiled_mesh(const geometry_node & n);
+            void insert_compiled_mesh(
+                const geometry_node & n,
+                const boost::shared_ptr<compiled_mesh> & mesh);
 
             void step(float, float, float);
             void zoom(float);
@@ -259,6 +289,8 @@ namespace openvrml {
 
             virtual void do_insert_sphere(const geometry_node & n,
                                           float radius);
+            virtual void do_insert_mesh(const geometry_node & n,
+                                        const compiled_mesh & mesh);
 
             // Lights
             virtual void do_insert_dir_light(float ambientIntensity,
@@ -309,6 +341,7 @@ namespace openvrml {
                                            bool retainHint = false);
 
             virtual void do_remove_texture_object(const texture_node & n);
+            void release_texture(texture_map_t::iterator texture);
 
             virtual void do_set_texture_transform(const vec2f & center,
                                                   float rotation,
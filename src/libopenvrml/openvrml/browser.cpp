@@ -21,6 +21,7 @@
 //
 
 # include "browser.h"
+# include "compiled_mesh.h"
 # include "scene.h"
 # include "scope.h"
 # include "viewer.h"
@@ -28,7 +29,16 @@
 # include <openvrml/local/node_metatype_registry_impl.h>
 # include <openvrml/local/component.h>
 # include <openvrml/local/parse_vrml.h>
+# include <openvrml/local/event_cascade.h>
+# include <openvrml/local/time_dependent_islands.h>
+# include <openvrml/local/io_executor.h>
+# include <openvrml/local/compute_executor.h>
+# include <openvrml/local/mapped_file.h>
+# include <openvrml/local/mesh_compiler.h>
+# include <openvrml/local/render_queue.h>
+# include <openvrml/local/resource_cache.h>
 # include <private.h>
+# include <boost/algorithm/string/predicate.hpp>
 # include <boost/bind.hpp>
 # include <boost/function.hpp>
 # include <boost/functional.hpp>
@@ -36,7 +46,9 @@
 # include <boost/scope_exit.hpp>
 # include <algorithm>
 # include <functional>
+# include <cctype>
 # include <cerrno>
+# include <cstdlib>
 # ifdef _WIN32
 #   include <sys/timeb.h>
 #   include <direct.h>
@@ -465,6 +477,11 @@ const char openvrml::x_vrml_media_type[15] = "x-world/x-vrml";
  */
 const char openvrml::x3d_vrml_media_type[15] = "model/x3d-vrml";
 
+/**
+ * @brief X3D Compressed Binary Encoding MIME media type.
+ */
+const char openvrml::x3d_binary_media_type[17] = "model/x3d+binary";
+
 /**
  * @class openvrml::resource_istream openvrml/browser.h
  *
@@ -559,6 +576,55 @@ bool openvrml::resource_istream::data_available() const OPENVRML_NOTHROW
  *         otherwise.
  */
 
+/**
+ * @brief Ask to be told when data is available to be read from the stream.
+ *
+ * This function delegates to @c #do_notify_data_available.
+ *
+ * @param[in] callback  called once, when @c #data_available would return
+ *                      @c true.  It must not throw.
+ *
+ * @return @c true if @p callback will be called; @c false if the stream
+ *         cannot say when data arrives, in which case the caller must check
+ *         @c #data_available again later.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+bool
+openvrml::resource_istream::
+notify_data_available(const boost::function0<void> & callback)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    return this->do_notify_data_available(callback);
+}
+
+/**
+ * @brief Ask to be told when data is available to be read from the stream.
+ *
+ * Streams whose data is written by another thread should override this
+ * function to call @p callback, from that thread, once data has been
+ * written or the end of the stream has been reached.  If data is available
+ * already, @p callback should be called before this function returns.
+ * @p callback must not be called while locks that the reading thread takes
+ * are held.
+ *
+ * This implementation does nothing and returns @c false.
+ *
+ * @param[in] callback  called once, when @c #data_available would return
+ *                      @c true.
+ *
+ * @return @c true if @p callback will be called; @c false otherwise.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+bool
+openvrml::resource_istream::
+do_notify_data_available(const boost::function0<void> &)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    return false;
+}
+
 
 /**
  * @class openvrml::resource_fetcher
@@ -726,6 +792,209 @@ openvrml::resource_fetcher::get_resource(const std::string & uri)
  */
 
 
+/**
+ * @class openvrml::file_resource_fetcher openvrml/browser.h
+ *
+ * @brief A @c resource_fetcher for local files.
+ *
+ * Only @c file URIs that refer to the local host are supported.  Files are
+ * memory-mapped rather than read; the parser consumes a mapped VRML or X3D
+ * world in place, without copying it.  The media type of a resource is
+ * inferred from the file name extension.
+ *
+ * An application that also needs to fetch network resources can delegate
+ * @c file URIs to a @c file_resource_fetcher from its own implementation of
+ * @c resource_fetcher::do_get_resource.
+ */
+
+/**
+ * @brief Destroy.
+ */
+openvrml::file_resource_fetcher::~file_resource_fetcher() OPENVRML_NOTHROW
+{}
+
+namespace {
+
+    //
+    // Decode the %-escaped octets in a URI path.
+    //
+    OPENVRML_LOCAL const std::string unescape(const std::string & str)
+    {
+        std::string result;
+        result.reserve(str.size());
+        for (std::string::size_type i = 0; i < str.size(); ++i) {
+            if (str[i] == '%' && i + 2 < str.size()
+                && std::isxdigit(static_cast<unsigned char>(str[i + 1]))
+                && std::isxdigit(static_cast<unsigned char>(str[i + 2]))) {
+                result += static_cast<char>(
+                    std::strtol(str.substr(i + 1, 2).c_str(), 0, 16));
+                i += 2;
+            } else {
+                result += str[i];
+            }
+        }
+        return result;
+    }
+}
+
+/**
+ * @brief Map a local file.
+ *
+ * If the file cannot be mapped, the returned stream is in a failed state.
+ *
+ * @param[in] uri   an absolute @c file URI.
+ *
+ * @return the file as a stream.
+ *
+ * @exception std::invalid_argument if @p uri is malformed, is not a @c file
+ *                                  URI, or refers to a remote host.
+ * @exception std::bad_alloc        if memory allocation fails.
+ */
+std::auto_ptr<openvrml::resource_istream>
+openvrml::file_resource_fetcher::do_get_resource(const std::string & uri)
+{
+    using std::invalid_argument;
+    using std::string;
+    using boost::algorithm::iequals;
+
+    local::uri id;
+    try {
+        id = local::uri(uri);
+    } catch (const invalid_url &) {
+        throw invalid_argument('\"' + uri + "\" is not a valid URI");
+    }
+    if (!iequals(id.scheme(), "file")) {
+        throw invalid_argument('\"' + id.scheme()
+                               + "\" URI scheme not supported");
+    }
+    const string host = id.host();
+    if (!(host.empty() || iequals(host, "localhost"))) {
+        throw invalid_argument("remote file URI \"" + uri
+                               + "\" not supported");
+    }
+    string path = unescape(id.path());
+# ifdef _WIN32
+    //
+    // file:///C:/path: drop the slash before the drive letter.
+    //
+    if (path.size() > 2 && path[0] == '/' && path[2] == ':') {
+        path.erase(0, 1);
+    }
+# endif
+    return std::auto_ptr<resource_istream>(
+        new local::mapped_file_istream(uri, path));
+}
+
+
+
+/**
+ * @class openvrml::resource_cache openvrml/browser.h
+ *
+ * @brief A caching @c resource_fetcher.
+ *
+ * A @c resource_cache sits in front of another @c resource_fetcher and keeps
+ * the bytes of the resources fetched through it, keyed by URI, up to a
+ * memory budget; least recently used resources are evicted first.
+ * Resources with identical content share storage, regardless of URI.
+ *
+ * Requests for a URI that is still being fetched do not start a second
+ * fetch; they read the data as the first fetch delivers it.  Streams from
+ * the cache are read in place by the VRML parser and by
+ * @c scene::read_stream.
+ *
+ * Resources that the underlying fetcher already provides in memory (such
+ * as files from a @c file_resource_fetcher) are not copied into the cache.
+ *
+ * A single @c resource_cache may be shared by several @c browser%s; it must
+ * outlive them, and the underlying @c resource_fetcher must outlive it.
+ */
+
+/**
+ * @var const std::size_t openvrml::resource_cache::default_budget
+ *
+ * @brief The default memory budget, in bytes.
+ */
+
+/**
+ * @brief Construct.
+ *
+ * @param[in] fetcher   the underlying @c resource_fetcher.
+ * @param[in] budget    the maximum number of bytes to keep cached.
+ */
+openvrml::resource_cache::resource_cache(resource_fetcher & fetcher,
+                                         const std::size_t budget):
+    impl_(new local::resource_cache_impl(fetcher, budget))
+{}
+
+/**
+ * @brief Destroy.
+ */
+openvrml::resource_cache::~resource_cache() OPENVRML_NOTHROW
+{}
+
+/**
+ * @brief The maximum number of bytes kept in the cache.
+ *
+ * @return the maximum number of bytes kept in the cache.
+ */
+std::size_t openvrml::resource_cache::budget() const OPENVRML_NOTHROW
+{
+    return this->impl_->budget();
+}
+
+/**
+ * @brief Set the maximum number of bytes kept in the cache.
+ *
+ * Least recently used resources are evicted to meet the new budget.
+ * Resources larger than the budget are never cached.
+ *
+ * @param[in] bytes the maximum number of bytes to keep in the cache.
+ */
+void openvrml::resource_cache::budget(const std::size_t bytes)
+    OPENVRML_NOTHROW
+{
+    this->impl_->budget(bytes);
+}
+
+/**
+ * @brief The number of bytes in the cache.
+ *
+ * @return the number of bytes in the cache.
+ */
+std::size_t openvrml::resource_cache::size() const OPENVRML_NOTHROW
+{
+    return this->impl_->size();
+}
+
+/**
+ * @brief Evict all cached resources.
+ *
+ * Streams already reading cached resources are unaffected.
+ */
+void openvrml::resource_cache::clear() OPENVRML_NOTHROW
+{
+    this->impl_->clear();
+}
+
+/**
+ * @brief Get a resource from the cache, or from the underlying
+ *        @c resource_fetcher.
+ *
+ * @param[in] uri   an absolute URI.
+ *
+ * @return the resource as a stream.
+ *
+ * @exception std::invalid_argument if the underlying @c resource_fetcher
+ *                                  does not support @p uri.
+ * @exception std::bad_alloc        if memory allocation fails.
+ */
+std::auto_ptr<openvrml::resource_istream>
+openvrml::resource_cache::do_get_resource(const std::string & uri)
+{
+    return this->impl_->get_resource(uri);
+}
+
+
 /**
  * @class openvrml::stream_listener openvrml/browser.h
  *
@@ -787,6 +1056,43 @@ data_available(const std::vector<unsigned char> & data)
  * @param[in] data  the data.
  */
 
+/**
+ * @brief Called when data is available.
+ *
+ * This function calls @c #do_data_available.  @p data is only valid for the
+ * duration of the call; the caller may reuse it afterward.
+ *
+ * @param[in] data  the data.
+ * @param[in] size  the number of bytes at @p data.
+ */
+void
+openvrml::stream_listener::data_available(const unsigned char * const data,
+                                          const std::size_t size)
+{
+    this->do_data_available(data, size);
+}
+
+/**
+ * @brief Called by @c #data_available.
+ *
+ * Unlike the overload taking a @c std::vector, this one does not require
+ * the caller to copy the data into a container of its own; @c scene reads
+ * streams through it.  The default implementation copies the data to a
+ * @c std::vector and calls <code>do_data_available(const
+ * std::vector<unsigned char> &)</code>; listeners that can consume the data
+ * in place should override it.
+ *
+ * @param[in] data  the data.
+ * @param[in] size  the number of bytes at @p data.
+ */
+void
+openvrml::stream_listener::do_data_available(const unsigned char * const data,
+                                             const std::size_t size)
+{
+    const std::vector<unsigned char> copy(data, data + size);
+    this->do_data_available(copy);
+}
+
 /**
  * @class openvrml::invalid_vrml openvrml/browser.h
  *
@@ -1083,6 +1389,12 @@ openvrml::node_metatype_registry::register_node_metatype(
  * Basic example using @c openvrml::browser.
  */
 
+/**
+ * @var class openvrml::browser::node
+ *
+ * @brief @c node::modified(bool) increments @c #modification_epoch_.
+ */
+
 /**
  * @var class openvrml::browser::scene
  *
@@ -1145,11 +1457,28 @@ openvrml::node_metatype_registry::register_node_metatype(
 /**
  * @internal
  *
- * @var boost::thread_group openvrml::browser::load_proto_thread_group_
+ * @var boost::scoped_ptr<openvrml::local::io_executor> openvrml::browser::io_executor_
+ *
+ * @brief The threads that read streams and load Inline scenes,
+ *        @c EXTERNPROTO implementations, and @c createVrmlFromURL requests.
+ *
+ * Queued jobs are cancelled and running ones waited for when the world is
+ * replaced and before the @c browser is destroyed.
+ *
+ * @see #io_threads
+ */
+
+/**
+ * @internal
+ *
+ * @var boost::scoped_ptr<openvrml::local::compute_executor> openvrml::browser::compute_executor_
  *
- * @brief The threads that load @c EXTERNPROTO implementations.
+ * @brief The threads that help compile meshes and generate normals.
  *
- * These threads @b must be joined by the @c browser before it is destroyed.
+ * They are shared by @c #set_world and @c #render, so that work done on
+ * several threads at once does not start more threads than there are
+ * processors.  They are started once for the @c browser, and joined when it
+ * is destroyed.
  */
 
 /**
@@ -1299,6 +1628,62 @@ openvrml::node_metatype_registry::register_node_metatype(
  * @brief A list of all the TimeSensor @c node%s in the @c browser.
  */
 
+/**
+ * @internal
+ *
+ * @var boost::shared_mutex openvrml::browser::time_dependent_islands_mutex_
+ *
+ * @brief Mutex protecting @c #time_dependent_islands_.
+ */
+
+/**
+ * @internal
+ *
+ * @var boost::scoped_ptr<openvrml::local::time_dependent_islands> openvrml::browser::time_dependent_islands_
+ *
+ * @brief Updates the time-dependent @c node%s concurrently; null if they are
+ *        updated serially.
+ *
+ * @see #update_threads
+ */
+
+/**
+ * @internal
+ *
+ * @var boost::shared_mutex openvrml::browser::parse_threads_mutex_
+ *
+ * @brief Mutex protecting @c #parse_threads_.
+ */
+
+/**
+ * @internal
+ *
+ * @var std::size_t openvrml::browser::parse_threads_
+ *
+ * @brief The number of threads used to parse VRML97 streams.
+ *
+ * @see #parse_threads
+ */
+
+/**
+ * @internal
+ *
+ * @var boost::shared_mutex openvrml::browser::mesh_compile_threads_mutex_
+ *
+ * @brief Mutex protecting @c #mesh_compile_threads_.
+ */
+
+/**
+ * @internal
+ *
+ * @var std::size_t openvrml::browser::mesh_compile_threads_
+ *
+ * @brief The number of threads used to compile meshes when a world is
+ *        loaded.
+ *
+ * @see #mesh_compile_threads
+ */
+
 /**
  * @internal
  *
@@ -1335,6 +1720,31 @@ openvrml::node_metatype_registry::register_node_metatype(
  * @brief Mutex protecting @c #modified_.
  */
 
+/**
+ * @internal
+ *
+ * @var boost::detail::atomic_count openvrml::browser::modification_epoch_
+ *
+ * @brief Incremented each time a @c node in the @c browser is marked
+ *        modified.
+ *
+ * @c node::modified(bool) increments this counter instead of locking
+ * @c #modified_mutex_.  @c node::modified() uses it to tell whether any
+ * @c node changed while it was checking a subtree, in which case it does not
+ * record the subtree as unmodified.
+ */
+
+/**
+ * @internal
+ *
+ * @var long openvrml::browser::rendered_epoch_
+ *
+ * @brief The value of @c #modification_epoch_ when the @c browser was last
+ *        marked unmodified.
+ *
+ * Guarded by @c #modified_mutex_.
+ */
+
 /**
  * @internal
  *
@@ -1473,6 +1883,12 @@ openvrml::browser::browser(resource_fetcher & fetcher,
     node_metatype_registry_(new node_metatype_registry(*this)),
     null_node_metatype_(new null_node_metatype(*this)),
     null_node_type_(new null_node_type(*null_node_metatype_)),
+    compiled_meshes_(new compiled_mesh_cache),
+    io_executor_(
+        new local::io_executor(local::io_executor::default_threads())),
+    compute_executor_(
+        new local::compute_executor(
+            local::compute_executor::default_threads())),
     script_node_metatype_(*this),
     fetcher_(fetcher),
     scene_(new scene(*this)),
@@ -1481,10 +1897,16 @@ openvrml::browser::browser(resource_fetcher & fetcher,
     default_navigation_info_(new default_navigation_info(*null_node_type_)),
     active_navigation_info_(
         node_cast<navigation_info_node *>(default_navigation_info_.get())),
+    parse_threads_(0),
+    mesh_compile_threads_(
+        (std::max)(std::size_t(boost::thread::hardware_concurrency()),
+                   std::size_t(1))),
     new_view(false),
     delta_time(DEFAULT_DELTA),
     viewer_(0),
     modified_(false),
+    modification_epoch_(0),
+    rendered_epoch_(0),
     frame_rate_(0.0),
     out_(&out),
     err_(&err),
@@ -1507,7 +1929,7 @@ openvrml::browser::~browser() OPENVRML_NOTHROW
         this->load_root_scene_thread_->join();
     }
 
-    this->load_proto_thread_group_.join_all();
+    this->io_executor_->cancel_all();
 
     const double now = browser::current_time();
 
@@ -1517,6 +1939,12 @@ openvrml::browser::~browser() OPENVRML_NOTHROW
     shared_lock<shared_mutex>
         node_metatype_registry_lock(this->node_metatype_registry_mutex_);
     this->node_metatype_registry_->impl_->shutdown(now);
+
+    //
+    // Geometry nodes that outlive the browser find the cache gone; see
+    // geometry_node::~geometry_node.
+    //
+    this->compiled_meshes_->clear();
     assert(this->viewpoint_list_.empty());
     assert(this->scoped_lights_.empty());
     assert(this->scripts_.empty());
@@ -1847,6 +2275,20 @@ openvrml::viewer * openvrml::browser::viewer() const OPENVRML_NOTHROW
     return this->viewer_;
 }
 
+/**
+ * @brief The meshes compiled for the geometry nodes in the browser.
+ *
+ * Viewers that draw triangles can take the meshes from here rather than
+ * tessellating the geometry themselves.
+ *
+ * @return the @c compiled_mesh_cache.
+ */
+openvrml::compiled_mesh_cache & openvrml::browser::compiled_meshes() const
+    OPENVRML_NOTHROW
+{
+    return *this->compiled_meshes_;
+}
+
 /**
  * @brief Get the browser name.
  *
@@ -1906,7 +2348,8 @@ const std::string openvrml::browser::world_url() const
  * @param[in,out] in    an input stream.
  *
  * @exception bad_media_type    if @p in.type() is not @c model/vrml,
- *                              @c x-world/x-vrml, or @c model/x3d-vrml.
+ *                              @c x-world/x-vrml, @c model/x3d-vrml, or
+ *                              @c model/x3d+binary.
  * @exception invalid_vrml      if @p in has invalid syntax.
  */
 void openvrml::browser::set_world(resource_istream & in)
@@ -1936,14 +2379,19 @@ void openvrml::browser::set_world(resource_istream & in)
         using boost::upgrade_to_unique_lock;
         using local::uri;
 
+        //
+        // Clear out the current scene.  Anything still waiting to be loaded
+        // for it is abandoned.  Loads that are running are waited for, so
+        // this is done before the scene is locked: a load may need the lock
+        // to finish.  Anything queued after this is waited for when the
+        // scene is destroyed.
+        //
+        this->io_executor_->cancel_all();
+
         upgrade_lock<shared_mutex>
             scene_lock(this->scene_mutex_),
             node_metatype_registry_lock(this->node_metatype_registry_mutex_);
 
-        //
-        // Clear out the current scene.
-        //
-        this->load_proto_thread_group_.join_all();
         double now = browser::current_time();
         if (this->scene_) { this->scene_->shutdown(now); }
         this->node_metatype_registry_->impl_->shutdown(now);
@@ -2001,6 +2449,19 @@ void openvrml::browser::set_world(resource_istream & in)
         //
         this->node_metatype_registry_->impl_->init(initial_viewpoint, now);
 
+        //
+        // Compile the meshes for the new scene's geometry, so that the first
+        // frame need only load them.  The scene may be rendered meanwhile;
+        // geometry_node::render_geometry and the compiler take turns on
+        // each node.
+        //
+        const std::size_t mesh_compile_threads = this->mesh_compile_threads();
+        if (mesh_compile_threads > 0) {
+            local::mesh_compiler compiler(*this->compiled_meshes_,
+                                          this->scene_->nodes());
+            compiler.run(*this->compute_executor_, mesh_compile_threads);
+        }
+
         if (!this->active_viewpoint_) {
             using boost::unique_lock;
             unique_lock<shared_mutex> lock(this->active_viewpoint_mutex_);
@@ -2026,6 +2487,12 @@ openvrml::browser::replace_world(
     shared_lock<shared_mutex>
         scene_lock(this->scene_mutex_),
         node_metatype_registry_lock(this->node_metatype_registry_mutex_);
+    //
+    // Streams and Inline scenes queued for the old nodes are no longer
+    // needed.  EXTERNPROTO loads are kept, since the new nodes may be
+    // instances of those types.
+    //
+    this->io_executor_->cancel_node_jobs();
     const double now = browser::current_time();
     this->scene_->nodes(nodes);
     this->scene_->initialize(now);
@@ -2318,6 +2785,15 @@ void openvrml::browser::sensitive_event(node * const n,
  *
  * This method should be called after each frame is rendered.
  *
+ * Events emitted while updating the time-dependent nodes and scripts are
+ * queued and delivered breadth-first once each set of nodes has been
+ * updated; see @c local::event_cascade.
+ *
+ * If @c #update_threads is nonzero, groups of time-dependent nodes that are
+ * not connected to each other by routes are updated concurrently; see
+ * @c local::time_dependent_islands.  All of them have been updated, and
+ * their events delivered, before the scripts are updated.
+ *
  * @return @c true if the @c browser needs to be rerendered, @c false otherwise.
  */
 bool openvrml::browser::update(double current_time)
@@ -2334,12 +2810,26 @@ bool openvrml::browser::update(double current_time)
 
     this->delta_time = DEFAULT_DELTA;
 
+    local::event_cascade cascade;
+    local::event_cascade::scope cascade_scope(cascade);
+
     //
     // Update each of the timers.
     //
-    for_each(this->timers_.begin(), this->timers_.end(),
-             boost::bind2nd(boost::mem_fun(&time_dependent_node::update),
-                            current_time));
+    {
+        shared_lock<shared_mutex>
+            islands_lock(this->time_dependent_islands_mutex_);
+        if (this->time_dependent_islands_) {
+            this->time_dependent_islands_->update(this->timers_,
+                                                  current_time);
+        } else {
+            for_each(this->timers_.begin(), this->timers_.end(),
+                     boost::bind2nd(
+                         boost::mem_fun(&time_dependent_node::update),
+                         current_time));
+        }
+    }
+    cascade.drain();
 
     //
     // Update each of the scripts.
@@ -2347,11 +2837,180 @@ bool openvrml::browser::update(double current_time)
     for_each(this->scripts_.begin(), this->scripts_.end(),
              boost::bind2nd(boost::mem_fun(&script_node::update),
                             current_time));
+    cascade.drain();
 
     // Signal a redisplay if necessary
     return this->modified();
 }
 
+/**
+ * @brief Set the number of threads used to update time-dependent
+ *        @c node%s.
+ *
+ * When @p threads is 0 (the default), @c #update updates the time-dependent
+ * @c node%s serially, in the order they were added.  Otherwise, the
+ * time-dependent @c node%s are partitioned into islands that are not
+ * connected to each other by routes, and the islands are updated by
+ * @p threads threads (including the thread calling @c #update).  Islands
+ * that include a @c script_node, a @c PROTO instance, or a bindable @c node
+ * are always updated on the thread calling @c #update.
+ *
+ * @param[in] threads   the number of threads used to update time-dependent
+ *                      @c node%s, or 0 to update them serially.
+ *
+ * @exception std::bad_alloc                if memory allocation fails.
+ * @exception boost::thread_resource_error  if a worker thread cannot be
+ *                                          started.
+ */
+void openvrml::browser::update_threads(const std::size_t threads)
+    OPENVRML_THROW2(std::bad_alloc, boost::thread_resource_error)
+{
+    using boost::unique_lock;
+    using boost::shared_mutex;
+    using boost::scoped_ptr;
+
+    scoped_ptr<local::time_dependent_islands> islands(
+        (threads > 0) ? new local::time_dependent_islands(threads) : 0);
+
+    unique_lock<shared_mutex> lock(this->time_dependent_islands_mutex_);
+    this->time_dependent_islands_.swap(islands);
+}
+
+/**
+ * @brief The number of threads used to update time-dependent @c node%s.
+ *
+ * @return the number of threads used to update time-dependent @c node%s, or
+ *         0 if they are updated serially.
+ *
+ * @see #update_threads(std::size_t)
+ */
+std::size_t openvrml::browser::update_threads() const OPENVRML_NOTHROW
+{
+    using boost::shared_lock;
+    using boost::shared_mutex;
+    shared_lock<shared_mutex> lock(this->time_dependent_islands_mutex_);
+    return this->time_dependent_islands_
+        ? this->time_dependent_islands_->threads()
+        : 0;
+}
+
+/**
+ * @brief Set the number of threads used to parse VRML97 streams.
+ *
+ * When @p threads is 0 or 1 (the default), streams are parsed serially.
+ * Otherwise, large VRML97 streams are split between top-level statements
+ * and the pieces are parsed by @p threads threads (including the calling
+ * thread).  Pieces that use <code>DEF</code>, <code>USE</code>,
+ * <code>ROUTE</code>, or Script nodes are parsed on the calling thread
+ * once the others are done; a stream that declares PROTOs or
+ * EXTERNPROTOs is always parsed serially.
+ *
+ * @param[in] threads   the number of threads used to parse VRML97 streams.
+ */
+void openvrml::browser::parse_threads(const std::size_t threads)
+    OPENVRML_NOTHROW
+{
+    using boost::unique_lock;
+    using boost::shared_mutex;
+    unique_lock<shared_mutex> lock(this->parse_threads_mutex_);
+    this->parse_threads_ = threads;
+}
+
+/**
+ * @brief The number of threads used to parse VRML97 streams.
+ *
+ * @return the number of threads used to parse VRML97 streams.
+ *
+ * @see #parse_threads(std::size_t)
+ */
+std::size_t openvrml::browser::parse_threads() const OPENVRML_NOTHROW
+{
+    using boost::shared_lock;
+    using boost::shared_mutex;
+    shared_lock<shared_mutex> lock(this->parse_threads_mutex_);
+    return this->parse_threads_;
+}
+
+/**
+ * @brief Set the maximum number of threads used to load resources.
+ *
+ * Stream reads (such as texture downloads), Inline scenes,
+ * @c EXTERNPROTO implementations, and @c createVrmlFromURL requests are
+ * queued and run on at most @p threads threads, nearest content first.
+ * The default is the larger of 8 and twice the number of hardware threads.
+ *
+ * A @c resource_fetcher whose streams are all fed by a single producer
+ * that blocks when a stream's buffer is full needs enough threads for the
+ * streams it may have open at once.
+ *
+ * @param[in] threads   the maximum number of threads used to load
+ *                      resources; 0 is treated as 1.
+ */
+void openvrml::browser::io_threads(const std::size_t threads)
+    OPENVRML_NOTHROW
+{
+    this->io_executor_->threads((std::max)(threads, std::size_t(1)));
+}
+
+/**
+ * @brief The maximum number of threads used to load resources.
+ *
+ * @return the maximum number of threads used to load resources.
+ *
+ * @see #io_threads(std::size_t)
+ */
+std::size_t openvrml::browser::io_threads() const OPENVRML_NOTHROW
+{
+    return this->io_executor_->threads();
+}
+
+/**
+ * @brief Set the number of threads used to compile meshes when a world is
+ *        loaded.
+ *
+ * Once @c #set_world has loaded and initialized a world, the meshes for its
+ * geometry @c node%s are compiled into @c #compiled_meshes by up to
+ * @p threads threads (including the calling thread); the others are taken
+ * from the threads the @c browser keeps for such work, of which there is
+ * one fewer than the number of hardware threads.  The @c viewer then finds
+ * each mesh ready to be loaded when the @c node is first drawn; a @c node
+ * drawn while the meshes are being compiled is compiled by whichever gets to
+ * it first.  When @p threads is 0, the meshes are compiled by
+ * the @c viewer as the @c node%s are first drawn.  The default is the number
+ * of hardware threads.
+ *
+ * Geometry @c node%s added to the world afterward (for instance, by an
+ * @c Inline) are compiled by the @c viewer.
+ *
+ * @param[in] threads   the number of threads used to compile meshes, or 0
+ *                      to leave them to the @c viewer.
+ */
+void openvrml::browser::mesh_compile_threads(const std::size_t threads)
+    OPENVRML_NOTHROW
+{
+    using boost::unique_lock;
+    using boost::shared_mutex;
+    unique_lock<shared_mutex> lock(this->mesh_compile_threads_mutex_);
+    this->mesh_compile_threads_ = threads;
+}
+
+/**
+ * @brief The number of threads used to compile meshes when a world is
+ *        loaded.
+ *
+ * @return the number of threads used to compile meshes when a world is
+ *         loaded, or 0 if they are compiled by the @c viewer.
+ *
+ * @see #mesh_compile_threads(std::size_t)
+ */
+std::size_t openvrml::browser::mesh_compile_threads() const OPENVRML_NOTHROW
+{
+    using boost::shared_lock;
+    using boost::shared_mutex;
+    shared_lock<shared_mutex> lock(this->mesh_compile_threads_mutex_);
+    return this->mesh_compile_threads_;
+}
+
 /**
  * @brief Indicate whether the headlight is on.
  *
@@ -2378,6 +3037,15 @@ void openvrml::browser::render()
 
     if (!this->viewer_) { return; }
 
+    //
+    // Normals generated for large meshes while drawing are shared among the
+    // compute threads.
+    //
+    const local::compute_executor::scope
+        compute_scope(*this->compute_executor_);
+
+    this->viewer_->state_changes_ = 0;
+
     if (this->new_view) {
         this->viewer_->reset_user_navigation();
         this->new_view = false;
@@ -2446,8 +3114,19 @@ void openvrml::browser::render()
     //
     // Render the nodes.  scene_ may be 0 if the world failed to load.
     //
+    // When drawing, the geometry is queued as the scene is traversed and
+    // drawn afterward sorted by rendering state.  Picking is left in
+    // traversal order, since the viewer associates what is drawn with the
+    // last set_sensitive call.
+    //
     if (this->scene_) {
-        this->scene_->render(*this->viewer_, rc);
+        if (this->viewer_->mode() == viewer::draw_mode) {
+            local::render_queue queue(*this->viewer_, modelview);
+            this->scene_->render(queue, rc);
+            queue.submit();
+        } else {
+            this->scene_->render(*this->viewer_, rc);
+        }
     }
 
     this->viewer_->end_object();
@@ -2472,11 +3151,16 @@ void openvrml::browser::modified(const bool value)
     using boost::shared_mutex;
     unique_lock<shared_mutex> lock(this->modified_mutex_);
     this->modified_ = value;
+    if (!value) { this->rendered_epoch_ = this->modification_epoch_; }
 }
 
 /**
  * @brief Check if the browser has been modified.
  *
+ * The @c browser is modified if @c #modified(bool) was last called with
+ * @c true, or if a @c node in the @c browser has been marked modified since
+ * @c #modified(bool) was last called with @c false.
+ *
  * @return @c true if the browser has been modified, @c false otherwise.
  */
 bool openvrml::browser::modified() const
@@ -2484,7 +3168,8 @@ bool openvrml::browser::modified() const
     using boost::shared_lock;
     using boost::shared_mutex;
     shared_lock<shared_mutex> lock(this->modified_mutex_);
-    return this->modified_;
+    return this->modified_
+        || this->rendered_epoch_ != this->modification_epoch_;
 }
 
 /**
@@ -2606,6 +3291,7 @@ void openvrml::browser::add_time_dependent(time_dependent_node & n)
     assert(std::find(this->timers_.begin(), this->timers_.end(), &n)
            == this->timers_.end());
     this->timers_.push_back(&n);
+    local::time_dependent_islands::invalidate();
 }
 
 /**
@@ -2627,6 +3313,7 @@ openvrml::browser::remove_time_dependent(time_dependent_node & n)
             std::find(this->timers_.begin(), end, &n);
     assert(pos != end);
     this->timers_.erase(pos);
+    local::time_dependent_islands::invalidate();
 }
 
 /**
@@ -2654,7 +3341,7 @@ void openvrml::browser::update_flags()
  */
 void openvrml::browser::out(const std::string & str) const
 {
-    boost::mutex::scoped_lock(this->out_mutex_);
+    boost::mutex::scoped_lock lock(this->out_mutex_);
     *this->out_ << str << std::endl;
 }
 
@@ -2665,6 +3352,6 @@ void openvrml::browser::out(const std::string & str) const
  */
 void openvrml::browser::err(const std::string & str) const
 {
-    boost::mutex::scoped_lock(this->err_mutex_);
+    boost::mutex::scoped_lock lock(this->err_mutex_);
     *this->err_ << str << std::endl;
 }
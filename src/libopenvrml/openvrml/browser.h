@@ -23,12 +23,14 @@
 #   define OPENVRML_BROWSER_H
 
 #   include <openvrml/script.h>
+#   include <boost/function.hpp>
 
 namespace openvrml {
 
     OPENVRML_API extern const char vrml_media_type[11];
     OPENVRML_API extern const char x_vrml_media_type[15];
     OPENVRML_API extern const char x3d_vrml_media_type[15];
+    OPENVRML_API extern const char x3d_binary_media_type[17];
 
     OPENVRML_API
     std::auto_ptr<node_type_decls> profile(const std::string & profile_id)
@@ -46,6 +48,8 @@ namespace openvrml {
         const std::string url() const OPENVRML_THROW1(std::bad_alloc);
         const std::string type() const OPENVRML_THROW1(std::bad_alloc);
         bool data_available() const OPENVRML_NOTHROW;
+        bool notify_data_available(const boost::function0<void> & callback)
+            OPENVRML_THROW1(std::bad_alloc);
 
     protected:
         explicit resource_istream(std::streambuf * streambuf);
@@ -56,6 +60,9 @@ namespace openvrml {
         virtual const std::string do_type() const
             OPENVRML_THROW1(std::bad_alloc) = 0;
         virtual bool do_data_available() const OPENVRML_NOTHROW = 0;
+        virtual bool
+        do_notify_data_available(const boost::function0<void> & callback)
+            OPENVRML_THROW1(std::bad_alloc);
     };
 
 
@@ -71,6 +78,41 @@ namespace openvrml {
     };
 
 
+    class OPENVRML_API file_resource_fetcher : public resource_fetcher {
+    public:
+        virtual ~file_resource_fetcher() OPENVRML_NOTHROW;
+
+    private:
+        virtual std::auto_ptr<resource_istream>
+        do_get_resource(const std::string & uri);
+    };
+
+
+    namespace local {
+        class resource_cache_impl;
+    }
+
+    class OPENVRML_API resource_cache : public resource_fetcher {
+        boost::scoped_ptr<local::resource_cache_impl> impl_;
+
+    public:
+        static const std::size_t default_budget = 256 * 1024 * 1024;
+
+        explicit resource_cache(resource_fetcher & fetcher,
+                                std::size_t budget = default_budget);
+        virtual ~resource_cache() OPENVRML_NOTHROW;
+
+        std::size_t budget() const OPENVRML_NOTHROW;
+        void budget(std::size_t bytes) OPENVRML_NOTHROW;
+        std::size_t size() const OPENVRML_NOTHROW;
+        void clear() OPENVRML_NOTHROW;
+
+    private:
+        virtual std::auto_ptr<resource_istream>
+        do_get_resource(const std::string & uri);
+    };
+
+
     class OPENVRML_API stream_listener {
     public:
         virtual ~stream_listener() OPENVRML_NOTHROW = 0;
@@ -78,6 +120,7 @@ namespace openvrml {
         void stream_available(const std::string & uri,
                               const std::string & media_type);
         void data_available(const std::vector<unsigned char> & data);
+        void data_available(const unsigned char * data, std::size_t size);
 
     private:
         virtual void
@@ -85,6 +128,8 @@ namespace openvrml {
                             const std::string & media_type) = 0;
         virtual void
         do_data_available(const std::vector<unsigned char> & data) = 0;
+        virtual void
+        do_data_available(const unsigned char * data, std::size_t size);
     };
 
 
@@ -175,6 +220,7 @@ namespace openvrml {
 
     class viewer;
     class scene;
+    class compiled_mesh_cache;
 
     namespace local {
         struct vrml97_parse_actions;
@@ -190,9 +236,14 @@ namespace openvrml {
         class externproto_node;
         class externproto_node_type;
         class externproto_node_metatype;
+        class time_dependent_islands;
+        class io_executor;
+        class compute_executor;
     }
 
     class OPENVRML_API browser : boost::noncopyable {
+        friend class node;
+        friend class geometry_node;
         friend class scene;
         friend class script_node;
         friend bool OPENVRML_API operator==(const node_type &,
@@ -221,10 +272,13 @@ namespace openvrml {
         const boost::scoped_ptr<null_node_metatype> null_node_metatype_;
         const boost::scoped_ptr<null_node_type> null_node_type_;
 
+        const boost::shared_ptr<compiled_mesh_cache> compiled_meshes_;
+
         boost::shared_mutex load_root_scene_thread_mutex_;
         boost::scoped_ptr<boost::thread> load_root_scene_thread_;
 
-        boost::thread_group load_proto_thread_group_;
+        boost::scoped_ptr<local::io_executor> io_executor_;
+        boost::scoped_ptr<local::compute_executor> compute_executor_;
         script_node_metatype script_node_metatype_;
         resource_fetcher & fetcher_;
 
@@ -254,6 +308,16 @@ namespace openvrml {
         boost::shared_mutex timers_mutex_;
         std::list<time_dependent_node *> timers_;
 
+        mutable boost::shared_mutex time_dependent_islands_mutex_;
+        boost::scoped_ptr<local::time_dependent_islands>
+            time_dependent_islands_;
+
+        mutable boost::shared_mutex parse_threads_mutex_;
+        std::size_t parse_threads_;
+
+        mutable boost::shared_mutex mesh_compile_threads_mutex_;
+        std::size_t mesh_compile_threads_;
+
         boost::shared_mutex listeners_mutex_;
         std::set<browser_listener *> listeners_;
 
@@ -267,6 +331,8 @@ namespace openvrml {
 
         bool modified_;
         mutable boost::shared_mutex modified_mutex_;
+        boost::detail::atomic_count modification_epoch_;
+        long rendered_epoch_;
 
         mutable boost::shared_mutex frame_rate_mutex_;
         double frame_rate_;
@@ -312,6 +378,7 @@ namespace openvrml {
         const std::list<viewpoint_node *> viewpoints() const OPENVRML_NOTHROW;
         void viewer(openvrml::viewer * v) OPENVRML_THROW1(viewer_in_use);
         openvrml::viewer * viewer() const OPENVRML_NOTHROW;
+        compiled_mesh_cache & compiled_meshes() const OPENVRML_NOTHROW;
 
         virtual const char * name() const OPENVRML_NOTHROW;
         virtual const char * version() const OPENVRML_NOTHROW;
@@ -343,6 +410,15 @@ namespace openvrml {
         double frame_rate() const;
 
         bool update(double current_time = -1.0);
+        void update_threads(std::size_t threads)
+            OPENVRML_THROW2(std::bad_alloc, boost::thread_resource_error);
+        std::size_t update_threads() const OPENVRML_NOTHROW;
+        void parse_threads(std::size_t threads) OPENVRML_NOTHROW;
+        std::size_t parse_threads() const OPENVRML_NOTHROW;
+        void io_threads(std::size_t threads) OPENVRML_NOTHROW;
+        std::size_t io_threads() const OPENVRML_NOTHROW;
+        void mesh_compile_threads(std::size_t threads) OPENVRML_NOTHROW;
+        std::size_t mesh_compile_threads() const OPENVRML_NOTHROW;
 
         void render();
 
@@ -0,0 +1,1254 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# include "compiled_mesh.h"
+# include "mesh.h"
+# include "viewer.h"
+# include <openvrml/local/float.h>
+# include <algorithm>
+# include <cassert>
+# include <cmath>
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+/**
+ * @file openvrml/compiled_mesh.h
+ *
+ * @brief Renderer-independent triangle meshes for geometry nodes.
+ */
+
+/**
+ * @class openvrml::compiled_mesh openvrml/compiled_mesh.h
+ *
+ * @brief The geometry of a geometry node as indexed triangles.
+ *
+ * Each vertex has a coordinate; @c #normal, @c #tex_coord, and @c #color
+ * are either empty or have an element for each vertex.  The vertices of
+ * triangle @c i are given by <code>triangle_index[3 * i]</code> through
+ * <code>triangle_index[3 * i + 2]</code>.
+ *
+ * Faces that are shared by vertices with different attributes (e.g., the
+ * faces of a box, or those of an @c IndexedFaceSet with per-face colors)
+ * get vertices of their own; so a renderer never needs flat shading to draw
+ * a @c compiled_mesh.
+ *
+ * @sa openvrml::compiled_mesh_cache
+ */
+
+/**
+ * @var std::vector<openvrml::vec3f> openvrml::compiled_mesh::coord
+ *
+ * @brief Vertex coordinates.
+ */
+
+/**
+ * @var std::vector<openvrml::vec3f> openvrml::compiled_mesh::normal
+ *
+ * @brief Vertex normals.
+ */
+
+/**
+ * @var std::vector<openvrml::vec2f> openvrml::compiled_mesh::tex_coord
+ *
+ * @brief Vertex texture coordinates.
+ */
+
+/**
+ * @var std::vector<openvrml::color> openvrml::compiled_mesh::color
+ *
+ * @brief Vertex colors.
+ */
+
+/**
+ * @var std::vector<openvrml::int32> openvrml::compiled_mesh::triangle_index
+ *
+ * @brief Vertex indices of the triangles, three to a triangle.
+ */
+
+/**
+ * @var bool openvrml::compiled_mesh::ccw
+ *
+ * @brief Whether the front faces of the triangles are those whose vertices
+ *        are counterclockwise.
+ */
+
+/**
+ * @var bool openvrml::compiled_mesh::solid
+ *
+ * @brief Whether back faces may be culled.
+ */
+
+/**
+ * @brief Construct an empty mesh.
+ */
+openvrml::compiled_mesh::compiled_mesh() OPENVRML_NOTHROW:
+    ccw(true),
+    solid(true)
+{}
+
+/**
+ * @brief Whether the mesh has no triangles.
+ *
+ * @return @c true if the mesh has no triangles; @c false otherwise.
+ */
+bool openvrml::compiled_mesh::empty() const OPENVRML_NOTHROW
+{
+    return this->triangle_index.empty();
+}
+
+/**
+ * @brief Remove the vertices and triangles.
+ *
+ * @c #ccw and @c #solid are reset to @c true.
+ */
+void openvrml::compiled_mesh::clear() OPENVRML_NOTHROW
+{
+    this->coord.clear();
+    this->normal.clear();
+    this->tex_coord.clear();
+    this->color.clear();
+    this->triangle_index.clear();
+    this->ccw = true;
+    this->solid = true;
+}
+
+namespace {
+
+    /**
+     * @internal
+     *
+     * @brief Append a vertex with a normal and a texture coordinate.
+     *
+     * @param[in,out] mesh      a mesh.
+     * @param[in] coord         coordinate.
+     * @param[in] normal        normal.
+     * @param[in] tex_coord     texture coordinate.
+     *
+     * @return the index of the new vertex.
+     *
+     * @exception std::bad_alloc    if memory allocation fails.
+     */
+    OPENVRML_LOCAL openvrml::int32
+    add_vertex(openvrml::compiled_mesh & mesh,
+               const openvrml::vec3f & coord,
+               const openvrml::vec3f & normal,
+               const openvrml::vec2f & tex_coord)
+        OPENVRML_THROW1(std::bad_alloc)
+    {
+        mesh.coord.push_back(coord);
+        mesh.normal.push_back(normal);
+        mesh.tex_coord.push_back(tex_coord);
+        return openvrml::int32(mesh.coord.size() - 1);
+    }
+
+    OPENVRML_LOCAL void add_triangle(openvrml::compiled_mesh & mesh,
+                                     const openvrml::int32 v0,
+                                     const openvrml::int32 v1,
+                                     const openvrml::int32 v2)
+        OPENVRML_THROW1(std::bad_alloc)
+    {
+        mesh.triangle_index.push_back(v0);
+        mesh.triangle_index.push_back(v1);
+        mesh.triangle_index.push_back(v2);
+    }
+
+    /**
+     * @internal
+     *
+     * @brief Triangulate the vertices from @p first to the end of the mesh
+     *        as a quadrilateral strip.
+     *
+     * The vertices are taken in the order of @c GL_QUAD_STRIP.
+     *
+     * @param[in,out] mesh  a mesh.
+     * @param[in] first     the first vertex of the strip.
+     *
+     * @exception std::bad_alloc    if memory allocation fails.
+     */
+    OPENVRML_LOCAL void add_quad_strip(openvrml::compiled_mesh & mesh,
+                                       const openvrml::int32 first)
+        OPENVRML_THROW1(std::bad_alloc)
+    {
+        using openvrml::int32;
+        const int32 end = int32(mesh.coord.size());
+        for (int32 v = first; v + 3 < end; v += 2) {
+            add_triangle(mesh, v, v + 1, v + 3);
+            add_triangle(mesh, v, v + 3, v + 2);
+        }
+    }
+
+    /**
+     * @internal
+     *
+     * @brief Triangulate the vertices from @p first to the end of the mesh
+     *        as a triangle fan.
+     *
+     * @param[in,out] mesh  a mesh.
+     * @param[in] first     the center of the fan.
+     *
+     * @exception std::bad_alloc    if memory allocation fails.
+     */
+    OPENVRML_LOCAL void add_triangle_fan(openvrml::compiled_mesh & mesh,
+                                         const openvrml::int32 first)
+        OPENVRML_THROW1(std::bad_alloc)
+    {
+        using openvrml::int32;
+        const int32 end = int32(mesh.coord.size());
+        for (int32 v = first + 1; v + 1 < end; ++v) {
+            add_triangle(mesh, first, v, v + 1);
+        }
+    }
+
+    /**
+     * @internal
+     *
+     * @brief Compute the rims of a cylinder.
+     *
+     * The top rim is at <code>coord[0]</code> through
+     * <code>coord[facets - 1]</code>; the bottom rim follows it.
+     *
+     * @param[in] height        the height of the cylinder.
+     * @param[in] radius        the radius of the cylinder.
+     * @param[in] facets        the number of facets for the side.
+     * @param[out] coord        the coordinates.
+     * @param[out] tex_coord    the texture coordinates for the side.
+     *
+     * @exception std::bad_alloc    if memory allocation fails.
+     */
+    OPENVRML_LOCAL void
+    cylinder_rims(const float height,
+                  const float radius,
+                  const std::size_t facets,
+                  std::vector<openvrml::vec3f> & coord,
+                  std::vector<openvrml::vec2f> & tex_coord)
+        OPENVRML_THROW1(std::bad_alloc)
+    {
+        using openvrml::make_vec2f;
+        using openvrml::make_vec3f;
+        using openvrml::local::pi;
+
+        coord.resize(2 * facets);
+        tex_coord.resize(2 * facets);
+        for (std::size_t i = 0; i < facets; ++i) {
+            const double angle = i * 2 * pi / facets;
+            const float x = float(radius * std::cos(angle));
+            const float z = float(radius * std::sin(angle));
+            const float u = float(0.75 - float(i) / facets);
+            coord[i] = make_vec3f(x, 0.5f * height, z);
+            coord[facets + i] = make_vec3f(x, -0.5f * height, z);
+            tex_coord[i] = make_vec2f(u, 1.0f);
+            tex_coord[facets + i] = make_vec2f(u, 0.0f);
+        }
+    }
+
+    /**
+     * @internal
+     *
+     * @brief Add the side of a cylinder or a cone.
+     *
+     * The normal at each vertex is
+     * <code>(x * normal_scale, normal_y, z * normal_scale)</code> (where
+     * @c x and @c z are those of the bottom rim), normalized.
+     *
+     * @param[in,out] mesh      a mesh.
+     * @param[in] coord         the rims computed by @c cylinder_rims.
+     * @param[in] tex_coord     the texture coordinates computed by
+     *                          @c cylinder_rims.
+     * @param[in] normal_scale  scale of the horizontal part of the normals.
+     * @param[in] normal_y      vertical part of the normals.
+     *
+     * @exception std::bad_alloc    if memory allocation fails.
+     */
+    OPENVRML_LOCAL void
+    add_side(openvrml::compiled_mesh & mesh,
+             const std::vector<openvrml::vec3f> & coord,
+             const std::vector<openvrml::vec2f> & tex_coord,
+             const float normal_scale,
+             const float normal_y)
+        OPENVRML_THROW1(std::bad_alloc)
+    {
+        using openvrml::int32;
+        using openvrml::vec3f;
+        using openvrml::make_vec2f;
+        using openvrml::make_vec3f;
+
+        const std::size_t facets = coord.size() / 2;
+        const int32 first = int32(mesh.coord.size());
+        for (std::size_t i = 0; i <= facets; ++i) {
+            //
+            // The seam gets vertices of its own, so that the texture wraps
+            // around.
+            //
+            const std::size_t j = i % facets;
+            const float seam = (i == facets) ? 1.0f : 0.0f;
+            const vec3f & rim = coord[facets + j];
+            const vec3f N = make_vec3f(rim.x() * normal_scale,
+                                       normal_y,
+                                       rim.z() * normal_scale).normalize();
+            add_vertex(mesh, coord[facets + j], N,
+                       make_vec2f(tex_coord[facets + j].x() - seam,
+                                  tex_coord[facets + j].y()));
+            add_vertex(mesh, coord[j], N,
+                       make_vec2f(tex_coord[j].x() - seam,
+                                  tex_coord[j].y()));
+        }
+        add_quad_strip(mesh, first);
+    }
+
+    OPENVRML_LOCAL const openvrml::vec2f cap_tex_coord(const double angle)
+        OPENVRML_NOTHROW
+    {
+        using std::cos;
+        using std::sin;
+        return openvrml::make_vec2f(float(0.5 * (1.0 + sin(angle))),
+                                    float(1.0 - 0.5 * (1.0 + cos(angle))));
+    }
+
+    /**
+     * @internal
+     *
+     * @brief Add the bottom of a cylinder or a cone.
+     *
+     * @param[in,out] mesh  a mesh.
+     * @param[in] height    the height of the cylinder or cone.
+     * @param[in] coord     the rims computed by @c cylinder_rims.
+     *
+     * @exception std::bad_alloc    if memory allocation fails.
+     */
+    OPENVRML_LOCAL void add_bottom(openvrml::compiled_mesh & mesh,
+                                   const float height,
+                                   const std::vector<openvrml::vec3f> & coord)
+        OPENVRML_THROW1(std::bad_alloc)
+    {
+        using openvrml::int32;
+        using openvrml::vec3f;
+        using openvrml::make_vec2f;
+        using openvrml::make_vec3f;
+        using openvrml::local::pi;
+
+        const std::size_t facets = coord.size() / 2;
+        const vec3f N = make_vec3f(0.0f, -1.0f, 0.0f);
+        const int32 first = add_vertex(mesh,
+                                       make_vec3f(0.0f, -0.5f * height, 0.0f),
+                                       N,
+                                       make_vec2f(0.5f, 0.5f));
+        double angle = 0.5 * pi; // First vertex is at max x.
+        const double aincr = 2.0 * pi / facets;
+        for (std::size_t i = 0; i <= facets; ++i, angle += aincr) {
+            add_vertex(mesh, coord[facets + i % facets], N,
+                       cap_tex_coord(angle));
+        }
+        add_triangle_fan(mesh, first);
+    }
+
+    /**
+     * @internal
+     *
+     * @brief Add the top of a cylinder.
+     *
+     * @param[in,out] mesh  a mesh.
+     * @param[in] height    the height of the cylinder.
+     * @param[in] coord     the rims computed by @c cylinder_rims.
+     *
+     * @exception std::bad_alloc    if memory allocation fails.
+     */
+    OPENVRML_LOCAL void add_top(openvrml::compiled_mesh & mesh,
+                                const float height,
+                                const std::vector<openvrml::vec3f> & coord)
+        OPENVRML_THROW1(std::bad_alloc)
+    {
+        using openvrml::int32;
+        using openvrml::vec3f;
+        using openvrml::make_vec2f;
+        using openvrml::make_vec3f;
+        using openvrml::local::pi;
+
+        const std::size_t facets = coord.size() / 2;
+        const vec3f N = make_vec3f(0.0f, 1.0f, 0.0f);
+        const int32 first = add_vertex(mesh,
+                                       make_vec3f(0.0f, 0.5f * height, 0.0f),
+                                       N,
+                                       make_vec2f(0.5f, 0.5f));
+        double angle = 0.75 * pi;
+        const double aincr = 2.0 * pi / facets;
+        for (std::size_t i = facets; i > 0; --i, angle += aincr) {
+            add_vertex(mesh, coord[i - 1], N, cap_tex_coord(angle));
+        }
+        add_vertex(mesh, coord[facets - 1], N, cap_tex_coord(angle));
+        add_triangle_fan(mesh, first);
+    }
+}
+
+/**
+ * @brief Compile a box.
+ *
+ * @param[in] size  box dimensions.
+ * @param[out] mesh the box.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void openvrml::compile_box(const vec3f & size, compiled_mesh & mesh)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    static const int faces[6][4] = {
+        { 0, 1, 2, 3 },
+        { 1, 5, 6, 2 },
+        { 5, 4, 7, 6 },
+        { 4, 0, 3, 7 },
+        { 2, 6, 7, 3 },
+        { 0, 4, 5, 1 }
+    };
+
+    static const float normal[6][3] = {
+        { -1.0f, 0.0f, 0.0f },
+        { 0.0f, 0.0f, 1.0f },
+        { 1.0f, 0.0f, 0.0f },
+        { 0.0f, 0.0f, -1.0f },
+        { 0.0f, 1.0f, 0.0f },
+        { 0.0f, -1.0f, 0.0f }
+    };
+
+    static const float tex_coord[4][2] = {
+        { 0.0f, 0.0f },
+        { 1.0f, 0.0f },
+        { 1.0f, 1.0f },
+        { 0.0f, 1.0f }
+    };
+
+    const float x = size.x() / 2, y = size.y() / 2, z = size.z() / 2;
+    const vec3f v[8] = {
+        make_vec3f(-x, -y, -z),
+        make_vec3f(-x, -y,  z),
+        make_vec3f(-x,  y,  z),
+        make_vec3f(-x,  y, -z),
+        make_vec3f( x, -y, -z),
+        make_vec3f( x, -y,  z),
+        make_vec3f( x,  y,  z),
+        make_vec3f( x,  y, -z)
+    };
+
+    mesh.clear();
+    for (std::size_t i = 0; i < 6; ++i) {
+        const int32 first = int32(mesh.coord.size());
+        for (std::size_t j = 0; j < 4; ++j) {
+            add_vertex(mesh,
+                       v[faces[i][j]],
+                       make_vec3f(normal[i]),
+                       make_vec2f(tex_coord[j]));
+        }
+        add_triangle(mesh, first, first + 1, first + 2);
+        add_triangle(mesh, first, first + 2, first + 3);
+    }
+}
+
+/**
+ * @brief Compile a cone.
+ *
+ * @param[in] height    height.
+ * @param[in] radius    radius at base.
+ * @param[in] bottom    include the bottom.
+ * @param[in] side      include the side.
+ * @param[out] mesh     the cone.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void openvrml::compile_cone(const float height,
+                            const float radius,
+                            const bool bottom,
+                            const bool side,
+                            compiled_mesh & mesh)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    static const std::size_t facets = 11;
+
+    mesh.clear();
+    mesh.solid = bottom && side;
+    if (!(bottom || side)) { return; }
+
+    std::vector<vec3f> coord;
+    std::vector<vec2f> tex_coord;
+    cylinder_rims(height, radius, facets, coord, tex_coord);
+    for (std::size_t i = 0; i < facets; ++i) {
+        coord[i] = make_vec3f(0.0f, coord[i].y(), 0.0f);
+    }
+
+    //
+    // The side normals are perpendicular to the slant.
+    //
+    if (side) { add_side(mesh, coord, tex_coord, height, radius * radius); }
+    if (bottom) { add_bottom(mesh, height, coord); }
+}
+
+/**
+ * @brief Compile a cylinder.
+ *
+ * @param[in] height    height.
+ * @param[in] radius    radius.
+ * @param[in] bottom    include the bottom.
+ * @param[in] side      include the side.
+ * @param[in] top       include the top.
+ * @param[out] mesh     the cylinder.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void openvrml::compile_cylinder(const float height,
+                                const float radius,
+                                const bool bottom,
+                                const bool side,
+                                const bool top,
+                                compiled_mesh & mesh)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    static const std::size_t facets = 8;
+
+    mesh.clear();
+    mesh.solid = bottom && side && top;
+    if (!(bottom || side || top)) { return; }
+
+    std::vector<vec3f> coord;
+    std::vector<vec2f> tex_coord;
+    cylinder_rims(height, radius, facets, coord, tex_coord);
+
+    if (side) { add_side(mesh, coord, tex_coord, 1.0f, 0.0f); }
+    if (bottom) { add_bottom(mesh, height, coord); }
+    if (top) { add_top(mesh, height, coord); }
+}
+
+/**
+ * @brief Compile a sphere.
+ *
+ * @param[in] radius    sphere radius.
+ * @param[out] mesh     the sphere.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void openvrml::compile_sphere(const float radius, compiled_mesh & mesh)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    using local::pi;
+    using local::pi_2;
+
+    static const std::size_t lat_long = 10;
+
+    mesh.clear();
+
+    std::vector<vec3f> unit(lat_long * lat_long);
+    for (std::size_t i = 0; i < lat_long; ++i) {
+        const double y = std::sin(i * pi / (lat_long - 1) - pi_2);
+        const double r = std::sqrt(1.0 - y * y);
+        for (std::size_t j = 0; j < lat_long; ++j) {
+            const double angle = 2 * pi * double(j) / lat_long;
+            unit[i * lat_long + j] = make_vec3f(float(-std::sin(angle) * r),
+                                                float(y),
+                                                float(-std::cos(angle) * r));
+        }
+    }
+
+    for (std::size_t i = 0; i < lat_long - 1; ++i) {
+        const std::size_t n = i * lat_long;
+        const int32 first = int32(mesh.coord.size());
+        for (std::size_t j = 0; j <= lat_long; ++j) {
+            //
+            // The seam gets vertices of its own, so that the texture wraps
+            // around.
+            //
+            const std::size_t k = j % lat_long;
+            const float s = float(j) / lat_long;
+            const vec3f & upper = unit[n + k + lat_long];
+            const vec3f & lower = unit[n + k];
+            add_vertex(mesh, upper * radius, upper,
+                       make_vec2f(s, float(i + 1) / lat_long));
+            add_vertex(mesh, lower * radius, lower,
+                       make_vec2f(s, float(i) / lat_long));
+        }
+        add_quad_strip(mesh, first);
+    }
+}
+
+namespace {
+
+    /**
+     * @internal
+     *
+     * @brief Compute a normal at a vertex of an ElevationGrid.
+     *
+     * @param[in] i         the column of the vertex.
+     * @param[in] j         the row of the vertex.
+     * @param[in] nx        the number of columns.
+     * @param[in] nz        the number of rows.
+     * @param[in] dx        the spacing of the columns.
+     * @param[in] dz        the spacing of the rows.
+     * @param[in] height    the height at the vertex.
+     *
+     * @return the normal at the vertex.
+     */
+    OPENVRML_LOCAL const openvrml::vec3f
+    elevation_vertex_normal(const openvrml::int32 i,
+                            const openvrml::int32 j,
+                            const openvrml::int32 nx,
+                            const openvrml::int32 nz,
+                            const float dx,
+                            const float dz,
+                            const std::vector<float>::const_iterator height)
+        OPENVRML_NOTHROW
+    {
+        openvrml::vec3f Vx, Vz;
+
+        if (i > 0 && i < nx - 1) {
+            Vx.x(2.0f * dx);
+            Vx.y(*(height + 1) - *(height - 1));
+        } else if (i == 0) {
+            Vx.x(dx);
+            Vx.y(*(height + 1) - *height);
+        } else {
+            Vx.x(dx);
+            Vx.y(*height - *(height - 1));
+        }
+        Vx.z(0.0f);
+
+        Vz.x(0.0f);
+        if (j > 0 && j < nz - 1) {
+            Vz.y(*(height + nx) - *(height - nx));
+            Vz.z(2.0f * dz);
+        } else if (j == 0) {
+            Vz.y(*(height + nx) - *height);
+            Vz.z(dz);
+        } else {
+            Vz.y(*height - *(height - nx));
+            Vz.z(dz);
+        }
+
+        return (Vz * Vx).normalize();
+    }
+}
+
+/**
+ * @brief Compile an elevation grid.
+ *
+ * Colors and normals are applied per vertex or per quadrilateral, according
+ * to @p mask.  If @p normal is empty, per-vertex normals are computed from
+ * the neighboring heights.  If @p tex_coord is empty, the texture is
+ * stretched over the grid.
+ *
+ * @param[in] mask          a combination of the @c viewer::mask_ccw,
+ *                          @c viewer::mask_solid,
+ *                          @c viewer::mask_color_per_vertex, and
+ *                          @c viewer::mask_normal_per_vertex flags.
+ * @param[in] height        height field.
+ * @param[in] x_dimension   vertices in the x direction.
+ * @param[in] z_dimension   vertices in the z direction.
+ * @param[in] x_spacing     distance between vertices in the x direction.
+ * @param[in] z_spacing     distance between vertices in the z direction.
+ * @param[in] color         colors.
+ * @param[in] normal        normals.
+ * @param[in] tex_coord     texture coordinates.
+ * @param[out] mesh         the elevation grid.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void
+openvrml::compile_elevation_grid(const unsigned int mask,
+                                 const std::vector<float> & height,
+                                 const int32 x_dimension,
+                                 const int32 z_dimension,
+                                 const float x_spacing,
+                                 const float z_spacing,
+                                 const std::vector<openvrml::color> & color,
+                                 const std::vector<vec3f> & normal,
+                                 const std::vector<vec2f> & tex_coord,
+                                 compiled_mesh & mesh)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    using std::vector;
+
+    mesh.clear();
+    mesh.ccw = (mask & viewer::mask_ccw) != 0;
+    mesh.solid = (mask & viewer::mask_solid) != 0;
+    if (x_dimension < 2 || z_dimension < 2
+        || height.size() < std::size_t(x_dimension)
+                           * std::size_t(z_dimension)) {
+        return;
+    }
+
+    vector<vec3f> coord;
+    vector<vec3f> vertex_normal;
+    vector<vec2f> grid_tex_coord;
+    const bool generate_normals =
+        normal.empty() && (mask & viewer::mask_normal_per_vertex);
+    for (int32 j = 0; j < z_dimension; ++j) {
+        for (int32 i = 0; i < x_dimension; ++i) {
+            const vector<float>::const_iterator h =
+                height.begin() + j * x_dimension + i;
+            coord.push_back(make_vec3f(x_spacing * i, *h, z_spacing * j));
+            if (generate_normals) {
+                vertex_normal.push_back(
+                    elevation_vertex_normal(i, j,
+                                            x_dimension, z_dimension,
+                                            x_spacing, z_spacing,
+                                            h));
+            }
+            if (tex_coord.empty()) {
+                grid_tex_coord.push_back(
+                    make_vec2f(float(i) / (x_dimension - 1),
+                               float(j) / (z_dimension - 1)));
+            }
+        }
+    }
+
+    vector<int32> coord_index;
+    for (int32 j = 0; j < z_dimension - 1; ++j) {
+        for (int32 i = 0; i < x_dimension - 1; ++i) {
+            coord_index.push_back(j * x_dimension + i);
+            coord_index.push_back((j + 1) * x_dimension + i);
+            coord_index.push_back((j + 1) * x_dimension + i + 1);
+            coord_index.push_back(j * x_dimension + i + 1);
+            coord_index.push_back(-1);
+        }
+    }
+
+    static const vector<int32> empty_index;
+    compile_shell(mask | viewer::mask_convex,
+                  coord, coord_index,
+                  color, empty_index,
+                  generate_normals ? vertex_normal : normal, empty_index,
+                  tex_coord.empty() ? grid_tex_coord : tex_coord,
+                  empty_index,
+                  mesh);
+}
+
+/**
+ * @brief Compile an extrusion.
+ *
+ * @param[in] mask          a combination of the @c viewer::mask_ccw,
+ *                          @c viewer::mask_convex, @c viewer::mask_solid,
+ *                          @c viewer::mask_bottom, and @c viewer::mask_top
+ *                          flags.
+ * @param[in] spine         spine points.
+ * @param[in] cross_section cross-section.
+ * @param[in] orientation   cross-section orientations.
+ * @param[in] scale         cross-section scales.
+ * @param[out] mesh         the extrusion.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ *
+ * @sa openvrml::extrusion_coords
+ * @sa openvrml::extrusion_faces
+ */
+void openvrml::compile_extrusion(const unsigned int mask,
+                                 const std::vector<vec3f> & spine,
+                                 const std::vector<vec2f> & cross_section,
+                                 const std::vector<rotation> & orientation,
+                                 const std::vector<vec2f> & scale,
+                                 compiled_mesh & mesh)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    using std::vector;
+
+    mesh.clear();
+    mesh.ccw = (mask & viewer::mask_ccw) != 0;
+    mesh.solid = (mask & viewer::mask_solid) != 0;
+    if (cross_section.empty() || spine.size() < 2) { return; }
+
+    vector<vec3f> coord;
+    vector<vec2f> tex_coord;
+    extrusion_coords(cross_section, spine, scale, orientation,
+                     coord, tex_coord);
+
+    vector<int32> coord_index, tex_coord_index;
+    extrusion_faces(cross_section,
+                    spine.size(),
+                    (mask & viewer::mask_bottom) != 0,
+                    (mask & viewer::mask_top) != 0,
+                    coord_index,
+                    tex_coord,
+                    tex_coord_index);
+
+    static const vector<openvrml::color> no_color;
+    static const vector<vec3f> no_normal;
+    static const vector<int32> empty_index;
+    compile_shell(mask & ~(viewer::mask_color_per_vertex
+                           | viewer::mask_normal_per_vertex),
+                  coord, coord_index,
+                  no_color, empty_index,
+                  no_normal, empty_index,
+                  tex_coord, tex_coord_index,
+                  mesh);
+}
+
+namespace {
+
+    OPENVRML_LOCAL void
+    compute_bounds(const std::vector<openvrml::vec3f> & points,
+                   float (&bounds)[6])
+        OPENVRML_NOTHROW
+    {
+        if (points.empty()) {
+            std::fill(bounds, bounds + 6, 0.0f);
+            return;
+        }
+        bounds[0] = bounds[1] = points[0].x();
+        bounds[2] = bounds[3] = points[0].y();
+        bounds[4] = bounds[5] = points[0].z();
+        for (std::size_t i = 1; i < points.size(); ++i) {
+            bounds[0] = (std::min)(bounds[0], points[i].x());
+            bounds[1] = (std::max)(bounds[1], points[i].x());
+            bounds[2] = (std::min)(bounds[2], points[i].y());
+            bounds[3] = (std::max)(bounds[3], points[i].y());
+            bounds[4] = (std::min)(bounds[4], points[i].z());
+            bounds[5] = (std::max)(bounds[5], points[i].z());
+        }
+    }
+
+    /**
+     * @internal
+     *
+     * @brief Choose the axes along which to generate texture coordinates.
+     *
+     * As described in 6.23 of VRML97, the texture's s axis follows the
+     * longest dimension of the bounding box and its t axis the next
+     * longest.
+     *
+     * @param[in] bounds    xmin, xmax, ymin, ymax, zmin, zmax.
+     * @param[out] axes     the axes for s and t.
+     * @param[out] params   s0, 1/sSize, t0, 1/tSize; or zero sizes if two of
+     *                      the dimensions are zero.
+     */
+    OPENVRML_LOCAL void tex_gen_params(const float (&bounds)[6],
+                                       int (&axes)[2],
+                                       float (&params)[4])
+        OPENVRML_NOTHROW
+    {
+        using openvrml::local::fequal;
+
+        axes[0] = 0;
+        axes[1] = 1;
+        params[0] = params[1] = params[2] = params[3] = 0.0f;
+
+        for (int nb = 0; nb < 3; ++nb) {
+            const float db = bounds[2 * nb + 1] - bounds[2 * nb];
+            if (db > params[1]) {
+                axes[1] = axes[0];
+                axes[0] = nb;
+                params[2] = params[0];
+                params[3] = params[1];
+                params[0] = bounds[2 * nb];
+                params[1] = db;
+            } else if (db > params[3]) {
+                axes[1] = nb;
+                params[2] = bounds[2 * nb];
+                params[3] = db;
+            }
+        }
+
+        // If two of the dimensions are zero, give up.
+        if (fequal(params[1], 0.0f) || fequal(params[3], 0.0f)) { return; }
+
+        params[1] = 1.0f / params[1];
+        params[3] = 1.0f / params[3];
+    }
+
+    /**
+     * @internal
+     *
+     * @brief Twice the signed area of a triangle in the plane.
+     */
+    OPENVRML_LOCAL float cross(const openvrml::vec2f & a,
+                               const openvrml::vec2f & b,
+                               const openvrml::vec2f & c)
+        OPENVRML_NOTHROW
+    {
+        return (b.x() - a.x()) * (c.y() - a.y())
+            - (b.y() - a.y()) * (c.x() - a.x());
+    }
+
+    /**
+     * @internal
+     *
+     * @brief Triangulate a simple polygon by ear clipping.
+     *
+     * The polygon is projected onto the coordinate plane most nearly
+     * parallel to it.  Ears are clipped in the polygon's own winding, so
+     * the triangles face the same way the polygon does.  A polygon that is
+     * not simple (or is degenerate) may run out of ears; then the triangles
+     * that remain are clipped regardless, so that nothing is lost.
+     *
+     * @param[in,out] mesh  a mesh.
+     * @param[in] first     the first vertex of the polygon; the polygon's
+     *                      vertices run to the end of the mesh.
+     * @param[in] normal    the polygon's normal, computed with Newell's
+     *                      method.
+     *
+     * @exception std::bad_alloc    if memory allocation fails.
+     */
+    OPENVRML_LOCAL void add_polygon(openvrml::compiled_mesh & mesh,
+                                    const openvrml::int32 first,
+                                    const openvrml::vec3f & normal)
+        OPENVRML_THROW1(std::bad_alloc)
+    {
+        using std::vector;
+        using openvrml::int32;
+        using openvrml::vec2f;
+        using openvrml::vec3f;
+        using openvrml::make_vec2f;
+
+        //
+        // Drop the axis along which the normal is longest, keeping the
+        // other two in cyclic order; the projection is then
+        // counterclockwise if that component of the normal is positive.
+        //
+        const float n[3] = {
+            std::fabs(normal.x()),
+            std::fabs(normal.y()),
+            std::fabs(normal.z())
+        };
+        const std::size_t axis = (n[0] >= n[1] && n[0] >= n[2]) ? 0
+                               : (n[1] >= n[2]) ? 1
+                               : 2;
+        const std::size_t u = (axis + 1) % 3, v = (axis + 2) % 3;
+        const float orientation = (normal[axis] < 0.0f) ? -1.0f : 1.0f;
+
+        const int32 end = int32(mesh.coord.size());
+        vector<int32> remaining;
+        vector<vec2f> point;
+        for (int32 i = first; i < end; ++i) {
+            remaining.push_back(i);
+            const vec3f & c = mesh.coord[std::size_t(i)];
+            point.push_back(make_vec2f(c[u], c[v]));
+        }
+
+        while (remaining.size() > 3) {
+            const std::size_t count = remaining.size();
+            std::size_t ear = 0;
+            bool found = false;
+            for (std::size_t i = 0; i < count && !found; ++i) {
+                const vec2f & a = point[remaining[(i + count - 1) % count]
+                                        - first];
+                const vec2f & b = point[remaining[i] - first];
+                const vec2f & c = point[remaining[(i + 1) % count] - first];
+                if (!(orientation * cross(a, b, c) > 0.0f)) { continue; }
+
+                found = true;
+                for (std::size_t j = 0; j < count && found; ++j) {
+                    const vec2f & p = point[remaining[j] - first];
+                    if (p == a || p == b || p == c) { continue; }
+                    found = !(orientation * cross(a, b, p) >= 0.0f
+                              && orientation * cross(b, c, p) >= 0.0f
+                              && orientation * cross(c, a, p) >= 0.0f);
+                }
+                if (found) { ear = i; }
+            }
+
+            add_triangle(mesh,
+                         remaining[(ear + count - 1) % count],
+                         remaining[ear],
+                         remaining[(ear + 1) % count]);
+            remaining.erase(remaining.begin() + ear);
+        }
+        add_triangle(mesh, remaining[0], remaining[1], remaining[2]);
+    }
+}
+
+/**
+ * @brief Compile a polygon mesh.
+ *
+ * This is the counterpart of @c viewer::insert_shell.  Each corner of each
+ * face gets a vertex of its own, with the color, normal, and texture
+ * coordinate that apply to it.  Faces with invalid coordinate indices, or
+ * with fewer than three corners, are skipped.  A face whose normal is not
+ * given gets the normal of its plane.  If @p tex_coord is empty, texture
+ * coordinates are generated as described in 6.23 of VRML97; if the mesh is
+ * degenerate so that they cannot be, @p mesh is left empty.
+ *
+ * Faces are convex if @p mask includes @c viewer::mask_convex; otherwise,
+ * they are triangulated by ear clipping.
+ *
+ * @param[in] mask              a combination of the @c viewer::mask_ccw,
+ *                              @c viewer::mask_convex,
+ *                              @c viewer::mask_solid,
+ *                              @c viewer::mask_color_per_vertex, and
+ *                              @c viewer::mask_normal_per_vertex flags.
+ * @param[in] coord             coordinates.
+ * @param[in] coord_index       coordinate indices.
+ * @param[in] color             colors.
+ * @param[in] color_index       color indices.
+ * @param[in] normal            normals.
+ * @param[in] normal_index      normal indices.
+ * @param[in] tex_coord         texture coordinates.
+ * @param[in] tex_coord_index   texture coordinate indices.
+ * @param[out] mesh             the mesh.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void openvrml::compile_shell(const unsigned int mask,
+                             const std::vector<vec3f> & coord,
+                             const std::vector<int32> & coord_index,
+                             const std::vector<openvrml::color> & color,
+                             const std::vector<int32> & color_index,
+                             const std::vector<vec3f> & normal,
+                             const std::vector<int32> & normal_index,
+                             const std::vector<vec2f> & tex_coord,
+                             const std::vector<int32> & tex_coord_index,
+                             compiled_mesh & mesh)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    using std::size_t;
+    using std::vector;
+
+    mesh.clear();
+    mesh.ccw = (mask & viewer::mask_ccw) != 0;
+    mesh.solid = (mask & viewer::mask_solid) != 0;
+    if (coord_index.size() < 4) { return; } // 3 pts and a trailing -1
+
+    //
+    // Texture coordinate generation parameters.
+    //
+    int tex_axes[2] = { 0, 1 };    // Map s,t to x,y,z
+    float tex_params[4] = {};      // s0, 1/sSize, t0, 1/tSize
+    if (tex_coord.empty()) {
+        float bounds[6];
+        compute_bounds(coord, bounds);
+        tex_gen_params(bounds, tex_axes, tex_params);
+        if (local::fequal(tex_params[1], 0.0f)
+            || local::fequal(tex_params[3], 0.0f)) {
+            return;
+        }
+    }
+
+    const bool color_per_vertex = (mask & viewer::mask_color_per_vertex) != 0;
+    const bool normal_per_vertex =
+        (mask & viewer::mask_normal_per_vertex) != 0;
+    openvrml::color current_color = make_color(1.0f, 1.0f, 1.0f);
+
+    size_t face = 0;
+    for (size_t begin = 0; begin < coord_index.size(); ++face) {
+        size_t end = begin;
+        bool valid = true;
+        for (; end < coord_index.size() && coord_index[end] != -1; ++end) {
+            valid = valid
+                && coord_index[end] >= 0
+                && size_t(coord_index[end]) < coord.size();
+        }
+
+        if (!valid || end - begin < 3) {
+            begin = end + 1;
+            continue;
+        }
+
+        //
+        // Newell's method gives the normal of a polygon that is neither
+        // convex nor quite planar.
+        //
+        float nx = 0.0f, ny = 0.0f, nz = 0.0f;
+        for (size_t i = begin; i < end; ++i) {
+            const vec3f & a = coord[size_t(coord_index[i])];
+            const vec3f & b =
+                coord[size_t(coord_index[(i + 1 < end) ? i + 1 : begin])];
+            nx += (a.y() - b.y()) * (a.z() + b.z());
+            ny += (a.z() - b.z()) * (a.x() + b.x());
+            nz += (a.x() - b.x()) * (a.y() + b.y());
+        }
+        const vec3f polygon_normal = make_vec3f(nx, ny, nz);
+        vec3f face_normal = polygon_normal.normalize();
+
+        // Flip normal if primitive orientation is clockwise.
+        if (!mesh.ccw) { face_normal = -face_normal; }
+
+        //
+        // Per-face attributes.
+        //
+        if (!color_per_vertex) {
+            const size_t index = (face < color_index.size())
+                               ? size_t(color_index[face])
+                               : face;
+            if (index < color.size()) { current_color = color[index]; }
+        }
+        if (!normal_per_vertex) {
+            const size_t index = (face < normal_index.size())
+                               ? size_t(normal_index[face])
+                               : face;
+            if (index < normal.size()) { face_normal = normal[index]; }
+        }
+
+        const int32 first = int32(mesh.coord.size());
+        for (size_t i = begin; i < end; ++i) {
+            const size_t v = size_t(coord_index[i]);
+            mesh.coord.push_back(coord[v]);
+
+            if (!color.empty()) {
+                if (color_per_vertex) {
+                    const size_t index = (i < color_index.size())
+                                       ? size_t(color_index[i])
+                                       : v;
+                    if (index < color.size()) {
+                        current_color = color[index];
+                    }
+                }
+                mesh.color.push_back(current_color);
+            }
+
+            vec3f vertex_normal = face_normal;
+            if (normal_per_vertex) {
+                const size_t index = (i < normal_index.size())
+                                   ? size_t(normal_index[i])
+                                   : v;
+                if (index < normal.size()) { vertex_normal = normal[index]; }
+            }
+            mesh.normal.push_back(vertex_normal);
+
+            const size_t tex_index = (i < tex_coord_index.size())
+                                   ? size_t(tex_coord_index[i])
+                                   : v;
+            if (tex_index < tex_coord.size()) {
+                mesh.tex_coord.push_back(tex_coord[tex_index]);
+            } else {
+                const vec3f & c = coord[v];
+                mesh.tex_coord.push_back(
+                    make_vec2f((c[size_t(tex_axes[0])] - tex_params[0])
+                               * tex_params[1],
+                               (c[size_t(tex_axes[1])] - tex_params[2])
+                               * tex_params[3]));
+            }
+        }
+
+        if (mask & viewer::mask_convex) {
+            add_triangle_fan(mesh, first);
+        } else {
+            add_polygon(mesh, first, polygon_normal);
+        }
+
+        begin = end + 1;
+    }
+}
+
+
+/**
+ * @class openvrml::compiled_mesh_cache openvrml/compiled_mesh.h
+ *
+ * @brief The @c compiled_mesh of each geometry node, shared by the viewers
+ *        of a @c browser.
+ *
+ * Tessellating a geometry node is the same work whatever renders it; the
+ * @c browser keeps a @c compiled_mesh_cache so that it is done once for
+ * each node rather than once for each viewer.  A mesh is discarded when its
+ * node is modified (see @c geometry_node::render_geometry) or destroyed.
+ *
+ * The cache may be used from several threads at once.
+ *
+ * @sa openvrml::browser::compiled_meshes
+ */
+
+/**
+ * @typedef openvrml::compiled_mesh_cache::mesh_map_t
+ *
+ * @brief Map of geometry nodes to their meshes.
+ */
+
+/**
+ * @var boost::shared_mutex openvrml::compiled_mesh_cache::mutex_
+ *
+ * @brief Guards @c #meshes_.
+ */
+
+/**
+ * @var openvrml::compiled_mesh_cache::mesh_map_t openvrml::compiled_mesh_cache::meshes_
+ *
+ * @brief Map of geometry nodes to their meshes.
+ */
+
+/**
+ * @brief Construct an empty cache.
+ */
+openvrml::compiled_mesh_cache::compiled_mesh_cache() OPENVRML_NOTHROW
+{}
+
+/**
+ * @brief Find the mesh for a node.
+ *
+ * @param[in] n a geometry node.
+ *
+ * @return the mesh for @p n, or a null pointer if there is none.
+ */
+const boost::shared_ptr<const openvrml::compiled_mesh>
+openvrml::compiled_mesh_cache::find(const geometry_node & n) const
+    OPENVRML_NOTHROW
+{
+    boost::shared_lock<boost::shared_mutex> lock(this->mutex_);
+    const mesh_map_t::const_iterator pos = this->meshes_.find(&n);
+    return (pos != this->meshes_.end())
+        ? pos->second
+        : boost::shared_ptr<const compiled_mesh>();
+}
+
+/**
+ * @brief Set the mesh for a node.
+ *
+ * The mesh replaces any the node already has.
+ *
+ * @param[in] n     a geometry node.
+ * @param[in] mesh  the mesh for @p n.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void
+openvrml::compiled_mesh_cache::
+insert(const geometry_node & n,
+       const boost::shared_ptr<const compiled_mesh> & mesh)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    boost::unique_lock<boost::shared_mutex> lock(this->mutex_);
+    this->meshes_[&n] = mesh;
+}
+
+/**
+ * @brief Discard the mesh for a node.
+ *
+ * Meshes that have been retrieved with @c #find remain valid for as long as
+ * they are referenced.
+ *
+ * @param[in] n a geometry node.
+ */
+void openvrml::compiled_mesh_cache::invalidate(const geometry_node & n)
+    OPENVRML_NOTHROW
+{
+    boost::unique_lock<boost::shared_mutex> lock(this->mutex_);
+    this->meshes_.erase(&n);
+}
+
+/**
+ * @brief Discard all of the meshes.
+ */
+void openvrml::compiled_mesh_cache::clear() OPENVRML_NOTHROW
+{
+    boost::unique_lock<boost::shared_mutex> lock(this->mutex_);
+    this->meshes_.clear();
+}
+
+/**
+ * @brief The number of meshes.
+ *
+ * @return the number of meshes in the cache.
+ */
+std::size_t openvrml::compiled_mesh_cache::size() const OPENVRML_NOTHROW
+{
+    boost::shared_lock<boost::shared_mutex> lock(this->mutex_);
+    return this->meshes_.size();
+}
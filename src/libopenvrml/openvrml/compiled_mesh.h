@@ -0,0 +1,129 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# ifndef OPENVRML_COMPILED_MESH_H
+#   define OPENVRML_COMPILED_MESH_H
+
+#   include <openvrml/basetypes.h>
+#   include <boost/shared_ptr.hpp>
+#   include <boost/thread/shared_mutex.hpp>
+#   include <boost/utility.hpp>
+#   include <map>
+#   include <vector>
+
+namespace openvrml {
+
+    class geometry_node;
+
+    class OPENVRML_API compiled_mesh {
+    public:
+        std::vector<vec3f> coord;
+        std::vector<vec3f> normal;
+        std::vector<vec2f> tex_coord;
+        std::vector<openvrml::color> color;
+        std::vector<int32> triangle_index;
+        bool ccw;
+        bool solid;
+
+        compiled_mesh() OPENVRML_NOTHROW;
+
+        bool empty() const OPENVRML_NOTHROW;
+        void clear() OPENVRML_NOTHROW;
+    };
+
+    OPENVRML_API void compile_box(const vec3f & size, compiled_mesh & mesh)
+        OPENVRML_THROW1(std::bad_alloc);
+
+    OPENVRML_API void compile_cone(float height,
+                                   float radius,
+                                   bool bottom,
+                                   bool side,
+                                   compiled_mesh & mesh)
+        OPENVRML_THROW1(std::bad_alloc);
+
+    OPENVRML_API void compile_cylinder(float height,
+                                       float radius,
+                                       bool bottom,
+                                       bool side,
+                                       bool top,
+                                       compiled_mesh & mesh)
+        OPENVRML_THROW1(std::bad_alloc);
+
+    OPENVRML_API void compile_sphere(float radius, compiled_mesh & mesh)
+        OPENVRML_THROW1(std::bad_alloc);
+
+    OPENVRML_API void
+    compile_elevation_grid(unsigned int mask,
+                           const std::vector<float> & height,
+                           int32 x_dimension,
+                           int32 z_dimension,
+                           float x_spacing,
+                           float z_spacing,
+                           const std::vector<color> & color,
+                           const std::vector<vec3f> & normal,
+                           const std::vector<vec2f> & tex_coord,
+                           compiled_mesh & mesh)
+        OPENVRML_THROW1(std::bad_alloc);
+
+    OPENVRML_API void
+    compile_extrusion(unsigned int mask,
+                      const std::vector<vec3f> & spine,
+                      const std::vector<vec2f> & cross_section,
+                      const std::vector<rotation> & orientation,
+                      const std::vector<vec2f> & scale,
+                      compiled_mesh & mesh)
+        OPENVRML_THROW1(std::bad_alloc);
+
+    OPENVRML_API void compile_shell(unsigned int mask,
+                                    const std::vector<vec3f> & coord,
+                                    const std::vector<int32> & coord_index,
+                                    const std::vector<color> & color,
+                                    const std::vector<int32> & color_index,
+                                    const std::vector<vec3f> & normal,
+                                    const std::vector<int32> & normal_index,
+                                    const std::vector<vec2f> & tex_coord,
+                                    const std::vector<int32> & tex_coord_index,
+                                    compiled_mesh & mesh)
+        OPENVRML_THROW1(std::bad_alloc);
+
+
+    class OPENVRML_API compiled_mesh_cache : boost::noncopyable {
+        typedef std::map<const geometry_node *,
+                         boost::shared_ptr<const compiled_mesh> >
+            mesh_map_t;
+
+        mutable boost::shared_mutex mutex_;
+        mesh_map_t meshes_;
+
+    public:
+        compiled_mesh_cache() OPENVRML_NOTHROW;
+
+        const boost::shared_ptr<const compiled_mesh>
+        find(const geometry_node & n) const OPENVRML_NOTHROW;
+        void insert(const geometry_node & n,
+                    const boost::shared_ptr<const compiled_mesh> & mesh)
+            OPENVRML_THROW1(std::bad_alloc);
+        void invalidate(const geometry_node & n) OPENVRML_NOTHROW;
+        void clear() OPENVRML_NOTHROW;
+        std::size_t size() const OPENVRML_NOTHROW;
+    };
+}
+
+# endif // ifndef OPENVRML_COMPILED_MESH_H
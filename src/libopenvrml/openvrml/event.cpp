@@ -23,6 +23,7 @@
 # endif
 
 # include "event.h"
+# include <openvrml/local/event_cascade.h>
 
 /**
  * @file openvrml/event.h
@@ -409,6 +410,13 @@ const std::string openvrml::node_event_listener::eventin_id() const
  * of @c node should call @c node::emit_event to emit an event.
  */
 
+/**
+ * @var class openvrml::event_emitter::local::event_cascade
+ *
+ * @brief @c local::event_cascade calls @c event_emitter::emit_event to
+ *        deliver queued events.
+ */
+
 /**
  * @internal
  *
@@ -418,20 +426,26 @@ const std::string openvrml::node_event_listener::eventin_id() const
  */
 
 /**
- * @typedef openvrml::event_emitter::listener_set
+ * @internal
+ *
+ * @typedef openvrml::event_emitter::listener_vector
  *
- * @brief Set of @c event_listener%s.
+ * @brief Type-erased sequence of @c field_value_listener%s.
  */
 
 /**
  * @internal
  *
- * @var openvrml::event_emitter::listener_set openvrml::event_emitter::listeners_
+ * @var openvrml::event_emitter::listener_vector openvrml::event_emitter::listeners_
  *
- * @brief The listeners registered for this emitter.
+ * @brief The listeners registered for this emitter, in the order they were
+ *        added.
  *
- * When @c emit_event is called, each of the registered listeners will be sent
- * an event.
+ * Each element is a <code>field_value_listener<FieldValue> *</code> for the
+ * @c FieldValue of @c #value_, converted to <code>void *</code> by @c #add.
+ * The conversion from @c event_listener is done once, when the route is
+ * added; @c emit_event converts each element back with a @c static_cast, so
+ * delivering an event does not use RTTI.
  */
 
 /**
@@ -471,9 +485,17 @@ openvrml::event_emitter::event_emitter(const field_value & value)
 
 /**
  * @brief Destroy.
+ *
+ * Any events for this emitter still waiting in the current
+ * @c local::event_cascade are cancelled.
  */
 openvrml::event_emitter::~event_emitter() OPENVRML_NOTHROW
-{}
+{
+    if (local::event_cascade * const cascade =
+        local::event_cascade::current()) {
+        cascade->cancel(*this);
+    }
+}
 
 /**
  * @brief A reference to the @c field_value for the @c event_emitter.
@@ -509,6 +531,23 @@ const std::string openvrml::event_emitter::eventout_id() const
  * @return the associated eventOut identifier.
  */
 
+/**
+ * @brief The @c node the @c event_emitter belongs to.
+ *
+ * @c local::event_cascade keeps the @c node alive while an event from the
+ * @c event_emitter is waiting to be delivered.  Subclasses for the eventOuts
+ * of a @c node should override this function; the default implementation
+ * returns 0, and the events of such an @c event_emitter are cancelled if it
+ * is destroyed first.
+ *
+ * @return the @c node the @c event_emitter belongs to, or 0 if it is not
+ *         known.
+ */
+openvrml::node * openvrml::event_emitter::do_node() const OPENVRML_NOTHROW
+{
+    return 0;
+}
+
 /**
  * @brief The timestamp of the last event emitted.
  *
@@ -527,10 +566,14 @@ double openvrml::event_emitter::last_time() const OPENVRML_NOTHROW
  *
  * @brief Add an event listener.
  *
- * @tparam FieldValue   a @link FieldValueConcept Field Value@endlink.
+ * @tparam FieldValue   a @link FieldValueConcept Field Value@endlink; must be
+ *                      the type of @c #value.
  *
  * @param[in] listener  an event listener.
  *
+ * @return @c true if @p listener is added; @c false if it was already
+ *         registered.
+ *
  * @exception std::bad_alloc    if memory allocation fails.
  */
 
@@ -542,6 +585,9 @@ double openvrml::event_emitter::last_time() const OPENVRML_NOTHROW
  * @tparam FieldValue   a @link FieldValueConcept Field Value@endlink.
  *
  * @param[in] listener  an event listener.
+ *
+ * @return @c true if @p listener is removed; @c false if it was not
+ *         registered.
  */
 
 /**
@@ -559,7 +605,10 @@ double openvrml::event_emitter::last_time() const OPENVRML_NOTHROW
  *
  * @brief Emit an event.
  *
- * @tparam FieldValue   a @link FieldValueConcept Field Value@endlink.
+ * Listeners are sent the event in the order they were added.
+ *
+ * @tparam FieldValue   a @link FieldValueConcept Field Value@endlink; must be
+ *                      the type of @c #value.
  *
  * @param[in] timestamp the current time.
  *
@@ -21,13 +21,19 @@
 # ifndef OPENVRML_EVENT_H
 #   define OPENVRML_EVENT_H
 
+#   include <algorithm>
 #   include <set>
+#   include <vector>
 #   include <openvrml/field_value.h>
 
 namespace openvrml {
 
     class node;
 
+    namespace local {
+        class event_cascade;
+    }
+
     class OPENVRML_API event_listener : boost::noncopyable {
     public:
         virtual ~event_listener() OPENVRML_NOTHROW = 0;
@@ -159,18 +165,18 @@ namespace openvrml {
 
     class OPENVRML_API event_emitter : boost::noncopyable {
         friend class node;
+        friend class local::event_cascade;
 
         const field_value & value_;
 
-        std::set<event_listener *> listeners_;
+        typedef std::vector<void *> listener_vector;
+        listener_vector listeners_;
         mutable boost::shared_mutex listeners_mutex_;
 
         double last_time_;
         mutable boost::shared_mutex last_time_mutex_;
 
     public:
-        typedef std::set<event_listener *> listener_set;
-
         virtual ~event_emitter() OPENVRML_NOTHROW = 0;
 
         const field_value & value() const OPENVRML_NOTHROW;
@@ -196,6 +202,7 @@ namespace openvrml {
 
     private:
         virtual const std::string do_eventout_id() const OPENVRML_NOTHROW = 0;
+        virtual openvrml::node * do_node() const OPENVRML_NOTHROW;
         virtual void emit_event(double timestamp)
             OPENVRML_THROW1(std::bad_alloc) = 0;
     };
@@ -206,8 +213,15 @@ namespace openvrml {
     {
         using boost::unique_lock;
         using boost::shared_mutex;
+        assert(listener.type() == this->value_.type());
+        void * const entry = static_cast<void *>(&listener);
         unique_lock<shared_mutex> lock(this->listeners_mutex_);
-        return this->listeners_.insert(&listener).second;
+        if (std::find(this->listeners_.begin(), this->listeners_.end(), entry)
+            != this->listeners_.end()) {
+            return false;
+        }
+        this->listeners_.push_back(entry);
+        return true;
     }
 
     template <typename FieldValue>
@@ -216,8 +230,13 @@ namespace openvrml {
     {
         using boost::unique_lock;
         using boost::shared_mutex;
+        void * const entry = static_cast<void *>(&listener);
         unique_lock<shared_mutex> lock(this->listeners_mutex_);
-        return (this->listeners_.erase(&listener) > 0);
+        const listener_vector::iterator pos =
+            std::find(this->listeners_.begin(), this->listeners_.end(), entry);
+        if (pos == this->listeners_.end()) { return false; }
+        this->listeners_.erase(pos);
+        return true;
     }
 
     template <typename FieldValue>
@@ -225,21 +244,15 @@ namespace openvrml {
     event_emitter::listeners() const
         OPENVRML_THROW1(std::bad_alloc)
     {
-        struct cast {
-            field_value_listener<FieldValue> *
-            operator()(event_listener * listener) const OPENVRML_NOTHROW
-            {
-                field_value_listener<FieldValue> * const result =
-                    dynamic_cast<field_value_listener<FieldValue> *>(listener);
-                assert(result);
-                return result;
-            }
-        };
         boost::shared_lock<boost::shared_mutex> lock(this->listeners_mutex_);
         std::set<field_value_listener<FieldValue> *> result;
-        std::transform(this->listeners_.begin(), this->listeners_.end(),
-                       inserter(result, result.begin()),
-                       cast());
+        for (listener_vector::const_iterator listener =
+                 this->listeners_.begin();
+             listener != this->listeners_.end();
+             ++listener) {
+            result.insert(
+                static_cast<field_value_listener<FieldValue> *>(*listener));
+        }
         return result;
     }
 
@@ -249,18 +262,18 @@ namespace openvrml {
     {
         using boost::shared_lock;
         using boost::shared_mutex;
+        using boost::polymorphic_downcast;
+        const FieldValue & value =
+            *polymorphic_downcast<const FieldValue *>(&this->value());
         shared_lock<shared_mutex> listeners_lock(this->listeners_mutex_);
         shared_lock<shared_mutex> last_time_lock(this->last_time_mutex_);
-        for (typename listener_set::iterator listener =
+        for (listener_vector::const_iterator listener =
                  this->listeners_.begin();
              listener != this->listeners_.end();
              ++listener) {
-            using boost::polymorphic_downcast;
             assert(*listener);
-            dynamic_cast<field_value_listener<FieldValue> &>(**listener)
-                .process_event(
-                    *polymorphic_downcast<const FieldValue *>(&this->value()),
-                    timestamp);
+            static_cast<field_value_listener<FieldValue> *>(*listener)
+                ->process_event(value, timestamp);
         }
         this->last_time_ = timestamp;
     }
@@ -78,6 +78,14 @@
  * @tparam FieldValue   a @link FieldValueConcept Field Value@endlink.
  */
 
+/**
+ * @fn openvrml::node * openvrml::exposedfield::do_node() const
+ *
+ * @brief The @c node the @c exposedField belongs to.
+ *
+ * @return the @c node the @c exposedField belongs to.
+ */
+
 /**
  * @fn void openvrml::exposedfield::do_process_event(const FieldValue & value, double timestamp)
  *
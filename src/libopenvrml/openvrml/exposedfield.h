@@ -43,6 +43,7 @@ namespace openvrml {
         exposedfield(const exposedfield<FieldValue> & obj);
 
     private:
+        virtual openvrml::node * do_node() const OPENVRML_NOTHROW;
         virtual void do_process_event(const FieldValue & value,
                                       double timestamp)
             OPENVRML_THROW1(std::bad_alloc);
@@ -77,6 +78,13 @@ namespace openvrml {
     inline exposedfield<FieldValue>::~exposedfield() OPENVRML_NOTHROW
     {}
 
+    template <typename FieldValue>
+    inline openvrml::node *
+    exposedfield<FieldValue>::do_node() const OPENVRML_NOTHROW
+    {
+        return &this->node();
+    }
+
     template <typename FieldValue>
     inline void
     exposedfield<FieldValue>::do_process_event(const FieldValue & value,
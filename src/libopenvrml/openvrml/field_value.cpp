@@ -60,46 +60,50 @@ std::ostream & openvrml::operator<<(std::ostream & out,
  * @brief Abstract base class for the VRML field types.
  *
  * Subclasses of @c field_value are models of @link FieldValueConcept
- * Field Value@endlink. These subclasses have copy-on-write semantics.
+ * Field Value@endlink. Small scalar and vector values are stored inline in the
+ * instance; the remaining types have copy-on-write semantics.
  */
 
 /**
  * @internal
  *
- * @class openvrml::field_value::counted_impl_base openvrml/field_value.h
+ * @class openvrml::field_value::impl_base openvrml/field_value.h
  *
- * @brief Base class for the internal reference-counted objects.
+ * @brief Base class for the internal value storage objects.
+ *
+ * Instances are always constructed in the inline storage of a
+ * @c field_value (@c field_value::storage_).
  */
 
 /**
  * @brief Destroy.
  */
-openvrml::field_value::counted_impl_base::~counted_impl_base() OPENVRML_NOTHROW
+openvrml::field_value::impl_base::~impl_base() OPENVRML_NOTHROW
 {}
 
 /**
  * @brief Clone.
  *
- * Delegates to @c counted_impl_base::do_clone.
+ * Delegates to @c impl_base::do_clone.
  *
- * @return a clone of the instance.
+ * @param[in] storage   uninitialized storage for the copy.
  *
  * @exception std::bad_alloc    if memory allocation fails.
  */
-std::auto_ptr<openvrml::field_value::counted_impl_base>
-openvrml::field_value::counted_impl_base::clone() const OPENVRML_THROW1(std::bad_alloc)
+void openvrml::field_value::impl_base::clone(void * const storage) const
+    OPENVRML_THROW1(std::bad_alloc)
 {
-    return this->do_clone();
+    this->do_clone(storage);
 }
 
 /**
- * @fn std::auto_ptr<openvrml::field_value::counted_impl_base> openvrml::field_value::counted_impl_base::do_clone() const
+ * @fn void openvrml::field_value::impl_base::do_clone(void * storage) const
  *
  * @brief Clone.
  *
- * Polymorphically construct a copy.
+ * Polymorphically construct a copy in @p storage.
  *
- * @return a clone of the instance.
+ * @param[in] storage   uninitialized storage for the copy.
  *
  * @exception std::bad_alloc    if memory allocation fails.
  */
@@ -107,36 +111,125 @@ openvrml::field_value::counted_impl_base::clone() const OPENVRML_THROW1(std::bad
 /**
  * @internal
  *
- * @class openvrml::field_value::counted_impl openvrml/field_value.h
+ * @class openvrml::field_value::inline_impl openvrml/field_value.h
+ *
+ * @brief Storage for small values that are cheap to copy.
  *
- * @brief Concrete reference-counted implementation.
+ * The value is held directly in the @c field_value; copying a
+ * @c field_value copies the value.  Used for the scalar and vector @c SF*
+ * types and for @c sfnode.
  *
  * @tparam ValueType    a @link FieldValueConcept Field Value@endlink
  *                      @c value_type.
  */
 
 /**
- * @var boost::shared_mutex openvrml::field_value::counted_impl::mutex_
+ * @var ValueType openvrml::field_value::inline_impl::value_
  *
- * @brief Mutex protecting @c #value_.
+ * @brief The value.
  */
 
 /**
- * @var boost::shared_ptr<ValueType> openvrml::field_value::counted_impl::value_
+ * @fn openvrml::field_value::inline_impl::inline_impl(const ValueType & value)
  *
- * @brief A @c shared_ptr to an instance of the @c value_type of a
- *        @link openvrml::FieldValueConcept Field Value@endlink.
+ * @brief Construct.
  *
- * @sa http://boost.org/libs/smart_ptr/shared_ptr.htm
+ * @param[in] value initial value.
  */
 
 /**
- * @fn openvrml::field_value::counted_impl::counted_impl(const ValueType & value)
+ * @fn openvrml::field_value::inline_impl::~inline_impl()
  *
- * @brief Construct.
+ * @brief Destroy.
+ */
+
+/**
+ * @fn const ValueType & openvrml::field_value::inline_impl::value() const
+ *
+ * @brief Access.
+ *
+ * @return the value.
+ */
+
+/**
+ * @fn void openvrml::field_value::inline_impl::value(const ValueType & val)
+ *
+ * @brief Mutate.
+ *
+ * @param[in] val   the new value.
+ */
+
+/**
+ * @fn void openvrml::field_value::inline_impl::swap(inline_impl<ValueType> & impl)
+ *
+ * @brief Swap.
+ *
+ * @param[in,out] impl  the instance to swap with this one.
+ */
+
+/**
+ * @fn void openvrml::field_value::inline_impl::do_clone(void * storage) const
+ *
+ * @brief Construct a copy in @p storage.
+ *
+ * @param[in] storage   uninitialized storage for the copy.
+ */
+
+/**
+ * @internal
+ *
+ * @class openvrml::field_value::counted_impl openvrml/field_value.h
+ *
+ * @brief Copy-on-write storage for values that are expensive to copy.
+ *
+ * The value is held in a reference-counted heap object shared between
+ * copies; it is copied only when a shared value is mutated.  The reference
+ * count is atomic; no lock is taken to copy or read the value.
  *
  * @tparam ValueType    a @link FieldValueConcept Field Value@endlink
  *                      @c value_type.
+ */
+
+/**
+ * @internal
+ *
+ * @class openvrml::field_value::counted_impl::counted_value openvrml/field_value.h
+ *
+ * @brief A reference-counted value.
+ */
+
+/**
+ * @var boost::detail::atomic_count openvrml::field_value::counted_impl::counted_value::count
+ *
+ * @brief The number of @c counted_impl instances sharing the value.
+ */
+
+/**
+ * @var ValueType openvrml::field_value::counted_impl::counted_value::value
+ *
+ * @brief The value.
+ */
+
+/**
+ * @fn openvrml::field_value::counted_impl::counted_value::counted_value(const ValueType & val)
+ *
+ * @brief Construct with a reference count of 1.
+ *
+ * @param[in] val   initial value.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+
+/**
+ * @var openvrml::field_value::counted_impl::counted_value * openvrml::field_value::counted_impl::value_
+ *
+ * @brief The shared value.
+ */
+
+/**
+ * @fn openvrml::field_value::counted_impl::counted_impl(const ValueType & value)
+ *
+ * @brief Construct.
  *
  * @param[in] value initial value.
  *
@@ -148,8 +241,7 @@ openvrml::field_value::counted_impl_base::clone() const OPENVRML_THROW1(std::bad
  *
  * @brief Construct a copy.
  *
- * @tparam ValueType    a @link FieldValueConcept Field Value@endlink
- *                      @c value_type.
+ * The copy shares the value of @p ci.
  *
  * @param[in] ci    the instance to copy.
  */
@@ -159,14 +251,17 @@ openvrml::field_value::counted_impl_base::clone() const OPENVRML_THROW1(std::bad
  *
  * @brief Destroy.
  *
- * @tparam ValueType    a @link FieldValueConcept Field Value@endlink
- *                      @c value_type.
+ * The shared value is destroyed when the last reference is released.
  */
 
 /**
- * @fn openvrml::field_value::counted_impl<ValueType> & openvrml::field_value::counted_impl::operator=(const counted_impl<ValueType> &)
+ * @fn openvrml::field_value::counted_impl<ValueType> & openvrml::field_value::counted_impl::operator=(const counted_impl<ValueType> & ci)
+ *
+ * @brief Assign.
  *
- * @brief Not implemented.
+ * @param[in] ci    the instance to share a value with.
+ *
+ * @return a reference to the instance.
  */
 
 /**
@@ -174,9 +269,6 @@ openvrml::field_value::counted_impl_base::clone() const OPENVRML_THROW1(std::bad
  *
  * @brief Access.
  *
- * @tparam ValueType    a @link FieldValueConcept Field Value@endlink
- *                      @c value_type.
- *
  * @return the value.
  */
 
@@ -185,8 +277,8 @@ openvrml::field_value::counted_impl_base::clone() const OPENVRML_THROW1(std::bad
  *
  * @brief Mutate.
  *
- * @tparam ValueType    a @link FieldValueConcept Field Value@endlink
- *                      @c value_type.
+ * If the value is shared, a new value is allocated; otherwise it is
+ * assigned in place.
  *
  * @param[in] val   the new value.
  *
@@ -194,24 +286,57 @@ openvrml::field_value::counted_impl_base::clone() const OPENVRML_THROW1(std::bad
  */
 
 /**
- * @fn std::auto_ptr<openvrml::field_value::counted_impl_base> openvrml::field_value::counted_impl::do_clone() const
+ * @fn void openvrml::field_value::counted_impl::swap(counted_impl<ValueType> & impl)
  *
- * @brief Polymorphically construct a copy.
+ * @brief Swap.
+ *
+ * @param[in,out] impl  the instance to swap with this one.
+ */
+
+/**
+ * @fn void openvrml::field_value::counted_impl::do_clone(void * storage) const
+ *
+ * @brief Construct a copy in @p storage.
+ *
+ * @param[in] storage   uninitialized storage for the copy.
+ */
+
+/**
+ * @internal
+ *
+ * @struct openvrml::field_value::impl_type openvrml/field_value.h
+ *
+ * @brief Select the storage implementation for a @c value_type.
+ *
+ * @c counted_impl by default; specialized to @c inline_impl for the small
+ * value types.
  *
  * @tparam ValueType    a @link FieldValueConcept Field Value@endlink
  *                      @c value_type.
+ */
+
+/**
+ * @internal
  *
- * @return a clone of the instance.
+ * @var openvrml::field_value::storage_
  *
- * @exception std::bad_alloc    if memory allocation fails.
+ * @brief Storage for the @c impl_base instance.
  */
 
 /**
- * @internal
+ * @fn openvrml::field_value::impl_base & openvrml::field_value::impl()
+ *
+ * @brief The storage implementation.
+ *
+ * @return the storage implementation.
+ */
+
+/**
+ * @fn const openvrml::field_value::impl_base & openvrml::field_value::impl() const
  *
- * @var std::auto_ptr<openvrml::field_value::counted_impl_base> openvrml::field_value::counted_impl_
+ * @brief The storage implementation.
  *
- * @brief Reference-counted implementation.
+ * @return the storage implementation.
  */
 
 /**
@@ -482,16 +607,19 @@ openvrml::field_value::create(const type_id type)
  * @exception std::bad_alloc    if memory allocation fails.
  */
 openvrml::field_value::field_value(const field_value & fv)
-    OPENVRML_THROW1(std::bad_alloc):
-    counted_impl_(fv.counted_impl_->clone())
-{}
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    fv.impl().clone(&this->storage_);
+}
 
 
 /**
  * @brief Destroy.
  */
 openvrml::field_value::~field_value() OPENVRML_NOTHROW
-{}
+{
+    this->impl().~impl_base();
+}
 
 /**
  * @fn FieldValue & openvrml::field_value::operator=(const FieldValue & fv)
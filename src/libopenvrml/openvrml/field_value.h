@@ -23,20 +23,26 @@
 #   define OPENVRML_FIELD_VALUE_H
 
 #   include <memory>
+#   include <new>
 #   include <string>
 #   include <typeinfo>
+#   include <boost/aligned_storage.hpp>
 #   include <boost/cast.hpp>
 #   include <boost/concept_check.hpp>
 #   include <boost/intrusive_ptr.hpp>
 #   include <boost/scoped_ptr.hpp>
 #   include <boost/shared_ptr.hpp>
+#   include <boost/static_assert.hpp>
+#   include <boost/type_traits/alignment_of.hpp>
 #   include <boost/utility.hpp>
 #   include <boost/thread.hpp>
+#   include <boost/detail/atomic_count.hpp>
 #   include <openvrml/basetypes.h>
 
 namespace openvrml {
 
     class field_value;
+    class node;
 
     OPENVRML_API std::ostream & operator<<(std::ostream & out,
                                            const field_value & value);
@@ -46,21 +52,44 @@ namespace openvrml {
         operator<<(std::ostream & out, const field_value & value);
 
     protected:
-        class counted_impl_base {
+        class impl_base {
         public:
-            virtual ~counted_impl_base() OPENVRML_NOTHROW;
-            std::auto_ptr<counted_impl_base> clone() const
-                OPENVRML_THROW1(std::bad_alloc);
+            virtual ~impl_base() OPENVRML_NOTHROW;
+            void clone(void * storage) const OPENVRML_THROW1(std::bad_alloc);
 
         private:
-            virtual std::auto_ptr<counted_impl_base> do_clone() const
+            virtual void do_clone(void * storage) const
                 OPENVRML_THROW1(std::bad_alloc) = 0;
         };
 
         template <typename ValueType>
-        class counted_impl : public counted_impl_base {
-            mutable boost::shared_mutex mutex_;
-            boost::shared_ptr<ValueType> value_;
+        class inline_impl : public impl_base {
+            ValueType value_;
+
+        public:
+            explicit inline_impl(const ValueType & value) OPENVRML_NOTHROW;
+            virtual ~inline_impl() OPENVRML_NOTHROW;
+
+            const ValueType & value() const OPENVRML_NOTHROW;
+            void value(const ValueType & val) OPENVRML_NOTHROW;
+            void swap(inline_impl<ValueType> & impl) OPENVRML_NOTHROW;
+
+        private:
+            virtual void do_clone(void * storage) const
+                OPENVRML_THROW1(std::bad_alloc);
+        };
+
+        template <typename ValueType>
+        class counted_impl : public impl_base {
+            struct counted_value : boost::noncopyable {
+                boost::detail::atomic_count count;
+                ValueType value;
+
+                explicit counted_value(const ValueType & val)
+                    OPENVRML_THROW1(std::bad_alloc);
+            };
+
+            counted_value * value_;
 
         public:
             explicit counted_impl(const ValueType & value)
@@ -68,19 +97,35 @@ namespace openvrml {
             counted_impl(const counted_impl<ValueType> & ci) OPENVRML_NOTHROW;
             virtual ~counted_impl() OPENVRML_NOTHROW;
 
+            counted_impl<ValueType> &
+            operator=(const counted_impl<ValueType> & ci) OPENVRML_NOTHROW;
+
             const ValueType & value() const OPENVRML_NOTHROW;
             void value(const ValueType & val) OPENVRML_THROW1(std::bad_alloc);
+            void swap(counted_impl<ValueType> & impl) OPENVRML_NOTHROW;
 
         private:
-            counted_impl<ValueType> &
-            operator=(const counted_impl<ValueType> &);
-
-            virtual std::auto_ptr<counted_impl_base> do_clone() const
+            virtual void do_clone(void * storage) const
                 OPENVRML_THROW1(std::bad_alloc);
         };
 
+        template <typename ValueType>
+        struct impl_type {
+            typedef counted_impl<ValueType> type;
+        };
+
     private:
-        boost::scoped_ptr<counted_impl_base> counted_impl_;
+        boost::aligned_storage<32, boost::alignment_of<double>::value>::type
+            storage_;
+
+        impl_base & impl() OPENVRML_NOTHROW;
+        const impl_base & impl() const OPENVRML_NOTHROW;
+
+        template <typename ValueType>
+        typename impl_type<ValueType>::type & impl() OPENVRML_NOTHROW;
+        template <typename ValueType>
+        const typename impl_type<ValueType>::type & impl() const
+            OPENVRML_NOTHROW;
 
     public:
         enum type_id {
@@ -164,76 +209,188 @@ namespace openvrml {
         virtual void print(std::ostream & out) const = 0;
     };
 
+    template <typename ValueType>
+    field_value::inline_impl<ValueType>::
+    inline_impl(const ValueType & value) OPENVRML_NOTHROW:
+        value_(value)
+    {}
+
+    template <typename ValueType>
+    field_value::inline_impl<ValueType>::~inline_impl() OPENVRML_NOTHROW
+    {}
+
+    template <typename ValueType>
+    const ValueType & field_value::inline_impl<ValueType>::value() const
+        OPENVRML_NOTHROW
+    {
+        return this->value_;
+    }
+
+    template <typename ValueType>
+    void field_value::inline_impl<ValueType>::value(const ValueType & val)
+        OPENVRML_NOTHROW
+    {
+        this->value_ = val;
+    }
+
+    template <typename ValueType>
+    void
+    field_value::inline_impl<ValueType>::swap(inline_impl<ValueType> & impl)
+        OPENVRML_NOTHROW
+    {
+        using std::swap;
+        swap(this->value_, impl.value_);
+    }
+
+    template <typename ValueType>
+    void field_value::inline_impl<ValueType>::do_clone(void * const storage)
+        const OPENVRML_THROW1(std::bad_alloc)
+    {
+        new (storage) inline_impl<ValueType>(*this);
+    }
+
+    template <typename ValueType>
+    field_value::counted_impl<ValueType>::counted_value::
+    counted_value(const ValueType & val) OPENVRML_THROW1(std::bad_alloc):
+        count(1),
+        value(val)
+    {}
+
     template <typename ValueType>
     field_value::counted_impl<ValueType>::
     counted_impl(const ValueType & value) OPENVRML_THROW1(std::bad_alloc):
-        value_(new ValueType(value))
+        value_(new counted_value(value))
     {}
 
     template <typename ValueType>
     field_value::counted_impl<ValueType>::
     counted_impl(const counted_impl<ValueType> & ci) OPENVRML_NOTHROW:
-        counted_impl_base()
+        impl_base(),
+        value_(ci.value_)
     {
-        using boost::shared_lock;
-        using boost::shared_mutex;
-        shared_lock<shared_mutex> lock(ci.mutex_);
-        value_ = ci.value_;
+        assert(this->value_);
+        ++this->value_->count;
     }
 
     template <typename ValueType>
     field_value::counted_impl<ValueType>::~counted_impl() OPENVRML_NOTHROW
-    {}
+    {
+        assert(this->value_);
+        if (--this->value_->count == 0) { delete this->value_; }
+    }
+
+    template <typename ValueType>
+    field_value::counted_impl<ValueType> &
+    field_value::counted_impl<ValueType>::
+    operator=(const counted_impl<ValueType> & ci) OPENVRML_NOTHROW
+    {
+        counted_impl<ValueType> temp(ci);
+        this->swap(temp);
+        return *this;
+    }
 
     template <typename ValueType>
     const ValueType & field_value::counted_impl<ValueType>::value() const
         OPENVRML_NOTHROW
     {
-        using boost::shared_lock;
-        using boost::shared_mutex;
-        shared_lock<shared_mutex> lock(this->mutex_);
         assert(this->value_);
-        return *this->value_;
+        return this->value_->value;
     }
 
     template <typename ValueType>
     void field_value::counted_impl<ValueType>::value(const ValueType & val)
         OPENVRML_THROW1(std::bad_alloc)
     {
-        using boost::unique_lock;
-        using boost::shared_mutex;
-        unique_lock<shared_mutex> lock(this->mutex_);
         assert(this->value_);
-        if (!this->value_.unique()) {
-            this->value_.reset(new ValueType(val));
+        if (this->value_->count == 1) {
+            this->value_->value = val;
         } else {
-            *this->value_ = val;
+            counted_impl<ValueType> temp(val);
+            this->swap(temp);
         }
     }
 
     template <typename ValueType>
-    std::auto_ptr<field_value::counted_impl_base>
-    field_value::counted_impl<ValueType>::do_clone() const
-        OPENVRML_THROW1(std::bad_alloc)
+    void
+    field_value::counted_impl<ValueType>::swap(counted_impl<ValueType> & impl)
+        OPENVRML_NOTHROW
     {
-        return std::auto_ptr<counted_impl_base>(
-            new counted_impl<ValueType>(*this));
+        std::swap(this->value_, impl.value_);
+    }
+
+    template <typename ValueType>
+    void field_value::counted_impl<ValueType>::do_clone(void * const storage)
+        const OPENVRML_THROW1(std::bad_alloc)
+    {
+        new (storage) counted_impl<ValueType>(*this);
+    }
+
+#   define OPENVRML_FIELD_VALUE_INLINE_IMPL_(value_type_)     \
+    template <>                                                 \
+    struct field_value::impl_type<value_type_ > {               \
+        typedef inline_impl<value_type_ > type;                 \
+    };
+
+    OPENVRML_FIELD_VALUE_INLINE_IMPL_(bool)
+    OPENVRML_FIELD_VALUE_INLINE_IMPL_(color)
+    OPENVRML_FIELD_VALUE_INLINE_IMPL_(color_rgba)
+    OPENVRML_FIELD_VALUE_INLINE_IMPL_(float)
+    OPENVRML_FIELD_VALUE_INLINE_IMPL_(double)
+    OPENVRML_FIELD_VALUE_INLINE_IMPL_(int32)
+    OPENVRML_FIELD_VALUE_INLINE_IMPL_(rotation)
+    OPENVRML_FIELD_VALUE_INLINE_IMPL_(vec2f)
+    OPENVRML_FIELD_VALUE_INLINE_IMPL_(vec2d)
+    OPENVRML_FIELD_VALUE_INLINE_IMPL_(vec3f)
+    OPENVRML_FIELD_VALUE_INLINE_IMPL_(vec3d)
+    OPENVRML_FIELD_VALUE_INLINE_IMPL_(boost::intrusive_ptr<node>)
+
+#   undef OPENVRML_FIELD_VALUE_INLINE_IMPL_
+
+    inline field_value::impl_base & field_value::impl() OPENVRML_NOTHROW
+    {
+        return *static_cast<impl_base *>(
+            static_cast<void *>(&this->storage_));
+    }
+
+    inline const field_value::impl_base & field_value::impl() const
+        OPENVRML_NOTHROW
+    {
+        return *static_cast<const impl_base *>(
+            static_cast<const void *>(&this->storage_));
+    }
+
+    template <typename ValueType>
+    typename field_value::impl_type<ValueType>::type &
+    field_value::impl() OPENVRML_NOTHROW
+    {
+        return *boost::polymorphic_downcast<
+            typename impl_type<ValueType>::type *>(&this->impl());
+    }
+
+    template <typename ValueType>
+    const typename field_value::impl_type<ValueType>::type &
+    field_value::impl() const OPENVRML_NOTHROW
+    {
+        return *boost::polymorphic_downcast<
+            const typename impl_type<ValueType>::type *>(&this->impl());
     }
 
     template <typename ValueType>
     field_value::field_value(const ValueType & value,
                              const value_type_constructor_tag &)
-        OPENVRML_THROW1(std::bad_alloc):
-        counted_impl_(new counted_impl<ValueType>(value))
-    {}
+        OPENVRML_THROW1(std::bad_alloc)
+    {
+        typedef typename impl_type<ValueType>::type impl_t;
+        BOOST_STATIC_ASSERT(sizeof (impl_t) <= sizeof (storage_));
+        new (&this->storage_) impl_t(value);
+    }
 
     template <typename FieldValue>
     FieldValue & field_value::operator=(const FieldValue & fv)
         OPENVRML_THROW1(std::bad_alloc)
     {
-        if (this != &fv) {
-            counted_impl_.reset(fv.counted_impl_->clone().release());
-        }
+        typedef typename FieldValue::value_type value_type;
+        this->impl<value_type>() = fv.template impl<value_type>();
         return *boost::polymorphic_downcast<FieldValue *>(this);
     }
 
@@ -241,26 +398,21 @@ namespace openvrml {
     const typename FieldValue::value_type & field_value::value() const
         OPENVRML_NOTHROW
     {
-        assert(this->counted_impl_.get());
-        return boost::polymorphic_downcast<
-        counted_impl<typename FieldValue::value_type> *>(
-            this->counted_impl_.get())->value();
+        return this->impl<typename FieldValue::value_type>().value();
     }
 
     template <typename FieldValue>
     void field_value::value(const typename FieldValue::value_type & val)
         OPENVRML_THROW1(std::bad_alloc)
     {
-        assert(this->counted_impl_.get());
-        boost::polymorphic_downcast<
-        counted_impl<typename FieldValue::value_type> *>(
-            this->counted_impl_.get())->value(val);
+        this->impl<typename FieldValue::value_type>().value(val);
     }
 
     template <typename FieldValue>
     void field_value::swap(FieldValue & val) OPENVRML_NOTHROW
     {
-        this->counted_impl_.swap(val.counted_impl_);
+        typedef typename FieldValue::value_type value_type;
+        this->impl<value_type>().swap(val.template impl<value_type>());
     }
 
     OPENVRML_API std::ostream & operator<<(std::ostream & out,
@@ -532,7 +684,6 @@ namespace openvrml {
         OPENVRML_NOTHROW;
 
 
-    class node;
     void intrusive_ptr_add_ref(const node *) OPENVRML_NOTHROW;
     void intrusive_ptr_release(const node *) OPENVRML_NOTHROW;
 
@@ -0,0 +1,173 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# include "buffer_streambuf.h"
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+/**
+ * @internal
+ *
+ * @class openvrml::local::buffer_streambuf openvrml/local/buffer_streambuf.h
+ *
+ * @brief Abstract base for a read-only @c std::streambuf whose get area
+ *        covers an entire resource held contiguously in memory.
+ *
+ * Since @c underflow is never needed, the data can be handed to a parser or
+ * a @c stream_listener without copying it.  See @c contiguous_buffer.
+ */
+
+/**
+ * @brief Construct.
+ *
+ * The get area is initially empty.
+ */
+openvrml::local::buffer_streambuf::buffer_streambuf() OPENVRML_NOTHROW
+{}
+
+/**
+ * @brief Destroy.
+ */
+openvrml::local::buffer_streambuf::~buffer_streambuf() OPENVRML_NOTHROW
+{}
+
+/**
+ * @brief Set the buffer.
+ *
+ * The buffer is never written through.
+ *
+ * @param[in] begin the beginning of the buffer.
+ * @param[in] end   the end of the buffer.
+ */
+void openvrml::local::buffer_streambuf::buffer(const char * const begin,
+                                               const char * const end)
+    OPENVRML_NOTHROW
+{
+    char * const first = const_cast<char *>(begin);
+    this->setg(first, first, first + (end - begin));
+}
+
+/**
+ * @brief The unread part of the buffer.
+ *
+ * @return a pointer to the current read position.
+ */
+const char * openvrml::local::buffer_streambuf::data() const OPENVRML_NOTHROW
+{
+    return this->gptr();
+}
+
+/**
+ * @brief The number of unread characters.
+ *
+ * @return the number of characters between @c #data and the end of the
+ *         buffer.
+ */
+std::size_t openvrml::local::buffer_streambuf::size() const OPENVRML_NOTHROW
+{
+    return this->egptr() - this->gptr();
+}
+
+/**
+ * @brief The number of characters that can be read without blocking.
+ *
+ * @return the number of unread characters, or -1 at the end of the buffer.
+ */
+std::streamsize openvrml::local::buffer_streambuf::showmanyc()
+{
+    const std::streamsize n = this->egptr() - this->gptr();
+    return (n > 0) ? n : -1;
+}
+
+/**
+ * @brief Reposition the read position relative to @p way.
+ *
+ * @param[in] off   offset.
+ * @param[in] way   the position @p off is relative to.
+ * @param[in] which must include @c std::ios_base::in.
+ *
+ * @return the new position, or -1 on failure.
+ */
+openvrml::local::buffer_streambuf::pos_type
+openvrml::local::buffer_streambuf::
+seekoff(const off_type off,
+        const std::ios_base::seekdir way,
+        const std::ios_base::openmode which)
+{
+    const off_type error = -1;
+    if (!(which & std::ios_base::in)) { return pos_type(error); }
+    off_type base;
+    switch (way) {
+    case std::ios_base::beg:
+        base = 0;
+        break;
+    case std::ios_base::cur:
+        base = this->gptr() - this->eback();
+        break;
+    case std::ios_base::end:
+        base = this->egptr() - this->eback();
+        break;
+    default:
+        return pos_type(error);
+    }
+    const off_type pos = base + off;
+    if (pos < 0 || pos > this->egptr() - this->eback()) {
+        return pos_type(error);
+    }
+    this->setg(this->eback(), this->eback() + pos, this->egptr());
+    return pos_type(pos);
+}
+
+/**
+ * @brief Reposition the read position.
+ *
+ * @param[in] pos   the new position.
+ * @param[in] which must include @c std::ios_base::in.
+ *
+ * @return the new position, or -1 on failure.
+ */
+openvrml::local::buffer_streambuf::pos_type
+openvrml::local::buffer_streambuf::
+seekpos(const pos_type pos, const std::ios_base::openmode which)
+{
+    return this->seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+
+/**
+ * @internal
+ *
+ * @brief The in-memory buffer underlying a stream, if there is one.
+ *
+ * This allows a reader to consume a memory-mapped file or a cached resource
+ * in place.
+ *
+ * @param[in] in    an input stream.
+ *
+ * @return the @c buffer_streambuf underlying @p in, or 0 if @p in is not
+ *         reading from one.
+ */
+const openvrml::local::buffer_streambuf *
+openvrml::local::contiguous_buffer(const std::istream & in) OPENVRML_NOTHROW
+{
+    return dynamic_cast<const buffer_streambuf *>(in.rdbuf());
+}
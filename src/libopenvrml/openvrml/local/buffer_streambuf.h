@@ -0,0 +1,60 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# ifndef OPENVRML_LOCAL_BUFFER_STREAMBUF_H
+#   define OPENVRML_LOCAL_BUFFER_STREAMBUF_H
+
+#   include <openvrml-common.h>
+#   include <boost/utility.hpp>
+#   include <istream>
+#   include <streambuf>
+
+namespace openvrml {
+
+    namespace local {
+
+        class OPENVRML_LOCAL buffer_streambuf : public std::streambuf,
+                                                boost::noncopyable {
+        public:
+            virtual ~buffer_streambuf() OPENVRML_NOTHROW = 0;
+
+            const char * data() const OPENVRML_NOTHROW;
+            std::size_t size() const OPENVRML_NOTHROW;
+
+        protected:
+            buffer_streambuf() OPENVRML_NOTHROW;
+
+            void buffer(const char * begin, const char * end)
+                OPENVRML_NOTHROW;
+
+            virtual std::streamsize showmanyc();
+            virtual pos_type seekoff(off_type off,
+                                     std::ios_base::seekdir way,
+                                     std::ios_base::openmode which);
+            virtual pos_type seekpos(pos_type pos,
+                                     std::ios_base::openmode which);
+        };
+
+        OPENVRML_LOCAL const buffer_streambuf *
+        contiguous_buffer(const std::istream & in) OPENVRML_NOTHROW;
+    }
+}
+
+# endif // ifndef OPENVRML_LOCAL_BUFFER_STREAMBUF_H
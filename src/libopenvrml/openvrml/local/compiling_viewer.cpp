@@ -0,0 +1,226 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# include "compiling_viewer.h"
+# include <openvrml/compiled_mesh.h>
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+/**
+ * @internal
+ *
+ * @class openvrml::local::compiling_viewer openvrml/local/compiling_viewer.h
+ *
+ * @brief A @c viewer that draws nothing; the meshes it is given are
+ *        compiled into a @c compiled_mesh_cache the same way
+ *        @c openvrml::gl::viewer compiles them.
+ *
+ * A geometry node that already has a mesh in the cache is not compiled
+ * again.  Line and point sets are not compiled meshes, and are ignored.
+ */
+
+/**
+ * @var openvrml::compiled_mesh_cache & openvrml::local::compiling_viewer::cache_
+ *
+ * @brief The cache the meshes are added to.
+ */
+
+/**
+ * @var boost::shared_ptr<const openvrml::compiled_mesh> openvrml::local::compiling_viewer::mesh_
+ *
+ * @brief The mesh of the geometry node last inserted.
+ */
+
+/**
+ * @brief Construct.
+ *
+ * @param[in,out] cache the cache the meshes are added to.
+ */
+openvrml::local::compiling_viewer::
+compiling_viewer(compiled_mesh_cache & cache) OPENVRML_NOTHROW:
+    cache_(cache)
+{}
+
+/**
+ * @brief Destroy.
+ */
+openvrml::local::compiling_viewer::~compiling_viewer() OPENVRML_NOTHROW
+{}
+
+/**
+ * @brief The mesh of the geometry node last inserted.
+ *
+ * @return the mesh of the geometry node last inserted, whether it was
+ *         compiled or found in the cache; or a null pointer if no node has
+ *         been inserted, or if compiling it failed.
+ */
+const boost::shared_ptr<const openvrml::compiled_mesh> &
+openvrml::local::compiling_viewer::mesh() const OPENVRML_NOTHROW
+{
+    return this->mesh_;
+}
+
+/**
+ * @brief Find the mesh for a node in the cache.
+ *
+ * @param[in] n a geometry node.
+ *
+ * @return @c true if @p n has a mesh in the cache; @c false otherwise.
+ */
+bool openvrml::local::compiling_viewer::find(const geometry_node & n)
+    OPENVRML_NOTHROW
+{
+    this->mesh_ = this->cache_.find(n);
+    return !!this->mesh_;
+}
+
+/**
+ * @brief Add a newly compiled mesh to the cache.
+ *
+ * @param[in] n     a geometry node.
+ * @param[in] mesh  the mesh compiled for @p n.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void
+openvrml::local::compiling_viewer::
+insert(const geometry_node & n, const boost::shared_ptr<compiled_mesh> & mesh)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    this->cache_.insert(n, mesh);
+    this->mesh_ = mesh;
+}
+
+void
+openvrml::local::compiling_viewer::do_insert_box(const geometry_node & n,
+                                                 const vec3f & size)
+{
+    if (this->find(n)) { return; }
+    const boost::shared_ptr<compiled_mesh> mesh(new compiled_mesh);
+    compile_box(size, *mesh);
+    this->insert(n, mesh);
+}
+
+void
+openvrml::local::compiling_viewer::do_insert_cone(const geometry_node & n,
+                                                  const float height,
+                                                  const float radius,
+                                                  const bool bottom,
+                                                  const bool side)
+{
+    if (this->find(n)) { return; }
+    const boost::shared_ptr<compiled_mesh> mesh(new compiled_mesh);
+    compile_cone(height, radius, bottom, side, *mesh);
+    this->insert(n, mesh);
+}
+
+void
+openvrml::local::compiling_viewer::
+do_insert_cylinder(const geometry_node & n,
+                   const float height,
+                   const float radius,
+                   const bool bottom,
+                   const bool side,
+                   const bool top)
+{
+    if (this->find(n)) { return; }
+    const boost::shared_ptr<compiled_mesh> mesh(new compiled_mesh);
+    compile_cylinder(height, radius, bottom, side, top, *mesh);
+    this->insert(n, mesh);
+}
+
+void
+openvrml::local::compiling_viewer::
+do_insert_elevation_grid(const geometry_node & n,
+                         const unsigned int mask,
+                         const std::vector<float> & height,
+                         const int32 x_dimension,
+                         const int32 z_dimension,
+                         const float x_spacing,
+                         const float z_spacing,
+                         const std::vector<color> & color,
+                         const std::vector<vec3f> & normal,
+                         const std::vector<vec2f> & tex_coord)
+{
+    if (this->find(n)) { return; }
+    const boost::shared_ptr<compiled_mesh> mesh(new compiled_mesh);
+    compile_elevation_grid(mask,
+                           height,
+                           x_dimension,
+                           z_dimension,
+                           x_spacing,
+                           z_spacing,
+                           color,
+                           normal,
+                           tex_coord,
+                           *mesh);
+    this->insert(n, mesh);
+}
+
+void
+openvrml::local::compiling_viewer::
+do_insert_extrusion(const geometry_node & n,
+                    const unsigned int mask,
+                    const std::vector<vec3f> & spine,
+                    const std::vector<vec2f> & cross_section,
+                    const std::vector<rotation> & orientation,
+                    const std::vector<vec2f> & scale)
+{
+    if (this->find(n)) { return; }
+    const boost::shared_ptr<compiled_mesh> mesh(new compiled_mesh);
+    compile_extrusion(mask, spine, cross_section, orientation, scale, *mesh);
+    this->insert(n, mesh);
+}
+
+void
+openvrml::local::compiling_viewer::
+do_insert_shell(const geometry_node & n,
+                const unsigned int mask,
+                const std::vector<vec3f> & coord,
+                const std::vector<int32> & coord_index,
+                const std::vector<color> & color,
+                const std::vector<int32> & color_index,
+                const std::vector<vec3f> & normal,
+                const std::vector<int32> & normal_index,
+                const std::vector<vec2f> & tex_coord,
+                const std::vector<int32> & tex_coord_index)
+{
+    if (this->find(n)) { return; }
+    const boost::shared_ptr<compiled_mesh> mesh(new compiled_mesh);
+    compile_shell(mask,
+                  coord, coord_index,
+                  color, color_index,
+                  normal, normal_index,
+                  tex_coord, tex_coord_index,
+                  *mesh);
+    this->insert(n, mesh);
+}
+
+void
+openvrml::local::compiling_viewer::do_insert_sphere(const geometry_node & n,
+                                                    const float radius)
+{
+    if (this->find(n)) { return; }
+    const boost::shared_ptr<compiled_mesh> mesh(new compiled_mesh);
+    compile_sphere(radius, *mesh);
+    this->insert(n, mesh);
+}
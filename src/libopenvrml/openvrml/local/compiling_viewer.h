@@ -0,0 +1,102 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# ifndef OPENVRML_LOCAL_COMPILING_VIEWER_H
+#   define OPENVRML_LOCAL_COMPILING_VIEWER_H
+
+#   include "null_viewer.h"
+#   include <boost/shared_ptr.hpp>
+
+namespace openvrml {
+
+    class compiled_mesh;
+    class compiled_mesh_cache;
+
+    namespace local {
+
+        class OPENVRML_LOCAL compiling_viewer : public null_viewer {
+            compiled_mesh_cache & cache_;
+            boost::shared_ptr<const compiled_mesh> mesh_;
+
+        public:
+            explicit compiling_viewer(compiled_mesh_cache & cache)
+                OPENVRML_NOTHROW;
+            virtual ~compiling_viewer() OPENVRML_NOTHROW;
+
+            const boost::shared_ptr<const compiled_mesh> & mesh() const
+                OPENVRML_NOTHROW;
+
+        private:
+            virtual void do_insert_box(const geometry_node & n,
+                                       const vec3f & size);
+            virtual void do_insert_cone(const geometry_node & n,
+                                        float height,
+                                        float radius,
+                                        bool bottom,
+                                        bool side);
+            virtual void do_insert_cylinder(const geometry_node & n,
+                                            float height,
+                                            float radius,
+                                            bool bottom,
+                                            bool side,
+                                            bool top);
+            virtual void
+            do_insert_elevation_grid(
+                const geometry_node & n,
+                unsigned int mask,
+                const std::vector<float> & height,
+                int32 x_dimension,
+                int32 z_dimension,
+                float x_spacing,
+                float z_spacing,
+                const std::vector<color> & color,
+                const std::vector<vec3f> & normal,
+                const std::vector<vec2f> & tex_coord);
+            virtual void
+            do_insert_extrusion(
+                const geometry_node & n,
+                unsigned int mask,
+                const std::vector<vec3f> & spine,
+                const std::vector<vec2f> & cross_section,
+                const std::vector<rotation> & orientation,
+                const std::vector<vec2f> & scale);
+            virtual void
+            do_insert_shell(const geometry_node & n,
+                            unsigned int mask,
+                            const std::vector<vec3f> & coord,
+                            const std::vector<int32> & coord_index,
+                            const std::vector<color> & color,
+                            const std::vector<int32> & color_index,
+                            const std::vector<vec3f> & normal,
+                            const std::vector<int32> & normal_index,
+                            const std::vector<vec2f> & tex_coord,
+                            const std::vector<int32> & tex_coord_index);
+            virtual void do_insert_sphere(const geometry_node & n,
+                                          float radius);
+
+            bool find(const geometry_node & n) OPENVRML_NOTHROW;
+            void insert(const geometry_node & n,
+                        const boost::shared_ptr<compiled_mesh> & mesh)
+                OPENVRML_THROW1(std::bad_alloc);
+        };
+    }
+}
+
+# endif // ifndef OPENVRML_LOCAL_COMPILING_VIEWER_H
@@ -0,0 +1,326 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# include "compute_executor.h"
+# include <boost/thread/tss.hpp>
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+namespace {
+
+    OPENVRML_LOCAL void no_cleanup(openvrml::local::compute_executor *)
+    {}
+
+    //
+    // The executor of the innermost compute_executor::scope on the calling
+    // thread, if any.
+    //
+    boost::thread_specific_ptr<openvrml::local::compute_executor>
+        current_executor(&no_cleanup);
+}
+
+/**
+ * @internal
+ *
+ * @class openvrml::local::compute_executor openvrml/local/compute_executor.h
+ *
+ * @brief Threads shared by the computations of a @c browser.
+ *
+ * Work that keeps the processors busy, such as compiling meshes and
+ * generating normals, is shared between the thread that wants it done and
+ * these threads, so that there is about one thread per processor however
+ * many such jobs are under way.  Loading resources, which is mostly waiting,
+ * is left to an @c io_executor.
+ *
+ * The threads are started when a job is first posted, and joined when the
+ * executor is destroyed.
+ */
+
+/**
+ * @var boost::mutex openvrml::local::compute_executor::mutex_
+ *
+ * @brief Mutex guarding the queue and the worker state.
+ */
+
+/**
+ * @var boost::condition_variable openvrml::local::compute_executor::work_available_
+ *
+ * @brief Signalled when a job is queued or the executor is stopping.
+ */
+
+/**
+ * @var std::deque<boost::function0<void> > openvrml::local::compute_executor::work_
+ *
+ * @brief The jobs waiting for a worker.
+ */
+
+/**
+ * @var boost::thread_group openvrml::local::compute_executor::workers_
+ *
+ * @brief The worker threads.
+ */
+
+/**
+ * @var const std::size_t openvrml::local::compute_executor::threads_
+ *
+ * @brief The number of worker threads to start.
+ */
+
+/**
+ * @var std::size_t openvrml::local::compute_executor::workers_started_
+ *
+ * @brief The number of worker threads started.
+ */
+
+/**
+ * @var bool openvrml::local::compute_executor::stopping_
+ *
+ * @brief Whether the executor is being destroyed.
+ */
+
+/**
+ * @brief The number of worker threads a @c browser's executor has by
+ *        default.
+ *
+ * The thread that posts the work takes part in it, so this is one fewer
+ * than the number of hardware threads.
+ *
+ * @return the default number of threads.
+ */
+std::size_t openvrml::local::compute_executor::default_threads()
+    OPENVRML_NOTHROW
+{
+    const std::size_t hardware_threads =
+        boost::thread::hardware_concurrency();
+    return hardware_threads > 1 ? hardware_threads - 1 : 0;
+}
+
+/**
+ * @brief The executor of the innermost @c compute_executor::scope on the
+ *        calling thread.
+ *
+ * @return the executor of the innermost @c compute_executor::scope on the
+ *         calling thread, or 0 if there is none; work done without one is
+ *         not split across threads.
+ */
+openvrml::local::compute_executor *
+openvrml::local::compute_executor::current() OPENVRML_NOTHROW
+{
+    return current_executor.get();
+}
+
+/**
+ * @brief Construct.
+ *
+ * No threads are started until a job is posted.
+ *
+ * @param[in] threads   the number of worker threads.  If it is 0, nothing is
+ *                      ever queued.
+ */
+openvrml::local::compute_executor::compute_executor(const std::size_t threads)
+    OPENVRML_NOTHROW:
+    threads_(threads),
+    workers_started_(0),
+    stopping_(false)
+{}
+
+/**
+ * @brief Destroy.
+ *
+ * Queued jobs are discarded; running jobs are waited for.
+ */
+openvrml::local::compute_executor::~compute_executor() OPENVRML_NOTHROW
+{
+    {
+        boost::mutex::scoped_lock lock(this->mutex_);
+        this->stopping_ = true;
+        this->work_.clear();
+    }
+    this->work_available_.notify_all();
+    this->workers_.join_all();
+}
+
+/**
+ * @brief The number of worker threads.
+ *
+ * @return the number of worker threads.
+ */
+std::size_t openvrml::local::compute_executor::threads() const
+    OPENVRML_NOTHROW
+{
+    return this->threads_;
+}
+
+/**
+ * @brief Queue copies of a job.
+ *
+ * The worker threads are started the first time a job is posted.  At most
+ * one copy per worker is queued; the caller is expected to do its share of
+ * the work and not to rely on any copy running.
+ *
+ * @param[in] job       the work.  It must not throw.
+ * @param[in] copies    the number of copies of @p job wanted.
+ *
+ * @return the number of copies queued.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+std::size_t
+openvrml::local::compute_executor::post(const boost::function0<void> & job,
+                                        const std::size_t copies)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    std::size_t posted;
+    {
+        boost::mutex::scoped_lock lock(this->mutex_);
+        if (this->workers_started_ == 0) {
+            try {
+                for (; this->workers_started_ < this->threads_;
+                     ++this->workers_started_) {
+                    this->workers_.create_thread(
+                        boost::bind(&compute_executor::work, this));
+                }
+            } catch (boost::thread_resource_error &) {
+                //
+                // Carry on with the workers we have.
+                //
+            }
+        }
+        posted = (std::min)(copies, this->workers_started_);
+        for (std::size_t i = 0; i < posted; ++i) {
+            this->work_.push_back(job);
+        }
+    }
+    this->work_available_.notify_all();
+    return posted;
+}
+
+/**
+ * @brief Run queued jobs until the executor is destroyed.
+ */
+void openvrml::local::compute_executor::work() OPENVRML_NOTHROW
+{
+    while (true) {
+        boost::function0<void> job;
+        {
+            boost::mutex::scoped_lock lock(this->mutex_);
+            while (this->work_.empty() && !this->stopping_) {
+                this->work_available_.wait(lock);
+            }
+            if (this->stopping_) { return; }
+            job.swap(this->work_.front());
+            this->work_.pop_front();
+        }
+        job();
+    }
+}
+
+/**
+ * @internal
+ *
+ * @class openvrml::local::compute_executor::scope openvrml/local/compute_executor.h
+ *
+ * @brief Makes a @c compute_executor the one used by work done on the
+ *        calling thread.
+ */
+
+/**
+ * @var openvrml::local::compute_executor * const openvrml::local::compute_executor::scope::enclosing_
+ *
+ * @brief The executor that was current on the thread when this scope was
+ *        constructed, if any.
+ */
+
+/**
+ * @brief Construct.
+ *
+ * @param[in] executor  the executor to use until the scope is destroyed.
+ */
+openvrml::local::compute_executor::scope::scope(compute_executor & executor)
+    OPENVRML_NOTHROW:
+    enclosing_(current_executor.get())
+{
+    current_executor.reset(&executor);
+}
+
+/**
+ * @brief Destroy.
+ */
+openvrml::local::compute_executor::scope::~scope() OPENVRML_NOTHROW
+{
+    current_executor.reset(this->enclosing_);
+}
+
+/**
+ * @internal
+ *
+ * @class openvrml::local::batch_queue openvrml/local/compute_executor.h
+ *
+ * @brief Hands out ranges of a job to the threads sharing it.
+ *
+ * @c Function is called with the beginning and end of each range; it must
+ * not throw.  A worker that gets to the queue after every batch has been
+ * handed out does not touch the @c Function, which may be gone by then.
+ */
+
+/**
+ * @fn openvrml::local::batch_queue<Function>::batch_queue(Function & function, std::size_t size, std::size_t batch_size)
+ *
+ * @brief Construct.
+ *
+ * @param[in] function      the function called for each batch.
+ * @param[in] size          the number of items.
+ * @param[in] batch_size    the number of items in a batch.
+ */
+
+/**
+ * @fn void openvrml::local::batch_queue<Function>::run()
+ *
+ * @brief Work on batches until none are left.
+ */
+
+/**
+ * @fn void openvrml::local::batch_queue<Function>::wait()
+ *
+ * @brief Wait for the batches that other threads are working on.
+ */
+
+/**
+ * @fn void openvrml::local::for_each_batch(compute_executor & executor, std::size_t size, std::size_t batch_size, std::size_t helpers, Function & function)
+ *
+ * @brief Call @p function for every item, sharing the work with the workers
+ *        of @p executor.
+ *
+ * The calling thread takes part in the work, and returns once every batch
+ * is done, whether or not any worker was free to help.  Copies of the work
+ * left in the queue are harmless; they find no batches left.
+ *
+ * @param[in,out] executor  the executor.
+ * @param[in] size          the number of items.
+ * @param[in] batch_size    the number of items in a batch.
+ * @param[in] helpers       the most workers to share the work with.
+ * @param[in] function      a function object called with a range of items.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ *
+ * @pre @p batch_size > 0.
+ */
@@ -0,0 +1,161 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# ifndef OPENVRML_LOCAL_COMPUTE_EXECUTOR_H
+#   define OPENVRML_LOCAL_COMPUTE_EXECUTOR_H
+
+#   include <openvrml-common.h>
+#   include <boost/bind.hpp>
+#   include <boost/function.hpp>
+#   include <boost/shared_ptr.hpp>
+#   include <boost/thread.hpp>
+#   include <boost/utility.hpp>
+#   include <algorithm>
+#   include <deque>
+
+namespace openvrml {
+
+    namespace local {
+
+        class OPENVRML_LOCAL compute_executor : boost::noncopyable {
+            boost::mutex mutex_;
+            boost::condition_variable work_available_;
+            std::deque<boost::function0<void> > work_;
+            boost::thread_group workers_;
+            const std::size_t threads_;
+            std::size_t workers_started_;
+            bool stopping_;
+
+        public:
+            class scope;
+
+            static std::size_t default_threads() OPENVRML_NOTHROW;
+            static compute_executor * current() OPENVRML_NOTHROW;
+
+            explicit compute_executor(std::size_t threads) OPENVRML_NOTHROW;
+            ~compute_executor() OPENVRML_NOTHROW;
+
+            std::size_t threads() const OPENVRML_NOTHROW;
+
+            std::size_t post(const boost::function0<void> & job,
+                             std::size_t copies)
+                OPENVRML_THROW1(std::bad_alloc);
+
+        private:
+            void work() OPENVRML_NOTHROW;
+        };
+
+
+        class OPENVRML_LOCAL compute_executor::scope : boost::noncopyable {
+            compute_executor * const enclosing_;
+
+        public:
+            explicit scope(compute_executor & executor) OPENVRML_NOTHROW;
+            ~scope() OPENVRML_NOTHROW;
+        };
+
+
+        template <typename Function>
+        class OPENVRML_LOCAL batch_queue : boost::noncopyable {
+            Function & function_;
+            const std::size_t size_;
+            const std::size_t batch_size_;
+            boost::mutex mutex_;
+            boost::condition_variable done_;
+            std::size_t next_;
+            std::size_t running_;
+
+        public:
+            batch_queue(Function & function,
+                        std::size_t size,
+                        std::size_t batch_size);
+
+            void run() OPENVRML_NOTHROW;
+            void wait() OPENVRML_NOTHROW;
+        };
+
+        template <typename Function>
+        batch_queue<Function>::batch_queue(Function & function,
+                                           const std::size_t size,
+                                           const std::size_t batch_size):
+            function_(function),
+            size_(size),
+            batch_size_(batch_size),
+            next_(0),
+            running_(0)
+        {}
+
+        template <typename Function>
+        void batch_queue<Function>::run() OPENVRML_NOTHROW
+        {
+            boost::mutex::scoped_lock lock(this->mutex_);
+            while (this->next_ < this->size_) {
+                const std::size_t begin = this->next_;
+                const std::size_t end =
+                    (std::min)(this->size_, begin + this->batch_size_);
+                this->next_ = end;
+                ++this->running_;
+                lock.unlock();
+                this->function_(begin, end);
+                lock.lock();
+                --this->running_;
+            }
+            if (this->running_ == 0) { this->done_.notify_all(); }
+        }
+
+        template <typename Function>
+        void batch_queue<Function>::wait() OPENVRML_NOTHROW
+        {
+            boost::mutex::scoped_lock lock(this->mutex_);
+            while (this->next_ < this->size_ || this->running_ > 0) {
+                this->done_.wait(lock);
+            }
+        }
+
+        template <typename Function>
+        void for_each_batch(compute_executor & executor,
+                            const std::size_t size,
+                            const std::size_t batch_size,
+                            const std::size_t helpers,
+                            Function & function)
+            OPENVRML_THROW1(std::bad_alloc)
+        {
+            const std::size_t batches = (size + batch_size - 1) / batch_size;
+            const boost::shared_ptr<batch_queue<Function> > queue(
+                new batch_queue<Function>(function, size, batch_size));
+            if (batches > 1) {
+                try {
+                    executor.post(
+                        boost::bind(&batch_queue<Function>::run, queue),
+                        (std::min)(helpers, batches - 1));
+                } catch (std::bad_alloc &) {
+                    //
+                    // The calling thread does the work of any copies that
+                    // could not be queued.
+                    //
+                }
+            }
+            queue->run();
+            queue->wait();
+        }
+    }
+}
+
+# endif // ifndef OPENVRML_LOCAL_COMPUTE_EXECUTOR_H
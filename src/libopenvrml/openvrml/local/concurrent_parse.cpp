@@ -0,0 +1,415 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# include "concurrent_parse.h"
+# include "vrml_parser.h"
+# include "node_arena.h"
+# include <boost/bind.hpp>
+# include <boost/scoped_ptr.hpp>
+# include <boost/thread.hpp>
+# include <algorithm>
+# include <cstddef>
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+namespace {
+
+    //
+    // Streams smaller than this are not worth splitting.
+    //
+    const std::ptrdiff_t min_concurrent_size = 256 * 1024;
+
+    //
+    // A warning, and the offset in the stream of the text it applies to.
+    //
+    struct OPENVRML_LOCAL diagnostic {
+        std::ptrdiff_t offset;
+        std::string message;
+
+        diagnostic(const std::ptrdiff_t offset, const std::string & message):
+            offset(offset),
+            message(message)
+        {}
+
+        bool operator<(const diagnostic & other) const
+        {
+            return this->offset < other.offset;
+        }
+    };
+
+    //
+    // Collects the parser's warnings rather than writing them to the
+    // browser, so that they can be written in stream order once all the
+    // parsing is done.  begin is the beginning of the buffer the scanner
+    // reads.
+    //
+    class OPENVRML_LOCAL collecting_parser :
+        public openvrml::local::vrml97_parser {
+
+        const char * const begin_;
+        std::vector<diagnostic> & diagnostics_;
+
+    public:
+        collecting_parser(
+            const openvrml::local::vrml97_parse_actions & actions,
+            openvrml::local::vrml_scanner & scanner,
+            openvrml::browser & b,
+            const std::string & uri,
+            const char * begin,
+            std::vector<diagnostic> & diagnostics):
+            openvrml::local::vrml97_parser(actions, scanner, b, uri),
+            begin_(begin),
+            diagnostics_(diagnostics)
+        {}
+
+        virtual ~collecting_parser() OPENVRML_NOTHROW
+        {}
+
+    private:
+        virtual void report_warning(const char * const where,
+                                    const std::string & message) const
+        {
+            this->diagnostics_.push_back(
+                diagnostic(where - this->begin_, message));
+        }
+    };
+
+    //
+    // Joins the threads in a thread_group when it goes out of scope, so
+    // that no thread outlives the data it works on if the calling thread
+    // throws.
+    //
+    class OPENVRML_LOCAL thread_joiner : boost::noncopyable {
+        boost::thread_group & threads_;
+
+    public:
+        explicit thread_joiner(boost::thread_group & threads):
+            threads_(threads)
+        {}
+
+        ~thread_joiner()
+        {
+            this->threads_.join_all();
+        }
+    };
+
+    //
+    // A contiguous run of chunks that do not refer to node names, parsed as
+    // a scene of its own.
+    //
+    struct OPENVRML_LOCAL batch {
+        const char * begin;
+        const char * end;
+        std::vector<boost::intrusive_ptr<openvrml::node> > nodes;
+        std::vector<diagnostic> diagnostics;
+        bool failed;
+
+        batch(const char * begin, const char * end):
+            begin(begin),
+            end(end),
+            failed(false)
+        {}
+    };
+
+    //
+    // A piece of the result, in stream order: either the nodes from a
+    // batch, or the next root_nodes nodes from the serial parse.
+    //
+    struct OPENVRML_LOCAL piece {
+        static const std::size_t serial = std::size_t(-1);
+
+        std::size_t batch;
+        std::size_t root_nodes;
+
+        piece(const std::size_t batch, const std::size_t root_nodes):
+            batch(batch),
+            root_nodes(root_nodes)
+        {}
+    };
+
+    class OPENVRML_LOCAL batch_parser : boost::noncopyable {
+        const char * const buffer_begin_;
+        const std::string & uri_;
+        const openvrml::scene & scene_;
+        const boost::shared_ptr<openvrml::scope> & root_scope_;
+        openvrml::local::node_arena * const arena_;
+        std::vector<batch> & batches_;
+
+        boost::mutex mutex_;
+        std::size_t next_;
+
+    public:
+        batch_parser(const char * buffer_begin,
+                     const std::string & uri,
+                     const openvrml::scene & scene,
+                     const boost::shared_ptr<openvrml::scope> & root_scope,
+                     std::vector<batch> & batches):
+            buffer_begin_(buffer_begin),
+            uri_(uri),
+            scene_(scene),
+            root_scope_(root_scope),
+            arena_(openvrml::local::node_arena::current()),
+            batches_(batches),
+            next_(0)
+        {}
+
+        //
+        // Parse batches until there are none left.  This runs on each
+        // worker thread and on the calling thread.
+        //
+        void run()
+        {
+            using openvrml::local::node_arena;
+
+            boost::scoped_ptr<node_arena::scope> arena_scope(
+                this->arena_ ? new node_arena::scope(*this->arena_) : 0);
+
+            for (;;) {
+                std::size_t index;
+                {
+                    boost::mutex::scoped_lock lock(this->mutex_);
+                    if (this->next_ == this->batches_.size()) { return; }
+                    index = this->next_++;
+                }
+                this->parse(this->batches_[index]);
+            }
+        }
+
+    private:
+        void parse(batch & b)
+        {
+            using openvrml::local::vrml_scanner;
+            using openvrml::local::vrml97_parse_actions;
+
+            try {
+                //
+                // The scanner starts at the beginning of the stream so that
+                // any warnings have the right line numbers.
+                //
+                vrml_scanner scanner(this->buffer_begin_, b.end, false);
+                scanner.position(b.begin);
+                vrml97_parse_actions actions(this->uri_,
+                                             this->scene_,
+                                             b.nodes,
+                                             this->root_scope_);
+                collecting_parser parser(actions,
+                                         scanner,
+                                         this->scene_.browser(),
+                                         this->uri_,
+                                         this->buffer_begin_,
+                                         b.diagnostics);
+                parser.parse();
+            } catch (...) {
+                //
+                // The stream will be parsed again serially, which will
+                // report the error and the warnings.
+                //
+                b.failed = true;
+            }
+        }
+    };
+}
+
+/**
+ * @internal
+ *
+ * @brief Parse a VRML97 stream on several threads.
+ *
+ * The stream is split into chunks of top-level statements with
+ * @c vrml_scanner::next_chunk.  Runs of chunks that do not refer to node
+ * names are grouped into batches, and each batch is parsed as a scene of
+ * its own, sharing a root scope with the others, on up to @p threads
+ * threads.  Once they are done, the chunks that do refer to node names are
+ * parsed serially on the calling thread, in stream order, so that
+ * <code>DEF</code>, <code>USE</code>, and <code>ROUTE</code> resolve as
+ * they would in a serial parse.  (The batches are blanked out of a copy of
+ * the stream for this, which preserves line numbers.)  Finally, the root
+ * nodes are merged in stream order.
+ *
+ * Warnings are collected for each batch and for the serial parse, and
+ * written to the @c browser in stream order once the stream has been
+ * parsed; they are the same, and in the same order, as those of a serial
+ * parse.  If @c false is returned, none are written.
+ *
+ * @c false is returned if the stream should be parsed serially instead:
+ * if it is small; if it declares PROTOs or EXTERNPROTOs, since the
+ * declared types would have to be visible to every batch; if it does not
+ * split into at least two batches; or if any part of it fails to parse.
+ * In the last case, the serial parse reports the error.
+ *
+ * @param[in]  begin    the beginning of the stream.
+ * @param[in]  end      the end of the stream.
+ * @param[in]  uri      the URI of the stream.
+ * @param[in]  scene    the @c scene.
+ * @param[out] nodes    the root @c node%s.
+ * @param[in]  threads  the maximum number of threads to use, including the
+ *                      calling thread.
+ *
+ * @return @c true if the stream was parsed; @c false if it should be parsed
+ *         serially.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+bool openvrml::local::parse_vrml97_concurrently(
+    const char * const begin,
+    const char * const end,
+    const std::string & uri,
+    const openvrml::scene & scene,
+    std::vector<boost::intrusive_ptr<openvrml::node> > & nodes,
+    const std::size_t threads)
+{
+    using std::vector;
+    using boost::intrusive_ptr;
+
+    if (threads < 2 || end - begin < min_concurrent_size) { return false; }
+
+    vrml_scanner splitter(begin, end, false);
+    vector<vrml_scanner::chunk> chunks;
+    std::size_t concurrent_bytes = 0;
+    vrml_scanner::chunk c;
+    while (splitter.next_chunk(c)) {
+        if (!c.complete || c.declarations) { return false; }
+        if (!c.names) { concurrent_bytes += c.end - c.begin; }
+        chunks.push_back(c);
+    }
+
+    //
+    // Several batches per thread, so that the threads finish at about the
+    // same time.
+    //
+    const std::size_t batch_size = concurrent_bytes / (threads * 4) + 1;
+    vector<batch> batches;
+    vector<piece> pieces;
+    bool serial = false;
+    for (vector<vrml_scanner::chunk>::const_iterator chunk = chunks.begin();
+         chunk != chunks.end();
+         ++chunk) {
+        if (chunk->names) {
+            pieces.push_back(piece(piece::serial, chunk->root_nodes));
+            serial = true;
+        } else if (!pieces.empty() && pieces.back().batch != piece::serial
+                   && std::size_t(batches.back().end - batches.back().begin)
+                      < batch_size) {
+            batches.back().end = chunk->end;
+        } else {
+            batches.push_back(batch(chunk->begin, chunk->end));
+            pieces.push_back(piece(batches.size() - 1, 0));
+        }
+    }
+    if (batches.size() < 2) { return false; }
+
+    const profile & p = local::profile_registry_.at(vrml97_profile::id);
+    std::auto_ptr<openvrml::scope> root_scope_ptr(
+        p.create_root_scope(scene.browser(), uri));
+    const boost::shared_ptr<openvrml::scope> root_scope(root_scope_ptr);
+
+    {
+        batch_parser parser(begin, uri, scene, root_scope, batches);
+        boost::thread_group workers;
+        const thread_joiner joiner(workers);
+        const std::size_t worker_count =
+            std::min(threads, batches.size()) - 1;
+        try {
+            for (std::size_t i = 0; i < worker_count; ++i) {
+                workers.create_thread(boost::bind(&batch_parser::run,
+                                                  &parser));
+            }
+        } catch (boost::thread_resource_error &) {
+            //
+            // Carry on with the threads we have.
+            //
+        }
+        parser.run();
+    }
+
+    for (vector<batch>::const_iterator b = batches.begin();
+         b != batches.end();
+         ++b) {
+        if (b->failed) { return false; }
+    }
+
+    vector<intrusive_ptr<node> > serial_nodes;
+    vector<diagnostic> diagnostics;
+    if (serial) {
+        vector<char> masked(begin, end);
+        for (vector<batch>::const_iterator b = batches.begin();
+             b != batches.end();
+             ++b) {
+            for (vector<char>::iterator ch = masked.begin() + (b->begin - begin);
+                 ch != masked.begin() + (b->end - begin);
+                 ++ch) {
+                if (*ch != '\n' && *ch != '\r') { *ch = ' '; }
+            }
+        }
+        vrml_scanner scanner(&masked.front(),
+                             &masked.front() + masked.size(),
+                             false);
+        vrml97_parse_actions actions(uri, scene, serial_nodes, root_scope);
+        collecting_parser parser(actions, scanner, scene.browser(), uri,
+                                 &masked.front(), diagnostics);
+        try {
+            parser.parse();
+        } catch (const vrml_parse_failure &) {
+            return false;
+        }
+    }
+
+    vector<intrusive_ptr<node> > result;
+    vector<intrusive_ptr<node> >::const_iterator next_serial =
+        serial_nodes.begin();
+    for (vector<piece>::const_iterator piece_ = pieces.begin();
+         piece_ != pieces.end();
+         ++piece_) {
+        if (piece_->batch != piece::serial) {
+            const vector<intrusive_ptr<node> > & batch_nodes =
+                batches[piece_->batch].nodes;
+            result.insert(result.end(), batch_nodes.begin(), batch_nodes.end());
+        } else {
+            if (std::size_t(serial_nodes.end() - next_serial)
+                < piece_->root_nodes) {
+                return false;
+            }
+            result.insert(result.end(),
+                          next_serial,
+                          next_serial + piece_->root_nodes);
+            next_serial += piece_->root_nodes;
+        }
+    }
+    if (next_serial != serial_nodes.end()) { return false; }
+
+    for (vector<batch>::const_iterator b = batches.begin();
+         b != batches.end();
+         ++b) {
+        diagnostics.insert(diagnostics.end(),
+                           b->diagnostics.begin(),
+                           b->diagnostics.end());
+    }
+    std::stable_sort(diagnostics.begin(), diagnostics.end());
+    for (vector<diagnostic>::const_iterator d = diagnostics.begin();
+         d != diagnostics.end();
+         ++d) {
+        scene.browser().err(d->message);
+    }
+
+    nodes.swap(result);
+    return true;
+}
@@ -243,3 +243,31 @@ const std::vector<boost::filesystem::path> openvrml::local::conf::script_path()
 
     return result;
 }
+
+//
+// OPENVRML_VRML_PARSER=spirit selects the Spirit grammars for the Classic VRML
+// encodings; otherwise, the hand-written parser is used.
+//
+openvrml::local::conf::vrml_parser_id openvrml::local::conf::vrml_parser()
+    OPENVRML_NOTHROW
+{
+    try {
+        if (get_env("OPENVRML_VRML_PARSER") == "spirit") {
+            return spirit_vrml_parser;
+        }
+    } catch (const std::exception &) {}
+    return scanner_vrml_parser;
+}
+
+//
+// OPENVRML_SCENE_CACHE names a directory in which parsed scenes are cached;
+// if it is not set, scenes are not cached.
+//
+const boost::filesystem::path openvrml::local::conf::scene_cache_dir()
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    try {
+        return get_env("OPENVRML_SCENE_CACHE");
+    } catch (const no_environment_var &) {}
+    return boost::filesystem::path();
+}
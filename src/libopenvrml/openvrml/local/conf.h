@@ -42,6 +42,16 @@ namespace openvrml {
             OPENVRML_LOCAL
             const std::vector<boost::filesystem::path> script_path()
                 OPENVRML_THROW2(std::runtime_error, std::bad_alloc);
+
+            enum vrml_parser_id {
+                scanner_vrml_parser,
+                spirit_vrml_parser
+            };
+
+            OPENVRML_LOCAL vrml_parser_id vrml_parser() OPENVRML_NOTHROW;
+
+            OPENVRML_LOCAL const boost::filesystem::path scene_cache_dir()
+                OPENVRML_THROW1(std::bad_alloc);
         }
     }
 }
@@ -0,0 +1,284 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# include "event_cascade.h"
+# include <openvrml/event.h>
+# include <openvrml/node.h>
+# include <boost/thread/tss.hpp>
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+namespace {
+
+    //
+    // The event_cascade is owned by the code that activates it (typically
+    // browser::update); the thread_specific_ptr must not delete it.
+    //
+    OPENVRML_LOCAL void no_cleanup(openvrml::local::event_cascade *)
+    {}
+
+    boost::thread_specific_ptr<openvrml::local::event_cascade>
+        current_cascade(&no_cleanup);
+}
+
+/**
+ * @internal
+ *
+ * @class openvrml::local::event_cascade
+ *
+ * @brief Breadth-first event cascade.
+ *
+ * While an @c event_cascade is active on a thread (see
+ * @c event_cascade::scope), @c node::emit_event queues events instead of
+ * delivering them immediately.  @c #drain delivers the queued events in the
+ * order they were emitted; events emitted by listeners in response are
+ * appended to the queue.  This keeps deep @c ROUTE cascades off the C++
+ * stack.
+ *
+ * Repeated events from the same @c event_emitter with the same timestamp
+ * are coalesced while the first is still pending: the emitter's value is
+ * read when the event is delivered, so the eventIns on its routes receive
+ * the latest value once.
+ *
+ * A queued event holds a reference to the @c node its @c event_emitter
+ * belongs to, so that a listener that removes the @c node from the scene
+ * (for instance, a Script calling @c Browser.replaceWorld, or an Inline
+ * unloading its scene) does not destroy the emitter under the queue; the
+ * event is delivered and the reference dropped afterward.  Events of an
+ * emitter whose @c node is not known are cancelled if the emitter is
+ * destroyed.
+ */
+
+/**
+ * @internal
+ *
+ * @struct openvrml::local::event_cascade::event
+ *
+ * @brief A queued event.
+ */
+
+/**
+ * @var openvrml::event_emitter * openvrml::local::event_cascade::event::emitter
+ *
+ * @brief The emitter; null if the event has been cancelled.
+ */
+
+/**
+ * @var boost::intrusive_ptr<openvrml::node> openvrml::local::event_cascade::event::node
+ *
+ * @brief The @c node @c #emitter belongs to, kept alive until the event
+ *        has been delivered; null if the @c node is not known or not yet
+ *        owned.
+ */
+
+/**
+ * @var double openvrml::local::event_cascade::event::timestamp
+ *
+ * @brief The timestamp of the event.
+ */
+
+/**
+ * @var std::deque<openvrml::local::event_cascade::event> openvrml::local::event_cascade::queue_
+ *
+ * @brief Events waiting to be delivered.
+ */
+
+/**
+ * @var std::map<const openvrml::event_emitter *, double> openvrml::local::event_cascade::pending_
+ *
+ * @brief Map of emitters with an event in @c #queue_ to the timestamp of
+ *        that event.
+ */
+
+/**
+ * @internal
+ *
+ * @class openvrml::local::event_cascade::scope
+ *
+ * @brief Make an @c event_cascade current for the calling thread for the
+ *        lifetime of the @c scope instance.
+ */
+
+/**
+ * @var openvrml::local::event_cascade * const openvrml::local::event_cascade::scope::previous_
+ *
+ * @brief The @c event_cascade that was current when the @c scope was
+ *        constructed.
+ */
+
+/**
+ * @brief Construct.
+ *
+ * @param[in] cascade   the @c event_cascade to make current.
+ */
+openvrml::local::event_cascade::scope::scope(event_cascade & cascade)
+    OPENVRML_NOTHROW:
+    previous_(current_cascade.get())
+{
+    current_cascade.reset(&cascade);
+}
+
+/**
+ * @brief Destroy.
+ *
+ * Restore the previously current @c event_cascade.
+ */
+openvrml::local::event_cascade::scope::~scope() OPENVRML_NOTHROW
+{
+    current_cascade.reset(this->previous_);
+}
+
+/**
+ * @brief The @c event_cascade current for the calling thread.
+ *
+ * @return the @c event_cascade current for the calling thread, or 0 if
+ *         there is none.
+ */
+openvrml::local::event_cascade * openvrml::local::event_cascade::current()
+    OPENVRML_NOTHROW
+{
+    return current_cascade.get();
+}
+
+/**
+ * @brief Construct.
+ */
+openvrml::local::event_cascade::event_cascade() OPENVRML_NOTHROW
+{}
+
+/**
+ * @brief Destroy.
+ *
+ * Any events still queued are discarded.
+ */
+openvrml::local::event_cascade::~event_cascade() OPENVRML_NOTHROW
+{
+    //
+    // Dropping the last reference to a node destroys its emitters, which
+    // cancel their events in the current cascade; empty this one first.
+    //
+    std::deque<event> queue;
+    queue.swap(this->queue_);
+    this->pending_.clear();
+}
+
+/**
+ * @brief Queue an event.
+ *
+ * If @p emitter already has an event with the same timestamp waiting in the
+ * queue, the new event is coalesced with it.
+ *
+ * @param[in] emitter   the emitter.
+ * @param[in] timestamp the timestamp of the event.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void openvrml::local::event_cascade::push(event_emitter & emitter,
+                                          const double timestamp)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    typedef std::map<const event_emitter *, double> pending_map;
+    const std::pair<pending_map::iterator, bool> result =
+        this->pending_.insert(std::make_pair(&emitter, timestamp));
+    if (!result.second) {
+        if (result.first->second == timestamp) { return; }
+        result.first->second = timestamp;
+    }
+    //
+    // A node that no one owns yet (one being constructed, say) must not be
+    // destroyed when the event lets go of it.
+    //
+    openvrml::node * const n = emitter.do_node();
+    const event e = {
+        &emitter,
+        boost::intrusive_ptr<openvrml::node>(n && n->use_count() > 0 ? n : 0),
+        timestamp
+    };
+    try {
+        this->queue_.push_back(e);
+    } catch (std::bad_alloc &) {
+        if (result.second) { this->pending_.erase(result.first); }
+        throw;
+    }
+}
+
+/**
+ * @brief Cancel any queued events for @p emitter.
+ *
+ * This function is called when an @c event_emitter is destroyed.  Only the
+ * events of an emitter whose @c node the queue does not hold can be
+ * pending then.
+ *
+ * @param[in] emitter   an @c event_emitter.
+ */
+void openvrml::local::event_cascade::cancel(const event_emitter & emitter)
+    OPENVRML_NOTHROW
+{
+    if (this->pending_.erase(&emitter) == 0) { return; }
+    for (std::deque<event>::iterator e = this->queue_.begin();
+         e != this->queue_.end();
+         ++e) {
+        if (e->emitter == &emitter) { e->emitter = 0; }
+    }
+}
+
+/**
+ * @brief Deliver queued events until the queue is empty.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void openvrml::local::event_cascade::drain() OPENVRML_THROW1(std::bad_alloc)
+{
+    while (!this->queue_.empty()) {
+        //
+        // e keeps the emitter's node alive while its listeners run; letting
+        // go of it at the end of the iteration may destroy the node.
+        //
+        const event e = this->queue_.front();
+        this->queue_.pop_front();
+        if (!e.emitter) { continue; }
+
+        //
+        // If the emitter was queued again with a different timestamp, this
+        // entry is superseded.
+        //
+        const std::map<const event_emitter *, double>::iterator pending =
+            this->pending_.find(e.emitter);
+        if (pending == this->pending_.end()
+            || pending->second != e.timestamp) {
+            continue;
+        }
+        this->pending_.erase(pending);
+
+        e.emitter->emit_event(e.timestamp);
+    }
+}
+
+/**
+ * @brief Whether there are events waiting to be delivered.
+ *
+ * @return @c true if the queue is empty; @c false otherwise.
+ */
+bool openvrml::local::event_cascade::empty() const OPENVRML_NOTHROW
+{
+    return this->queue_.empty();
+}
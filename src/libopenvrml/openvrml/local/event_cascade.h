@@ -0,0 +1,71 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# ifndef OPENVRML_LOCAL_EVENT_CASCADE_H
+#   define OPENVRML_LOCAL_EVENT_CASCADE_H
+
+#   include <openvrml-common.h>
+#   include <boost/intrusive_ptr.hpp>
+#   include <boost/utility.hpp>
+#   include <deque>
+#   include <map>
+#   include <new>
+
+namespace openvrml {
+
+    class node;
+    class event_emitter;
+
+    namespace local {
+
+        class OPENVRML_LOCAL event_cascade : boost::noncopyable {
+            struct event {
+                event_emitter * emitter;
+                boost::intrusive_ptr<openvrml::node> node;
+                double timestamp;
+            };
+
+            std::deque<event> queue_;
+            std::map<const event_emitter *, double> pending_;
+
+        public:
+            class OPENVRML_LOCAL scope : boost::noncopyable {
+                event_cascade * const previous_;
+
+            public:
+                explicit scope(event_cascade & cascade) OPENVRML_NOTHROW;
+                ~scope() OPENVRML_NOTHROW;
+            };
+
+            static event_cascade * current() OPENVRML_NOTHROW;
+
+            event_cascade() OPENVRML_NOTHROW;
+            ~event_cascade() OPENVRML_NOTHROW;
+
+            void push(event_emitter & emitter, double timestamp)
+                OPENVRML_THROW1(std::bad_alloc);
+            void cancel(const event_emitter & emitter) OPENVRML_NOTHROW;
+            void drain() OPENVRML_THROW1(std::bad_alloc);
+            bool empty() const OPENVRML_NOTHROW;
+        };
+    }
+}
+
+# endif // ifndef OPENVRML_LOCAL_EVENT_CASCADE_H
@@ -134,8 +134,9 @@ private:
  *                                          @c EXTERNPROTO occurs.
  * @param[in] uris                          the list of alternative
  *                                          implementation identifiers.
- * @param[in,out] load_proto_thread_group   the thread group used for loading
- *                                          @c EXTERNPROTO implementations.
+ * @param[in,out] executor                  the @c io_executor used for
+ *                                          loading @c EXTERNPROTO
+ *                                          implementations.
  *
  * @exception boost::thread_resource_error  if a new thread of execution
  *                                          cannot be started.
@@ -145,14 +146,14 @@ openvrml::local::externproto_node_metatype::
 externproto_node_metatype(const openvrml::node_metatype_id & id,
                           const openvrml::scene & scene,
                           const std::vector<std::string> & uris,
-                          boost::thread_group & load_proto_thread_group)
+                          io_executor & executor)
     OPENVRML_THROW2(boost::thread_resource_error, std::bad_alloc):
     node_metatype(id, scene.browser()),
-                  externproto_node_types_cleared_(false),
-                  load_proto_thread_(
-                      load_proto_thread_group.create_thread(
-                          boost::function0<void>(
-                              load_proto(*this, scene, uris))))
+    externproto_node_types_cleared_(false),
+    load_proto_job_(
+        executor.post(boost::function0<void>(load_proto(*this, scene, uris)),
+                      0.0f,
+                      false))
 {}
 
 /**
@@ -190,7 +191,7 @@ do_create_type(const std::string & id,
 void openvrml::local::externproto_node_metatype::do_shutdown(double)
     OPENVRML_NOTHROW
 {
-    this->load_proto_thread_->join();
+    this->load_proto_job_->wait();
 }
 
 void
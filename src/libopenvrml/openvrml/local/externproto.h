@@ -22,6 +22,7 @@
 #   define OPENVRML_LOCAL_EXTERNPROTO_H
 
 #   include <openvrml/local/proto.h>
+#   include <openvrml/local/io_executor.h>
 #   include <boost/enable_shared_from_this.hpp>
 #   include <boost/thread.hpp>
 
@@ -51,14 +52,14 @@ namespace openvrml {
             mutable externproto_node_types externproto_node_types_;
             bool externproto_node_types_cleared_;
 
-            boost::thread * const load_proto_thread_;
+            const boost::shared_ptr<io_job> load_proto_job_;
 
         public:
             externproto_node_metatype(
                 const openvrml::node_metatype_id & id,
                 const openvrml::scene & scene,
                 const std::vector<std::string> & uris,
-                boost::thread_group & load_proto_thread_group)
+                io_executor & executor)
                 OPENVRML_THROW2(boost::thread_resource_error, std::bad_alloc);
             virtual ~externproto_node_metatype() OPENVRML_NOTHROW;
 
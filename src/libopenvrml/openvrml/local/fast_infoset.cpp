@@ -0,0 +1,986 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# include "fast_infoset.h"
+# include "x3d_vocabulary.h"
+# include <boost/cstdint.hpp>
+# include <cstring>
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+/**
+ * @internal
+ *
+ * @class openvrml::local::fast_infoset_error openvrml/local/fast_infoset.h
+ *
+ * @brief Exception thrown when a Fast Infoset document cannot be decoded.
+ */
+
+/**
+ * @brief Construct.
+ *
+ * @param[in] message   error message.
+ */
+openvrml::local::fast_infoset_error::
+fast_infoset_error(const std::string & message):
+    std::runtime_error(message)
+{}
+
+/**
+ * @brief Destroy.
+ */
+openvrml::local::fast_infoset_error::~fast_infoset_error() throw ()
+{}
+
+
+/**
+ * @internal
+ *
+ * @struct openvrml::local::fi_string openvrml/local/fast_infoset.h
+ *
+ * @brief A character string in a Fast Infoset document.
+ *
+ * Strings encoded as UTF-8, as UTF-16, or with a restricted alphabet are
+ * decoded to UTF-8 text.  Strings encoded with an encoding algorithm are
+ * left as the encoded octets; interpreting them is up to the consumer,
+ * which knows what type of value to expect.
+ */
+
+/**
+ * @var openvrml::local::fi_string::encoding_id openvrml::local::fi_string::encoding
+ *
+ * @brief Whether @a data is text or the output of an encoding algorithm.
+ */
+
+/**
+ * @var unsigned openvrml::local::fi_string::algorithm
+ *
+ * @brief The encoding algorithm index, if @a encoding is
+ *        @c algorithm_encoding.
+ *
+ * Indices less than @c application_algorithm_start identify the built-in
+ * algorithms of ITU-T Rec. X.891 &sect;10.
+ */
+
+/**
+ * @var std::string openvrml::local::fi_string::algorithm_uri
+ *
+ * @brief The URI of an application-defined encoding algorithm.
+ */
+
+/**
+ * @var std::string openvrml::local::fi_string::data
+ *
+ * @brief UTF-8 text, or encoded octets.
+ */
+
+/**
+ * @brief Construct an empty string.
+ */
+openvrml::local::fi_string::fi_string() OPENVRML_NOTHROW:
+    encoding(text_encoding),
+    algorithm(0)
+{}
+
+
+/**
+ * @internal
+ *
+ * @class openvrml::local::fi_element openvrml/local/fast_infoset.h
+ *
+ * @brief An element in a decoded Fast Infoset document.
+ *
+ * Only what is needed to construct a scene is kept: the local names of the
+ * element and its attributes, the attribute values, child elements, and
+ * the character content (concatenated).  Namespaces, comments, and
+ * processing instructions are discarded.
+ */
+
+/**
+ * @brief Find an attribute.
+ *
+ * @param[in] name  the attribute's local name.
+ *
+ * @return the attribute named @p name, or 0 if there is no such attribute.
+ */
+const openvrml::local::fi_attribute *
+openvrml::local::fi_element::attribute(const std::string & name) const
+    OPENVRML_NOTHROW
+{
+    for (attributes_t::const_iterator attr = this->attributes.begin();
+         attr != this->attributes.end();
+         ++attr) {
+        if (attr->name == name) { return &*attr; }
+    }
+    return 0;
+}
+
+namespace {
+
+    using openvrml::local::fast_infoset_error;
+    using openvrml::local::fi_string;
+    using openvrml::local::fi_element;
+    using openvrml::local::x3d_external_vocabulary_uri;
+    using openvrml::local::x3d_element_names;
+    using openvrml::local::x3d_element_names_size;
+    using openvrml::local::x3d_attribute_names;
+    using openvrml::local::x3d_attribute_names_size;
+
+    //
+    // The built-in restricted alphabets; see X.891 &sect;9.
+    //
+    const char numeric_alphabet[] = "0123456789-+.E ";
+    const char date_time_alphabet[] = "0123456789-:TZ ";
+
+    const unsigned restricted_alphabet_application_start = 16;
+
+    //
+    // Terminators (X.891 C.2.12, C.3.8).  Two consecutive terminators may be
+    // combined into one octet.
+    //
+    const unsigned char terminator = 0xF0;
+    const unsigned char double_terminator = 0xFF;
+
+    OPENVRML_LOCAL void append_utf8(std::string & str, const unsigned long c)
+    {
+        if (c < 0x80) {
+            str += char(c);
+        } else if (c < 0x800) {
+            str += char(0xC0 | (c >> 6));
+            str += char(0x80 | (c & 0x3F));
+        } else if (c < 0x10000) {
+            str += char(0xE0 | (c >> 12));
+            str += char(0x80 | ((c >> 6) & 0x3F));
+            str += char(0x80 | (c & 0x3F));
+        } else {
+            str += char(0xF0 | (c >> 18));
+            str += char(0x80 | ((c >> 12) & 0x3F));
+            str += char(0x80 | ((c >> 6) & 0x3F));
+            str += char(0x80 | (c & 0x3F));
+        }
+    }
+
+    //
+    // Decode a UTF-8 string into code points.  Restricted alphabets are
+    // sequences of characters, not of octets.
+    //
+    OPENVRML_LOCAL void code_points(const std::string & str,
+                                    std::vector<unsigned long> & result)
+    {
+        result.clear();
+        for (std::string::size_type i = 0; i < str.size();) {
+            const unsigned char lead = str[i];
+            std::size_t length = (lead < 0x80) ? 1
+                               : (lead < 0xE0) ? 2
+                               : (lead < 0xF0) ? 3
+                               : 4;
+            if (i + length > str.size()) {
+                throw fast_infoset_error("invalid UTF-8 in restricted "
+                                         "alphabet");
+            }
+            unsigned long c = (length == 1) ? lead
+                            : (lead & (0x7F >> length));
+            for (std::size_t j = 1; j < length; ++j) {
+                c = (c << 6) | (static_cast<unsigned char>(str[i + j]) & 0x3F);
+            }
+            result.push_back(c);
+            i += length;
+        }
+    }
+
+    struct OPENVRML_LOCAL qualified_name {
+        std::string local_name;
+    };
+
+    //
+    // A decoder for the subset of ITU-T Rec. X.891 (Fast Infoset) used by
+    // document-centric encodings like X3D: elements, attributes, and
+    // character content, with the vocabulary tables that let repeated names
+    // and values be encoded as indices.  Document type declarations,
+    // notations, unparsed entities, and external vocabularies other than
+    // X3D's are not supported.
+    //
+    class OPENVRML_LOCAL fi_decoder : boost::noncopyable {
+        const unsigned char * pos_;
+        const unsigned char * const end_;
+        bool pending_terminator_;
+
+        std::vector<std::string> restricted_alphabets_;
+        std::vector<std::string> encoding_algorithms_;
+        std::vector<std::string> prefixes_;
+        std::vector<std::string> namespace_names_;
+        std::vector<std::string> local_names_;
+        std::vector<std::string> other_ncnames_;
+        std::vector<std::string> other_uris_;
+        std::vector<fi_string> attribute_values_;
+        std::vector<fi_string> content_character_chunks_;
+        std::vector<fi_string> other_strings_;
+        std::vector<qualified_name> element_names_;
+        std::vector<qualified_name> attribute_names_;
+
+    public:
+        fi_decoder(const char * begin, const char * end);
+
+        std::auto_ptr<fi_element> document();
+
+    private:
+        unsigned char peek();
+        unsigned char read();
+        boost::uint32_t read32();
+        const std::string read_octets(std::size_t length);
+        bool terminated();
+
+        template <typename T>
+        static const T & lookup(const std::vector<T> & table,
+                                std::size_t index);
+
+        std::size_t sequence_length();
+        std::size_t index_on_second_bit(unsigned char b);
+        std::size_t index_on_third_bit(unsigned char b);
+        std::size_t length_on_second_bit(unsigned char b);
+        std::size_t length_on_fifth_bit(unsigned char b);
+        std::size_t length_on_seventh_bit(unsigned char b);
+
+        const std::string identifying_string(std::vector<std::string> & table);
+        const std::string octet_string_on_second_bit();
+        void encoded_string(unsigned discriminant,
+                            unsigned alphabet_or_algorithm,
+                            std::size_t length,
+                            fi_string & result);
+        const fi_string
+        non_identifying_string(std::vector<fi_string> & table);
+        const fi_string character_chunk();
+        const qualified_name
+        literal_qualified_name(unsigned char flags,
+                               std::vector<qualified_name> & table);
+        const qualified_name name_surrogate();
+
+        void initial_vocabulary();
+        void x3d_vocabulary();
+        void namespace_attributes();
+        std::auto_ptr<fi_element> element();
+        void processing_instruction();
+        void comment();
+    };
+
+    fi_decoder::fi_decoder(const char * const begin, const char * const end):
+        pos_(reinterpret_cast<const unsigned char *>(begin)),
+        end_(reinterpret_cast<const unsigned char *>(end)),
+        pending_terminator_(false)
+    {
+        //
+        // The prefix and namespace name tables begin with the entries for
+        // the "xml" prefix (X.891 &sect;8.3).
+        //
+        this->prefixes_.push_back("xml");
+        this->namespace_names_.push_back(
+            "http://www.w3.org/XML/1998/namespace");
+    }
+
+    unsigned char fi_decoder::peek()
+    {
+        if (this->pos_ == this->end_) {
+            throw fast_infoset_error("unexpected end of document");
+        }
+        return *this->pos_;
+    }
+
+    unsigned char fi_decoder::read()
+    {
+        const unsigned char b = this->peek();
+        ++this->pos_;
+        return b;
+    }
+
+    boost::uint32_t fi_decoder::read32()
+    {
+        boost::uint32_t result = 0;
+        for (std::size_t i = 0; i < 4; ++i) {
+            result = (result << 8) | this->read();
+        }
+        return result;
+    }
+
+    const std::string fi_decoder::read_octets(const std::size_t length)
+    {
+        if (std::size_t(this->end_ - this->pos_) < length) {
+            throw fast_infoset_error("unexpected end of document");
+        }
+        const char * const begin = reinterpret_cast<const char *>(this->pos_);
+        this->pos_ += length;
+        return std::string(begin, begin + length);
+    }
+
+    //
+    // Consume a terminator if one is next.
+    //
+    bool fi_decoder::terminated()
+    {
+        if (this->pending_terminator_) {
+            this->pending_terminator_ = false;
+            return true;
+        }
+        const unsigned char b = this->peek();
+        if (b == terminator) {
+            ++this->pos_;
+            return true;
+        }
+        if (b == double_terminator) {
+            ++this->pos_;
+            this->pending_terminator_ = true;
+            return true;
+        }
+        return false;
+    }
+
+    template <typename T>
+    const T & fi_decoder::lookup(const std::vector<T> & table,
+                                 const std::size_t index)
+    {
+        if (index >= table.size()) {
+            throw fast_infoset_error("vocabulary table index out of range");
+        }
+        return table[index];
+    }
+
+    //
+    // C.21: the length of a sequence-of.
+    //
+    std::size_t fi_decoder::sequence_length()
+    {
+        const unsigned char b = this->read();
+        if ((b & 0x80) == 0) { return std::size_t(b) + 1; }
+        if ((b & 0xF0) == 0x80) {
+            std::size_t length = b & 0x0F;
+            length = (length << 8) | this->read();
+            length = (length << 8) | this->read();
+            return length + 129;
+        }
+        throw fast_infoset_error("invalid sequence length");
+    }
+
+    //
+    // C.25, C.26: an index starting on the second bit of b; the value
+    // returned is zero-based.
+    //
+    std::size_t fi_decoder::index_on_second_bit(const unsigned char b)
+    {
+        if ((b & 0x40) == 0) { return b & 0x3F; }
+        if ((b & 0x60) == 0x40) {
+            return ((std::size_t(b & 0x1F) << 8) | this->read()) + 64;
+        }
+        if ((b & 0x70) == 0x60) {
+            std::size_t index = b & 0x0F;
+            index = (index << 8) | this->read();
+            index = (index << 8) | this->read();
+            return index + 8256;
+        }
+        throw fast_infoset_error("invalid index");
+    }
+
+    //
+    // C.27: an index starting on the third bit of b; the value returned is
+    // zero-based.
+    //
+    std::size_t fi_decoder::index_on_third_bit(const unsigned char b)
+    {
+        if ((b & 0x20) == 0) { return b & 0x1F; }
+        if ((b & 0x38) == 0x20) {
+            return ((std::size_t(b & 0x07) << 8) | this->read()) + 32;
+        }
+        if ((b & 0x38) == 0x28) {
+            std::size_t index = b & 0x07;
+            index = (index << 8) | this->read();
+            index = (index << 8) | this->read();
+            return index + 2080;
+        }
+        if ((b & 0x3F) == 0x30) {
+            std::size_t index = this->read() & 0x0F;
+            index = (index << 8) | this->read();
+            index = (index << 8) | this->read();
+            return index + 526368;
+        }
+        throw fast_infoset_error("invalid index");
+    }
+
+    //
+    // C.22: the length of a non-empty octet string starting on the second
+    // bit of b.
+    //
+    std::size_t fi_decoder::length_on_second_bit(const unsigned char b)
+    {
+        if ((b & 0x40) == 0) { return std::size_t(b & 0x3F) + 1; }
+        if ((b & 0x7F) == 0x40) { return std::size_t(this->read()) + 65; }
+        if ((b & 0x7F) == 0x60) { return std::size_t(this->read32()) + 321; }
+        throw fast_infoset_error("invalid string length");
+    }
+
+    //
+    // C.23: the length of a non-empty octet string starting on the fifth
+    // bit of b.
+    //
+    std::size_t fi_decoder::length_on_fifth_bit(const unsigned char b)
+    {
+        if ((b & 0x08) == 0) { return std::size_t(b & 0x07) + 1; }
+        if ((b & 0x0F) == 0x08) { return std::size_t(this->read()) + 9; }
+        if ((b & 0x0F) == 0x0C) { return std::size_t(this->read32()) + 265; }
+        throw fast_infoset_error("invalid string length");
+    }
+
+    //
+    // C.24: the length of a non-empty octet string starting on the seventh
+    // bit of b.
+    //
+    std::size_t fi_decoder::length_on_seventh_bit(const unsigned char b)
+    {
+        if ((b & 0x02) == 0) { return std::size_t(b & 0x01) + 1; }
+        if ((b & 0x03) == 0x02) { return std::size_t(this->read()) + 3; }
+        return std::size_t(this->read32()) + 259;
+    }
+
+    //
+    // C.13: an identifying string or index, starting on the first bit.
+    // Literal identifying strings are always added to their table.
+    //
+    const std::string
+    fi_decoder::identifying_string(std::vector<std::string> & table)
+    {
+        const unsigned char b = this->read();
+        if (b & 0x80) {
+            return lookup(table, this->index_on_second_bit(b & 0x7F));
+        }
+        table.push_back(this->read_octets(this->length_on_second_bit(b)));
+        return table.back();
+    }
+
+    //
+    // A non-empty octet string starting on the second bit, following a
+    // padding bit; used in the document header and the initial vocabulary.
+    //
+    const std::string fi_decoder::octet_string_on_second_bit()
+    {
+        const unsigned char b = this->read();
+        if (b & 0x80) { throw fast_infoset_error("invalid string"); }
+        return this->read_octets(this->length_on_second_bit(b));
+    }
+
+    //
+    // C.19, C.20: the octets of an encoded character string.
+    //
+    void fi_decoder::encoded_string(const unsigned discriminant,
+                                    const unsigned alphabet_or_algorithm,
+                                    const std::size_t length,
+                                    fi_string & result)
+    {
+        const std::string octets = this->read_octets(length);
+        result = fi_string();
+        switch (discriminant) {
+        case 0:
+            result.data = octets;
+            break;
+        case 1:
+        {
+            if (octets.size() % 2 != 0) {
+                throw fast_infoset_error("invalid UTF-16 string");
+            }
+            for (std::size_t i = 0; i < octets.size(); i += 2) {
+                unsigned long c =
+                    (static_cast<unsigned char>(octets[i]) << 8)
+                    | static_cast<unsigned char>(octets[i + 1]);
+                if (c >= 0xD800 && c < 0xDC00 && i + 3 < octets.size()) {
+                    const unsigned long low =
+                        (static_cast<unsigned char>(octets[i + 2]) << 8)
+                        | static_cast<unsigned char>(octets[i + 3]);
+                    c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+                    i += 2;
+                }
+                append_utf8(result.data, c);
+            }
+            break;
+        }
+        case 2:
+        {
+            std::vector<unsigned long> alphabet;
+            if (alphabet_or_algorithm == 0) {
+                code_points(numeric_alphabet, alphabet);
+            } else if (alphabet_or_algorithm == 1) {
+                code_points(date_time_alphabet, alphabet);
+            } else if (alphabet_or_algorithm
+                       >= restricted_alphabet_application_start) {
+                code_points(
+                    lookup(this->restricted_alphabets_,
+                           alphabet_or_algorithm
+                           - restricted_alphabet_application_start),
+                    alphabet);
+            } else {
+                throw fast_infoset_error("unknown restricted alphabet");
+            }
+
+            //
+            // Each character is the smallest number of bits that can hold
+            // the alphabet's size plus a terminating all-ones value.
+            //
+            unsigned bits = 1;
+            while ((1UL << bits) <= alphabet.size()) { ++bits; }
+            const unsigned long end_of_string = (1UL << bits) - 1;
+            unsigned long acc = 0;
+            unsigned acc_bits = 0;
+            for (std::size_t i = 0; i < octets.size(); ++i) {
+                acc = (acc << 8) | static_cast<unsigned char>(octets[i]);
+                acc_bits += 8;
+                while (acc_bits >= bits) {
+                    const unsigned long c =
+                        (acc >> (acc_bits - bits)) & end_of_string;
+                    acc_bits -= bits;
+                    if (c == end_of_string) { break; }
+                    if (c >= alphabet.size()) {
+                        throw fast_infoset_error("invalid restricted "
+                                                 "alphabet string");
+                    }
+                    append_utf8(result.data, alphabet[c]);
+                }
+            }
+            break;
+        }
+        case 3:
+            result.encoding = fi_string::algorithm_encoding;
+            result.algorithm = alphabet_or_algorithm;
+            if (alphabet_or_algorithm
+                >= fi_string::application_algorithm_start) {
+                result.algorithm_uri =
+                    lookup(this->encoding_algorithms_,
+                           alphabet_or_algorithm
+                           - fi_string::application_algorithm_start);
+            }
+            result.data = octets;
+            break;
+        }
+    }
+
+    //
+    // C.14: a non-identifying string or index, starting on the first bit.
+    //
+    const fi_string
+    fi_decoder::non_identifying_string(std::vector<fi_string> & table)
+    {
+        const unsigned char b = this->read();
+        if (b == 0xFF) { return fi_string(); }
+        if (b & 0x80) {
+            return lookup(table, this->index_on_second_bit(b & 0x7F));
+        }
+        const bool add_to_table = (b & 0x40) != 0;
+        const unsigned discriminant = (b >> 4) & 0x03;
+        fi_string result;
+        if (discriminant < 2) {
+            this->encoded_string(discriminant, 0,
+                                 this->length_on_fifth_bit(b),
+                                 result);
+        } else {
+            const unsigned char b2 = this->read();
+            const unsigned index = ((b & 0x0F) << 4) | (b2 >> 4);
+            this->encoded_string(discriminant, index,
+                                 this->length_on_fifth_bit(b2),
+                                 result);
+        }
+        if (add_to_table) { table.push_back(result); }
+        return result;
+    }
+
+    //
+    // C.7, C.15: a character chunk.  The leading "10" bits have been
+    // peeked, not consumed.
+    //
+    const fi_string fi_decoder::character_chunk()
+    {
+        const unsigned char b = this->read();
+        if (b & 0x20) {
+            //
+            // C.28: an index starting on the fourth bit.
+            //
+            std::size_t index;
+            if ((b & 0x10) == 0) {
+                index = b & 0x0F;
+            } else if ((b & 0x1C) == 0x10) {
+                index = ((std::size_t(b & 0x03) << 8) | this->read()) + 16;
+            } else if ((b & 0x1C) == 0x14) {
+                index = b & 0x03;
+                index = (index << 8) | this->read();
+                index = (index << 8) | this->read();
+                index += 1040;
+            } else if ((b & 0x1F) == 0x18) {
+                index = this->read() & 0x0F;
+                index = (index << 8) | this->read();
+                index = (index << 8) | this->read();
+                index += 263184;
+            } else {
+                throw fast_infoset_error("invalid index");
+            }
+            return lookup(this->content_character_chunks_, index);
+        }
+        const bool add_to_table = (b & 0x10) != 0;
+        const unsigned discriminant = (b >> 2) & 0x03;
+        fi_string result;
+        if (discriminant < 2) {
+            this->encoded_string(discriminant, 0,
+                                 this->length_on_seventh_bit(b),
+                                 result);
+        } else {
+            const unsigned char b2 = this->read();
+            const unsigned index = ((b & 0x03) << 6) | (b2 >> 2);
+            this->encoded_string(discriminant, index,
+                                 this->length_on_seventh_bit(b2),
+                                 result);
+        }
+        if (add_to_table) {
+            this->content_character_chunks_.push_back(result);
+        }
+        return result;
+    }
+
+    //
+    // C.18.4, C.17.4: a literal qualified name, which is added to the name
+    // table.
+    //
+    const qualified_name
+    fi_decoder::literal_qualified_name(const unsigned char flags,
+                                       std::vector<qualified_name> & table)
+    {
+        if (flags & 0x02) { this->identifying_string(this->prefixes_); }
+        if (flags & 0x01) { this->identifying_string(this->namespace_names_); }
+        qualified_name name;
+        name.local_name = this->identifying_string(this->local_names_);
+        table.push_back(name);
+        return name;
+    }
+
+    //
+    // C.16: a name surrogate in the initial vocabulary.
+    //
+    const qualified_name fi_decoder::name_surrogate()
+    {
+        const unsigned char flags = this->read();
+        if (flags & 0x02) {
+            lookup(this->prefixes_, this->index_on_second_bit(this->read()));
+        }
+        if (flags & 0x01) {
+            lookup(this->namespace_names_,
+                   this->index_on_second_bit(this->read()));
+        }
+        qualified_name name;
+        name.local_name = lookup(this->local_names_,
+                                 this->index_on_second_bit(this->read()));
+        return name;
+    }
+
+    //
+    // C.2.5: the initial vocabulary.  The only external vocabulary known is
+    // X3D's; its tables come before any the document adds.
+    //
+    void fi_decoder::initial_vocabulary()
+    {
+        const unsigned char b1 = this->read(), b2 = this->read();
+        if (b1 & 0x10) {
+            const std::string uri = this->octet_string_on_second_bit();
+            if (uri != x3d_external_vocabulary_uri) {
+                throw fast_infoset_error("unsupported external vocabulary: "
+                                         + uri);
+            }
+            this->x3d_vocabulary();
+        }
+
+        std::vector<std::string> * const string_tables[] = {
+            &this->restricted_alphabets_,
+            &this->encoding_algorithms_,
+            &this->prefixes_,
+            &this->namespace_names_,
+            &this->local_names_,
+            &this->other_ncnames_,
+            &this->other_uris_
+        };
+        const bool string_tables_present[] = {
+            (b1 & 0x08) != 0,
+            (b1 & 0x04) != 0,
+            (b1 & 0x02) != 0,
+            (b1 & 0x01) != 0,
+            (b2 & 0x80) != 0,
+            (b2 & 0x40) != 0,
+            (b2 & 0x20) != 0
+        };
+        for (std::size_t i = 0; i < 7; ++i) {
+            if (!string_tables_present[i]) { continue; }
+            for (std::size_t n = this->sequence_length(); n > 0; --n) {
+                string_tables[i]->push_back(
+                    this->octet_string_on_second_bit());
+            }
+        }
+
+        std::vector<fi_string> * const value_tables[] = {
+            &this->attribute_values_,
+            &this->content_character_chunks_,
+            &this->other_strings_
+        };
+        const bool value_tables_present[] = {
+            (b2 & 0x10) != 0,
+            (b2 & 0x08) != 0,
+            (b2 & 0x04) != 0
+        };
+        for (std::size_t i = 0; i < 3; ++i) {
+            if (!value_tables_present[i]) { continue; }
+            for (std::size_t n = this->sequence_length(); n > 0; --n) {
+                //
+                // Encoded character strings starting on the third bit are
+                // laid out like literal non-identifying strings that are
+                // not added to a table.
+                //
+                if (this->peek() & 0xC0) {
+                    throw fast_infoset_error("invalid initial vocabulary");
+                }
+                std::vector<fi_string> scratch;
+                value_tables[i]->push_back(
+                    this->non_identifying_string(scratch));
+            }
+        }
+
+        if (b2 & 0x02) {
+            for (std::size_t n = this->sequence_length(); n > 0; --n) {
+                this->element_names_.push_back(this->name_surrogate());
+            }
+        }
+        if (b2 & 0x01) {
+            for (std::size_t n = this->sequence_length(); n > 0; --n) {
+                this->attribute_names_.push_back(this->name_surrogate());
+            }
+        }
+    }
+
+    //
+    // Add the X3D external vocabulary's element and attribute names to the
+    // name tables, and their local names to the local name table.
+    //
+    void fi_decoder::x3d_vocabulary()
+    {
+        qualified_name name;
+        for (std::size_t i = 0; i < x3d_element_names_size; ++i) {
+            name.local_name = x3d_element_names[i];
+            this->local_names_.push_back(name.local_name);
+            this->element_names_.push_back(name);
+        }
+        for (std::size_t i = 0; i < x3d_attribute_names_size; ++i) {
+            name.local_name = x3d_attribute_names[i];
+            this->local_names_.push_back(name.local_name);
+            this->attribute_names_.push_back(name);
+        }
+    }
+
+    //
+    // C.12: namespace attributes, which precede the element's name.
+    //
+    void fi_decoder::namespace_attributes()
+    {
+        for (;;) {
+            const unsigned char b = this->read();
+            if (b == terminator) { break; }
+            if ((b & 0xFC) != 0xCC) {
+                throw fast_infoset_error("invalid namespace attribute");
+            }
+            if (b & 0x02) { this->identifying_string(this->prefixes_); }
+            if (b & 0x01) {
+                this->identifying_string(this->namespace_names_);
+            }
+        }
+    }
+
+    //
+    // C.3: an element.
+    //
+    std::auto_ptr<fi_element> fi_decoder::element()
+    {
+        std::auto_ptr<fi_element> result(new fi_element);
+
+        unsigned char b = this->read();
+        const bool attributes = (b & 0x40) != 0;
+        if ((b & 0x3F) == 0x38) {
+            this->namespace_attributes();
+            b = this->read();
+        }
+        if ((b & 0x3C) == 0x3C) {
+            result->name =
+                this->literal_qualified_name(b & 0x03, this->element_names_)
+                .local_name;
+        } else {
+            result->name =
+                lookup(this->element_names_, this->index_on_third_bit(b & 0x3F))
+                .local_name;
+        }
+
+        if (attributes) {
+            while (!this->terminated()) {
+                //
+                // C.4: an attribute.
+                //
+                b = this->read();
+                if (b & 0x80) {
+                    throw fast_infoset_error("invalid attribute");
+                }
+                openvrml::local::fi_attribute attr;
+                if ((b & 0x7C) == 0x78) {
+                    attr.name =
+                        this->literal_qualified_name(b & 0x03,
+                                                     this->attribute_names_)
+                        .local_name;
+                } else {
+                    attr.name =
+                        lookup(this->attribute_names_,
+                               this->index_on_second_bit(b))
+                        .local_name;
+                }
+                attr.value =
+                    this->non_identifying_string(this->attribute_values_);
+                result->attributes.push_back(attr);
+            }
+        }
+
+        while (!this->terminated()) {
+            b = this->peek();
+            if ((b & 0x80) == 0) {
+                result->children.push_back(this->element().release());
+            } else if ((b & 0xC0) == 0x80) {
+                const fi_string chunk = this->character_chunk();
+                if (chunk.encoding == fi_string::text_encoding
+                    || chunk.algorithm == fi_string::cdata_algorithm) {
+                    result->text += chunk.data;
+                }
+            } else if (b == 0xE1) {
+                this->processing_instruction();
+            } else if (b == 0xE2) {
+                this->comment();
+            } else {
+                throw fast_infoset_error("unsupported element content");
+            }
+        }
+        return result;
+    }
+
+    //
+    // C.5: a processing instruction; discarded.
+    //
+    void fi_decoder::processing_instruction()
+    {
+        this->read();
+        this->identifying_string(this->other_ncnames_);
+        this->non_identifying_string(this->other_strings_);
+    }
+
+    //
+    // C.8: a comment; discarded.
+    //
+    void fi_decoder::comment()
+    {
+        this->read();
+        this->non_identifying_string(this->other_strings_);
+    }
+
+    //
+    // C.2: the document.
+    //
+    std::auto_ptr<fi_element> fi_decoder::document()
+    {
+        //
+        // An XML declaration may precede the identification octets.
+        //
+        static const char xml_declaration[] = "<?xml";
+        if (std::size_t(this->end_ - this->pos_) >= sizeof xml_declaration - 1
+            && std::memcmp(this->pos_, xml_declaration,
+                           sizeof xml_declaration - 1) == 0) {
+            while (!(this->read() == '?' && this->peek() == '>')) {}
+            this->read();
+        }
+
+        static const unsigned char identification[] = { 0xE0, 0x00,
+                                                        0x00, 0x01 };
+        if (this->read_octets(4)
+            != std::string(identification, identification + 4)) {
+            throw fast_infoset_error("not a Fast Infoset document");
+        }
+
+        const unsigned char components = this->read();
+        if (components & 0x40) {
+            for (std::size_t n = this->sequence_length(); n > 0; --n) {
+                this->octet_string_on_second_bit();
+                this->octet_string_on_second_bit();
+            }
+        }
+        if (components & 0x20) { this->initial_vocabulary(); }
+        if (components & 0x18) {
+            throw fast_infoset_error("unsupported notations or unparsed "
+                                     "entities");
+        }
+        if (components & 0x04) { this->octet_string_on_second_bit(); }
+        if (components & 0x02) { this->read(); }
+        if (components & 0x01) {
+            this->non_identifying_string(this->other_strings_);
+        }
+
+        std::auto_ptr<fi_element> root;
+        while (!this->terminated()) {
+            const unsigned char b = this->peek();
+            if ((b & 0x80) == 0) {
+                if (root.get()) {
+                    throw fast_infoset_error("more than one document "
+                                             "element");
+                }
+                root = this->element();
+            } else if (b == 0xE1) {
+                this->processing_instruction();
+            } else if (b == 0xE2) {
+                this->comment();
+            } else {
+                throw fast_infoset_error("unsupported document content");
+            }
+        }
+        if (!root.get()) { throw fast_infoset_error("no document element"); }
+        return root;
+    }
+}
+
+/**
+ * @internal
+ *
+ * @brief Decode a Fast Infoset document.
+ *
+ * @param[in] begin the beginning of the document.
+ * @param[in] end   the end of the document.
+ *
+ * @return the document element.
+ *
+ * @exception fast_infoset_error    if the document is malformed or uses a
+ *                                  feature that is not supported.
+ * @exception std::bad_alloc        if memory allocation fails.
+ */
+std::auto_ptr<openvrml::local::fi_element>
+openvrml::local::read_fast_infoset(const char * const begin,
+                                   const char * const end)
+    OPENVRML_THROW2(fast_infoset_error, std::bad_alloc)
+{
+    fi_decoder decoder(begin, end);
+    return decoder.document();
+}
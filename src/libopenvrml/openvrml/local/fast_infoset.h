@@ -0,0 +1,95 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# ifndef OPENVRML_LOCAL_FAST_INFOSET_H
+#   define OPENVRML_LOCAL_FAST_INFOSET_H
+
+#   include <openvrml-common.h>
+#   include <boost/ptr_container/ptr_vector.hpp>
+#   include <memory>
+#   include <stdexcept>
+#   include <string>
+#   include <vector>
+
+namespace openvrml {
+
+    namespace local {
+
+        class OPENVRML_LOCAL fast_infoset_error : public std::runtime_error {
+        public:
+            explicit fast_infoset_error(const std::string & message);
+            virtual ~fast_infoset_error() throw ();
+        };
+
+
+        struct OPENVRML_LOCAL fi_string {
+            enum encoding_id { text_encoding, algorithm_encoding };
+
+            enum algorithm_id {
+                hexadecimal_algorithm,
+                base64_algorithm,
+                short_algorithm,
+                int_algorithm,
+                long_algorithm,
+                boolean_algorithm,
+                float_algorithm,
+                double_algorithm,
+                uuid_algorithm,
+                cdata_algorithm,
+                application_algorithm_start = 32
+            };
+
+            encoding_id encoding;
+            unsigned algorithm;
+            std::string algorithm_uri;
+            std::string data;
+
+            fi_string() OPENVRML_NOTHROW;
+        };
+
+
+        struct OPENVRML_LOCAL fi_attribute {
+            std::string name;
+            fi_string value;
+        };
+
+
+        class OPENVRML_LOCAL fi_element : boost::noncopyable {
+        public:
+            typedef std::vector<fi_attribute> attributes_t;
+            typedef boost::ptr_vector<fi_element> children_t;
+
+            std::string name;
+            attributes_t attributes;
+            children_t children;
+            std::string text;
+
+            const fi_attribute * attribute(const std::string & name) const
+                OPENVRML_NOTHROW;
+        };
+
+
+        OPENVRML_LOCAL std::auto_ptr<fi_element>
+        read_fast_infoset(const char * begin, const char * end)
+            OPENVRML_THROW2(fast_infoset_error, std::bad_alloc);
+    }
+}
+
+# endif // ifndef OPENVRML_LOCAL_FAST_INFOSET_H
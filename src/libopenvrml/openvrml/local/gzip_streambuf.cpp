@@ -0,0 +1,281 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+# ifdef OPENVRML_ENABLE_GZIP
+#   include "gzip_streambuf.h"
+#   include <algorithm>
+#   include <cstring>
+#   include <limits>
+
+/**
+ * @internal
+ *
+ * @class openvrml::local::gzip_error openvrml/local/gzip_streambuf.h
+ *
+ * @brief Exception thrown when a gzip-compressed stream cannot be inflated.
+ */
+
+/**
+ * @brief Construct.
+ *
+ * @param[in] message   error message.
+ */
+openvrml::local::gzip_error::gzip_error(const std::string & message):
+    std::runtime_error(message)
+{}
+
+/**
+ * @brief Destroy.
+ */
+openvrml::local::gzip_error::~gzip_error() throw ()
+{}
+
+
+/**
+ * @internal
+ *
+ * @class openvrml::local::gzip_streambuf openvrml/local/gzip_streambuf.h
+ *
+ * @brief A read-only @c std::streambuf that inflates a gzip-compressed
+ *        source @c std::streambuf.
+ *
+ * Data is read from the source and inflated a block at a time, so neither
+ * the compressed nor the uncompressed stream is ever held in memory in its
+ * entirety by the @c gzip_streambuf.  @c xsgetn inflates directly into the
+ * caller's buffer.  Several concatenated gzip members are read as a single
+ * stream, as @c gunzip does.
+ *
+ * Corrupt or truncated input results in a @c gzip_error being thrown from
+ * the reading operation.
+ */
+
+/**
+ * @var const std::size_t openvrml::local::gzip_streambuf::buffer_size
+ *
+ * @brief The size of the compressed and uncompressed buffers.
+ */
+
+/**
+ * @var std::streambuf & openvrml::local::gzip_streambuf::source_
+ *
+ * @brief The compressed source.
+ */
+
+/**
+ * @var z_stream openvrml::local::gzip_streambuf::stream_
+ *
+ * @brief zlib inflate state.
+ */
+
+/**
+ * @var bool openvrml::local::gzip_streambuf::end_
+ *
+ * @brief Whether the end of the last gzip member has been reached.
+ */
+
+/**
+ * @var std::vector<char> openvrml::local::gzip_streambuf::in_
+ *
+ * @brief Compressed data read from @a source_.
+ */
+
+/**
+ * @var std::vector<char> openvrml::local::gzip_streambuf::out_
+ *
+ * @brief The get area.
+ */
+
+/**
+ * @brief Determine whether a stream is gzip-compressed.
+ *
+ * Only the first byte is examined, so that nothing need be put back into
+ * @p source.  That is sufficient to tell a gzip stream from VRML or X3D
+ * text, which must begin with &ldquo;#&rdquo;; the rest of the gzip header
+ * is checked by zlib.
+ *
+ * @param[in] source    a @c std::streambuf.
+ *
+ * @return @c true if @p source appears to be gzip-compressed; @c false
+ *         otherwise.
+ */
+bool openvrml::local::gzip_streambuf::compressed(std::streambuf & source)
+{
+    return source.sgetc() == 0x1f;
+}
+
+/**
+ * @brief Construct.
+ *
+ * @param[in] source    the compressed source.
+ *
+ * @exception gzip_error        if zlib cannot be initialized.
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+openvrml::local::gzip_streambuf::gzip_streambuf(std::streambuf & source)
+    OPENVRML_THROW2(gzip_error, std::bad_alloc):
+    source_(source),
+    end_(false),
+    in_(buffer_size),
+    out_(buffer_size)
+{
+    std::memset(&this->stream_, 0, sizeof this->stream_);
+    this->stream_.zalloc = Z_NULL;
+    this->stream_.zfree = Z_NULL;
+    this->stream_.opaque = Z_NULL;
+    this->stream_.next_in = Z_NULL;
+    this->stream_.avail_in = 0;
+    //
+    // Adding 16 to the window bits selects gzip (rather than zlib) framing.
+    //
+    const int result = inflateInit2(&this->stream_, 16 + MAX_WBITS);
+    if (result == Z_MEM_ERROR) { throw std::bad_alloc(); }
+    if (result != Z_OK) {
+        throw gzip_error(this->stream_.msg
+                         ? this->stream_.msg
+                         : "failed to initialize zlib");
+    }
+    this->setg(&this->out_[0], &this->out_[0], &this->out_[0]);
+}
+
+/**
+ * @brief Destroy.
+ */
+openvrml::local::gzip_streambuf::~gzip_streambuf() OPENVRML_NOTHROW
+{
+    inflateEnd(&this->stream_);
+}
+
+/**
+ * @brief Inflate the next block into the get area.
+ *
+ * @return the next character, or @c traits_type::eof() at the end of the
+ *         uncompressed stream.
+ *
+ * @exception gzip_error    if the compressed stream is corrupt or truncated.
+ */
+openvrml::local::gzip_streambuf::int_type
+openvrml::local::gzip_streambuf::underflow()
+{
+    if (this->gptr() < this->egptr()) {
+        return traits_type::to_int_type(*this->gptr());
+    }
+    const std::streamsize count = this->inflate(&this->out_[0],
+                                                this->out_.size());
+    if (count == 0) { return traits_type::eof(); }
+    this->setg(&this->out_[0], &this->out_[0], &this->out_[0] + count);
+    return traits_type::to_int_type(*this->gptr());
+}
+
+/**
+ * @brief Read up to @p n characters.
+ *
+ * Anything left in the get area is copied first; the remainder is inflated
+ * directly into @p s.
+ *
+ * @param[out] s    destination buffer.
+ * @param[in]  n    size of @p s.
+ *
+ * @return the number of characters read.
+ *
+ * @exception gzip_error    if the compressed stream is corrupt or truncated.
+ */
+std::streamsize
+openvrml::local::gzip_streambuf::xsgetn(char_type * const s,
+                                        const std::streamsize n)
+{
+    const std::streamsize buffered =
+        std::min(n, std::streamsize(this->egptr() - this->gptr()));
+    std::copy(this->gptr(), this->gptr() + buffered, s);
+    this->gbump(static_cast<int>(buffered));
+
+    //
+    // z_stream::avail_out is a uInt; inflate in pieces that fit.
+    //
+    static const std::streamsize max_chunk =
+        std::numeric_limits<int>::max();
+    std::streamsize count = buffered;
+    while (count < n) {
+        const std::streamsize inflated =
+            this->inflate(s + count, std::min(n - count, max_chunk));
+        if (inflated == 0) { break; }
+        count += inflated;
+    }
+    return count;
+}
+
+/**
+ * @brief Inflate into @p dest.
+ *
+ * Compressed data is read from @a source_ as needed until at least one
+ * character has been produced or the end of the stream is reached.
+ *
+ * @param[out] dest destination buffer.
+ * @param[in]  n    size of @p dest.
+ *
+ * @return the number of characters written to @p dest; 0 at the end of the
+ *         stream.
+ *
+ * @exception gzip_error    if the compressed stream is corrupt or truncated.
+ */
+std::streamsize
+openvrml::local::gzip_streambuf::inflate(char * const dest,
+                                         const std::streamsize n)
+{
+    const uInt size = static_cast<uInt>(n);
+    this->stream_.next_out = reinterpret_cast<Bytef *>(dest);
+    this->stream_.avail_out = size;
+    while (this->stream_.avail_out == size && !this->end_) {
+        if (this->stream_.avail_in == 0) {
+            const std::streamsize count =
+                this->source_.sgetn(&this->in_[0], this->in_.size());
+            if (count <= 0) {
+                throw gzip_error("unexpected end of gzip-compressed data");
+            }
+            this->stream_.next_in = reinterpret_cast<Bytef *>(&this->in_[0]);
+            this->stream_.avail_in = static_cast<uInt>(count);
+        }
+        const int result = ::inflate(&this->stream_, Z_NO_FLUSH);
+        if (result == Z_STREAM_END) {
+            //
+            // Another gzip member may follow.
+            //
+            if (this->stream_.avail_in == 0
+                && traits_type::eq_int_type(this->source_.sgetc(),
+                                            traits_type::eof())) {
+                this->end_ = true;
+            } else {
+                inflateReset(&this->stream_);
+            }
+        } else if (result == Z_MEM_ERROR) {
+            throw std::bad_alloc();
+        } else if (result != Z_OK && result != Z_BUF_ERROR) {
+            throw gzip_error(this->stream_.msg
+                             ? this->stream_.msg
+                             : "invalid gzip-compressed data");
+        }
+    }
+    return n - this->stream_.avail_out;
+}
+
+# endif // defined OPENVRML_ENABLE_GZIP
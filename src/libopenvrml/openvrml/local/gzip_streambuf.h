@@ -0,0 +1,68 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# ifndef OPENVRML_LOCAL_GZIP_STREAMBUF_H
+#   define OPENVRML_LOCAL_GZIP_STREAMBUF_H
+
+#   include <openvrml-common.h>
+#   include <boost/utility.hpp>
+#   include <stdexcept>
+#   include <streambuf>
+#   include <vector>
+#   include <zlib.h>
+
+namespace openvrml {
+
+    namespace local {
+
+        class OPENVRML_LOCAL gzip_error : public std::runtime_error {
+        public:
+            explicit gzip_error(const std::string & message);
+            virtual ~gzip_error() throw ();
+        };
+
+
+        class OPENVRML_LOCAL gzip_streambuf : public std::streambuf,
+                                              boost::noncopyable {
+            static const std::size_t buffer_size = 64 * 1024;
+
+            std::streambuf & source_;
+            z_stream stream_;
+            bool end_;
+            std::vector<char> in_, out_;
+
+        public:
+            static bool compressed(std::streambuf & source);
+
+            explicit gzip_streambuf(std::streambuf & source)
+                OPENVRML_THROW2(gzip_error, std::bad_alloc);
+            virtual ~gzip_streambuf() OPENVRML_NOTHROW;
+
+        protected:
+            virtual int_type underflow();
+            virtual std::streamsize xsgetn(char_type * s, std::streamsize n);
+
+        private:
+            std::streamsize inflate(char * dest, std::streamsize n);
+        };
+    }
+}
+
+# endif // ifndef OPENVRML_LOCAL_GZIP_STREAMBUF_H
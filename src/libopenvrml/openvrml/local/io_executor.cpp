@@ -0,0 +1,811 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# include "io_executor.h"
+# include <boost/bind.hpp>
+# include <algorithm>
+# include <vector>
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+/**
+ * @internal
+ *
+ * @class openvrml::local::io_job openvrml/local/io_executor.h
+ *
+ * @brief A unit of work queued on an @c io_executor.
+ *
+ * The state of an @c io_job is guarded by its @c io_executor's mutex.
+ */
+
+/**
+ * @var openvrml::local::io_job::state_id
+ *
+ * @brief The state of an @c io_job.
+ */
+
+/**
+ * @var openvrml::local::io_job::state_id openvrml::local::io_job::queued
+ *
+ * @brief Waiting for a worker.
+ */
+
+/**
+ * @var openvrml::local::io_job::state_id openvrml::local::io_job::deferred
+ *
+ * @brief Waiting for its due time before it is queued.
+ */
+
+/**
+ * @var openvrml::local::io_job::state_id openvrml::local::io_job::running
+ *
+ * @brief Being run by a worker.
+ */
+
+/**
+ * @var openvrml::local::io_job::state_id openvrml::local::io_job::done
+ *
+ * @brief Finished running.
+ */
+
+/**
+ * @var openvrml::local::io_job::state_id openvrml::local::io_job::cancelled
+ *
+ * @brief Removed from the queue without having been run.
+ */
+
+/**
+ * @var openvrml::local::io_executor & openvrml::local::io_job::executor_
+ *
+ * @brief The @c io_executor the job was posted to.
+ */
+
+/**
+ * @var boost::function0<void> openvrml::local::io_job::function_
+ *
+ * @brief The work; cleared once it has been run or cancelled, so that any
+ *        resources it holds are released.
+ */
+
+/**
+ * @var float openvrml::local::io_job::priority_
+ *
+ * @brief Jobs with a lower priority value run first.
+ *
+ * A deferred job's priority may be raised when it is queued.
+ */
+
+/**
+ * @var unsigned long openvrml::local::io_job::sequence_
+ *
+ * @brief Jobs with equal priority run in the order they were queued.
+ */
+
+/**
+ * @var const bool openvrml::local::io_job::node_scoped_
+ *
+ * @brief Whether the job serves @c node%s in the scene graph, as opposed to
+ *        node types.
+ *
+ * Node-scoped jobs are cancelled by @c io_executor::cancel_node_jobs.
+ */
+
+/**
+ * @var openvrml::local::io_job::state_id openvrml::local::io_job::state_
+ *
+ * @brief The state of the job.
+ */
+
+/**
+ * @var boost::system_time openvrml::local::io_job::due_
+ *
+ * @brief When a deferred job is queued.
+ */
+
+/**
+ * @brief Construct.
+ *
+ * @param[in] executor      the @c io_executor.
+ * @param[in] function      the work.
+ * @param[in] priority      the priority; lower values run first.
+ * @param[in] sequence      the order in which the job was posted.
+ * @param[in] node_scoped   whether the job serves @c node%s in the scene
+ *                          graph.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+openvrml::local::io_job::io_job(io_executor & executor,
+                                const boost::function0<void> & function,
+                                const float priority,
+                                const unsigned long sequence,
+                                const bool node_scoped)
+    OPENVRML_THROW1(std::bad_alloc):
+    executor_(executor),
+    function_(function),
+    priority_(priority),
+    sequence_(sequence),
+    node_scoped_(node_scoped),
+    state_(queued),
+    due_()
+{}
+
+/**
+ * @brief Cancel the job if it has not started.
+ *
+ * @return @c true if the job was removed from the queue, or from the
+ *         deferred jobs; @c false if it has already started, finished, or
+ *         been cancelled.
+ */
+bool openvrml::local::io_job::cancel() OPENVRML_NOTHROW
+{
+    boost::function0<void> function;
+    {
+        boost::mutex::scoped_lock lock(this->executor_.mutex_);
+        if (this->state_ == queued) {
+            this->executor_.queue_.erase(this->shared_from_this());
+        } else if (this->state_ == deferred) {
+            this->executor_.deferred_.erase(this->shared_from_this());
+        } else {
+            return false;
+        }
+        this->state_ = cancelled;
+        function.swap(this->function_);
+    }
+    this->executor_.job_finished_.notify_all();
+    return true;
+}
+
+/**
+ * @brief Queue a deferred job now, rather than when it is due.
+ *
+ * This is how a job deferred until data arrives is woken.  The job is
+ * queued behind the jobs already in the queue, as it would be had it come
+ * due.
+ *
+ * @return @c true if the job was queued; @c false if it was not deferred,
+ *         or if memory allocation failed, in which case it stays deferred.
+ */
+bool openvrml::local::io_job::resume() OPENVRML_NOTHROW
+{
+    {
+        boost::mutex::scoped_lock lock(this->executor_.mutex_);
+        if (this->state_ != deferred) { return false; }
+        if (!this->executor_.queue(this->shared_from_this())) {
+            return false;
+        }
+    }
+    this->executor_.job_available_.notify_one();
+    return true;
+}
+
+/**
+ * @brief Make sure the job is not running.
+ *
+ * If the job has not started, it is cancelled; if it is running, this
+ * function blocks until it finishes.
+ *
+ * @pre This function is not called from the job itself.
+ */
+void openvrml::local::io_job::wait() OPENVRML_NOTHROW
+{
+    if (this->cancel()) { return; }
+    boost::mutex::scoped_lock lock(this->executor_.mutex_);
+    while (this->state_ == running) {
+        this->executor_.job_finished_.wait(lock);
+    }
+}
+
+/**
+ * @brief Whether the job has finished or been cancelled.
+ *
+ * @return @c true if the job has finished or been cancelled; @c false
+ *         otherwise.
+ */
+bool openvrml::local::io_job::finished() const OPENVRML_NOTHROW
+{
+    boost::mutex::scoped_lock lock(this->executor_.mutex_);
+    return this->state_ == done || this->state_ == cancelled;
+}
+
+
+/**
+ * @internal
+ *
+ * @class openvrml::local::io_executor openvrml/local/io_executor.h
+ *
+ * @brief A bounded pool of threads for loading resources.
+ *
+ * A @c browser owns one @c io_executor, through which stream reads, Inline
+ * loads, @c EXTERNPROTO implementation loads, and @c createVrmlFromURL
+ * requests are run, rather than each starting a thread of its own.  Jobs
+ * run in order of priority; callers use the distance from the viewer where
+ * they know it, so that nearby content loads first.
+ *
+ * Worker threads are started as jobs are posted, up to the limit set with
+ * @c #threads.
+ *
+ * A job that blocks waiting on another job that is still queued will
+ * deadlock the pool if every worker does the same; jobs should only wait on
+ * resources that are being produced independently of the pool.
+ */
+
+/**
+ * @internal
+ *
+ * @struct openvrml::local::io_executor::job_order
+ *
+ * @brief Orders jobs by priority and then by the order in which they were
+ *        posted.
+ */
+
+/**
+ * @brief Compare two jobs.
+ *
+ * @param[in] lhs   an @c io_job.
+ * @param[in] rhs   an @c io_job.
+ *
+ * @return @c true if @p lhs should run before @p rhs; @c false otherwise.
+ */
+bool
+openvrml::local::io_executor::job_order::
+operator()(const boost::shared_ptr<io_job> & lhs,
+           const boost::shared_ptr<io_job> & rhs) const
+    OPENVRML_NOTHROW
+{
+    if (lhs->priority_ != rhs->priority_) {
+        return lhs->priority_ < rhs->priority_;
+    }
+    return lhs->sequence_ < rhs->sequence_;
+}
+
+/**
+ * @internal
+ *
+ * @struct openvrml::local::io_executor::due_order
+ *
+ * @brief Orders deferred jobs by the time they are due.
+ */
+
+/**
+ * @brief Compare two deferred jobs.
+ *
+ * @param[in] lhs   an @c io_job.
+ * @param[in] rhs   an @c io_job.
+ *
+ * @return @c true if @p lhs is due before @p rhs; @c false otherwise.
+ */
+bool
+openvrml::local::io_executor::due_order::
+operator()(const boost::shared_ptr<io_job> & lhs,
+           const boost::shared_ptr<io_job> & rhs) const
+    OPENVRML_NOTHROW
+{
+    if (lhs->due_ != rhs->due_) { return lhs->due_ < rhs->due_; }
+    return std::less<io_job *>()(lhs.get(), rhs.get());
+}
+
+/**
+ * @typedef openvrml::local::io_executor::queue_t
+ *
+ * @brief Queued jobs, in the order they will run.
+ */
+
+/**
+ * @typedef openvrml::local::io_executor::deferred_t
+ *
+ * @brief Deferred jobs, in the order they are due.
+ */
+
+/**
+ * @var boost::mutex openvrml::local::io_executor::mutex_
+ *
+ * @brief Mutex guarding the queue, the counters, and the state of every
+ *        job.
+ */
+
+/**
+ * @var boost::condition_variable openvrml::local::io_executor::job_available_
+ *
+ * @brief Signaled when a job is queued or deferred, when the thread limit
+ *        is lowered, or when the workers are stopped.
+ */
+
+/**
+ * @var boost::condition_variable openvrml::local::io_executor::job_finished_
+ *
+ * @brief Signaled when a job finishes or is cancelled.
+ */
+
+/**
+ * @var boost::thread_group openvrml::local::io_executor::workers_
+ *
+ * @brief Worker threads.
+ */
+
+/**
+ * @var openvrml::local::io_executor::queue_t openvrml::local::io_executor::queue_
+ *
+ * @brief Queued jobs.
+ */
+
+/**
+ * @var openvrml::local::io_executor::deferred_t openvrml::local::io_executor::deferred_
+ *
+ * @brief Jobs waiting for their due time.
+ */
+
+/**
+ * @var std::size_t openvrml::local::io_executor::threads_
+ *
+ * @brief The maximum number of worker threads.
+ */
+
+/**
+ * @var std::size_t openvrml::local::io_executor::workers_started_
+ *
+ * @brief The number of worker threads that have been started and have not
+ *        exited.
+ */
+
+/**
+ * @var std::size_t openvrml::local::io_executor::idle_
+ *
+ * @brief The number of worker threads waiting for a job.
+ */
+
+/**
+ * @var std::size_t openvrml::local::io_executor::running_
+ *
+ * @brief The number of jobs being run.
+ */
+
+/**
+ * @var unsigned long openvrml::local::io_executor::sequence_
+ *
+ * @brief The sequence number for the next job.
+ */
+
+/**
+ * @var bool openvrml::local::io_executor::stopping_
+ *
+ * @brief Set to tell the workers to exit.
+ */
+
+/**
+ * @brief The number of threads a @c browser uses for loading resources by
+ *        default.
+ *
+ * Loading is mostly waiting on I/O, so this is more than the number of
+ * hardware threads.
+ *
+ * @return the default number of threads.
+ */
+std::size_t openvrml::local::io_executor::default_threads() OPENVRML_NOTHROW
+{
+    return (std::max)(std::size_t(8),
+                      std::size_t(boost::thread::hardware_concurrency()) * 2);
+}
+
+/**
+ * @brief Construct.
+ *
+ * No threads are started until a job is posted.
+ *
+ * @param[in] threads   the maximum number of worker threads.
+ *
+ * @pre @p threads > 0.
+ */
+openvrml::local::io_executor::io_executor(const std::size_t threads)
+    OPENVRML_NOTHROW:
+    threads_(threads),
+    workers_started_(0),
+    idle_(0),
+    running_(0),
+    sequence_(0),
+    stopping_(false)
+{
+    assert(threads > 0);
+}
+
+/**
+ * @brief Destroy.
+ *
+ * Queued jobs are cancelled; running jobs are waited for.
+ */
+openvrml::local::io_executor::~io_executor() OPENVRML_NOTHROW
+{
+    this->cancel_all();
+    {
+        boost::mutex::scoped_lock lock(this->mutex_);
+        this->stopping_ = true;
+    }
+    this->job_available_.notify_all();
+    this->workers_.join_all();
+}
+
+/**
+ * @brief Set the maximum number of worker threads.
+ *
+ * If @p n is less than the number of workers running, the surplus workers
+ * exit once they finish their current jobs.
+ *
+ * @param[in] n the maximum number of worker threads.
+ *
+ * @pre @p n > 0.
+ */
+void openvrml::local::io_executor::threads(const std::size_t n)
+    OPENVRML_NOTHROW
+{
+    assert(n > 0);
+    {
+        boost::mutex::scoped_lock lock(this->mutex_);
+        this->threads_ = n;
+    }
+    this->job_available_.notify_all();
+}
+
+/**
+ * @brief The maximum number of worker threads.
+ *
+ * @return the maximum number of worker threads.
+ */
+std::size_t openvrml::local::io_executor::threads() const OPENVRML_NOTHROW
+{
+    boost::mutex::scoped_lock lock(this->mutex_);
+    return this->threads_;
+}
+
+/**
+ * @brief Queue a job.
+ *
+ * A worker thread is started if every worker is busy and there are fewer
+ * than @c #threads of them.
+ *
+ * @param[in] function      the work.  It should not throw; anything it
+ *                          throws is discarded.
+ * @param[in] priority      the priority; lower values run first.  Callers
+ *                          that know the distance from the viewer to the
+ *                          content being loaded pass that.
+ * @param[in] node_scoped   whether the job serves @c node%s in the scene
+ *                          graph (streams, Inline scenes) rather than node
+ *                          types (@c EXTERNPROTO implementations).
+ *
+ * @return the job.
+ *
+ * @exception std::bad_alloc                if memory allocation fails.
+ * @exception boost::thread_resource_error  if there are no worker threads
+ *                                          and one cannot be started.
+ */
+const boost::shared_ptr<openvrml::local::io_job>
+openvrml::local::io_executor::post(const boost::function0<void> & function,
+                                   const float priority,
+                                   const bool node_scoped)
+    OPENVRML_THROW2(std::bad_alloc, boost::thread_resource_error)
+{
+    boost::mutex::scoped_lock lock(this->mutex_);
+    const boost::shared_ptr<io_job> job(
+        new io_job(*this, function, priority, this->sequence_++, node_scoped));
+    this->queue_.insert(job);
+    if (this->queue_.size() > this->idle_
+        && this->workers_started_ < this->threads_) {
+        this->start_worker(job);
+    }
+    this->job_available_.notify_one();
+    return job;
+}
+
+/**
+ * @brief Queue a job behind the jobs already queued, once a delay has
+ *        passed.
+ *
+ * This is for work that is waiting on something outside the pool, such as
+ * a stream that has no data yet; it gives the thread up without going back
+ * ahead of the other jobs.  When the job is due, it is queued with
+ * @p priority or the priority of the last job in the queue, whichever is
+ * greater, so that it runs after every job queued before it.
+ *
+ * If @p delay is @c boost::posix_time::pos_infin, the job is never due; it
+ * is queued when @c io_job::resume is called, or cancelled.
+ *
+ * @param[in] function      the work.  It should not throw; anything it
+ *                          throws is discarded.
+ * @param[in] priority      the priority; lower values run first.
+ * @param[in] node_scoped   whether the job serves @c node%s in the scene
+ *                          graph.
+ * @param[in] delay         how long to wait before queuing the job.
+ *
+ * @return the job.
+ *
+ * @exception std::bad_alloc                if memory allocation fails.
+ * @exception boost::thread_resource_error  if there are no worker threads
+ *                                          and one cannot be started.
+ */
+const boost::shared_ptr<openvrml::local::io_job>
+openvrml::local::io_executor::
+defer(const boost::function0<void> & function,
+      const float priority,
+      const bool node_scoped,
+      const boost::posix_time::time_duration & delay)
+    OPENVRML_THROW2(std::bad_alloc, boost::thread_resource_error)
+{
+    boost::mutex::scoped_lock lock(this->mutex_);
+    const boost::shared_ptr<io_job> job(
+        new io_job(*this, function, priority, 0, node_scoped));
+    job->state_ = io_job::deferred;
+    job->due_ = boost::get_system_time() + delay;
+    this->deferred_.insert(job);
+    if (this->workers_started_ == 0) { this->start_worker(job); }
+    //
+    // Wake a worker, if one is idle, so that it waits for the job's due
+    // time.
+    //
+    this->job_available_.notify_one();
+    return job;
+}
+
+/**
+ * @brief Start a worker thread.
+ *
+ * If no thread can be started and there are no workers, @p job is removed
+ * from the queue or the deferred jobs.
+ *
+ * @param[in] job   the job the worker is started for.
+ *
+ * @exception boost::thread_resource_error  if there are no worker threads
+ *                                          and one cannot be started.
+ *
+ * @pre @c #mutex_ is locked.
+ */
+void
+openvrml::local::io_executor::
+start_worker(const boost::shared_ptr<io_job> & job)
+    OPENVRML_THROW1(boost::thread_resource_error)
+{
+    try {
+        this->workers_.create_thread(boost::bind(&io_executor::work, this));
+        ++this->workers_started_;
+    } catch (boost::thread_resource_error &) {
+        //
+        // Carry on with the workers we have, if any.
+        //
+        if (this->workers_started_ == 0) {
+            if (job->state_ == io_job::deferred) {
+                this->deferred_.erase(job);
+            } else {
+                this->queue_.erase(job);
+            }
+            throw;
+        }
+    }
+}
+
+/**
+ * @brief Move the deferred jobs that are due to the queue.
+ *
+ * Each is queued behind the jobs already in the queue.
+ *
+ * @pre @c #mutex_ is locked.
+ */
+void openvrml::local::io_executor::queue_due_jobs() OPENVRML_NOTHROW
+{
+    const boost::system_time now = boost::get_system_time();
+    while (!this->deferred_.empty()
+           && (*this->deferred_.begin())->due_ <= now) {
+        //
+        // If the job cannot be queued, leave it deferred; it is tried again
+        // the next time a worker looks for a job.
+        //
+        const boost::shared_ptr<io_job> job = *this->deferred_.begin();
+        if (!this->queue(job)) { return; }
+    }
+}
+
+/**
+ * @brief Move a deferred job to the queue, behind the jobs already in it.
+ *
+ * @param[in] job   a deferred job.
+ *
+ * @return @c true if @p job was queued; @c false if memory allocation
+ *         failed, in which case it is still deferred.
+ *
+ * @pre @c #mutex_ is locked.
+ */
+bool
+openvrml::local::io_executor::queue(const boost::shared_ptr<io_job> & job)
+    OPENVRML_NOTHROW
+{
+    assert(job->state_ == io_job::deferred);
+    const float priority = job->priority_;
+    const unsigned long sequence = job->sequence_;
+    if (!this->queue_.empty()) {
+        job->priority_ = (std::max)(job->priority_,
+                                    (*this->queue_.rbegin())->priority_);
+    }
+    job->sequence_ = this->sequence_++;
+    try {
+        this->queue_.insert(job);
+    } catch (std::bad_alloc &) {
+        job->priority_ = priority;
+        job->sequence_ = sequence;
+        return false;
+    }
+    this->deferred_.erase(job);
+    job->state_ = io_job::queued;
+    return true;
+}
+
+/**
+ * @brief Cancel the jobs in @p jobs that serve @c node%s in the scene graph.
+ *
+ * The cancelled jobs are added to @p cancelled, so that their functions can
+ * be released once the mutex is unlocked; if that fails, a job's function
+ * is released here.
+ *
+ * @param[in,out] jobs      @c #queue_ or @c #deferred_.
+ * @param[in,out] cancelled the jobs cancelled.
+ *
+ * @pre @c #mutex_ is locked.
+ */
+template <typename Jobs>
+void
+openvrml::local::io_executor::
+cancel_node_scoped(Jobs & jobs,
+                   std::vector<boost::shared_ptr<io_job> > & cancelled)
+    OPENVRML_NOTHROW
+{
+    for (typename Jobs::iterator job = jobs.begin(); job != jobs.end();) {
+        if ((*job)->node_scoped_) {
+            (*job)->state_ = io_job::cancelled;
+            try {
+                cancelled.push_back(*job);
+            } catch (std::bad_alloc &) {
+                (*job)->function_.clear();
+            }
+            jobs.erase(job++);
+        } else {
+            ++job;
+        }
+    }
+}
+
+/**
+ * @brief Cancel every job in @p jobs.
+ *
+ * @param[in,out] jobs  @c #queue_ or @c #deferred_.
+ *
+ * @pre @c #mutex_ is locked.
+ */
+template <typename Jobs>
+void openvrml::local::io_executor::cancel_every(Jobs & jobs)
+    OPENVRML_NOTHROW
+{
+    for (typename Jobs::const_iterator job = jobs.begin();
+         job != jobs.end();
+         ++job) {
+        (*job)->state_ = io_job::cancelled;
+        (*job)->function_.clear();
+    }
+    jobs.clear();
+}
+
+/**
+ * @brief Cancel the queued and deferred jobs that serve @c node%s in the
+ *        scene graph.
+ *
+ * This is called when the root @c node%s of the world are replaced.  Jobs
+ * that load node types are left alone, since the new @c node%s may be
+ * instances of them.
+ */
+void openvrml::local::io_executor::cancel_node_jobs() OPENVRML_NOTHROW
+{
+    std::vector<boost::shared_ptr<io_job> > cancelled;
+    {
+        boost::mutex::scoped_lock lock(this->mutex_);
+        cancel_node_scoped(this->queue_, cancelled);
+        cancel_node_scoped(this->deferred_, cancelled);
+    }
+    for (std::vector<boost::shared_ptr<io_job> >::const_iterator job =
+             cancelled.begin();
+         job != cancelled.end();
+         ++job) {
+        (*job)->function_.clear();
+    }
+    this->job_finished_.notify_all();
+}
+
+/**
+ * @brief Cancel every queued job and wait for the running ones to finish.
+ *
+ * Jobs queued by running jobs are cancelled too.  This is called when the
+ * world is replaced and when the @c browser is destroyed.
+ *
+ * @pre This function is not called from a job.
+ */
+void openvrml::local::io_executor::cancel_all() OPENVRML_NOTHROW
+{
+    boost::mutex::scoped_lock lock(this->mutex_);
+    for (;;) {
+        cancel_every(this->queue_);
+        cancel_every(this->deferred_);
+        this->job_finished_.notify_all();
+        while (this->running_ > 0) { this->job_finished_.wait(lock); }
+        if (this->queue_.empty() && this->deferred_.empty()) { break; }
+    }
+}
+
+/**
+ * @brief Run jobs until the workers are stopped or there are more workers
+ *        than @c #threads.
+ */
+void openvrml::local::io_executor::work() OPENVRML_NOTHROW
+{
+    boost::mutex::scoped_lock lock(this->mutex_);
+    for (;;) {
+        ++this->idle_;
+        for (;;) {
+            this->queue_due_jobs();
+            if (this->stopping_
+                || !this->queue_.empty()
+                || this->workers_started_ > this->threads_) {
+                break;
+            }
+            //
+            // Jobs deferred until they are resumed are never due.
+            //
+            if (this->deferred_.empty()
+                || (*this->deferred_.begin())->due_.is_pos_infinity()) {
+                this->job_available_.wait(lock);
+            } else {
+                this->job_available_.timed_wait(
+                    lock,
+                    (*this->deferred_.begin())->due_);
+            }
+        }
+        --this->idle_;
+        if (this->stopping_ || this->workers_started_ > this->threads_) {
+            --this->workers_started_;
+            return;
+        }
+
+        const boost::shared_ptr<io_job> job = *this->queue_.begin();
+        this->queue_.erase(this->queue_.begin());
+        job->state_ = io_job::running;
+        ++this->running_;
+
+        boost::function0<void> function;
+        function.swap(job->function_);
+        lock.unlock();
+        try {
+            function();
+        } catch (...) {
+            //
+            // Jobs are expected to report their own errors.
+            //
+        }
+        function.clear();
+        lock.lock();
+
+        job->state_ = io_job::done;
+        --this->running_;
+        this->job_finished_.notify_all();
+    }
+}
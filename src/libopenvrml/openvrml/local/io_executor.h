@@ -0,0 +1,145 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# ifndef OPENVRML_LOCAL_IO_EXECUTOR_H
+#   define OPENVRML_LOCAL_IO_EXECUTOR_H
+
+#   include <openvrml-common.h>
+#   include <boost/enable_shared_from_this.hpp>
+#   include <boost/function.hpp>
+#   include <boost/shared_ptr.hpp>
+#   include <boost/thread.hpp>
+#   include <boost/utility.hpp>
+#   include <set>
+#   include <vector>
+
+namespace openvrml {
+
+    namespace local {
+
+        class io_executor;
+
+        class OPENVRML_LOCAL io_job :
+            public boost::enable_shared_from_this<io_job>,
+            boost::noncopyable {
+            friend class io_executor;
+
+            enum state_id { queued, deferred, running, done, cancelled };
+
+            io_executor & executor_;
+            boost::function0<void> function_;
+            float priority_;
+            unsigned long sequence_;
+            const bool node_scoped_;
+            state_id state_;
+            boost::system_time due_;
+
+        public:
+            io_job(io_executor & executor,
+                   const boost::function0<void> & function,
+                   float priority,
+                   unsigned long sequence,
+                   bool node_scoped)
+                OPENVRML_THROW1(std::bad_alloc);
+
+            bool cancel() OPENVRML_NOTHROW;
+            bool resume() OPENVRML_NOTHROW;
+            void wait() OPENVRML_NOTHROW;
+            bool finished() const OPENVRML_NOTHROW;
+        };
+
+
+        class OPENVRML_LOCAL io_executor : boost::noncopyable {
+            friend class io_job;
+
+            struct job_order {
+                bool operator()(const boost::shared_ptr<io_job> & lhs,
+                                const boost::shared_ptr<io_job> & rhs) const
+                    OPENVRML_NOTHROW;
+            };
+
+            struct due_order {
+                bool operator()(const boost::shared_ptr<io_job> & lhs,
+                                const boost::shared_ptr<io_job> & rhs) const
+                    OPENVRML_NOTHROW;
+            };
+
+            typedef std::set<boost::shared_ptr<io_job>, job_order> queue_t;
+            typedef std::set<boost::shared_ptr<io_job>, due_order>
+                deferred_t;
+
+            mutable boost::mutex mutex_;
+            boost::condition_variable job_available_, job_finished_;
+            boost::thread_group workers_;
+            queue_t queue_;
+            deferred_t deferred_;
+            std::size_t threads_;
+            std::size_t workers_started_;
+            std::size_t idle_;
+            std::size_t running_;
+            unsigned long sequence_;
+            bool stopping_;
+
+        public:
+            static std::size_t default_threads() OPENVRML_NOTHROW;
+
+            explicit io_executor(std::size_t threads) OPENVRML_NOTHROW;
+            ~io_executor() OPENVRML_NOTHROW;
+
+            void threads(std::size_t n) OPENVRML_NOTHROW;
+            std::size_t threads() const OPENVRML_NOTHROW;
+
+            const boost::shared_ptr<io_job>
+            post(const boost::function0<void> & function,
+                 float priority,
+                 bool node_scoped)
+                OPENVRML_THROW2(std::bad_alloc, boost::thread_resource_error);
+
+            const boost::shared_ptr<io_job>
+            defer(const boost::function0<void> & function,
+                  float priority,
+                  bool node_scoped,
+                  const boost::posix_time::time_duration & delay)
+                OPENVRML_THROW2(std::bad_alloc, boost::thread_resource_error);
+
+            void cancel_node_jobs() OPENVRML_NOTHROW;
+            void cancel_all() OPENVRML_NOTHROW;
+
+        private:
+            template <typename Jobs>
+            static void
+            cancel_node_scoped(Jobs & jobs,
+                               std::vector<boost::shared_ptr<io_job> > &
+                               cancelled)
+                OPENVRML_NOTHROW;
+            template <typename Jobs>
+            static void cancel_every(Jobs & jobs) OPENVRML_NOTHROW;
+
+            void start_worker(const boost::shared_ptr<io_job> & job)
+                OPENVRML_THROW1(boost::thread_resource_error);
+            bool queue(const boost::shared_ptr<io_job> & job)
+                OPENVRML_NOTHROW;
+            void queue_due_jobs() OPENVRML_NOTHROW;
+            void work() OPENVRML_NOTHROW;
+        };
+    }
+}
+
+# endif // ifndef OPENVRML_LOCAL_IO_EXECUTOR_H
@@ -0,0 +1,224 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# include "mapped_file.h"
+# include <boost/algorithm/string/predicate.hpp>
+# include <boost/filesystem/operations.hpp>
+# include <boost/interprocess/file_mapping.hpp>
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+/**
+ * @internal
+ *
+ * @class openvrml::local::mapped_file_streambuf openvrml/local/mapped_file.h
+ *
+ * @brief A @c buffer_streambuf over a memory-mapped file.
+ */
+
+/**
+ * @var boost::interprocess::mapped_region openvrml::local::mapped_file_streambuf::region_
+ *
+ * @brief The mapping.
+ *
+ * This is empty for a zero-length file.
+ */
+
+/**
+ * @var bool openvrml::local::mapped_file_streambuf::open_
+ *
+ * @brief Whether a file has been successfully opened.
+ */
+
+/**
+ * @brief Construct.
+ */
+openvrml::local::mapped_file_streambuf::mapped_file_streambuf()
+    OPENVRML_NOTHROW:
+    open_(false)
+{}
+
+/**
+ * @brief Destroy.
+ */
+openvrml::local::mapped_file_streambuf::~mapped_file_streambuf()
+    OPENVRML_NOTHROW
+{}
+
+/**
+ * @brief Map a file.
+ *
+ * @param[in] path  the path to a file.
+ *
+ * @return @c true if the file was mapped; @c false otherwise.
+ */
+bool
+openvrml::local::mapped_file_streambuf::open(const std::string & path)
+    OPENVRML_NOTHROW
+{
+    using boost::interprocess::file_mapping;
+    using boost::interprocess::mapped_region;
+    using boost::interprocess::read_only;
+
+    try {
+        //
+        // A zero-length file cannot be mapped; it is simply an empty get
+        // area.
+        //
+        if (boost::filesystem::file_size(path) > 0) {
+            const file_mapping file(path.c_str(), read_only);
+            mapped_region region(file, read_only);
+            region.advise(mapped_region::advice_sequential);
+            this->region_.swap(region);
+        }
+    } catch (const boost::interprocess::interprocess_exception &) {
+        return false;
+    } catch (const boost::filesystem::filesystem_error &) {
+        return false;
+    }
+    const char * const begin =
+        static_cast<const char *>(this->region_.get_address());
+    this->buffer(begin, begin + this->region_.get_size());
+    this->open_ = true;
+    return true;
+}
+
+/**
+ * @brief Whether a file has been successfully mapped.
+ *
+ * @return @c true if a file has been successfully mapped; @c false
+ *         otherwise.
+ */
+bool openvrml::local::mapped_file_streambuf::is_open() const OPENVRML_NOTHROW
+{
+    return this->open_;
+}
+
+/**
+ * @internal
+ *
+ * @class openvrml::local::mapped_file_istream openvrml/local/mapped_file.h
+ *
+ * @brief A @c resource_istream for a local file, read through a
+ *        @c mapped_file_streambuf.
+ */
+
+/**
+ * @var const std::string openvrml::local::mapped_file_istream::url_
+ *
+ * @brief The URL of the file.
+ */
+
+/**
+ * @var openvrml::local::mapped_file_streambuf openvrml::local::mapped_file_istream::buf_
+ *
+ * @brief The mapping.
+ */
+
+/**
+ * @brief Construct.
+ *
+ * If the file cannot be mapped, the stream's @c failbit is set.
+ *
+ * @param[in] url   the URL of the file.
+ * @param[in] path  the file system path of the file.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+openvrml::local::mapped_file_istream::
+mapped_file_istream(const std::string & url, const std::string & path)
+    OPENVRML_THROW1(std::bad_alloc):
+    resource_istream(&this->buf_),
+    url_(url)
+{
+    if (!this->buf_.open(path)) { this->setstate(ios_base::failbit); }
+}
+
+/**
+ * @brief Destroy.
+ */
+openvrml::local::mapped_file_istream::~mapped_file_istream() OPENVRML_NOTHROW
+{}
+
+/**
+ * @brief The URL of the file.
+ *
+ * @return the URL of the file.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+const std::string openvrml::local::mapped_file_istream::do_url() const
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    return this->url_;
+}
+
+/**
+ * @brief The MIME media type of the file, according to its extension.
+ *
+ * @return the MIME media type of the file.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+const std::string openvrml::local::mapped_file_istream::do_type() const
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    using std::string;
+    using boost::algorithm::iequals;
+
+    string media_type = "application/octet-stream";
+    const string::size_type end = this->url_.find_first_of("?#");
+    const string path = this->url_.substr(0, end);
+    const string::size_type dot = path.find_last_of("./");
+    if (dot == string::npos || path[dot] != '.') { return media_type; }
+    const string ext = path.substr(dot + 1);
+    if (iequals(ext, "wrl") || iequals(ext, "wrz")) {
+        media_type = openvrml::vrml_media_type;
+    } else if (iequals(ext, "x3dv") || iequals(ext, "x3dvz")) {
+        media_type = openvrml::x3d_vrml_media_type;
+    } else if (iequals(ext, "x3db")) {
+        media_type = openvrml::x3d_binary_media_type;
+    } else if (iequals(ext, "png")) {
+        media_type = "image/png";
+    } else if (iequals(ext, "jpg") || iequals(ext, "jpeg")) {
+        media_type = "image/jpeg";
+    } else if (iequals(ext, "class")) {
+        media_type = "application/java";
+    } else if (iequals(ext, "js")) {
+        media_type = "application/javascript";
+    }
+    return media_type;
+}
+
+/**
+ * @brief Whether the file was mapped.
+ *
+ * The whole file is available as soon as it is mapped.
+ *
+ * @return @c true if the stream is in a good state; @c false otherwise.
+ */
+bool openvrml::local::mapped_file_istream::do_data_available() const
+    OPENVRML_NOTHROW
+{
+    return !!(*this);
+}
+
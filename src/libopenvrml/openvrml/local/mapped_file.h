@@ -0,0 +1,67 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# ifndef OPENVRML_LOCAL_MAPPED_FILE_H
+#   define OPENVRML_LOCAL_MAPPED_FILE_H
+
+#   include <openvrml/local/buffer_streambuf.h>
+#   include <openvrml/browser.h>
+#   include <boost/interprocess/mapped_region.hpp>
+
+namespace openvrml {
+
+    namespace local {
+
+        class OPENVRML_LOCAL mapped_file_streambuf : public buffer_streambuf {
+            boost::interprocess::mapped_region region_;
+            bool open_;
+
+        public:
+            mapped_file_streambuf() OPENVRML_NOTHROW;
+            virtual ~mapped_file_streambuf() OPENVRML_NOTHROW;
+
+            bool open(const std::string & path) OPENVRML_NOTHROW;
+            bool is_open() const OPENVRML_NOTHROW;
+        };
+
+
+        class OPENVRML_LOCAL mapped_file_istream :
+            public openvrml::resource_istream {
+
+            const std::string url_;
+            mapped_file_streambuf buf_;
+
+        public:
+            mapped_file_istream(const std::string & url,
+                                const std::string & path)
+                OPENVRML_THROW1(std::bad_alloc);
+            virtual ~mapped_file_istream() OPENVRML_NOTHROW;
+
+        private:
+            virtual const std::string do_url() const
+                OPENVRML_THROW1(std::bad_alloc);
+            virtual const std::string do_type() const
+                OPENVRML_THROW1(std::bad_alloc);
+            virtual bool do_data_available() const OPENVRML_NOTHROW;
+        };
+    }
+}
+
+# endif // ifndef OPENVRML_LOCAL_MAPPED_FILE_H
@@ -0,0 +1,231 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# include "mesh_compiler.h"
+# include "compiling_viewer.h"
+# include "compute_executor.h"
+# include "worker_scope.h"
+# include <openvrml/compiled_mesh.h>
+# include <openvrml/node.h>
+# include <openvrml/viewer.h>
+# include <boost/scoped_ptr.hpp>
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+namespace {
+
+    //
+    // Collects the geometry nodes in a scene, each once.
+    //
+    class OPENVRML_LOCAL geometry_collector :
+        public openvrml::node_traverser {
+        std::vector<openvrml::geometry_node *> & geometry_;
+
+    public:
+        explicit geometry_collector(
+            std::vector<openvrml::geometry_node *> & geometry)
+            OPENVRML_THROW1(std::bad_alloc):
+            geometry_(geometry)
+        {}
+
+        virtual ~geometry_collector() OPENVRML_NOTHROW
+        {}
+
+    private:
+        virtual void on_entering(openvrml::node & n)
+            OPENVRML_THROW1(std::bad_alloc)
+        {
+            using openvrml::node_cast;
+            using openvrml::geometry_node;
+            if (geometry_node * const geometry =
+                node_cast<geometry_node *>(&n)) {
+                this->geometry_.push_back(geometry);
+            }
+        }
+    };
+}
+
+/**
+ * @internal
+ *
+ * @class openvrml::local::mesh_compiler
+ *
+ * @brief Compile the meshes of a scene's geometry nodes on several threads.
+ *
+ * Each geometry node is compiled as its @c viewer would compile it when it
+ * is first drawn, and its mesh is added to a @c compiled_mesh_cache; any
+ * normals the node generates, and its bounding volume, are computed along
+ * the way.  A @c viewer that draws the scene afterward finds the meshes in
+ * the cache and need only load them.
+ *
+ * The geometry nodes are rendered into a @c viewer that draws nothing,
+ * without their modified flags being cleared: a node that has been modified
+ * is left for its @c viewer, which must discard what it has for the node.
+ * A node modified after it has been compiled is compiled again when it is
+ * next drawn; @c geometry_node::render_geometry discards the mesh in the
+ * cache.  The scene may be rendered meanwhile; a geometry node is compiled
+ * or rendered by one thread at a time.
+ *
+ * The nodes are compiled on the calling thread and the workers of the
+ * @c browser's @c compute_executor.  When they are compiled on several
+ * threads, each node's normals are generated on the thread compiling it.
+ */
+
+/**
+ * @var openvrml::compiled_mesh_cache & openvrml::local::mesh_compiler::cache_
+ *
+ * @brief The cache the meshes are added to.
+ */
+
+/**
+ * @var std::vector<openvrml::geometry_node *> openvrml::local::mesh_compiler::geometry_
+ *
+ * @brief The geometry nodes to compile.
+ */
+
+/**
+ * @brief Construct.
+ *
+ * @param[in,out] cache the cache the meshes are added to.
+ * @param[in] nodes     the root nodes of a scene.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+openvrml::local::mesh_compiler::
+mesh_compiler(compiled_mesh_cache & cache,
+              const std::vector<boost::intrusive_ptr<node> > & nodes)
+    OPENVRML_THROW1(std::bad_alloc):
+    cache_(cache)
+{
+    geometry_collector(this->geometry_).traverse(nodes);
+}
+
+/**
+ * @brief The number of geometry nodes to compile.
+ *
+ * @return the number of geometry nodes to compile.
+ */
+std::size_t openvrml::local::mesh_compiler::geometry_nodes() const
+    OPENVRML_NOTHROW
+{
+    return this->geometry_.size();
+}
+
+/**
+ * @internal
+ *
+ * @class openvrml::local::mesh_compiler::batch
+ *
+ * @brief Compiles a range of a @c mesh_compiler's geometry nodes.
+ */
+class OPENVRML_LOCAL openvrml::local::mesh_compiler::batch {
+    mesh_compiler & compiler_;
+    const bool shared_;
+
+public:
+    batch(mesh_compiler & compiler, const bool shared) OPENVRML_NOTHROW:
+        compiler_(compiler),
+        shared_(shared)
+    {}
+
+    //
+    // If other threads are compiling too, the work for each node is not
+    // split across more threads.
+    //
+    void operator()(const std::size_t begin, const std::size_t end)
+        OPENVRML_NOTHROW
+    {
+        boost::scoped_ptr<worker_scope> scope(
+            this->shared_ ? new worker_scope : 0);
+        for (std::size_t i = begin; i < end; ++i) {
+            this->compiler_.compile(*this->compiler_.geometry_[i]);
+        }
+    }
+};
+
+/**
+ * @brief Compile the meshes.
+ *
+ * The calling thread takes part in the work, helped by as many of the
+ * workers of @p executor as are free to.  @p executor is also used to
+ * generate normals for a large mesh when the calling thread is the only
+ * one compiling.
+ *
+ * @param[in,out] executor  the threads shared by the @c browser's
+ *                          computations.
+ * @param[in] threads       the most threads to compile on, including the
+ *                          calling thread.
+ */
+void
+openvrml::local::mesh_compiler::run(compute_executor & executor,
+                                    const std::size_t threads)
+    OPENVRML_NOTHROW
+{
+    const compute_executor::scope scope(executor);
+    const bool shared = threads > 1
+        && this->geometry_.size() > 1
+        && executor.threads() > 0;
+    batch compile(*this, shared);
+    if (!shared) {
+        compile(0, this->geometry_.size());
+        return;
+    }
+    try {
+        for_each_batch(executor, this->geometry_.size(), 1, threads - 1,
+                       compile);
+    } catch (std::bad_alloc &) {
+        //
+        // Whatever was not compiled is left for the viewer.
+        //
+    }
+}
+
+/**
+ * @brief Compile the mesh for a geometry node.
+ *
+ * If compiling @p n fails, it is skipped; its @c viewer compiles it when it
+ * is drawn.
+ *
+ * @param[in,out] n a geometry node.
+ */
+void openvrml::local::mesh_compiler::compile(geometry_node & n)
+    OPENVRML_NOTHROW
+{
+    using boost::shared_lock;
+    using boost::shared_mutex;
+
+    try {
+        shared_lock<shared_mutex> lock(n.scene_mutex());
+        boost::mutex::scoped_lock render_lock(n.render_mutex_);
+        if (!n.scene() || n.modified()) { return; }
+
+        compiling_viewer v(this->cache_);
+        n.do_render_geometry(v, rendering_context());
+        n.bounding_volume();
+
+        //
+        // If the node was modified while it was being compiled, the mesh may
+        // be of neither the old geometry nor the new.
+        //
+        if (n.modified()) { this->cache_.invalidate(n); }
+    } catch (std::exception &) {}
+}
@@ -0,0 +1,62 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# ifndef OPENVRML_LOCAL_MESH_COMPILER_H
+#   define OPENVRML_LOCAL_MESH_COMPILER_H
+
+#   include <openvrml-common.h>
+#   include <boost/intrusive_ptr.hpp>
+#   include <boost/utility.hpp>
+#   include <vector>
+
+namespace openvrml {
+
+    class node;
+    class geometry_node;
+    class compiled_mesh_cache;
+
+    namespace local {
+
+        class compute_executor;
+
+        class OPENVRML_LOCAL mesh_compiler : boost::noncopyable {
+            class batch;
+
+            compiled_mesh_cache & cache_;
+            std::vector<geometry_node *> geometry_;
+
+        public:
+            mesh_compiler(
+                compiled_mesh_cache & cache,
+                const std::vector<boost::intrusive_ptr<node> > & nodes)
+                OPENVRML_THROW1(std::bad_alloc);
+
+            std::size_t geometry_nodes() const OPENVRML_NOTHROW;
+
+            void run(compute_executor & executor, std::size_t threads)
+                OPENVRML_NOTHROW;
+
+        private:
+            void compile(geometry_node & n) OPENVRML_NOTHROW;
+        };
+    }
+}
+
+# endif // ifndef OPENVRML_LOCAL_MESH_COMPILER_H
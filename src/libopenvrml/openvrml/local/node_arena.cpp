@@ -0,0 +1,291 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# include "node_arena.h"
+# include <boost/thread/tss.hpp>
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+namespace {
+
+    //
+    // Each node allocation is prefixed with a header that identifies the
+    // arena it came from (or 0 if it came from the free store).  The union
+    // members other than arena are there to give the header the strictest
+    // fundamental alignment, so that the node that follows it is suitably
+    // aligned.
+    //
+    union OPENVRML_LOCAL header {
+        openvrml::local::node_arena * arena;
+        long double ld;
+        double d;
+        long l;
+        void * p;
+    };
+
+    //
+    // The node_arena is owned by the scene that activates it; the
+    // thread_specific_ptr must not delete it.
+    //
+    OPENVRML_LOCAL void no_cleanup(openvrml::local::node_arena *)
+    {}
+
+    boost::thread_specific_ptr<openvrml::local::node_arena>
+        current_arena(&no_cleanup);
+
+    OPENVRML_LOCAL std::size_t round_up(const std::size_t size)
+    {
+        return (size + sizeof (header) - 1) / sizeof (header) * sizeof (header);
+    }
+}
+
+/**
+ * @internal
+ *
+ * @class openvrml::local::node_arena
+ *
+ * @brief Arena for the @c node%s of a @c scene.
+ *
+ * While a @c node_arena is current on a thread (see @c node_arena::scope),
+ * @c node::operator new places @c node%s in the arena's chunks rather than
+ * allocating each one from the free store.  @c scene::load makes a new
+ * arena current while the @c scene is parsed, so the @c node%s of a
+ * @c scene (including their inline field, eventIn and eventOut members) are
+ * laid out contiguously in the order they are parsed.
+ *
+ * Memory for individual @c node%s is not reused; deleting a @c node only
+ * drops its reference to the arena.  The chunks are freed together once
+ * the @c scene has let the arena go (when it is destroyed or loaded again)
+ * and every @c node allocated from the arena is gone.  A
+ * @c node that outlives its @c scene (for example, because a @c Script holds
+ * a reference to it) keeps the arena alive.
+ */
+
+/**
+ * @var const std::size_t openvrml::local::node_arena::chunk_size
+ *
+ * @brief The size of the chunks carved up by the arena.
+ *
+ * Allocations larger than a quarter of this get a chunk of their own.
+ */
+
+/**
+ * @var boost::detail::atomic_count openvrml::local::node_arena::ref_count_
+ *
+ * @brief The number of references to the arena: one for the owning
+ *        @c scene, plus one for each live @c node allocated from it.
+ */
+
+/**
+ * @var boost::mutex openvrml::local::node_arena::mutex_
+ *
+ * @brief Mutex guarding @c #chunks_, @c #next_ and @c #end_.
+ */
+
+/**
+ * @var std::vector<char *> openvrml::local::node_arena::chunks_
+ *
+ * @brief The chunks allocated by the arena.
+ */
+
+/**
+ * @var char * openvrml::local::node_arena::next_
+ *
+ * @brief The next free byte in the current chunk.
+ */
+
+/**
+ * @var char * openvrml::local::node_arena::end_
+ *
+ * @brief The end of the current chunk.
+ */
+
+/**
+ * @internal
+ *
+ * @class openvrml::local::node_arena::scope
+ *
+ * @brief Make a @c node_arena current for the calling thread for the
+ *        lifetime of the @c scope instance.
+ */
+
+/**
+ * @var openvrml::local::node_arena * const openvrml::local::node_arena::scope::previous_
+ *
+ * @brief The @c node_arena that was current when the @c scope was
+ *        constructed.
+ */
+
+/**
+ * @brief Construct.
+ *
+ * @param[in] arena the @c node_arena to make current.
+ */
+openvrml::local::node_arena::scope::scope(node_arena & arena)
+    OPENVRML_NOTHROW:
+    previous_(current_arena.get())
+{
+    current_arena.reset(&arena);
+}
+
+/**
+ * @brief Destroy.
+ *
+ * Restore the previously current @c node_arena.
+ */
+openvrml::local::node_arena::scope::~scope() OPENVRML_NOTHROW
+{
+    current_arena.reset(this->previous_);
+}
+
+/**
+ * @brief The @c node_arena current on the calling thread.
+ *
+ * Work handed to another thread can make the same arena current there
+ * with a @c node_arena::scope.
+ *
+ * @return the @c node_arena current on the calling thread, or 0 if there is
+ *         none.
+ */
+openvrml::local::node_arena * openvrml::local::node_arena::current()
+    OPENVRML_NOTHROW
+{
+    return current_arena.get();
+}
+
+/**
+ * @brief Allocate storage for a @c node.
+ *
+ * The storage comes from the @c node_arena current on the calling thread,
+ * if there is one; otherwise, from the free store.
+ *
+ * @param[in] size  the size of the @c node.
+ *
+ * @return storage for the @c node.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void * openvrml::local::node_arena::allocate_node(const std::size_t size)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    node_arena * const arena = current_arena.get();
+    header * const h = static_cast<header *>(
+        arena ? arena->allocate(sizeof (header) + size)
+              : ::operator new(sizeof (header) + size));
+    h->arena = arena;
+    if (arena) { arena->add_ref(); }
+    return h + 1;
+}
+
+/**
+ * @brief Deallocate storage obtained from @c #allocate_node.
+ *
+ * @param[in] ptr   storage obtained from @c #allocate_node, or 0.
+ */
+void openvrml::local::node_arena::deallocate_node(void * const ptr)
+    OPENVRML_NOTHROW
+{
+    if (!ptr) { return; }
+    header * const h = static_cast<header *>(ptr) - 1;
+    if (h->arena) {
+        h->arena->release();
+    } else {
+        ::operator delete(h);
+    }
+}
+
+/**
+ * @brief Construct.
+ *
+ * The new arena has one reference, which belongs to the caller.
+ */
+openvrml::local::node_arena::node_arena() OPENVRML_NOTHROW:
+    ref_count_(1),
+    next_(0),
+    end_(0)
+{}
+
+/**
+ * @brief Destroy.
+ *
+ * Free all of the chunks.
+ */
+openvrml::local::node_arena::~node_arena() OPENVRML_NOTHROW
+{
+    for (std::vector<char *>::const_iterator chunk = this->chunks_.begin();
+         chunk != this->chunks_.end();
+         ++chunk) {
+        delete [] *chunk;
+    }
+}
+
+/**
+ * @brief Add a reference.
+ */
+void openvrml::local::node_arena::add_ref() const OPENVRML_NOTHROW
+{
+    ++this->ref_count_;
+}
+
+/**
+ * @brief Release a reference.
+ *
+ * The arena is destroyed when the last reference is released.
+ */
+void openvrml::local::node_arena::release() const OPENVRML_NOTHROW
+{
+    if (--this->ref_count_ == 0) { delete this; }
+}
+
+/**
+ * @brief Allocate @p size bytes from the arena.
+ *
+ * @param[in] size  the number of bytes to allocate.
+ *
+ * @return a pointer to the allocated storage.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void * openvrml::local::node_arena::allocate(std::size_t size)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    size = round_up(size);
+
+    boost::mutex::scoped_lock lock(this->mutex_);
+    this->chunks_.reserve(this->chunks_.size() + 1);
+
+    if (size > chunk_size / 4) {
+        char * const chunk = new char[size];
+        this->chunks_.push_back(chunk);
+        return chunk;
+    }
+
+    if (std::size_t(this->end_ - this->next_) < size) {
+        char * const chunk = new char[chunk_size];
+        this->chunks_.push_back(chunk);
+        this->next_ = chunk;
+        this->end_ = chunk + chunk_size;
+    }
+    void * const result = this->next_;
+    this->next_ += size;
+    return result;
+}
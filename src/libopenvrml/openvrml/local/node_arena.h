@@ -0,0 +1,72 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# ifndef OPENVRML_LOCAL_NODE_ARENA_H
+#   define OPENVRML_LOCAL_NODE_ARENA_H
+
+#   include <openvrml-common.h>
+#   include <boost/detail/atomic_count.hpp>
+#   include <boost/thread/mutex.hpp>
+#   include <boost/utility.hpp>
+#   include <new>
+#   include <vector>
+
+namespace openvrml {
+
+    namespace local {
+
+        class OPENVRML_LOCAL node_arena : boost::noncopyable {
+            static const std::size_t chunk_size = 64 * 1024;
+
+            mutable boost::detail::atomic_count ref_count_;
+
+            boost::mutex mutex_;
+            std::vector<char *> chunks_;
+            char * next_;
+            char * end_;
+
+        public:
+            class OPENVRML_LOCAL scope : boost::noncopyable {
+                node_arena * const previous_;
+
+            public:
+                explicit scope(node_arena & arena) OPENVRML_NOTHROW;
+                ~scope() OPENVRML_NOTHROW;
+            };
+
+            static node_arena * current() OPENVRML_NOTHROW;
+            static void * allocate_node(std::size_t size)
+                OPENVRML_THROW1(std::bad_alloc);
+            static void deallocate_node(void * ptr) OPENVRML_NOTHROW;
+
+            node_arena() OPENVRML_NOTHROW;
+
+            void add_ref() const OPENVRML_NOTHROW;
+            void release() const OPENVRML_NOTHROW;
+
+        private:
+            ~node_arena() OPENVRML_NOTHROW;
+
+            void * allocate(std::size_t size) OPENVRML_THROW1(std::bad_alloc);
+        };
+    }
+}
+
+# endif // ifndef OPENVRML_LOCAL_NODE_ARENA_H
@@ -0,0 +1,217 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# include "null_viewer.h"
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+/**
+ * @internal
+ *
+ * @class openvrml::local::null_viewer openvrml/local/null_viewer.h
+ *
+ * @brief A @c viewer that draws nothing.
+ *
+ * Subclasses override the functions for what they are interested in.
+ */
+
+/**
+ * @brief Construct.
+ */
+openvrml::local::null_viewer::null_viewer() OPENVRML_NOTHROW
+{}
+
+/**
+ * @brief Destroy.
+ */
+openvrml::local::null_viewer::~null_viewer() OPENVRML_NOTHROW
+{}
+
+openvrml::viewer::rendering_mode openvrml::local::null_viewer::do_mode()
+{
+    return viewer::draw_mode;
+}
+
+double openvrml::local::null_viewer::do_frame_rate()
+{
+    return 0.0;
+}
+
+void openvrml::local::null_viewer::do_reset_user_navigation()
+{}
+
+void openvrml::local::null_viewer::do_begin_object(const char *, bool)
+{}
+
+void openvrml::local::null_viewer::do_end_object()
+{}
+
+void
+openvrml::local::null_viewer::do_insert_background(const background_node &)
+{}
+
+void
+openvrml::local::null_viewer::do_insert_box(const geometry_node &,
+                                            const vec3f &)
+{}
+
+void
+openvrml::local::null_viewer::do_insert_cone(const geometry_node &, float,
+                                             float, bool, bool)
+{}
+
+void
+openvrml::local::null_viewer::do_insert_cylinder(const geometry_node &, float,
+                                                 float, bool, bool, bool)
+{}
+
+void
+openvrml::local::null_viewer::
+do_insert_elevation_grid(const geometry_node &,
+                         unsigned int,
+                         const std::vector<float> &,
+                         int32, int32,
+                         float, float,
+                         const std::vector<color> &,
+                         const std::vector<vec3f> &,
+                         const std::vector<vec2f> &)
+{}
+
+void
+openvrml::local::null_viewer::
+do_insert_extrusion(const geometry_node &,
+                    unsigned int,
+                    const std::vector<vec3f> &,
+                    const std::vector<vec2f> &,
+                    const std::vector<rotation> &,
+                    const std::vector<vec2f> &)
+{}
+
+void
+openvrml::local::null_viewer::do_insert_line_set(const geometry_node &,
+                                                 const std::vector<vec3f> &,
+                                                 const std::vector<int32> &,
+                                                 bool,
+                                                 const std::vector<color> &,
+                                                 const std::vector<int32> &)
+{}
+
+void
+openvrml::local::null_viewer::do_insert_point_set(const geometry_node &,
+                                                  const std::vector<vec3f> &,
+                                                  const std::vector<color> &)
+{}
+
+void
+openvrml::local::null_viewer::do_insert_shell(const geometry_node &,
+                                              unsigned int,
+                                              const std::vector<vec3f> &,
+                                              const std::vector<int32> &,
+                                              const std::vector<color> &,
+                                              const std::vector<int32> &,
+                                              const std::vector<vec3f> &,
+                                              const std::vector<int32> &,
+                                              const std::vector<vec2f> &,
+                                              const std::vector<int32> &)
+{}
+
+void
+openvrml::local::null_viewer::do_insert_sphere(const geometry_node &, float)
+{}
+
+void
+openvrml::local::null_viewer::do_insert_dir_light(float, float, const color &,
+                                                  const vec3f &)
+{}
+
+void
+openvrml::local::null_viewer::do_insert_point_light(float, const vec3f &,
+                                                    const color &, float,
+                                                    const vec3f &, float)
+{}
+
+void
+openvrml::local::null_viewer::do_insert_spot_light(float, const vec3f &,
+                                                   float, const color &,
+                                                   float, const vec3f &,
+                                                   float, const vec3f &,
+                                                   float)
+{}
+
+void openvrml::local::null_viewer::do_remove_object(const node &)
+{}
+
+void openvrml::local::null_viewer::do_enable_lighting(bool)
+{}
+
+void
+openvrml::local::null_viewer::do_set_fog(const color &, float, const char *)
+{}
+
+void openvrml::local::null_viewer::do_set_color(const color &, float)
+{}
+
+void
+openvrml::local::null_viewer::do_set_material(float, const color &,
+                                              const color &, float,
+                                              const color &, float)
+{}
+
+void openvrml::local::null_viewer::do_set_material_mode(size_t, bool)
+{}
+
+void openvrml::local::null_viewer::do_set_sensitive(node *)
+{}
+
+void
+openvrml::local::null_viewer::do_insert_texture(const texture_node &, bool)
+{}
+
+void
+openvrml::local::null_viewer::do_remove_texture_object(const texture_node &)
+{}
+
+void
+openvrml::local::null_viewer::do_set_texture_transform(const vec2f &, float,
+                                                       const vec2f &,
+                                                       const vec2f &)
+{}
+
+void openvrml::local::null_viewer::do_set_frustum(float, float, float)
+{}
+
+void
+openvrml::local::null_viewer::do_set_viewpoint(const vec3f &,
+                                               const rotation &, float, float)
+{}
+
+void openvrml::local::null_viewer::do_transform(const mat4f &)
+{}
+
+void openvrml::local::null_viewer::do_transform_points(size_t, vec3f *) const
+{}
+
+void
+openvrml::local::null_viewer::
+do_draw_bounding_sphere(const bounding_sphere &,
+                        bounding_volume::intersection)
+{}
@@ -0,0 +1,162 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# ifndef OPENVRML_LOCAL_NULL_VIEWER_H
+#   define OPENVRML_LOCAL_NULL_VIEWER_H
+
+#   include <openvrml/viewer.h>
+
+namespace openvrml {
+
+    namespace local {
+
+        class OPENVRML_LOCAL null_viewer : public viewer {
+        public:
+            virtual ~null_viewer() OPENVRML_NOTHROW;
+
+        protected:
+            null_viewer() OPENVRML_NOTHROW;
+
+            virtual rendering_mode do_mode();
+            virtual double do_frame_rate();
+            virtual void do_reset_user_navigation();
+            virtual void do_begin_object(const char * id, bool retain);
+            virtual void do_end_object();
+            virtual void
+            do_insert_background(const background_node & n);
+            virtual void do_insert_box(const geometry_node & n,
+                                       const vec3f & size);
+            virtual void do_insert_cone(const geometry_node & n,
+                                        float height,
+                                        float radius,
+                                        bool bottom,
+                                        bool side);
+            virtual void do_insert_cylinder(const geometry_node & n,
+                                            float height,
+                                            float radius,
+                                            bool bottom,
+                                            bool side,
+                                            bool top);
+            virtual void
+            do_insert_elevation_grid(
+                const geometry_node & n,
+                unsigned int mask,
+                const std::vector<float> & height,
+                int32 x_dimension,
+                int32 z_dimension,
+                float x_spacing,
+                float z_spacing,
+                const std::vector<color> & color,
+                const std::vector<vec3f> & normal,
+                const std::vector<vec2f> & tex_coord);
+            virtual void
+            do_insert_extrusion(
+                const geometry_node & n,
+                unsigned int mask,
+                const std::vector<vec3f> & spine,
+                const std::vector<vec2f> & cross_section,
+                const std::vector<rotation> & orientation,
+                const std::vector<vec2f> & scale);
+            virtual void
+            do_insert_line_set(const geometry_node & n,
+                               const std::vector<vec3f> & coord,
+                               const std::vector<int32> & coord_index,
+                               bool color_per_vertex,
+                               const std::vector<color> & color,
+                               const std::vector<int32> & color_index);
+            virtual void
+            do_insert_point_set(const geometry_node & n,
+                                const std::vector<vec3f> & coord,
+                                const std::vector<color> & color);
+            virtual void
+            do_insert_shell(const geometry_node & n,
+                            unsigned int mask,
+                            const std::vector<vec3f> & coord,
+                            const std::vector<int32> & coord_index,
+                            const std::vector<color> & color,
+                            const std::vector<int32> & color_index,
+                            const std::vector<vec3f> & normal,
+                            const std::vector<int32> & normal_index,
+                            const std::vector<vec2f> & tex_coord,
+                            const std::vector<int32> & tex_coord_index);
+            virtual void do_insert_sphere(const geometry_node & n,
+                                          float radius);
+            virtual void do_insert_dir_light(float ambient_intensity,
+                                             float intensity,
+                                             const color & color,
+                                             const vec3f & direction);
+            virtual void
+            do_insert_point_light(float ambient_intensity,
+                                  const vec3f & attenuation,
+                                  const color & color,
+                                  float intensity,
+                                  const vec3f & location,
+                                  float radius);
+            virtual void do_insert_spot_light(float ambient_intensity,
+                                              const vec3f & attenuation,
+                                              float beam_width,
+                                              const color & color,
+                                              float cut_off_angle,
+                                              const vec3f & direction,
+                                              float intensity,
+                                              const vec3f & location,
+                                              float radius);
+            virtual void do_remove_object(const node & ref);
+            virtual void do_enable_lighting(bool val);
+            virtual void do_set_fog(const color & color,
+                                    float visibility_range,
+                                    const char * type);
+            virtual void do_set_color(const color & rgb, float a);
+            virtual void do_set_material(float ambient_intensity,
+                                         const color & diffuse_color,
+                                         const color & emissive_color,
+                                         float shininess,
+                                         const color & specular_color,
+                                         float transparency);
+            virtual void do_set_material_mode(size_t tex_components,
+                                              bool geometry_color);
+            virtual void do_set_sensitive(node * object);
+            virtual void do_insert_texture(const texture_node & n,
+                                           bool retain);
+            virtual void
+            do_remove_texture_object(const texture_node & ref);
+            virtual void do_set_texture_transform(
+                const vec2f & center,
+                float rotation,
+                const vec2f & scale,
+                const vec2f & translation);
+            virtual void do_set_frustum(float field_of_view,
+                                        float avatar_size,
+                                        float visibility_limit);
+            virtual void do_set_viewpoint(const vec3f & position,
+                                          const rotation & orientation,
+                                          float avatar_size,
+                                          float visibility_limit);
+            virtual void do_transform(const mat4f & mat);
+            virtual void do_transform_points(size_t nPoints,
+                                             vec3f * point) const;
+            virtual void do_draw_bounding_sphere(
+                const bounding_sphere & bs,
+                bounding_volume::intersection intersection);
+        };
+    }
+}
+
+# endif // ifndef OPENVRML_LOCAL_NULL_VIEWER_H
@@ -19,9 +19,23 @@
 //
 
 # include "parse_vrml.h"
+# include "vrml_parser.h"
+# include "concurrent_parse.h"
+# include "buffer_streambuf.h"
+# include "scene_cache.h"
+# include "x3db_parser.h"
+# include "conf.h"
 # include <openvrml/x3d_vrml_grammar.h>
 # include <boost/algorithm/string/predicate.hpp>
 
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+# ifdef OPENVRML_ENABLE_GZIP
+#   include "gzip_streambuf.h"
+# endif
+
 bool openvrml::local::anonymous_stream_id(const openvrml::local::uri & id)
 {
     const std::string str(id);
@@ -90,6 +104,73 @@ namespace {
         openvrml::browser & browser_;
         parse_error & error_;
     };
+
+    //
+    // The hand-written parser works on a contiguous buffer; read the whole
+    // stream into one.  sgetn on a gzip_streambuf inflates directly into
+    // buf, so a compressed stream is not copied a second time.
+    //
+    OPENVRML_LOCAL void read_stream(std::istream & in, std::vector<char> & buf)
+    {
+        static const std::streamsize initial_size = 64 * 1024;
+        buf.resize(initial_size);
+        std::size_t size = 0;
+        std::streamsize count;
+        while ((count = in.rdbuf()->sgetn(&buf[size], buf.size() - size))
+               > 0) {
+            size += count;
+            if (size == buf.size()) { buf.resize(buf.size() * 2); }
+        }
+        buf.resize(size);
+    }
+
+    //
+    // A memory-mapped file or a cached resource is parsed in place; anything
+    // else is read into a buffer first.
+    //
+    OPENVRML_LOCAL void stream_data(std::istream & in,
+                                    std::vector<char> & buf,
+                                    const char *& begin,
+                                    const char *& end)
+    {
+        using openvrml::local::buffer_streambuf;
+        if (const buffer_streambuf * const contiguous =
+            openvrml::local::contiguous_buffer(in)) {
+            begin = contiguous->data();
+            end = begin + contiguous->size();
+        } else {
+            read_stream(in, buf);
+            begin = buf.empty() ? 0 : &buf.front();
+            end = begin + buf.size();
+        }
+    }
+
+    template <typename Parser, typename Actions>
+    OPENVRML_LOCAL void scan_vrml(const char * const begin,
+                                  const char * const end,
+                                  const std::string & uri,
+                                  const bool x3d,
+                                  Actions & actions,
+                                  openvrml::browser & b,
+                                  openvrml::local::scene_tape * tape = 0)
+    {
+        using openvrml::local::vrml_scanner;
+        using openvrml::local::vrml_parse_failure;
+
+        vrml_scanner scanner(begin, end, x3d);
+        Parser parser(actions, scanner, b, uri, tape);
+        try {
+            parser.parse();
+        } catch (const vrml_parse_failure & failure) {
+            std::size_t line, column;
+            scanner.location(failure.where, line, column);
+            throw openvrml::invalid_vrml(
+                uri,
+                line,
+                column,
+                openvrml::x3d_vrml_parse_error_msg(failure.error));
+        }
+    }
 }
 
 /**
@@ -97,6 +178,32 @@ namespace {
  *
  * @brief Parse a VRML stream.
  *
+ * The stream is parsed with @c vrml97_parser or @c x3d_vrml_parser unless
+ * the @c OPENVRML_VRML_PARSER environment variable is set to
+ * &ldquo;spirit&rdquo;, in which case the Spirit grammars are used.  Large
+ * VRML97 streams may be parsed on several threads; see
+ * @c browser::parse_threads.
+ *
+ * A stream read from a memory-mapped file (see
+ * @c file_resource_fetcher) or from a @c resource_cache is parsed in place.
+ *
+ * gzip-compressed streams (such as &ldquo;.wrz&rdquo; and
+ * &ldquo;.x3dvz&rdquo; files) are recognized by their leading magic byte
+ * and read through a @c gzip_streambuf.  The Spirit grammars consume the
+ * inflated stream as it is produced.  The hand-written parser, the scene
+ * cache, and @c parse_x3db need the whole document in contiguous memory:
+ * tokens point into it, concurrent parsing splits it, and the cache hashes
+ * it.  For them the stream is inflated straight into one buffer.  The
+ * compressed stream is never held in memory in its entirety, but the
+ * inflated one is.
+ *
+ * If the @c OPENVRML_SCENE_CACHE environment variable names a directory,
+ * large streams parsed with the hand-written parser are cached there; see
+ * @c scene_cache.
+ *
+ * Streams in the X3D Compressed Binary Encoding are read with
+ * @c parse_x3db.
+ *
  * @param[in,out] in    input stream.
  * @param[in]     uri   URI associated with @p in.
  * @param[in]     type  MIME media type of the data to be read from @p in.
@@ -126,9 +233,93 @@ parse_vrml(std::istream & in,
     typedef multi_pass<istreambuf_iterator<char> > multi_pass_iterator_t;
     typedef istream::char_type char_t;
 
+    const bool vrml97 = iequals(type, vrml_media_type)
+        || iequals(type, x_vrml_media_type);
+    const bool x3d_vrml = iequals(type, x3d_vrml_media_type);
+    const bool x3d_binary = iequals(type, x3d_binary_media_type);
+    if (!(vrml97 || x3d_vrml || x3d_binary)) { throw bad_media_type(type); }
+
+# ifdef OPENVRML_ENABLE_GZIP
+    if (gzip_streambuf::compressed(*in.rdbuf())) {
+        try {
+            gzip_streambuf inflated_buf(*in.rdbuf());
+            istream inflated(&inflated_buf);
+            parse_vrml(inflated, uri, type, scene, nodes, meta);
+        } catch (const gzip_error & ex) {
+            throw invalid_vrml(uri, 0, 0, ex.what());
+        }
+        return;
+    }
+# endif
+
+    if (x3d_binary) {
+        std::vector<char> buf;
+        const char * begin, * end;
+        stream_data(in, buf, begin, end);
+        parse_x3db(begin, end, uri, scene, nodes, meta);
+        return;
+    }
+
+    if (conf::vrml_parser() == conf::scanner_vrml_parser) {
+        openvrml::browser & b = scene.browser();
+        std::vector<char> buf;
+        const char * begin, * end;
+        stream_data(in, buf, begin, end);
+        const boost::filesystem::path cache_dir = conf::scene_cache_dir();
+        if (scene_cache::enabled(cache_dir, uri, begin, end)) {
+            scene_cache cache(cache_dir, uri, x3d_vrml, begin, end);
+            if (cache.valid()) {
+                try {
+                    if (vrml97) {
+                        vrml97_parse_actions actions(uri, scene, nodes);
+                        cache.replay(actions);
+                    } else {
+                        x3d_vrml_parse_actions actions(uri, scene, nodes,
+                                                       meta);
+                        cache.replay(actions);
+                    }
+                    return;
+                } catch (const std::exception & ex) {
+                    b.err(cache_dir.string() + ": " + ex.what());
+                    nodes.clear();
+                    meta.clear();
+                }
+            }
+
+            //
+            // The parse is recorded serially; subsequent loads replay the
+            // recording rather than parse.
+            //
+            scene_tape tape;
+            if (vrml97) {
+                vrml97_parse_actions actions(uri, scene, nodes);
+                scan_vrml<vrml97_parser>(begin, end, uri, false, actions, b,
+                                         &tape);
+            } else {
+                x3d_vrml_parse_actions actions(uri, scene, nodes, meta);
+                scan_vrml<x3d_vrml_parser>(begin, end, uri, true, actions, b,
+                                           &tape);
+            }
+            cache.store(tape);
+            return;
+        }
+        if (vrml97) {
+            if (parse_vrml97_concurrently(begin, end, uri, scene, nodes,
+                                          b.parse_threads())) {
+                return;
+            }
+            vrml97_parse_actions actions(uri, scene, nodes);
+            scan_vrml<vrml97_parser>(begin, end, uri, false, actions, b);
+        } else {
+            x3d_vrml_parse_actions actions(uri, scene, nodes, meta);
+            scan_vrml<x3d_vrml_parser>(begin, end, uri, true, actions, b);
+        }
+        return;
+    }
+
     vrml97_skip_grammar skip_g;
 
-    if (iequals(type, vrml_media_type) || iequals(type, x_vrml_media_type)) {
+    if (vrml97) {
         multi_pass_iterator_t
             in_begin(make_multi_pass(istreambuf_iterator<char_t>(in))),
             in_end(make_multi_pass(istreambuf_iterator<char_t>()));
@@ -152,7 +343,7 @@ parse_vrml(std::istream & in,
                                          error.column,
                                          error.message);
         }
-    } else if (iequals(type, x3d_vrml_media_type)) {
+    } else {
         multi_pass_iterator_t
             in_begin(make_multi_pass(istreambuf_iterator<char_t>(in))),
             in_end(make_multi_pass(istreambuf_iterator<char_t>()));
@@ -176,7 +367,5 @@ parse_vrml(std::istream & in,
                                          error.column,
                                          error.message);
         }
-    } else {
-        throw bad_media_type(type);
     }
 }
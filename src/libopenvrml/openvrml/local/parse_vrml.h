@@ -43,7 +43,9 @@ namespace openvrml {
             vrml97_parse_actions(
                 const std::string & uri,
                 const openvrml::scene & scene,
-                std::vector<boost::intrusive_ptr<openvrml::node> > & nodes):
+                std::vector<boost::intrusive_ptr<openvrml::node> > & nodes,
+                const boost::shared_ptr<openvrml::scope> & root_scope =
+                    boost::shared_ptr<openvrml::scope>()):
                 on_scene_start(*this),
                 on_scene_finish(*this),
                 on_externproto(*this),
@@ -82,7 +84,8 @@ namespace openvrml {
                 on_mfvec3f(*this),
                 uri_(uri),
                 scene_(scene),
-                nodes_(nodes)
+                nodes_(nodes),
+                root_scope_(root_scope)
             {}
 
             ~vrml97_parse_actions()
@@ -166,13 +169,23 @@ namespace openvrml {
 
                     this->actions_.ps.push(parse_scope());
 
-                    const profile & p =
-                        local::profile_registry_.at(vrml97_profile::id);
-                    std::auto_ptr<scope>
-                        root_scope(
-                            p.create_root_scope(this->actions_.scene_.browser(),
-                                                this->actions_.uri_));
-                    this->actions_.ps.top().scope = root_scope;
+                    //
+                    // When a stream is parsed in pieces, the pieces share a
+                    // root scope.
+                    //
+                    if (this->actions_.root_scope_) {
+                        this->actions_.ps.top().scope =
+                            this->actions_.root_scope_;
+                    } else {
+                        const profile & p =
+                            local::profile_registry_.at(vrml97_profile::id);
+                        std::auto_ptr<scope>
+                            root_scope(
+                                p.create_root_scope(
+                                    this->actions_.scene_.browser(),
+                                    this->actions_.uri_));
+                        this->actions_.ps.top().scope = root_scope;
+                    }
                     this->actions_.ps.top().children.push(
                         parse_scope::children_t());
                 }
@@ -220,9 +233,9 @@ namespace openvrml {
                 vrml97_parse_actions & actions_;
             } on_scene_finish;
 
-            static boost::thread_group & get_load_proto_thread_group(browser & b)
+            static io_executor & get_io_executor(browser & b)
             {
-                return b.load_proto_thread_group_;
+                return *b.io_executor_;
             }
 
             struct on_externproto_t {
@@ -286,7 +299,7 @@ namespace openvrml {
                                     metatype_id,
                                     this->actions_.scene_,
                                     uri_list,
-                                    get_load_proto_thread_group(
+                                    get_io_executor(
                                         this->actions_.scene_.browser())));
 
                         this->actions_.scene_.browser().add_node_metatype(
@@ -1255,10 +1268,11 @@ namespace openvrml {
             //
             std::stack<parse_scope> ps;
 
-        private:
+        protected:
             const std::string uri_;
             const openvrml::scene & scene_;
             std::vector<boost::intrusive_ptr<openvrml::node> > & nodes_;
+            const boost::shared_ptr<openvrml::scope> root_scope_;
         };
 
         struct OPENVRML_LOCAL x3d_vrml_parse_actions : vrml97_parse_actions {
@@ -1291,8 +1305,21 @@ namespace openvrml {
                     actions_(actions)
                 {}
 
-                void operator()(const std::string & /* profile_id */) const
-                {}
+                //
+                // on_scene_start has set up a VRML97 root scope; replace it
+                // with one for the requested profile.
+                //
+                void operator()(const std::string & profile_id) const
+                {
+                    assert(!this->actions_.ps.empty());
+                    const profile & p =
+                        local::profile_registry_.at(profile_id);
+                    std::auto_ptr<scope>
+                        root_scope(
+                            p.create_root_scope(this->actions_.scene_.browser(),
+                                                this->actions_.uri_));
+                    this->actions_.ps.top().scope = root_scope;
+                }
 
             private:
                 x3d_vrml_parse_actions & actions_;
@@ -1304,9 +1331,17 @@ namespace openvrml {
                     actions_(actions)
                 {}
 
-                void operator()(const std::string & /* component_id */,
-                                int32 /* level */) const
-                {}
+                void operator()(const std::string & component_id,
+                                const int32 level) const
+                {
+                    assert(!this->actions_.ps.empty());
+                    assert(this->actions_.ps.top().scope);
+                    const component & c =
+                        local::component_registry_.at(component_id);
+                    c.add_to_scope(this->actions_.scene_.browser(),
+                                   *this->actions_.ps.top().scope,
+                                   level);
+                }
 
             private:
                 x3d_vrml_parse_actions & actions_;
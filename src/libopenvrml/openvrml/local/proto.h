@@ -233,6 +233,7 @@ namespace openvrml {
 
             private:
                 const std::string do_eventout_id() const OPENVRML_NOTHROW;
+                openvrml::node * do_node() const OPENVRML_NOTHROW;
             };
 
             struct proto_eventout_creator {
@@ -650,4 +651,17 @@ do_eventout_id() const
     return pos->first;
 }
 
+/**
+ * @brief The @c PROTO instance.
+ *
+ * @return the @c PROTO instance.
+ */
+template <typename FieldValue>
+openvrml::node *
+openvrml::local::abstract_proto_node::proto_eventout<FieldValue>::
+do_node() const OPENVRML_NOTHROW
+{
+    return &this->listener.node;
+}
+
 # endif // ifndef OPENVRML_LOCAL_PROTO_H
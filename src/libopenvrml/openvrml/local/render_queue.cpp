@@ -0,0 +1,1056 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# include "render_queue.h"
+# include <openvrml/browser.h>
+# include <openvrml/compiled_mesh.h>
+# include <openvrml/node.h>
+# include <boost/thread/shared_mutex.hpp>
+# include <algorithm>
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+namespace {
+
+    const std::size_t no_index = std::size_t(-1);
+
+    OPENVRML_LOCAL bool less(const openvrml::color & lhs,
+                             const openvrml::color & rhs)
+        OPENVRML_NOTHROW
+    {
+        if (lhs.r() != rhs.r()) { return lhs.r() < rhs.r(); }
+        if (lhs.g() != rhs.g()) { return lhs.g() < rhs.g(); }
+        return lhs.b() < rhs.b();
+    }
+}
+
+/**
+ * @internal
+ *
+ * @brief Order materials by their members.
+ *
+ * @param[in] lhs   a material.
+ * @param[in] rhs   a material.
+ *
+ * @return @c true if @p lhs is less than @p rhs; @c false otherwise.
+ */
+bool openvrml::local::operator<(const render_queue::material & lhs,
+                                const render_queue::material & rhs)
+    OPENVRML_NOTHROW
+{
+    if (lhs.ambient_intensity != rhs.ambient_intensity) {
+        return lhs.ambient_intensity < rhs.ambient_intensity;
+    }
+    if (lhs.diffuse_color != rhs.diffuse_color) {
+        return less(lhs.diffuse_color, rhs.diffuse_color);
+    }
+    if (lhs.emissive_color != rhs.emissive_color) {
+        return less(lhs.emissive_color, rhs.emissive_color);
+    }
+    if (lhs.shininess != rhs.shininess) {
+        return lhs.shininess < rhs.shininess;
+    }
+    if (lhs.specular_color != rhs.specular_color) {
+        return less(lhs.specular_color, rhs.specular_color);
+    }
+    return lhs.transparency < rhs.transparency;
+}
+
+/**
+ * @internal
+ *
+ * @class openvrml::local::render_queue
+ *
+ * @brief A @c viewer that records the geometry drawn in a frame and submits
+ *        it to another @c viewer sorted by rendering state.
+ *
+ * Nodes render into the queue as they would into any @c viewer.  Rather than
+ * being drawn in traversal order, each geometry node is recorded with its
+ * transformation, the directional lights that are in scope for it, and the
+ * lighting, material, texture and color set for it.  @c #submit then draws
+ * the opaque geometry grouped by light set, texture and material, so that
+ * each is set on the target @c viewer once per run instead of once per
+ * @c Shape; transparent geometry is drawn last, from back to front.
+ *
+ * What a geometry node inserts is recorded as its compiled mesh, found in
+ * or added to the @c browser's @c compiled_mesh_cache, and is drawn with
+ * @c viewer::insert_mesh; line and point sets, which are not meshes, are
+ * recorded as they are inserted.  The nodes are not rendered again.
+ *
+ * Everything that is not geometry or the state it is drawn with is passed
+ * through to the target @c viewer as it arrives.
+ */
+
+/**
+ * @internal
+ *
+ * @struct openvrml::local::render_queue::material
+ *
+ * @brief The arguments to a @c viewer::set_material call.
+ */
+
+/**
+ * @internal
+ *
+ * @struct openvrml::local::render_queue::directional_light
+ *
+ * @brief A directional light and the transformation it was inserted with.
+ */
+
+/**
+ * @internal
+ *
+ * @struct openvrml::local::render_queue::light_set
+ *
+ * @brief The directional lights in scope at some point in the traversal.
+ *
+ * Light sets form a tree: a light set is its parent's lights plus one more.
+ * Light set 0 is the empty set.
+ */
+
+/**
+ * @internal
+ *
+ * @struct openvrml::local::render_queue::scope
+ *
+ * @brief What @c viewer::end_object restores.
+ */
+
+/**
+ * @internal
+ *
+ * @struct openvrml::local::render_queue::texture_transform
+ *
+ * @brief The arguments to a @c viewer::set_texture_transform call.
+ */
+
+/**
+ * @internal
+ *
+ * @struct openvrml::local::render_queue::state
+ *
+ * @brief The rendering state geometry is drawn with.
+ *
+ * A member that has not been set is left alone when the state is submitted.
+ */
+
+/**
+ * @internal
+ *
+ * @brief Construct with nothing set.
+ */
+openvrml::local::render_queue::state::state() OPENVRML_NOTHROW:
+    lighting(-1),
+    material(no_index),
+    texture(0),
+    retain_texture(false),
+    texture_transform_set(false),
+    material_mode_set(false),
+    texture_components(0),
+    geometry_color(false),
+    color_set(false),
+    alpha(1.0)
+{}
+
+/**
+ * @internal
+ *
+ * @struct openvrml::local::render_queue::line_set
+ *
+ * @brief The arguments to a @c viewer::insert_line_set call.
+ */
+
+/**
+ * @internal
+ *
+ * @struct openvrml::local::render_queue::point_set
+ *
+ * @brief The arguments to a @c viewer::insert_point_set call.
+ */
+
+/**
+ * @internal
+ *
+ * @struct openvrml::local::render_queue::draw_item
+ *
+ * @brief A geometry node, with what it inserted and the transformation,
+ *        lights and state it is drawn with.
+ *
+ * What the node inserted is its @c mesh if that is not null; otherwise, the
+ * line set or point set with the index @c line_set or @c point_set.
+ */
+
+/**
+ * @internal
+ *
+ * @struct openvrml::local::render_queue::bounding_sphere_item
+ *
+ * @brief A @c viewer::draw_bounding_sphere call.
+ */
+
+/**
+ * @internal
+ *
+ * @brief Order opaque @c draw_item%s so that those sharing the most
+ *        expensive state changes are adjacent.
+ */
+struct OPENVRML_LOCAL openvrml::local::render_queue::state_less {
+    //
+    // Texture nodes that load the same image share it; group by the image
+    // rather than by the node.
+    //
+    static const openvrml::image * image(const state & s) OPENVRML_NOTHROW
+    {
+        return s.texture ? &s.texture->image() : 0;
+    }
+
+    bool operator()(const draw_item * const lhs,
+                    const draw_item * const rhs) const OPENVRML_NOTHROW
+    {
+        if (lhs->light_set != rhs->light_set) {
+            return lhs->light_set < rhs->light_set;
+        }
+        const state & l = lhs->state, & r = rhs->state;
+        const openvrml::image * const l_image = image(l);
+        const openvrml::image * const r_image = image(r);
+        if (l_image != r_image) { return l_image < r_image; }
+        if (l.material != r.material) { return l.material < r.material; }
+        if (l.texture_components != r.texture_components) {
+            return l.texture_components < r.texture_components;
+        }
+        if (l.geometry_color != r.geometry_color) {
+            return l.geometry_color < r.geometry_color;
+        }
+        return l.lighting < r.lighting;
+    }
+};
+
+/**
+ * @internal
+ *
+ * @brief Order transparent @c draw_item%s from back to front.
+ */
+struct OPENVRML_LOCAL openvrml::local::render_queue::farther {
+    bool operator()(const draw_item * const lhs,
+                    const draw_item * const rhs) const OPENVRML_NOTHROW
+    {
+        return lhs->depth < rhs->depth;
+    }
+};
+
+/**
+ * @var openvrml::viewer & openvrml::local::render_queue::target_
+ *
+ * @brief The @c viewer the queue is submitted to.
+ */
+
+/**
+ * @var const openvrml::mat4f openvrml::local::render_queue::modelview_
+ *
+ * @brief The transformation from the coordinate system the queue starts in
+ *        to eye coordinates.
+ */
+
+/**
+ * @var openvrml::local::compiling_viewer openvrml::local::render_queue::compiler_
+ *
+ * @brief Finds or compiles the meshes of the geometry nodes recorded.
+ */
+
+/**
+ * @var std::vector<openvrml::local::render_queue::scope> openvrml::local::render_queue::scopes_
+ *
+ * @brief The objects begun and not yet ended.
+ */
+
+/**
+ * @var openvrml::mat4f openvrml::local::render_queue::matrix_
+ *
+ * @brief The current transformation, relative to the one the queue starts
+ *        in.
+ */
+
+/**
+ * @var std::size_t openvrml::local::render_queue::light_set_
+ *
+ * @brief The current light set.
+ */
+
+/**
+ * @var std::vector<openvrml::local::render_queue::directional_light> openvrml::local::render_queue::lights_
+ *
+ * @brief The directional lights inserted.
+ */
+
+/**
+ * @var std::vector<openvrml::local::render_queue::light_set> openvrml::local::render_queue::light_sets_
+ *
+ * @brief The light sets; the first is empty.
+ */
+
+/**
+ * @var openvrml::local::render_queue::state openvrml::local::render_queue::state_
+ *
+ * @brief The current rendering state.
+ */
+
+/**
+ * @var std::vector<openvrml::local::render_queue::material> openvrml::local::render_queue::materials_
+ *
+ * @brief The distinct materials set.
+ */
+
+/**
+ * @var std::map<openvrml::local::render_queue::material, std::size_t> openvrml::local::render_queue::material_index_
+ *
+ * @brief Map from a material to its index in @c #materials_.
+ */
+
+/**
+ * @var std::vector<openvrml::local::render_queue::draw_item> openvrml::local::render_queue::items_
+ *
+ * @brief The geometry recorded, in traversal order.
+ */
+
+/**
+ * @var std::vector<openvrml::local::render_queue::line_set> openvrml::local::render_queue::line_sets_
+ *
+ * @brief The line sets recorded.
+ */
+
+/**
+ * @var std::vector<openvrml::local::render_queue::point_set> openvrml::local::render_queue::point_sets_
+ *
+ * @brief The point sets recorded.
+ */
+
+/**
+ * @var std::vector<openvrml::local::render_queue::bounding_sphere_item> openvrml::local::render_queue::bounding_spheres_
+ *
+ * @brief The bounding spheres recorded.
+ */
+
+/**
+ * @var bool openvrml::local::render_queue::scope_open_
+ *
+ * @brief Whether @c #submit has begun an object on the target for a light
+ *        set.
+ */
+
+/**
+ * @var std::size_t openvrml::local::render_queue::submitted_light_set_
+ *
+ * @brief The light set in effect on the target, if @c #scope_open_.
+ */
+
+/**
+ * @var openvrml::local::render_queue::state openvrml::local::render_queue::submitted_
+ *
+ * @brief The rendering state last set on the target.
+ */
+
+/**
+ * @var bool openvrml::local::render_queue::previous_geometry_color_
+ *
+ * @brief Whether the geometry last submitted had colors of its own.
+ *
+ * The current color is indeterminate after such geometry is drawn.
+ */
+
+/**
+ * @brief Construct.
+ *
+ * @param[in] target    the @c viewer the queue is submitted to; it must be
+ *                      associated with a @c browser.
+ * @param[in] modelview the transformation from the coordinate system current
+ *                      on @p target to eye coordinates.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+openvrml::local::render_queue::render_queue(viewer & target,
+                                            const mat4f & modelview)
+    OPENVRML_THROW1(std::bad_alloc):
+    target_(target),
+    modelview_(modelview),
+    compiler_(target.browser()->compiled_meshes()),
+    matrix_(make_mat4f()),
+    light_set_(0),
+    scope_open_(false),
+    submitted_light_set_(0),
+    previous_geometry_color_(false)
+{
+    const light_set empty = { no_index, no_index };
+    this->light_sets_.push_back(empty);
+}
+
+/**
+ * @brief Destroy.
+ */
+openvrml::local::render_queue::~render_queue() OPENVRML_NOTHROW
+{}
+
+/**
+ * @brief The number of geometry nodes recorded.
+ *
+ * @return the number of geometry nodes recorded.
+ */
+std::size_t openvrml::local::render_queue::size() const OPENVRML_NOTHROW
+{
+    return this->items_.size();
+}
+
+/**
+ * @brief Draw what has been recorded on the target @c viewer.
+ *
+ * The geometry is drawn within an object begun on the target, in the
+ * coordinate system that was current on it when the queue was constructed.
+ */
+void openvrml::local::render_queue::submit()
+{
+    using std::stable_sort;
+
+    std::vector<const draw_item *> opaque, transparent;
+    opaque.reserve(this->items_.size());
+    for (std::vector<draw_item>::const_iterator item = this->items_.begin();
+         item != this->items_.end();
+         ++item) {
+        (item->transparent ? transparent : opaque).push_back(&*item);
+    }
+    stable_sort(opaque.begin(), opaque.end(), state_less());
+    stable_sort(transparent.begin(), transparent.end(), farther());
+
+    for (std::size_t i = 0; i < opaque.size(); ++i) {
+        this->draw(*opaque[i]);
+    }
+
+    if (!this->bounding_spheres_.empty()) {
+        this->use_light_set(0);
+        for (std::vector<bounding_sphere_item>::const_iterator bs =
+                 this->bounding_spheres_.begin();
+             bs != this->bounding_spheres_.end();
+             ++bs) {
+            this->target_.begin_object(0);
+            this->target_.transform(bs->matrix);
+            this->target_.draw_bounding_sphere(bs->sphere, bs->intersection);
+            this->target_.end_object();
+        }
+        //
+        // Drawing a bounding sphere may change the color and material.
+        //
+        this->submitted_ = state();
+    }
+
+    for (std::size_t i = 0; i < transparent.size(); ++i) {
+        this->draw(*transparent[i]);
+    }
+
+    if (this->scope_open_) {
+        this->target_.end_object();
+        this->scope_open_ = false;
+    }
+}
+
+/**
+ * @brief Record a geometry node with the current transformation, lights and
+ *        state.
+ *
+ * The caller records what the node inserted in the @c draw_item.
+ *
+ * @param[in] n a geometry node.
+ *
+ * @return the @c draw_item for @p n.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+openvrml::local::render_queue::draw_item &
+openvrml::local::render_queue::record(const geometry_node & n)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    draw_item item;
+    item.geometry = &n;
+    item.line_set = no_index;
+    item.point_set = no_index;
+    item.matrix = this->matrix_;
+    item.light_set = this->light_set_;
+    item.state = this->state_;
+
+    //
+    // A texture is only inserted for an Appearance that has one; the last
+    // one inserted does not apply to geometry that is drawn untextured.
+    //
+    if (item.state.texture_components == 0) {
+        item.state.texture = 0;
+        item.state.texture_transform_set = false;
+    }
+
+    item.transparent = item.state.texture_components == 2
+        || item.state.texture_components == 4
+        || (item.state.material != no_index
+            && this->materials_[item.state.material].transparency > 0.0f);
+
+    item.depth = 0.0;
+    if (item.transparent) {
+        vec3f center = make_vec3f();
+        const bounding_sphere * const bs =
+            dynamic_cast<const bounding_sphere *>(&n.bounding_volume());
+        if (bs && !bs->maximized() && bs->radius() != -1.0) {
+            center = bs->center();
+        }
+        center *= this->matrix_ * this->modelview_;
+        item.depth = center.z();
+    }
+
+    this->items_.push_back(item);
+    return this->items_.back();
+}
+
+/**
+ * @brief Record a geometry node with the mesh @c #compiler_ has just found
+ *        or compiled for it.
+ *
+ * @param[in] n a geometry node.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void openvrml::local::render_queue::record_mesh(const geometry_node & n)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    if (!this->compiler_.mesh()) { return; }
+    this->record(n).mesh = this->compiler_.mesh();
+}
+
+/**
+ * @brief Make a light set the one in effect on the target.
+ *
+ * Directional lights are scoped to the object they are inserted in; so each
+ * light set gets an object of its own.  The lights are inserted with the
+ * transformations they were recorded with.
+ *
+ * @param[in] set   a light set.
+ */
+void openvrml::local::render_queue::use_light_set(const std::size_t set)
+{
+    if (this->scope_open_) {
+        if (set == this->submitted_light_set_) { return; }
+        this->target_.end_object();
+    }
+    this->target_.begin_object(0);
+    this->scope_open_ = true;
+    this->submitted_light_set_ = set;
+
+    std::vector<std::size_t> lights;
+    for (std::size_t s = set; s != 0; s = this->light_sets_[s].parent) {
+        lights.push_back(this->light_sets_[s].light);
+    }
+    for (std::vector<std::size_t>::reverse_iterator light = lights.rbegin();
+         light != lights.rend();
+         ++light) {
+        const directional_light & l = this->lights_[*light];
+        this->target_.transform(l.matrix);
+        this->target_.insert_dir_light(l.ambient_intensity,
+                                       l.intensity,
+                                       l.color,
+                                       l.direction);
+        this->target_.transform(l.matrix.inverse());
+    }
+}
+
+/**
+ * @brief Draw a geometry node on the target.
+ *
+ * Only the state that differs from what the target already has is set.
+ *
+ * @param[in] item  the geometry node to draw.
+ */
+void openvrml::local::render_queue::draw(const draw_item & item)
+{
+    this->use_light_set(item.light_set);
+
+    const state & s = item.state;
+    state & current = this->submitted_;
+
+    if (s.lighting != -1 && s.lighting != current.lighting) {
+        this->target_.enable_lighting(s.lighting != 0);
+        current.lighting = s.lighting;
+    }
+
+    if (s.material != no_index && s.material != current.material) {
+        const material & m = this->materials_[s.material];
+        this->target_.set_material(m.ambient_intensity,
+                                   m.diffuse_color,
+                                   m.emissive_color,
+                                   m.shininess,
+                                   m.specular_color,
+                                   m.transparency);
+        current.material = s.material;
+    }
+
+    if (s.texture) {
+        //
+        // The texture transformation does not outlast the geometry it is
+        // set for.
+        //
+        if (s.texture_transform_set) {
+            const texture_transform & t = s.texture_transform;
+            this->target_.set_texture_transform(t.center,
+                                                t.rotation,
+                                                t.scale,
+                                                t.translation);
+        }
+        if (s.texture != current.texture) {
+            //
+            // The texture node released the lock on its image when it was
+            // recorded; the image may have been replaced since, and may be
+            // being replaced now.
+            //
+            boost::shared_mutex * const image_mutex =
+                s.texture->image_mutex();
+            if (image_mutex) {
+                boost::shared_lock<boost::shared_mutex> lock(*image_mutex);
+                this->target_.insert_texture(*s.texture, s.retain_texture);
+            } else {
+                this->target_.insert_texture(*s.texture, s.retain_texture);
+            }
+            current.texture = s.texture;
+        }
+    }
+
+    if (s.material_mode_set
+        && (!current.material_mode_set
+            || s.texture_components != current.texture_components
+            || s.geometry_color != current.geometry_color)) {
+        this->target_.set_material_mode(s.texture_components,
+                                        s.geometry_color);
+        current.material_mode_set = true;
+        current.texture_components = s.texture_components;
+        current.geometry_color = s.geometry_color;
+    }
+
+    if (s.color_set
+        && (!current.color_set
+            || this->previous_geometry_color_
+            || s.color != current.color
+            || s.alpha != current.alpha)) {
+        this->target_.set_color(s.color, s.alpha);
+        current.color_set = true;
+        current.color = s.color;
+        current.alpha = s.alpha;
+    }
+
+    this->target_.begin_object(0);
+    this->target_.transform(item.matrix);
+    if (item.mesh) {
+        this->target_.insert_mesh(*item.geometry, *item.mesh);
+    } else if (item.line_set != no_index) {
+        const line_set & l = this->line_sets_[item.line_set];
+        this->target_.insert_line_set(*item.geometry,
+                                      l.coord,
+                                      l.coord_index,
+                                      l.color_per_vertex,
+                                      l.color,
+                                      l.color_index);
+    } else if (item.point_set != no_index) {
+        const point_set & p = this->point_sets_[item.point_set];
+        this->target_.insert_point_set(*item.geometry, p.coord, p.color);
+    }
+    this->target_.end_object();
+
+    this->previous_geometry_color_ = s.geometry_color;
+}
+
+openvrml::bounding_volume::intersection
+openvrml::local::render_queue::
+do_intersect_view_volume(const bounding_volume & bvolume) const
+{
+    return this->target_.intersect_view_volume(bvolume);
+}
+
+const openvrml::frustum & openvrml::local::render_queue::do_frustum() const
+{
+    return this->target_.frustum();
+}
+
+void openvrml::local::render_queue::do_frustum(const openvrml::frustum & f)
+{
+    this->target_.frustum(f);
+}
+
+openvrml::local::render_queue::rendering_mode
+openvrml::local::render_queue::do_mode()
+{
+    return this->target_.mode();
+}
+
+double openvrml::local::render_queue::do_frame_rate()
+{
+    return this->target_.frame_rate();
+}
+
+void openvrml::local::render_queue::do_reset_user_navigation()
+{
+    this->target_.reset_user_navigation();
+}
+
+void openvrml::local::render_queue::do_begin_object(const char *, bool)
+{
+    const scope s = { this->matrix_, this->light_set_ };
+    this->scopes_.push_back(s);
+}
+
+void openvrml::local::render_queue::do_end_object()
+{
+    if (this->scopes_.empty()) { return; }
+    this->matrix_ = this->scopes_.back().matrix;
+    this->light_set_ = this->scopes_.back().light_set;
+    this->scopes_.pop_back();
+}
+
+void
+openvrml::local::render_queue::
+do_insert_background(const background_node & n)
+{
+    this->target_.insert_background(n);
+}
+
+void openvrml::local::render_queue::do_insert_box(const geometry_node & n,
+                                                  const vec3f & size)
+{
+    this->compiler_.insert_box(n, size);
+    this->record_mesh(n);
+}
+
+void openvrml::local::render_queue::do_insert_cone(const geometry_node & n,
+                                                   const float height,
+                                                   const float radius,
+                                                   const bool bottom,
+                                                   const bool side)
+{
+    this->compiler_.insert_cone(n, height, radius, bottom, side);
+    this->record_mesh(n);
+}
+
+void
+openvrml::local::render_queue::do_insert_cylinder(const geometry_node & n,
+                                                  const float height,
+                                                  const float radius,
+                                                  const bool bottom,
+                                                  const bool side,
+                                                  const bool top)
+{
+    this->compiler_.insert_cylinder(n, height, radius, bottom, side, top);
+    this->record_mesh(n);
+}
+
+void
+openvrml::local::render_queue::
+do_insert_elevation_grid(const geometry_node & n,
+                         const unsigned int mask,
+                         const std::vector<float> & height,
+                         const int32 x_dimension,
+                         const int32 z_dimension,
+                         const float x_spacing,
+                         const float z_spacing,
+                         const std::vector<color> & color,
+                         const std::vector<vec3f> & normal,
+                         const std::vector<vec2f> & tex_coord)
+{
+    this->compiler_.insert_elevation_grid(n,
+                                          mask,
+                                          height,
+                                          x_dimension,
+                                          z_dimension,
+                                          x_spacing,
+                                          z_spacing,
+                                          color,
+                                          normal,
+                                          tex_coord);
+    this->record_mesh(n);
+}
+
+void
+openvrml::local::render_queue::
+do_insert_extrusion(const geometry_node & n,
+                    const unsigned int mask,
+                    const std::vector<vec3f> & spine,
+                    const std::vector<vec2f> & cross_section,
+                    const std::vector<rotation> & orientation,
+                    const std::vector<vec2f> & scale)
+{
+    this->compiler_.insert_extrusion(n,
+                                     mask,
+                                     spine,
+                                     cross_section,
+                                     orientation,
+                                     scale);
+    this->record_mesh(n);
+}
+
+void
+openvrml::local::render_queue::
+do_insert_line_set(const geometry_node & n,
+                   const std::vector<vec3f> & coord,
+                   const std::vector<int32> & coord_index,
+                   const bool color_per_vertex,
+                   const std::vector<color> & color,
+                   const std::vector<int32> & color_index)
+{
+    line_set l;
+    l.coord = coord;
+    l.coord_index = coord_index;
+    l.color_per_vertex = color_per_vertex;
+    l.color = color;
+    l.color_index = color_index;
+    this->line_sets_.push_back(l);
+    this->record(n).line_set = this->line_sets_.size() - 1;
+}
+
+void
+openvrml::local::render_queue::
+do_insert_point_set(const geometry_node & n,
+                    const std::vector<vec3f> & coord,
+                    const std::vector<color> & color)
+{
+    point_set p;
+    p.coord = coord;
+    p.color = color;
+    this->point_sets_.push_back(p);
+    this->record(n).point_set = this->point_sets_.size() - 1;
+}
+
+void
+openvrml::local::render_queue::
+do_insert_shell(const geometry_node & n,
+                const unsigned int mask,
+                const std::vector<vec3f> & coord,
+                const std::vector<int32> & coord_index,
+                const std::vector<color> & color,
+                const std::vector<int32> & color_index,
+                const std::vector<vec3f> & normal,
+                const std::vector<int32> & normal_index,
+                const std::vector<vec2f> & tex_coord,
+                const std::vector<int32> & tex_coord_index)
+{
+    this->compiler_.insert_shell(n,
+                                 mask,
+                                 coord, coord_index,
+                                 color, color_index,
+                                 normal, normal_index,
+                                 tex_coord, tex_coord_index);
+    this->record_mesh(n);
+}
+
+void openvrml::local::render_queue::do_insert_sphere(const geometry_node & n,
+                                                     const float radius)
+{
+    this->compiler_.insert_sphere(n, radius);
+    this->record_mesh(n);
+}
+
+void
+openvrml::local::render_queue::do_insert_dir_light(
+    const float ambient_intensity,
+    const float intensity,
+    const color & color,
+    const vec3f & direction)
+{
+    const directional_light light = {
+        ambient_intensity, intensity, color, direction, this->matrix_
+    };
+    this->lights_.push_back(light);
+    const light_set set = { this->light_set_, this->lights_.size() - 1 };
+    this->light_sets_.push_back(set);
+    this->light_set_ = this->light_sets_.size() - 1;
+}
+
+void
+openvrml::local::render_queue::do_insert_point_light(
+    const float ambient_intensity,
+    const vec3f & attenuation,
+    const color & color,
+    const float intensity,
+    const vec3f & location,
+    const float radius)
+{
+    this->target_.insert_point_light(ambient_intensity,
+                                     attenuation,
+                                     color,
+                                     intensity,
+                                     location,
+                                     radius);
+}
+
+void
+openvrml::local::render_queue::do_insert_spot_light(
+    const float ambient_intensity,
+    const vec3f & attenuation,
+    const float beam_width,
+    const color & color,
+    const float cut_off_angle,
+    const vec3f & direction,
+    const float intensity,
+    const vec3f & location,
+    const float radius)
+{
+    this->target_.insert_spot_light(ambient_intensity,
+                                    attenuation,
+                                    beam_width,
+                                    color,
+                                    cut_off_angle,
+                                    direction,
+                                    intensity,
+                                    location,
+                                    radius);
+}
+
+void openvrml::local::render_queue::do_remove_object(const node & ref)
+{
+    this->target_.remove_object(ref);
+}
+
+void openvrml::local::render_queue::do_enable_lighting(const bool val)
+{
+    this->state_.lighting = val ? 1 : 0;
+}
+
+void openvrml::local::render_queue::do_set_fog(const color & color,
+                                               const float visibility_range,
+                                               const char * const type)
+{
+    this->target_.set_fog(color, visibility_range, type);
+}
+
+void openvrml::local::render_queue::do_set_color(const color & rgb,
+                                                 const float a)
+{
+    this->state_.color_set = true;
+    this->state_.color = rgb;
+    this->state_.alpha = a;
+}
+
+void
+openvrml::local::render_queue::do_set_material(const float ambient_intensity,
+                                               const color & diffuse_color,
+                                               const color & emissive_color,
+                                               const float shininess,
+                                               const color & specular_color,
+                                               const float transparency)
+{
+    const material m = {
+        ambient_intensity,
+        diffuse_color,
+        emissive_color,
+        shininess,
+        specular_color,
+        transparency
+    };
+    const std::pair<std::map<material, std::size_t>::iterator, bool> result =
+        this->material_index_.insert(
+            std::make_pair(m, this->materials_.size()));
+    if (result.second) { this->materials_.push_back(m); }
+    this->state_.material = result.first->second;
+}
+
+void
+openvrml::local::render_queue::do_set_material_mode(
+    const size_t tex_components,
+    const bool geometry_color)
+{
+    this->state_.material_mode_set = true;
+    this->state_.texture_components = tex_components;
+    this->state_.geometry_color = geometry_color;
+}
+
+void openvrml::local::render_queue::do_set_sensitive(node * const object)
+{
+    this->target_.set_sensitive(object);
+}
+
+void openvrml::local::render_queue::do_insert_texture(const texture_node & n,
+                                                      const bool retainHint)
+{
+    this->state_.texture = &n;
+    this->state_.retain_texture = retainHint;
+}
+
+void
+openvrml::local::render_queue::
+do_remove_texture_object(const texture_node & ref)
+{
+    this->target_.remove_texture_object(ref);
+}
+
+void
+openvrml::local::render_queue::do_set_texture_transform(
+    const vec2f & center,
+    const float rotation,
+    const vec2f & scale,
+    const vec2f & translation)
+{
+    this->state_.texture_transform_set = true;
+    this->state_.texture_transform.center = center;
+    this->state_.texture_transform.rotation = rotation;
+    this->state_.texture_transform.scale = scale;
+    this->state_.texture_transform.translation = translation;
+}
+
+void
+openvrml::local::render_queue::do_set_frustum(const float field_of_view,
+                                              const float avatar_size,
+                                              const float visibility_limit)
+{
+    this->target_.set_frustum(field_of_view, avatar_size, visibility_limit);
+}
+
+void
+openvrml::local::render_queue::do_set_viewpoint(
+    const vec3f & position,
+    const rotation & orientation,
+    const float avatar_size,
+    const float visibility_limit)
+{
+    this->target_.set_viewpoint(position,
+                                orientation,
+                                avatar_size,
+                                visibility_limit);
+}
+
+void openvrml::local::render_queue::do_transform(const mat4f & mat)
+{
+    this->matrix_ = mat * this->matrix_;
+}
+
+void
+openvrml::local::render_queue::do_transform_points(const size_t nPoints,
+                                                   vec3f * point) const
+{
+    const mat4f m = this->matrix_ * this->modelview_;
+    for (size_t i = 0; i < nPoints; ++i) { point[i] *= m; }
+}
+
+void
+openvrml::local::render_queue::do_draw_bounding_sphere(
+    const bounding_sphere & bs,
+    const bounding_volume::intersection intersection)
+{
+    const bounding_sphere_item item = { bs, intersection, this->matrix_ };
+    this->bounding_spheres_.push_back(item);
+}
@@ -0,0 +1,301 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# ifndef OPENVRML_LOCAL_RENDER_QUEUE_H
+#   define OPENVRML_LOCAL_RENDER_QUEUE_H
+
+#   include "compiling_viewer.h"
+#   include <boost/shared_ptr.hpp>
+#   include <map>
+#   include <vector>
+
+namespace openvrml {
+
+    namespace local {
+
+        class OPENVRML_LOCAL render_queue : public viewer {
+        public:
+            struct material {
+                float ambient_intensity;
+                color diffuse_color;
+                color emissive_color;
+                float shininess;
+                color specular_color;
+                float transparency;
+            };
+
+        private:
+            struct directional_light {
+                float ambient_intensity;
+                float intensity;
+                openvrml::color color;
+                vec3f direction;
+                mat4f matrix;
+            };
+
+            struct light_set {
+                std::size_t parent;
+                std::size_t light;
+            };
+
+            struct scope {
+                mat4f matrix;
+                std::size_t light_set;
+            };
+
+            struct texture_transform {
+                vec2f center;
+                float rotation;
+                vec2f scale;
+                vec2f translation;
+            };
+
+            struct state {
+                int lighting;
+                std::size_t material;
+                const texture_node * texture;
+                bool retain_texture;
+                bool texture_transform_set;
+                struct texture_transform texture_transform;
+                bool material_mode_set;
+                std::size_t texture_components;
+                bool geometry_color;
+                bool color_set;
+                openvrml::color color;
+                float alpha;
+
+                state() OPENVRML_NOTHROW;
+            };
+
+            struct line_set {
+                std::vector<vec3f> coord;
+                std::vector<int32> coord_index;
+                bool color_per_vertex;
+                std::vector<openvrml::color> color;
+                std::vector<int32> color_index;
+            };
+
+            struct point_set {
+                std::vector<vec3f> coord;
+                std::vector<openvrml::color> color;
+            };
+
+            struct draw_item {
+                const geometry_node * geometry;
+                boost::shared_ptr<const compiled_mesh> mesh;
+                std::size_t line_set;
+                std::size_t point_set;
+                mat4f matrix;
+                std::size_t light_set;
+                struct state state;
+                bool transparent;
+                float depth;
+            };
+
+            struct bounding_sphere_item {
+                bounding_sphere sphere;
+                bounding_volume::intersection intersection;
+                mat4f matrix;
+            };
+
+            struct state_less;
+            struct farther;
+
+            viewer & target_;
+            const mat4f modelview_;
+            compiling_viewer compiler_;
+
+            std::vector<scope> scopes_;
+            mat4f matrix_;
+            std::size_t light_set_;
+            std::vector<directional_light> lights_;
+            std::vector<light_set> light_sets_;
+            struct state state_;
+            std::vector<material> materials_;
+            std::map<material, std::size_t> material_index_;
+            std::vector<draw_item> items_;
+            std::vector<struct line_set> line_sets_;
+            std::vector<struct point_set> point_sets_;
+            std::vector<bounding_sphere_item> bounding_spheres_;
+
+            bool scope_open_;
+            std::size_t submitted_light_set_;
+            struct state submitted_;
+            bool previous_geometry_color_;
+
+        public:
+            render_queue(viewer & target, const mat4f & modelview)
+                OPENVRML_THROW1(std::bad_alloc);
+            virtual ~render_queue() OPENVRML_NOTHROW;
+
+            std::size_t size() const OPENVRML_NOTHROW;
+
+            void submit();
+
+        private:
+            draw_item & record(const geometry_node & n)
+                OPENVRML_THROW1(std::bad_alloc);
+            void record_mesh(const geometry_node & n)
+                OPENVRML_THROW1(std::bad_alloc);
+            void use_light_set(std::size_t set);
+            void draw(const draw_item & item);
+
+            virtual bounding_volume::intersection
+            do_intersect_view_volume(const bounding_volume & bvolume) const;
+            virtual const openvrml::frustum & do_frustum() const;
+            virtual void do_frustum(const openvrml::frustum & f);
+
+            virtual rendering_mode do_mode();
+            virtual double do_frame_rate();
+            virtual void do_reset_user_navigation();
+
+            virtual void do_begin_object(const char * id, bool retain);
+            virtual void do_end_object();
+
+            virtual void do_insert_background(const background_node & n);
+
+            virtual void do_insert_box(const geometry_node & n,
+                                       const vec3f & size);
+            virtual void do_insert_cone(const geometry_node & n,
+                                        float height, float radius,
+                                        bool bottom, bool side);
+            virtual void do_insert_cylinder(const geometry_node & n,
+                                            float height, float radius,
+                                            bool bottom, bool side,
+                                            bool top);
+            virtual void
+            do_insert_elevation_grid(const geometry_node & n,
+                                     unsigned int mask,
+                                     const std::vector<float> & height,
+                                     int32 x_dimension, int32 z_dimension,
+                                     float x_spacing, float z_spacing,
+                                     const std::vector<color> & color,
+                                     const std::vector<vec3f> & normal,
+                                     const std::vector<vec2f> & tex_coord);
+            virtual void
+            do_insert_extrusion(const geometry_node & n,
+                                unsigned int mask,
+                                const std::vector<vec3f> & spine,
+                                const std::vector<vec2f> & cross_section,
+                                const std::vector<rotation> & orientation,
+                                const std::vector<vec2f> & scale);
+            virtual void
+            do_insert_line_set(const geometry_node & n,
+                               const std::vector<vec3f> & coord,
+                               const std::vector<int32> & coord_index,
+                               bool color_per_vertex,
+                               const std::vector<color> & color,
+                               const std::vector<int32> & color_index);
+            virtual void
+            do_insert_point_set(const geometry_node & n,
+                                const std::vector<vec3f> & coord,
+                                const std::vector<color> & color);
+            virtual void
+            do_insert_shell(const geometry_node & n,
+                            unsigned int mask,
+                            const std::vector<vec3f> & coord,
+                            const std::vector<int32> & coord_index,
+                            const std::vector<color> & color,
+                            const std::vector<int32> & color_index,
+                            const std::vector<vec3f> & normal,
+                            const std::vector<int32> & normal_index,
+                            const std::vector<vec2f> & tex_coord,
+                            const std::vector<int32> & tex_coord_index);
+            virtual void do_insert_sphere(const geometry_node & n,
+                                          float radius);
+
+            virtual void do_insert_dir_light(float ambient_intensity,
+                                             float intensity,
+                                             const color & color,
+                                             const vec3f & direction);
+            virtual void do_insert_point_light(float ambient_intensity,
+                                               const vec3f & attenuation,
+                                               const color & color,
+                                               float intensity,
+                                               const vec3f & location,
+                                               float radius);
+            virtual void do_insert_spot_light(float ambient_intensity,
+                                              const vec3f & attenuation,
+                                              float beam_width,
+                                              const color & color,
+                                              float cut_off_angle,
+                                              const vec3f & direction,
+                                              float intensity,
+                                              const vec3f & location,
+                                              float radius);
+
+            virtual void do_remove_object(const node & ref);
+
+            virtual void do_enable_lighting(bool val);
+
+            virtual void do_set_fog(const color & color,
+                                    float visibility_range,
+                                    const char * type);
+
+            virtual void do_set_color(const color & rgb, float a);
+
+            virtual void do_set_material(float ambient_intensity,
+                                         const color & diffuse_color,
+                                         const color & emissive_color,
+                                         float shininess,
+                                         const color & specular_color,
+                                         float transparency);
+
+            virtual void do_set_material_mode(size_t tex_components,
+                                              bool geometry_color);
+
+            virtual void do_set_sensitive(node * object);
+
+            virtual void do_insert_texture(const texture_node & n,
+                                           bool retainHint);
+
+            virtual void do_remove_texture_object(const texture_node & ref);
+
+            virtual void do_set_texture_transform(const vec2f & center,
+                                                  float rotation,
+                                                  const vec2f & scale,
+                                                  const vec2f & translation);
+
+            virtual void do_set_frustum(float field_of_view,
+                                        float avatar_size,
+                                        float visibility_limit);
+            virtual void do_set_viewpoint(const vec3f & position,
+                                          const rotation & orientation,
+                                          float avatar_size,
+                                          float visibility_limit);
+
+            virtual void do_transform(const mat4f & mat);
+
+            virtual void do_transform_points(size_t nPoints,
+                                             vec3f * point) const;
+
+            virtual void
+            do_draw_bounding_sphere(
+                const bounding_sphere & bs,
+                bounding_volume::intersection intersection);
+        };
+
+        OPENVRML_LOCAL bool operator<(const render_queue::material & lhs,
+                                      const render_queue::material & rhs)
+            OPENVRML_NOTHROW;
+    }
+}
+
+# endif // ifndef OPENVRML_LOCAL_RENDER_QUEUE_H
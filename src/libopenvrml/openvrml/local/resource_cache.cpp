@@ -0,0 +1,830 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# include "resource_cache.h"
+# include "buffer_streambuf.h"
+# include <algorithm>
+# include <cassert>
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+namespace {
+
+    const std::size_t read_size = 64 * 1024;
+
+    //
+    // 64-bit FNV-1a.
+    //
+    OPENVRML_LOCAL boost::uint64_t digest(const std::vector<char> & data)
+    {
+        boost::uint64_t hash = 14695981039346656037ULL;
+        for (std::vector<char>::const_iterator c = data.begin();
+             c != data.end();
+             ++c) {
+            hash ^= static_cast<unsigned char>(*c);
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+}
+
+/**
+ * @internal
+ *
+ * @class openvrml::local::resource_cache_impl openvrml/local/resource_cache.h
+ *
+ * @brief The implementation of @c openvrml::resource_cache.
+ *
+ * A resource is cached once it has been read to the end.  Until then, it is
+ * &ldquo;pending&rdquo;: the first stream for the URI reads from the
+ * underlying @c resource_fetcher and appends what it reads to a
+ * @c pending record, and any further requests for the URI get streams that
+ * read from that record as it grows.  If the first stream is destroyed
+ * before reaching the end, those streams fall back to fetching the
+ * resource themselves.
+ *
+ * Cached data is immutable and shared by reference with the streams reading
+ * it; so eviction never invalidates a stream.  Resources with the same
+ * content share a single buffer, whatever their URIs; that buffer counts
+ * against the budget once.  A resource larger than the budget is not
+ * cached: once the pending data outgrow the budget, the fetch is abandoned
+ * and the first stream just passes the rest through.
+ */
+
+/**
+ * @internal
+ *
+ * @brief A resource being fetched for the first time.
+ */
+struct OPENVRML_LOCAL openvrml::local::resource_cache_impl::pending :
+    boost::noncopyable {
+
+    enum state_id { receiving, complete, abandoned };
+
+    boost::mutex mutex;
+    boost::condition_variable changed;
+    std::vector<boost::function0<void> > waiting;
+    const std::string type;
+    const boost::shared_ptr<bytes> data;
+    state_id state;
+
+    explicit pending(const std::string & type):
+        type(type),
+        data(new bytes),
+        state(receiving)
+    {}
+
+    //
+    // Wake the streams reading the pending data, and call the callbacks
+    // given to resource_istream::notify_data_available for them.
+    //
+    void notify_changed() OPENVRML_NOTHROW
+    {
+        std::vector<boost::function0<void> > callbacks;
+        {
+            boost::mutex::scoped_lock lock(this->mutex);
+            callbacks.swap(this->waiting);
+        }
+        this->changed.notify_all();
+        for (std::vector<boost::function0<void> >::const_iterator callback =
+                 callbacks.begin();
+             callback != callbacks.end();
+             ++callback) {
+            (*callback)();
+        }
+    }
+};
+
+/**
+ * @internal
+ *
+ * @brief A stream over a cached resource.
+ */
+class OPENVRML_LOCAL openvrml::local::resource_cache_impl::cached_istream :
+    public resource_istream {
+
+    class streambuf : public buffer_streambuf {
+        const boost::shared_ptr<const bytes> data_;
+
+    public:
+        explicit streambuf(const boost::shared_ptr<const bytes> & data):
+            data_(data)
+        {
+            const char * const begin = data->empty() ? 0 : &data->front();
+            this->buffer(begin, begin + data->size());
+        }
+
+        virtual ~streambuf() OPENVRML_NOTHROW
+        {}
+    };
+
+    const std::string url_, type_;
+    streambuf buf_;
+
+public:
+    cached_istream(const std::string & url,
+                   const std::string & type,
+                   const boost::shared_ptr<const bytes> & data):
+        resource_istream(&this->buf_),
+        url_(url),
+        type_(type),
+        buf_(data)
+    {}
+
+private:
+    virtual const std::string do_url() const OPENVRML_THROW1(std::bad_alloc)
+    {
+        return this->url_;
+    }
+
+    virtual const std::string do_type() const OPENVRML_THROW1(std::bad_alloc)
+    {
+        return this->type_;
+    }
+
+    virtual bool do_data_available() const OPENVRML_NOTHROW
+    {
+        return !!(*this);
+    }
+
+    virtual bool
+    do_notify_data_available(const boost::function0<void> & callback)
+        OPENVRML_THROW1(std::bad_alloc)
+    {
+        callback();
+        return true;
+    }
+};
+
+/**
+ * @internal
+ *
+ * @brief The first stream for a resource; it reads from the underlying
+ *        @c resource_fetcher and fills in the @c pending record.
+ */
+class OPENVRML_LOCAL openvrml::local::resource_cache_impl::caching_istream :
+    public resource_istream {
+
+    class streambuf : public std::streambuf {
+        resource_cache_impl & cache_;
+        const std::string uri_;
+        const std::auto_ptr<resource_istream> source_;
+        const boost::shared_ptr<pending> pending_;
+        std::vector<char> buf_;
+        bool caching_;
+        bool finished_;
+
+    public:
+        streambuf(resource_cache_impl & cache,
+                  const std::string & uri,
+                  std::auto_ptr<resource_istream> source,
+                  const boost::shared_ptr<pending> & p):
+            cache_(cache),
+            uri_(uri),
+            source_(source),
+            pending_(p),
+            buf_(read_size),
+            caching_(true),
+            finished_(false)
+        {
+            this->setg(&this->buf_[0], &this->buf_[0], &this->buf_[0]);
+        }
+
+        virtual ~streambuf() OPENVRML_NOTHROW
+        {
+            if (this->caching_ && !this->finished_) {
+                this->cache_.abandon(this->uri_, *this->pending_);
+            }
+        }
+
+        resource_istream & source() const OPENVRML_NOTHROW
+        {
+            return *this->source_;
+        }
+
+    private:
+        //
+        // Append the first n bytes of buf_ to the pending data; or, if that
+        // would take them over the budget, give up caching the resource.
+        //
+        void cache(const std::size_t n)
+        {
+            const std::size_t budget = this->cache_.budget();
+            bool over_budget;
+            {
+                boost::mutex::scoped_lock lock(this->pending_->mutex);
+                bytes & data = *this->pending_->data;
+                over_budget = data.size() + n > budget;
+                if (over_budget) {
+                    //
+                    // Streams reading the pending data fetch the rest
+                    // themselves once it is abandoned; they do not need
+                    // what has been read so far.
+                    //
+                    bytes().swap(data);
+                } else {
+                    data.insert(data.end(),
+                                this->buf_.begin(),
+                                this->buf_.begin() + n);
+                }
+            }
+            if (over_budget) {
+                this->caching_ = false;
+                this->cache_.abandon(this->uri_, *this->pending_);
+            } else {
+                this->pending_->notify_changed();
+            }
+        }
+
+    protected:
+        virtual std::streamsize showmanyc()
+        {
+            return this->source_->rdbuf()->in_avail();
+        }
+
+        virtual int_type underflow()
+        {
+            if (this->gptr() < this->egptr()) {
+                return traits_type::to_int_type(*this->gptr());
+            }
+            if (this->finished_) { return traits_type::eof(); }
+
+            //
+            // Take whatever the source has buffered; otherwise block for a
+            // single character.
+            //
+            std::streambuf & source = *this->source_->rdbuf();
+            const std::streamsize available = source.in_avail();
+            const std::streamsize n =
+                source.sgetn(&this->buf_[0],
+                             (available > 0)
+                             ? std::min(available,
+                                        std::streamsize(this->buf_.size()))
+                             : 1);
+            if (n <= 0) {
+                this->finished_ = true;
+                if (!this->caching_) { return traits_type::eof(); }
+                if (*this->source_) {
+                    this->cache_.complete(this->uri_, *this->pending_);
+                } else {
+                    this->cache_.abandon(this->uri_, *this->pending_);
+                }
+                return traits_type::eof();
+            }
+            if (this->caching_) { this->cache(std::size_t(n)); }
+            this->setg(&this->buf_[0], &this->buf_[0], &this->buf_[0] + n);
+            return traits_type::to_int_type(*this->gptr());
+        }
+    };
+
+    streambuf buf_;
+
+public:
+    caching_istream(resource_cache_impl & cache,
+                    const std::string & uri,
+                    std::auto_ptr<resource_istream> source,
+                    const boost::shared_ptr<pending> & p):
+        resource_istream(&this->buf_),
+        buf_(cache, uri, source, p)
+    {}
+
+private:
+    virtual const std::string do_url() const OPENVRML_THROW1(std::bad_alloc)
+    {
+        return this->buf_.source().url();
+    }
+
+    virtual const std::string do_type() const OPENVRML_THROW1(std::bad_alloc)
+    {
+        return this->buf_.source().type();
+    }
+
+    virtual bool do_data_available() const OPENVRML_NOTHROW
+    {
+        return const_cast<streambuf &>(this->buf_).in_avail() > 0
+            || this->buf_.source().data_available();
+    }
+
+    virtual bool
+    do_notify_data_available(const boost::function0<void> & callback)
+        OPENVRML_THROW1(std::bad_alloc)
+    {
+        if (this->buf_.in_avail() > 0) {
+            callback();
+            return true;
+        }
+        return this->buf_.source().notify_data_available(callback);
+    }
+};
+
+/**
+ * @internal
+ *
+ * @brief A stream for a resource that another stream is already fetching.
+ *
+ * Data is read from the @c pending record.  If the fetch is abandoned, the
+ * rest of the resource is fetched directly.
+ */
+class OPENVRML_LOCAL openvrml::local::resource_cache_impl::pending_istream :
+    public resource_istream {
+
+    class streambuf : public std::streambuf {
+        resource_fetcher & fetcher_;
+        const std::string uri_;
+        const boost::shared_ptr<pending> pending_;
+        std::size_t offset_;
+        std::auto_ptr<resource_istream> source_;
+        std::vector<char> buf_;
+
+    public:
+        streambuf(resource_fetcher & fetcher,
+                  const std::string & uri,
+                  const boost::shared_ptr<pending> & p):
+            fetcher_(fetcher),
+            uri_(uri),
+            pending_(p),
+            offset_(0),
+            buf_(read_size)
+        {
+            this->setg(&this->buf_[0], &this->buf_[0], &this->buf_[0]);
+        }
+
+        virtual ~streambuf() OPENVRML_NOTHROW
+        {}
+
+        const std::string type() const OPENVRML_THROW1(std::bad_alloc)
+        {
+            return this->source_.get()
+                ? this->source_->type()
+                : this->pending_->type;
+        }
+
+        bool data_available() OPENVRML_NOTHROW
+        {
+            if (this->gptr() < this->egptr()) { return true; }
+            if (this->source_.get()) {
+                return this->source_->data_available();
+            }
+            boost::mutex::scoped_lock lock(this->pending_->mutex);
+            return this->offset_ < this->pending_->data->size()
+                || this->pending_->state != pending::receiving;
+        }
+
+        bool notify_data_available(const boost::function0<void> & callback)
+            OPENVRML_THROW1(std::bad_alloc)
+        {
+            if (this->gptr() == this->egptr()) {
+                if (this->source_.get()) {
+                    return this->source_->notify_data_available(callback);
+                }
+                boost::mutex::scoped_lock lock(this->pending_->mutex);
+                if (this->offset_ == this->pending_->data->size()
+                    && this->pending_->state == pending::receiving) {
+                    this->pending_->waiting.push_back(callback);
+                    return true;
+                }
+            }
+            callback();
+            return true;
+        }
+
+    protected:
+        virtual std::streamsize showmanyc()
+        {
+            if (this->source_.get()) {
+                return this->source_->rdbuf()->in_avail();
+            }
+            boost::mutex::scoped_lock lock(this->pending_->mutex);
+            const std::size_t size = this->pending_->data->size();
+            if (this->offset_ < size) {
+                return size - this->offset_;
+            }
+            return (this->pending_->state == pending::complete) ? -1 : 0;
+        }
+
+        virtual int_type underflow()
+        {
+            if (this->gptr() < this->egptr()) {
+                return traits_type::to_int_type(*this->gptr());
+            }
+
+            if (!this->source_.get()) {
+                boost::mutex::scoped_lock lock(this->pending_->mutex);
+                const bytes & data = *this->pending_->data;
+                while (this->offset_ == data.size()
+                       && this->pending_->state == pending::receiving) {
+                    this->pending_->changed.wait(lock);
+                }
+                if (this->offset_ < data.size()) {
+                    const std::size_t n =
+                        std::min(data.size() - this->offset_,
+                                 this->buf_.size());
+                    std::copy(data.begin() + this->offset_,
+                              data.begin() + this->offset_ + n,
+                              this->buf_.begin());
+                    this->offset_ += n;
+                    this->setg(&this->buf_[0],
+                               &this->buf_[0],
+                               &this->buf_[0] + n);
+                    return traits_type::to_int_type(*this->gptr());
+                }
+                if (this->pending_->state == pending::complete) {
+                    return traits_type::eof();
+                }
+                lock.unlock();
+
+                //
+                // The fetch was abandoned; get the rest ourselves.
+                //
+                try {
+                    this->source_ = this->fetcher_.get_resource(this->uri_);
+                } catch (std::exception &) {
+                    return traits_type::eof();
+                }
+                if (!this->source_.get()) { return traits_type::eof(); }
+                this->source_->ignore(std::streamsize(this->offset_));
+            }
+
+            const std::streamsize n =
+                this->source_->rdbuf()->sgetn(&this->buf_[0],
+                                              this->buf_.size());
+            if (n <= 0) { return traits_type::eof(); }
+            this->setg(&this->buf_[0], &this->buf_[0], &this->buf_[0] + n);
+            return traits_type::to_int_type(*this->gptr());
+        }
+    };
+
+    const std::string url_;
+    streambuf buf_;
+
+public:
+    pending_istream(resource_fetcher & fetcher,
+                    const std::string & uri,
+                    const boost::shared_ptr<pending> & p):
+        resource_istream(&this->buf_),
+        url_(uri),
+        buf_(fetcher, uri, p)
+    {}
+
+private:
+    virtual const std::string do_url() const OPENVRML_THROW1(std::bad_alloc)
+    {
+        return this->url_;
+    }
+
+    virtual const std::string do_type() const OPENVRML_THROW1(std::bad_alloc)
+    {
+        return this->buf_.type();
+    }
+
+    virtual bool do_data_available() const OPENVRML_NOTHROW
+    {
+        return const_cast<streambuf &>(this->buf_).data_available();
+    }
+
+    virtual bool
+    do_notify_data_available(const boost::function0<void> & callback)
+        OPENVRML_THROW1(std::bad_alloc)
+    {
+        return this->buf_.notify_data_available(callback);
+    }
+};
+
+/**
+ * @brief Construct.
+ *
+ * @param[in] fetcher   the underlying @c resource_fetcher.
+ * @param[in] budget    the maximum number of bytes to keep cached.
+ */
+openvrml::local::resource_cache_impl::
+resource_cache_impl(resource_fetcher & fetcher, const std::size_t budget)
+    OPENVRML_NOTHROW:
+    fetcher_(fetcher),
+    budget_(budget),
+    size_(0)
+{}
+
+/**
+ * @brief Destroy.
+ */
+openvrml::local::resource_cache_impl::~resource_cache_impl() OPENVRML_NOTHROW
+{}
+
+/**
+ * @brief Get a resource from the cache, or from the underlying
+ *        @c resource_fetcher.
+ *
+ * Streams that are already in memory (for instance, those from a
+ * @c file_resource_fetcher) and streams that fail to open are passed
+ * through without being cached.
+ *
+ * @param[in] uri   an absolute URI.
+ *
+ * @return the resource as a stream.
+ */
+std::auto_ptr<openvrml::resource_istream>
+openvrml::local::resource_cache_impl::get_resource(const std::string & uri)
+{
+    {
+        boost::mutex::scoped_lock lock(this->mutex_);
+        const entry_map::iterator cached = this->entries_.find(uri);
+        if (cached != this->entries_.end()) {
+            this->lru_.splice(this->lru_.begin(),
+                              this->lru_,
+                              cached->second.lru_pos);
+            return std::auto_ptr<resource_istream>(
+                new cached_istream(uri,
+                                   cached->second.type,
+                                   cached->second.data));
+        }
+        const pending_map::const_iterator fetching = this->pending_.find(uri);
+        if (fetching != this->pending_.end()) {
+            return std::auto_ptr<resource_istream>(
+                new pending_istream(this->fetcher_, uri, fetching->second));
+        }
+    }
+
+    std::auto_ptr<resource_istream> source =
+        this->fetcher_.get_resource(uri);
+    if (!source.get() || !*source || contiguous_buffer(*source)) {
+        return source;
+    }
+    const boost::shared_ptr<pending> p(new pending(source->type()));
+    {
+        boost::mutex::scoped_lock lock(this->mutex_);
+        //
+        // Another thread may have started fetching the same resource while
+        // the lock was released; if so, just hand back the stream we have.
+        //
+        if (this->entries_.find(uri) != this->entries_.end()
+            || !this->pending_.insert(std::make_pair(uri, p)).second) {
+            return source;
+        }
+    }
+    return std::auto_ptr<resource_istream>(
+        new caching_istream(*this, uri, source, p));
+}
+
+/**
+ * @brief The maximum number of bytes kept in the cache.
+ *
+ * @return the maximum number of bytes kept in the cache.
+ */
+std::size_t openvrml::local::resource_cache_impl::budget() const
+    OPENVRML_NOTHROW
+{
+    boost::mutex::scoped_lock lock(this->mutex_);
+    return this->budget_;
+}
+
+/**
+ * @brief Set the maximum number of bytes kept in the cache.
+ *
+ * Least recently used resources are evicted to meet the new budget.
+ *
+ * @param[in] bytes the maximum number of bytes to keep in the cache.
+ */
+void openvrml::local::resource_cache_impl::budget(const std::size_t bytes)
+    OPENVRML_NOTHROW
+{
+    boost::mutex::scoped_lock lock(this->mutex_);
+    this->budget_ = bytes;
+    this->evict(this->budget_);
+}
+
+/**
+ * @brief The number of bytes in the cache.
+ *
+ * @return the number of bytes in the cache.
+ */
+std::size_t openvrml::local::resource_cache_impl::size() const
+    OPENVRML_NOTHROW
+{
+    boost::mutex::scoped_lock lock(this->mutex_);
+    return this->size_;
+}
+
+/**
+ * @brief Evict everything.
+ *
+ * Resources being fetched are unaffected.
+ */
+void openvrml::local::resource_cache_impl::clear() OPENVRML_NOTHROW
+{
+    boost::mutex::scoped_lock lock(this->mutex_);
+    this->evict(0);
+}
+
+/**
+ * @brief Finish fetching a resource and add it to the cache.
+ *
+ * @param[in] uri   the URI of the resource.
+ * @param[in] p     the @c pending record for @p uri.
+ */
+void
+openvrml::local::resource_cache_impl::complete(const std::string & uri,
+                                               pending & p)
+    OPENVRML_NOTHROW
+{
+    {
+        //
+        // Streams reading p only ever touch its data with p.mutex held; so
+        // it can be trimmed here.
+        //
+        boost::mutex::scoped_lock lock(p.mutex);
+        try {
+            if (p.data->capacity() > p.data->size()) {
+                bytes(*p.data).swap(*p.data);
+            }
+        } catch (std::bad_alloc &) {
+            //
+            // Keep the slack.
+            //
+        }
+        p.state = pending::complete;
+    }
+    p.notify_changed();
+
+    const boost::uint64_t hash = digest(*p.data);
+    boost::mutex::scoped_lock lock(this->mutex_);
+    const pending_map::iterator fetching = this->pending_.find(uri);
+    if (fetching == this->pending_.end() || fetching->second.get() != &p) {
+        return;
+    }
+    const boost::shared_ptr<bytes> data = p.data;
+    this->pending_.erase(fetching);
+    if (data->size() > this->budget_) { return; }
+    entry e;
+    try {
+        e.type = p.type;
+        e.data = this->shared_content(data, hash);
+        e.digest = hash;
+    } catch (std::bad_alloc &) {
+        return;
+    }
+    try {
+        this->lru_.push_front(uri);
+        e.lru_pos = this->lru_.begin();
+        try {
+            this->entries_.insert(std::make_pair(uri, e));
+        } catch (std::bad_alloc &) {
+            this->lru_.pop_front();
+            throw;
+        }
+    } catch (std::bad_alloc &) {
+        this->release_content(e);
+        return;
+    }
+    this->evict(this->budget_);
+}
+
+/**
+ * @brief Give up fetching a resource.
+ *
+ * Streams waiting on @p p will fetch the rest of the resource themselves.
+ *
+ * @param[in] uri   the URI of the resource.
+ * @param[in] p     the @c pending record for @p uri.
+ */
+void
+openvrml::local::resource_cache_impl::abandon(const std::string & uri,
+                                              pending & p)
+    OPENVRML_NOTHROW
+{
+    {
+        boost::mutex::scoped_lock lock(this->mutex_);
+        const pending_map::iterator fetching = this->pending_.find(uri);
+        if (fetching != this->pending_.end()
+            && fetching->second.get() == &p) {
+            this->pending_.erase(fetching);
+        }
+    }
+    {
+        boost::mutex::scoped_lock lock(p.mutex);
+        p.state = pending::abandoned;
+    }
+    p.notify_changed();
+}
+
+/**
+ * @brief Find a cached buffer with the same content as @p data.
+ *
+ * The buffer returned is counted as used by one more entry; if it was not
+ * used by any, its size is added to @c #size_.
+ *
+ * @c #mutex_ must be held.
+ *
+ * @param[in] data      newly fetched data.
+ * @param[in] digest    the digest of @p data.
+ *
+ * @return a cached buffer equal to @p data if there is one; otherwise
+ *         @p data.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+const boost::shared_ptr<const openvrml::local::resource_cache_impl::bytes>
+openvrml::local::resource_cache_impl::
+shared_content(const boost::shared_ptr<bytes> & data,
+               const boost::uint64_t digest)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    typedef std::pair<content_map::iterator, content_map::iterator> range_t;
+    const range_t range = this->contents_.equal_range(digest);
+    for (content_map::iterator pos = range.first; pos != range.second;) {
+        const boost::shared_ptr<const bytes> existing =
+            pos->second.data.lock();
+        if (!existing) {
+            assert(pos->second.entries == 0);
+            this->contents_.erase(pos++);
+            continue;
+        }
+        if (*existing == *data) {
+            if (pos->second.entries++ == 0) {
+                this->size_ += existing->size();
+            }
+            return existing;
+        }
+        ++pos;
+    }
+    content c;
+    c.data = data;
+    c.entries = 1;
+    this->contents_.insert(std::make_pair(digest, c));
+    this->size_ += data->size();
+    return data;
+}
+
+/**
+ * @brief Release an entry's use of its buffer.
+ *
+ * If no other entry uses the buffer, its size is subtracted from
+ * @c #size_ and it is forgotten.
+ *
+ * @c #mutex_ must be held.
+ *
+ * @param[in] e an entry.
+ */
+void openvrml::local::resource_cache_impl::release_content(const entry & e)
+    OPENVRML_NOTHROW
+{
+    typedef std::pair<content_map::iterator, content_map::iterator> range_t;
+    const range_t range = this->contents_.equal_range(e.digest);
+    for (content_map::iterator pos = range.first; pos != range.second;) {
+        const boost::shared_ptr<const bytes> existing =
+            pos->second.data.lock();
+        if (existing == e.data) {
+            assert(pos->second.entries > 0);
+            if (--pos->second.entries == 0) {
+                this->size_ -= e.data->size();
+                this->contents_.erase(pos);
+            }
+            return;
+        }
+        if (!existing) {
+            this->contents_.erase(pos++);
+        } else {
+            ++pos;
+        }
+    }
+    assert(false);
+}
+
+/**
+ * @brief Evict least recently used resources until the cache holds no more
+ *        than @p budget bytes.
+ *
+ * @c #mutex_ must be held.
+ *
+ * @param[in] budget    the number of bytes to allow.
+ */
+void openvrml::local::resource_cache_impl::evict(const std::size_t budget)
+    OPENVRML_NOTHROW
+{
+    while (this->size_ > budget && !this->lru_.empty()) {
+        const entry_map::iterator victim =
+            this->entries_.find(this->lru_.back());
+        assert(victim != this->entries_.end());
+        this->release_content(victim->second);
+        this->entries_.erase(victim);
+        this->lru_.pop_back();
+    }
+}
@@ -0,0 +1,104 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# ifndef OPENVRML_LOCAL_RESOURCE_CACHE_H
+#   define OPENVRML_LOCAL_RESOURCE_CACHE_H
+
+#   include <openvrml/browser.h>
+#   include <boost/cstdint.hpp>
+#   include <boost/shared_ptr.hpp>
+#   include <boost/thread.hpp>
+#   include <boost/weak_ptr.hpp>
+#   include <list>
+#   include <map>
+
+namespace openvrml {
+
+    namespace local {
+
+        class OPENVRML_LOCAL resource_cache_impl : boost::noncopyable {
+        public:
+            typedef std::vector<char> bytes;
+
+            struct pending;
+
+        private:
+            class cached_istream;
+            class caching_istream;
+            class pending_istream;
+
+            typedef std::list<std::string> lru_list;
+
+            struct entry {
+                std::string type;
+                boost::shared_ptr<const bytes> data;
+                boost::uint64_t digest;
+                lru_list::iterator lru_pos;
+            };
+
+            struct content {
+                boost::weak_ptr<const bytes> data;
+                std::size_t entries;
+            };
+
+            typedef std::map<std::string, entry> entry_map;
+            typedef std::multimap<boost::uint64_t, content> content_map;
+            typedef std::map<std::string, boost::shared_ptr<pending> >
+                pending_map;
+
+            resource_fetcher & fetcher_;
+            mutable boost::mutex mutex_;
+            std::size_t budget_;
+            std::size_t size_;
+            lru_list lru_;
+            entry_map entries_;
+            content_map contents_;
+            pending_map pending_;
+
+        public:
+            resource_cache_impl(resource_fetcher & fetcher,
+                                std::size_t budget)
+                OPENVRML_NOTHROW;
+            ~resource_cache_impl() OPENVRML_NOTHROW;
+
+            std::auto_ptr<resource_istream>
+            get_resource(const std::string & uri);
+
+            std::size_t budget() const OPENVRML_NOTHROW;
+            void budget(std::size_t bytes) OPENVRML_NOTHROW;
+            std::size_t size() const OPENVRML_NOTHROW;
+            void clear() OPENVRML_NOTHROW;
+
+        private:
+            void complete(const std::string & uri, pending & p)
+                OPENVRML_NOTHROW;
+            void abandon(const std::string & uri, pending & p)
+                OPENVRML_NOTHROW;
+            const boost::shared_ptr<const bytes>
+            shared_content(const boost::shared_ptr<bytes> & data,
+                           boost::uint64_t digest)
+                OPENVRML_THROW1(std::bad_alloc);
+            void release_content(const entry & e) OPENVRML_NOTHROW;
+            void evict(std::size_t budget) OPENVRML_NOTHROW;
+        };
+    }
+}
+
+# endif // ifndef OPENVRML_LOCAL_RESOURCE_CACHE_H
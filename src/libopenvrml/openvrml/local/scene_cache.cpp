@@ -0,0 +1,1046 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# include "scene_cache.h"
+# include <openvrml/local/parse_vrml.h>
+# include <boost/filesystem/operations.hpp>
+# include <fstream>
+# include <iomanip>
+# include <sstream>
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+namespace {
+
+    //
+    // 64-bit FNV-1a.
+    //
+    OPENVRML_LOCAL boost::uint64_t digest(const char * const begin,
+                                          const char * const end)
+        OPENVRML_NOTHROW
+    {
+        boost::uint64_t hash = 14695981039346656037ULL;
+        for (const char * c = begin; c != end; ++c) {
+            hash ^= static_cast<unsigned char>(*c);
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    //
+    // The header of a scene cache file.  It is followed by the URI, and then
+    // by the tape, starting on an 8-byte boundary.
+    //
+    // Values are stored in the native byte order and layout; byte_order and
+    // layout identify them, so that a file written on a different platform
+    // (or by a build with a different layout for the value types) is
+    // treated as stale rather than misread.
+    //
+    struct OPENVRML_LOCAL cache_header {
+        char magic[8];
+        boost::uint32_t version;
+        boost::uint32_t byte_order;
+        boost::uint32_t layout;
+        boost::uint32_t x3d;
+        boost::uint64_t source_size;
+        boost::uint64_t source_digest;
+        boost::uint64_t tape_size;
+        boost::uint64_t tape_digest;
+        boost::uint32_t uri_size;
+        boost::uint32_t reserved;
+    };
+
+    const char cache_magic[8] = { 'O', 'V', 'R', 'M', 'L', 'S', 'C', '\0' };
+    const boost::uint32_t cache_version = 1;
+    const boost::uint32_t cache_byte_order = 0x01020304;
+
+    OPENVRML_LOCAL boost::uint32_t cache_layout() OPENVRML_NOTHROW
+    {
+        using openvrml::color_rgba;
+        using openvrml::rotation;
+        using openvrml::vec3d;
+        using openvrml::int32;
+        return boost::uint32_t(sizeof (vec3d)) << 24
+            | boost::uint32_t(sizeof (rotation)) << 16
+            | boost::uint32_t(sizeof (color_rgba)) << 8
+            | boost::uint32_t(sizeof (int32));
+    }
+
+    OPENVRML_LOCAL std::size_t aligned(const std::size_t n,
+                                       const std::size_t alignment)
+        OPENVRML_NOTHROW
+    {
+        return (n + alignment - 1) / alignment * alignment;
+    }
+
+    //
+    // The name of the cache file for a URI.
+    //
+    OPENVRML_LOCAL const std::string cache_file_name(const std::string & uri)
+        OPENVRML_THROW1(std::bad_alloc)
+    {
+        std::ostringstream name;
+        name << std::hex << std::setw(16) << std::setfill('0')
+             << digest(uri.data(), uri.data() + uri.size()) << ".ovsc";
+        return name.str();
+    }
+
+    class OPENVRML_LOCAL corrupt_scene_cache : public std::runtime_error {
+    public:
+        corrupt_scene_cache():
+            std::runtime_error("corrupt scene cache")
+        {}
+    };
+
+    class OPENVRML_LOCAL tape_reader {
+        const char * const begin_;
+        const char * pos_;
+        const char * const end_;
+
+    public:
+        tape_reader(const char * const begin, const char * const end)
+            OPENVRML_NOTHROW:
+            begin_(begin),
+            pos_(begin),
+            end_(end)
+        {}
+
+        bool at_end() const OPENVRML_NOTHROW
+        {
+            return this->pos_ == this->end_;
+        }
+
+        const char * read(const std::size_t size)
+        {
+            if (std::size_t(this->end_ - this->pos_) < size) {
+                throw corrupt_scene_cache();
+            }
+            const char * const result = this->pos_;
+            this->pos_ += size;
+            return result;
+        }
+
+        void align(const std::size_t alignment)
+        {
+            const std::size_t offset = this->pos_ - this->begin_;
+            this->read(aligned(offset, alignment) - offset);
+        }
+
+        std::size_t read_size()
+        {
+            boost::uint32_t size;
+            this->read_pod(size);
+            return size;
+        }
+
+        //
+        // Each element of a sequence takes at least one byte; a count that
+        // exceeds the bytes remaining is corrupt.
+        //
+        std::size_t read_count()
+        {
+            const std::size_t count = this->read_size();
+            if (count > std::size_t(this->end_ - this->pos_)) {
+                throw corrupt_scene_cache();
+            }
+            return count;
+        }
+
+        template <typename T>
+        void read_pod(T & val)
+        {
+            this->align(boost::alignment_of<T>::value);
+            std::memcpy(&val, this->read(sizeof val), sizeof val);
+        }
+
+        template <typename T>
+        const T read_pod()
+        {
+            T val;
+            this->read_pod(val);
+            return val;
+        }
+
+        template <typename T>
+        void read_array(std::vector<T> & val)
+        {
+            const std::size_t size = this->read_size();
+            this->align(boost::alignment_of<T>::value);
+            if (size > std::size_t(this->end_ - this->pos_) / sizeof (T)) {
+                throw corrupt_scene_cache();
+            }
+            val.resize(size);
+            if (size > 0) {
+                std::memcpy(&val.front(),
+                            this->read(size * sizeof (T)),
+                            size * sizeof (T));
+            }
+        }
+
+        const std::string read_string()
+        {
+            const std::size_t size = this->read_size();
+            const char * const data = this->read(size);
+            return std::string(data, data + size);
+        }
+
+        const std::vector<std::string> read_strings()
+        {
+            std::vector<std::string> result(this->read_count());
+            for (std::vector<std::string>::iterator str = result.begin();
+                 str != result.end();
+                 ++str) {
+                *str = this->read_string();
+            }
+            return result;
+        }
+
+        const openvrml::node_interface read_interface()
+        {
+            using openvrml::field_value;
+            using openvrml::node_interface;
+            const node_interface::type_id type =
+                node_interface::type_id(this->read_size());
+            const field_value::type_id field_type =
+                field_value::type_id(this->read_size());
+            return node_interface(type, field_type, this->read_string());
+        }
+
+        const openvrml::image read_image()
+        {
+            const std::size_t x = this->read_size();
+            const std::size_t y = this->read_size();
+            const std::size_t comp = this->read_size();
+            std::vector<unsigned char> array;
+            this->read_array(array);
+            if (array.size() != x * y * comp) { throw corrupt_scene_cache(); }
+            return openvrml::image(x, y, comp, array);
+        }
+    };
+
+    OPENVRML_LOCAL void
+    replay_x3d_value(tape_reader & tape,
+                     const openvrml::field_value::type_id type,
+                     openvrml::local::x3d_vrml_parse_actions & actions)
+    {
+        using namespace openvrml;
+        switch (type) {
+        case field_value::sfcolorrgba_id:
+            actions.on_sfcolorrgba(tape.read_pod<color_rgba>());
+            break;
+        case field_value::sfdouble_id:
+            actions.on_sfdouble(tape.read_pod<double>());
+            break;
+        case field_value::sfvec2d_id:
+            actions.on_sfvec2d(tape.read_pod<vec2d>());
+            break;
+        case field_value::sfvec3d_id:
+            actions.on_sfvec3d(tape.read_pod<vec3d>());
+            break;
+        case field_value::mfbool_id:
+        {
+            std::vector<bool> values(tape.read_count());
+            for (std::vector<bool>::iterator b = values.begin();
+                 b != values.end();
+                 ++b) {
+                *b = *tape.read(1) != 0;
+            }
+            actions.on_mfbool(values);
+            break;
+        }
+        case field_value::mfcolorrgba_id:
+        {
+            std::vector<color_rgba> values;
+            tape.read_array(values);
+            actions.on_mfcolorrgba(values);
+            break;
+        }
+        case field_value::mfdouble_id:
+        {
+            std::vector<double> values;
+            tape.read_array(values);
+            actions.on_mfdouble(values);
+            break;
+        }
+        case field_value::mfimage_id:
+        {
+            std::vector<image> values(tape.read_count());
+            for (std::vector<image>::iterator img = values.begin();
+                 img != values.end();
+                 ++img) {
+                *img = tape.read_image();
+            }
+            actions.on_mfimage(values);
+            break;
+        }
+        case field_value::mfvec2d_id:
+        {
+            std::vector<vec2d> values;
+            tape.read_array(values);
+            actions.on_mfvec2d(values);
+            break;
+        }
+        case field_value::mfvec3d_id:
+        {
+            std::vector<vec3d> values;
+            tape.read_array(values);
+            actions.on_mfvec3d(values);
+            break;
+        }
+        default:
+            throw corrupt_scene_cache();
+        }
+    }
+}
+
+/**
+ * @internal
+ *
+ * @class openvrml::local::scene_tape openvrml/local/scene_cache.h
+ *
+ * @brief A recording of the semantic actions taken by the parser.
+ *
+ * The parser records each action it takes on a @c scene_tape, if it is given
+ * one.  Replaying the tape through a fresh set of parse actions (see
+ * @c scene_cache::replay) constructs the same scene without scanning or
+ * parsing the source: node types, field values, <code>DEF</code> names,
+ * <code>ROUTE</code>s, and <code>PROTO</code> and
+ * <code>EXTERNPROTO</code> definitions are all established by the same code
+ * that establishes them when parsing.
+ */
+
+/**
+ * @var std::vector<char> openvrml::local::scene_tape::data_
+ *
+ * @brief The recording.
+ */
+
+/**
+ * @brief The recording.
+ *
+ * @return the recording.
+ */
+const std::vector<char> & openvrml::local::scene_tape::data() const
+    OPENVRML_NOTHROW
+{
+    return this->data_;
+}
+
+void openvrml::local::scene_tape::scene_start()
+{
+    this->op(scene_start_op);
+}
+
+void openvrml::local::scene_tape::scene_finish()
+{
+    this->op(scene_finish_op);
+}
+
+void
+openvrml::local::scene_tape::
+externproto(const std::string & node_type_id,
+            const node_interface_set & interfaces,
+            const std::vector<std::string> & uri_list)
+{
+    this->op(externproto_op);
+    this->write_string(node_type_id);
+    this->write_size(interfaces.size());
+    for (node_interface_set::const_iterator interface_ = interfaces.begin();
+         interface_ != interfaces.end();
+         ++interface_) {
+        this->write_interface(*interface_);
+    }
+    this->value(field_value::mfstring_id, uri_list);
+}
+
+void openvrml::local::scene_tape::proto_start(const std::string & node_type_id)
+{
+    this->op(proto_start_op);
+    this->write_string(node_type_id);
+}
+
+void
+openvrml::local::scene_tape::proto_interface(const node_interface & interface_)
+{
+    this->op(proto_interface_op);
+    this->write_interface(interface_);
+}
+
+void openvrml::local::scene_tape::proto_default_value_start()
+{
+    this->op(proto_default_value_start_op);
+}
+
+void openvrml::local::scene_tape::proto_default_value_finish()
+{
+    this->op(proto_default_value_finish_op);
+}
+
+void openvrml::local::scene_tape::proto_body_start()
+{
+    this->op(proto_body_start_op);
+}
+
+void openvrml::local::scene_tape::proto_finish()
+{
+    this->op(proto_finish_op);
+}
+
+void openvrml::local::scene_tape::node_start(const std::string & node_name_id,
+                                             const std::string & node_type_id)
+{
+    this->op(node_start_op);
+    this->write_string(node_name_id);
+    this->write_string(node_type_id);
+}
+
+void openvrml::local::scene_tape::node_finish()
+{
+    this->op(node_finish_op);
+}
+
+void
+openvrml::local::scene_tape::
+script_interface_decl(const node_interface & interface_)
+{
+    this->op(script_interface_decl_op);
+    this->write_interface(interface_);
+}
+
+void
+openvrml::local::scene_tape::
+route(const std::string & from_node_name_id,
+      const node_interface & from_node_interface,
+      const std::string & to_node_name_id,
+      const node_interface & to_node_interface)
+{
+    this->op(route_op);
+    this->write_string(from_node_name_id);
+    this->write_interface(from_node_interface);
+    this->write_string(to_node_name_id);
+    this->write_interface(to_node_interface);
+}
+
+void openvrml::local::scene_tape::use(const std::string & node_name_id)
+{
+    this->op(use_op);
+    this->write_string(node_name_id);
+}
+
+void
+openvrml::local::scene_tape::is_mapping(const std::string & proto_interface_id)
+{
+    this->op(is_mapping_op);
+    this->write_string(proto_interface_id);
+}
+
+void
+openvrml::local::scene_tape::field_start(const std::string & field_name_id,
+                                         const field_value::type_id field_type)
+{
+    this->op(field_start_op);
+    this->write_string(field_name_id);
+    this->write_size(field_type);
+}
+
+void openvrml::local::scene_tape::sfnode(const bool null)
+{
+    this->op(sfnode_op);
+    this->write_size(null);
+}
+
+void openvrml::local::scene_tape::mfnode()
+{
+    this->op(mfnode_op);
+}
+
+void
+openvrml::local::scene_tape::profile_statement(const std::string & profile_id)
+{
+    this->op(profile_statement_op);
+    this->write_string(profile_id);
+}
+
+void
+openvrml::local::scene_tape::
+component_statement(const std::string & component_id, const int32 level)
+{
+    this->op(component_statement_op);
+    this->write_string(component_id);
+    this->write_pod(level);
+}
+
+void openvrml::local::scene_tape::meta_statement(const std::string & name,
+                                                 const std::string & value)
+{
+    this->op(meta_statement_op);
+    this->write_string(name);
+    this->write_string(value);
+}
+
+void openvrml::local::scene_tape::value(const field_value::type_id type,
+                                        const bool val)
+{
+    this->op(value_op);
+    this->write_size(type);
+    this->write_size(val);
+}
+
+void openvrml::local::scene_tape::value(const field_value::type_id type,
+                                        const std::string & val)
+{
+    this->op(value_op);
+    this->write_size(type);
+    this->write_string(val);
+}
+
+void openvrml::local::scene_tape::value(const field_value::type_id type,
+                                        const image & val)
+{
+    this->op(value_op);
+    this->write_size(type);
+    this->write_image(val);
+}
+
+void openvrml::local::scene_tape::value(const field_value::type_id type,
+                                        const std::vector<bool> & val)
+{
+    this->op(value_op);
+    this->write_size(type);
+    this->write_size(val.size());
+    for (std::vector<bool>::const_iterator b = val.begin();
+         b != val.end();
+         ++b) {
+        const char c = *b;
+        this->write(&c, 1);
+    }
+}
+
+void
+openvrml::local::scene_tape::value(const field_value::type_id type,
+                                   const std::vector<std::string> & val)
+{
+    this->op(value_op);
+    this->write_size(type);
+    this->write_size(val.size());
+    for (std::vector<std::string>::const_iterator str = val.begin();
+         str != val.end();
+         ++str) {
+        this->write_string(*str);
+    }
+}
+
+void openvrml::local::scene_tape::value(const field_value::type_id type,
+                                        const std::vector<image> & val)
+{
+    this->op(value_op);
+    this->write_size(type);
+    this->write_size(val.size());
+    for (std::vector<image>::const_iterator img = val.begin();
+         img != val.end();
+         ++img) {
+        this->write_image(*img);
+    }
+}
+
+void openvrml::local::scene_tape::op(const opcode code)
+{
+    this->write_size(code);
+}
+
+void openvrml::local::scene_tape::align(const std::size_t alignment)
+{
+    this->data_.resize(aligned(this->data_.size(), alignment));
+}
+
+void openvrml::local::scene_tape::write(const void * const data,
+                                        const std::size_t size)
+{
+    const char * const bytes = static_cast<const char *>(data);
+    this->data_.insert(this->data_.end(), bytes, bytes + size);
+}
+
+void openvrml::local::scene_tape::write_size(const std::size_t size)
+{
+    this->write_pod(boost::uint32_t(size));
+}
+
+void openvrml::local::scene_tape::write_string(const std::string & str)
+{
+    this->write_size(str.size());
+    this->write(str.data(), str.size());
+}
+
+void
+openvrml::local::scene_tape::write_interface(const node_interface & interface_)
+{
+    this->write_size(interface_.type);
+    this->write_size(interface_.field_type);
+    this->write_string(interface_.id);
+}
+
+void openvrml::local::scene_tape::write_image(const image & img)
+{
+    this->write_size(img.x());
+    this->write_size(img.y());
+    this->write_size(img.comp());
+    this->write_size(img.array().size());
+    if (!img.array().empty()) {
+        this->write(&img.array().front(), img.array().size());
+    }
+}
+
+
+/**
+ * @internal
+ *
+ * @class openvrml::local::scene_cache openvrml/local/scene_cache.h
+ *
+ * @brief A cache of parsed scenes, used to skip parsing streams that have
+ *        been parsed before.
+ *
+ * A parsed stream is cached as a @c scene_tape in a file in the directory
+ * named by the @c OPENVRML_SCENE_CACHE environment variable.  The file is
+ * named for the stream's URI, and records a digest of the stream's content;
+ * it is used only if the stream's content is unchanged.  The file is
+ * memory-mapped, and arrays of values are copied out of it wholesale.
+ */
+
+/**
+ * @var const std::size_t openvrml::local::scene_cache::min_source_size
+ *
+ * @brief Streams smaller than this are parsed quickly enough that caching
+ *        them is not worthwhile.
+ */
+
+/**
+ * @brief Whether a stream should be cached.
+ *
+ * @param[in] dir   the cache directory.
+ * @param[in] uri   the stream's URI.
+ * @param[in] begin the beginning of the stream's content.
+ * @param[in] end   the end of the stream's content.
+ *
+ * @return @c true if caching is enabled and the stream is not anonymous or
+ *         too small to bother with; @c false otherwise.
+ */
+bool openvrml::local::scene_cache::enabled(const boost::filesystem::path & dir,
+                                           const std::string & uri,
+                                           const char * const begin,
+                                           const char * const end)
+    OPENVRML_NOTHROW
+{
+    return !dir.empty()
+        && std::size_t(end - begin) >= min_source_size
+        && uri.compare(0, anonymous_stream_id_prefix.size(),
+                       anonymous_stream_id_prefix) != 0;
+}
+
+/**
+ * @brief Construct.
+ *
+ * If the cache file for @p uri exists and was recorded from the same
+ * content, it is mapped.
+ *
+ * @param[in] dir   the cache directory.
+ * @param[in] uri   the stream's URI.
+ * @param[in] x3d   whether the stream is X3D VRML.
+ * @param[in] begin the beginning of the stream's content.
+ * @param[in] end   the end of the stream's content.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+openvrml::local::scene_cache::scene_cache(const boost::filesystem::path & dir,
+                                          const std::string & uri,
+                                          const bool x3d,
+                                          const char * const begin,
+                                          const char * const end)
+    OPENVRML_THROW1(std::bad_alloc):
+    path_(dir / cache_file_name(uri)),
+    uri_(uri),
+    x3d_(x3d),
+    source_size_(end - begin),
+    source_digest_(digest(begin, end)),
+    tape_begin_(0),
+    tape_end_(0)
+{
+    this->file_.reset(new mapped_file_streambuf);
+    if (!this->file_->open(this->path_.string())) {
+        this->file_.reset();
+        return;
+    }
+
+    const char * const data = this->file_->data();
+    const std::size_t size = this->file_->size();
+
+    cache_header header;
+    if (size < sizeof header) { return; }
+    std::memcpy(&header, data, sizeof header);
+
+    const std::size_t tape_offset =
+        aligned(sizeof header + std::size_t(header.uri_size), 8);
+    if (std::memcmp(header.magic, cache_magic, sizeof cache_magic) != 0
+        || header.version != cache_version
+        || header.byte_order != cache_byte_order
+        || header.layout != cache_layout()
+        || bool(header.x3d) != x3d
+        || tape_offset > size
+        || header.tape_size != size - tape_offset
+        || uri.compare(0, std::string::npos,
+                       data + sizeof header, header.uri_size) != 0
+        || header.source_size != this->source_size_
+        || header.source_digest != this->source_digest_) {
+        return;
+    }
+
+    const char * const tape_begin = data + tape_offset;
+    const char * const tape_end = data + size;
+    if (header.tape_digest != digest(tape_begin, tape_end)) { return; }
+
+    this->tape_begin_ = tape_begin;
+    this->tape_end_ = tape_end;
+}
+
+/**
+ * @brief Whether the cache holds a tape recorded from the stream.
+ *
+ * @return @c true if the cache holds a tape recorded from the stream;
+ *         @c false otherwise.
+ */
+bool openvrml::local::scene_cache::valid() const OPENVRML_NOTHROW
+{
+    return this->tape_begin_ != 0;
+}
+
+/**
+ * @brief Construct the scene by replaying the cached tape.
+ *
+ * @param[in,out] actions   VRML97 parse actions.
+ *
+ * @exception std::runtime_error    if the tape is corrupt.
+ * @exception std::bad_alloc        if memory allocation fails.
+ */
+void
+openvrml::local::scene_cache::replay(vrml97_parse_actions & actions) const
+{
+    this->replay(actions, 0);
+}
+
+/**
+ * @brief Construct the scene by replaying the cached tape.
+ *
+ * @param[in,out] actions   X3D VRML parse actions.
+ *
+ * @exception std::runtime_error    if the tape is corrupt.
+ * @exception std::bad_alloc        if memory allocation fails.
+ */
+void
+openvrml::local::scene_cache::replay(x3d_vrml_parse_actions & actions) const
+{
+    this->replay(actions, &actions);
+}
+
+void
+openvrml::local::scene_cache::replay(vrml97_parse_actions & actions,
+                                     x3d_vrml_parse_actions * const x3d_actions)
+    const
+{
+    assert(this->valid());
+
+    tape_reader tape(this->tape_begin_, this->tape_end_);
+    while (!tape.at_end()) {
+        switch (scene_tape::opcode(tape.read_size())) {
+        case scene_tape::scene_start_op:
+            actions.on_scene_start();
+            break;
+        case scene_tape::scene_finish_op:
+            actions.on_scene_finish();
+            break;
+        case scene_tape::externproto_op:
+        {
+            const std::string node_type_id = tape.read_string();
+            node_interface_set interfaces;
+            for (std::size_t n = tape.read_count(); n > 0; --n) {
+                interfaces.insert(tape.read_interface());
+            }
+            if (tape.read_size() != scene_tape::value_op
+                || tape.read_size() != field_value::mfstring_id) {
+                throw corrupt_scene_cache();
+            }
+            actions.on_externproto(node_type_id,
+                                   interfaces,
+                                   tape.read_strings());
+            break;
+        }
+        case scene_tape::proto_start_op:
+            actions.on_proto_start(tape.read_string());
+            break;
+        case scene_tape::proto_interface_op:
+            actions.on_proto_interface(tape.read_interface());
+            break;
+        case scene_tape::proto_default_value_start_op:
+            actions.on_proto_default_value_start();
+            break;
+        case scene_tape::proto_default_value_finish_op:
+            actions.on_proto_default_value_finish();
+            break;
+        case scene_tape::proto_body_start_op:
+            actions.on_proto_body_start();
+            break;
+        case scene_tape::proto_finish_op:
+            actions.on_proto_finish();
+            break;
+        case scene_tape::node_start_op:
+        {
+            const std::string node_name_id = tape.read_string();
+            actions.on_node_start(node_name_id, tape.read_string());
+            break;
+        }
+        case scene_tape::node_finish_op:
+            actions.on_node_finish();
+            break;
+        case scene_tape::script_interface_decl_op:
+            actions.on_script_interface_decl(tape.read_interface());
+            break;
+        case scene_tape::route_op:
+        {
+            const std::string from_node_name_id = tape.read_string();
+            const node_interface from_node_interface = tape.read_interface();
+            const std::string to_node_name_id = tape.read_string();
+            actions.on_route(from_node_name_id, from_node_interface,
+                             to_node_name_id, tape.read_interface());
+            break;
+        }
+        case scene_tape::use_op:
+            actions.on_use(tape.read_string());
+            break;
+        case scene_tape::is_mapping_op:
+            actions.on_is_mapping(tape.read_string());
+            break;
+        case scene_tape::field_start_op:
+        {
+            const std::string field_name_id = tape.read_string();
+            actions.on_field_start(field_name_id,
+                                   field_value::type_id(tape.read_size()));
+            break;
+        }
+        case scene_tape::sfnode_op:
+            actions.on_sfnode(tape.read_size() != 0);
+            break;
+        case scene_tape::mfnode_op:
+            actions.on_mfnode();
+            break;
+        case scene_tape::value_op:
+        {
+            const field_value::type_id type =
+                field_value::type_id(tape.read_size());
+            switch (type) {
+            case field_value::sfbool_id:
+                actions.on_sfbool(tape.read_size() != 0);
+                break;
+            case field_value::sfcolor_id:
+                actions.on_sfcolor(tape.read_pod<color>());
+                break;
+            case field_value::sffloat_id:
+                actions.on_sffloat(tape.read_pod<float>());
+                break;
+            case field_value::sfimage_id:
+                actions.on_sfimage(tape.read_image());
+                break;
+            case field_value::sfint32_id:
+                actions.on_sfint32(tape.read_pod<int32>());
+                break;
+            case field_value::sfrotation_id:
+                actions.on_sfrotation(tape.read_pod<rotation>());
+                break;
+            case field_value::sfstring_id:
+                actions.on_sfstring(tape.read_string());
+                break;
+            case field_value::sftime_id:
+                actions.on_sftime(tape.read_pod<double>());
+                break;
+            case field_value::sfvec2f_id:
+                actions.on_sfvec2f(tape.read_pod<vec2f>());
+                break;
+            case field_value::sfvec3f_id:
+                actions.on_sfvec3f(tape.read_pod<vec3f>());
+                break;
+            case field_value::mfcolor_id:
+            {
+                std::vector<color> values;
+                tape.read_array(values);
+                actions.on_mfcolor(values);
+                break;
+            }
+            case field_value::mffloat_id:
+            {
+                std::vector<float> values;
+                tape.read_array(values);
+                actions.on_mffloat(values);
+                break;
+            }
+            case field_value::mfint32_id:
+            {
+                std::vector<int32> values;
+                tape.read_array(values);
+                actions.on_mfint32(values);
+                break;
+            }
+            case field_value::mfrotation_id:
+            {
+                std::vector<rotation> values;
+                tape.read_array(values);
+                actions.on_mfrotation(values);
+                break;
+            }
+            case field_value::mfstring_id:
+                actions.on_mfstring(tape.read_strings());
+                break;
+            case field_value::mftime_id:
+            {
+                std::vector<double> values;
+                tape.read_array(values);
+                actions.on_mftime(values);
+                break;
+            }
+            case field_value::mfvec2f_id:
+            {
+                std::vector<vec2f> values;
+                tape.read_array(values);
+                actions.on_mfvec2f(values);
+                break;
+            }
+            case field_value::mfvec3f_id:
+            {
+                std::vector<vec3f> values;
+                tape.read_array(values);
+                actions.on_mfvec3f(values);
+                break;
+            }
+            default:
+                if (!x3d_actions) { throw corrupt_scene_cache(); }
+                replay_x3d_value(tape, type, *x3d_actions);
+            }
+            break;
+        }
+        case scene_tape::profile_statement_op:
+            if (!x3d_actions) { throw corrupt_scene_cache(); }
+            x3d_actions->on_profile_statement(tape.read_string());
+            break;
+        case scene_tape::component_statement_op:
+        {
+            if (!x3d_actions) { throw corrupt_scene_cache(); }
+            const std::string component_id = tape.read_string();
+            x3d_actions->on_component_statement(component_id,
+                                                tape.read_pod<int32>());
+            break;
+        }
+        case scene_tape::meta_statement_op:
+        {
+            if (!x3d_actions) { throw corrupt_scene_cache(); }
+            const std::string name = tape.read_string();
+            x3d_actions->on_meta_statement(name, tape.read_string());
+            break;
+        }
+        default:
+            throw corrupt_scene_cache();
+        }
+    }
+}
+
+/**
+ * @brief Store a tape in the cache.
+ *
+ * The cache file is written under a temporary name and then renamed, so
+ * that a concurrent reader never sees a partially written file.  Failure to
+ * store the tape is not an error; the stream will simply be parsed again
+ * the next time it is loaded.
+ *
+ * @param[in] tape  a recording of the stream's parse.
+ */
+void openvrml::local::scene_cache::store(const scene_tape & tape)
+    OPENVRML_NOTHROW
+{
+    using boost::filesystem::path;
+
+    //
+    // Release any stale mapping of the file before replacing it.
+    //
+    this->file_.reset();
+    this->tape_begin_ = 0;
+    this->tape_end_ = 0;
+
+    try {
+        const std::vector<char> & data = tape.data();
+        const char * const tape_begin = data.empty() ? 0 : &data.front();
+        const char * const tape_end = tape_begin + data.size();
+
+        cache_header header = {};
+        std::memcpy(header.magic, cache_magic, sizeof cache_magic);
+        header.version = cache_version;
+        header.byte_order = cache_byte_order;
+        header.layout = cache_layout();
+        header.x3d = this->x3d_;
+        header.source_size = this->source_size_;
+        header.source_digest = this->source_digest_;
+        header.tape_size = data.size();
+        header.tape_digest = digest(tape_begin, tape_end);
+        header.uri_size = boost::uint32_t(this->uri_.size());
+
+        boost::filesystem::create_directories(this->path_.parent_path());
+
+        //
+        // The temporary name must be unique across processes sharing the
+        // cache directory, not just within this one.
+        //
+        const path temp_path =
+            boost::filesystem::unique_path(
+                this->path_.string() + ".%%%%-%%%%-%%%%-%%%%");
+        {
+            std::ofstream out(temp_path.string().c_str(),
+                              std::ios_base::out | std::ios_base::binary
+                              | std::ios_base::trunc);
+            out.write(reinterpret_cast<const char *>(&header), sizeof header);
+            out.write(this->uri_.data(), this->uri_.size());
+            static const char padding[8] = {};
+            out.write(padding,
+                      aligned(sizeof header + this->uri_.size(), 8)
+                      - (sizeof header + this->uri_.size()));
+            out.write(tape_begin, data.size());
+            out.close();
+            if (!out) {
+                boost::filesystem::remove(temp_path);
+                return;
+            }
+        }
+
+        try {
+            boost::filesystem::rename(temp_path, this->path_);
+        } catch (const boost::filesystem::filesystem_error &) {
+            //
+            // On some platforms, rename will not replace an existing file.
+            //
+            boost::filesystem::remove(this->path_);
+            boost::filesystem::rename(temp_path, this->path_);
+        }
+    } catch (const std::exception &) {}
+}
@@ -0,0 +1,200 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# ifndef OPENVRML_LOCAL_SCENE_CACHE_H
+#   define OPENVRML_LOCAL_SCENE_CACHE_H
+
+#   include <openvrml/local/mapped_file.h>
+#   include <openvrml/node.h>
+#   include <boost/cstdint.hpp>
+#   include <boost/filesystem/path.hpp>
+#   include <boost/scoped_ptr.hpp>
+#   include <boost/type_traits/alignment_of.hpp>
+#   include <cstring>
+
+namespace openvrml {
+
+    namespace local {
+
+        struct vrml97_parse_actions;
+        struct x3d_vrml_parse_actions;
+
+        class OPENVRML_LOCAL scene_tape : boost::noncopyable {
+            std::vector<char> data_;
+
+        public:
+            enum opcode {
+                scene_start_op = 1,
+                scene_finish_op,
+                externproto_op,
+                proto_start_op,
+                proto_interface_op,
+                proto_default_value_start_op,
+                proto_default_value_finish_op,
+                proto_body_start_op,
+                proto_finish_op,
+                node_start_op,
+                node_finish_op,
+                script_interface_decl_op,
+                route_op,
+                use_op,
+                is_mapping_op,
+                field_start_op,
+                sfnode_op,
+                mfnode_op,
+                value_op,
+                profile_statement_op,
+                component_statement_op,
+                meta_statement_op
+            };
+
+            const std::vector<char> & data() const OPENVRML_NOTHROW;
+
+            void scene_start();
+            void scene_finish();
+            void externproto(const std::string & node_type_id,
+                             const node_interface_set & interfaces,
+                             const std::vector<std::string> & uri_list);
+            void proto_start(const std::string & node_type_id);
+            void proto_interface(const node_interface & interface_);
+            void proto_default_value_start();
+            void proto_default_value_finish();
+            void proto_body_start();
+            void proto_finish();
+            void node_start(const std::string & node_name_id,
+                            const std::string & node_type_id);
+            void node_finish();
+            void script_interface_decl(const node_interface & interface_);
+            void route(const std::string & from_node_name_id,
+                       const node_interface & from_node_interface,
+                       const std::string & to_node_name_id,
+                       const node_interface & to_node_interface);
+            void use(const std::string & node_name_id);
+            void is_mapping(const std::string & proto_interface_id);
+            void field_start(const std::string & field_name_id,
+                             field_value::type_id field_type);
+            void sfnode(bool null);
+            void mfnode();
+            void profile_statement(const std::string & profile_id);
+            void component_statement(const std::string & component_id,
+                                     int32 level);
+            void meta_statement(const std::string & name,
+                                const std::string & value);
+
+            void value(field_value::type_id type, bool val);
+            void value(field_value::type_id type, const std::string & val);
+            void value(field_value::type_id type, const image & val);
+            void value(field_value::type_id type,
+                       const std::vector<bool> & val);
+            void value(field_value::type_id type,
+                       const std::vector<std::string> & val);
+            void value(field_value::type_id type,
+                       const std::vector<image> & val);
+            template <typename T>
+            void value(field_value::type_id type, const T & val);
+            template <typename T>
+            void value(field_value::type_id type, const std::vector<T> & val);
+
+        private:
+            void op(opcode code);
+            void align(std::size_t alignment);
+            void write(const void * data, std::size_t size);
+            void write_size(std::size_t size);
+            void write_string(const std::string & str);
+            void write_interface(const node_interface & interface_);
+            void write_image(const image & img);
+
+            template <typename T>
+            void write_pod(const T & val)
+            {
+                this->align(boost::alignment_of<T>::value);
+                this->write(&val, sizeof val);
+            }
+        };
+
+        //
+        // Values of fixed size (int32, float, double, and the vector, color,
+        // and rotation types) are stored as they are laid out in memory.
+        //
+        template <typename T>
+        void scene_tape::value(const field_value::type_id type, const T & val)
+        {
+            this->op(value_op);
+            this->write_size(type);
+            this->write_pod(val);
+        }
+
+        //
+        // Arrays of values of fixed size are stored contiguously, so that
+        // reading them back is a single copy.
+        //
+        template <typename T>
+        void scene_tape::value(const field_value::type_id type,
+                               const std::vector<T> & val)
+        {
+            this->op(value_op);
+            this->write_size(type);
+            this->write_size(val.size());
+            this->align(boost::alignment_of<T>::value);
+            if (!val.empty()) {
+                this->write(&val.front(), val.size() * sizeof (T));
+            }
+        }
+
+
+        class OPENVRML_LOCAL scene_cache : boost::noncopyable {
+            const boost::filesystem::path path_;
+            const std::string uri_;
+            const bool x3d_;
+            const boost::uint64_t source_size_;
+            const boost::uint64_t source_digest_;
+            boost::scoped_ptr<mapped_file_streambuf> file_;
+            const char * tape_begin_;
+            const char * tape_end_;
+
+        public:
+            static const std::size_t min_source_size = 64 * 1024;
+
+            static bool enabled(const boost::filesystem::path & dir,
+                                const std::string & uri,
+                                const char * begin,
+                                const char * end)
+                OPENVRML_NOTHROW;
+
+            scene_cache(const boost::filesystem::path & dir,
+                        const std::string & uri,
+                        bool x3d,
+                        const char * begin,
+                        const char * end)
+                OPENVRML_THROW1(std::bad_alloc);
+
+            bool valid() const OPENVRML_NOTHROW;
+            void replay(vrml97_parse_actions & actions) const;
+            void replay(x3d_vrml_parse_actions & actions) const;
+            void store(const scene_tape & tape) OPENVRML_NOTHROW;
+
+        private:
+            void replay(vrml97_parse_actions & actions,
+                        x3d_vrml_parse_actions * x3d_actions) const;
+        };
+    }
+}
+
+# endif // ifndef OPENVRML_LOCAL_SCENE_CACHE_H
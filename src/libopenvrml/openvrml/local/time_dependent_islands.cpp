@@ -0,0 +1,569 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# include "time_dependent_islands.h"
+# include <openvrml/local/event_cascade.h>
+# include <openvrml/local/field_value_types.h>
+# include <openvrml/node.h>
+# include <openvrml/script.h>
+# include <boost/bind.hpp>
+# include <boost/detail/atomic_count.hpp>
+# include <boost/mpl/for_each.hpp>
+# include <map>
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+namespace {
+
+    //
+    // Incremented whenever a route or the set of time-dependent nodes
+    // changes; time_dependent_islands::update repartitions when this differs
+    // from the value it last partitioned at.
+    //
+    boost::detail::atomic_count route_generation(0);
+
+    //
+    // Nodes whose event processing touches state that is not confined to
+    // the node itself.  An island that contains one of these is updated on
+    // the calling thread.
+    //
+    // - Script nodes run in script engines that are not reentrant, and may
+    //   use directOutput to reach nodes without a route.
+    // - PROTO instances forward events to their implementation nodes
+    //   without a route.
+    // - Bindable nodes modify the (unsynchronized) bound node stacks.
+    //
+    OPENVRML_LOCAL bool serial_only(openvrml::node & n)
+    {
+        using openvrml::node_cast;
+        using openvrml::script_node;
+        const openvrml::node_interface_set & interfaces =
+            n.type().interfaces();
+        return node_cast<script_node *>(&n)
+            || openvrml::is_proto_instance(n)
+            || openvrml::find_interface(interfaces, "set_bind")
+            != interfaces.end();
+    }
+
+    struct OPENVRML_LOCAL collect_listener_nodes {
+        collect_listener_nodes(openvrml::event_emitter & emitter,
+                               std::vector<openvrml::node *> & nodes,
+                               bool & opaque):
+            emitter_(&emitter),
+            nodes_(&nodes),
+            opaque_(&opaque)
+        {}
+
+        template <typename T>
+        void operator()(T) const
+        {
+            if (T::field_value_type_id != this->emitter_->value().type()) {
+                return;
+            }
+            typedef openvrml::field_value_emitter<T> emitter_t;
+            typedef std::set<openvrml::field_value_listener<T> *> listeners_t;
+            const listeners_t listeners =
+                dynamic_cast<emitter_t &>(*this->emitter_).listeners();
+            for (typename listeners_t::const_iterator listener =
+                     listeners.begin();
+                 listener != listeners.end();
+                 ++listener) {
+                openvrml::event_listener & l = **listener;
+                if (openvrml::node_event_listener * const node_listener =
+                    dynamic_cast<openvrml::node_event_listener *>(&l)) {
+                    this->nodes_->push_back(&node_listener->node());
+                } else {
+                    *this->opaque_ = true;
+                }
+            }
+        }
+
+    private:
+        openvrml::event_emitter * emitter_;
+        std::vector<openvrml::node *> * nodes_;
+        bool * opaque_;
+    };
+
+    //
+    // Union-find over the nodes reachable by routes from the time-dependent
+    // nodes.
+    //
+    class OPENVRML_LOCAL route_graph {
+        std::map<openvrml::node *, std::size_t> index_;
+        std::vector<std::size_t> parent_;
+        std::vector<bool> serial_;
+
+    public:
+        std::size_t island(openvrml::node & n)
+        {
+            return this->find(this->index_.find(&n)->second);
+        }
+
+        bool serial(const std::size_t island) const
+        {
+            return this->serial_[island];
+        }
+
+        void add(openvrml::node & root)
+        {
+            std::vector<openvrml::node *> pending(1, &root);
+            if (this->index_.find(&root) != this->index_.end()) { return; }
+            this->insert(root);
+
+            while (!pending.empty()) {
+                openvrml::node & n = *pending.back();
+                pending.pop_back();
+
+                const std::size_t n_index = this->index_.find(&n)->second;
+                if (serial_only(n)) { this->mark_serial(n_index); }
+
+                std::vector<openvrml::node *> targets;
+                bool opaque = false;
+                const openvrml::node_interface_set & interfaces =
+                    n.type().interfaces();
+                for (openvrml::node_interface_set::const_iterator interface_ =
+                         interfaces.begin();
+                     interface_ != interfaces.end();
+                     ++interface_) {
+                    if (interface_->type != openvrml::node_interface::eventout_id
+                        && interface_->type
+                        != openvrml::node_interface::exposedfield_id) {
+                        continue;
+                    }
+                    try {
+                        using boost::mpl::for_each;
+                        using openvrml::local::field_value_types;
+                        for_each<field_value_types>(
+                            collect_listener_nodes(
+                                n.event_emitter(interface_->id),
+                                targets,
+                                opaque));
+                    } catch (const openvrml::unsupported_interface &) {
+                        opaque = true;
+                    } catch (const std::bad_cast &) {
+                        opaque = true;
+                    }
+                }
+                if (opaque) { this->mark_serial(n_index); }
+
+                for (std::vector<openvrml::node *>::const_iterator target =
+                         targets.begin();
+                     target != targets.end();
+                     ++target) {
+                    if (this->index_.find(*target) == this->index_.end()) {
+                        this->insert(**target);
+                        pending.push_back(*target);
+                    }
+                    this->unite(n_index, this->index_.find(*target)->second);
+                }
+            }
+        }
+
+    private:
+        void insert(openvrml::node & n)
+        {
+            const std::size_t i = this->parent_.size();
+            this->parent_.push_back(i);
+            this->serial_.push_back(false);
+            this->index_.insert(std::make_pair(&n, i));
+        }
+
+        std::size_t find(std::size_t i)
+        {
+            while (this->parent_[i] != i) {
+                this->parent_[i] = this->parent_[this->parent_[i]];
+                i = this->parent_[i];
+            }
+            return i;
+        }
+
+        void mark_serial(const std::size_t i)
+        {
+            this->serial_[this->find(i)] = true;
+        }
+
+        void unite(const std::size_t a, const std::size_t b)
+        {
+            const std::size_t root_a = this->find(a), root_b = this->find(b);
+            if (root_a == root_b) { return; }
+            this->parent_[root_b] = root_a;
+            this->serial_[root_a] =
+                this->serial_[root_a] || this->serial_[root_b];
+        }
+    };
+}
+
+/**
+ * @internal
+ *
+ * @class openvrml::local::time_dependent_islands
+ *
+ * @brief Update independent groups of time-dependent nodes concurrently.
+ *
+ * The time-dependent nodes are partitioned into <em>islands</em>: sets of
+ * nodes that are connected, directly or indirectly, by routes.  Events never
+ * cross from one island to another, so islands can be updated on different
+ * threads.  Each island is updated with its own @c event_cascade, which is
+ * drained before the island is considered done; @c #update returns only once
+ * every island has been updated.  Within an island, events are delivered in
+ * the same order as when all the time-dependent nodes are updated serially.
+ *
+ * Islands that contain a node for which this does not hold (see
+ * @c serial_only) are updated on the calling thread after the concurrent
+ * islands have finished, using the calling thread's current
+ * @c event_cascade.
+ *
+ * The partition is cached and recomputed when @c #invalidate has been called
+ * since it was last computed.
+ */
+
+/**
+ * @internal
+ *
+ * @typedef openvrml::local::time_dependent_islands::island
+ *
+ * @brief An island of time-dependent nodes, in the order they appear in the
+ *        @c browser's list.
+ */
+
+/**
+ * @var std::vector<openvrml::local::time_dependent_islands::island> openvrml::local::time_dependent_islands::parallel_
+ *
+ * @brief Islands that may be updated concurrently.
+ */
+
+/**
+ * @var openvrml::local::time_dependent_islands::island openvrml::local::time_dependent_islands::serial_
+ *
+ * @brief Time-dependent nodes that must be updated on the calling thread.
+ */
+
+/**
+ * @var long openvrml::local::time_dependent_islands::generation_
+ *
+ * @brief The route generation at which @c #parallel_ and @c #serial_ were
+ *        computed; -1 if they have not been computed.
+ */
+
+/**
+ * @var boost::thread_group openvrml::local::time_dependent_islands::workers_
+ *
+ * @brief Worker threads.
+ */
+
+/**
+ * @var boost::mutex openvrml::local::time_dependent_islands::mutex_
+ *
+ * @brief Mutex guarding the frame state.
+ */
+
+/**
+ * @var boost::condition_variable openvrml::local::time_dependent_islands::work_available_
+ *
+ * @brief Signaled when a frame starts or the workers are stopped.
+ */
+
+/**
+ * @var boost::condition_variable openvrml::local::time_dependent_islands::work_done_
+ *
+ * @brief Signaled when the last busy worker finishes a frame.
+ */
+
+/**
+ * @var std::size_t openvrml::local::time_dependent_islands::frame_
+ *
+ * @brief Incremented for each frame.
+ */
+
+/**
+ * @var bool openvrml::local::time_dependent_islands::stopping_
+ *
+ * @brief Set to tell the workers to exit.
+ */
+
+/**
+ * @var double openvrml::local::time_dependent_islands::current_time_
+ *
+ * @brief The time passed to @c time_dependent_node::update for this frame.
+ */
+
+/**
+ * @var std::size_t openvrml::local::time_dependent_islands::next_island_
+ *
+ * @brief Index in @c #parallel_ of the next island to be updated.
+ */
+
+/**
+ * @var std::size_t openvrml::local::time_dependent_islands::busy_
+ *
+ * @brief The number of workers that have not finished this frame.
+ */
+
+/**
+ * @var boost::exception_ptr openvrml::local::time_dependent_islands::error_
+ *
+ * @brief The first exception thrown while updating an island this frame.
+ */
+
+/**
+ * @brief Invalidate the cached partition of every
+ *        @c time_dependent_islands.
+ *
+ * This function is called when a route is added or deleted, and when a
+ * time-dependent node is added to or removed from a @c browser.
+ */
+void openvrml::local::time_dependent_islands::invalidate() OPENVRML_NOTHROW
+{
+    ++route_generation;
+}
+
+/**
+ * @brief Construct.
+ *
+ * @param[in] threads   the number of threads to use to update islands,
+ *                      including the thread that calls @c #update.
+ *
+ * @exception std::bad_alloc                if memory allocation fails.
+ * @exception boost::thread_resource_error  if a worker thread cannot be
+ *                                          started.
+ *
+ * @pre @p threads > 0.
+ */
+openvrml::local::time_dependent_islands::
+time_dependent_islands(const std::size_t threads)
+    OPENVRML_THROW2(std::bad_alloc, boost::thread_resource_error):
+    generation_(-1),
+    frame_(0),
+    stopping_(false),
+    current_time_(0.0),
+    next_island_(0),
+    busy_(0)
+{
+    assert(threads > 0);
+    try {
+        for (std::size_t i = 1; i < threads; ++i) {
+            this->workers_.create_thread(
+                boost::bind(&time_dependent_islands::work, this));
+        }
+    } catch (...) {
+        {
+            boost::mutex::scoped_lock lock(this->mutex_);
+            this->stopping_ = true;
+        }
+        this->work_available_.notify_all();
+        this->workers_.join_all();
+        throw;
+    }
+}
+
+/**
+ * @brief Destroy.
+ *
+ * Stops and joins the worker threads.
+ */
+openvrml::local::time_dependent_islands::~time_dependent_islands()
+    OPENVRML_NOTHROW
+{
+    {
+        boost::mutex::scoped_lock lock(this->mutex_);
+        this->stopping_ = true;
+    }
+    this->work_available_.notify_all();
+    this->workers_.join_all();
+}
+
+/**
+ * @brief The number of threads used to update islands.
+ *
+ * @return the number of threads used to update islands, including the thread
+ *         that calls @c #update.
+ */
+std::size_t openvrml::local::time_dependent_islands::threads() const
+    OPENVRML_NOTHROW
+{
+    return this->workers_.size() + 1;
+}
+
+/**
+ * @brief The number of islands updated concurrently by the last call to
+ *        @c #update.
+ *
+ * @return the number of islands updated concurrently by the last call to
+ *         @c #update.
+ */
+std::size_t openvrml::local::time_dependent_islands::parallel_islands() const
+    OPENVRML_NOTHROW
+{
+    return this->parallel_.size();
+}
+
+/**
+ * @brief Update the time-dependent nodes.
+ *
+ * @param[in] timers        the @c browser's time-dependent nodes.
+ * @param[in] current_time  the current time.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ *
+ * Any exception thrown by @c time_dependent_node::update on a worker thread
+ * is rethrown on the calling thread once all islands have been updated.
+ */
+void openvrml::local::time_dependent_islands::update(
+    const std::list<time_dependent_node *> & timers,
+    const double current_time)
+{
+    const long generation = route_generation;
+    if (generation != this->generation_) {
+        this->partition(timers);
+        this->generation_ = generation;
+    }
+
+    {
+        boost::mutex::scoped_lock lock(this->mutex_);
+        this->current_time_ = current_time;
+        this->next_island_ = 0;
+        this->busy_ = this->workers_.size();
+        this->error_ = boost::exception_ptr();
+        ++this->frame_;
+    }
+    this->work_available_.notify_all();
+
+    this->update_islands();
+
+    boost::exception_ptr error;
+    {
+        boost::mutex::scoped_lock lock(this->mutex_);
+        while (this->busy_ > 0) { this->work_done_.wait(lock); }
+        error = this->error_;
+    }
+    if (error) { boost::rethrow_exception(error); }
+
+    for (island::const_iterator timer = this->serial_.begin();
+         timer != this->serial_.end();
+         ++timer) {
+        (*timer)->update(current_time);
+    }
+}
+
+/**
+ * @brief Partition the time-dependent nodes into islands.
+ *
+ * @param[in] timers    the @c browser's time-dependent nodes.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void openvrml::local::time_dependent_islands::partition(
+    const std::list<time_dependent_node *> & timers)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    route_graph graph;
+    for (std::list<time_dependent_node *>::const_iterator timer =
+             timers.begin();
+         timer != timers.end();
+         ++timer) {
+        graph.add(**timer);
+    }
+
+    std::vector<island> parallel;
+    island serial;
+    std::map<std::size_t, std::size_t> island_index;
+    for (std::list<time_dependent_node *>::const_iterator timer =
+             timers.begin();
+         timer != timers.end();
+         ++timer) {
+        const std::size_t i = graph.island(**timer);
+        if (graph.serial(i)) {
+            serial.push_back(*timer);
+            continue;
+        }
+        const std::pair<std::map<std::size_t, std::size_t>::iterator, bool>
+            result = island_index.insert(std::make_pair(i, parallel.size()));
+        if (result.second) { parallel.push_back(island()); }
+        parallel[result.first->second].push_back(*timer);
+    }
+
+    this->parallel_.swap(parallel);
+    this->serial_.swap(serial);
+}
+
+/**
+ * @brief Worker thread function.
+ */
+void openvrml::local::time_dependent_islands::work() OPENVRML_NOTHROW
+{
+    std::size_t frame = 0;
+    while (true) {
+        {
+            boost::mutex::scoped_lock lock(this->mutex_);
+            while (this->frame_ == frame && !this->stopping_) {
+                this->work_available_.wait(lock);
+            }
+            if (this->stopping_) { return; }
+            frame = this->frame_;
+        }
+
+        this->update_islands();
+
+        {
+            boost::mutex::scoped_lock lock(this->mutex_);
+            if (--this->busy_ == 0) { this->work_done_.notify_all(); }
+        }
+    }
+}
+
+/**
+ * @brief Update islands from @c #parallel_ until none are left.
+ *
+ * Each island is updated with its own @c event_cascade.
+ */
+void openvrml::local::time_dependent_islands::update_islands()
+    OPENVRML_NOTHROW
+{
+    while (true) {
+        std::size_t index;
+        double current_time;
+        {
+            boost::mutex::scoped_lock lock(this->mutex_);
+            if (this->error_
+                || this->next_island_ == this->parallel_.size()) {
+                return;
+            }
+            index = this->next_island_++;
+            current_time = this->current_time_;
+        }
+
+        try {
+            event_cascade cascade;
+            event_cascade::scope cascade_scope(cascade);
+            const island & timers = this->parallel_[index];
+            for (island::const_iterator timer = timers.begin();
+                 timer != timers.end();
+                 ++timer) {
+                (*timer)->update(current_time);
+            }
+            cascade.drain();
+        } catch (...) {
+            boost::mutex::scoped_lock lock(this->mutex_);
+            if (!this->error_) { this->error_ = boost::current_exception(); }
+        }
+    }
+}
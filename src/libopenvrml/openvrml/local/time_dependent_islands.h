@@ -0,0 +1,76 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# ifndef OPENVRML_LOCAL_TIME_DEPENDENT_ISLANDS_H
+#   define OPENVRML_LOCAL_TIME_DEPENDENT_ISLANDS_H
+
+#   include <openvrml-common.h>
+#   include <boost/exception_ptr.hpp>
+#   include <boost/thread.hpp>
+#   include <boost/utility.hpp>
+#   include <list>
+#   include <vector>
+
+namespace openvrml {
+
+    class time_dependent_node;
+
+    namespace local {
+
+        class OPENVRML_LOCAL time_dependent_islands : boost::noncopyable {
+            typedef std::vector<time_dependent_node *> island;
+
+            std::vector<island> parallel_;
+            island serial_;
+            long generation_;
+
+            boost::thread_group workers_;
+            boost::mutex mutex_;
+            boost::condition_variable work_available_, work_done_;
+            std::size_t frame_;
+            bool stopping_;
+            double current_time_;
+            std::size_t next_island_;
+            std::size_t busy_;
+            boost::exception_ptr error_;
+
+        public:
+            static void invalidate() OPENVRML_NOTHROW;
+
+            explicit time_dependent_islands(std::size_t threads)
+                OPENVRML_THROW2(std::bad_alloc, boost::thread_resource_error);
+            ~time_dependent_islands() OPENVRML_NOTHROW;
+
+            std::size_t threads() const OPENVRML_NOTHROW;
+            std::size_t parallel_islands() const OPENVRML_NOTHROW;
+
+            void update(const std::list<time_dependent_node *> & timers,
+                        double current_time);
+
+        private:
+            void partition(const std::list<time_dependent_node *> & timers)
+                OPENVRML_THROW1(std::bad_alloc);
+            void work() OPENVRML_NOTHROW;
+            void update_islands() OPENVRML_NOTHROW;
+        };
+    }
+}
+
+# endif // ifndef OPENVRML_LOCAL_TIME_DEPENDENT_ISLANDS_H
@@ -0,0 +1,1715 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# include "vrml_parser.h"
+# include "scene_cache.h"
+# include <openvrml/local/float.h>
+# include <openvrml/x3d_vrml_grammar.h>
+# include <algorithm>
+# include <functional>
+# include <sstream>
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+namespace {
+
+    typedef openvrml::local::vrml_scanner::token token;
+
+    struct OPENVRML_LOCAL field_type_entry {
+        const char * id;
+        openvrml::field_value::type_id type;
+    };
+
+    template <std::size_t N>
+    OPENVRML_LOCAL bool find_field_type(const field_type_entry (&table)[N],
+                                        const token & t,
+                                        openvrml::field_value::type_id & type)
+    {
+        for (std::size_t i = 0; i < N; ++i) {
+            if (t == table[i].id) {
+                type = table[i].type;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template <std::size_t N>
+    OPENVRML_LOCAL bool find_keyword(const char * const (&table)[N],
+                                     const token & t)
+    {
+        for (std::size_t i = 0; i < N; ++i) {
+            if (t == table[i]) { return true; }
+        }
+        return false;
+    }
+
+    const char * const vrml97_keywords[] = {
+        "DEF", "EXTERNPROTO", "FALSE", "IS", "NULL", "PROTO", "ROUTE", "TO",
+        "TRUE", "USE", "eventIn", "eventOut", "field", "exposedField"
+    };
+
+    const char * const x3d_vrml_keywords[] = {
+        "AS", "COMPONENT", "EXPORT", "IMPORT", "META", "PROFILE", "inputOnly",
+        "outputOnly", "inputOutput", "initializeOnly"
+    };
+
+    using openvrml::field_value;
+
+    const field_type_entry vrml97_field_types[] = {
+        { "MFColor",    field_value::mfcolor_id },
+        { "MFFloat",    field_value::mffloat_id },
+        { "MFInt32",    field_value::mfint32_id },
+        { "MFNode",     field_value::mfnode_id },
+        { "MFRotation", field_value::mfrotation_id },
+        { "MFString",   field_value::mfstring_id },
+        { "MFTime",     field_value::mftime_id },
+        { "MFVec2f",    field_value::mfvec2f_id },
+        { "MFVec3f",    field_value::mfvec3f_id },
+        { "SFBool",     field_value::sfbool_id },
+        { "SFColor",    field_value::sfcolor_id },
+        { "SFFloat",    field_value::sffloat_id },
+        { "SFImage",    field_value::sfimage_id },
+        { "SFInt32",    field_value::sfint32_id },
+        { "SFNode",     field_value::sfnode_id },
+        { "SFRotation", field_value::sfrotation_id },
+        { "SFString",   field_value::sfstring_id },
+        { "SFTime",     field_value::sftime_id },
+        { "SFVec2f",    field_value::sfvec2f_id },
+        { "SFVec3f",    field_value::sfvec3f_id }
+    };
+
+    const field_type_entry x3d_vrml_field_types[] = {
+        { "MFBool",      field_value::mfbool_id },
+        { "MFColorRGBA", field_value::mfcolorrgba_id },
+        { "MFDouble",    field_value::mfdouble_id },
+        { "MFImage",     field_value::mfimage_id },
+        { "MFVec2d",     field_value::mfvec2d_id },
+        { "MFVec3d",     field_value::mfvec3d_id },
+        { "SFColorRGBA", field_value::sfcolorrgba_id },
+        { "SFDouble",    field_value::sfdouble_id },
+        { "SFVec2d",     field_value::sfvec2d_id },
+        { "SFVec3d",     field_value::sfvec3d_id }
+    };
+
+    using openvrml::node_interface;
+
+    const node_interface script_node_interfaces[] = {
+        node_interface(node_interface::field_id,
+                       field_value::sfbool_id,
+                       "directOutput"),
+        node_interface(node_interface::field_id,
+                       field_value::sfbool_id,
+                       "mustEvaluate"),
+        node_interface(node_interface::exposedfield_id,
+                       field_value::mfstring_id,
+                       "url")
+    };
+
+    //
+    // The number of numbers in each element of a numeric multi-valued field;
+    // 0 for types that are not numeric.
+    //
+    template <typename T>
+    struct OPENVRML_LOCAL numeric_components {
+        static const std::size_t value = 0;
+    };
+
+# define OPENVRML_NUMERIC_COMPONENTS_(type_, n_)        \
+    template <>                                         \
+    struct OPENVRML_LOCAL numeric_components<type_> {   \
+        static const std::size_t value = n_;            \
+    }
+
+    OPENVRML_NUMERIC_COMPONENTS_(float, 1);
+    OPENVRML_NUMERIC_COMPONENTS_(double, 1);
+    OPENVRML_NUMERIC_COMPONENTS_(openvrml::int32, 1);
+    OPENVRML_NUMERIC_COMPONENTS_(openvrml::vec2f, 2);
+    OPENVRML_NUMERIC_COMPONENTS_(openvrml::vec2d, 2);
+    OPENVRML_NUMERIC_COMPONENTS_(openvrml::vec3f, 3);
+    OPENVRML_NUMERIC_COMPONENTS_(openvrml::vec3d, 3);
+    OPENVRML_NUMERIC_COMPONENTS_(openvrml::color, 3);
+    OPENVRML_NUMERIC_COMPONENTS_(openvrml::color_rgba, 4);
+    OPENVRML_NUMERIC_COMPONENTS_(openvrml::rotation, 4);
+
+# undef OPENVRML_NUMERIC_COMPONENTS_
+
+    //
+    // Inside a PROTO definition, an eventIn or eventOut (or an exposedField
+    // referred to by its eventIn or eventOut name) can only be given a value
+    // with IS.
+    //
+    OPENVRML_LOCAL bool event_interface(const node_interface & interface_,
+                                        const std::string & interface_id)
+    {
+        static const std::string eventin_prefix = "set_";
+        static const std::string eventout_suffix = "_changed";
+        return interface_.type == node_interface::eventin_id
+            || interface_.type == node_interface::eventout_id
+            || (interface_.type == node_interface::exposedfield_id
+                && ((interface_id.size() > eventin_prefix.size()
+                     && std::equal(eventin_prefix.begin(),
+                                   eventin_prefix.end(),
+                                   interface_id.begin()))
+                    || (interface_id.size() > eventout_suffix.size()
+                        && std::equal(eventout_suffix.rbegin(),
+                                      eventout_suffix.rend(),
+                                      interface_id.rbegin()))));
+    }
+}
+
+/**
+ * @internal
+ *
+ * @struct openvrml::local::vrml_parse_failure
+ *
+ * @brief Exception thrown by @c vrml97_parser when it encounters an error.
+ */
+
+/**
+ * @var openvrml::vrml_parse_error openvrml::local::vrml_parse_failure::error
+ *
+ * @brief The error.
+ */
+
+/**
+ * @var const char * openvrml::local::vrml_parse_failure::where
+ *
+ * @brief The position in the @c vrml_scanner buffer where the error was
+ *        found.
+ */
+
+/**
+ * @brief Construct.
+ *
+ * @param[in] error the error.
+ * @param[in] where the position where the error was found.
+ */
+openvrml::local::vrml_parse_failure::
+vrml_parse_failure(const vrml_parse_error error, const char * const where)
+    OPENVRML_NOTHROW:
+    error(error),
+    where(where)
+{}
+
+
+/**
+ * @internal
+ *
+ * @class openvrml::local::vrml97_parser
+ *
+ * @brief Recursive descent parser for VRML97.
+ *
+ * @c vrml97_parser accepts the same language as @c vrml97_grammar and
+ * drives the same semantic actions; but it reads tokens from a
+ * @c vrml_scanner rather than through Spirit's @c multi_pass and
+ * @c position_iterator, which is considerably faster.
+ *
+ * Parsing stops at the first error, which is thrown as a
+ * @c vrml_parse_failure.  Warnings are reported to @c browser::err.
+ */
+
+/**
+ * @var const openvrml::local::vrml97_parse_actions & openvrml::local::vrml97_parser::actions_
+ *
+ * @brief The semantic actions.
+ */
+
+/**
+ * @var openvrml::browser & openvrml::local::vrml97_parser::browser_
+ *
+ * @brief The @c browser to which warnings are reported.
+ */
+
+/**
+ * @var const std::string openvrml::local::vrml97_parser::uri_
+ *
+ * @brief The URI of the stream being parsed; used in warnings.
+ */
+
+/**
+ * @typedef openvrml::local::vrml_scanner::token openvrml::local::vrml97_parser::token
+ *
+ * @brief A token.
+ */
+
+/**
+ * @var openvrml::local::vrml_scanner & openvrml::local::vrml97_parser::scanner_
+ *
+ * @brief The scanner.
+ */
+
+/**
+ * @var openvrml::scope_stack_t openvrml::local::vrml97_parser::scope_stack_
+ *
+ * @brief The node types, <code>DEF</code>ed names, and PROTO interfaces in
+ *        scope.
+ */
+
+/**
+ * @var openvrml::local::scene_tape * const openvrml::local::vrml97_parser::tape_
+ *
+ * @brief The tape on which the semantic actions are recorded, or null.
+ */
+
+/**
+ * @brief Construct.
+ *
+ * @param[in] actions   the semantic actions.
+ * @param[in] scanner   a @c vrml_scanner.
+ * @param[in] b         the @c browser to which warnings are reported.
+ * @param[in] uri       the URI of the stream being parsed.
+ * @param[in] tape      a @c scene_tape on which to record the semantic
+ *                      actions, or null.
+ */
+openvrml::local::vrml97_parser::
+vrml97_parser(const vrml97_parse_actions & actions,
+              vrml_scanner & scanner,
+              openvrml::browser & b,
+              const std::string & uri,
+              scene_tape * const tape):
+    actions_(actions),
+    browser_(b),
+    uri_(uri),
+    scanner_(scanner),
+    tape_(tape)
+{
+    this->scope_stack_.push(parse_scope());
+}
+
+/**
+ * @brief Destroy.
+ */
+openvrml::local::vrml97_parser::~vrml97_parser() OPENVRML_NOTHROW
+{}
+
+/**
+ * @brief Parse the scanner's buffer.
+ *
+ * @exception vrml_parse_failure    if the buffer does not contain a valid
+ *                                  scene.
+ * @exception std::bad_alloc        if memory allocation fails.
+ */
+void openvrml::local::vrml97_parser::parse()
+{
+    this->parse_scene();
+}
+
+/**
+ * @brief Throw a @c vrml_parse_failure.
+ *
+ * @param[in] error the error.
+ * @param[in] where the position of the error.
+ *
+ * @exception vrml_parse_failure    always.
+ */
+void openvrml::local::vrml97_parser::fail(const vrml_parse_error error,
+                                          const char * const where) const
+{
+    throw vrml_parse_failure(error, where);
+}
+
+/**
+ * @brief Report a warning.
+ *
+ * The warning is written with @c #report_warning.
+ *
+ * @param[in] error the warning.
+ * @param[in] where the position the warning applies to.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void openvrml::local::vrml97_parser::warn(const vrml_parse_error error,
+                                          const char * const where) const
+{
+    std::size_t line, column;
+    this->scanner_.location(where, line, column);
+    std::ostringstream out;
+    out << this->uri_ << ':' << line << ':' << column << ": warning: "
+        << x3d_vrml_parse_error_msg(error);
+    this->report_warning(where, out.str());
+}
+
+/**
+ * @brief Write a warning.
+ *
+ * The default implementation writes @p message to the @c browser's error
+ * stream.
+ *
+ * @param[in] where     the position the warning applies to.
+ * @param[in] message   the warning, with its location.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void
+openvrml::local::vrml97_parser::report_warning(const char *,
+                                               const std::string & message)
+    const
+{
+    this->browser_.err(message);
+}
+
+/**
+ * @brief Read a character.
+ *
+ * @param[in] c     the character.
+ * @param[in] error the error to report if @p c is not next.
+ *
+ * @exception vrml_parse_failure    if @p c is not next.
+ */
+void openvrml::local::vrml97_parser::expect(const char c,
+                                            const vrml_parse_error error)
+{
+    const char * const where = this->scanner_.skip();
+    if (!this->scanner_.consume(c)) { this->fail(error, where); }
+}
+
+/**
+ * @brief Read a keyword if it is next.
+ *
+ * @param[in] keyword   a keyword.
+ *
+ * @return @c true if @p keyword was read; @c false otherwise.
+ */
+bool openvrml::local::vrml97_parser::next_is(const char * const keyword)
+{
+    const char * const start = this->scanner_.skip();
+    token t;
+    if (this->scanner_.id(t) && t == keyword) { return true; }
+    this->scanner_.position(start);
+    return false;
+}
+
+/**
+ * @brief Read an identifier that is not a keyword.
+ *
+ * @return the identifier.
+ *
+ * @exception vrml_parse_failure    if an identifier is not next.
+ */
+const openvrml::local::vrml_scanner::token
+openvrml::local::vrml97_parser::expect_id()
+{
+    const char * const where = this->scanner_.skip();
+    token t;
+    if (!this->scanner_.id(t) || this->keyword(t)) {
+        this->fail(id_expected, where);
+    }
+    return t;
+}
+
+/**
+ * @brief Parse a statement if one is next.
+ *
+ * @return @c true if a statement was parsed; @c false otherwise.
+ */
+bool openvrml::local::vrml97_parser::next_statement()
+{
+    const char * const start = this->scanner_.skip();
+    token t;
+    if (this->scanner_.id(t) && this->parse_statement(t, start)) {
+        return true;
+    }
+    this->scanner_.position(start);
+    return false;
+}
+
+/**
+ * @brief Parse a <code>DEF</code>ed node name in the current scope.
+ *
+ * @return the @c defs_t entry for the node name.
+ *
+ * @exception vrml_parse_failure    if a node name is not next, or if it
+ *                                  has not been <code>DEF</code>ed.
+ */
+const openvrml::defs_t::value_type *
+openvrml::local::vrml97_parser::parse_node_name_id()
+{
+    const token t = this->expect_id();
+    const defs_t & defs = this->scope_stack_.top().defs;
+    const defs_t::const_iterator pos = defs.find(t.str());
+    if (pos == defs.end()) { this->fail(unknown_node_name_id, t.begin); }
+    return &(*pos);
+}
+
+/**
+ * @brief Parse a single value.
+ *
+ * @param[out] value    the value.
+ * @param[in]  error    the error to report if a value is not next.
+ *
+ * @exception vrml_parse_failure    if a value is not next.
+ */
+template <typename T>
+void openvrml::local::vrml97_parser::parse_sf(T & value,
+                                              const vrml_parse_error error)
+{
+    const char * const where = this->scanner_.skip();
+    if (!this->parse_value(value)) { this->fail(error, where); }
+}
+
+/**
+ * @brief Parse a single value, or a bracketed list of values.
+ *
+ * Coordinate and index arrays make up most of a typical file.  For numeric
+ * types, the values in a list are counted with
+ * @c vrml_scanner::count_numbers before they are parsed so that @p values
+ * is only allocated once.
+ *
+ * @param[out] values                       the values.
+ * @param[in]  element_or_lbracket_error    the error to report if neither a
+ *                                          value nor &lsquo;[&rsquo; is
+ *                                          next.
+ * @param[in]  element_or_rbracket_error    the error to report if the list
+ *                                          is not terminated by
+ *                                          &lsquo;]&rsquo;.
+ *
+ * @exception vrml_parse_failure    if a value is not next.
+ */
+template <typename T>
+void openvrml::local::vrml97_parser::
+parse_mf(std::vector<T> & values,
+         const vrml_parse_error element_or_lbracket_error,
+         const vrml_parse_error element_or_rbracket_error)
+{
+    T value;
+    const char * const where = this->scanner_.skip();
+    if (this->parse_value(value)) {
+        values.push_back(value);
+        return;
+    }
+    if (!this->scanner_.consume('[')) {
+        this->fail(element_or_lbracket_error, where);
+    }
+    if (numeric_components<T>::value > 0) {
+        values.reserve(values.size()
+                       + this->scanner_.count_numbers()
+                         / numeric_components<T>::value);
+    }
+    while (this->parse_value(value)) { values.push_back(value); }
+    this->expect(']', element_or_rbracket_error);
+}
+
+/**
+ * @brief Read a value.
+ *
+ * @param[out] value    the value.
+ *
+ * @return @c true if a value was read; @c false otherwise.
+ */
+template <typename T>
+bool openvrml::local::vrml97_parser::parse_value(T & value)
+{
+    return this->scanner_.read(value);
+}
+
+/**
+ * @brief Read an SFRotation value.
+ *
+ * Warns if the axis is not normalized.
+ *
+ * @param[out] value    the value.
+ *
+ * @return @c true if a value was read; @c false otherwise.
+ */
+bool openvrml::local::vrml97_parser::parse_value(rotation & value)
+{
+    const char * const start = this->scanner_.skip();
+    float x, y, z, angle;
+    if (!(this->scanner_.read(x)
+          && this->scanner_.read(y)
+          && this->scanner_.read(z))) {
+        this->scanner_.position(start);
+        return false;
+    }
+    if (!fequal(float(std::sqrt(x * x + y * y + z * z)), 1.0f)) {
+        this->warn(rotation_axis_not_normalized, this->scanner_.position());
+    }
+    if (!this->scanner_.read(angle)) {
+        this->scanner_.position(start);
+        return false;
+    }
+    value.rot[0] = x;
+    value.rot[1] = y;
+    value.rot[2] = z;
+    value.rot[3] = angle;
+    return true;
+}
+
+/**
+ * @brief Read an SFImage value.
+ *
+ * Once the width has been read, the rest of the value must follow.
+ *
+ * The dimensions are not trusted to size the pixel array: it grows as the
+ * pixels are read, so a value that claims more pixels than the input holds
+ * fails without allocating for them.
+ *
+ * @param[out] value    the value.
+ *
+ * @return @c true if a value was read; @c false otherwise.
+ *
+ * @exception vrml_parse_failure    if the value is incomplete.
+ * @exception std::bad_alloc        if memory allocation fails.
+ */
+bool openvrml::local::vrml97_parser::parse_value(image & value)
+{
+    int32 x, y, comp;
+    if (!this->scanner_.read(x)) { return false; }
+    this->parse_sf(y, int32_expected);
+    this->parse_sf(comp, int32_expected);
+    const std::size_t pixels = std::size_t(x) * std::size_t(y);
+    if (x < 0 || y < 0 || comp < 0 || comp > 4
+        || (x > 0 && pixels / std::size_t(x) != std::size_t(y))) {
+        this->fail(int32_expected, this->scanner_.position());
+    }
+    std::vector<unsigned char> array;
+    for (std::size_t index = 0; index < pixels; ++index) {
+        int32 pixel;
+        this->parse_sf(pixel, int32_expected);
+        for (int32 component = comp; component > 0; --component) {
+            array.push_back(
+                static_cast<unsigned char>(pixel >> (8 * (component - 1))));
+        }
+    }
+    image result(x, y, comp, array);
+    value.swap(result);
+    return true;
+}
+
+/**
+ * @brief Record a field value on the tape, if there is one.
+ *
+ * @param[in] type  the type of the field.
+ * @param[in] value the value.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+template <typename T>
+void openvrml::local::vrml97_parser::record(const field_value::type_id type,
+                                            const T & value)
+{
+    if (this->tape_) { this->tape_->value(type, value); }
+}
+
+/**
+ * @brief Parse the scene.
+ *
+ * @exception vrml_parse_failure    if the buffer does not contain a valid
+ *                                  scene.
+ * @exception std::bad_alloc        if memory allocation fails.
+ */
+void openvrml::local::vrml97_parser::parse_scene()
+{
+    const std::auto_ptr<node_type_decls> node_types =
+        openvrml::profile("VRML97");
+    this->scope_stack_.top().node_body_repo = *node_types;
+
+    this->actions_.on_scene_start();
+    if (this->tape_) { this->tape_->scene_start(); }
+    while (this->next_statement()) {}
+    if (!this->scanner_.at_end()) {
+        this->fail(node_expected, this->scanner_.position());
+    }
+    this->actions_.on_scene_finish();
+    if (this->tape_) { this->tape_->scene_finish(); }
+}
+
+/**
+ * @brief Parse a statement.
+ *
+ * @param[in] t     the first token of the statement.
+ * @param[in] start the position of @p t.
+ *
+ * @return @c true if @p t starts a statement; @c false otherwise.
+ *
+ * @exception vrml_parse_failure    if @p t starts an invalid statement.
+ */
+bool openvrml::local::vrml97_parser::parse_statement(const token & t,
+                                                     const char * const start)
+{
+    if (t == "PROTO") {
+        this->parse_proto(start);
+        return true;
+    } else if (t == "EXTERNPROTO") {
+        this->parse_externproto(start);
+        return true;
+    } else if (t == "ROUTE") {
+        this->parse_route();
+        return true;
+    }
+    return this->parse_node_statement(t, start);
+}
+
+/**
+ * @brief Whether a token is a keyword.
+ *
+ * @param[in] t a token.
+ *
+ * @return @c true if @p t is a keyword; @c false otherwise.
+ */
+bool openvrml::local::vrml97_parser::keyword(const token & t) const
+{
+    return find_keyword(vrml97_keywords, t);
+}
+
+/**
+ * @brief Get the interface type corresponding to a token.
+ *
+ * @param[in]  t        a token.
+ * @param[out] type     the interface type.
+ * @param[in]  script   whether this is a Script node interface declaration;
+ *                      Script nodes cannot declare exposedFields.
+ *
+ * @return @c true if @p t is an interface type; @c false otherwise.
+ */
+bool
+openvrml::local::vrml97_parser::interface_type(const token & t,
+                                               node_interface::type_id & type,
+                                               const bool script) const
+{
+    if (t == "eventIn") {
+        type = node_interface::eventin_id;
+    } else if (t == "eventOut") {
+        type = node_interface::eventout_id;
+    } else if (t == "exposedField" && !script) {
+        type = node_interface::exposedfield_id;
+    } else if (t == "field") {
+        type = node_interface::field_id;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Get the field type corresponding to a token.
+ *
+ * @param[in]  t    a token.
+ * @param[out] type the field type.
+ *
+ * @return @c true if @p t is a field type; @c false otherwise.
+ */
+bool
+openvrml::local::vrml97_parser::field_type(const token & t,
+                                           field_value::type_id & type) const
+{
+    return find_field_type(vrml97_field_types, t, type);
+}
+
+/**
+ * @brief Parse a field value.
+ *
+ * @param[in] type  the type of the field.
+ *
+ * @exception vrml_parse_failure    if a value of type @p type is not next.
+ * @exception std::bad_alloc        if memory allocation fails.
+ */
+void openvrml::local::vrml97_parser::parse_field_value(
+    const field_value::type_id type)
+{
+    switch (type) {
+    case field_value::sfbool_id:
+        {
+            bool value;
+            this->parse_sf(value, bool_expected);
+            this->actions_.on_sfbool(value);
+            this->record(field_value::sfbool_id, value);
+        }
+        break;
+    case field_value::sfcolor_id:
+        {
+            color value;
+            this->parse_sf(value, color_expected);
+            this->actions_.on_sfcolor(value);
+            this->record(field_value::sfcolor_id, value);
+        }
+        break;
+    case field_value::sffloat_id:
+        {
+            float value;
+            this->parse_sf(value, float_expected);
+            this->actions_.on_sffloat(value);
+            this->record(field_value::sffloat_id, value);
+        }
+        break;
+    case field_value::sfimage_id:
+        {
+            image value;
+            this->parse_sf(value, int32_expected);
+            this->actions_.on_sfimage(value);
+            this->record(field_value::sfimage_id, value);
+        }
+        break;
+    case field_value::sfint32_id:
+        {
+            int32 value;
+            this->parse_sf(value, int32_expected);
+            this->actions_.on_sfint32(value);
+            this->record(field_value::sfint32_id, value);
+        }
+        break;
+    case field_value::sfnode_id:
+        this->parse_sfnode();
+        break;
+    case field_value::sfrotation_id:
+        {
+            rotation value;
+            this->parse_sf(value, rotation_expected);
+            this->actions_.on_sfrotation(value);
+            this->record(field_value::sfrotation_id, value);
+        }
+        break;
+    case field_value::sfstring_id:
+        {
+            std::string value;
+            this->parse_sf(value, string_expected);
+            this->actions_.on_sfstring(value);
+            this->record(field_value::sfstring_id, value);
+        }
+        break;
+    case field_value::sftime_id:
+        {
+            double value;
+            this->parse_sf(value, float_expected);
+            this->actions_.on_sftime(value);
+            this->record(field_value::sftime_id, value);
+        }
+        break;
+    case field_value::sfvec2f_id:
+        {
+            vec2f value;
+            this->parse_sf(value, vec2_expected);
+            this->actions_.on_sfvec2f(value);
+            this->record(field_value::sfvec2f_id, value);
+        }
+        break;
+    case field_value::sfvec3f_id:
+        {
+            vec3f value;
+            this->parse_sf(value, vec3_expected);
+            this->actions_.on_sfvec3f(value);
+            this->record(field_value::sfvec3f_id, value);
+        }
+        break;
+    case field_value::mfcolor_id:
+        {
+            std::vector<color> values;
+            this->parse_mf(values,
+                           color_or_lbracket_expected,
+                           color_or_rbracket_expected);
+            this->actions_.on_mfcolor(values);
+            this->record(field_value::mfcolor_id, values);
+        }
+        break;
+    case field_value::mffloat_id:
+        {
+            std::vector<float> values;
+            this->parse_mf(values,
+                           float_or_lbracket_expected,
+                           float_or_rbracket_expected);
+            this->actions_.on_mffloat(values);
+            this->record(field_value::mffloat_id, values);
+        }
+        break;
+    case field_value::mfint32_id:
+        {
+            std::vector<int32> values;
+            this->parse_mf(values,
+                           int32_or_lbracket_expected,
+                           int32_or_rbracket_expected);
+            this->actions_.on_mfint32(values);
+            this->record(field_value::mfint32_id, values);
+        }
+        break;
+    case field_value::mfnode_id:
+        this->parse_mfnode();
+        break;
+    case field_value::mfrotation_id:
+        {
+            std::vector<rotation> values;
+            this->parse_mf(values,
+                           rotation_or_lbracket_expected,
+                           rotation_or_rbracket_expected);
+            this->actions_.on_mfrotation(values);
+            this->record(field_value::mfrotation_id, values);
+        }
+        break;
+    case field_value::mfstring_id:
+        {
+            std::vector<std::string> values;
+            this->parse_mf(values,
+                           string_or_lbracket_expected,
+                           string_or_rbracket_expected);
+            this->actions_.on_mfstring(values);
+            this->record(field_value::mfstring_id, values);
+        }
+        break;
+    case field_value::mftime_id:
+        {
+            std::vector<double> values;
+            this->parse_mf(values,
+                           float_or_lbracket_expected,
+                           float_or_rbracket_expected);
+            this->actions_.on_mftime(values);
+            this->record(field_value::mftime_id, values);
+        }
+        break;
+    case field_value::mfvec2f_id:
+        {
+            std::vector<vec2f> values;
+            this->parse_mf(values,
+                           vec2_or_lbracket_expected,
+                           vec2_or_rbracket_expected);
+            this->actions_.on_mfvec2f(values);
+            this->record(field_value::mfvec2f_id, values);
+        }
+        break;
+    case field_value::mfvec3f_id:
+        {
+            std::vector<vec3f> values;
+            this->parse_mf(values,
+                           vec3_or_lbracket_expected,
+                           vec3_or_rbracket_expected);
+            this->actions_.on_mfvec3f(values);
+            this->record(field_value::mfvec3f_id, values);
+        }
+        break;
+    default:
+        assert(false);
+    }
+}
+
+/**
+ * @brief Parse a PROTO or EXTERNPROTO if one is next.
+ *
+ * @return @c true if a PROTO or EXTERNPROTO was parsed; @c false otherwise.
+ */
+bool openvrml::local::vrml97_parser::parse_proto_statement()
+{
+    const char * const start = this->scanner_.skip();
+    token t;
+    if (this->scanner_.id(t)) {
+        if (t == "PROTO") {
+            this->parse_proto(start);
+            return true;
+        } else if (t == "EXTERNPROTO") {
+            this->parse_externproto(start);
+            return true;
+        }
+    }
+    this->scanner_.position(start);
+    return false;
+}
+
+/**
+ * @brief Parse the remainder of a PROTO, following the
+ *        <code>PROTO</code> keyword.
+ *
+ * @param[in] start the position of the <code>PROTO</code> keyword.
+ */
+void openvrml::local::vrml97_parser::parse_proto(const char * const start)
+{
+    node_type_decl node_type(this->expect_id().str(), node_interface_set());
+    if (find_node_type(this->scope_stack_, node_type.first)) {
+        this->fail(node_type_already_exists, start);
+    }
+
+    parse_scope proto_scope;
+    proto_scope.proto_node_type = &node_type;
+    this->scope_stack_.push(proto_scope);
+
+    this->actions_.on_proto_start(node_type.first);
+    if (this->tape_) { this->tape_->proto_start(node_type.first); }
+
+    this->expect('[', lbracket_expected);
+    node_interface interface_;
+    while (this->parse_interface_decl(interface_)) {
+        if (!node_type.second.insert(interface_).second) {
+            this->fail(interface_collision, this->scanner_.position());
+        }
+        this->actions_.on_proto_interface(interface_);
+        if (this->tape_) { this->tape_->proto_interface(interface_); }
+
+        //
+        // Any nodes in the default value get their own scope.
+        //
+        this->scope_stack_.push(parse_scope());
+        if (interface_.type == node_interface::field_id
+            || interface_.type == node_interface::exposedfield_id) {
+            this->actions_.on_proto_default_value_start();
+            if (this->tape_) { this->tape_->proto_default_value_start(); }
+            this->parse_field_value(interface_.field_type);
+            this->actions_.on_proto_default_value_finish();
+            if (this->tape_) { this->tape_->proto_default_value_finish(); }
+        }
+        this->scope_stack_.pop();
+    }
+    this->expect(']', interface_type_or_rbracket_expected);
+
+    this->expect('{', lbrace_expected);
+    this->actions_.on_proto_body_start();
+    if (this->tape_) { this->tape_->proto_body_start(); }
+    while (this->parse_proto_statement()) {}
+    const char * const root_node_start = this->scanner_.skip();
+    token t;
+    if (!(this->scanner_.id(t)
+          && this->parse_root_node_statement(t, root_node_start))) {
+        this->fail(node_expected, root_node_start);
+    }
+    while (this->next_statement()) {}
+    this->expect('}', node_expected);
+
+    this->scope_stack_.pop();
+    this->actions_.on_proto_finish();
+    if (this->tape_) { this->tape_->proto_finish(); }
+
+    this->scope_stack_.top().node_body_repo.insert(node_type);
+}
+
+/**
+ * @brief Parse the remainder of an EXTERNPROTO, following the
+ *        <code>EXTERNPROTO</code> keyword.
+ *
+ * @param[in] start the position of the <code>EXTERNPROTO</code> keyword.
+ */
+void openvrml::local::vrml97_parser::parse_externproto(const char * const start)
+{
+    node_type_decl node_type(this->expect_id().str(), node_interface_set());
+    if (find_node_type(this->scope_stack_, node_type.first)) {
+        this->fail(node_type_already_exists, start);
+    }
+
+    this->expect('[', lbracket_expected);
+    node_interface interface_;
+    while (this->parse_interface_decl(interface_)) {
+        if (!node_type.second.insert(interface_).second) {
+            this->fail(interface_collision, this->scanner_.position());
+        }
+    }
+    this->expect(']', interface_type_or_rbracket_expected);
+
+    std::vector<std::string> uri_list;
+    this->parse_mf(uri_list,
+                   string_or_lbracket_expected,
+                   string_or_rbracket_expected);
+
+    this->actions_.on_externproto(node_type.first, node_type.second, uri_list);
+    if (this->tape_) {
+        this->tape_->externproto(node_type.first, node_type.second,
+                                 uri_list);
+    }
+
+    this->scope_stack_.top().node_body_repo.insert(node_type);
+}
+
+/**
+ * @brief Parse an interface declaration if one is next.
+ *
+ * @param[out] interface_   the interface.
+ *
+ * @return @c true if an interface declaration was parsed; @c false
+ *         otherwise.
+ */
+bool
+openvrml::local::vrml97_parser::parse_interface_decl(node_interface & interface_)
+{
+    const char * const start = this->scanner_.skip();
+    token t;
+    if (!(this->scanner_.id(t)
+          && this->interface_type(t, interface_.type, false))) {
+        this->scanner_.position(start);
+        return false;
+    }
+    this->parse_field_type_and_id(interface_);
+    return true;
+}
+
+/**
+ * @brief Parse the field type and identifier of an interface declaration.
+ *
+ * @param[in,out] interface_    the interface.
+ */
+void
+openvrml::local::vrml97_parser::
+parse_field_type_and_id(node_interface & interface_)
+{
+    const char * const where = this->scanner_.skip();
+    token t;
+    if (!(this->scanner_.id(t)
+          && this->field_type(t, interface_.field_type))) {
+        this->fail(field_type_expected, where);
+    }
+    interface_.id = this->expect_id().str();
+}
+
+/**
+ * @brief Parse the remainder of a ROUTE, following the
+ *        <code>ROUTE</code> keyword.
+ */
+void openvrml::local::vrml97_parser::parse_route()
+{
+    using std::bind2nd;
+    using std::find_if;
+
+    const defs_t::value_type * const from_node = this->parse_node_name_id();
+    this->expect('.', dot_expected);
+    const token eventout_id = this->expect_id();
+    const node_interface_set & from_interfaces = from_node->second->second;
+    const node_interface_set::const_iterator from_interface =
+        find_if(from_interfaces.begin(), from_interfaces.end(),
+                bind2nd(node_interface_matches_eventout(),
+                        eventout_id.str()));
+    if (from_interface == from_interfaces.end()) {
+        this->fail(eventout_id_expected, eventout_id.end);
+    }
+
+    if (!this->next_is("TO")) {
+        this->fail(to_expected, this->scanner_.skip());
+    }
+
+    const defs_t::value_type * const to_node = this->parse_node_name_id();
+    this->expect('.', dot_expected);
+    const token eventin_id = this->expect_id();
+    const node_interface_set & to_interfaces = to_node->second->second;
+    const node_interface_set::const_iterator to_interface =
+        find_if(to_interfaces.begin(), to_interfaces.end(),
+                bind2nd(node_interface_matches_eventin(), eventin_id.str()));
+    if (to_interface == to_interfaces.end()) {
+        this->fail(eventin_id_expected, eventin_id.end);
+    }
+
+    if (from_interface->field_type != to_interface->field_type) {
+        this->fail(event_value_type_mismatch, eventin_id.end);
+    }
+
+    this->actions_.on_route(from_node->first, *from_interface,
+                            to_node->first, *to_interface);
+    if (this->tape_) {
+        this->tape_->route(from_node->first, *from_interface,
+                           to_node->first, *to_interface);
+    }
+}
+
+/**
+ * @brief Parse a node statement: a (possibly <code>DEF</code>ed) node, or
+ *        a <code>USE</code>.
+ *
+ * @param[in] t     the first token of the statement.
+ * @param[in] start the position of @p t.
+ *
+ * @return @c true if @p t starts a node statement; @c false otherwise.
+ */
+bool
+openvrml::local::vrml97_parser::parse_node_statement(const token & t,
+                                                     const char * const start)
+{
+    if (t == "USE") {
+        const std::string & node_name_id = this->parse_node_name_id()->first;
+        this->actions_.on_use(node_name_id);
+        if (this->tape_) { this->tape_->use(node_name_id); }
+        return true;
+    }
+    return this->parse_root_node_statement(t, start);
+}
+
+/**
+ * @brief Parse a (possibly <code>DEF</code>ed) node.
+ *
+ * @param[in] t     the first token of the statement.
+ * @param[in] start the position of @p t.
+ *
+ * @return @c true if @p t starts a node; @c false otherwise.
+ */
+bool
+openvrml::local::vrml97_parser::
+parse_root_node_statement(const token & t, const char * const start)
+{
+    if (t == "DEF") {
+        const std::string node_name_id = this->expect_id().str();
+        const char * const node_type_start = this->scanner_.skip();
+        token node_type_id;
+        if (!this->scanner_.id(node_type_id) || this->keyword(node_type_id)) {
+            this->fail(node_expected, node_type_start);
+        }
+        this->parse_node(node_name_id, node_type_id);
+        return true;
+    }
+    if (this->keyword(t)) { return false; }
+    this->parse_node(std::string(), t);
+    return true;
+}
+
+/**
+ * @brief Parse the remainder of a node, following the node type
+ *        identifier.
+ *
+ * @param[in] node_name_id  the name the node is <code>DEF</code>ed with,
+ *                          or the empty string.
+ * @param[in] node_type_id  the node type identifier.
+ */
+void
+openvrml::local::vrml97_parser::parse_node(const std::string & node_name_id,
+                                           const token & node_type_id)
+{
+    node_type_decls::value_type * node_type;
+    if (node_type_id == "Script") {
+        //
+        // Each Script node has its own interfaces.
+        //
+        node_type =
+            &(*this->scope_stack_.top().script_node_types.insert(
+                  make_pair(std::string("Script"),
+                            node_interface_set(script_node_interfaces,
+                                               script_node_interfaces + 3))));
+    } else {
+        node_type = find_node_type(this->scope_stack_, node_type_id.str());
+        if (!node_type) { this->fail(unknown_node_type_id, node_type_id.begin); }
+    }
+    const bool script = node_type->first == "Script";
+
+    if (!node_name_id.empty()) {
+        this->scope_stack_.top().defs[node_name_id] = node_type;
+    }
+
+    this->expect('{', lbrace_expected);
+    this->actions_.on_node_start(node_name_id, node_type->first);
+    if (this->tape_) {
+        this->tape_->node_start(node_name_id, node_type->first);
+    }
+
+    for (;;) {
+        const char * const start = this->scanner_.skip();
+        token t;
+        if (!this->scanner_.id(t)) { break; }
+        node_interface::type_id interface_type;
+        if (script && this->interface_type(t, interface_type, true)) {
+            this->parse_script_interface(*node_type, interface_type);
+        } else if (t == "ROUTE") {
+            this->parse_route();
+        } else if (t == "PROTO") {
+            this->parse_proto(start);
+        } else if (t == "EXTERNPROTO") {
+            this->parse_externproto(start);
+        } else if (!this->keyword(t)) {
+            this->parse_field(*node_type, t);
+        } else {
+            this->scanner_.position(start);
+            break;
+        }
+    }
+
+    this->expect(
+        '}',
+        script
+        ? script_interface_or_field_or_prototype_or_route_or_rbrace_expected
+        : field_or_prototype_or_route_or_rbrace_expected);
+    this->actions_.on_node_finish();
+    if (this->tape_) { this->tape_->node_finish(); }
+}
+
+/**
+ * @brief Parse the remainder of a Script node interface declaration,
+ *        following the interface type.
+ *
+ * @param[in,out] node_type the Script node's type.
+ * @param[in]     type      the interface type.
+ */
+void
+openvrml::local::vrml97_parser::
+parse_script_interface(node_type_decls::value_type & node_type,
+                       const node_interface::type_id type)
+{
+    node_interface interface_;
+    interface_.type = type;
+    this->parse_field_type_and_id(interface_);
+    if (!node_type.second.insert(interface_).second) {
+        this->fail(interface_collision, this->scanner_.position());
+    }
+
+    this->actions_.on_script_interface_decl(interface_);
+    if (this->tape_) { this->tape_->script_interface_decl(interface_); }
+
+    if (in_proto_def(this->scope_stack_) && this->next_is("IS")) {
+        this->parse_is_mapping(interface_);
+    } else if (type == node_interface::field_id) {
+        this->parse_field_value(interface_.field_type);
+    }
+}
+
+/**
+ * @brief Parse the remainder of a field, following the interface
+ *        identifier.
+ *
+ * @param[in] node_type     the node's type.
+ * @param[in] interface_id  the interface identifier.
+ */
+void
+openvrml::local::vrml97_parser::
+parse_field(node_type_decls::value_type & node_type,
+            const token & interface_id)
+{
+    const std::string id = interface_id.str();
+    const node_interface_set::const_iterator interface_ =
+        find_interface(node_type.second, id);
+    if (interface_ == node_type.second.end()) {
+        this->fail(unknown_node_interface_id, interface_id.begin);
+    }
+
+    this->actions_.on_field_start(id, interface_->field_type);
+    if (this->tape_) {
+        this->tape_->field_start(id, interface_->field_type);
+    }
+
+    if (in_proto_def(this->scope_stack_)) {
+        if (event_interface(*interface_, id)) {
+            if (!this->next_is("IS")) {
+                this->fail(is_expected, this->scanner_.skip());
+            }
+            this->parse_is_mapping(*interface_);
+        } else if (this->next_is("IS")) {
+            this->parse_is_mapping(*interface_);
+        } else {
+            this->parse_field_value(interface_->field_type);
+        }
+    } else {
+        this->parse_field_value(interface_->field_type);
+    }
+}
+
+/**
+ * @brief Parse the remainder of an IS mapping, following the
+ *        <code>IS</code> keyword.
+ *
+ * An exposedField in the PROTO implementation can be IS'd to any type of
+ * interface; otherwise the interface types must agree.  See 4.8.3;
+ * particularly table 4.4.
+ *
+ * @param[in] impl_interface    the interface in the PROTO implementation.
+ */
+void
+openvrml::local::vrml97_parser::
+parse_is_mapping(const node_interface & impl_interface)
+{
+    const token t = this->expect_id();
+    const node_interface_set & proto_interfaces =
+        this->scope_stack_.top().proto_node_type->second;
+    const node_interface_set::const_iterator proto_interface =
+        find_interface(proto_interfaces, t.str());
+    if (proto_interface == proto_interfaces.end()
+        || proto_interface->field_type != impl_interface.field_type
+        || !(impl_interface.type == node_interface::exposedfield_id
+             || proto_interface->type == impl_interface.type)) {
+        this->fail(incompatible_proto_interface, t.end);
+    }
+    this->actions_.on_is_mapping(proto_interface->id);
+    if (this->tape_) { this->tape_->is_mapping(proto_interface->id); }
+}
+
+/**
+ * @brief Parse an SFNode value.
+ */
+void openvrml::local::vrml97_parser::parse_sfnode()
+{
+    const char * const start = this->scanner_.skip();
+    token t;
+    if (this->scanner_.id(t)) {
+        if (t == "NULL") {
+            this->actions_.on_sfnode(true);
+            if (this->tape_) { this->tape_->sfnode(true); }
+            return;
+        } else if (this->parse_node_statement(t, start)) {
+            this->actions_.on_sfnode(false);
+            if (this->tape_) { this->tape_->sfnode(false); }
+            return;
+        }
+    }
+    this->fail(node_expected, start);
+}
+
+/**
+ * @brief Parse an MFNode value.
+ */
+void openvrml::local::vrml97_parser::parse_mfnode()
+{
+    const char * start = this->scanner_.skip();
+    token t;
+    if (this->scanner_.id(t) && this->parse_node_statement(t, start)) {
+        this->actions_.on_mfnode();
+        if (this->tape_) { this->tape_->mfnode(); }
+        return;
+    }
+    this->scanner_.position(start);
+    if (!this->scanner_.consume('[')) {
+        this->fail(node_or_lbracket_expected, start);
+    }
+    for (start = this->scanner_.skip();
+         this->scanner_.id(t) && this->parse_node_statement(t, start);
+         start = this->scanner_.skip()) {}
+    this->scanner_.position(start);
+    this->expect(']', node_or_rbracket_expected);
+    this->actions_.on_mfnode();
+    if (this->tape_) { this->tape_->mfnode(); }
+}
+
+
+/**
+ * @internal
+ *
+ * @class openvrml::local::x3d_vrml_parser
+ *
+ * @brief Recursive descent parser for the Classic VRML encoding of X3D.
+ *
+ * @c x3d_vrml_parser accepts the same language as @c x3d_vrml_grammar.
+ */
+
+/**
+ * @var const openvrml::local::x3d_vrml_parse_actions & openvrml::local::x3d_vrml_parser::actions_
+ *
+ * @brief The semantic actions.
+ */
+
+/**
+ * @brief Construct.
+ *
+ * @param[in] actions   the semantic actions.
+ * @param[in] scanner   a @c vrml_scanner.
+ * @param[in] b         the @c browser to which warnings are reported.
+ * @param[in] uri       the URI of the stream being parsed.
+ * @param[in] tape      a @c scene_tape on which to record the semantic
+ *                      actions, or null.
+ */
+openvrml::local::x3d_vrml_parser::
+x3d_vrml_parser(const x3d_vrml_parse_actions & actions,
+                vrml_scanner & scanner,
+                openvrml::browser & b,
+                const std::string & uri,
+                scene_tape * const tape):
+    vrml97_parser(actions, scanner, b, uri, tape),
+    actions_(actions)
+{}
+
+/**
+ * @brief Destroy.
+ */
+openvrml::local::x3d_vrml_parser::~x3d_vrml_parser() OPENVRML_NOTHROW
+{}
+
+/**
+ * @brief Parse the scene.
+ *
+ * The PROFILE statement is required; it may be followed by COMPONENT and
+ * then META statements.
+ *
+ * @exception vrml_parse_failure    if the buffer does not contain a valid
+ *                                  scene.
+ * @exception std::bad_alloc        if memory allocation fails.
+ */
+void openvrml::local::x3d_vrml_parser::parse_scene()
+{
+    this->actions_.on_scene_start();
+    if (this->tape_) { this->tape_->scene_start(); }
+
+    if (!this->next_is("PROFILE")) {
+        this->fail(profile_expected, this->scanner_.skip());
+    }
+    const token profile_id = this->expect_id();
+    std::auto_ptr<node_type_decls> node_types;
+    try {
+        node_types = openvrml::profile(profile_id.str());
+    } catch (std::invalid_argument &) {
+        this->fail(unrecognized_profile_id, profile_id.begin);
+    }
+    this->scope_stack_.top().node_body_repo = *node_types;
+    this->actions_.on_profile_statement(profile_id.str());
+    if (this->tape_) { this->tape_->profile_statement(profile_id.str()); }
+
+    while (this->next_is("COMPONENT")) {
+        const token component_id = this->expect_id();
+        this->expect(':', colon_expected);
+        int32 level;
+        this->parse_sf(level, int32_expected);
+        try {
+            openvrml::add_component(this->scope_stack_.top().node_body_repo,
+                                    component_id.str(),
+                                    level);
+        } catch (std::invalid_argument &) {
+            this->fail(unrecognized_component_id_or_level,
+                       component_id.begin);
+        }
+        this->actions_.on_component_statement(component_id.str(), level);
+        if (this->tape_) {
+            this->tape_->component_statement(component_id.str(), level);
+        }
+    }
+
+    while (this->next_is("META")) {
+        std::string name, value;
+        this->parse_sf(name, string_expected);
+        this->parse_sf(value, string_expected);
+        this->actions_.on_meta_statement(name, value);
+        if (this->tape_) { this->tape_->meta_statement(name, value); }
+    }
+
+    while (this->next_statement()) {}
+    if (!this->scanner_.at_end()) {
+        this->fail(node_expected, this->scanner_.position());
+    }
+    this->actions_.on_scene_finish();
+    if (this->tape_) { this->tape_->scene_finish(); }
+}
+
+/**
+ * @brief Parse a statement.
+ *
+ * In addition to the VRML97 statements, X3D has IMPORT and EXPORT.
+ *
+ * @param[in] t     the first token of the statement.
+ * @param[in] start the position of @p t.
+ *
+ * @return @c true if @p t starts a statement; @c false otherwise.
+ */
+bool openvrml::local::x3d_vrml_parser::parse_statement(const token & t,
+                                                       const char * const start)
+{
+    if (t == "IMPORT") {
+        this->parse_import_statement(start);
+        return true;
+    } else if (t == "EXPORT") {
+        this->parse_export_statement(start);
+        return true;
+    }
+    return this->vrml97_parser::parse_statement(t, start);
+}
+
+/**
+ * @brief Whether a token is a keyword.
+ *
+ * @param[in] t a token.
+ *
+ * @return @c true if @p t is a keyword; @c false otherwise.
+ */
+bool openvrml::local::x3d_vrml_parser::keyword(const token & t) const
+{
+    return this->vrml97_parser::keyword(t)
+        || find_keyword(x3d_vrml_keywords, t);
+}
+
+/**
+ * @brief Get the interface type corresponding to a token.
+ *
+ * The VRML97 interface type keywords are accepted with a warning.
+ *
+ * @param[in]  t        a token.
+ * @param[out] type     the interface type.
+ * @param[in]  script   whether this is a Script node interface declaration.
+ *
+ * @return @c true if @p t is an interface type; @c false otherwise.
+ */
+bool
+openvrml::local::x3d_vrml_parser::interface_type(const token & t,
+                                                 node_interface::type_id & type,
+                                                 const bool script) const
+{
+    if (t == "inputOnly") {
+        type = node_interface::eventin_id;
+    } else if (t == "outputOnly") {
+        type = node_interface::eventout_id;
+    } else if (t == "inputOutput" && !script) {
+        type = node_interface::exposedfield_id;
+    } else if (t == "initializeOnly") {
+        type = node_interface::field_id;
+    } else if (this->vrml97_parser::interface_type(t, type, script)) {
+        static const vrml_parse_error deprecated[] = {
+            eventin_deprecated,
+            eventout_deprecated,
+            exposedfield_deprecated,
+            field_deprecated
+        };
+        const std::size_t index = type - node_interface::eventin_id;
+        assert(index < sizeof deprecated / sizeof deprecated[0]);
+        this->warn(deprecated[index], t.begin);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Get the field type corresponding to a token.
+ *
+ * @param[in]  t    a token.
+ * @param[out] type the field type.
+ *
+ * @return @c true if @p t is a field type; @c false otherwise.
+ */
+bool
+openvrml::local::x3d_vrml_parser::field_type(const token & t,
+                                             field_value::type_id & type) const
+{
+    return this->vrml97_parser::field_type(t, type)
+        || find_field_type(x3d_vrml_field_types, t, type);
+}
+
+/**
+ * @brief Parse a field value.
+ *
+ * @param[in] type  the type of the field.
+ *
+ * @exception vrml_parse_failure    if a value of type @p type is not next.
+ * @exception std::bad_alloc        if memory allocation fails.
+ */
+void openvrml::local::x3d_vrml_parser::parse_field_value(
+    const field_value::type_id type)
+{
+    switch (type) {
+    case field_value::sfcolorrgba_id:
+        {
+            color_rgba value;
+            this->parse_sf(value, color_rgba_expected);
+            this->actions_.on_sfcolorrgba(value);
+            this->record(field_value::sfcolorrgba_id, value);
+        }
+        break;
+    case field_value::sfdouble_id:
+        {
+            double value;
+            this->parse_sf(value, float_expected);
+            this->actions_.on_sfdouble(value);
+            this->record(field_value::sfdouble_id, value);
+        }
+        break;
+    case field_value::sfvec2d_id:
+        {
+            vec2d value;
+            this->parse_sf(value, vec2_expected);
+            this->actions_.on_sfvec2d(value);
+            this->record(field_value::sfvec2d_id, value);
+        }
+        break;
+    case field_value::sfvec3d_id:
+        {
+            vec3d value;
+            this->parse_sf(value, vec3_expected);
+            this->actions_.on_sfvec3d(value);
+            this->record(field_value::sfvec3d_id, value);
+        }
+        break;
+    case field_value::mfbool_id:
+        {
+            std::vector<bool> values;
+            this->parse_mf(values,
+                           bool_or_lbracket_expected,
+                           bool_or_rbracket_expected);
+            this->actions_.on_mfbool(values);
+            this->record(field_value::mfbool_id, values);
+        }
+        break;
+    case field_value::mfcolorrgba_id:
+        {
+            std::vector<color_rgba> values;
+            this->parse_mf(values,
+                           color_rgba_or_lbracket_expected,
+                           color_rgba_or_rbracket_expected);
+            this->actions_.on_mfcolorrgba(values);
+            this->record(field_value::mfcolorrgba_id, values);
+        }
+        break;
+    case field_value::mfdouble_id:
+        {
+            std::vector<double> values;
+            this->parse_mf(values,
+                           float_or_lbracket_expected,
+                           float_or_rbracket_expected);
+            this->actions_.on_mfdouble(values);
+            this->record(field_value::mfdouble_id, values);
+        }
+        break;
+    case field_value::mfimage_id:
+        {
+            std::vector<image> values;
+            this->parse_mf(values,
+                           int32_or_lbracket_expected,
+                           int32_or_rbracket_expected);
+            this->actions_.on_mfimage(values);
+            this->record(field_value::mfimage_id, values);
+        }
+        break;
+    case field_value::mfvec2d_id:
+        {
+            std::vector<vec2d> values;
+            this->parse_mf(values,
+                           vec2_or_lbracket_expected,
+                           vec2_or_rbracket_expected);
+            this->actions_.on_mfvec2d(values);
+            this->record(field_value::mfvec2d_id, values);
+        }
+        break;
+    case field_value::mfvec3d_id:
+        {
+            std::vector<vec3d> values;
+            this->parse_mf(values,
+                           vec3_or_lbracket_expected,
+                           vec3_or_rbracket_expected);
+            this->actions_.on_mfvec3d(values);
+            this->record(field_value::mfvec3d_id, values);
+        }
+        break;
+    default:
+        this->vrml97_parser::parse_field_value(type);
+    }
+}
+
+/**
+ * @brief Parse the remainder of an IMPORT statement, following the
+ *        <code>IMPORT</code> keyword.
+ *
+ * @param[in] start the position of the <code>IMPORT</code> keyword.
+ */
+void openvrml::local::x3d_vrml_parser::parse_import_statement(
+    const char * const start)
+{
+    const defs_t::value_type * const inline_node = this->parse_node_name_id();
+    if (!this->scanner_.consume('.')) { this->fail(node_expected, start); }
+    const token exported_node_name_id = this->expect_id();
+    if (!this->next_is("AS")) { this->fail(node_expected, start); }
+    const token imported_node_name_id = this->expect_id();
+    this->actions_.on_import_statement(inline_node->first,
+                                       exported_node_name_id.str(),
+                                       imported_node_name_id.str());
+}
+
+/**
+ * @brief Parse the remainder of an EXPORT statement, following the
+ *        <code>EXPORT</code> keyword.
+ *
+ * @param[in] start the position of the <code>EXPORT</code> keyword.
+ */
+void openvrml::local::x3d_vrml_parser::parse_export_statement(
+    const char * const start)
+{
+    const defs_t::value_type * const node = this->parse_node_name_id();
+    if (!this->next_is("AS")) { this->fail(node_expected, start); }
+    const token exported_node_name_id = this->expect_id();
+    this->actions_.on_export_statement(node->first,
+                                       exported_node_name_id.str());
+}
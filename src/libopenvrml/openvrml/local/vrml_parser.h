@@ -0,0 +1,152 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# ifndef OPENVRML_LOCAL_VRML_PARSER_H
+#   define OPENVRML_LOCAL_VRML_PARSER_H
+
+#   include <openvrml/local/vrml_scanner.h>
+#   include <openvrml/local/parse_vrml.h>
+#   include <openvrml/vrml97_grammar.h>
+
+namespace openvrml {
+
+    namespace local {
+
+        class scene_tape;
+
+        struct OPENVRML_LOCAL vrml_parse_failure {
+            vrml_parse_error error;
+            const char * where;
+
+            vrml_parse_failure(vrml_parse_error error, const char * where)
+                OPENVRML_NOTHROW;
+        };
+
+
+        class OPENVRML_LOCAL vrml97_parser : boost::noncopyable {
+            const vrml97_parse_actions & actions_;
+            openvrml::browser & browser_;
+            const std::string uri_;
+
+        protected:
+            typedef vrml_scanner::token token;
+
+            vrml_scanner & scanner_;
+            scope_stack_t scope_stack_;
+            scene_tape * const tape_;
+
+        public:
+            vrml97_parser(const vrml97_parse_actions & actions,
+                          vrml_scanner & scanner,
+                          openvrml::browser & b,
+                          const std::string & uri,
+                          scene_tape * tape = 0);
+            virtual ~vrml97_parser() OPENVRML_NOTHROW;
+
+            void parse();
+
+        protected:
+            void fail(vrml_parse_error error, const char * where) const;
+            void warn(vrml_parse_error error, const char * where) const;
+
+            void expect(char c, vrml_parse_error error);
+            bool next_is(const char * keyword);
+            const token expect_id();
+            bool next_statement();
+            const defs_t::value_type * parse_node_name_id();
+
+            template <typename T>
+            void parse_sf(T & value, vrml_parse_error error);
+
+            template <typename T>
+            void parse_mf(std::vector<T> & values,
+                          vrml_parse_error element_or_lbracket_error,
+                          vrml_parse_error element_or_rbracket_error);
+
+            template <typename T>
+            bool parse_value(T & value);
+            bool parse_value(rotation & value);
+            bool parse_value(image & value);
+
+            template <typename T>
+            void record(field_value::type_id type, const T & value);
+
+            virtual void parse_scene();
+            virtual bool parse_statement(const token & t, const char * start);
+            virtual bool keyword(const token & t) const;
+            virtual bool interface_type(const token & t,
+                                        node_interface::type_id & type,
+                                        bool script) const;
+            virtual bool field_type(const token & t,
+                                    field_value::type_id & type) const;
+            virtual void parse_field_value(field_value::type_id type);
+            virtual void report_warning(const char * where,
+                                        const std::string & message) const;
+
+        private:
+            bool parse_proto_statement();
+            void parse_proto(const char * start);
+            void parse_externproto(const char * start);
+            bool parse_interface_decl(node_interface & interface_);
+            void parse_field_type_and_id(node_interface & interface_);
+            void parse_route();
+            bool parse_node_statement(const token & t, const char * start);
+            bool parse_root_node_statement(const token & t,
+                                           const char * start);
+            void parse_node(const std::string & node_name_id,
+                            const token & node_type_id);
+            void parse_script_interface(node_type_decls::value_type & node_type,
+                                        node_interface::type_id type);
+            void parse_field(node_type_decls::value_type & node_type,
+                             const token & interface_id);
+            void parse_is_mapping(const node_interface & impl_interface);
+            void parse_sfnode();
+            void parse_mfnode();
+        };
+
+        class OPENVRML_LOCAL x3d_vrml_parser : public vrml97_parser {
+            const x3d_vrml_parse_actions & actions_;
+
+        public:
+            x3d_vrml_parser(const x3d_vrml_parse_actions & actions,
+                            vrml_scanner & scanner,
+                            openvrml::browser & b,
+                            const std::string & uri,
+                            scene_tape * tape = 0);
+            virtual ~x3d_vrml_parser() OPENVRML_NOTHROW;
+
+        private:
+            virtual void parse_scene();
+            virtual bool parse_statement(const token & t, const char * start);
+            virtual bool keyword(const token & t) const;
+            virtual bool interface_type(const token & t,
+                                        node_interface::type_id & type,
+                                        bool script) const;
+            virtual bool field_type(const token & t,
+                                    field_value::type_id & type) const;
+            virtual void parse_field_value(field_value::type_id type);
+
+            void parse_import_statement(const char * start);
+            void parse_export_statement(const char * start);
+        };
+    }
+}
+
+# endif // ifndef OPENVRML_LOCAL_VRML_PARSER_H
@@ -0,0 +1,919 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# include "vrml_scanner.h"
+# include <boost/cstdint.hpp>
+# include <cassert>
+# include <cmath>
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+# if defined(__SSE2__) || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define OPENVRML_VRML_SCANNER_SSE2
+#   include <emmintrin.h>
+# endif
+
+namespace {
+
+    OPENVRML_LOCAL inline bool space_char(const char c)
+    {
+        switch (c) {
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\v':
+        case '\f':
+        case '\r':
+        case ',':
+            return true;
+        default:
+            return false;
+        }
+    }
+
+# ifdef OPENVRML_VRML_SCANNER_SSE2
+    //
+    // Get a mask with a bit set for each of the 16 bytes at p that is a
+    // space_char.
+    //
+    OPENVRML_LOCAL inline unsigned space_mask(const char * const p)
+    {
+        const __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const __m128i space =
+            _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')),
+                             _mm_cmpeq_epi8(chunk, _mm_set1_epi8(','))),
+                _mm_or_si128(
+                    _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')),
+                    _mm_or_si128(
+                        _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')),
+                        _mm_or_si128(
+                            _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t')),
+                            _mm_or_si128(
+                                _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\v')),
+                                _mm_cmpeq_epi8(chunk,
+                                               _mm_set1_epi8('\f')))))));
+        return unsigned(_mm_movemask_epi8(space));
+    }
+
+    //
+    // Get a mask with a bit set for each of the 16 bytes at p that ends a
+    // run of numbers: ']' or the start of a comment.
+    //
+    OPENVRML_LOCAL inline unsigned stop_mask(const char * const p)
+    {
+        const __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        return unsigned(_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(']')),
+                         _mm_cmpeq_epi8(chunk, _mm_set1_epi8('#')))));
+    }
+
+    OPENVRML_LOCAL inline std::size_t count_bits(unsigned mask)
+    {
+        std::size_t n = 0;
+        for (; mask; mask &= mask - 1) { ++n; }
+        return n;
+    }
+
+    OPENVRML_LOCAL inline std::size_t lowest_bit(const unsigned mask)
+    {
+        assert(mask);
+#   ifdef __GNUC__
+        return std::size_t(__builtin_ctz(mask));
+#   else
+        std::size_t n = 0;
+        while (!(mask & (1U << n))) { ++n; }
+        return n;
+#   endif
+    }
+# endif
+
+    //
+    // Skip space_chars.  Runs of whitespace (typically indentation) are
+    // skipped 16 bytes at a time where SSE2 is available.
+    //
+    OPENVRML_LOCAL inline const char * skip_space(const char * p,
+                                                  const char * const end)
+    {
+        if (p == end || !space_char(*p)) { return p; }
+        ++p;
+# ifdef OPENVRML_VRML_SCANNER_SSE2
+        while (end - p >= 16) {
+            const unsigned mask = space_mask(p);
+            if (mask != 0xffff) { return p + lowest_bit(~mask); }
+            p += 16;
+        }
+# endif
+        while (p != end && space_char(*p)) { ++p; }
+        return p;
+    }
+
+    OPENVRML_LOCAL inline bool digit(const char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    OPENVRML_LOCAL inline int hex_digit_value(const char c)
+    {
+        return (c >= '0' && c <= '9') ? c - '0'
+            :  (c >= 'a' && c <= 'f') ? c - 'a' + 10
+            :  (c >= 'A' && c <= 'F') ? c - 'A' + 10
+            :  -1;
+    }
+
+    //
+    // These correspond to the invalid_id_rest_char and invalid_id_first_char
+    // character sets in vrml97_grammar and x3d_vrml_grammar.
+    //
+    OPENVRML_LOCAL inline bool id_rest_char(const char c, const bool x3d)
+    {
+        const unsigned char uc = static_cast<unsigned char>(c);
+        switch (uc) {
+        case '"':
+        case '#':
+        case '\'':
+        case ',':
+        case '.':
+        case '[':
+        case '\\':
+        case ']':
+        case '{':
+        case '}':
+        case 0x7f:
+            return false;
+        case ':':
+            return !x3d;
+        default:
+            return uc > 0x20;
+        }
+    }
+
+    OPENVRML_LOCAL inline bool id_first_char(const char c, const bool x3d)
+    {
+        return id_rest_char(c, x3d) && !digit(c) && c != '+' && c != '-';
+    }
+
+    const double exact_powers_of_10[] = {
+        1.0e0,  1.0e1,  1.0e2,  1.0e3,  1.0e4,  1.0e5,  1.0e6,  1.0e7,
+        1.0e8,  1.0e9,  1.0e10, 1.0e11, 1.0e12, 1.0e13, 1.0e14, 1.0e15,
+        1.0e16, 1.0e17, 1.0e18, 1.0e19, 1.0e20, 1.0e21, 1.0e22
+    };
+
+    //
+    // Parse a real number in the format accepted by Spirit's real_parser:
+    // an optional sign, digits with an optional decimal point (at least one
+    // digit must be present on one side of it), and an optional exponent.
+    //
+    // Returns the end of the number; or first, if there isn't one.
+    //
+    OPENVRML_LOCAL const char * parse_real(const char * const first,
+                                           const char * const last,
+                                           double & value)
+    {
+        using boost::uint64_t;
+
+        //
+        // Digits past what fits in the mantissa only affect the exponent.
+        //
+        static const uint64_t max_mantissa = 1000000000000000000ULL;
+        static const uint64_t max_exact_mantissa = 1ULL << 53;
+        static const int max_exponent = 100000;
+
+        const char * p = first;
+        bool negative = false;
+        if (p != last && (*p == '+' || *p == '-')) {
+            negative = (*p == '-');
+            ++p;
+        }
+
+        uint64_t mantissa = 0;
+        int exponent = 0;
+        bool digits = false;
+        for (; p != last && digit(*p); ++p) {
+            digits = true;
+            if (mantissa < max_mantissa) {
+                mantissa = mantissa * 10 + (*p - '0');
+            } else {
+                ++exponent;
+            }
+        }
+
+        if (p != last && *p == '.') {
+            const char * q = p + 1;
+            bool fraction_digits = false;
+            for (; q != last && digit(*q); ++q) {
+                fraction_digits = true;
+                if (mantissa < max_mantissa) {
+                    mantissa = mantissa * 10 + (*q - '0');
+                    --exponent;
+                }
+            }
+            if (digits || fraction_digits) {
+                digits = true;
+                p = q;
+            }
+        }
+
+        if (!digits) { return first; }
+
+        if (p != last && (*p == 'e' || *p == 'E')) {
+            const char * q = p + 1;
+            bool negative_exponent = false;
+            if (q != last && (*q == '+' || *q == '-')) {
+                negative_exponent = (*q == '-');
+                ++q;
+            }
+            if (q != last && digit(*q)) {
+                int e = 0;
+                for (; q != last && digit(*q); ++q) {
+                    if (e < max_exponent) { e = e * 10 + (*q - '0'); }
+                }
+                exponent += negative_exponent ? -e : e;
+                p = q;
+            }
+        }
+
+        double result;
+        if (mantissa == 0) {
+            result = 0.0;
+        } else if (mantissa <= max_exact_mantissa
+                   && exponent >= -22 && exponent <= 22) {
+            //
+            // Both the mantissa and the power of 10 are exactly
+            // representable, so a single multiplication or division is
+            // correctly rounded.
+            //
+            result = (exponent < 0)
+                ? double(mantissa) / exact_powers_of_10[-exponent]
+                : double(mantissa) * exact_powers_of_10[exponent];
+        } else {
+            result = double(static_cast<long double>(mantissa)
+                            * std::pow(10.0L, exponent));
+        }
+        value = negative ? -result : result;
+        return p;
+    }
+
+    //
+    // Parse an int32 in the format accepted by int32_parser: a hexadecimal
+    // number with a leading "0x" or "0X", or a decimal number with an
+    // optional sign.  Hexadecimal numbers up to 0xFFFFFFFF are accepted
+    // (and wrap to negative values), since they are commonly used for
+    // SFImage pixels.
+    //
+    // Returns the end of the number; or first, if there isn't one.
+    //
+    OPENVRML_LOCAL const char * parse_int32(const char * const first,
+                                            const char * const last,
+                                            openvrml::int32 & value)
+    {
+        using boost::int64_t;
+        using boost::uint32_t;
+        using boost::uint64_t;
+
+        const char * p = first;
+        if (last - p > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')
+            && hex_digit_value(p[2]) >= 0) {
+            uint64_t result = 0;
+            const char * q = p + 2;
+            int d;
+            for (; q != last && (d = hex_digit_value(*q)) >= 0; ++q) {
+                result = result * 16 + d;
+                if (result > 0xffffffffULL) { break; }
+            }
+            if (result <= 0xffffffffULL) {
+                value = openvrml::int32(uint32_t(result));
+                return q;
+            }
+        }
+
+        bool negative = false;
+        if (p != last && (*p == '+' || *p == '-')) {
+            negative = (*p == '-');
+            ++p;
+        }
+        if (p == last || !digit(*p)) { return first; }
+
+        const int64_t limit = negative ? 2147483648LL : 2147483647LL;
+        int64_t result = 0;
+        for (; p != last && digit(*p); ++p) {
+            result = result * 10 + (*p - '0');
+            if (result > limit) { return first; }
+        }
+        value = openvrml::int32(negative ? -result : result);
+        return p;
+    }
+}
+
+/**
+ * @internal
+ *
+ * @class openvrml::local::vrml_scanner
+ *
+ * @brief Tokenizer for the VRML97 and Classic VRML encodings.
+ *
+ * A @c vrml_scanner reads from a contiguous, immutable buffer.
+ * Identifiers are returned as @c token%s that point into the buffer, and
+ * numeric values are converted directly from the buffer; nothing is copied
+ * except string values.
+ *
+ * Each of the reading functions first skips whitespace (including commas)
+ * and comments.  When a reading function fails, the position is left
+ * after any skipped whitespace.
+ *
+ * The line and column of a position are only computed when needed, for
+ * diagnostic messages.
+ */
+
+/**
+ * @var const char * const openvrml::local::vrml_scanner::begin_
+ *
+ * @brief The beginning of the buffer.
+ */
+
+/**
+ * @var const char * const openvrml::local::vrml_scanner::end_
+ *
+ * @brief The end of the buffer.
+ */
+
+/**
+ * @var const bool openvrml::local::vrml_scanner::x3d_
+ *
+ * @brief Whether the buffer holds Classic VRML, in which &lsquo;:&rsquo; is
+ *        not a valid identifier character.
+ */
+
+/**
+ * @var const char * openvrml::local::vrml_scanner::pos_
+ *
+ * @brief The current position.
+ */
+
+/**
+ * @var const char * openvrml::local::vrml_scanner::location_pos_
+ *
+ * @brief The position of the last @c #location computed.
+ *
+ * Diagnostics are generally issued in increasing buffer order; so
+ * @c #location starts counting from here rather than from the beginning of
+ * the buffer whenever it can.
+ */
+
+/**
+ * @var std::size_t openvrml::local::vrml_scanner::location_line_
+ *
+ * @brief The line corresponding to @c #location_pos_.
+ */
+
+/**
+ * @var std::size_t openvrml::local::vrml_scanner::location_column_
+ *
+ * @brief The column corresponding to @c #location_pos_.
+ */
+
+/**
+ * @internal
+ *
+ * @struct openvrml::local::vrml_scanner::token
+ *
+ * @brief A range of the buffer.
+ */
+
+/**
+ * @var const char * openvrml::local::vrml_scanner::token::begin
+ *
+ * @brief The beginning of the range.
+ */
+
+/**
+ * @var const char * openvrml::local::vrml_scanner::token::end
+ *
+ * @brief The end of the range.
+ */
+
+/**
+ * @fn openvrml::local::vrml_scanner::token::token()
+ *
+ * @brief Construct an empty @c token.
+ */
+
+/**
+ * @fn bool openvrml::local::vrml_scanner::token::operator==(const char * str) const
+ *
+ * @brief Compare the @c token with a null-terminated string.
+ *
+ * @param[in] str   a null-terminated string.
+ *
+ * @return @c true if the @c token is equal to @p str; @c false otherwise.
+ */
+
+/**
+ * @fn const std::string openvrml::local::vrml_scanner::token::str() const
+ *
+ * @brief Copy the @c token to a string.
+ *
+ * @return the @c token as a string.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+
+/**
+ * @brief Construct.
+ *
+ * @param[in] begin the beginning of the buffer.
+ * @param[in] end   the end of the buffer.
+ * @param[in] x3d   whether the buffer holds Classic VRML.
+ */
+openvrml::local::vrml_scanner::vrml_scanner(const char * const begin,
+                                            const char * const end,
+                                            const bool x3d)
+    OPENVRML_NOTHROW:
+    begin_(begin),
+    end_(end),
+    x3d_(x3d),
+    pos_(begin),
+    location_pos_(begin),
+    location_line_(1),
+    location_column_(1)
+{}
+
+/**
+ * @fn const char * openvrml::local::vrml_scanner::position() const
+ *
+ * @brief The current position.
+ *
+ * @return the current position.
+ */
+
+/**
+ * @fn void openvrml::local::vrml_scanner::position(const char * pos)
+ *
+ * @brief Set the current position.
+ *
+ * @param[in] pos   a position previously obtained from the @c vrml_scanner.
+ */
+
+/**
+ * @brief Skip whitespace, commas, and comments.
+ *
+ * @return the new position.
+ */
+const char * openvrml::local::vrml_scanner::skip() OPENVRML_NOTHROW
+{
+    const char * p = this->pos_;
+    for (;;) {
+        p = skip_space(p, this->end_);
+        if (p == this->end_ || *p != '#') { break; }
+        while (p != this->end_ && *p != '\n' && *p != '\r') { ++p; }
+    }
+    return this->pos_ = p;
+}
+
+/**
+ * @brief Skip whitespace, commas, and comments; and check whether the end
+ *        of the buffer has been reached.
+ *
+ * @return @c true if the end of the buffer has been reached; @c false
+ *         otherwise.
+ */
+bool openvrml::local::vrml_scanner::at_end() OPENVRML_NOTHROW
+{
+    return this->skip() == this->end_;
+}
+
+/**
+ * @brief Read a character.
+ *
+ * @param[in] c the character to read.
+ *
+ * @return @c true if the next character is @p c; @c false otherwise.
+ */
+bool openvrml::local::vrml_scanner::consume(const char c) OPENVRML_NOTHROW
+{
+    const char * const p = this->skip();
+    if (p == this->end_ || *p != c) { return false; }
+    this->pos_ = p + 1;
+    return true;
+}
+
+/**
+ * @brief Read an identifier.
+ *
+ * Keywords are identifiers as far as the @c vrml_scanner is concerned.
+ *
+ * @param[out] t    the identifier.
+ *
+ * @return @c true if an identifier was read; @c false otherwise.
+ */
+bool openvrml::local::vrml_scanner::id(token & t) OPENVRML_NOTHROW
+{
+    const char * const first = this->skip();
+    if (first == this->end_ || !id_first_char(*first, this->x3d_)) {
+        return false;
+    }
+    const char * last = first + 1;
+    while (last != this->end_ && id_rest_char(*last, this->x3d_)) { ++last; }
+    t.begin = first;
+    t.end = last;
+    this->pos_ = last;
+    return true;
+}
+
+/**
+ * @brief Count the numbers that follow the current position, up to the
+ *        next &lsquo;]&rsquo; or comment.
+ *
+ * This counts the runs of characters between whitespace and commas; it
+ * does not check that they are well-formed numbers.  It is intended to be
+ * used following the &lsquo;[&rsquo; of a numeric multi-valued field value
+ * in order to size the container for the values up front.
+ *
+ * @return the number of numbers that follow the current position.
+ */
+std::size_t openvrml::local::vrml_scanner::count_numbers() const
+    OPENVRML_NOTHROW
+{
+    const char * p = this->pos_;
+    std::size_t count = 0;
+    bool in_number = false;
+# ifdef OPENVRML_VRML_SCANNER_SSE2
+    for (; this->end_ - p >= 16; p += 16) {
+        if (stop_mask(p)) { break; }
+        const unsigned number = ~space_mask(p) & 0xffff;
+        const unsigned number_start =
+            number & ~((number << 1) | unsigned(in_number));
+        count += count_bits(number_start);
+        in_number = (number & 0x8000) != 0;
+    }
+# endif
+    for (; p != this->end_ && *p != ']' && *p != '#'; ++p) {
+        if (space_char(*p)) {
+            in_number = false;
+        } else if (!in_number) {
+            in_number = true;
+            ++count;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Skip the next chunk of top-level statements.
+ *
+ * A chunk ends with the &lsquo;}&rsquo; that closes the body of a
+ * top-level node, so it holds one or more complete top-level statements.
+ * The last chunk in the buffer may end with a statement that has no body,
+ * such as <code>USE</code> or <code>ROUTE</code>.  The chunk's content is
+ * only tokenized, not parsed.
+ *
+ * @param[out] c    the chunk.  @c chunk::complete is @c false if the
+ *                  buffer ends with unbalanced braces or brackets, in
+ *                  which case no further chunks are read.
+ *                  @c chunk::names is @c true if the chunk refers to node
+ *                  names (with <code>DEF</code>, <code>USE</code>, or
+ *                  <code>ROUTE</code>) or contains a Script node.
+ *                  @c chunk::declarations is @c true if the chunk declares
+ *                  node types or imports or exports node names.
+ *
+ * @return @c true if a chunk was read; @c false if only whitespace and
+ *         comments remain.
+ */
+bool openvrml::local::vrml_scanner::next_chunk(chunk & c) OPENVRML_NOTHROW
+{
+    c.begin = this->skip();
+    c.root_nodes = 0;
+    c.complete = true;
+    c.names = false;
+    c.declarations = false;
+    if (c.begin == this->end_) { return false; }
+
+    std::size_t depth = 0;
+    const char * p = c.begin;
+    while ((p = skip_space(p, this->end_)) != this->end_) {
+        const char ch = *p;
+        if (ch == '#') {
+            while (p != this->end_ && *p != '\n' && *p != '\r') { ++p; }
+        } else if (ch == '"') {
+            for (++p; p != this->end_ && *p != '"'; ++p) {
+                if (*p == '\\' && p + 1 != this->end_) { ++p; }
+            }
+            if (p != this->end_) { ++p; }
+        } else if (ch == '{' || ch == '[') {
+            if (ch == '{' && depth == 0) { ++c.root_nodes; }
+            ++depth;
+            ++p;
+        } else if (ch == '}' || ch == ']') {
+            if (depth == 0) { break; }
+            --depth;
+            ++p;
+            if (ch == '}' && depth == 0) {
+                c.end = this->pos_ = p;
+                return true;
+            }
+        } else if (id_first_char(ch, this->x3d_)) {
+            token t;
+            t.begin = p;
+            for (++p; p != this->end_ && id_rest_char(*p, this->x3d_); ++p) {}
+            t.end = p;
+            if (t == "DEF" || t == "ROUTE" || t == "Script") {
+                c.names = true;
+            } else if (t == "USE") {
+                c.names = true;
+                if (depth == 0) { ++c.root_nodes; }
+            } else if (t == "PROTO" || t == "EXTERNPROTO"
+                       || t == "IMPORT" || t == "EXPORT") {
+                c.declarations = true;
+            }
+        } else {
+            ++p;
+        }
+    }
+    c.complete = (depth == 0 && p == this->end_);
+    c.end = p;
+    this->pos_ = this->end_;
+    return true;
+}
+
+/**
+ * @brief Read an SFBool value.
+ *
+ * @param[out] value    the value read.
+ *
+ * @return @c true if a value was read; @c false otherwise.
+ */
+bool openvrml::local::vrml_scanner::read(bool & value) OPENVRML_NOTHROW
+{
+    const char * const p = this->skip();
+    const std::size_t remaining = this->end_ - p;
+    if (remaining >= 4 && std::strncmp(p, "TRUE", 4) == 0) {
+        value = true;
+        this->pos_ = p + 4;
+        return true;
+    }
+    if (remaining >= 5 && std::strncmp(p, "FALSE", 5) == 0) {
+        value = false;
+        this->pos_ = p + 5;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Read an SFInt32 value.
+ *
+ * @param[out] value    the value read.
+ *
+ * @return @c true if a value was read; @c false otherwise.
+ */
+bool openvrml::local::vrml_scanner::read(int32 & value) OPENVRML_NOTHROW
+{
+    const char * const first = this->skip();
+    const char * const last = parse_int32(first, this->end_, value);
+    this->pos_ = last;
+    return last != first;
+}
+
+/**
+ * @brief Read a single-precision floating point value.
+ *
+ * @param[out] value    the value read.
+ *
+ * @return @c true if a value was read; @c false otherwise.
+ */
+bool openvrml::local::vrml_scanner::read(float & value) OPENVRML_NOTHROW
+{
+    double d;
+    if (!this->read(d)) { return false; }
+    value = float(d);
+    return true;
+}
+
+/**
+ * @brief Read a double-precision floating point value.
+ *
+ * @param[out] value    the value read.
+ *
+ * @return @c true if a value was read; @c false otherwise.
+ */
+bool openvrml::local::vrml_scanner::read(double & value) OPENVRML_NOTHROW
+{
+    const char * const first = this->skip();
+    const char * const last = parse_real(first, this->end_, value);
+    this->pos_ = last;
+    return last != first;
+}
+
+/**
+ * @brief Read an SFString value.
+ *
+ * As with @c string_parser, the value is the text between the quotes;
+ * escape sequences are left as they are.
+ *
+ * @param[out] value    the value read.
+ *
+ * @return @c true if a value was read; @c false otherwise.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+bool openvrml::local::vrml_scanner::read(std::string & value)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    const char * const first = this->skip();
+    if (first == this->end_ || *first != '"') { return false; }
+    const char * last = first + 1;
+    for (; last != this->end_; ++last) {
+        if (*last == '"') { break; }
+        if (*last == '\\' && last + 1 != this->end_ && last[1] == '"') {
+            ++last;
+        }
+    }
+    if (last == this->end_) { return false; }
+    value.assign(first + 1, last);
+    this->pos_ = last + 1;
+    return true;
+}
+
+/**
+ * @brief Read a floating point value in the range [0, 1].
+ *
+ * @param[out] value    the value read.
+ *
+ * @return @c true if a value was read; @c false otherwise.
+ */
+template <typename Float>
+bool openvrml::local::vrml_scanner::read_intensity(Float & value)
+    OPENVRML_NOTHROW
+{
+    return this->read(value) && value >= 0.0 && value <= 1.0;
+}
+
+/**
+ * @brief Read an SFColor value.
+ *
+ * @param[out] value    the value read.
+ *
+ * @return @c true if a value was read; @c false otherwise.
+ */
+bool openvrml::local::vrml_scanner::read(color & value) OPENVRML_NOTHROW
+{
+    const char * const start = this->skip();
+    if (this->read_intensity(value.rgb[0])
+        && this->read_intensity(value.rgb[1])
+        && this->read_intensity(value.rgb[2])) {
+        return true;
+    }
+    this->pos_ = start;
+    return false;
+}
+
+/**
+ * @brief Read an SFColorRGBA value.
+ *
+ * @param[out] value    the value read.
+ *
+ * @return @c true if a value was read; @c false otherwise.
+ */
+bool openvrml::local::vrml_scanner::read(color_rgba & value) OPENVRML_NOTHROW
+{
+    const char * const start = this->skip();
+    if (this->read_intensity(value.rgba[0])
+        && this->read_intensity(value.rgba[1])
+        && this->read_intensity(value.rgba[2])
+        && this->read_intensity(value.rgba[3])) {
+        return true;
+    }
+    this->pos_ = start;
+    return false;
+}
+
+/**
+ * @brief Read an SFVec2f value.
+ *
+ * @param[out] value    the value read.
+ *
+ * @return @c true if a value was read; @c false otherwise.
+ */
+bool openvrml::local::vrml_scanner::read(vec2f & value) OPENVRML_NOTHROW
+{
+    const char * const start = this->skip();
+    if (this->read(value.vec[0]) && this->read(value.vec[1])) { return true; }
+    this->pos_ = start;
+    return false;
+}
+
+/**
+ * @brief Read an SFVec2d value.
+ *
+ * @param[out] value    the value read.
+ *
+ * @return @c true if a value was read; @c false otherwise.
+ */
+bool openvrml::local::vrml_scanner::read(vec2d & value) OPENVRML_NOTHROW
+{
+    const char * const start = this->skip();
+    if (this->read(value.vec[0]) && this->read(value.vec[1])) { return true; }
+    this->pos_ = start;
+    return false;
+}
+
+/**
+ * @brief Read an SFVec3f value.
+ *
+ * @param[out] value    the value read.
+ *
+ * @return @c true if a value was read; @c false otherwise.
+ */
+bool openvrml::local::vrml_scanner::read(vec3f & value) OPENVRML_NOTHROW
+{
+    const char * const start = this->skip();
+    if (this->read(value.vec[0])
+        && this->read(value.vec[1])
+        && this->read(value.vec[2])) {
+        return true;
+    }
+    this->pos_ = start;
+    return false;
+}
+
+/**
+ * @brief Read an SFVec3d value.
+ *
+ * @param[out] value    the value read.
+ *
+ * @return @c true if a value was read; @c false otherwise.
+ */
+bool openvrml::local::vrml_scanner::read(vec3d & value) OPENVRML_NOTHROW
+{
+    const char * const start = this->skip();
+    if (this->read(value.vec[0])
+        && this->read(value.vec[1])
+        && this->read(value.vec[2])) {
+        return true;
+    }
+    this->pos_ = start;
+    return false;
+}
+
+/**
+ * @brief Get the line and column of a position.
+ *
+ * Lines and columns are numbered from 1; tabs advance the column to the
+ * next multiple of 4, as with Spirit's @c position_iterator.
+ *
+ * @param[in] where     a position in the buffer.
+ * @param[out] line     the line of @p where.
+ * @param[out] column   the column of @p where.
+ */
+void openvrml::local::vrml_scanner::location(const char * const where,
+                                             std::size_t & line,
+                                             std::size_t & column) const
+    OPENVRML_NOTHROW
+{
+    if (where < this->location_pos_) {
+        this->location_pos_ = this->begin_;
+        this->location_line_ = 1;
+        this->location_column_ = 1;
+    }
+    for (const char * p = this->location_pos_; p != where; ++p) {
+        switch (*p) {
+        case '\n':
+            if (p != this->begin_ && p[-1] == '\r') { break; }
+            // fall through
+        case '\r':
+            ++this->location_line_;
+            this->location_column_ = 1;
+            break;
+        case '\t':
+            this->location_column_ += 4 - (this->location_column_ - 1) % 4;
+            break;
+        default:
+            ++this->location_column_;
+        }
+    }
+    this->location_pos_ = where;
+    line = this->location_line_;
+    column = this->location_column_;
+}
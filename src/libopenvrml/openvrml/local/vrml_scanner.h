@@ -0,0 +1,129 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# ifndef OPENVRML_LOCAL_VRML_SCANNER_H
+#   define OPENVRML_LOCAL_VRML_SCANNER_H
+
+#   include <openvrml/basetypes.h>
+#   include <boost/utility.hpp>
+#   include <cstring>
+#   include <string>
+
+namespace openvrml {
+
+    namespace local {
+
+        class OPENVRML_LOCAL vrml_scanner : boost::noncopyable {
+            const char * const begin_;
+            const char * const end_;
+            const bool x3d_;
+            const char * pos_;
+
+            mutable const char * location_pos_;
+            mutable std::size_t location_line_, location_column_;
+
+        public:
+            struct OPENVRML_LOCAL token {
+                const char * begin;
+                const char * end;
+
+                token() OPENVRML_NOTHROW;
+
+                bool operator==(const char * str) const OPENVRML_NOTHROW;
+                const std::string str() const OPENVRML_THROW1(std::bad_alloc);
+            };
+
+            struct OPENVRML_LOCAL chunk {
+                const char * begin;
+                const char * end;
+                std::size_t root_nodes;
+                bool complete;
+                bool names;
+                bool declarations;
+            };
+
+            vrml_scanner(const char * begin, const char * end, bool x3d)
+                OPENVRML_NOTHROW;
+
+            const char * position() const OPENVRML_NOTHROW;
+            void position(const char * pos) OPENVRML_NOTHROW;
+            const char * skip() OPENVRML_NOTHROW;
+            bool at_end() OPENVRML_NOTHROW;
+
+            bool consume(char c) OPENVRML_NOTHROW;
+            bool id(token & t) OPENVRML_NOTHROW;
+            std::size_t count_numbers() const OPENVRML_NOTHROW;
+            bool next_chunk(chunk & c) OPENVRML_NOTHROW;
+
+            bool read(bool & value) OPENVRML_NOTHROW;
+            bool read(int32 & value) OPENVRML_NOTHROW;
+            bool read(float & value) OPENVRML_NOTHROW;
+            bool read(double & value) OPENVRML_NOTHROW;
+            bool read(std::string & value) OPENVRML_THROW1(std::bad_alloc);
+            bool read(color & value) OPENVRML_NOTHROW;
+            bool read(color_rgba & value) OPENVRML_NOTHROW;
+            bool read(vec2f & value) OPENVRML_NOTHROW;
+            bool read(vec2d & value) OPENVRML_NOTHROW;
+            bool read(vec3f & value) OPENVRML_NOTHROW;
+            bool read(vec3d & value) OPENVRML_NOTHROW;
+
+            void location(const char * where,
+                          std::size_t & line,
+                          std::size_t & column) const OPENVRML_NOTHROW;
+
+        private:
+            template <typename Float>
+            bool read_intensity(Float & value) OPENVRML_NOTHROW;
+        };
+
+        inline vrml_scanner::token::token() OPENVRML_NOTHROW:
+            begin(0),
+            end(0)
+        {}
+
+        inline bool
+        vrml_scanner::token::operator==(const char * const str) const
+            OPENVRML_NOTHROW
+        {
+            const std::size_t length = this->end - this->begin;
+            return std::strncmp(this->begin, str, length) == 0
+                && str[length] == '\0';
+        }
+
+        inline const std::string vrml_scanner::token::str() const
+            OPENVRML_THROW1(std::bad_alloc)
+        {
+            return std::string(this->begin, this->end);
+        }
+
+        inline const char * vrml_scanner::position() const OPENVRML_NOTHROW
+        {
+            return this->pos_;
+        }
+
+        inline void vrml_scanner::position(const char * const pos)
+            OPENVRML_NOTHROW
+        {
+            this->pos_ = pos;
+        }
+    }
+}
+
+# endif // ifndef OPENVRML_LOCAL_VRML_SCANNER_H
@@ -0,0 +1,85 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# include "worker_scope.h"
+# include <boost/thread/tss.hpp>
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+namespace {
+
+    OPENVRML_LOCAL void no_cleanup(openvrml::local::worker_scope *)
+    {}
+
+    //
+    // The innermost worker_scope on the calling thread, if any.
+    //
+    boost::thread_specific_ptr<openvrml::local::worker_scope>
+        current_scope(&no_cleanup);
+}
+
+/**
+ * @internal
+ *
+ * @class openvrml::local::worker_scope openvrml/local/worker_scope.h
+ *
+ * @brief Marks the calling thread as one of several sharing a job.
+ *
+ * While a @c worker_scope exists, work done on the thread is not split
+ * across more threads: the job already keeps the processors busy, and
+ * starting threads from each of its threads would multiply their number.
+ */
+
+/**
+ * @var openvrml::local::worker_scope * const openvrml::local::worker_scope::enclosing_
+ *
+ * @brief The @c worker_scope that was innermost on the thread when this one
+ *        was constructed, if any.
+ */
+
+/**
+ * @brief Whether the calling thread is in a @c worker_scope.
+ *
+ * @return @c true if the calling thread is in a @c worker_scope; @c false
+ *         otherwise.
+ */
+bool openvrml::local::worker_scope::active() OPENVRML_NOTHROW
+{
+    return current_scope.get() != 0;
+}
+
+/**
+ * @brief Construct.
+ */
+openvrml::local::worker_scope::worker_scope() OPENVRML_NOTHROW:
+    enclosing_(current_scope.get())
+{
+    current_scope.reset(this);
+}
+
+/**
+ * @brief Destroy.
+ */
+openvrml::local::worker_scope::~worker_scope() OPENVRML_NOTHROW
+{
+    current_scope.reset(this->enclosing_);
+}
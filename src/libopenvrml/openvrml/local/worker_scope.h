@@ -0,0 +1,43 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# ifndef OPENVRML_LOCAL_WORKER_SCOPE_H
+#   define OPENVRML_LOCAL_WORKER_SCOPE_H
+
+#   include <openvrml-common.h>
+#   include <boost/utility.hpp>
+
+namespace openvrml {
+
+    namespace local {
+
+        class OPENVRML_LOCAL worker_scope : boost::noncopyable {
+            worker_scope * const enclosing_;
+
+        public:
+            static bool active() OPENVRML_NOTHROW;
+
+            worker_scope() OPENVRML_NOTHROW;
+            ~worker_scope() OPENVRML_NOTHROW;
+        };
+    }
+}
+
+# endif // ifndef OPENVRML_LOCAL_WORKER_SCOPE_H
@@ -0,0 +1,182 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# include "x3d_vocabulary.h"
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+//
+// The X3D external vocabulary (ISO/IEC 19776-3): the element and attribute
+// name tables an encoder may refer to by URI rather than include in the
+// document's initial vocabulary.  Index 1 of each table is its first entry.
+//
+
+/**
+ * @internal
+ *
+ * @brief The URI that identifies the X3D external vocabulary.
+ */
+const char openvrml::local::x3d_external_vocabulary_uri[] =
+    "urn:external-vocabulary";
+
+/**
+ * @internal
+ *
+ * @brief The element names of the X3D external vocabulary: the most
+ *        frequently used first, then the rest of the X3D 3.0 elements in
+ *        alphabetical order, then those added in X3D 3.1.
+ */
+const char * const openvrml::local::x3d_element_names[] = {
+    "Shape", "Appearance", "Material", "IndexedFaceSet", "ProtoInstance",
+    "Transform", "ImageTexture", "TextureTransform", "Coordinate", "Normal",
+    "Color", "ColorRGBA", "TextureCoordinate", "ROUTE", "fieldValue", "Group",
+    "LOD", "Switch", "Script", "IndexedTriangleFanSet", "IndexedTriangleSet",
+    "IndexedTriangleStripSet", "MultiTexture", "MultiTextureCoordinate",
+    "MultiTextureTransform", "IndexedLineSet", "PointSet", "StaticGroup",
+    "Sphere", "Box", "Cone", "Anchor", "Arc2D", "ArcClose2D", "AudioClip",
+    "Background", "Billboard", "BooleanFilter", "BooleanSequencer",
+    "BooleanToggle", "BooleanTrigger", "Circle2D", "Collision",
+    "ColorInterpolator", "Contour2D", "ContourPolyline2D", "CoordinateDouble",
+    "CoordinateInterpolator", "CoordinateInterpolator2D", "Cylinder",
+    "CylinderSensor", "DirectionalLight", "Disk2D", "EXPORT", "ElevationGrid",
+    "EspduTransform", "ExternProtoDeclare", "Extrusion", "FillProperties",
+    "Fog", "FontStyle", "GeoCoordinate", "GeoElevationGrid", "GeoLOD",
+    "GeoLocation", "GeoMetadata", "GeoOrigin", "GeoPositionInterpolator",
+    "GeoTouchSensor", "GeoViewpoint", "HAnimDisplacer", "HAnimHumanoid",
+    "HAnimJoint", "HAnimSegment", "HAnimSite", "IMPORT", "IS", "Inline",
+    "IntegerSequencer", "IntegerTrigger", "KeySensor", "LineProperties",
+    "LineSet", "LoadSensor", "MetadataDouble", "MetadataFloat",
+    "MetadataInteger", "MetadataSet", "MetadataString", "MovieTexture",
+    "NavigationInfo", "NormalInterpolator", "NurbsCurve", "NurbsCurve2D",
+    "NurbsOrientationInterpolator", "NurbsPatchSurface",
+    "NurbsPositionInterpolator", "NurbsSet", "NurbsSurfaceInterpolator",
+    "NurbsSweptSurface", "NurbsSwungSurface", "NurbsTextureCoordinate",
+    "NurbsTrimmedSurface", "OrientationInterpolator", "PixelTexture",
+    "PlaneSensor", "PointLight", "Polyline2D", "Polypoint2D",
+    "PositionInterpolator", "PositionInterpolator2D", "ProtoBody",
+    "ProtoDeclare", "ProtoInterface", "ProximitySensor", "ReceiverPdu",
+    "Rectangle2D", "ScalarInterpolator", "Scene", "SignalPdu", "Sound",
+    "SphereSensor", "SpotLight", "StringSensor", "Text", "TextureBackground",
+    "TextureCoordinateGenerator", "TimeSensor", "TimeTrigger", "TouchSensor",
+    "TransmitterPdu", "TriangleFanSet", "TriangleSet", "TriangleSet2D",
+    "TriangleStripSet", "Viewpoint", "VisibilitySensor", "WorldInfo", "X3D",
+    "component", "connect", "field", "head", "humanoidBodyType", "meta",
+    "CADAssembly", "CADFace", "CADLayer", "CADPart", "ComposedCubeMapTexture",
+    "ComposedShader", "ComposedTexture3D", "FloatVertexAttribute",
+    "FogCoordinate", "GeneratedCubeMapTexture", "ImageCubeMapTexture",
+    "ImageTexture3D", "IndexedQuadSet", "LocalFog", "Matrix3VertexAttribute",
+    "Matrix4VertexAttribute", "PackagedShader", "PixelTexture3D",
+    "ProgramShader", "QuadSet", "ShaderPart", "ShaderProgram",
+    "TextureCoordinate3D", "TextureCoordinate4D", "TextureTransform3D",
+    "TextureTransformMatrix3D"
+};
+
+/**
+ * @internal
+ *
+ * @brief The number of entries in @c #x3d_element_names.
+ */
+const std::size_t openvrml::local::x3d_element_names_size =
+    sizeof x3d_element_names / sizeof x3d_element_names[0];
+
+/**
+ * @internal
+ *
+ * @brief The attribute names of the X3D external vocabulary: the most
+ *        frequently used first, then the rest in alphabetical order.
+ */
+const char * const openvrml::local::x3d_attribute_names[] = {
+    "DEF", "USE", "containerField", "fromNode", "fromField", "toNode",
+    "toField", "name", "value", "color", "colorIndex", "coordIndex",
+    "texCoordIndex", "normalIndex", "colorPerVertex", "normalPerVertex",
+    "rotation", "translation", "center", "scale", "scaleOrientation", "point",
+    "vector", "type", "depth", "magnificationFilter", "minificationFilter",
+    "AS", "accessType", "address", "alpha", "ambientIntensity",
+    "antennaLocation", "antennaPatternLength", "antennaPatternType",
+    "appinfo", "applicationID", "applied", "articulationParameterArray",
+    "articulationParameterChangeIndicatorArray", "articulationParameterCount",
+    "articulationParameterDesignatorArray",
+    "articulationParameterIdPartAttachedToArray",
+    "articulationParameterTypeArray", "attenuation", "autoOffset",
+    "avatarSize", "axisOfRotation", "backUrl", "bboxCenter", "bboxSize",
+    "beamWidth", "beginCap", "bottom", "bottomRadius", "bottomUrl", "ccw",
+    "centerOfMass", "centerOfRotation", "child1Url", "child2Url", "child3Url",
+    "child4Url", "class", "closed", "closureType", "collide", "collisionType",
+    "content", "controlPoint", "convex", "creaseAngle", "crossSection",
+    "cryptoKeyID", "cryptoSystem", "cutOffAngle", "data", "dataLength",
+    "deadReckoning", "deletionAllowed", "description", "detonationLocation",
+    "detonationRelativeLocation", "detonationResult", "diffuseColor",
+    "direction", "diskAngle", "displacements", "documentation",
+    "emissiveColor", "enabled", "encodingScheme", "endAngle", "endCap",
+    "entityCategory", "entityCountry", "entityDomain", "entityExtra",
+    "entityID", "entityKind", "entitySpecific", "entitySubCategory",
+    "eventApplicationID", "eventEntityID", "eventNumber", "eventSiteID",
+    "family", "fanCount", "fieldOfView", "filled", "fireMissionIndex",
+    "fired1", "fired2", "firingRange", "firingRate", "fogType", "forceID",
+    "frequency", "frontUrl", "function", "fuse", "geoCoords", "geoGridOrigin",
+    "geoSystem", "groundAngle", "groundColor", "hatchColor", "hatchStyle",
+    "hatched", "headlight", "height", "horizontal", "image", "importedDEF",
+    "index", "info", "inlineDEF", "innerRadius", "inputSource", "integerKey",
+    "intensity", "jump", "justify", "key", "keyValue", "knot", "language",
+    "leftToRight", "leftUrl", "length", "lengthOfModulationParameters",
+    "level", "limitOrientation", "lineSegments", "lineType",
+    "linearAcceleration", "linearVelocity", "linewidthScaleFactor", "llimit",
+    "load", "localDEF", "location", "loop", "marking", "mass", "maxAngle",
+    "maxBack", "maxExtent", "maxFront", "maxPosition", "minAngle", "minBack",
+    "minFront", "minPosition", "mode", "modulationTypeDetail",
+    "modulationTypeMajor", "modulationTypeSpreadSpectrum",
+    "modulationTypeSystem", "momentsOfInertia", "multicastRelayHost",
+    "multicastRelayPort", "munitionApplicationID", "munitionEndPoint",
+    "munitionEntityID", "munitionQuantity", "munitionSiteID",
+    "munitionStartPoint", "navType", "networkMode", "nodeField", "offset",
+    "on", "order", "orientation", "outerRadius", "parameter", "pauseTime",
+    "pitch", "port", "position", "power", "priority", "profile", "protoField",
+    "radioEntityTypeCategory", "radioEntityTypeCountry",
+    "radioEntityTypeDomain", "radioEntityTypeKind",
+    "radioEntityTypeNomenclature", "radioEntityTypeNomenclatureVersion",
+    "radioID", "radius", "range", "readInterval", "receivedPower",
+    "receiverState", "reference", "relativeAntennaLocation", "repeatS",
+    "repeatT", "resumeTime", "rightUrl", "rootUrl", "rotateYUp",
+    "rtpHeaderExpected", "sampleRate", "samples", "shininess", "side",
+    "siteID", "size", "skinCoordIndex", "skyAngle", "skyColor", "solid",
+    "source", "spacing", "spatialize", "specularColor", "speed",
+    "speedFactor", "spine", "startAngle", "startTime", "stiffness",
+    "stopTime", "string", "stripCount", "style", "summary", "tdlType",
+    "tessellation", "tessellationScale", "timeout", "title", "toggle", "top",
+    "topToBottom", "topUrl", "transitionType", "transmitFrequencyBandwidth",
+    "transmitState", "transmitterApplicationID", "transmitterEntityID",
+    "transmitterRadioID", "transmitterSiteID", "transparency", "uClosed",
+    "uDimension", "uKnot", "uOrder", "uTessellation", "ulimit", "url",
+    "vClosed", "vDimension", "vKnot", "vOrder", "vTessellation", "version",
+    "vertexCount", "vertices", "visibilityLimit", "visibilityRange",
+    "visible", "warhead", "weight", "whichChoice", "whichGeometry",
+    "writeInterval", "xDimension", "xSpacing", "yScale", "zDimension",
+    "zSpacing"
+};
+
+/**
+ * @internal
+ *
+ * @brief The number of entries in @c #x3d_attribute_names.
+ */
+const std::size_t openvrml::local::x3d_attribute_names_size =
+    sizeof x3d_attribute_names / sizeof x3d_attribute_names[0];
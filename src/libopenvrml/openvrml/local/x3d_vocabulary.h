@@ -0,0 +1,41 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# ifndef OPENVRML_LOCAL_X3D_VOCABULARY_H
+#   define OPENVRML_LOCAL_X3D_VOCABULARY_H
+
+#   include <openvrml-common.h>
+#   include <cstddef>
+
+namespace openvrml {
+
+    namespace local {
+
+        OPENVRML_LOCAL extern const char x3d_external_vocabulary_uri[];
+
+        OPENVRML_LOCAL extern const char * const x3d_element_names[];
+        OPENVRML_LOCAL extern const std::size_t x3d_element_names_size;
+
+        OPENVRML_LOCAL extern const char * const x3d_attribute_names[];
+        OPENVRML_LOCAL extern const std::size_t x3d_attribute_names_size;
+    }
+}
+
+# endif // ifndef OPENVRML_LOCAL_X3D_VOCABULARY_H
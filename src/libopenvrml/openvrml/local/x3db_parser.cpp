@@ -0,0 +1,1680 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# include "x3db_parser.h"
+# include "fast_infoset.h"
+# include "parse_vrml.h"
+# include "vrml_scanner.h"
+# include <openvrml/local/float.h>
+# include <openvrml/x3d_vrml_grammar.h>
+# include <boost/algorithm/string/predicate.hpp>
+# include <boost/algorithm/string/trim.hpp>
+# include <boost/cstdint.hpp>
+# include <boost/integer.hpp>
+# include <algorithm>
+# include <cmath>
+# include <cstring>
+# include <functional>
+# include <limits>
+# include <set>
+# include <sstream>
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+# ifdef OPENVRML_ENABLE_GZIP
+#   include <zlib.h>
+# endif
+
+namespace {
+
+    using openvrml::int32;
+    using openvrml::local::fi_string;
+    using openvrml::local::fi_attribute;
+    using openvrml::local::fi_element;
+
+    //
+    // The number of numbers in each value of a numeric field type, and the
+    // type of those numbers.
+    //
+    template <typename T>
+    struct OPENVRML_LOCAL value_traits;
+
+# define OPENVRML_VALUE_TRAITS_(type_, number_, n_)     \
+    template <>                                         \
+    struct OPENVRML_LOCAL value_traits<type_> {         \
+        typedef number_ number_type;                    \
+        static const std::size_t components = n_;       \
+    }
+
+    OPENVRML_VALUE_TRAITS_(float, float, 1);
+    OPENVRML_VALUE_TRAITS_(double, double, 1);
+    OPENVRML_VALUE_TRAITS_(int32, int32, 1);
+    OPENVRML_VALUE_TRAITS_(openvrml::vec2f, float, 2);
+    OPENVRML_VALUE_TRAITS_(openvrml::vec2d, double, 2);
+    OPENVRML_VALUE_TRAITS_(openvrml::vec3f, float, 3);
+    OPENVRML_VALUE_TRAITS_(openvrml::vec3d, double, 3);
+    OPENVRML_VALUE_TRAITS_(openvrml::color, float, 3);
+    OPENVRML_VALUE_TRAITS_(openvrml::color_rgba, float, 4);
+    OPENVRML_VALUE_TRAITS_(openvrml::rotation, float, 4);
+
+# undef OPENVRML_VALUE_TRAITS_
+
+    OPENVRML_LOCAL void convert(const float * const n, float & value)
+    {
+        value = n[0];
+    }
+
+    OPENVRML_LOCAL void convert(const double * const n, double & value)
+    {
+        value = n[0];
+    }
+
+    OPENVRML_LOCAL void convert(const int32 * const n, int32 & value)
+    {
+        value = n[0];
+    }
+
+    OPENVRML_LOCAL void convert(const float * const n,
+                                openvrml::vec2f & value)
+    {
+        value = openvrml::make_vec2f(n[0], n[1]);
+    }
+
+    OPENVRML_LOCAL void convert(const double * const n,
+                                openvrml::vec2d & value)
+    {
+        value = openvrml::make_vec2d(n[0], n[1]);
+    }
+
+    OPENVRML_LOCAL void convert(const float * const n,
+                                openvrml::vec3f & value)
+    {
+        value = openvrml::make_vec3f(n[0], n[1], n[2]);
+    }
+
+    OPENVRML_LOCAL void convert(const double * const n,
+                                openvrml::vec3d & value)
+    {
+        value = openvrml::make_vec3d(n[0], n[1], n[2]);
+    }
+
+    OPENVRML_LOCAL void convert(const float * const n,
+                                openvrml::color & value)
+    {
+        value = openvrml::make_color(n[0], n[1], n[2]);
+    }
+
+    OPENVRML_LOCAL void convert(const float * const n,
+                                openvrml::color_rgba & value)
+    {
+        value = openvrml::make_color_rgba(n[0], n[1], n[2], n[3]);
+    }
+
+    OPENVRML_LOCAL void convert(const float * const n,
+                                openvrml::rotation & value)
+    {
+        //
+        // Set the components directly; make_rotation requires a normalized
+        // axis.
+        //
+        for (std::size_t i = 0; i < 4; ++i) { value.rot[i] = n[i]; }
+    }
+
+    template <typename UInt>
+    OPENVRML_LOCAL UInt read_big_endian(const char * const p)
+    {
+        UInt result = 0;
+        for (std::size_t i = 0; i < sizeof (UInt); ++i) {
+            result = UInt(result << 8) | static_cast<unsigned char>(p[i]);
+        }
+        return result;
+    }
+
+# ifdef OPENVRML_ENABLE_GZIP
+    //
+    // Inflate the zlib stream that starts at offset in data, which must
+    // inflate to exactly size octets.  The size comes from the document, so
+    // octets grows only as the stream actually produces output; a corrupt
+    // size costs no more memory than the payload itself.
+    //
+    OPENVRML_LOCAL bool inflate_octets(const std::string & data,
+                                       const std::size_t offset,
+                                       const std::size_t size,
+                                       std::vector<unsigned char> & octets)
+    {
+        octets.clear();
+        if (size == 0) { return true; }
+
+        z_stream stream = z_stream();
+        stream.next_in =
+            reinterpret_cast<Bytef *>(const_cast<char *>(data.data()
+                                                         + offset));
+        stream.avail_in = uInt(data.size() - offset);
+        if (inflateInit(&stream) != Z_OK) { return false; }
+
+        static const std::size_t chunk = 16384;
+        int result = Z_OK;
+        while (result == Z_OK) {
+            if (octets.size() == size) {
+                //
+                // Anything more than size octets is an error; ask for one
+                // to find out whether the stream has ended.
+                //
+                unsigned char extra;
+                stream.next_out = &extra;
+                stream.avail_out = 1;
+                result = inflate(&stream, Z_NO_FLUSH);
+                if (stream.avail_out == 0) { result = Z_DATA_ERROR; }
+                break;
+            }
+            const std::size_t filled = octets.size();
+            octets.resize(filled + std::min(chunk, size - filled));
+            stream.next_out = &octets[filled];
+            stream.avail_out = uInt(octets.size() - filled);
+            result = inflate(&stream, Z_NO_FLUSH);
+            octets.resize(octets.size() - stream.avail_out);
+        }
+        inflateEnd(&stream);
+        return result == Z_STREAM_END && octets.size() == size;
+    }
+
+    //
+    // The X3D quantized float array encoder: the number of exponent bits,
+    // the number of mantissa bits, and a 32-bit count, followed by a zlib
+    // stream of the values packed with a sign bit, exponent, and mantissa,
+    // most significant bit first.
+    //
+    OPENVRML_LOCAL bool quantized_floats(const std::string & data,
+                                         std::vector<double> & numbers)
+    {
+        if (data.size() < 6) { return false; }
+        const unsigned exponent_bits = static_cast<unsigned char>(data[0]);
+        const unsigned mantissa_bits = static_cast<unsigned char>(data[1]);
+        if (exponent_bits < 1 || exponent_bits > 11 || mantissa_bits > 52) {
+            return false;
+        }
+        const std::size_t count = read_big_endian<boost::uint32_t>(&data[2]);
+        const std::size_t bits = 1 + exponent_bits + mantissa_bits;
+        if (count > std::numeric_limits<std::size_t>::max() / bits) {
+            return false;
+        }
+        std::vector<unsigned char> packed;
+        if (!inflate_octets(data, 6, (count * bits + 7) / 8, packed)) {
+            return false;
+        }
+
+        const int bias = (1 << (exponent_bits - 1)) - 1;
+        numbers.resize(count);
+        std::size_t pos = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            boost::uint64_t value = 0;
+            for (std::size_t bit = 0; bit < bits; ++bit, ++pos) {
+                value = (value << 1)
+                    | ((packed[pos >> 3] >> (7 - (pos & 7))) & 1);
+            }
+            const boost::uint64_t mantissa =
+                value & ((boost::uint64_t(1) << mantissa_bits) - 1);
+            const int exponent =
+                int((value >> mantissa_bits) & ((1U << exponent_bits) - 1));
+            const bool negative = (value >> (bits - 1)) != 0;
+            const double magnitude = (exponent == 0)
+                ? std::ldexp(double(mantissa),
+                             1 - bias - int(mantissa_bits))
+                : std::ldexp(double(mantissa
+                                    | (boost::uint64_t(1) << mantissa_bits)),
+                             exponent - bias - int(mantissa_bits));
+            numbers[i] = negative ? -magnitude : magnitude;
+        }
+        return true;
+    }
+
+    //
+    // The X3D delta integer array encoder: a 32-bit count and the span
+    // between each value and the one it is a delta from, followed by a zlib
+    // stream of 32-bit deltas.
+    //
+    OPENVRML_LOCAL bool delta_ints(const std::string & data,
+                                   std::vector<double> & numbers)
+    {
+        if (data.size() < 5) { return false; }
+        const std::size_t count = read_big_endian<boost::uint32_t>(&data[0]);
+        const std::size_t span = static_cast<unsigned char>(data[4]);
+        if (span == 0 || count > std::numeric_limits<std::size_t>::max() / 4) {
+            return false;
+        }
+        std::vector<unsigned char> packed;
+        if (!inflate_octets(data, 5, count * 4, packed)) { return false; }
+
+        std::vector<boost::uint32_t> values(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            values[i] = read_big_endian<boost::uint32_t>(
+                reinterpret_cast<const char *>(&packed[i * 4]));
+            if (i >= span) { values[i] += values[i - span]; }
+        }
+        numbers.resize(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            numbers[i] = double(boost::int32_t(values[i]));
+        }
+        return true;
+    }
+# endif // defined OPENVRML_ENABLE_GZIP
+
+    template <typename Int>
+    OPENVRML_LOCAL void integers(const std::string & data,
+                                 std::vector<double> & numbers)
+    {
+        typedef typename boost::uint_t<sizeof (Int) * 8>::exact uint_type;
+        numbers.resize(data.size() / sizeof (Int));
+        for (std::size_t i = 0; i < numbers.size(); ++i) {
+            numbers[i] = double(Int(
+                read_big_endian<uint_type>(&data[i * sizeof (Int)])));
+        }
+    }
+
+    template <typename Float, typename UInt>
+    OPENVRML_LOCAL void floats(const std::string & data,
+                               std::vector<double> & numbers)
+    {
+        numbers.resize(data.size() / sizeof (Float));
+        for (std::size_t i = 0; i < numbers.size(); ++i) {
+            const UInt bits = read_big_endian<UInt>(&data[i * sizeof (Float)]);
+            Float value;
+            std::memcpy(&value, &bits, sizeof value);
+            numbers[i] = value;
+        }
+    }
+
+    //
+    // Decode the numbers in a value encoded with an encoding algorithm.
+    //
+    OPENVRML_LOCAL bool decode_numbers(const fi_string & value,
+                                       std::vector<double> & numbers)
+    {
+        const std::string & data = value.data;
+        switch (value.algorithm) {
+        case fi_string::short_algorithm:
+            if (data.size() % 2 != 0) { return false; }
+            integers<boost::int16_t>(data, numbers);
+            return true;
+        case fi_string::int_algorithm:
+            if (data.size() % 4 != 0) { return false; }
+            integers<boost::int32_t>(data, numbers);
+            return true;
+        case fi_string::long_algorithm:
+            if (data.size() % 8 != 0) { return false; }
+            integers<boost::int64_t>(data, numbers);
+            return true;
+        case fi_string::float_algorithm:
+            if (data.size() % 4 != 0) { return false; }
+            floats<float, boost::uint32_t>(data, numbers);
+            return true;
+        case fi_string::double_algorithm:
+            if (data.size() % 8 != 0) { return false; }
+            floats<double, boost::uint64_t>(data, numbers);
+            return true;
+        }
+# ifdef OPENVRML_ENABLE_GZIP
+        using boost::algorithm::ends_with;
+        if (ends_with(value.algorithm_uri, "QuantizedzlibFloatArrayEncoder")) {
+            return quantized_floats(data, numbers);
+        }
+        if (ends_with(value.algorithm_uri, "DeltazlibIntArrayEncoder")) {
+            return delta_ints(data, numbers);
+        }
+# endif
+        return false;
+    }
+
+    OPENVRML_LOCAL bool text_value(const fi_string & value)
+    {
+        return value.encoding == fi_string::text_encoding
+            || value.algorithm == fi_string::cdata_algorithm;
+    }
+
+    //
+    // Whether a decoded number fits in a Number: an integer must be integral
+    // and in range; a floating point value must not overflow.
+    //
+    template <typename Number>
+    OPENVRML_LOCAL bool representable(const double n)
+    {
+        typedef std::numeric_limits<Number> limits;
+        if (limits::is_integer) {
+            return n >= double(limits::min()) && n <= double(limits::max())
+                && std::floor(n) == n;
+        }
+        return !(std::fabs(n) > double(limits::max()))
+            || std::fabs(n) == std::numeric_limits<double>::infinity();
+    }
+
+    template <typename Number>
+    OPENVRML_LOCAL bool read_numbers(const fi_string & value,
+                                     std::vector<Number> & numbers)
+    {
+        numbers.clear();
+        if (text_value(value)) {
+            const char * const begin = value.data.data();
+            openvrml::local::vrml_scanner
+                scanner(begin, begin + value.data.size(), true);
+            while (!scanner.at_end()) {
+                Number n;
+                if (!scanner.read(n)) { return false; }
+                numbers.push_back(n);
+            }
+            return true;
+        }
+        std::vector<double> decoded;
+        if (!decode_numbers(value, decoded)) { return false; }
+        numbers.reserve(decoded.size());
+        for (std::vector<double>::const_iterator n = decoded.begin();
+             n != decoded.end();
+             ++n) {
+            if (!representable<Number>(*n)) { return false; }
+            numbers.push_back(static_cast<Number>(*n));
+        }
+        return true;
+    }
+
+    OPENVRML_LOCAL bool read_booleans(const fi_string & value,
+                                      std::vector<bool> & booleans)
+    {
+        booleans.clear();
+        if (text_value(value)) {
+            const char * const begin = value.data.data();
+            openvrml::local::vrml_scanner
+                scanner(begin, begin + value.data.size(), true);
+            openvrml::local::vrml_scanner::token t;
+            while (!scanner.at_end()) {
+                if (!scanner.id(t)) { return false; }
+                if (t == "true" || t == "TRUE") {
+                    booleans.push_back(true);
+                } else if (t == "false" || t == "FALSE") {
+                    booleans.push_back(false);
+                } else {
+                    return false;
+                }
+            }
+            return true;
+        }
+        if (value.algorithm != fi_string::boolean_algorithm
+            || value.data.empty()) {
+            return false;
+        }
+
+        //
+        // The first four bits are the number of unused bits in the last
+        // octet.
+        //
+        const std::size_t unused =
+            static_cast<unsigned char>(value.data[0]) >> 4;
+        const std::size_t bits = value.data.size() * 8 - 4;
+        if (unused > bits) { return false; }
+        for (std::size_t pos = 4; pos < bits + 4 - unused; ++pos) {
+            booleans.push_back(
+                ((static_cast<unsigned char>(value.data[pos >> 3])
+                  >> (7 - (pos & 7))) & 1) != 0);
+        }
+        return true;
+    }
+
+    //
+    // MFString values are quoted as in the Classic VRML encoding; as a
+    // convenience, a value without any quotes is taken as a single string.
+    //
+    OPENVRML_LOCAL bool read_strings(const fi_string & value,
+                                     std::vector<std::string> & strings)
+    {
+        strings.clear();
+        if (!text_value(value)) { return false; }
+        if (value.data.find('"') == std::string::npos) {
+            const std::string str = boost::algorithm::trim_copy(value.data);
+            if (!str.empty()) { strings.push_back(str); }
+            return true;
+        }
+        const char * const begin = value.data.data();
+        openvrml::local::vrml_scanner
+            scanner(begin, begin + value.data.size(), true);
+        while (!scanner.at_end()) {
+            std::string str;
+            if (!scanner.read(str)) { return false; }
+            strings.push_back(str);
+        }
+        return true;
+    }
+
+    OPENVRML_LOCAL bool read_image(const std::vector<int32> & numbers,
+                                   std::size_t & pos,
+                                   openvrml::image & value)
+    {
+        if (numbers.size() - pos < 3) { return false; }
+        const int32 x = numbers[pos], y = numbers[pos + 1],
+            comp = numbers[pos + 2];
+        if (x < 0 || y < 0 || comp < 0) { return false; }
+        const std::size_t pixels = std::size_t(x) * y;
+        if (numbers.size() - pos - 3 < pixels) { return false; }
+        openvrml::image result(x, y, comp);
+        for (std::size_t index = 0; index < pixels; ++index) {
+            result.pixel(index, numbers[pos + 3 + index]);
+        }
+        value.swap(result);
+        pos += 3 + pixels;
+        return true;
+    }
+
+    struct OPENVRML_LOCAL container_field_entry {
+        const char * node_type_id;
+        const char * field_id;
+    };
+
+    //
+    // The default containerField of the node types that do not go in
+    // "children".
+    //
+    const container_field_entry default_container_fields[] = {
+        { "Appearance",                "appearance" },
+        { "Material",                  "material" },
+        { "TwoSidedMaterial",          "material" },
+        { "ComposedCubeMapTexture",    "texture" },
+        { "ComposedTexture3D",         "texture" },
+        { "GeneratedCubeMapTexture",   "texture" },
+        { "ImageCubeMapTexture",       "texture" },
+        { "ImageTexture",              "texture" },
+        { "ImageTexture3D",            "texture" },
+        { "MovieTexture",              "texture" },
+        { "MultiTexture",              "texture" },
+        { "PixelTexture",              "texture" },
+        { "PixelTexture3D",            "texture" },
+        { "MultiTextureTransform",     "textureTransform" },
+        { "TextureTransform",          "textureTransform" },
+        { "TextureTransform3D",        "textureTransform" },
+        { "TextureTransformMatrix3D",  "textureTransform" },
+        { "Arc2D",                     "geometry" },
+        { "ArcClose2D",                "geometry" },
+        { "Box",                       "geometry" },
+        { "Circle2D",                  "geometry" },
+        { "Cone",                      "geometry" },
+        { "Cylinder",                  "geometry" },
+        { "Disk2D",                    "geometry" },
+        { "ElevationGrid",             "geometry" },
+        { "Extrusion",                 "geometry" },
+        { "GeoElevationGrid",          "geometry" },
+        { "IndexedFaceSet",            "geometry" },
+        { "IndexedLineSet",            "geometry" },
+        { "IndexedQuadSet",            "geometry" },
+        { "IndexedTriangleFanSet",     "geometry" },
+        { "IndexedTriangleSet",        "geometry" },
+        { "IndexedTriangleStripSet",   "geometry" },
+        { "LineSet",                   "geometry" },
+        { "NurbsCurve",                "geometry" },
+        { "NurbsPatchSurface",         "geometry" },
+        { "NurbsSweptSurface",         "geometry" },
+        { "NurbsSwungSurface",         "geometry" },
+        { "NurbsTrimmedSurface",       "geometry" },
+        { "PointSet",                  "geometry" },
+        { "Polyline2D",                "geometry" },
+        { "Polypoint2D",               "geometry" },
+        { "QuadSet",                   "geometry" },
+        { "Rectangle2D",               "geometry" },
+        { "Sphere",                    "geometry" },
+        { "Text",                      "geometry" },
+        { "TriangleFanSet",            "geometry" },
+        { "TriangleSet",               "geometry" },
+        { "TriangleSet2D",             "geometry" },
+        { "TriangleStripSet",          "geometry" },
+        { "Coordinate",                "coord" },
+        { "CoordinateDouble",          "coord" },
+        { "GeoCoordinate",             "coord" },
+        { "Color",                     "color" },
+        { "ColorRGBA",                 "color" },
+        { "Normal",                    "normal" },
+        { "MultiTextureCoordinate",    "texCoord" },
+        { "TextureCoordinate",         "texCoord" },
+        { "TextureCoordinate3D",       "texCoord" },
+        { "TextureCoordinate4D",       "texCoord" },
+        { "TextureCoordinateGenerator", "texCoord" },
+        { "FontStyle",                 "fontStyle" },
+        { "ScreenFontStyle",           "fontStyle" },
+        { "MetadataDouble",            "metadata" },
+        { "MetadataFloat",             "metadata" },
+        { "MetadataInteger",           "metadata" },
+        { "MetadataSet",               "metadata" },
+        { "MetadataString",            "metadata" },
+        { "AudioClip",                 "source" },
+        { "FogCoordinate",             "fogCoord" },
+        { "FloatVertexAttribute",      "attrib" },
+        { "Matrix3VertexAttribute",    "attrib" },
+        { "Matrix4VertexAttribute",    "attrib" },
+        { "GeoOrigin",                 "geoOrigin" }
+    };
+
+    //
+    // Elements in a node's content that are not child nodes.
+    //
+    const char * const node_content_elements[] = {
+        "ExternProtoDeclare", "IS", "ProtoDeclare", "ROUTE", "field",
+        "fieldValue"
+    };
+
+    OPENVRML_LOCAL bool node_element(const fi_element & e)
+    {
+        for (std::size_t i = 0;
+             i < sizeof node_content_elements / sizeof node_content_elements[0];
+             ++i) {
+            if (e.name == node_content_elements[i]) { return false; }
+        }
+        return true;
+    }
+
+    OPENVRML_LOCAL bool node_field(const openvrml::node_interface & interface_)
+    {
+        using openvrml::node_interface;
+        using openvrml::field_value;
+        return (interface_.type == node_interface::field_id
+                || interface_.type == node_interface::exposedfield_id)
+            && (interface_.field_type == field_value::sfnode_id
+                || interface_.field_type == field_value::mfnode_id);
+    }
+
+    using openvrml::defs_t;
+    using openvrml::field_value;
+    using openvrml::node_interface;
+    using openvrml::node_interface_set;
+    using openvrml::node_type_decls;
+    using openvrml::scope_stack_t;
+    using openvrml::vrml_parse_error;
+
+    //
+    // Builds a scene from a decoded X3D document by driving the same
+    // semantic actions as x3d_vrml_parser, validating the document against
+    // the same node type and DEF scopes.
+    //
+    class OPENVRML_LOCAL x3db_builder : boost::noncopyable {
+        const openvrml::local::x3d_vrml_parse_actions & actions_;
+        openvrml::browser & browser_;
+        const std::string uri_;
+        scope_stack_t scope_stack_;
+
+    public:
+        x3db_builder(const openvrml::local::x3d_vrml_parse_actions & actions,
+                     openvrml::browser & b,
+                     const std::string & uri);
+
+        void build(const fi_element & x3d);
+
+    private:
+        void fail(vrml_parse_error error, const std::string & context) const;
+        void warn(vrml_parse_error error, const std::string & context) const;
+
+        const std::string & text(const fi_string & value,
+                                 const std::string & context) const;
+        const std::string attribute(const fi_element & e,
+                                    const char * name) const;
+        const defs_t::value_type * node_name_id(const std::string & id) const;
+
+        bool statement(const fi_element & e);
+        void proto(const fi_element & e);
+        void externproto(const fi_element & e);
+        void interface_decl(const fi_element & e,
+                            node_interface & interface_,
+                            bool script) const;
+        void route(const fi_element & e);
+        void node_statement(const fi_element & e);
+        void node(const fi_element & e,
+                  const std::string & node_name_id,
+                  const std::string & node_type_id);
+        void script_interface(const fi_element & e,
+                              node_type_decls::value_type & node_type,
+                              std::map<std::string, std::string> & connects);
+        const node_interface &
+        field_start(const node_type_decls::value_type & node_type,
+                    const std::string & id,
+                    std::set<std::string> & fields);
+        void is_mapping(const node_interface & impl_interface,
+                        const std::string & proto_interface_id);
+        const std::string
+        container_field(const node_type_decls::value_type & node_type,
+                        const fi_element & child) const;
+        void field_value(field_value::type_id type,
+                         const fi_string & value,
+                         const std::string & context);
+        void node_field_value(field_value::type_id type,
+                              const std::vector<const fi_element *> & nodes,
+                              const std::string & context);
+
+        template <typename T, typename Action>
+        void sf(const fi_string & value,
+                vrml_parse_error error,
+                const std::string & context,
+                const Action & action);
+
+        template <typename T, typename Action>
+        void mf(const fi_string & value,
+                vrml_parse_error error,
+                const std::string & context,
+                const Action & action);
+
+        template <typename T>
+        void check_value(const T &, const std::string &) const {}
+        void check_value(const openvrml::rotation & value,
+                         const std::string & context) const;
+    };
+
+    x3db_builder::
+    x3db_builder(const openvrml::local::x3d_vrml_parse_actions & actions,
+                 openvrml::browser & b,
+                 const std::string & uri):
+        actions_(actions),
+        browser_(b),
+        uri_(uri)
+    {
+        this->scope_stack_.push(openvrml::parse_scope());
+    }
+
+    void x3db_builder::fail(const vrml_parse_error error,
+                            const std::string & context) const
+    {
+        throw openvrml::invalid_vrml(
+            this->uri_, 0, 0,
+            std::string(openvrml::x3d_vrml_parse_error_msg(error))
+            + " (" + context + ')');
+    }
+
+    void x3db_builder::warn(const vrml_parse_error error,
+                            const std::string & context) const
+    {
+        this->browser_.err(this->uri_ + ": warning: "
+                           + openvrml::x3d_vrml_parse_error_msg(error)
+                           + " (" + context + ')');
+    }
+
+    const std::string & x3db_builder::text(const fi_string & value,
+                                           const std::string & context) const
+    {
+        if (!text_value(value)) {
+            this->fail(openvrml::string_expected, context);
+        }
+        return value.data;
+    }
+
+    const std::string x3db_builder::attribute(const fi_element & e,
+                                              const char * const name) const
+    {
+        const fi_attribute * const attr = e.attribute(name);
+        return attr ? this->text(attr->value, e.name + ' ' + name)
+                    : std::string();
+    }
+
+    const defs_t::value_type *
+    x3db_builder::node_name_id(const std::string & id) const
+    {
+        const defs_t & defs = this->scope_stack_.top().defs;
+        const defs_t::const_iterator pos = defs.find(id);
+        if (pos == defs.end()) {
+            this->fail(openvrml::unknown_node_name_id, id);
+        }
+        return &(*pos);
+    }
+
+    //
+    // The document element is X3D.  The profile attribute is required; the
+    // head may contain component and then meta elements.
+    //
+    void x3db_builder::build(const fi_element & x3d)
+    {
+        if (x3d.name != "X3D") {
+            this->fail(openvrml::profile_expected, x3d.name);
+        }
+
+        this->actions_.on_scene_start();
+
+        const std::string profile_id = this->attribute(x3d, "profile");
+        if (profile_id.empty()) {
+            this->fail(openvrml::profile_expected, x3d.name);
+        }
+        std::auto_ptr<node_type_decls> node_types;
+        try {
+            node_types = openvrml::profile(profile_id);
+        } catch (std::invalid_argument &) {
+            this->fail(openvrml::unrecognized_profile_id, profile_id);
+        }
+        this->scope_stack_.top().node_body_repo = *node_types;
+        this->actions_.on_profile_statement(profile_id);
+
+        const fi_element * scene = 0;
+        for (fi_element::children_t::const_iterator child =
+                 x3d.children.begin();
+             child != x3d.children.end();
+             ++child) {
+            if (child->name == "Scene") {
+                scene = &*child;
+            } else if (child->name != "head") {
+                continue;
+            }
+            for (fi_element::children_t::const_iterator e =
+                     child->children.begin();
+                 e != child->children.end();
+                 ++e) {
+                if (e->name == "component") {
+                    const std::string component_id =
+                        this->attribute(*e, "name");
+                    std::istringstream level_in(this->attribute(*e, "level"));
+                    int32 level;
+                    if (!(level_in >> level)) {
+                        this->fail(openvrml::int32_expected, component_id);
+                    }
+                    try {
+                        openvrml::add_component(
+                            this->scope_stack_.top().node_body_repo,
+                            component_id,
+                            level);
+                    } catch (std::invalid_argument &) {
+                        this->fail(
+                            openvrml::unrecognized_component_id_or_level,
+                            component_id);
+                    }
+                    this->actions_.on_component_statement(component_id,
+                                                          level);
+                } else if (e->name == "meta") {
+                    this->actions_.on_meta_statement(
+                        this->attribute(*e, "name"),
+                        this->attribute(*e, "content"));
+                }
+            }
+        }
+
+        if (scene) {
+            for (fi_element::children_t::const_iterator e =
+                     scene->children.begin();
+                 e != scene->children.end();
+                 ++e) {
+                this->statement(*e);
+            }
+        }
+        this->actions_.on_scene_finish();
+    }
+
+    //
+    // Returns true if e is a node.
+    //
+    bool x3db_builder::statement(const fi_element & e)
+    {
+        if (e.name == "ProtoDeclare") {
+            this->proto(e);
+        } else if (e.name == "ExternProtoDeclare") {
+            this->externproto(e);
+        } else if (e.name == "ROUTE") {
+            this->route(e);
+        } else if (e.name == "IMPORT" || e.name == "EXPORT") {
+            //
+            // x3d_vrml_parse_actions ignores these.
+            //
+        } else if (node_element(e)) {
+            this->node_statement(e);
+            return true;
+        } else {
+            this->fail(openvrml::node_expected, e.name);
+        }
+        return false;
+    }
+
+    void x3db_builder::proto(const fi_element & e)
+    {
+        using openvrml::node_type_decl;
+
+        node_type_decl node_type(this->attribute(e, "name"),
+                                 node_interface_set());
+        if (node_type.first.empty()) {
+            this->fail(openvrml::id_expected, e.name);
+        }
+        if (find_node_type(this->scope_stack_, node_type.first)) {
+            this->fail(openvrml::node_type_already_exists, node_type.first);
+        }
+
+        openvrml::parse_scope proto_scope;
+        proto_scope.proto_node_type = &node_type;
+        this->scope_stack_.push(proto_scope);
+
+        this->actions_.on_proto_start(node_type.first);
+
+        const fi_element * body = 0;
+        for (fi_element::children_t::const_iterator child =
+                 e.children.begin();
+             child != e.children.end();
+             ++child) {
+            if (child->name == "ProtoBody") {
+                body = &*child;
+                continue;
+            } else if (child->name != "ProtoInterface") {
+                continue;
+            }
+            for (fi_element::children_t::const_iterator field =
+                     child->children.begin();
+                 field != child->children.end();
+                 ++field) {
+                if (field->name != "field") { continue; }
+                node_interface interface_;
+                this->interface_decl(*field, interface_, false);
+                if (!node_type.second.insert(interface_).second) {
+                    this->fail(openvrml::interface_collision, interface_.id);
+                }
+                this->actions_.on_proto_interface(interface_);
+
+                //
+                // Any nodes in the default value get their own scope.  An
+                // absent value leaves the field's default.
+                //
+                this->scope_stack_.push(openvrml::parse_scope());
+                if (interface_.type == node_interface::field_id
+                    || interface_.type == node_interface::exposedfield_id) {
+                    std::vector<const fi_element *> nodes;
+                    for (fi_element::children_t::const_iterator n =
+                             field->children.begin();
+                         n != field->children.end();
+                         ++n) {
+                        nodes.push_back(&*n);
+                    }
+                    const fi_attribute * const value =
+                        field->attribute("value");
+                    if (value || !nodes.empty()) {
+                        this->actions_.on_proto_default_value_start();
+                        if (node_field(interface_)) {
+                            this->node_field_value(interface_.field_type,
+                                                   nodes,
+                                                   interface_.id);
+                        } else if (value) {
+                            this->field_value(interface_.field_type,
+                                              value->value,
+                                              interface_.id);
+                        }
+                        this->actions_.on_proto_default_value_finish();
+                    }
+                }
+                this->scope_stack_.pop();
+            }
+        }
+
+        if (!body) { this->fail(openvrml::node_expected, node_type.first); }
+        this->actions_.on_proto_body_start();
+        bool root_node = false;
+        for (fi_element::children_t::const_iterator child =
+                 body->children.begin();
+             child != body->children.end();
+             ++child) {
+            root_node = this->statement(*child) || root_node;
+        }
+        if (!root_node) {
+            this->fail(openvrml::node_expected, node_type.first);
+        }
+
+        this->scope_stack_.pop();
+        this->actions_.on_proto_finish();
+
+        this->scope_stack_.top().node_body_repo.insert(node_type);
+    }
+
+    void x3db_builder::externproto(const fi_element & e)
+    {
+        using openvrml::node_type_decl;
+
+        node_type_decl node_type(this->attribute(e, "name"),
+                                 node_interface_set());
+        if (node_type.first.empty()) {
+            this->fail(openvrml::id_expected, e.name);
+        }
+        if (find_node_type(this->scope_stack_, node_type.first)) {
+            this->fail(openvrml::node_type_already_exists, node_type.first);
+        }
+
+        for (fi_element::children_t::const_iterator field =
+                 e.children.begin();
+             field != e.children.end();
+             ++field) {
+            if (field->name != "field") { continue; }
+            node_interface interface_;
+            this->interface_decl(*field, interface_, false);
+            if (!node_type.second.insert(interface_).second) {
+                this->fail(openvrml::interface_collision, interface_.id);
+            }
+        }
+
+        std::vector<std::string> uri_list;
+        const fi_attribute * const url = e.attribute("url");
+        if (!(url && read_strings(url->value, uri_list))) {
+            this->fail(openvrml::string_or_lbracket_expected,
+                       node_type.first);
+        }
+
+        this->actions_.on_externproto(node_type.first, node_type.second,
+                                      uri_list);
+
+        this->scope_stack_.top().node_body_repo.insert(node_type);
+    }
+
+    //
+    // A field element in a ProtoInterface, an ExternProtoDeclare, or a
+    // Script.  As in the Classic VRML encoding, a Script may not have
+    // inputOutput fields.
+    //
+    void x3db_builder::interface_decl(const fi_element & e,
+                                      node_interface & interface_,
+                                      const bool script) const
+    {
+        interface_.id = this->attribute(e, "name");
+        if (interface_.id.empty()) {
+            this->fail(openvrml::id_expected, e.name);
+        }
+
+        const std::string access_type = this->attribute(e, "accessType");
+        if (access_type == "inputOnly") {
+            interface_.type = node_interface::eventin_id;
+        } else if (access_type == "outputOnly") {
+            interface_.type = node_interface::eventout_id;
+        } else if (access_type == "inputOutput" && !script) {
+            interface_.type = node_interface::exposedfield_id;
+        } else if (access_type == "initializeOnly") {
+            interface_.type = node_interface::field_id;
+        } else {
+            this->fail(openvrml::interface_type_or_rbracket_expected,
+                       interface_.id);
+        }
+
+        std::istringstream type_in(this->attribute(e, "type"));
+        if (!(type_in >> interface_.field_type)) {
+            this->fail(openvrml::field_type_expected, interface_.id);
+        }
+    }
+
+    void x3db_builder::route(const fi_element & e)
+    {
+        using std::bind2nd;
+        using std::find_if;
+        using openvrml::node_interface_matches_eventin;
+        using openvrml::node_interface_matches_eventout;
+
+        const defs_t::value_type * const from_node =
+            this->node_name_id(this->attribute(e, "fromNode"));
+        const std::string eventout_id = this->attribute(e, "fromField");
+        const node_interface_set & from_interfaces = from_node->second->second;
+        const node_interface_set::const_iterator from_interface =
+            find_if(from_interfaces.begin(), from_interfaces.end(),
+                    bind2nd(node_interface_matches_eventout(), eventout_id));
+        if (from_interface == from_interfaces.end()) {
+            this->fail(openvrml::eventout_id_expected, eventout_id);
+        }
+
+        const defs_t::value_type * const to_node =
+            this->node_name_id(this->attribute(e, "toNode"));
+        const std::string eventin_id = this->attribute(e, "toField");
+        const node_interface_set & to_interfaces = to_node->second->second;
+        const node_interface_set::const_iterator to_interface =
+            find_if(to_interfaces.begin(), to_interfaces.end(),
+                    bind2nd(node_interface_matches_eventin(), eventin_id));
+        if (to_interface == to_interfaces.end()) {
+            this->fail(openvrml::eventin_id_expected, eventin_id);
+        }
+
+        if (from_interface->field_type != to_interface->field_type) {
+            this->fail(openvrml::event_value_type_mismatch, eventin_id);
+        }
+
+        this->actions_.on_route(from_node->first, *from_interface,
+                                to_node->first, *to_interface);
+    }
+
+    //
+    // A node element, a ProtoInstance, or either with USE.
+    //
+    void x3db_builder::node_statement(const fi_element & e)
+    {
+        const std::string use = this->attribute(e, "USE");
+        if (!use.empty()) {
+            this->actions_.on_use(this->node_name_id(use)->first);
+            return;
+        }
+        const std::string node_type_id = (e.name == "ProtoInstance")
+                                       ? this->attribute(e, "name")
+                                       : e.name;
+        this->node(e, this->attribute(e, "DEF"), node_type_id);
+    }
+
+    void x3db_builder::node(const fi_element & e,
+                            const std::string & node_name_id,
+                            const std::string & node_type_id)
+    {
+        using openvrml::in_proto_def;
+
+        node_type_decls::value_type * node_type;
+        if (node_type_id == "Script") {
+            //
+            // Each Script node has its own interfaces.
+            //
+            static const node_interface script_node_interfaces[] = {
+                node_interface(node_interface::field_id,
+                               field_value::sfbool_id,
+                               "directOutput"),
+                node_interface(node_interface::field_id,
+                               field_value::sfbool_id,
+                               "mustEvaluate"),
+                node_interface(node_interface::exposedfield_id,
+                               field_value::mfstring_id,
+                               "url")
+            };
+            node_type =
+                &(*this->scope_stack_.top().script_node_types.insert(
+                      make_pair(std::string("Script"),
+                                node_interface_set(script_node_interfaces,
+                                                   script_node_interfaces
+                                                   + 3))));
+        } else {
+            node_type = find_node_type(this->scope_stack_, node_type_id);
+            if (!node_type) {
+                this->fail(openvrml::unknown_node_type_id, node_type_id);
+            }
+        }
+        const bool script = node_type->first == "Script";
+
+        if (!node_name_id.empty()) {
+            this->scope_stack_.top().defs[node_name_id] = node_type;
+        }
+
+        this->actions_.on_node_start(node_name_id, node_type->first);
+
+        //
+        // IS mappings are collected first so that a Script field can be
+        // mapped where it is declared.
+        //
+        std::map<std::string, std::string> connects;
+        for (fi_element::children_t::const_iterator child =
+                 e.children.begin();
+             child != e.children.end();
+             ++child) {
+            if (child->name == "ProtoDeclare") {
+                this->proto(*child);
+            } else if (child->name == "ExternProtoDeclare") {
+                this->externproto(*child);
+            } else if (child->name == "IS") {
+                if (!in_proto_def(this->scope_stack_)) {
+                    this->fail(openvrml::incompatible_proto_interface,
+                               node_type->first);
+                }
+                for (fi_element::children_t::const_iterator connect =
+                         child->children.begin();
+                     connect != child->children.end();
+                     ++connect) {
+                    if (connect->name != "connect") { continue; }
+                    const std::string node_field =
+                        this->attribute(*connect, "nodeField");
+                    if (!connects.insert(
+                            make_pair(node_field,
+                                      this->attribute(*connect,
+                                                      "protoField")))
+                        .second) {
+                        this->fail(openvrml::interface_collision,
+                                   node_field);
+                    }
+                }
+            }
+        }
+
+        std::set<std::string> fields;
+        if (script) {
+            for (fi_element::children_t::const_iterator child =
+                     e.children.begin();
+                 child != e.children.end();
+                 ++child) {
+                if (child->name != "field") { continue; }
+                this->script_interface(*child, *node_type, connects);
+                fields.insert(this->attribute(*child, "name"));
+            }
+        }
+
+        for (fi_element::attributes_t::const_iterator attr =
+                 e.attributes.begin();
+             attr != e.attributes.end();
+             ++attr) {
+            if (attr->name == "DEF" || attr->name == "USE"
+                || attr->name == "containerField" || attr->name == "class"
+                || attr->name == "id" || attr->name == "style"
+                || (e.name == "ProtoInstance" && attr->name == "name")) {
+                continue;
+            }
+            const node_interface & interface_ =
+                this->field_start(*node_type, attr->name, fields);
+            this->field_value(interface_.field_type, attr->value,
+                              attr->name);
+        }
+
+        for (fi_element::children_t::const_iterator child =
+                 e.children.begin();
+             child != e.children.end();
+             ++child) {
+            if (child->name != "fieldValue") { continue; }
+            const std::string id = this->attribute(*child, "name");
+            const node_interface & interface_ =
+                this->field_start(*node_type, id, fields);
+            std::vector<const fi_element *> nodes;
+            for (fi_element::children_t::const_iterator n =
+                     child->children.begin();
+                 n != child->children.end();
+                 ++n) {
+                nodes.push_back(&*n);
+            }
+            const fi_attribute * const value = child->attribute("value");
+            if (value) {
+                this->field_value(interface_.field_type, value->value, id);
+            } else {
+                this->node_field_value(interface_.field_type, nodes, id);
+            }
+        }
+
+        for (std::map<std::string, std::string>::const_iterator connect =
+                 connects.begin();
+             connect != connects.end();
+             ++connect) {
+            const node_interface & interface_ =
+                this->field_start(*node_type, connect->first, fields);
+            this->is_mapping(interface_, connect->second);
+        }
+
+        //
+        // Child nodes are grouped by the field they go in, in the order in
+        // which each field first appears.
+        //
+        typedef std::vector<std::pair<std::string,
+                                      std::vector<const fi_element *> > >
+            containers_t;
+        containers_t containers;
+        for (fi_element::children_t::const_iterator child =
+                 e.children.begin();
+             child != e.children.end();
+             ++child) {
+            if (!node_element(*child)) { continue; }
+            const std::string id = this->container_field(*node_type, *child);
+            containers_t::iterator container = containers.begin();
+            while (container != containers.end() && container->first != id) {
+                ++container;
+            }
+            if (container == containers.end()) {
+                containers.push_back(
+                    make_pair(id, std::vector<const fi_element *>()));
+                container = containers.end() - 1;
+            }
+            container->second.push_back(&*child);
+        }
+        for (containers_t::const_iterator container = containers.begin();
+             container != containers.end();
+             ++container) {
+            const node_interface & interface_ =
+                this->field_start(*node_type, container->first, fields);
+            this->node_field_value(interface_.field_type,
+                                   container->second,
+                                   container->first);
+        }
+
+        //
+        // A Script's code may be given as the element's content rather than
+        // in the url attribute.
+        //
+        if (script && fields.find("url") == fields.end()) {
+            const std::string code = boost::algorithm::trim_copy(e.text);
+            if (!code.empty()) {
+                this->field_start(*node_type, "url", fields);
+                this->actions_.on_mfstring(std::vector<std::string>(1, code));
+            }
+        }
+
+        for (fi_element::children_t::const_iterator child =
+                 e.children.begin();
+             child != e.children.end();
+             ++child) {
+            if (child->name == "ROUTE") { this->route(*child); }
+        }
+
+        this->actions_.on_node_finish();
+    }
+
+    void x3db_builder::
+    script_interface(const fi_element & e,
+                     node_type_decls::value_type & node_type,
+                     std::map<std::string, std::string> & connects)
+    {
+        node_interface interface_;
+        this->interface_decl(e, interface_, true);
+        if (!node_type.second.insert(interface_).second) {
+            this->fail(openvrml::interface_collision, interface_.id);
+        }
+
+        this->actions_.on_script_interface_decl(interface_);
+
+        const std::map<std::string, std::string>::iterator connect =
+            connects.find(interface_.id);
+        if (connect != connects.end()) {
+            this->is_mapping(interface_, connect->second);
+            connects.erase(connect);
+        } else if (interface_.type == node_interface::field_id) {
+            const fi_attribute * const value = e.attribute("value");
+            if (value) {
+                this->field_value(interface_.field_type, value->value,
+                                  interface_.id);
+            } else {
+                std::vector<const fi_element *> nodes;
+                for (fi_element::children_t::const_iterator n =
+                         e.children.begin();
+                     n != e.children.end();
+                     ++n) {
+                    nodes.push_back(&*n);
+                }
+                this->node_field_value(interface_.field_type, nodes,
+                                       interface_.id);
+            }
+        }
+    }
+
+    const node_interface &
+    x3db_builder::field_start(const node_type_decls::value_type & node_type,
+                              const std::string & id,
+                              std::set<std::string> & fields)
+    {
+        const node_interface_set::const_iterator interface_ =
+            find_interface(node_type.second, id);
+        if (interface_ == node_type.second.end()) {
+            this->fail(openvrml::unknown_node_interface_id, id);
+        }
+        if (!fields.insert(id).second) {
+            this->fail(openvrml::interface_collision, id);
+        }
+        this->actions_.on_field_start(id, interface_->field_type);
+        return *interface_;
+    }
+
+    //
+    // An exposedField in the PROTO implementation can be IS'd to any type of
+    // interface; otherwise the interface types must agree.
+    //
+    void x3db_builder::is_mapping(const node_interface & impl_interface,
+                                  const std::string & proto_interface_id)
+    {
+        const node_interface_set & proto_interfaces =
+            this->scope_stack_.top().proto_node_type->second;
+        const node_interface_set::const_iterator proto_interface =
+            find_interface(proto_interfaces, proto_interface_id);
+        if (proto_interface == proto_interfaces.end()
+            || proto_interface->field_type != impl_interface.field_type
+            || !(impl_interface.type == node_interface::exposedfield_id
+                 || proto_interface->type == impl_interface.type)) {
+            this->fail(openvrml::incompatible_proto_interface,
+                       proto_interface_id);
+        }
+        this->actions_.on_is_mapping(proto_interface->id);
+    }
+
+    //
+    // The field a child node goes in: its containerField attribute if it has
+    // one; otherwise the node type's default, if the parent has that field;
+    // otherwise "children", if the parent has that field; otherwise the
+    // parent's only node field, not counting "metadata".
+    //
+    const std::string
+    x3db_builder::container_field(const node_type_decls::value_type & node_type,
+                                  const fi_element & child) const
+    {
+        const std::string container = this->attribute(child, "containerField");
+        if (!container.empty()) { return container; }
+
+        const node_interface_set & interfaces = node_type.second;
+        for (std::size_t i = 0;
+             i < sizeof default_container_fields
+                 / sizeof default_container_fields[0];
+             ++i) {
+            if (child.name != default_container_fields[i].node_type_id) {
+                continue;
+            }
+            const node_interface_set::const_iterator interface_ =
+                find_interface(interfaces,
+                               default_container_fields[i].field_id);
+            if (interface_ != interfaces.end() && node_field(*interface_)) {
+                return interface_->id;
+            }
+            break;
+        }
+
+        const node_interface_set::const_iterator children =
+            find_interface(interfaces, "children");
+        if (children != interfaces.end() && node_field(*children)) {
+            return children->id;
+        }
+
+        const node_interface * only = 0;
+        for (node_interface_set::const_iterator interface_ =
+                 interfaces.begin();
+             interface_ != interfaces.end();
+             ++interface_) {
+            if (!node_field(*interface_) || interface_->id == "metadata") {
+                continue;
+            }
+            if (only) {
+                this->fail(openvrml::unknown_node_interface_id, child.name);
+            }
+            only = &*interface_;
+        }
+        if (!only) {
+            this->fail(openvrml::unknown_node_interface_id, child.name);
+        }
+        return only->id;
+    }
+
+    template <typename T, typename Action>
+    void x3db_builder::sf(const fi_string & value,
+                          const vrml_parse_error error,
+                          const std::string & context,
+                          const Action & action)
+    {
+        typedef typename value_traits<T>::number_type number_type;
+        std::vector<number_type> numbers;
+        if (!read_numbers(value, numbers)
+            || numbers.size() != value_traits<T>::components) {
+            this->fail(error, context);
+        }
+        T result;
+        convert(&numbers.front(), result);
+        this->check_value(result, context);
+        action(result);
+    }
+
+    template <typename T, typename Action>
+    void x3db_builder::mf(const fi_string & value,
+                          const vrml_parse_error error,
+                          const std::string & context,
+                          const Action & action)
+    {
+        typedef typename value_traits<T>::number_type number_type;
+        static const std::size_t components = value_traits<T>::components;
+        std::vector<number_type> numbers;
+        if (!read_numbers(value, numbers)
+            || numbers.size() % components != 0) {
+            this->fail(error, context);
+        }
+        std::vector<T> result(numbers.size() / components);
+        for (std::size_t i = 0; i < result.size(); ++i) {
+            convert(&numbers[i * components], result[i]);
+            this->check_value(result[i], context);
+        }
+        action(result);
+    }
+
+    void x3db_builder::check_value(const openvrml::rotation & value,
+                                   const std::string & context) const
+    {
+        using openvrml::local::fequal;
+        const float length = float(std::sqrt(value.x() * value.x()
+                                             + value.y() * value.y()
+                                             + value.z() * value.z()));
+        if (!fequal(length, 1.0f)) {
+            this->warn(openvrml::rotation_axis_not_normalized, context);
+        }
+    }
+
+    void x3db_builder::field_value(const field_value::type_id type,
+                                   const fi_string & value,
+                                   const std::string & context)
+    {
+        using namespace openvrml;
+
+        switch (type) {
+        case field_value::sfbool_id:
+            {
+                std::vector<bool> values;
+                if (!read_booleans(value, values) || values.size() != 1) {
+                    this->fail(bool_expected, context);
+                }
+                this->actions_.on_sfbool(values.front());
+            }
+            break;
+        case field_value::sfcolor_id:
+            this->sf<color>(value, color_expected, context,
+                            this->actions_.on_sfcolor);
+            break;
+        case field_value::sfcolorrgba_id:
+            this->sf<color_rgba>(value, color_rgba_expected, context,
+                                 this->actions_.on_sfcolorrgba);
+            break;
+        case field_value::sfdouble_id:
+            this->sf<double>(value, float_expected, context,
+                             this->actions_.on_sfdouble);
+            break;
+        case field_value::sffloat_id:
+            this->sf<float>(value, float_expected, context,
+                            this->actions_.on_sffloat);
+            break;
+        case field_value::sfimage_id:
+            {
+                std::vector<int32> numbers;
+                std::size_t pos = 0;
+                image result;
+                if (!(read_numbers(value, numbers)
+                      && read_image(numbers, pos, result)
+                      && pos == numbers.size())) {
+                    this->fail(int32_expected, context);
+                }
+                this->actions_.on_sfimage(result);
+            }
+            break;
+        case field_value::sfint32_id:
+            this->sf<int32>(value, int32_expected, context,
+                            this->actions_.on_sfint32);
+            break;
+        case field_value::sfnode_id:
+        case field_value::mfnode_id:
+            {
+                //
+                // Nodes are child elements; an attribute can only say that
+                // there are none.
+                //
+                const std::string & str = this->text(value, context);
+                const std::string null = boost::algorithm::trim_copy(str);
+                if (!(null.empty() || null == "NULL")) {
+                    this->fail(node_expected, context);
+                }
+                this->node_field_value(type,
+                                       std::vector<const fi_element *>(),
+                                       context);
+            }
+            break;
+        case field_value::sfrotation_id:
+            this->sf<rotation>(value, rotation_expected, context,
+                               this->actions_.on_sfrotation);
+            break;
+        case field_value::sfstring_id:
+            this->actions_.on_sfstring(this->text(value, context));
+            break;
+        case field_value::sftime_id:
+            this->sf<double>(value, float_expected, context,
+                             this->actions_.on_sftime);
+            break;
+        case field_value::sfvec2d_id:
+            this->sf<vec2d>(value, vec2_expected, context,
+                            this->actions_.on_sfvec2d);
+            break;
+        case field_value::sfvec2f_id:
+            this->sf<vec2f>(value, vec2_expected, context,
+                            this->actions_.on_sfvec2f);
+            break;
+        case field_value::sfvec3d_id:
+            this->sf<vec3d>(value, vec3_expected, context,
+                            this->actions_.on_sfvec3d);
+            break;
+        case field_value::sfvec3f_id:
+            this->sf<vec3f>(value, vec3_expected, context,
+                            this->actions_.on_sfvec3f);
+            break;
+        case field_value::mfbool_id:
+            {
+                std::vector<bool> values;
+                if (!read_booleans(value, values)) {
+                    this->fail(bool_or_rbracket_expected, context);
+                }
+                this->actions_.on_mfbool(values);
+            }
+            break;
+        case field_value::mfcolor_id:
+            this->mf<color>(value, color_or_rbracket_expected, context,
+                            this->actions_.on_mfcolor);
+            break;
+        case field_value::mfcolorrgba_id:
+            this->mf<color_rgba>(value, color_rgba_or_rbracket_expected,
+                                 context, this->actions_.on_mfcolorrgba);
+            break;
+        case field_value::mfdouble_id:
+            this->mf<double>(value, float_or_rbracket_expected, context,
+                             this->actions_.on_mfdouble);
+            break;
+        case field_value::mffloat_id:
+            this->mf<float>(value, float_or_rbracket_expected, context,
+                            this->actions_.on_mffloat);
+            break;
+        case field_value::mfimage_id:
+            {
+                std::vector<int32> numbers;
+                if (!read_numbers(value, numbers)) {
+                    this->fail(int32_or_rbracket_expected, context);
+                }
+                std::vector<image> values;
+                for (std::size_t pos = 0; pos != numbers.size();) {
+                    values.push_back(image());
+                    if (!read_image(numbers, pos, values.back())) {
+                        this->fail(int32_or_rbracket_expected, context);
+                    }
+                }
+                this->actions_.on_mfimage(values);
+            }
+            break;
+        case field_value::mfint32_id:
+            this->mf<int32>(value, int32_or_rbracket_expected, context,
+                            this->actions_.on_mfint32);
+            break;
+        case field_value::mfrotation_id:
+            this->mf<rotation>(value, rotation_or_rbracket_expected, context,
+                               this->actions_.on_mfrotation);
+            break;
+        case field_value::mfstring_id:
+            {
+                std::vector<std::string> values;
+                if (!read_strings(value, values)) {
+                    this->fail(string_or_rbracket_expected, context);
+                }
+                this->actions_.on_mfstring(values);
+            }
+            break;
+        case field_value::mftime_id:
+            this->mf<double>(value, float_or_rbracket_expected, context,
+                             this->actions_.on_mftime);
+            break;
+        case field_value::mfvec2d_id:
+            this->mf<vec2d>(value, vec2_or_rbracket_expected, context,
+                            this->actions_.on_mfvec2d);
+            break;
+        case field_value::mfvec2f_id:
+            this->mf<vec2f>(value, vec2_or_rbracket_expected, context,
+                            this->actions_.on_mfvec2f);
+            break;
+        case field_value::mfvec3d_id:
+            this->mf<vec3d>(value, vec3_or_rbracket_expected, context,
+                            this->actions_.on_mfvec3d);
+            break;
+        case field_value::mfvec3f_id:
+            this->mf<vec3f>(value, vec3_or_rbracket_expected, context,
+                            this->actions_.on_mfvec3f);
+            break;
+        default:
+            assert(false);
+        }
+    }
+
+    void x3db_builder::
+    node_field_value(const field_value::type_id type,
+                     const std::vector<const fi_element *> & nodes,
+                     const std::string & context)
+    {
+        if (type == field_value::sfnode_id) {
+            if (nodes.size() > 1) {
+                this->fail(openvrml::interface_collision, context);
+            }
+            if (!nodes.empty()) { this->node_statement(*nodes.front()); }
+            this->actions_.on_sfnode(nodes.empty());
+        } else if (type == field_value::mfnode_id) {
+            for (std::vector<const fi_element *>::const_iterator n =
+                     nodes.begin();
+                 n != nodes.end();
+                 ++n) {
+                this->node_statement(**n);
+            }
+            this->actions_.on_mfnode();
+        } else {
+            this->fail(openvrml::unknown_node_interface_id, context);
+        }
+    }
+}
+
+/**
+ * @internal
+ *
+ * @brief Parse an X3D world in the Compressed Binary Encoding.
+ *
+ * The encoding is the X3D XML encoding serialized as a Fast Infoset
+ * document (see @c read_fast_infoset).  The document is decoded in full and
+ * then walked to drive the same semantic actions, with the same node type
+ * and <code>DEF</code> scoping rules, as the Classic VRML encoding.
+ *
+ * Field values may be text, as in the XML encoding, or encoded with the
+ * Fast Infoset built-in numeric and boolean encoding algorithms.  When
+ * OpenVRML is built with zlib, the X3D quantized float array and delta
+ * integer array encodings are also accepted.
+ *
+ * @param[in]  begin    the beginning of the data.
+ * @param[in]  end      the end of the data.
+ * @param[in]  uri      the URI of the data.
+ * @param[in]  scene    the @c scene.
+ * @param[out] nodes    the root @c node%s.
+ * @param[out] meta     the @c scene metadata.
+ *
+ * @exception openvrml::invalid_vrml    if the data is not a valid world.
+ * @exception std::bad_alloc            if memory allocation fails.
+ */
+void
+openvrml::local::
+parse_x3db(const char * const begin,
+           const char * const end,
+           const std::string & uri,
+           const openvrml::scene & scene,
+           std::vector<boost::intrusive_ptr<openvrml::node> > & nodes,
+           std::map<std::string, std::string> & meta)
+{
+    std::auto_ptr<fi_element> document;
+    try {
+        document = read_fast_infoset(begin, end);
+    } catch (const fast_infoset_error & ex) {
+        throw invalid_vrml(uri, 0, 0, ex.what());
+    }
+    x3d_vrml_parse_actions actions(uri, scene, nodes, meta);
+    x3db_builder builder(actions, scene.browser(), uri);
+    builder.build(*document);
+}
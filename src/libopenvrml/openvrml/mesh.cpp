@@ -0,0 +1,1314 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# include "mesh.h"
+# include <openvrml/node.h>
+# include <openvrml/local/compute_executor.h>
+# include <openvrml/local/float.h>
+# include <openvrml/local/worker_scope.h>
+# include <algorithm>
+# include <cassert>
+# include <cmath>
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+/**
+ * @file openvrml/mesh.h
+ *
+ * @brief Renderer-independent preparation of polygon meshes.
+ */
+
+namespace {
+
+    //
+    // Below this many faces, the cost of handing out the work outweighs
+    // that of computing the normals.
+    //
+    const std::size_t min_concurrent_faces = 4096;
+
+    /**
+     * @internal
+     *
+     * @brief Call @p function for every face, on several threads if there
+     *        are enough faces to make that worthwhile.
+     *
+     * The work is shared between the calling thread and the workers of the
+     * current @c local::compute_executor.  Without one, or on a thread in a
+     * @c local::worker_scope, all of the work is done on the calling thread.
+     *
+     * @param[in] faces     the number of faces.
+     * @param[in] function  a function object called with a range of faces.
+     *
+     * @exception std::bad_alloc    if memory allocation fails.
+     */
+    template <typename Function>
+    OPENVRML_LOCAL void for_each_face_batch(const std::size_t faces,
+                                            Function & function)
+    {
+        using openvrml::local::compute_executor;
+        compute_executor * const executor = compute_executor::current();
+        if (!executor
+            || executor->threads() == 0
+            || faces < min_concurrent_faces
+            || openvrml::local::worker_scope::active()) {
+            function(0, faces);
+            return;
+        }
+
+        //
+        // Several batches per thread, so that the threads finish at about
+        // the same time.
+        //
+        const std::size_t threads = executor->threads() + 1;
+        openvrml::local::for_each_batch(*executor,
+                                        faces,
+                                        faces / (threads * 4) + 1,
+                                        threads - 1,
+                                        function);
+    }
+
+    const std::size_t npos = std::size_t(-1);
+
+    /**
+     * @internal
+     *
+     * @brief A polygon mesh given as coordinates and coordinate indices, with
+     *        the adjacency information needed to smooth its normals.
+     */
+    struct OPENVRML_LOCAL polygon_mesh : boost::noncopyable {
+        const std::vector<openvrml::vec3f> & coord;
+        const std::vector<openvrml::int32> & coord_index;
+
+        //
+        // The corners of face f are coord_index[face_begin[f]] up to
+        // coord_index[face_end[f]].
+        //
+        std::vector<std::size_t> face_begin, face_end;
+
+        //
+        // The face to which each element of coord_index belongs; npos for
+        // the -1 separators.
+        //
+        std::vector<std::size_t> corner_face;
+
+        //
+        // Face normals computed with Newell's method.  Their length is
+        // proportional to the area of the face, so they weight the
+        // contribution of each face to a vertex normal.
+        //
+        std::vector<openvrml::vec3f> area_normal, unit_normal;
+
+        //
+        // Coincident coordinates are welded into a position; position[v] is
+        // the smallest index of a coordinate coincident with coord[v].
+        //
+        std::vector<std::size_t> position;
+
+        //
+        // The corners at each position, in compressed sparse row form: the
+        // corners at position p are position_corner[position_begin[p]] up
+        // to position_corner[position_begin[p + 1]].
+        //
+        std::vector<std::size_t> position_begin, position_corner;
+
+        polygon_mesh(const std::vector<openvrml::vec3f> & coord,
+                     const std::vector<openvrml::int32> & coord_index)
+            OPENVRML_THROW1(std::bad_alloc);
+
+        bool valid_corner(std::size_t corner) const OPENVRML_NOTHROW;
+        void compute_face_normals(std::size_t begin, std::size_t end)
+            OPENVRML_NOTHROW;
+        void weld_positions() OPENVRML_THROW1(std::bad_alloc);
+    };
+
+    /**
+     * @brief Construct.
+     *
+     * Divides @p coord_index into faces.  Runs of more than one -1 are
+     * tolerated, and the last face need not be terminated with -1.
+     *
+     * @param[in] coord         coordinates.
+     * @param[in] coord_index   coordinate indices.
+     *
+     * @exception std::bad_alloc    if memory allocation fails.
+     */
+    polygon_mesh::polygon_mesh(const std::vector<openvrml::vec3f> & coord,
+                               const std::vector<openvrml::int32> & coord_index)
+        OPENVRML_THROW1(std::bad_alloc):
+        coord(coord),
+        coord_index(coord_index),
+        corner_face(coord_index.size(), npos)
+    {
+        std::size_t begin = 0;
+        for (std::size_t i = 0; i <= coord_index.size(); ++i) {
+            if (i < coord_index.size() && coord_index[i] != -1) { continue; }
+            if (i > begin) {
+                std::fill(this->corner_face.begin() + begin,
+                          this->corner_face.begin() + i,
+                          this->face_begin.size());
+                this->face_begin.push_back(begin);
+                this->face_end.push_back(i);
+            }
+            begin = i + 1;
+        }
+        this->area_normal.resize(this->face_begin.size());
+        this->unit_normal.resize(this->face_begin.size());
+    }
+
+    /**
+     * @brief Whether a corner refers to an existing coordinate.
+     *
+     * @param[in] corner    an index into @c #coord_index.
+     *
+     * @return @c true if @p corner refers to an element of @c #coord;
+     *         @c false otherwise.
+     */
+    bool polygon_mesh::valid_corner(const std::size_t corner) const
+        OPENVRML_NOTHROW
+    {
+        return this->coord_index[corner] >= 0
+            && std::size_t(this->coord_index[corner]) < this->coord.size();
+    }
+
+    /**
+     * @brief Compute the normals of a range of faces.
+     *
+     * Corners that do not refer to an existing coordinate are left out.
+     *
+     * @param[in] begin the first face.
+     * @param[in] end   one past the last face.
+     */
+    void polygon_mesh::compute_face_normals(const std::size_t begin,
+                                            const std::size_t end)
+        OPENVRML_NOTHROW
+    {
+        using openvrml::vec3f;
+        using openvrml::make_vec3f;
+
+        for (std::size_t f = begin; f < end; ++f) {
+            float n[3] = { 0.0f, 0.0f, 0.0f };
+            std::size_t first = npos, prev = npos;
+            for (std::size_t i = this->face_begin[f];
+                 i <= this->face_end[f];
+                 ++i) {
+                std::size_t current;
+                if (i < this->face_end[f]) {
+                    if (!this->valid_corner(i)) { continue; }
+                    current = std::size_t(this->coord_index[i]);
+                    if (first == npos) { first = current; }
+                } else {
+                    current = first;
+                }
+                if (prev != npos && current != npos) {
+                    const vec3f & a = this->coord[prev];
+                    const vec3f & b = this->coord[current];
+                    n[0] += (a.y() - b.y()) * (a.z() + b.z());
+                    n[1] += (a.z() - b.z()) * (a.x() + b.x());
+                    n[2] += (a.x() - b.x()) * (a.y() + b.y());
+                }
+                prev = current;
+            }
+            this->area_normal[f] = make_vec3f(n[0], n[1], n[2]);
+            this->unit_normal[f] = this->area_normal[f].normalize();
+        }
+    }
+
+    /**
+     * @internal
+     *
+     * @brief Function object computing the normals of a range of faces.
+     */
+    struct OPENVRML_LOCAL compute_face_normals_ {
+        explicit compute_face_normals_(polygon_mesh & mesh) OPENVRML_NOTHROW:
+            mesh_(mesh)
+        {}
+
+        void operator()(const std::size_t begin, const std::size_t end) const
+            OPENVRML_NOTHROW
+        {
+            this->mesh_.compute_face_normals(begin, end);
+        }
+
+    private:
+        polygon_mesh & mesh_;
+    };
+
+    /**
+     * @brief Weld coincident coordinates and find the corners at each
+     *        position.
+     *
+     * Coordinates are welded if they are within a small distance, relative
+     * to the extent of the mesh, of one another.  They are found with a
+     * spatial hash whose cells are as wide as that distance, so only the
+     * 27 cells around a coordinate need to be searched.
+     *
+     * @exception std::bad_alloc    if memory allocation fails.
+     */
+    void polygon_mesh::weld_positions() OPENVRML_THROW1(std::bad_alloc)
+    {
+        using std::vector;
+        using openvrml::vec3f;
+
+        const std::size_t n = this->coord.size();
+        this->position.resize(n);
+
+        float min[3] = {}, max[3] = {};
+        for (std::size_t v = 0; v < n; ++v) {
+            for (std::size_t k = 0; k < 3; ++k) {
+                const float c = this->coord[v][k];
+                if (v == 0 || c < min[k]) { min[k] = c; }
+                if (v == 0 || c > max[k]) { max[k] = c; }
+            }
+        }
+        const float extent = (std::max)((std::max)(max[0] - min[0],
+                                                   max[1] - min[1]),
+                                        max[2] - min[2]);
+        static const float relative_tolerance = 1.0e-6f;
+        const float tolerance = extent * relative_tolerance;
+        const float cell = (tolerance > 0.0f) ? tolerance : 1.0f;
+
+        std::size_t buckets = 1;
+        while (buckets < 2 * n) { buckets *= 2; }
+        vector<std::size_t> head(buckets, npos), next(n, npos);
+
+        for (std::size_t v = 0; v < n; ++v) {
+            const vec3f & p = this->coord[v];
+            long c[3];
+            for (std::size_t k = 0; k < 3; ++k) {
+                c[k] = long(std::floor((p[k] - min[k]) / cell));
+            }
+
+            this->position[v] = v;
+            for (long dx = -1; dx <= 1 && this->position[v] == v; ++dx) {
+                for (long dy = -1; dy <= 1 && this->position[v] == v; ++dy) {
+                    for (long dz = -1;
+                         dz <= 1 && this->position[v] == v;
+                         ++dz) {
+                        const std::size_t bucket =
+                            (std::size_t(c[0] + dx) * 73856093ul
+                             ^ std::size_t(c[1] + dy) * 19349663ul
+                             ^ std::size_t(c[2] + dz) * 83492791ul)
+                            & (buckets - 1);
+                        for (std::size_t u = head[bucket];
+                             u != npos;
+                             u = next[u]) {
+                            const vec3f d = this->coord[u] - p;
+                            if (d.dot(d) <= tolerance * tolerance) {
+                                this->position[v] = this->position[u];
+                                break;
+                            }
+                        }
+                    }
+                }
+            }
+
+            const std::size_t bucket =
+                (std::size_t(c[0]) * 73856093ul
+                 ^ std::size_t(c[1]) * 19349663ul
+                 ^ std::size_t(c[2]) * 83492791ul)
+                & (buckets - 1);
+            next[v] = head[bucket];
+            head[bucket] = v;
+        }
+
+        this->position_begin.assign(n + 1, 0);
+        for (std::size_t i = 0; i < this->coord_index.size(); ++i) {
+            if (!this->valid_corner(i)) { continue; }
+            const std::size_t v = std::size_t(this->coord_index[i]);
+            ++this->position_begin[this->position[v] + 1];
+        }
+        for (std::size_t p = 0; p < n; ++p) {
+            this->position_begin[p + 1] += this->position_begin[p];
+        }
+        this->position_corner.resize(this->position_begin[n]);
+        vector<std::size_t> fill(this->position_begin.begin(),
+                                 this->position_begin.end() - 1);
+        for (std::size_t i = 0; i < this->coord_index.size(); ++i) {
+            if (!this->valid_corner(i)) { continue; }
+            const std::size_t v = std::size_t(this->coord_index[i]);
+            this->position_corner[fill[this->position[v]]++] = i;
+        }
+    }
+
+    /**
+     * @internal
+     *
+     * @brief Function object computing the vertex normals at the corners of
+     *        a range of faces.
+     *
+     * The normal at a corner is the area-weighted average of the normals of
+     * the faces sharing its position whose normals are within the crease
+     * angle of its own face's normal.  Each face writes only its own
+     * corners, so ranges of faces can be processed concurrently.
+     */
+    class OPENVRML_LOCAL smooth_corner_normals {
+        const polygon_mesh & mesh_;
+        const float cos_crease_;
+        const bool ccw_;
+        std::vector<openvrml::vec3f> & normal_;
+        const std::vector<openvrml::int32> & normal_index_;
+
+    public:
+        smooth_corner_normals(const polygon_mesh & mesh,
+                              float cos_crease,
+                              bool ccw,
+                              std::vector<openvrml::vec3f> & normal,
+                              const std::vector<openvrml::int32> & normal_index)
+            OPENVRML_NOTHROW;
+
+        void operator()(std::size_t begin, std::size_t end) const
+            OPENVRML_NOTHROW;
+    };
+
+    smooth_corner_normals::
+    smooth_corner_normals(const polygon_mesh & mesh,
+                          const float cos_crease,
+                          const bool ccw,
+                          std::vector<openvrml::vec3f> & normal,
+                          const std::vector<openvrml::int32> & normal_index)
+        OPENVRML_NOTHROW:
+        mesh_(mesh),
+        cos_crease_(cos_crease),
+        ccw_(ccw),
+        normal_(normal),
+        normal_index_(normal_index)
+    {}
+
+    void smooth_corner_normals::operator()(const std::size_t begin,
+                                           const std::size_t end) const
+        OPENVRML_NOTHROW
+    {
+        using openvrml::vec3f;
+        using openvrml::make_vec3f;
+
+        const polygon_mesh & m = this->mesh_;
+        for (std::size_t f = begin; f < end; ++f) {
+            const vec3f & face_normal = m.unit_normal[f];
+            for (std::size_t i = m.face_begin[f]; i < m.face_end[f]; ++i) {
+                vec3f n = face_normal;
+                if (m.valid_corner(i)) {
+                    const std::size_t p =
+                        m.position[std::size_t(m.coord_index[i])];
+                    vec3f sum = make_vec3f();
+                    for (std::size_t j = m.position_begin[p];
+                         j < m.position_begin[p + 1];
+                         ++j) {
+                        const std::size_t g = m.corner_face[
+                            m.position_corner[j]];
+                        if (g == f || face_normal.dot(m.unit_normal[g])
+                                      >= this->cos_crease_) {
+                            sum += m.area_normal[g];
+                        }
+                    }
+                    if (sum != make_vec3f()) { n = sum.normalize(); }
+                }
+                this->normal_[std::size_t(this->normal_index_[i])] =
+                    this->ccw_ ? n : -n;
+            }
+        }
+    }
+
+    /**
+     * @internal
+     *
+     * @brief Function object copying the face normal to the corners of a
+     *        range of faces.
+     */
+    class OPENVRML_LOCAL flat_corner_normals {
+        const polygon_mesh & mesh_;
+        const bool ccw_;
+        std::vector<openvrml::vec3f> & normal_;
+        const std::vector<openvrml::int32> & normal_index_;
+
+    public:
+        flat_corner_normals(const polygon_mesh & mesh,
+                            bool ccw,
+                            std::vector<openvrml::vec3f> & normal,
+                            const std::vector<openvrml::int32> & normal_index)
+            OPENVRML_NOTHROW;
+
+        void operator()(std::size_t begin, std::size_t end) const
+            OPENVRML_NOTHROW;
+    };
+
+    flat_corner_normals::
+    flat_corner_normals(const polygon_mesh & mesh,
+                        const bool ccw,
+                        std::vector<openvrml::vec3f> & normal,
+                        const std::vector<openvrml::int32> & normal_index)
+        OPENVRML_NOTHROW:
+        mesh_(mesh),
+        ccw_(ccw),
+        normal_(normal),
+        normal_index_(normal_index)
+    {}
+
+    void flat_corner_normals::operator()(const std::size_t begin,
+                                         const std::size_t end) const
+        OPENVRML_NOTHROW
+    {
+        const polygon_mesh & m = this->mesh_;
+        for (std::size_t f = begin; f < end; ++f) {
+            for (std::size_t i = m.face_begin[f]; i < m.face_end[f]; ++i) {
+                this->normal_[std::size_t(this->normal_index_[i])] =
+                    this->ccw_ ? m.unit_normal[f] : -m.unit_normal[f];
+            }
+        }
+    }
+
+    /**
+     * @brief Get the length of an Extrusion spine.
+     *
+     * The length of the spine is used in computing texture coordinates for an
+     * Extrusion.  In order to determine the texture coordinates at a given
+     * point on the Extrusion cross-section, the distance from the start of
+     * the spine is divided by its total length.  As such, this function
+     * returns 1.0 if the length of the spine is 0 (to avoid dividing by
+     * zero).
+     *
+     * @param[in] spine Extrusion spine.
+     *
+     * @return the length of the Extrusion spine described by @p spine; or 1.0
+     *         if the length is 0.
+     */
+    OPENVRML_LOCAL
+    float get_spine_length(const std::vector<openvrml::vec3f> & spine)
+    {
+        using std::vector;
+        using openvrml::vec3f;
+
+        float result = 0.0;
+        for (vector<vec3f>::const_iterator point = spine.begin();
+             point < spine.end() - 1;
+             ++point) {
+            result += (*(point + 1) - *point).length();
+        }
+        return result == 0.0f ? 1.0f : result;
+    }
+
+    /**
+     * @brief Get the length of an Extrusion cross-section.
+     *
+     * The length of the cross-section is used in computing texture
+     * coordinates for an Extrusion.  In order to determine the texture
+     * coordinates at a given point on the Extrusion cross-section, the
+     * distance from the start of the cross-section is divided by its total
+     * length.  As such, this function returns 1.0 if the length of the
+     * cross-section is 0 (to avoid dividing by zero).
+     *
+     * @param[in] cross_section Extrusion cross-section.
+     *
+     * @return the length of the Extrusion cross-section described by
+     *         @p cross_section; or 1.0 if the length is 0.
+     */
+    OPENVRML_LOCAL
+    float
+    get_cross_section_length(
+        const std::vector<openvrml::vec2f> & cross_section)
+    {
+        using std::vector;
+        using openvrml::vec2f;
+
+        float result = 0.0;
+        for (vector<vec2f>::const_iterator point = cross_section.begin();
+             point != cross_section.end() - 1;
+             ++point) {
+            result += (*(point + 1) - *point).length();
+        }
+        return result == 0.0f ? 1.0f : result;
+    }
+
+    /**
+     * @brief Compute the <var>y</var>-axis of the spine-aligned cross-section
+     *        plane.
+     *
+     * @param[in] point an arbitrary point in the extrusion spine.
+     * @param[in] first the first point in the extrusion spine.
+     * @param[in] last  the last point in the extrusion spine.
+     *
+     * @return the <var>y</var>-axis of the spine-aligned cross-section plane
+     *         at @p point.
+     */
+    OPENVRML_LOCAL
+    const openvrml::vec3f
+    compute_scp_y_axis(
+        const std::vector<openvrml::vec3f>::const_iterator & point,
+        const std::vector<openvrml::vec3f>::const_iterator & first,
+        const std::vector<openvrml::vec3f>::const_iterator & last,
+        const openvrml::vec3f & prev)
+    {
+        if (point != first && point != last) {
+            if (*point == *(point - 1)) { return prev; }
+            return (*(point + 1) - *(point - 1)).normalize();
+        }
+
+        //
+        // From here on, we're dealing with the first or last point.
+        //
+        const bool spine_closed = (*first == *last);
+
+        if (spine_closed) {
+            return (*(first + 1) - *(last - 1)).normalize();
+        }
+
+        //
+        // The spine is not closed.
+        //
+        if (point == first) {
+            return (*(first + 1) - *first).normalize();
+        }
+
+        assert(point == last);
+        assert(last - first > 0);
+        return (*last - *(last - 1)).normalize();
+    }
+
+    /**
+     * @brief Compute the <var>z</var>-axis of the spine-aligned cross-section
+     *        plane.
+     *
+     * @param[in] point an arbitrary point in the extrusion spine.
+     * @param[in] first the first point in the extrusion spine.
+     * @param[in] last  the last point in the extrusion spine.
+     * @param[in] prev  the <var>z</var>-axis of the spine-aligned
+     *                  cross-section plane for the previous spine point.
+     *
+     * @return the <var>z</var>axis of the spine-aligned cross-section plane
+     *         at @p point.
+     */
+    OPENVRML_LOCAL
+    const openvrml::vec3f
+    compute_scp_z_axis(
+        const std::vector<openvrml::vec3f>::const_iterator & point,
+        const std::vector<openvrml::vec3f>::const_iterator & first,
+        const std::vector<openvrml::vec3f>::const_iterator & last,
+        const openvrml::vec3f & prev)
+    {
+        using openvrml::vec3f;
+        using openvrml::make_vec3f;
+        using openvrml::local::fequal;
+
+        vec3f z0, z1;
+
+        if (point != first && point != last) {
+            if (*point == *(point - 1)) { return prev; }
+            z0 = *(point + 1) - *point;
+            z1 = *(point - 1) - *point;
+        } else {
+
+            //
+            // From here on, we're dealing with the first or last point.
+            //
+            const bool spine_closed = (*first == *last);
+
+            if (spine_closed) {
+                z0 = *(first + 1) - *first;
+                z1 = *(last - 1) - *first;
+            } else {
+                if (last - first == 1) { return prev; }
+                if (point == first) {
+                    //
+                    // The spine is not closed.
+                    //
+                    z0 = *(first + 2) - *(first + 1);
+                    z1 = *first - *(first + 1);
+                } else {
+                    assert(point == last);
+                    assert(last - first > 0);
+                    z0 = *(last - 2) - *(last - 1);
+                    z1 = *last - *(last - 1);
+                }
+            }
+        }
+
+        if (fequal(z0.dot(z1), 1.0f)) { return prev; }
+
+        const vec3f z = (z0 * z1).normalize();
+        if (z == make_vec3f(0.0, 0.0, 0.0)) { return prev; }
+
+        return (z.dot(prev) < 0) ? -z : z;
+    }
+
+    /**
+     * @brief Determine if the extrusion spine points are collinear.
+     *
+     * If this function returns @c true, @p scp_x, @p scp_y, and @p scp_z are
+     * the axes of the spine-aligned cross-section plane that should be used
+     * for the extent of the extrusion.
+     *
+     * @param[in] spine     the extrusion spine.
+     * @param[out] scp_x    the initial spine-aligned cross-section plane
+     *                      <var>x</var>-axis.
+     * @param[out] scp_y    the initial spine-aligned cross-section plane
+     *                      <var>y</var>-axis.
+     * @param[out] scp_z    the initial spine-aligned cross-section plane
+     *                      <var>z</var>-axis.
+     *
+     * @return @c true if the points in @p spine are collinear; @c false
+     *         otherwise.
+     */
+    OPENVRML_LOCAL
+    bool
+    check_spine_points_collinear(const std::vector<openvrml::vec3f> & spine,
+                                 openvrml::vec3f & scp_x,
+                                 openvrml::vec3f & scp_y,
+                                 openvrml::vec3f & scp_z)
+    {
+        using std::vector;
+        using openvrml::mat4f;
+        using openvrml::make_rotation_mat4f;
+        using openvrml::make_scale_mat4f;
+        using openvrml::rotation;
+        using openvrml::make_rotation;
+        using openvrml::vec3f;
+        using openvrml::make_vec3f;
+
+        //
+        // First, iterate over the spine points until either the y- or z-axis
+        // for the spine-aligned cross-section plane (SCP) is valid (i.e.,
+        // nonzero).  We bail out of the loop as soon as we get a valid y- or
+        // z-axis; because that means we've hit the first noncollinear point.
+        // If the points are all collinear, we won't have a valid z-axis (or
+        // y-axis) when we're done.
+        //
+        static const vec3f zero = make_vec3f();
+        scp_y = zero;
+        scp_z = zero;
+        vec3f prev_scp_y = zero, prev_scp_z = zero;
+        for (vector<vec3f>::const_iterator point = spine.begin();
+             point < spine.end() && (prev_scp_y == zero || prev_scp_z == zero);
+             ++point) {
+            if (prev_scp_y == zero) {
+                scp_y = compute_scp_y_axis(point,
+                                           spine.begin(),
+                                           spine.end() - 1,
+                                           prev_scp_y);
+                if (scp_y != zero) { prev_scp_y = scp_y; }
+            }
+            if (prev_scp_z == zero) {
+                scp_z = compute_scp_z_axis(point,
+                                           spine.begin(),
+                                           spine.end() - 1,
+                                           prev_scp_z);
+                if (scp_z != zero) { prev_scp_z = scp_z; }
+            }
+        }
+
+        //
+        // If all the points are coincident, prev_scp_y will be invalid
+        // (zero).  Set it to (0 1 0).
+        //
+        if (prev_scp_y == zero) { prev_scp_y = make_vec3f(0.0, 1.0, 0.0); }
+
+        //
+        // If all the points are collinear, prev_scp_z will be invalid (zero).
+        // Default it to (0 0 1); then, per 6.18.3 of VRML97:
+        //
+        //   If the entire spine is collinear, the SCP is computed by finding
+        //   the rotation of a vector along the positive Y-axis (v1) to the
+        //   vector formed by the spine points (v2).  The Y=0 plane is then
+        //   rotated by this value.
+        //
+        bool spine_points_collinear = false;
+        if (prev_scp_z == zero) {
+            spine_points_collinear = true;
+            prev_scp_z = make_vec3f(0.0, 0.0, 1.0);
+            if (prev_scp_y != make_vec3f(0.0, 1.0, 0.0)) {
+                const mat4f rot_mat =
+                    make_rotation_mat4f(
+                        make_rotation(make_vec3f(0.0, 1.0, 0.0),
+                                      prev_scp_y));
+                prev_scp_z *= rot_mat;
+            }
+        }
+
+        if (spine_points_collinear) {
+            scp_y = prev_scp_y;
+            scp_z = prev_scp_z;
+            scp_x = (scp_y * scp_z).normalize();
+        }
+
+        return spine_points_collinear;
+    }
+}
+
+/**
+ * @brief Generate vertex normals for a polygon mesh.
+ *
+ * This is how normals are generated for geometry nodes whose normals are
+ * not given and that are drawn with per-vertex normals.  The normal at each
+ * corner of a face is the average of the normals of the faces that share
+ * that corner's position and whose normals are within @p crease_angle of
+ * the face's own; the average is weighted by the faces' areas.  If
+ * @p crease_angle is 0, every corner gets its face's normal (faceted
+ * shading); if it is &pi; or more, the mesh is smooth everywhere.
+ *
+ * Faces share a position if they share a coordinate index or if their
+ * coordinates coincide.  Coincident coordinates are found with a spatial
+ * hash; so meshes whose faces do not share coordinate indices (e.g., those
+ * written out by tools that duplicate coordinates along texture seams) are
+ * smoothed just the same.
+ *
+ * Large meshes are processed on several threads.
+ *
+ * On return, @p normal_index has the same length as @p coord_index; it has
+ * -1 where @p coord_index does, and the index of the normal for each corner
+ * elsewhere.  That is, the result may be passed to
+ * @c viewer::insert_shell along with @c viewer::mask_normal_per_vertex.
+ *
+ * @param[in] coord         coordinates.
+ * @param[in] coord_index   coordinate indices of the faces, separated by -1.
+ * @param[in] crease_angle  the crease angle in radians.
+ * @param[in] ccw           whether the faces are given in counterclockwise
+ *                          order.
+ * @param[out] normal       the generated normals.
+ * @param[out] normal_index the generated normal indices.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void openvrml::generate_normals(const std::vector<vec3f> & coord,
+                                const std::vector<int32> & coord_index,
+                                const float crease_angle,
+                                const bool ccw,
+                                std::vector<vec3f> & normal,
+                                std::vector<int32> & normal_index)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    using std::vector;
+    using local::pi;
+
+    vector<vec3f> new_normal;
+    vector<int32> new_normal_index(coord_index.size(), -1);
+    int32 corners = 0;
+    for (vector<int32>::size_type i = 0; i < coord_index.size(); ++i) {
+        if (coord_index[i] != -1) { new_normal_index[i] = corners++; }
+    }
+    new_normal.resize(std::size_t(corners));
+
+    polygon_mesh mesh(coord, coord_index);
+    compute_face_normals_ compute_face_normals(mesh);
+    for_each_face_batch(mesh.face_begin.size(), compute_face_normals);
+
+    if (crease_angle > 0.0f) {
+        mesh.weld_positions();
+        const float cos_crease = (crease_angle < pi)
+                               ? float(std::cos(crease_angle))
+                               : -2.0f;
+        smooth_corner_normals smooth(mesh,
+                                     cos_crease,
+                                     ccw,
+                                     new_normal,
+                                     new_normal_index);
+        for_each_face_batch(mesh.face_begin.size(), smooth);
+    } else {
+        flat_corner_normals flat(mesh, ccw, new_normal, new_normal_index);
+        for_each_face_batch(mesh.face_begin.size(), flat);
+    }
+
+    normal.swap(new_normal);
+    normal_index.swap(new_normal_index);
+}
+
+namespace {
+
+    /**
+     * @internal
+     *
+     * @brief Append the triangles of each run of indices in @p index to
+     *        @p coord_index.
+     *
+     * @param[in] index             runs of vertex indices separated by -1.
+     * @param[out] coord_index      coordinate indices of the triangles.
+     * @param[in] append_triangles  a function appending the triangles of a
+     *                              run to a coordinate index.
+     *
+     * @exception std::bad_alloc    if memory allocation fails.
+     */
+    OPENVRML_LOCAL void
+    triangulate_runs(const std::vector<openvrml::int32> & index,
+                     std::vector<openvrml::int32> & coord_index,
+                     void (*append_triangles)(
+                         std::vector<openvrml::int32>::const_iterator,
+                         std::vector<openvrml::int32>::const_iterator,
+                         std::vector<openvrml::int32> &))
+        OPENVRML_THROW1(std::bad_alloc)
+    {
+        using std::vector;
+        using openvrml::int32;
+
+        vector<int32> result;
+        vector<int32>::const_iterator begin = index.begin();
+        while (begin != index.end()) {
+            const vector<int32>::const_iterator end =
+                std::find(begin, index.end(), -1);
+            if (end - begin > 2) { append_triangles(begin, end, result); }
+            begin = (end == index.end()) ? end : end + 1;
+        }
+        coord_index.swap(result);
+    }
+
+    OPENVRML_LOCAL void
+    append_fan_triangles(
+        const std::vector<openvrml::int32>::const_iterator begin,
+        const std::vector<openvrml::int32>::const_iterator end,
+        std::vector<openvrml::int32> & coord_index)
+        OPENVRML_THROW1(std::bad_alloc)
+    {
+        for (std::vector<openvrml::int32>::const_iterator v = begin + 1;
+             v + 1 != end;
+             ++v) {
+            coord_index.push_back(*begin);
+            coord_index.push_back(*v);
+            coord_index.push_back(*(v + 1));
+            coord_index.push_back(-1);
+        }
+    }
+
+    OPENVRML_LOCAL void
+    append_strip_triangles(
+        const std::vector<openvrml::int32>::const_iterator begin,
+        const std::vector<openvrml::int32>::const_iterator end,
+        std::vector<openvrml::int32> & coord_index)
+        OPENVRML_THROW1(std::bad_alloc)
+    {
+        //
+        // Every other triangle is reversed, so that all of them have the
+        // winding of the first.
+        //
+        bool odd = false;
+        for (std::vector<openvrml::int32>::const_iterator v = begin;
+             v + 2 != end;
+             ++v, odd = !odd) {
+            coord_index.push_back(odd ? *(v + 1) : *v);
+            coord_index.push_back(odd ? *v : *(v + 1));
+            coord_index.push_back(*(v + 2));
+            coord_index.push_back(-1);
+        }
+    }
+}
+
+/**
+ * @brief Coordinate indices of the triangles of triangle fans.
+ *
+ * Each fan's first vertex is shared by all of its triangles.  Fans with
+ * fewer than three vertices are ignored.
+ *
+ * @param[in] index         vertex indices of the fans, separated by -1.
+ * @param[out] coord_index  coordinate indices of the triangles, each
+ *                          terminated by -1.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void openvrml::triangle_fan_coord_index(const std::vector<int32> & index,
+                                        std::vector<int32> & coord_index)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    triangulate_runs(index, coord_index, append_fan_triangles);
+}
+
+/**
+ * @brief Coordinate indices of the triangles of triangle strips.
+ *
+ * Strips with fewer than three vertices are ignored.
+ *
+ * @param[in] index         vertex indices of the strips, separated by -1.
+ * @param[out] coord_index  coordinate indices of the triangles, each
+ *                          terminated by -1.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void openvrml::triangle_strip_coord_index(const std::vector<int32> & index,
+                                          std::vector<int32> & coord_index)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    triangulate_runs(index, coord_index, append_strip_triangles);
+}
+
+/**
+ * @brief Compute the coordinates and texture coordinates of an Extrusion.
+ *
+ * The coordinates are those of the cross-section transformed to each point
+ * of the spine, as described in 6.18.3 of VRML97: the cross-section at
+ * spine point @c i is at <code>coord[i * cross_section.size()]</code>.
+ * Each coordinate gets the texture coordinate described there for the sides
+ * of the extrusion.
+ *
+ * @param[in] cross_section the cross-section.
+ * @param[in] spine         the spine.
+ * @param[in] scale         the cross-section scale at each spine point.
+ * @param[in] orientation   the cross-section orientation at each spine
+ *                          point.
+ * @param[out] coord        the coordinates.
+ * @param[out] tex_coord    the texture coordinates.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ *
+ * @pre @p cross_section is not empty and @p spine has more than one point.
+ */
+void openvrml::extrusion_coords(const std::vector<vec2f> & cross_section,
+                                const std::vector<vec3f> & spine,
+                                const std::vector<vec2f> & scale,
+                                const std::vector<rotation> & orientation,
+                                std::vector<vec3f> & coord,
+                                std::vector<vec2f> & tex_coord)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    assert(!cross_section.empty());
+    assert(spine.size() > 1);
+
+    using std::vector;
+
+    coord.resize(spine.size() * cross_section.size());
+    tex_coord.resize(spine.size() * cross_section.size());
+
+    //
+    // Check if the spine points are collinear.  If they are collinear,
+    // the spine-aligned cross-section plane computed for the first point
+    // will be used for the entire extrusion.
+    //
+    vec3f scp_x = make_vec3f(), scp_y = make_vec3f(), scp_z = make_vec3f();
+    const bool spine_points_collinear =
+        check_spine_points_collinear(spine, scp_x, scp_y, scp_z);
+
+    const float spine_length = get_spine_length(spine);
+    const float cross_section_length =
+        get_cross_section_length(cross_section);
+    float current_spine_length = 0.0;
+    for (vector<vec3f>::const_iterator spine_point = spine.begin();
+         spine_point != spine.end();
+         ++spine_point) {
+        if (!spine_points_collinear) {
+            scp_y = compute_scp_y_axis(spine_point,
+                                       spine.begin(),
+                                       spine.end() - 1,
+                                       scp_y);
+            scp_z = compute_scp_z_axis(spine_point,
+                                       spine.begin(),
+                                       spine.end() - 1,
+                                       scp_z);
+            scp_x = (scp_y * scp_z).normalize();
+        }
+
+        mat4f mat =
+            make_mat4f(
+                scp_x.x(),        scp_x.y(),        scp_x.z(),        0.0,
+                scp_y.x(),        scp_y.y(),        scp_y.z(),        0.0,
+                scp_z.x(),        scp_z.y(),        scp_z.z(),        0.0,
+                spine_point->x(), spine_point->y(), spine_point->z(), 1.0);
+
+        const vector<vec3f>::size_type spine_index =
+            static_cast<std::size_t>(std::distance(spine.begin(),
+                                                   spine_point));
+
+        if (!orientation.empty()) {
+            const vector<rotation>::size_type index =
+                spine_index < orientation.size()
+                ? spine_index
+                : orientation.size() - 1;
+            mat = make_rotation_mat4f(orientation[index]) * mat;
+        }
+
+        if (!scale.empty()) {
+            const vector<vec2f>::size_type index =
+                spine_index < scale.size()
+                ? spine_index
+                : scale.size() - 1;
+            mat = (make_scale_mat4f(make_vec3f(scale[index].x(),
+                                               1.0,
+                                               scale[index].y()))
+                   * mat);
+        }
+
+        float current_cross_section_length = 0.0;
+        for (vector<vec2f>::size_type i = 0;
+             i < cross_section.size();
+             ++i) {
+            vec3f cross_section_point = make_vec3f(cross_section[i].x(),
+                                                   0.0,
+                                                   cross_section[i].y());
+            cross_section_point *= mat;
+            const size_t coord_index =
+                spine_index * cross_section.size() + i;
+            coord[coord_index] = cross_section_point;
+            tex_coord[coord_index] =
+                make_vec2f(
+                    current_cross_section_length / cross_section_length,
+                    current_spine_length / spine_length);
+
+            if (i < cross_section.size() - 1) {
+                current_cross_section_length +=
+                    (cross_section[i + 1] - cross_section[i]).length();
+            }
+        }
+        if (spine_point < spine.end() - 1) {
+            current_spine_length +=
+                (*(spine_point + 1) - *spine_point).length();
+        }
+    }
+}
+
+/**
+ * @brief Compute the faces of an Extrusion.
+ *
+ * The sides are quadrilaterals between successive cross-sections.  The caps
+ * are the cross-section (less its last point, if the cross-section is
+ * closed) at the first and last spine points; their texture coordinates map
+ * the cross-section's bounding box to the unit square, and are appended to
+ * @p tex_coord.
+ *
+ * @param[in] cross_section     the cross-section.
+ * @param[in] spine_points      the number of points in the spine.
+ * @param[in] begin_cap         whether to include the cap at the first spine
+ *                              point.
+ * @param[in] end_cap           whether to include the cap at the last spine
+ *                              point.
+ * @param[out] coord_index      the coordinate indices of the faces, for the
+ *                              coordinates computed by
+ *                              @c #extrusion_coords.
+ * @param[in,out] tex_coord     the texture coordinates computed by
+ *                              @c #extrusion_coords.
+ * @param[out] tex_coord_index  the texture coordinate indices of the faces.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ *
+ * @pre @p cross_section is not empty and @p spine_points is greater than 1.
+ */
+void openvrml::extrusion_faces(const std::vector<vec2f> & cross_section,
+                               const std::size_t spine_points,
+                               const bool begin_cap,
+                               const bool end_cap,
+                               std::vector<int32> & coord_index,
+                               std::vector<vec2f> & tex_coord,
+                               std::vector<int32> & tex_coord_index)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    assert(!cross_section.empty());
+    assert(spine_points > 1);
+
+    const int32 n = int32(cross_section.size());
+    const int32 last_section = int32(spine_points - 1) * n;
+    std::vector<int32> new_coord_index;
+    for (int32 section = 0; section < last_section; section += n) {
+        for (int32 j = 0; j < n - 1; ++j) {
+            new_coord_index.push_back(section + n + j);
+            new_coord_index.push_back(section + j);
+            new_coord_index.push_back(section + j + 1);
+            new_coord_index.push_back(section + n + j + 1);
+            new_coord_index.push_back(-1);
+        }
+    }
+    std::vector<int32> new_tex_coord_index = new_coord_index;
+
+    const int32 cap_points =
+        (n > 1 && cross_section.front() == cross_section.back())
+        ? n - 1
+        : n;
+    if (cap_points > 2 && (begin_cap || end_cap)) {
+        float xz[4] = { cross_section[0].x(), cross_section[0].x(),
+                        cross_section[0].y(), cross_section[0].y() };
+        for (int32 j = 1; j < n; ++j) {
+            xz[0] = (std::min)(xz[0], cross_section[j].x());
+            xz[1] = (std::max)(xz[1], cross_section[j].x());
+            xz[2] = (std::min)(xz[2], cross_section[j].y());
+            xz[3] = (std::max)(xz[3], cross_section[j].y());
+        }
+        const float dx = (xz[1] > xz[0]) ? 1.0f / (xz[1] - xz[0]) : 0.0f;
+        const float dz = (xz[3] > xz[2]) ? 1.0f / (xz[3] - xz[2]) : 0.0f;
+        const int32 cap_tex_coord = int32(tex_coord.size());
+        for (int32 j = 0; j < n; ++j) {
+            tex_coord.push_back(
+                make_vec2f((cross_section[j].x() - xz[0]) * dx,
+                           (cross_section[j].y() - xz[2]) * dz));
+        }
+
+        if (begin_cap) {
+            for (int32 j = cap_points - 1; j >= 0; --j) {
+                new_coord_index.push_back(j);
+                new_tex_coord_index.push_back(cap_tex_coord + j);
+            }
+            new_coord_index.push_back(-1);
+            new_tex_coord_index.push_back(-1);
+        }
+        if (end_cap) {
+            for (int32 j = 0; j < cap_points; ++j) {
+                new_coord_index.push_back(last_section + j);
+                new_tex_coord_index.push_back(cap_tex_coord + j);
+            }
+            new_coord_index.push_back(-1);
+            new_tex_coord_index.push_back(-1);
+        }
+    }
+
+    coord_index.swap(new_coord_index);
+    tex_coord_index.swap(new_tex_coord_index);
+}
+
+/**
+ * @class openvrml::normal_cache openvrml/mesh.h
+ *
+ * @brief Normals generated for a geometry node, kept until its coordinates
+ *        or coordinate indices change.
+ *
+ * Generating normals for a large mesh is not cheap; geometry nodes keep
+ * them in a @c normal_cache so that they are generated again only when
+ * needed.  A node calls @c #invalidate when its coordinate indices change.
+ * Changes to the coordinates themselves are detected by passing the
+ * @c coordinate_node (if any) to @c #valid: the cache is not valid for a
+ * different @c coordinate_node than the one it was generated from.  The
+ * node is responsible for checking whether that @c coordinate_node has been
+ * modified.
+ */
+
+/**
+ * @var std::vector<openvrml::vec3f> openvrml::normal_cache::normal_
+ *
+ * @brief Generated normals.
+ */
+
+/**
+ * @var std::vector<openvrml::int32> openvrml::normal_cache::normal_index_
+ *
+ * @brief Generated normal indices.
+ */
+
+/**
+ * @var const openvrml::node * openvrml::normal_cache::coord_node_
+ *
+ * @brief The @c node providing the coordinates the normals were generated
+ *        from.
+ */
+
+/**
+ * @var long openvrml::normal_cache::coord_modifications_
+ *
+ * @brief The modification count of @c #coord_node_ when the normals were
+ *        generated.
+ */
+
+/**
+ * @var bool openvrml::normal_cache::valid_
+ *
+ * @brief Whether the normals are current.
+ */
+
+/**
+ * @brief Construct.
+ *
+ * The cache starts out invalid.
+ */
+openvrml::normal_cache::normal_cache() OPENVRML_NOTHROW:
+    coord_node_(0),
+    coord_modifications_(0),
+    valid_(false)
+{}
+
+/**
+ * @brief Whether the normals are current.
+ *
+ * @param[in] coord_node    the @c node providing the coordinates; or 0 if
+ *                          the coordinates are not provided by a @c node.
+ *
+ * The normals are keyed on @p coord_node's modification count rather than
+ * its modified flag: a coordinate @c node may be shared by several geometry
+ * @c node%s, and the first of them to be rendered clears the flag.
+ *
+ * @return @c true if the cache holds normals generated from @p coord_node's
+ *         coordinates, @p coord_node has not been modified since, and the
+ *         cache has not been invalidated; @c false otherwise.
+ *
+ * @sa openvrml::node::modifications
+ */
+bool openvrml::normal_cache::valid(const node * const coord_node) const
+    OPENVRML_NOTHROW
+{
+    return this->valid_
+        && this->coord_node_ == coord_node
+        && (!coord_node
+            || coord_node->modifications() == this->coord_modifications_);
+}
+
+/**
+ * @brief Discard the normals.
+ *
+ * Call this when the coordinates or coordinate indices change.
+ */
+void openvrml::normal_cache::invalidate() OPENVRML_NOTHROW
+{
+    this->valid_ = false;
+}
+
+/**
+ * @brief Generate the normals.
+ *
+ * @param[in] coord_node    the @c node providing @p coord; or 0.
+ * @param[in] coord         coordinates.
+ * @param[in] coord_index   coordinate indices.
+ * @param[in] crease_angle  the crease angle in radians.
+ * @param[in] ccw           whether the faces are given in counterclockwise
+ *                          order.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ *
+ * @sa openvrml::generate_normals
+ */
+void openvrml::normal_cache::generate(const node * const coord_node,
+                                      const std::vector<vec3f> & coord,
+                                      const std::vector<int32> & coord_index,
+                                      const float crease_angle,
+                                      const bool ccw)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    this->valid_ = false;
+    //
+    // Read the count first, so that a change made while the normals are
+    // being generated leaves them invalid.
+    //
+    const long coord_modifications =
+        coord_node ? coord_node->modifications() : 0;
+    generate_normals(coord, coord_index, crease_angle, ccw,
+                     this->normal_, this->normal_index_);
+    this->coord_node_ = coord_node;
+    this->coord_modifications_ = coord_modifications;
+    this->valid_ = true;
+}
+
+/**
+ * @brief Generated normals.
+ *
+ * @return the generated normals.
+ */
+const std::vector<openvrml::vec3f> & openvrml::normal_cache::normal() const
+    OPENVRML_NOTHROW
+{
+    return this->normal_;
+}
+
+/**
+ * @brief Generated normal indices.
+ *
+ * @return the generated normal indices.
+ */
+const std::vector<openvrml::int32> &
+openvrml::normal_cache::normal_index() const OPENVRML_NOTHROW
+{
+    return this->normal_index_;
+}
@@ -0,0 +1,94 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# ifndef OPENVRML_MESH_H
+#   define OPENVRML_MESH_H
+
+#   include <openvrml/basetypes.h>
+#   include <boost/utility.hpp>
+#   include <vector>
+
+namespace openvrml {
+
+    class node;
+
+    OPENVRML_API void generate_normals(const std::vector<vec3f> & coord,
+                                       const std::vector<int32> & coord_index,
+                                       float crease_angle,
+                                       bool ccw,
+                                       std::vector<vec3f> & normal,
+                                       std::vector<int32> & normal_index)
+        OPENVRML_THROW1(std::bad_alloc);
+
+    OPENVRML_API void
+    triangle_fan_coord_index(const std::vector<int32> & index,
+                             std::vector<int32> & coord_index)
+        OPENVRML_THROW1(std::bad_alloc);
+
+    OPENVRML_API void
+    triangle_strip_coord_index(const std::vector<int32> & index,
+                               std::vector<int32> & coord_index)
+        OPENVRML_THROW1(std::bad_alloc);
+
+    OPENVRML_API void
+    extrusion_coords(const std::vector<vec2f> & cross_section,
+                     const std::vector<vec3f> & spine,
+                     const std::vector<vec2f> & scale,
+                     const std::vector<rotation> & orientation,
+                     std::vector<vec3f> & coord,
+                     std::vector<vec2f> & tex_coord)
+        OPENVRML_THROW1(std::bad_alloc);
+
+    OPENVRML_API void
+    extrusion_faces(const std::vector<vec2f> & cross_section,
+                    std::size_t spine_points,
+                    bool begin_cap,
+                    bool end_cap,
+                    std::vector<int32> & coord_index,
+                    std::vector<vec2f> & tex_coord,
+                    std::vector<int32> & tex_coord_index)
+        OPENVRML_THROW1(std::bad_alloc);
+
+
+    class OPENVRML_API normal_cache : boost::noncopyable {
+        std::vector<vec3f> normal_;
+        std::vector<int32> normal_index_;
+        const node * coord_node_;
+        long coord_modifications_;
+        bool valid_;
+
+    public:
+        normal_cache() OPENVRML_NOTHROW;
+
+        bool valid(const node * coord_node) const OPENVRML_NOTHROW;
+        void invalidate() OPENVRML_NOTHROW;
+        void generate(const node * coord_node,
+                      const std::vector<vec3f> & coord,
+                      const std::vector<int32> & coord_index,
+                      float crease_angle,
+                      bool ccw)
+            OPENVRML_THROW1(std::bad_alloc);
+
+        const std::vector<vec3f> & normal() const OPENVRML_NOTHROW;
+        const std::vector<int32> & normal_index() const OPENVRML_NOTHROW;
+    };
+}
+
+# endif // ifndef OPENVRML_MESH_H
@@ -20,14 +20,19 @@
 //
 
 # include "browser.h"
+# include "compiled_mesh.h"
 # include "scope.h"
 # include "viewer.h"
 # include <openvrml/local/node_metatype_registry_impl.h>
 # include <openvrml/local/uri.h>
 # include <openvrml/local/field_value_types.h>
+# include <openvrml/local/event_cascade.h>
+# include <openvrml/local/time_dependent_islands.h>
+# include <openvrml/local/node_arena.h>
 # include <boost/array.hpp>
 # include <boost/lexical_cast.hpp>
 # include <boost/mpl/for_each.hpp>
+# include <boost/thread/tss.hpp>
 # include <algorithm>
 # include <sstream>
 
@@ -1523,17 +1528,12 @@ openvrml::node::self_tag(new self_ref_node);
 /**
  * @internal
  *
- * @var boost::mutex openvrml::node::ref_count_mutex_
- *
- * @brief Mutex to guard @c #ref_count_.
- */
-
-/**
- * @internal
- *
- * @var size_t openvrml::node::ref_count_
+ * @var boost::detail::atomic_count openvrml::node::ref_count_
  *
  * @brief The number of owning references to the instance.
+ *
+ * The count is updated atomically; copying a
+ * @c boost::intrusive_ptr<node> does not require taking a lock.
  */
 
 /**
@@ -1588,6 +1588,26 @@ openvrml::node::self_tag(new self_ref_node);
  * @sa #modified
  */
 
+/**
+ * @internal
+ *
+ * @var boost::detail::atomic_count openvrml::node::modifications_
+ *
+ * @brief The number of times the @c node has been marked modified.
+ */
+
+/**
+ * @internal
+ *
+ * @var boost::shared_ptr<openvrml::local::subtree_state> openvrml::node::subtree_
+ *
+ * @brief Whether this @c node and its children are known to be unmodified,
+ *        and the @c node%s that have checked this one as a child.
+ *
+ * Created the first time @c #modified() is called.  Guarded by
+ * @c #modified_mutex_.
+ */
+
 /**
  * @brief Construct.
  *
@@ -1601,9 +1621,39 @@ openvrml::node::node(const node_type & type,
     type_(type),
     scope_(scope),
     scene_(0),
-    modified_(false)
+    modified_(false),
+    modifications_(0)
 {}
 
+/**
+ * @brief Allocate storage for a @c node.
+ *
+ * While a @c scene is being loaded, its @c node%s are placed in the
+ * @c scene's @c local::node_arena; otherwise, storage is allocated from the
+ * free store.
+ *
+ * @param[in] size  the size of the @c node.
+ *
+ * @return storage for the @c node.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void * openvrml::node::operator new(const std::size_t size)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    return local::node_arena::allocate_node(size);
+}
+
+/**
+ * @brief Deallocate storage for a @c node.
+ *
+ * @param[in] ptr   storage obtained from @c node::operator new.
+ */
+void openvrml::node::operator delete(void * const ptr) OPENVRML_NOTHROW
+{
+    local::node_arena::deallocate_node(ptr);
+}
+
 namespace {
 
     /**
@@ -1654,15 +1704,12 @@ openvrml::node::~node() OPENVRML_NOTHROW
 }
 
 /**
+ * @fn void openvrml::node::add_ref() const
+ *
  * @brief Increment the reference count.
  *
  * Add an owning reference.
  */
-void openvrml::node::add_ref() const OPENVRML_NOTHROW
-{
-    boost::mutex::scoped_lock lock(this->ref_count_mutex_);
-    ++this->ref_count_;
-}
 
 /**
  * @fn void openvrml::intrusive_ptr_add_ref(const node * n)
@@ -1690,18 +1737,11 @@ void openvrml::node::add_ref() const OPENVRML_NOTHROW
  */
 
 /**
+ * @fn void openvrml::node::release() const
+ *
  * @brief Decrement the reference count; destroy the instance if the count
  *        drops to zero.
  */
-void openvrml::node::release() const OPENVRML_NOTHROW
-{
-    bool delete_me;
-    {
-        boost::mutex::scoped_lock lock(this->ref_count_mutex_);
-        delete_me = (--this->ref_count_ == 0);
-    }
-    if (delete_me) { delete this; }
-}
 
 /**
  * @fn void openvrml::intrusive_ptr_release(const node * n)
@@ -1722,7 +1762,7 @@ void openvrml::node::release() const OPENVRML_NOTHROW
  */
 size_t openvrml::node::use_count() const OPENVRML_NOTHROW
 {
-    return this->ref_count_;
+    return static_cast<size_t>(static_cast<long>(this->ref_count_));
 }
 
 /**
@@ -2371,11 +2411,143 @@ openvrml::viewpoint_node * openvrml::node::to_viewpoint() OPENVRML_NOTHROW
     return 0;
 }
 
+/**
+ * @internal
+ *
+ * @brief Whether a @c node and its children are known to be unmodified, and
+ *        the @c node%s that have checked it as a child.
+ *
+ * The links to parents are made as @c node::modified() walks the scene
+ * graph, so they need no maintenance where child @c node%s are assigned.  A
+ * parent's subtree can be recorded as unmodified only after it has checked
+ * each of its children, so a parent whose subtree is unmodified is linked
+ * from each of them.  A link that outlives the parent's use of the child
+ * costs at most an unneeded recheck of the parent.
+ */
+struct OPENVRML_LOCAL openvrml::local::subtree_state : boost::noncopyable {
+    boost::mutex mutex;
+    bool unmodified;
+    std::vector<boost::weak_ptr<subtree_state> > parents;
+
+    subtree_state() OPENVRML_NOTHROW;
+};
+
+/**
+ * @var boost::mutex openvrml::local::subtree_state::mutex
+ *
+ * @brief Guards @c #unmodified and @c #parents.
+ */
+
+/**
+ * @var bool openvrml::local::subtree_state::unmodified
+ *
+ * @brief Whether the @c node and its children are known to be unmodified.
+ */
+
+/**
+ * @var std::vector<boost::weak_ptr<openvrml::local::subtree_state> > openvrml::local::subtree_state::parents
+ *
+ * @brief The @c subtree_state%s of the @c node%s that have checked the
+ *        @c node as a child.
+ */
+
+/**
+ * @brief Construct.
+ */
+openvrml::local::subtree_state::subtree_state() OPENVRML_NOTHROW:
+    unmodified(false)
+{}
+
+namespace {
+
+    using openvrml::local::subtree_state;
+
+    OPENVRML_LOCAL void
+    no_cleanup(boost::shared_ptr<subtree_state> *)
+    {}
+
+    //
+    // The subtree_state of the node whose children node::modified is
+    // checking on the calling thread, if any.
+    //
+    boost::thread_specific_ptr<boost::shared_ptr<subtree_state> >
+        checking_parent(&no_cleanup);
+
+    class OPENVRML_LOCAL checking_children : boost::noncopyable {
+        boost::shared_ptr<subtree_state> * const previous_;
+
+    public:
+        explicit checking_children(boost::shared_ptr<subtree_state> & parent)
+            OPENVRML_NOTHROW:
+            previous_(checking_parent.get())
+        {
+            checking_parent.reset(&parent);
+        }
+
+        ~checking_children() OPENVRML_NOTHROW
+        {
+            checking_parent.reset(this->previous_);
+        }
+    };
+
+    //
+    // Link subtree to parent, if it is not already.  subtree.mutex must be
+    // held.
+    //
+    OPENVRML_LOCAL void
+    add_parent(subtree_state & subtree,
+               const boost::shared_ptr<subtree_state> & parent)
+        OPENVRML_THROW1(std::bad_alloc)
+    {
+        typedef std::vector<boost::weak_ptr<subtree_state> > parents_t;
+        for (parents_t::iterator p = subtree.parents.begin();
+             p != subtree.parents.end();) {
+            if (p->expired()) {
+                p = subtree.parents.erase(p);
+            } else if (!p->owner_before(parent) && !parent.owner_before(*p)) {
+                return;
+            } else {
+                ++p;
+            }
+        }
+        subtree.parents.push_back(parent);
+    }
+
+    //
+    // Mark subtree and its ancestors as possibly modified.  An ancestor of a
+    // subtree that is not known to be unmodified is not either, so this
+    // stops there.
+    //
+    OPENVRML_LOCAL void
+    invalidate(const boost::shared_ptr<subtree_state> & subtree)
+        OPENVRML_THROW1(std::bad_alloc)
+    {
+        std::vector<boost::weak_ptr<subtree_state> > parents;
+        {
+            boost::mutex::scoped_lock lock(subtree->mutex);
+            if (!subtree->unmodified) { return; }
+            subtree->unmodified = false;
+            parents = subtree->parents;
+        }
+        for (std::vector<boost::weak_ptr<subtree_state> >::const_iterator p =
+                 parents.begin();
+             p != parents.end();
+             ++p) {
+            const boost::shared_ptr<subtree_state> parent = p->lock();
+            if (parent) { invalidate(parent); }
+        }
+    }
+}
+
 /**
  * @brief Set the modified flag.
  *
  * Indicates the node needs to be revisited for rendering.
  *
+ * Setting the flag increments the @c browser's modification epoch and
+ * marks the @c node%s that have checked this one as a child (and theirs in
+ * turn) as possibly modified; it does not lock any @c browser-wide mutex.
+ *
  * @param[in] value
  *
  * @exception boost::thread_resource_error if @c #modified_mutex_ cannot be
@@ -2386,17 +2558,47 @@ void openvrml::node::modified(const bool value)
 {
     using boost::unique_lock;
     using boost::shared_mutex;
-    unique_lock<shared_mutex> lock(this->modified_mutex_);
-    this->modified_ = value;
-    if (this->modified_) { this->type_.metatype().browser().modified(true); }
+    boost::shared_ptr<local::subtree_state> subtree;
+    {
+        unique_lock<shared_mutex> lock(this->modified_mutex_);
+        this->modified_ = value;
+        if (!this->modified_) { return; }
+        ++this->modifications_;
+        ++this->type_.metatype().browser().modification_epoch_;
+        subtree = this->subtree_;
+    }
+    if (subtree) { invalidate(subtree); }
+}
+
+/**
+ * @brief The number of times the @c node has been marked modified.
+ *
+ * Unlike the modified flag, this is not reset when the @c node is rendered.
+ * So anything derived from the @c node's state, and shared among the
+ * @c node%s that use it, can be checked for being current by recording this
+ * count along with it.
+ *
+ * @return the number of times @c #modified(bool) has been called with
+ *         @c true.
+ */
+long openvrml::node::modifications() const OPENVRML_NOTHROW
+{
+    return this->modifications_;
 }
 
 /**
  * @brief Determine whether the @c node has been modified.
  *
- * The default implementation returns whether this @c node has been modified.
- * Subclasses that can have child @c node%s should override this method and
- * return @c true if any of their children have been modified.
+ * Returns @c true if this @c node has been modified, or if
+ * @c #do_modified returns @c true.  Subclasses that can have child
+ * @c node%s override @c #do_modified to check their children.
+ *
+ * Once this @c node and its children have been found to be unmodified, that
+ * result is reused until one of them is marked modified; see
+ * @c local::subtree_state.  So an unchanged subtree is checked in constant
+ * time, however much of the rest of the scene changes.  If any @c node in
+ * the @c browser is marked modified while the subtree is being checked, the
+ * result is not reused.
  *
  * @return @c true if the @c node has been modified; @c false otherwise.
  *
@@ -2407,9 +2609,44 @@ bool openvrml::node::modified() const
     OPENVRML_THROW1(boost::thread_resource_error)
 {
     using boost::shared_lock;
+    using boost::unique_lock;
     using boost::shared_mutex;
+
+    const long epoch = this->type_.metatype().browser().modification_epoch_;
+    boost::shared_ptr<local::subtree_state> subtree;
+    {
+        shared_lock<shared_mutex> lock(this->modified_mutex_);
+        if (this->modified_) { return true; }
+        subtree = this->subtree_;
+    }
+    if (!subtree) {
+        unique_lock<shared_mutex> lock(this->modified_mutex_);
+        if (!this->subtree_) {
+            this->subtree_.reset(new local::subtree_state);
+        }
+        subtree = this->subtree_;
+    }
+
+    {
+        boost::mutex::scoped_lock lock(subtree->mutex);
+        const boost::shared_ptr<local::subtree_state> * const parent =
+            checking_parent.get();
+        if (parent) { add_parent(*subtree, *parent); }
+        if (subtree->unmodified) { return false; }
+    }
+
+    {
+        checking_children checking(subtree);
+        if (this->do_modified()) { return true; }
+    }
+
     shared_lock<shared_mutex> lock(this->modified_mutex_);
-    return this->modified_ || this->do_modified();
+    if (this->modified_) { return true; }
+    boost::mutex::scoped_lock subtree_lock(subtree->mutex);
+    if (epoch == this->type_.metatype().browser().modification_epoch_) {
+        subtree->unmodified = true;
+    }
+    return false;
 }
 
 /**
@@ -2432,6 +2669,10 @@ bool openvrml::node::do_modified() const
 /**
  * @brief Emit an event.
  *
+ * If a @c local::event_cascade is active on the calling thread (as it is
+ * during @c browser::update), the event is queued and delivered when the
+ * cascade is drained; otherwise it is delivered immediately.
+ *
  * @param[in,out] emitter   an @c event_emitter.
  * @param[in]     timestamp the current time.
  *
@@ -2441,7 +2682,12 @@ void openvrml::node::emit_event(openvrml::event_emitter & emitter,
                                 const double timestamp)
     OPENVRML_THROW1(std::bad_alloc)
 {
-    emitter.emit_event(timestamp);
+    if (local::event_cascade * const cascade =
+        local::event_cascade::current()) {
+        cascade->push(emitter, timestamp);
+    } else {
+        emitter.emit_event(timestamp);
+    }
 }
 
 /**
@@ -2698,6 +2944,7 @@ bool openvrml::add_route(node & from,
     } catch (const bad_cast &) {
         throw field_value_type_mismatch();
     }
+    if (added_route) { local::time_dependent_islands::invalidate(); }
     return added_route;
 }
 
@@ -2766,6 +3013,7 @@ bool openvrml::delete_route(node & from,
         // Do nothing.  If route removal fails, we simply return false.
         //
     }
+    if (deleted_route) { local::time_dependent_islands::invalidate(); }
     return deleted_route;
 }
 
@@ -4004,6 +4252,23 @@ bool openvrml::font_style_node::top_to_bottom() const OPENVRML_NOTHROW
  * @brief Abstract base class for geometry nodes.
  */
 
+/**
+ * @internal
+ *
+ * @var const boost::weak_ptr<openvrml::compiled_mesh_cache> openvrml::geometry_node::compiled_meshes_
+ *
+ * @brief The @c browser's @c compiled_mesh_cache.
+ */
+
+/**
+ * @internal
+ *
+ * @var boost::mutex openvrml::geometry_node::render_mutex_
+ *
+ * @brief Serializes @c #render_geometry with the compilation of the node's
+ *        mesh by a @c local::mesh_compiler.
+ */
+
 /**
  * @brief Construct.
  *
@@ -4015,14 +4280,24 @@ geometry_node(const node_type & type,
               const boost::shared_ptr<openvrml::scope> & scope)
     OPENVRML_NOTHROW:
     node(type, scope),
-    bounded_volume_node(type, scope)
+    bounded_volume_node(type, scope),
+    compiled_meshes_(type.metatype().browser().compiled_meshes_)
 {}
 
 /**
  * @brief Destroy.
+ *
+ * The node's mesh is removed from the @c browser's
+ * @c compiled_mesh_cache, so that a node later constructed at the same
+ * address does not find it.  A node may outlive its @c browser; in that
+ * case the cache is already gone, and there is nothing to remove.
  */
 openvrml::geometry_node::~geometry_node() OPENVRML_NOTHROW
-{}
+{
+    const boost::shared_ptr<compiled_mesh_cache> compiled_meshes =
+        this->compiled_meshes_.lock();
+    if (compiled_meshes) { compiled_meshes->invalidate(*this); }
+}
 
 /**
  * @brief Cast to a @c geometry_node.
@@ -4038,6 +4313,10 @@ openvrml::geometry_node * openvrml::geometry_node::to_geometry()
 /**
  * @brief Insert geometry into a viewer.
  *
+ * If the node has been modified, its mesh in the @c browser's
+ * @c compiled_mesh_cache is discarded, and @p v is told to remove the
+ * object it has for the node.
+ *
  * @param[in,out] v     viewer.
  * @param[in] context   rendering context.
  */
@@ -4047,10 +4326,14 @@ void openvrml::geometry_node::render_geometry(viewer & v,
     using boost::shared_lock;
     using boost::shared_mutex;
     shared_lock<shared_mutex> lock(this->scene_mutex());
+    boost::mutex::scoped_lock render_lock(this->render_mutex_);
 
     if (!this->scene()) { return; }
 
-    if (this->modified()) { v.remove_object(*this); }
+    if (this->modified()) {
+        this->type().metatype().browser().compiled_meshes().invalidate(*this);
+        v.remove_object(*this);
+    }
 
     this->do_render_geometry(v, context);
     this->modified(false);
@@ -4954,6 +5237,35 @@ const openvrml::image & openvrml::texture_node::image() const
  * @return the image.
  */
 
+/**
+ * @brief The mutex guarding the image.
+ *
+ * A texture whose image may be replaced by another thread (while it is
+ * being loaded, for instance) guards it with a mutex; a @c viewer must hold
+ * a shared lock on it while it reads the image.  A texture whose image is
+ * only changed by the thread that renders it has no such mutex.
+ *
+ * This function delegates to @c #do_image_mutex.
+ *
+ * @return the mutex guarding the image, or 0 if there is none.
+ */
+boost::shared_mutex * openvrml::texture_node::image_mutex() const
+    OPENVRML_NOTHROW
+{
+    return this->do_image_mutex();
+}
+
+/**
+ * @brief The mutex guarding the image.
+ *
+ * @return 0.
+ */
+boost::shared_mutex * openvrml::texture_node::do_image_mutex() const
+    OPENVRML_NOTHROW
+{
+    return 0;
+}
+
 /**
  * @brief Get the flag indicating whether the texture should repeat in the
  *      <var>S</var> direction.
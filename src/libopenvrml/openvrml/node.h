@@ -25,6 +25,8 @@
 #   include <openvrml/field_value.h>
 #   include <openvrml/rendering_context.h>
 #   include <boost/bind.hpp>
+#   include <boost/detail/atomic_count.hpp>
+#   include <boost/weak_ptr.hpp>
 #   include <deque>
 #   include <map>
 #   include <set>
@@ -362,6 +364,7 @@ namespace openvrml {
 
 
     class bounding_volume;
+    class compiled_mesh_cache;
     class script_node;
     class appearance_node;
     class background_node;
@@ -403,6 +406,8 @@ namespace openvrml {
     namespace local {
         class proto_node;
         class externproto_node;
+        class mesh_compiler;
+        struct subtree_state;
     }
 
     class OPENVRML_API node : boost::noncopyable {
@@ -462,8 +467,7 @@ namespace openvrml {
         template <typename FieldValue>
         friend class exposedfield;
 
-        mutable boost::mutex ref_count_mutex_;
-        mutable size_t ref_count_;
+        mutable boost::detail::atomic_count ref_count_;
 
         const node_type & type_;
         const boost::shared_ptr<openvrml::scope> scope_;
@@ -473,10 +477,16 @@ namespace openvrml {
 
         mutable boost::shared_mutex modified_mutex_;
         bool modified_;
+        boost::detail::atomic_count modifications_;
+        mutable boost::shared_ptr<local::subtree_state> subtree_;
 
     public:
         static const boost::intrusive_ptr<node> self_tag;
 
+        static void * operator new(std::size_t size)
+            OPENVRML_THROW1(std::bad_alloc);
+        static void operator delete(void * ptr) OPENVRML_NOTHROW;
+
         virtual ~node() OPENVRML_NOTHROW = 0;
 
         void add_ref() const OPENVRML_NOTHROW;
@@ -526,6 +536,7 @@ namespace openvrml {
 
         bool modified() const OPENVRML_THROW1(boost::thread_resource_error);
         void modified(bool value) OPENVRML_THROW1(boost::thread_resource_error);
+        long modifications() const OPENVRML_NOTHROW;
 
     protected:
         static void emit_event(openvrml::event_emitter & emitter,
@@ -593,11 +604,21 @@ namespace openvrml {
         n->add_ref();
     }
 
+    inline void node::add_ref() const OPENVRML_NOTHROW
+    {
+        ++this->ref_count_;
+    }
+
     inline void node::remove_ref() const OPENVRML_NOTHROW
     {
-        boost::mutex::scoped_lock lock(this->ref_count_mutex_);
-        assert(this->ref_count_ > 0);
-        --this->ref_count_;
+        const long count = --this->ref_count_;
+        assert(count >= 0);
+        static_cast<void>(count);
+    }
+
+    inline void node::release() const OPENVRML_NOTHROW
+    {
+        if (--this->ref_count_ == 0) { delete this; }
     }
 
     inline void intrusive_ptr_release(const node * n) OPENVRML_NOTHROW
@@ -1080,6 +1101,11 @@ namespace openvrml {
 
 
     class OPENVRML_API geometry_node : public virtual bounded_volume_node {
+        friend class local::mesh_compiler;
+
+        const boost::weak_ptr<compiled_mesh_cache> compiled_meshes_;
+        boost::mutex render_mutex_;
+
     public:
         virtual ~geometry_node() OPENVRML_NOTHROW = 0;
 
@@ -1284,6 +1310,7 @@ namespace openvrml {
         void render_texture(viewer & v);
 
         const openvrml::image & image() const OPENVRML_NOTHROW;
+        boost::shared_mutex * image_mutex() const OPENVRML_NOTHROW;
         bool repeat_s() const OPENVRML_NOTHROW;
         bool repeat_t() const OPENVRML_NOTHROW;
 
@@ -1298,6 +1325,8 @@ namespace openvrml {
         virtual void do_render_texture(viewer & v);
 
         virtual const openvrml::image & do_image() const OPENVRML_NOTHROW = 0;
+        virtual boost::shared_mutex * do_image_mutex() const
+            OPENVRML_NOTHROW;
         virtual bool do_repeat_s() const OPENVRML_NOTHROW = 0;
         virtual bool do_repeat_t() const OPENVRML_NOTHROW = 0;
     };
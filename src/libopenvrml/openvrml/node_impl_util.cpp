@@ -745,6 +745,14 @@ openvrml::node_impl_util::abstract_node_type::~abstract_node_type()
  * @return the associated @c eventOut identifier.
  */
 
+/**
+ * @fn openvrml::node * openvrml::node_impl_util::event_emitter_base::do_node() const
+ *
+ * @brief The node with which the @c event_emitter is associated.
+ *
+ * @return the node with which the @c event_emitter is associated.
+ */
+
 
 /**
  * @class openvrml::node_impl_util::abstract_node openvrml/node_impl_util.h
@@ -1131,6 +1139,14 @@ openvrml::node_impl_util::abstract_node_type::~abstract_node_type()
  * @brief Polymorphically construct a copy.
  */
 
+/**
+ * @fn openvrml::node * openvrml::node_impl_util::abstract_node::exposedfield::do_node() const
+ *
+ * @brief The node with which the @c exposedField is associated.
+ *
+ * @return the node with which the @c exposedField is associated.
+ */
+
 /**
  * @var openvrml::node_impl_util::abstract_node::metadata
  *
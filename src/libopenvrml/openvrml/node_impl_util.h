@@ -443,6 +443,7 @@ namespace openvrml {
             };
 
             virtual const std::string do_eventout_id() const OPENVRML_NOTHROW;
+            virtual openvrml::node * do_node() const OPENVRML_NOTHROW;
         };
 
         template <typename Node>
@@ -480,6 +481,13 @@ namespace openvrml {
             return pos->first;
         }
 
+        template <typename Node>
+        openvrml::node *
+        event_emitter_base<Node>::do_node() const OPENVRML_NOTHROW
+        {
+            return this->node_;
+        }
+
 
         template <typename Derived>
         class abstract_node : public virtual node {
@@ -573,6 +581,7 @@ namespace openvrml {
             private:
                 virtual std::auto_ptr<field_value> do_clone() const
                     OPENVRML_THROW1(std::bad_alloc);
+                virtual openvrml::node * do_node() const OPENVRML_NOTHROW;
             };
 
             exposedfield<sfnode> metadata;
@@ -656,6 +665,15 @@ namespace openvrml {
                 new exposedfield<FieldValue>(*this));
         }
 
+        template <typename Derived>
+        template <typename FieldValue>
+        openvrml::node *
+        abstract_node<Derived>::exposedfield<FieldValue>::do_node() const
+            OPENVRML_NOTHROW
+        {
+            return &this->event_emitter_base<Derived>::node();
+        }
+
         template <typename Derived>
         abstract_node<Derived>::
         abstract_node(const node_type & type,
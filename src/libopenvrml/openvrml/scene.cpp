@@ -23,9 +23,15 @@
 # include "browser.h"
 # include <openvrml/local/uri.h>
 # include <openvrml/local/parse_vrml.h>
+# include <openvrml/local/node_arena.h>
+# include <openvrml/local/io_executor.h>
+# include <openvrml/local/buffer_streambuf.h>
 # include <private.h>
+# include <boost/bind.hpp>
 # include <boost/function.hpp>
 # include <boost/scope_exit.hpp>
+# include <boost/weak_ptr.hpp>
+# include <algorithm>
 
 # ifdef HAVE_CONFIG_H
 #   include <config.h>
@@ -114,9 +120,30 @@
 /**
  * @internal
  *
- * @var boost::thread_group openvrml::scene::stream_reader_threads_
+ * @var boost::mutex openvrml::scene::io_jobs_mutex_
  *
- * @brief Stream reader thread group.
+ * @brief Mutex protecting @c #io_jobs_.
+ */
+
+/**
+ * @internal
+ *
+ * @var std::vector<boost::shared_ptr<openvrml::local::io_job> > openvrml::scene::io_jobs_
+ *
+ * @brief Jobs posted to the @c browser's I/O threads on behalf of the
+ *        @c scene that may not have finished.
+ */
+
+/**
+ * @internal
+ *
+ * @var openvrml::local::node_arena * openvrml::scene::node_arena_
+ *
+ * @brief The arena for @c node%s created by the last @c #load; null until
+ *        the @c scene is first loaded.
+ *
+ * The @c scene holds a reference to the arena; so does each @c node
+ * allocated from it.  Guarded by @c #nodes_mutex_.
  */
 
 /**
@@ -128,15 +155,35 @@
 openvrml::scene::scene(openvrml::browser & browser, scene * parent)
     OPENVRML_NOTHROW:
     browser_(&browser),
-    parent_(parent)
+    parent_(parent),
+    node_arena_(0)
 {}
 
 /**
  * @brief Destroy.
+ *
+ * Loads queued on behalf of the @c scene are cancelled, and running ones
+ * are waited for.  The @c scene's reference to its @c local::node_arena is
+ * released; the arena's memory is freed once the @c node%s allocated from it
+ * are gone.
  */
 openvrml::scene::~scene() OPENVRML_NOTHROW
 {
-    this->stream_reader_threads_.join_all();
+    //
+    // Running jobs may post more (a stream read yielding its thread), so
+    // keep going until there are none left.
+    //
+    for (;;) {
+        std::vector<boost::shared_ptr<local::io_job> > jobs;
+        {
+            boost::mutex::scoped_lock lock(this->io_jobs_mutex_);
+            jobs.swap(this->io_jobs_);
+        }
+        if (jobs.empty()) { break; }
+        std::for_each(jobs.begin(), jobs.end(),
+                      boost::bind(&local::io_job::wait, _1));
+    }
+    if (this->node_arena_) { this->node_arena_->release(); }
 }
 
 /**
@@ -169,8 +216,9 @@ openvrml::scene * openvrml::scene::parent() const OPENVRML_NOTHROW
  *
  * @exception bad_media_type    if @p in.type() is not
  *                              &ldquo;model/vrml&rdquo;,
- *                              &ldquo;x-world/x-vrml&rdquo;, or
- *                              &ldquo;model/x3d-vrml&rdquo;.
+ *                              &ldquo;x-world/x-vrml&rdquo;,
+ *                              &ldquo;model/x3d-vrml&rdquo;, or
+ *                              &ldquo;model/x3d+binary&rdquo;.
  * @exception invalid_vrml      if @p in has invalid syntax.
  */
 void openvrml::scene::load(resource_istream & in)
@@ -191,14 +239,89 @@ void openvrml::scene::load(resource_istream & in)
             url_lock(this->url_mutex_),
             meta_lock(this->meta_mutex_);
 
+        //
+        // Each load gets a fresh arena.  The previous one is freed once the
+        // nodes allocated from it are gone; reusing it would keep every
+        // earlier load's chunks alive for the life of the scene.
+        //
+        local::node_arena * const arena = new local::node_arena;
         this->nodes_.clear();
         this->meta_.clear();
         this->url_ = in.url();
+        if (this->node_arena_) { this->node_arena_->release(); }
+        this->node_arena_ = arena;
+        local::node_arena::scope node_arena_scope(*this->node_arena_);
         local::parse_vrml(in, in.url(), in.type(),
                           *this, this->nodes_, this->meta_);
     }
 }
 
+struct OPENVRML_LOCAL openvrml::scene::scene_loader {
+    scene_loader(openvrml::scene & scene, const std::vector<std::string> & url):
+        scene_(&scene),
+        url_(url)
+    {}
+
+    void operator()() const OPENVRML_NOTHROW
+    {
+        try {
+            try {
+                //
+                // Relative URIs are relative to the parent scene, if there is
+                // one.
+                //
+                const openvrml::scene & resolving_scene =
+                    this->scene_->parent() ? *this->scene_->parent()
+                                           : *this->scene_;
+                std::auto_ptr<resource_istream> in =
+                    resolving_scene.get_resource(this->url_);
+                if (!(*in)) { throw unreachable_url(); }
+                this->scene_->load(*in);
+            } catch (std::exception & ex) {
+                this->scene_->browser().err(ex.what());
+                throw unreachable_url();
+            } catch (...) {
+                //
+                // The implementation of resource_istream is provided by the
+                // user; and unfortunately, operations on it could throw
+                // anything.
+                //
+                throw unreachable_url();
+            }
+        } catch (std::exception & ex) {
+            this->scene_->browser().err(ex.what());
+        }
+    }
+
+private:
+    openvrml::scene * const scene_;
+    const std::vector<std::string> url_;
+};
+
+/**
+ * @brief Load the @c scene asynchronously from a URI.
+ *
+ * The @c scene is loaded by the @c browser's I/O threads (see
+ * @c browser::io_threads), as if by @c #load; relative URIs in @p url are
+ * resolved against the parent @c scene, if there is one.  Errors are
+ * reported with @c browser::err.
+ *
+ * @param[in] url       an alternative URI list.
+ * @param[in] priority  the priority of the load relative to other loads;
+ *                      lower values are loaded first.  This is typically
+ *                      the distance from the viewer to the content, where
+ *                      that is known.
+ *
+ * @exception std::bad_alloc                if memory allocation fails.
+ * @exception boost::thread_resource_error  if no I/O thread can be started.
+ */
+void openvrml::scene::load_async(const std::vector<std::string> & url,
+                                 const float priority)
+    OPENVRML_THROW2(std::bad_alloc, boost::thread_resource_error)
+{
+    this->post_io_job(scene_loader(*this, url), priority);
+}
+
 /**
  * @brief Initialize the @c scene.
  *
@@ -405,57 +528,291 @@ void openvrml::scene::render(openvrml::viewer & viewer,
 
 namespace {
 
-    struct OPENVRML_LOCAL stream_reader {
-        stream_reader(std::auto_ptr<openvrml::resource_istream> in,
-                      std::auto_ptr<openvrml::stream_listener> listener):
-            in_(in),
-            listener_(listener)
-        {}
+    typedef std::vector<unsigned char> stream_buffer;
+
+    //
+    // Buffers for stream_reader, reused across streams so that a texture or
+    // audio download does not allocate a fresh block for every read.
+    //
+    class OPENVRML_LOCAL stream_buffer_pool : boost::noncopyable {
+        static const std::size_t buffer_size = 65536;
+        static const std::size_t max_free = 8;
+
+        boost::mutex mutex_;
+        std::vector<boost::shared_ptr<stream_buffer> > free_;
 
-        void operator()() const
+    public:
+        const boost::shared_ptr<stream_buffer> acquire()
         {
-            this->listener_->stream_available(this->in_->url(),
-                                              this->in_->type());
-            while (*this->in_) {
-                std::vector<unsigned char> data;
-                while (this->in_->data_available()) {
-                    using openvrml::resource_istream;
-                    const resource_istream::int_type c = this->in_->get();
-                    if (c != resource_istream::traits_type::eof()) {
-                        data.push_back(
-                            static_cast<unsigned char>(
-                                resource_istream::traits_type::
-                                    to_char_type(c)));
-                    } else {
-                        break;
-                    }
+            {
+                boost::mutex::scoped_lock lock(this->mutex_);
+                if (!this->free_.empty()) {
+                    const boost::shared_ptr<stream_buffer> buffer =
+                        this->free_.back();
+                    this->free_.pop_back();
+                    return buffer;
                 }
-                if (!data.empty()) {
-                    this->listener_->data_available(data);
+            }
+            return boost::shared_ptr<stream_buffer>(
+                new stream_buffer(buffer_size));
+        }
+
+        void release(const boost::shared_ptr<stream_buffer> & buffer)
+            OPENVRML_NOTHROW
+        {
+            boost::mutex::scoped_lock lock(this->mutex_);
+            if (this->free_.size() < max_free) {
+                try {
+                    this->free_.push_back(buffer);
+                } catch (std::bad_alloc &) {
+                    //
+                    // Just let the buffer go.
+                    //
                 }
             }
         }
+    };
 
-    private:
-        boost::shared_ptr<openvrml::resource_istream> in_;
-        boost::shared_ptr<openvrml::stream_listener> listener_;
+    stream_buffer_pool stream_buffers;
+
+    //
+    // Queues an I/O job that was deferred until a stream has data.  The job
+    // holds the stream, and the stream holds this; so only a weak reference
+    // to the job is kept.
+    //
+    class OPENVRML_LOCAL io_job_resumer {
+        boost::weak_ptr<openvrml::local::io_job> job_;
+
+    public:
+        explicit io_job_resumer(
+            const boost::shared_ptr<openvrml::local::io_job> & job):
+            job_(job)
+        {}
+
+        void operator()() const OPENVRML_NOTHROW
+        {
+            const boost::shared_ptr<openvrml::local::io_job> job =
+                this->job_.lock();
+            if (job) { job->resume(); }
+        }
     };
 }
 
+struct OPENVRML_LOCAL openvrml::scene::stream_reader {
+    stream_reader(openvrml::scene & scene,
+                  std::auto_ptr<openvrml::resource_istream> in,
+                  std::auto_ptr<openvrml::stream_listener> listener,
+                  const float priority):
+        scene_(&scene),
+        in_(in),
+        listener_(listener),
+        priority_(priority),
+        started_(false),
+        waits_(0)
+    {}
+
+    void operator()() const
+    {
+        if (!this->started_) {
+            this->listener_->stream_available(this->in_->url(),
+                                              this->in_->type());
+            this->started_ = true;
+        }
+
+        //
+        // A memory-mapped file or a cached resource can be handed to the
+        // listener in place.
+        //
+        if (const local::buffer_streambuf * const contiguous =
+            local::contiguous_buffer(*this->in_)) {
+            if (contiguous->size() > 0) {
+                this->listener_->data_available(
+                    reinterpret_cast<const unsigned char *>(
+                        contiguous->data()),
+                    contiguous->size());
+            }
+            return;
+        }
+
+        const boost::shared_ptr<stream_buffer> buffer =
+            stream_buffers.acquire();
+        stream_buffer & data = *buffer;
+        BOOST_SCOPE_EXIT((&buffer)) {
+            stream_buffers.release(buffer);
+        } BOOST_SCOPE_EXIT_END
+
+        while (*this->in_) {
+            if (!this->in_->data_available() && this->yield()) { return; }
+            this->waits_ = 0;
+
+            //
+            // Take whatever the streambuf already has buffered in one go;
+            // only fall back to get (which may block) when it has nothing
+            // buffered but data_available says more is coming.
+            //
+            std::size_t size = 0;
+            while (size < data.size() && this->in_->data_available()) {
+                const std::streamsize n =
+                    this->in_->readsome(reinterpret_cast<char *>(&data[size]),
+                                        data.size() - size);
+                if (n > 0) {
+                    size += n;
+                    continue;
+                }
+                if (!*this->in_) { break; }
+                const resource_istream::int_type c = this->in_->get();
+                if (c == resource_istream::traits_type::eof()) { break; }
+                data[size++] = static_cast<unsigned char>(
+                    resource_istream::traits_type::to_char_type(c));
+            }
+            if (size > 0) {
+                this->listener_->data_available(&data[0], size);
+            }
+        }
+    }
+
+private:
+    //
+    // Give the thread up until the stream has data, rather than tie it up
+    // waiting.  The rest of the stream is deferred until the stream says
+    // data has arrived, and then queued behind the other I/O jobs.  A
+    // stream that cannot say when data arrives is checked again after a
+    // delay that doubles, from 1 ms up to 64 ms, each time it is found
+    // still waiting.  Returns false if deferring fails, in which case the
+    // caller carries on reading here.
+    //
+    bool yield() const OPENVRML_NOTHROW
+    {
+        static const unsigned int max_doublings = 6;
+        try {
+            const boost::shared_ptr<local::io_job> waiting =
+                this->scene_->defer_io_job(
+                    *this,
+                    this->priority_,
+                    boost::posix_time::time_duration(
+                        boost::posix_time::pos_infin));
+            if (this->in_->notify_data_available(io_job_resumer(waiting))) {
+                return true;
+            }
+            //
+            // If the job cannot be cancelled, the scene has cancelled it
+            // already.
+            //
+            if (!waiting->cancel()) { return true; }
+
+            const unsigned int wait_ms =
+                1u << (std::min)(this->waits_, max_doublings);
+            ++this->waits_;
+            this->scene_->defer_io_job(*this,
+                                       this->priority_,
+                                       boost::posix_time::milliseconds(
+                                           wait_ms));
+            return true;
+        } catch (std::exception &) {
+            return false;
+        }
+    }
+
+    openvrml::scene * scene_;
+    boost::shared_ptr<openvrml::resource_istream> in_;
+    boost::shared_ptr<openvrml::stream_listener> listener_;
+    float priority_;
+    mutable bool started_;
+    mutable unsigned int waits_;
+};
+
 /**
- * @brief Read a stream in a new thread.
+ * @brief Read a stream asynchronously.
  *
- * @c #read_stream takes ownership of its arguments; the resources are released
- * when reading the stream completes and the thread terminates.
+ * The stream is read by the @c browser's I/O threads (see
+ * @c browser::io_threads).  @c #read_stream takes ownership of its arguments;
+ * the resources are released when reading the stream completes, or when the
+ * read is cancelled because the world is replaced.
  *
  * @param[in] in        an input stream.
  * @param[in] listener  a stream listener.
+ * @param[in] priority  the priority of the read relative to other loads;
+ *                      lower values are read first.  This is typically the
+ *                      distance from the viewer to the content, where that
+ *                      is known.
+ *
+ * @exception std::bad_alloc                if memory allocation fails.
+ * @exception boost::thread_resource_error  if no I/O thread can be started.
  */
 void openvrml::scene::read_stream(std::auto_ptr<resource_istream> in,
-                                  std::auto_ptr<stream_listener> listener)
+                                  std::auto_ptr<stream_listener> listener,
+                                  const float priority)
+{
+    this->post_io_job(stream_reader(*this, in, listener, priority), priority);
+}
+
+/**
+ * @internal
+ *
+ * @brief Queue a job on the @c browser's I/O threads on behalf of this
+ *        @c scene.
+ *
+ * The @c scene cancels or waits for the job when it is destroyed.
+ *
+ * @param[in] job       the job.
+ * @param[in] priority  the priority of the job; lower values run first.
+ *
+ * @exception std::bad_alloc                if memory allocation fails.
+ * @exception boost::thread_resource_error  if no I/O thread can be started.
+ */
+void openvrml::scene::post_io_job(const boost::function0<void> & job,
+                                  const float priority)
+    OPENVRML_THROW2(std::bad_alloc, boost::thread_resource_error)
 {
-    boost::function0<void> f = stream_reader(in, listener);
-    this->stream_reader_threads_.create_thread(f);
+    static const bool node_scoped = true;
+    const boost::shared_ptr<local::io_job> posted =
+        this->browser_->io_executor_->post(job, priority, node_scoped);
+
+    boost::mutex::scoped_lock lock(this->io_jobs_mutex_);
+    this->io_jobs_.erase(
+        std::remove_if(this->io_jobs_.begin(), this->io_jobs_.end(),
+                       boost::bind(&local::io_job::finished, _1)),
+        this->io_jobs_.end());
+    this->io_jobs_.push_back(posted);
+}
+
+/**
+ * @internal
+ *
+ * @brief Queue a job on the @c browser's I/O threads behind the jobs already
+ *        queued, once a delay has passed.
+ *
+ * This is for a job that is waiting on data from outside the pool; see
+ * @c local::io_executor::defer.
+ *
+ * @param[in] job       the job.
+ * @param[in] priority  the priority of the job; lower values run first.
+ * @param[in] delay     how long to wait before queuing the job; or
+ *                      @c boost::posix_time::pos_infin to wait until the
+ *                      job is resumed.
+ *
+ * @return the job.
+ *
+ * @exception std::bad_alloc                if memory allocation fails.
+ * @exception boost::thread_resource_error  if no I/O thread can be started.
+ */
+const boost::shared_ptr<openvrml::local::io_job>
+openvrml::scene::defer_io_job(const boost::function0<void> & job,
+                              const float priority,
+                              const boost::posix_time::time_duration & delay)
+    OPENVRML_THROW2(std::bad_alloc, boost::thread_resource_error)
+{
+    static const bool node_scoped = true;
+    const boost::shared_ptr<local::io_job> deferred =
+        this->browser_->io_executor_->defer(job, priority, node_scoped, delay);
+
+    boost::mutex::scoped_lock lock(this->io_jobs_mutex_);
+    this->io_jobs_.erase(
+        std::remove_if(this->io_jobs_.begin(), this->io_jobs_.end(),
+                       boost::bind(&local::io_job::finished, _1)),
+        this->io_jobs_.end());
+    this->io_jobs_.push_back(deferred);
+    return deferred;
 }
 
 struct OPENVRML_LOCAL openvrml::scene::vrml_from_url_creator {
@@ -520,7 +877,7 @@ private:
  * @exception unsupported_interface         if @p node has no eventIn @p event.
  * @exception std::bad_cast                 if the @p event eventIn of @p node
  *                                          is not an MFNode.
- * @exception boost::thread_resource_error  if thread creation fails.
+ * @exception boost::thread_resource_error  if no I/O thread can be started.
  */
 void
 openvrml::scene::
@@ -530,8 +887,7 @@ create_vrml_from_url(const std::vector<std::string> & url,
     OPENVRML_THROW3(unsupported_interface, std::bad_cast,
                     boost::thread_resource_error)
 {
-    boost::function0<void> f = vrml_from_url_creator(*this, url, node, event);
-    this->stream_reader_threads_.create_thread(f);
+    this->post_io_job(vrml_from_url_creator(*this, url, node, event), 0.0f);
 }
 
 /**
@@ -597,6 +953,36 @@ void openvrml::scene::load_url(const std::vector<std::string> & url,
     }
 }
 
+/**
+ * @brief Resolve a URI.
+ *
+ * Relative URIs are resolved against the absolute URI of the @c scene, as
+ * by @c #get_resource; but nothing is fetched.  This gives the key under
+ * which a resource obtained by @c #get_resource can be shared.
+ *
+ * @param[in] url   a URI.
+ *
+ * @return the absolute form of @p url.
+ *
+ * @exception invalid_url           if @p url is not a valid URI.
+ * @exception std::runtime_error    if @p url is relative and a file URL
+ *                                  for it cannot be constructed.
+ * @exception std::bad_alloc        if memory allocation fails.
+ */
+const std::string
+openvrml::scene::resolve_url(const std::string & url) const
+    OPENVRML_THROW2(std::runtime_error, std::bad_alloc)
+{
+    using local::uri;
+
+    const uri test_uri(url);
+    return !relative(test_uri)
+        ? test_uri
+        : (!this->parent() && this->url().empty())
+            ? create_file_url(test_uri)
+            : resolve_against(test_uri, uri(this->url()));
+}
+
 /**
  * @brief Get a resource using a list of alternative URIs.
  *
@@ -635,11 +1021,7 @@ openvrml::scene::get_resource(const std::vector<std::string> & url) const
             //
             test_uri = uri(url[i]);
 
-            absolute_uri = !relative(test_uri)
-                         ? test_uri
-                         : (!this->parent() && this->url().empty())
-                             ? create_file_url(test_uri)
-                             : resolve_against(test_uri, uri(this->url()));
+            absolute_uri = uri(this->resolve_url(url[i]));
             in = this->browser().fetcher_.get_resource(absolute_uri);
         } catch (invalid_url &) {
             std::ostringstream msg;
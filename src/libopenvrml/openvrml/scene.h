@@ -25,6 +25,8 @@
 #   include <openvrml-common.h>
 #   include <openvrml/bad_url.h>
 #   include <openvrml/node.h>
+#   include <boost/date_time/posix_time/posix_time_types.hpp>
+#   include <boost/function.hpp>
 
 namespace openvrml {
 
@@ -32,8 +34,15 @@ namespace openvrml {
     class resource_istream;
     class stream_listener;
 
+    namespace local {
+        class node_arena;
+        class io_job;
+    }
+
     class OPENVRML_API scene : boost::noncopyable {
         struct vrml_from_url_creator;
+        struct scene_loader;
+        struct stream_reader;
 
         openvrml::browser * const browser_;
         scene * const parent_;
@@ -47,7 +56,10 @@ namespace openvrml {
         mutable boost::shared_mutex meta_mutex_;
         std::map<std::string, std::string> meta_;
 
-        boost::thread_group stream_reader_threads_;
+        boost::mutex io_jobs_mutex_;
+        std::vector<boost::shared_ptr<local::io_job> > io_jobs_;
+
+        local::node_arena * node_arena_;
 
     public:
         explicit scene(openvrml::browser & browser, scene * parent = 0)
@@ -57,6 +69,9 @@ namespace openvrml {
         openvrml::browser & browser() const OPENVRML_NOTHROW;
         scene * parent() const OPENVRML_NOTHROW;
         void load(resource_istream & in);
+        void load_async(const std::vector<std::string> & url,
+                        float priority = 0.0f)
+            OPENVRML_THROW2(std::bad_alloc, boost::thread_resource_error);
         void initialize(double timestamp) OPENVRML_THROW1(std::bad_alloc);
         const std::string meta(const std::string & key) const
             OPENVRML_THROW2(std::invalid_argument, std::bad_alloc);
@@ -74,11 +89,14 @@ namespace openvrml {
         void load_url(const std::vector<std::string> & url,
                       const std::vector<std::string> & parameter)
             OPENVRML_THROW1(std::bad_alloc);
+        const std::string resolve_url(const std::string & url) const
+            OPENVRML_THROW2(std::runtime_error, std::bad_alloc);
         std::auto_ptr<resource_istream>
         get_resource(const std::vector<std::string> & url) const
             OPENVRML_THROW2(no_alternative_url, std::bad_alloc);
         void read_stream(std::auto_ptr<resource_istream> in,
-                         std::auto_ptr<stream_listener> listener);
+                         std::auto_ptr<stream_listener> listener,
+                         float priority = 0.0f);
         void create_vrml_from_url(const std::vector<std::string> & url,
                                   const boost::intrusive_ptr<node> & node,
                                   const std::string & event)
@@ -87,6 +105,14 @@ namespace openvrml {
         void shutdown(double timestamp) OPENVRML_NOTHROW;
 
     private:
+        void post_io_job(const boost::function0<void> & job, float priority)
+            OPENVRML_THROW2(std::bad_alloc, boost::thread_resource_error);
+        const boost::shared_ptr<local::io_job>
+        defer_io_job(const boost::function0<void> & job,
+                     float priority,
+                     const boost::posix_time::time_duration & delay)
+            OPENVRML_THROW2(std::bad_alloc, boost::thread_resource_error);
+
         virtual void scene_loaded();
     };
 }
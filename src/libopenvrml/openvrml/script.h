@@ -237,13 +237,16 @@ namespace openvrml {
         };
 
         class url_changed_emitter : public openvrml::mfstring_emitter {
+            script_node * node_;
+
         public:
-            explicit url_changed_emitter(const mfstring & value)
+            url_changed_emitter(script_node & node, const mfstring & value)
                 OPENVRML_NOTHROW;
             virtual ~url_changed_emitter() OPENVRML_NOTHROW;
 
         private:
             virtual const std::string do_eventout_id() const OPENVRML_NOTHROW;
+            virtual openvrml::node * do_node() const OPENVRML_NOTHROW;
         };
 
         class set_metadata_listener :
@@ -260,13 +263,17 @@ namespace openvrml {
         };
 
         class metadata_changed_emitter : public openvrml::sfnode_emitter {
+            script_node * node_;
+
         public:
-            explicit metadata_changed_emitter(const sfnode & value)
+            metadata_changed_emitter(script_node & node,
+                                     const sfnode & value)
                 OPENVRML_NOTHROW;
             virtual ~metadata_changed_emitter() OPENVRML_NOTHROW;
 
         private:
             virtual const std::string do_eventout_id() const OPENVRML_NOTHROW;
+            virtual openvrml::node * do_node() const OPENVRML_NOTHROW;
         };
 
         script_node_type type_;
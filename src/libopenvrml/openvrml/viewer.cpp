@@ -31,6 +31,7 @@
 
 # include <private.h>
 # include "viewer.h"
+# include "compiled_mesh.h"
 
 /**
  * @class openvrml::viewer openvrml/viewer.h
@@ -45,6 +46,12 @@
  *        associated.
  */
 
+/**
+ * @var std::size_t openvrml::viewer::state_changes_
+ *
+ * @brief The number of state changes made in the current frame.
+ */
+
 /**
  * @var openvrml::frustum openvrml::viewer::frustum_
  *
@@ -109,7 +116,8 @@
  * @brief Construct.
  */
 openvrml::viewer::viewer() OPENVRML_NOTHROW:
-    browser_(0)
+    browser_(0),
+    state_changes_(0)
 {}
 
 /**
@@ -131,6 +139,21 @@ openvrml::browser * openvrml::viewer::browser() const OPENVRML_NOTHROW
     return this->browser_;
 }
 
+/**
+ * @brief The number of state changes made in the current frame.
+ *
+ * Each call to @c #enable_lighting, @c #set_material, @c #set_material_mode,
+ * @c #insert_texture, @c #set_texture_transform, or @c #set_color is a state
+ * change.  The count is reset when the @c browser starts rendering a frame;
+ * once @c browser::render returns, it is the number made for that frame.
+ *
+ * @return the number of state changes made in the current frame.
+ */
+std::size_t openvrml::viewer::state_changes() const OPENVRML_NOTHROW
+{
+    return this->state_changes_;
+}
+
 /**
  * @brief Get the rendering mode.
  *
@@ -566,6 +589,57 @@ void openvrml::viewer::insert_sphere(const geometry_node & n,
  * @param[in] radius    sphere radius.
  */
 
+/**
+ * @brief Insert a geometry node's compiled mesh into a display list.
+ *
+ * This function delegates to @c viewer::do_insert_mesh.
+ *
+ * @param[in] n     a @c geometry_node.
+ * @param[in] mesh  the mesh compiled for @p n.
+ */
+void openvrml::viewer::insert_mesh(const geometry_node & n,
+                                   const compiled_mesh & mesh)
+{
+    this->do_insert_mesh(n, mesh);
+}
+
+/**
+ * @brief Insert a geometry node's compiled mesh into a display list.
+ *
+ * A geometry node's mesh is what it inserts with @c #insert_box,
+ * @c #insert_shell and so on, tessellated into triangles.  This
+ * implementation inserts the triangles with @c #insert_shell; a viewer that
+ * draws compiled meshes can do better.
+ *
+ * @param[in] n     a @c geometry_node.
+ * @param[in] mesh  the mesh compiled for @p n.
+ */
+void openvrml::viewer::do_insert_mesh(const geometry_node & n,
+                                      const compiled_mesh & mesh)
+{
+    std::vector<int32> coord_index;
+    coord_index.reserve(mesh.triangle_index.size() / 3 * 4);
+    for (std::size_t i = 0; i + 2 < mesh.triangle_index.size(); i += 3) {
+        coord_index.push_back(mesh.triangle_index[i]);
+        coord_index.push_back(mesh.triangle_index[i + 1]);
+        coord_index.push_back(mesh.triangle_index[i + 2]);
+        coord_index.push_back(-1);
+    }
+
+    unsigned int mask =
+        mask_convex | mask_color_per_vertex | mask_normal_per_vertex;
+    if (mesh.ccw) { mask |= mask_ccw; }
+    if (mesh.solid) { mask |= mask_solid; }
+
+    const std::vector<int32> per_vertex;
+    this->insert_shell(n,
+                       mask,
+                       mesh.coord, coord_index,
+                       mesh.color, per_vertex,
+                       mesh.normal, per_vertex,
+                       mesh.tex_coord, per_vertex);
+}
+
 /**
  * @brief Insert a directional light into a display list.
  *
@@ -719,6 +793,7 @@ void openvrml::viewer::remove_object(const node & ref)
  */
 void openvrml::viewer::enable_lighting(const bool val)
 {
+    ++this->state_changes_;
     this->do_enable_lighting(val);
 }
 
@@ -768,6 +843,7 @@ void openvrml::viewer::set_fog(const color & color,
  */
 void openvrml::viewer::set_color(const color & rgb, float a)
 {
+    ++this->state_changes_;
     this->do_set_color(rgb, a);
 }
 
@@ -799,6 +875,7 @@ void openvrml::viewer::set_material(const float ambient_intensity,
                                     const color & specular_color,
                                     const float transparency)
 {
+    ++this->state_changes_;
     this->do_set_material(ambient_intensity,
                           diffuse_color,
                           emissive_color,
@@ -831,6 +908,7 @@ void openvrml::viewer::set_material(const float ambient_intensity,
 void openvrml::viewer::set_material_mode(const size_t tex_components,
                                          const bool geometry_color)
 {
+    ++this->state_changes_;
     this->do_set_material_mode(tex_components, geometry_color);
 }
 
@@ -874,6 +952,7 @@ void openvrml::viewer::set_sensitive(node * const object)
 void openvrml::viewer::insert_texture(const texture_node & n,
                                       const bool retainHint)
 {
+    ++this->state_changes_;
     return this->do_insert_texture(n, retainHint);
 }
 
@@ -921,6 +1000,7 @@ void openvrml::viewer::set_texture_transform(const vec2f & center,
                                              const vec2f & scale,
                                              const vec2f & translation)
 {
+    ++this->state_changes_;
     this->do_set_texture_transform(center, rotation, scale, translation);
 }
 
@@ -33,11 +33,13 @@ namespace openvrml {
     class background_node;
     class geometry_node;
     class texture_node;
+    class compiled_mesh;
 
     class OPENVRML_API viewer : boost::noncopyable {
         friend class browser;
 
         openvrml::browser * browser_;
+        std::size_t state_changes_;
 
     protected:
         openvrml::frustum frustum_;
@@ -63,6 +65,7 @@ namespace openvrml {
         virtual ~viewer() OPENVRML_NOTHROW = 0;
 
         openvrml::browser * browser() const OPENVRML_NOTHROW;
+        std::size_t state_changes() const OPENVRML_NOTHROW;
 
         rendering_mode mode();
         double frame_rate();
@@ -112,6 +115,7 @@ namespace openvrml {
                           const std::vector<vec2f> & tex_coord,
                           const std::vector<int32> & tex_coord_index);
         void insert_sphere(const geometry_node & n, float radius);
+        void insert_mesh(const geometry_node & n, const compiled_mesh & mesh);
         void insert_dir_light(float ambient_intensity,
                               float intensity,
                               const color & color,
@@ -255,6 +259,8 @@ namespace openvrml {
                              const std::vector<int32> & tex_coord_index) = 0;
         virtual
         void do_insert_sphere(const geometry_node & n, float radius) = 0;
+        virtual void do_insert_mesh(const geometry_node & n,
+                                    const compiled_mesh & mesh);
 
         virtual void do_insert_dir_light(float ambient_intensity,
                                          float intensity,
@@ -836,10 +836,12 @@ namespace openvrml {
 
         vrml_scene
             =  g(
-                    profile_statement[on_profile_statement]
+                    eps_p[this->on_scene_start]
+                    >> profile_statement[on_profile_statement]
                     >> *component_statement[on_component_statement]
                     >> *meta_statement[on_meta_statement]
                     >> *statement >> end_p
+                    >> eps_p[this->on_scene_finish]
                 )[self.vrml97_g.error_handler]
             ;
 
@@ -0,0 +1,108 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML Control
+//
+// Copyright 2009  Braden N. McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# include "bounded_buffer.h"
+
+openvrml_control::bounded_streambuf::bounded_streambuf():
+    eof_(false)
+{
+    this->setg(this->get_area_, this->get_area_, this->get_area_);
+}
+
+openvrml_control::bounded_streambuf::~bounded_streambuf()
+{}
+
+//
+// Block until all of data has been copied into the buffer.
+//
+void openvrml_control::bounded_streambuf::write(const char_type * const data,
+                                                const size_t n)
+{
+    this->buf_.write(data, n);
+}
+
+void openvrml_control::bounded_streambuf::set_eof()
+{
+    this->buf_.set_eof();
+}
+
+//
+// Whether reading will not block: there is data in the get area or the
+// ring buffer, or the end of the stream has been reached.
+//
+// It may seem a bit counterintuitive to return true at EOF; however, if we
+// don't return true in this case, clients may never get EOF from the
+// stream.
+//
+bool openvrml_control::bounded_streambuf::data_available() const
+{
+    //
+    // underflow moves up to a buffer's worth into the get area at once;
+    // what is left there after a get has not been delivered yet.
+    //
+    return this->egptr() > this->gptr()
+        || this->buf_.buffered() > 0
+        || this->buf_.eof();
+}
+
+//
+// Call callback once data_available would return true.  This is called from
+// the reading thread; callback may be called from the writing thread.
+//
+void
+openvrml_control::bounded_streambuf::
+notify_data_available(const boost::function0<void> & callback)
+{
+    if (this->egptr() > this->gptr()) {
+        callback();
+        return;
+    }
+    this->buf_.notify_readable(callback);
+}
+
+std::streamsize openvrml_control::bounded_streambuf::showmanyc()
+{
+    //
+    // Let readsome take whatever has been written but not yet moved into
+    // the get area.
+    //
+    const size_t buffered = this->buf_.buffered();
+    if (buffered > 0) { return std::streamsize(buffered); }
+    return this->buf_.eof() ? -1 : 0;
+}
+
+openvrml_control::bounded_streambuf::int_type
+openvrml_control::bounded_streambuf::underflow()
+{
+    if (this->eof_) { return traits_type::eof(); }
+
+    //
+    // Take everything that has been written so far (up to the size of the
+    // get area), rather than a character at a time.
+    //
+    const size_t n = this->buf_.read(this->get_area_, buffer_t::size);
+    if (n == 0) {
+        this->eof_ = true;
+        return traits_type::eof();
+    }
+
+    this->setg(this->get_area_, this->get_area_, this->get_area_ + n);
+    return traits_type::to_int_type(*this->gptr());
+}
@@ -0,0 +1,212 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML Control
+//
+// Copyright 2009  Braden N. McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# ifndef OPENVRML_CONTROL_BOUNDED_BUFFER_H
+#   define OPENVRML_CONTROL_BOUNDED_BUFFER_H
+
+#   include <openvrml-common.h>
+#   include <boost/function.hpp>
+#   include <boost/thread/condition_variable.hpp>
+#   include <boost/thread/mutex.hpp>
+#   include <algorithm>
+#   include <cstddef>
+#   include <streambuf>
+
+namespace openvrml_control {
+
+    //
+    // A ring buffer between the thread calling browser::write and the thread
+    // reading the stream.  Data is transferred in spans rather than a
+    // character at a time, and each side wakes the other at most once per
+    // span.
+    //
+    template <typename CharT, size_t BufferSize>
+    class bounded_buffer {
+        mutable boost::mutex mutex_;
+        boost::condition_variable buffer_not_full_, buffer_not_empty_or_eof_;
+
+        CharT buf_[BufferSize];
+        size_t begin_, end_, buffered_;
+        bool eof_;
+        boost::function0<void> readable_;
+
+    public:
+        typedef CharT char_type;
+        typedef typename std::char_traits<char_type> traits_type;
+        typedef typename traits_type::int_type int_type;
+
+        static const size_t size = BufferSize;
+
+        bounded_buffer();
+        void write(const char_type * data, size_t n);
+        size_t read(char_type * data, size_t n);
+        size_t buffered() const;
+        void set_eof();
+        bool eof() const;
+        void notify_readable(const boost::function0<void> & callback);
+    };
+
+    template <typename CharT, size_t BufferSize>
+    bounded_buffer<CharT, BufferSize>::bounded_buffer():
+        begin_(0),
+        end_(0),
+        buffered_(0),
+        eof_(false)
+    {}
+
+    //
+    // Block until all of data has been copied into the buffer.
+    //
+    template <typename CharT, size_t BufferSize>
+    void bounded_buffer<CharT, BufferSize>::write(const char_type * data,
+                                                  size_t n)
+    {
+        boost::mutex::scoped_lock lock(this->mutex_);
+        while (n > 0) {
+            while (this->buffered_ == BufferSize) {
+                this->buffer_not_full_.wait(lock);
+            }
+            const bool was_empty = (this->buffered_ == 0);
+            size_t span = BufferSize - this->buffered_;
+            if (span > n) { span = n; }
+            const size_t first = (std::min)(span, BufferSize - this->end_);
+            std::copy(data, data + first, this->buf_ + this->end_);
+            std::copy(data + first, data + span, this->buf_);
+            this->end_ = (this->end_ + span) % BufferSize;
+            this->buffered_ += span;
+            data += span;
+            n -= span;
+            if (was_empty) {
+                this->buffer_not_empty_or_eof_.notify_all();
+                if (this->readable_) {
+                    boost::function0<void> readable;
+                    readable.swap(this->readable_);
+                    lock.unlock();
+                    readable();
+                    lock.lock();
+                }
+            }
+        }
+    }
+
+    //
+    // Block until data is available or EOF has been set; then copy up to n
+    // characters out of the buffer.  Returns the number of characters
+    // copied, which is 0 only at EOF.
+    //
+    template <typename CharT, size_t BufferSize>
+    size_t bounded_buffer<CharT, BufferSize>::read(char_type * const data,
+                                                   const size_t n)
+    {
+        boost::mutex::scoped_lock lock(this->mutex_);
+        while (this->buffered_ == 0 && !this->eof_) {
+            this->buffer_not_empty_or_eof_.wait(lock);
+        }
+        const bool was_full = (this->buffered_ == BufferSize);
+        const size_t span = (std::min)(n, this->buffered_);
+        const size_t first = (std::min)(span, BufferSize - this->begin_);
+        std::copy(this->buf_ + this->begin_,
+                  this->buf_ + this->begin_ + first,
+                  data);
+        std::copy(this->buf_, this->buf_ + (span - first), data + first);
+        this->begin_ = (this->begin_ + span) % BufferSize;
+        this->buffered_ -= span;
+        if (was_full && span > 0) { this->buffer_not_full_.notify_all(); }
+        return span;
+    }
+
+    template <typename CharT, size_t BufferSize>
+    size_t bounded_buffer<CharT, BufferSize>::buffered() const
+    {
+        boost::mutex::scoped_lock lock(this->mutex_);
+        return this->buffered_;
+    }
+
+    template <typename CharT, size_t BufferSize>
+    void bounded_buffer<CharT, BufferSize>::set_eof()
+    {
+        boost::function0<void> readable;
+        {
+            boost::mutex::scoped_lock lock(this->mutex_);
+            this->eof_ = true;
+            this->buffer_not_empty_or_eof_.notify_all();
+            readable.swap(this->readable_);
+        }
+        if (readable) { readable(); }
+    }
+
+    template <typename CharT, size_t BufferSize>
+    bool bounded_buffer<CharT, BufferSize>::eof() const
+    {
+        boost::mutex::scoped_lock lock(this->mutex_);
+        return this->eof_;
+    }
+
+    //
+    // Call callback once there is data to read or EOF has been set: from
+    // the writing thread, with the buffer unlocked; or from this one, if
+    // that is so already.  A callback given earlier and not yet called is
+    // replaced.
+    //
+    template <typename CharT, size_t BufferSize>
+    void
+    bounded_buffer<CharT, BufferSize>::
+    notify_readable(const boost::function0<void> & callback)
+    {
+        {
+            boost::mutex::scoped_lock lock(this->mutex_);
+            if (this->buffered_ == 0 && !this->eof_) {
+                this->readable_ = callback;
+                return;
+            }
+        }
+        callback();
+    }
+
+    //
+    // A streambuf that reads what is written to a bounded_buffer, a span at
+    // a time.  write and set_eof are called from the writing thread; the
+    // rest from the reading thread.
+    //
+    class OPENVRML_LOCAL bounded_streambuf : public std::streambuf {
+    public:
+        typedef bounded_buffer<char_type, 16384> buffer_t;
+
+    private:
+        buffer_t buf_;
+        bool eof_;
+        char_type get_area_[buffer_t::size];
+
+    public:
+        bounded_streambuf();
+        virtual ~bounded_streambuf();
+
+        void write(const char_type * data, size_t n);
+        void set_eof();
+        bool data_available() const;
+        void notify_data_available(const boost::function0<void> & callback);
+
+    protected:
+        virtual std::streamsize showmanyc();
+        virtual int_type underflow();
+    };
+}
+
+# endif // ifndef OPENVRML_CONTROL_BOUNDED_BUFFER_H
@@ -19,9 +19,11 @@
 //
 
 # include "browser.h"
+# include "bounded_buffer.h"
 # include <boost/enable_shared_from_this.hpp>
 # include <boost/lexical_cast.hpp>
 # include <boost/thread.hpp>
+# include <algorithm>
 # include <iostream>
 
 openvrml_control::unknown_stream::unknown_stream(const std::string & uri):
@@ -79,97 +81,10 @@ openvrml_control::unknown_stream::~unknown_stream() throw ()
 // plugin_streambuf is removed, the plugin_streambuf is deleted.
 //
 
-namespace {
-
-    template <typename CharT, size_t BufferSize>
-    class bounded_buffer {
-        mutable boost::mutex mutex_;
-        boost::condition_variable buffer_not_full_, buffer_not_empty_or_eof_;
-
-        CharT buf_[BufferSize];
-        size_t begin_, end_, buffered_;
-        bool eof_;
-
-    public:
-        typedef CharT char_type;
-        typedef typename std::char_traits<char_type> traits_type;
-        typedef typename traits_type::int_type int_type;
-
-        bounded_buffer();
-        void put(const char_type & c);
-        int_type get();
-        size_t buffered() const;
-        void set_eof();
-        bool eof() const;
-    };
-
-    template <typename CharT, size_t BufferSize>
-    bounded_buffer<CharT, BufferSize>::bounded_buffer():
-        begin_(0),
-        end_(0),
-        buffered_(0),
-        eof_(false)
-    {}
-
-    template <typename CharT, size_t BufferSize>
-    void bounded_buffer<CharT, BufferSize>::put(const char_type & c)
-    {
-        boost::mutex::scoped_lock lock(this->mutex_);
-        while (this->buffered_ == BufferSize) {
-            this->buffer_not_full_.wait(lock);
-        }
-        this->buf_[this->end_] = c;
-        this->end_ = (this->end_ + 1) % BufferSize;
-        ++this->buffered_;
-        this->buffer_not_empty_or_eof_.notify_one();
-    }
-
-    template <typename CharT, size_t BufferSize>
-    typename bounded_buffer<CharT, BufferSize>::int_type
-    bounded_buffer<CharT, BufferSize>::get()
-    {
-        boost::mutex::scoped_lock lock(this->mutex_);
-        while (this->buffered_ == 0 && !this->eof_) {
-            this->buffer_not_empty_or_eof_.wait(lock);
-        }
-        if (this->buffered_ == 0 && this->eof_) {
-            return traits_type::eof();
-        }
-        const int_type c = traits_type::to_int_type(this->buf_[this->begin_]);
-        this->begin_ = (this->begin_ + 1) % BufferSize;
-        --this->buffered_;
-        this->buffer_not_full_.notify_one();
-        assert(!traits_type::eq_int_type(c, traits_type::eof()));
-        return c;
-    }
-
-    template <typename CharT, size_t BufferSize>
-    size_t bounded_buffer<CharT, BufferSize>::buffered() const
-    {
-        boost::mutex::scoped_lock lock(this->mutex_);
-        return this->buffered_;
-    }
-
-    template <typename CharT, size_t BufferSize>
-    void bounded_buffer<CharT, BufferSize>::set_eof()
-    {
-        boost::mutex::scoped_lock lock(this->mutex_);
-        this->eof_ = true;
-        this->buffer_not_empty_or_eof_.notify_one();
-    }
-
-    template <typename CharT, size_t BufferSize>
-    bool bounded_buffer<CharT, BufferSize>::eof() const
-    {
-        boost::mutex::scoped_lock lock(this->mutex_);
-        return this->eof_;
-    }
-}
-
 class OPENVRML_LOCAL openvrml_control::browser::plugin_streambuf :
     public boost::enable_shared_from_this<
         openvrml_control::browser::plugin_streambuf>,
-    public std::streambuf {
+    public bounded_streambuf {
 
     friend class openvrml_control::browser;
 
@@ -188,9 +103,6 @@ private:
     mutable boost::condition_variable streambuf_initialized_or_failed_;
     std::string url_;
     std::string type_;
-    bounded_buffer<char_type, 16384> buf_;
-    int_type i_;
-    char_type c_;
     uninitialized_plugin_streambuf_map & uninitialized_map_;
     plugin_streambuf_map & map_;
 
@@ -209,7 +121,6 @@ public:
     void fail();
     const std::string & url() const;
     const std::string & type() const;
-    bool data_available() const;
 };
 
 openvrml_control::browser::plugin_streambuf::
@@ -219,21 +130,9 @@ plugin_streambuf(const std::string & requested_url,
     state_(requested),
     get_url_result_(-1),
     url_(requested_url),
-    i_(0),
-    c_('\0'),
     uninitialized_map_(uninitialized_map),
     map_(map)
-{
-    //
-    // This is really just here to emphasize that c_ must not be EOF.
-    //
-    this->i_ = traits_type::not_eof(this->i_);
-    this->c_ =
-        traits_type::to_char_type(
-            traits_type::not_eof(traits_type::to_int_type(this->c_)));
-
-    this->setg(&this->c_, &this->c_, &this->c_);
-}
+{}
 
 openvrml_control::browser::plugin_streambuf::state_id
 openvrml_control::browser::plugin_streambuf::state() const
@@ -303,7 +202,7 @@ void openvrml_control::browser::plugin_streambuf::fail()
     boost::mutex::scoped_lock lock(this->mutex_);
     const bool succeeded = this->uninitialized_map_.erase(*this);
     assert(succeeded);
-    this->buf_.set_eof();
+    this->set_eof();
     this->streambuf_initialized_or_failed_.notify_all();
 }
 
@@ -325,37 +224,16 @@ const std::string & openvrml_control::browser::plugin_streambuf::type() const
     return this->type_;
 }
 
-bool openvrml_control::browser::plugin_streambuf::data_available() const
-{
-    //
-    // It may seem a bit counterintuitive to return true here if the stream
-    // has been destroyed; however, if we don't return true in this case,
-    // clients may never get EOF from the stream.
-    //
-    return this->buf_.buffered() > 0 || this->buf_.eof();
-}
-
 openvrml_control::browser::plugin_streambuf::int_type
 openvrml_control::browser::plugin_streambuf::underflow()
 {
-    boost::mutex::scoped_lock lock(this->mutex_);
-    while (this->state_ != plugin_streambuf::initialized) {
-        this->streambuf_initialized_or_failed_.wait(lock);
-    }
-
-    if (traits_type::eq_int_type(this->i_, traits_type::eof())) {
-        return traits_type::eof();
-    }
-
-    this->i_ = this->buf_.get();
-    this->c_ = traits_type::to_char_type(this->i_);
-
-    if (traits_type::eq_int_type(this->i_, traits_type::eof())) {
-        return traits_type::eof();
+    {
+        boost::mutex::scoped_lock lock(this->mutex_);
+        while (this->state_ != plugin_streambuf::initialized) {
+            this->streambuf_initialized_or_failed_.wait(lock);
+        }
     }
-
-    this->setg(&this->c_, &this->c_, &this->c_ + 1);
-    return traits_type::to_int_type(*this->gptr());
+    return this->bounded_streambuf::underflow();
 }
 
 const boost::shared_ptr<openvrml_control::browser::plugin_streambuf>
@@ -560,6 +438,14 @@ do_get_resource(const std::string & uri)
         {
             return this->streambuf_->data_available();
         }
+
+        virtual bool
+        do_notify_data_available(const boost::function0<void> & callback)
+            OPENVRML_THROW1(std::bad_alloc)
+        {
+            this->streambuf_->notify_data_available(callback);
+            return true;
+        }
     };
     return std::auto_ptr<openvrml::resource_istream>(
         new plugin_resource_istream(uri, *this));
@@ -659,8 +545,9 @@ openvrml_control::browser::browser(browser_host & host,
     fetcher_(host,
              this->uninitialized_streambuf_map_,
              this->streambuf_map_),
+    cache_(this->fetcher_),
     listener_(*this),
-    browser_(this->fetcher_, std::cout, std::cerr),
+    browser_(this->cache_, std::cout, std::cerr),
     host_(host),
     expect_initial_stream_(expect_initial_stream),
     got_initial_stream_(false)
@@ -738,7 +625,7 @@ void openvrml_control::browser::destroy_stream(const uint64_t stream_id)
     const shared_ptr<plugin_streambuf> streambuf =
         this->streambuf_map_.find(stream_id);
     if (!streambuf) { throw unknown_stream(stream_id); }
-    streambuf->buf_.set_eof();
+    streambuf->set_eof();
     this->streambuf_map_.erase(stream_id);
 }
 
@@ -752,7 +639,7 @@ void openvrml_control::browser::write(const uint64_t stream_id,
     const shared_ptr<plugin_streambuf> streambuf =
         this->streambuf_map_.find(stream_id);
     if (!streambuf) { throw unknown_stream(stream_id); }
-    for (size_t i = 0; i < size; ++i) { streambuf->buf_.put(data[i]); }
+    streambuf->write(reinterpret_cast<const char *>(data), size);
 }
 
 struct OPENVRML_LOCAL openvrml_control::browser::load_url {
@@ -772,6 +659,11 @@ struct OPENVRML_LOCAL openvrml_control::browser::load_url {
                     lock(this->browser_.initialized_mutex_);
                 this->browser_.initialized_ = false;
             }
+            //
+            // The world and what it uses may have changed since they were
+            // cached; a reload must not show the old content.
+            //
+            this->browser_.cache_.clear();
             this->browser_.browser_.load_url(this->url_, this->parameter_);
         } catch (std::exception & ex) {
             this->browser_.browser_.err(ex.what());
@@ -110,6 +110,7 @@ namespace openvrml_control {
             uninitialized_streambuf_map_;
         plugin_streambuf_map streambuf_map_;
         resource_fetcher fetcher_;
+        openvrml::resource_cache cache_;
         browser_listener listener_;
         openvrml::browser browser_;
         browser_host & host_;
@@ -87,6 +87,9 @@ namespace openvrml_node_vrml97 {
 
         virtual bool do_modified() const
             OPENVRML_THROW1(boost::thread_resource_error);
+
+    private:
+        virtual void do_coord_index_changed() OPENVRML_NOTHROW;
     };
 
     /**
@@ -186,6 +189,7 @@ namespace openvrml_node_vrml97 {
             dynamic_cast<abstract_indexed_set_node *>(&this->node());
         assert(abstract_indexed_set);
         abstract_indexed_set->coord_index_ = coord_index;
+        abstract_indexed_set->do_coord_index_changed();
         abstract_indexed_set->node::modified(true);
     }
 
@@ -274,6 +278,17 @@ namespace openvrml_node_vrml97 {
             || (this->coord_.value() && this->coord_.value()->modified());
     }
 
+    /**
+     * @brief Called when the coordIndex field changes.
+     *
+     * Subclasses that keep state derived from the coordinate indices
+     * override this to discard it.  This implementation does nothing.
+     */
+    template <typename Derived>
+    void abstract_indexed_set_node<Derived>::do_coord_index_changed()
+        OPENVRML_NOTHROW
+    {}
+
     /**
      * @brief color_node.
      *
@@ -21,6 +21,7 @@
 
 # include "elevation_grid.h"
 # include <private.h>
+# include <openvrml/mesh.h>
 # include <openvrml/node_impl_util.h>
 # include <openvrml/viewer.h>
 # include <boost/array.hpp>
@@ -64,6 +65,11 @@ namespace {
         openvrml::sfint32 z_dimension_;
         openvrml::sffloat z_spacing_;
 
+        std::vector<openvrml::vec3f> mesh_coord_;
+        std::vector<openvrml::int32> mesh_coord_index_;
+        std::vector<openvrml::vec2f> mesh_tex_coord_;
+        openvrml::normal_cache generated_normals_;
+
     public:
         elevation_grid_node(const openvrml::node_type & type,
                             const boost::shared_ptr<openvrml::scope> & scope);
@@ -75,6 +81,8 @@ namespace {
 
         virtual void do_render_geometry(openvrml::viewer & viewer,
                                         openvrml::rendering_context context);
+
+        void generate_mesh() OPENVRML_THROW1(std::bad_alloc);
     };
 
     /**
@@ -134,6 +142,7 @@ namespace {
                 dynamic_cast<elevation_grid_node &>(this->node());
 
             elevation_grid.height_ = height;
+            elevation_grid.generated_normals_.invalidate();
             elevation_grid.node::modified(true);
 
         } catch (std::bad_cast & ex) {
@@ -225,6 +234,33 @@ namespace {
      * @brief zSpacing field.
      */
 
+    /**
+     * @var std::vector<openvrml::vec3f> elevation_grid_node::mesh_coord_
+     *
+     * @brief Coordinates of the grid points, when the grid is drawn with
+     *        generated normals.
+     */
+
+    /**
+     * @var std::vector<openvrml::int32> elevation_grid_node::mesh_coord_index_
+     *
+     * @brief Coordinate indices of the grid's quadrilaterals, when the grid
+     *        is drawn with generated normals.
+     */
+
+    /**
+     * @var std::vector<openvrml::vec2f> elevation_grid_node::mesh_tex_coord_
+     *
+     * @brief Default texture coordinates of the grid points, when the grid
+     *        is drawn with generated normals.
+     */
+
+    /**
+     * @var openvrml::normal_cache elevation_grid_node::generated_normals_
+     *
+     * @brief Normals generated when the normal field is @c NULL.
+     */
+
     /**
      * @brief Construct.
      *
@@ -273,9 +309,69 @@ namespace {
                 && this->tex_coord_.value()->modified());
     }
 
+    /**
+     * @brief Build the grid as a polygon mesh and generate its normals.
+     *
+     * The quadrilaterals are ordered as the colors of a grid with a color
+     * per face: with the <var>x</var> index varying fastest.
+     *
+     * @exception std::bad_alloc    if memory allocation fails.
+     *
+     * @pre The grid has at least two points in each dimension and a height
+     *      for each point.
+     */
+    void elevation_grid_node::generate_mesh() OPENVRML_THROW1(std::bad_alloc)
+    {
+        using std::vector;
+        using openvrml::int32;
+        using openvrml::make_vec2f;
+        using openvrml::make_vec3f;
+
+        const int32 nx = this->x_dimension_.value();
+        const int32 nz = this->z_dimension_.value();
+        const float dx = this->x_spacing_.value();
+        const float dz = this->z_spacing_.value();
+        const vector<float> & height = this->height_.mffloat::value();
+        assert(nx > 1 && nz > 1);
+        assert(height.size() >= std::size_t(nx) * std::size_t(nz));
+
+        this->mesh_coord_.resize(std::size_t(nx) * std::size_t(nz));
+        this->mesh_tex_coord_.resize(this->mesh_coord_.size());
+        for (int32 j = 0; j < nz; ++j) {
+            for (int32 i = 0; i < nx; ++i) {
+                const std::size_t k = std::size_t(j) * nx + i;
+                this->mesh_coord_[k] = make_vec3f(dx * i, height[k], dz * j);
+                this->mesh_tex_coord_[k] = make_vec2f(float(i) / (nx - 1),
+                                                      float(j) / (nz - 1));
+            }
+        }
+
+        this->mesh_coord_index_.clear();
+        this->mesh_coord_index_.reserve(std::size_t(nx - 1) * (nz - 1) * 5);
+        for (int32 j = 0; j < nz - 1; ++j) {
+            for (int32 i = 0; i < nx - 1; ++i) {
+                this->mesh_coord_index_.push_back(j * nx + i);
+                this->mesh_coord_index_.push_back((j + 1) * nx + i);
+                this->mesh_coord_index_.push_back((j + 1) * nx + i + 1);
+                this->mesh_coord_index_.push_back(j * nx + i + 1);
+                this->mesh_coord_index_.push_back(-1);
+            }
+        }
+
+        this->generated_normals_.generate(0,
+                                          this->mesh_coord_,
+                                          this->mesh_coord_index_,
+                                          this->crease_angle_.value(),
+                                          this->ccw_.value());
+    }
+
     /**
      * @brief Insert this geometry into @p viewer's display list.
      *
+     * If the normal field is @c NULL and normalPerVertex is @c TRUE, the
+     * grid is inserted as a shell with per-vertex normals generated using
+     * creaseAngle.
+     *
      * @param v         a viewer.
      * @param context   the rendering context.
      */
@@ -329,16 +425,37 @@ namespace {
                 optMask |= viewer::mask_normal_per_vertex;
             }
 
-            v.insert_elevation_grid(*this,
-                                    optMask,
-                                    this->height_.mffloat::value(),
-                                    this->x_dimension_.sfint32::value(),
-                                    this->z_dimension_.sfint32::value(),
-                                    this->x_spacing_.sffloat::value(),
-                                    this->z_spacing_.sffloat::value(),
-                                    color,
-                                    normal,
-                                    texCoord);
+            const openvrml::int32 nx = this->x_dimension_.value();
+            const openvrml::int32 nz = this->z_dimension_.value();
+            if (!normalNode && this->normal_per_vertex_.value()
+                && nx > 1 && nz > 1
+                && this->height_.mffloat::value().size()
+                   >= std::size_t(nx) * std::size_t(nz)) {
+                if (!this->generated_normals_.valid(0)) {
+                    this->generate_mesh();
+                }
+                static const vector<openvrml::int32> empty_index;
+                v.insert_shell(*this,
+                               optMask | viewer::mask_convex,
+                               this->mesh_coord_,
+                               this->mesh_coord_index_,
+                               color, empty_index,
+                               this->generated_normals_.normal(),
+                               this->generated_normals_.normal_index(),
+                               texCoordNode ? texCoord : this->mesh_tex_coord_,
+                               empty_index);
+            } else {
+                v.insert_elevation_grid(*this,
+                                        optMask,
+                                        this->height_.mffloat::value(),
+                                        this->x_dimension_.sfint32::value(),
+                                        this->z_dimension_.sfint32::value(),
+                                        this->x_spacing_.sffloat::value(),
+                                        this->z_spacing_.sffloat::value(),
+                                        color,
+                                        normal,
+                                        texCoord);
+            }
         }
 
         if (colorNode) { colorNode->modified(false); }
@@ -21,9 +21,11 @@
 
 # include "extrusion.h"
 # include <private.h>
+# include <openvrml/mesh.h>
 # include <openvrml/node_impl_util.h>
 # include <openvrml/viewer.h>
 # include <boost/array.hpp>
+# include <algorithm>
 
 # ifdef HAVE_CONFIG_H
 #   include <config.h>
@@ -101,6 +103,12 @@ namespace {
         openvrml::sfbool solid_;
         openvrml::mfvec3f spine_;
 
+        std::vector<openvrml::vec3f> mesh_coord_;
+        std::vector<openvrml::int32> mesh_coord_index_;
+        std::vector<openvrml::vec2f> mesh_tex_coord_;
+        std::vector<openvrml::int32> mesh_tex_coord_index_;
+        openvrml::normal_cache generated_normals_;
+
     public:
         extrusion_node(const openvrml::node_type & type,
                        const boost::shared_ptr<openvrml::scope> & scope);
@@ -109,6 +117,8 @@ namespace {
     private:
         virtual void do_render_geometry(openvrml::viewer & viewer,
                                         openvrml::rendering_context context);
+
+        void generate_mesh() OPENVRML_THROW1(std::bad_alloc);
     };
 
     /**
@@ -167,6 +177,7 @@ namespace {
             extrusion_node & extrusion =
                 dynamic_cast<extrusion_node &>(this->node());
             extrusion.cross_section_ = cross_section;
+            extrusion.generated_normals_.invalidate();
             extrusion.node::modified(true);
         } catch (std::bad_cast & ex) {
             OPENVRML_PRINT_EXCEPTION_(ex);
@@ -217,6 +228,7 @@ namespace {
             extrusion_node & extrusion =
                 dynamic_cast<extrusion_node &>(this->node());
             extrusion.orientation_ = orientation;
+            extrusion.generated_normals_.invalidate();
             extrusion.node::modified(true);
         } catch (std::bad_cast & ex) {
             OPENVRML_PRINT_EXCEPTION_(ex);
@@ -266,6 +278,7 @@ namespace {
             extrusion_node & extrusion =
                 dynamic_cast<extrusion_node &>(this->node());
             extrusion.scale_ = scale;
+            extrusion.generated_normals_.invalidate();
             extrusion.node::modified(true);
         } catch (std::bad_cast & ex) {
             OPENVRML_PRINT_EXCEPTION_(ex);
@@ -315,6 +328,7 @@ namespace {
             extrusion_node & extrusion =
                 dynamic_cast<extrusion_node &>(this->node());
             extrusion.spine_ = spine;
+            extrusion.generated_normals_.invalidate();
             extrusion.node::modified(true);
         } catch (std::bad_cast & ex) {
             OPENVRML_PRINT_EXCEPTION_(ex);
@@ -405,6 +419,37 @@ namespace {
      * @brief spine field.
      */
 
+    /**
+     * @var std::vector<openvrml::vec3f> extrusion_node::mesh_coord_
+     *
+     * @brief Coordinates of the extrusion.
+     */
+
+    /**
+     * @var std::vector<openvrml::int32> extrusion_node::mesh_coord_index_
+     *
+     * @brief Coordinate indices of the sides and caps.
+     */
+
+    /**
+     * @var std::vector<openvrml::vec2f> extrusion_node::mesh_tex_coord_
+     *
+     * @brief Texture coordinates of the sides, followed by those of the
+     *        caps.
+     */
+
+    /**
+     * @var std::vector<openvrml::int32> extrusion_node::mesh_tex_coord_index_
+     *
+     * @brief Texture coordinate indices of the sides and caps.
+     */
+
+    /**
+     * @var openvrml::normal_cache extrusion_node::generated_normals_
+     *
+     * @brief Normals generated using creaseAngle.
+     */
+
     const openvrml::vec2f extrusionDefaultCrossSection_[] =
     {
         openvrml::make_vec2f(1.0, 1.0),
@@ -470,9 +515,56 @@ namespace {
      */
     extrusion_node::~extrusion_node() OPENVRML_NOTHROW {}
 
+    /**
+     * @brief Build the extrusion as a polygon mesh and generate its normals.
+     *
+     * The faces are those computed by @c openvrml::extrusion_faces.
+     *
+     * @exception std::bad_alloc    if memory allocation fails.
+     *
+     * @pre The cross-section is not empty and the spine has more than one
+     *      point.
+     */
+    void extrusion_node::generate_mesh() OPENVRML_THROW1(std::bad_alloc)
+    {
+        using std::vector;
+        using openvrml::int32;
+        using openvrml::vec2f;
+        using openvrml::make_vec2f;
+
+        const vector<vec2f> & cross_section = this->cross_section_.value();
+        const vector<openvrml::vec3f> & spine = this->spine_.value();
+        assert(!cross_section.empty());
+        assert(spine.size() > 1);
+
+        openvrml::extrusion_coords(cross_section,
+                                   spine,
+                                   this->scale_.value(),
+                                   this->orientation_.value(),
+                                   this->mesh_coord_,
+                                   this->mesh_tex_coord_);
+
+        openvrml::extrusion_faces(cross_section,
+                                  spine.size(),
+                                  this->begin_cap_.value(),
+                                  this->end_cap_.value(),
+                                  this->mesh_coord_index_,
+                                  this->mesh_tex_coord_,
+                                  this->mesh_tex_coord_index_);
+
+        this->generated_normals_.generate(0,
+                                          this->mesh_coord_,
+                                          this->mesh_coord_index_,
+                                          this->crease_angle_.value(),
+                                          this->ccw_.value());
+    }
+
     /**
      * @brief Insert this geometry into @p viewer's display list.
      *
+     * The extrusion is inserted as a shell with per-vertex normals generated
+     * using creaseAngle.
+     *
      * @param v         a viewer.
      * @param context   the rendering context.
      */
@@ -483,19 +575,25 @@ namespace {
 
         if (!this->cross_section_.value().empty()
             && this->spine_.value().size() > 1) {
-            unsigned int optMask = 0;
+            unsigned int optMask = viewer::mask_normal_per_vertex;
             if (this->ccw_.value())       { optMask |= viewer::mask_ccw; }
             if (this->convex_.value())    { optMask |= viewer::mask_convex; }
             if (this->solid_.value())     { optMask |= viewer::mask_solid; }
-            if (this->begin_cap_.value()) { optMask |= viewer::mask_bottom; }
-            if (this->end_cap_.value())   { optMask |= viewer::mask_top; }
-
-            v.insert_extrusion(*this,
-                               optMask,
-                               this->spine_.value(),
-                               this->cross_section_.value(),
-                               this->orientation_.value(),
-                               this->scale_.value());
+
+            if (!this->generated_normals_.valid(0)) { this->generate_mesh(); }
+
+            static const std::vector<openvrml::color> no_color;
+            static const std::vector<openvrml::int32> no_color_index;
+            v.insert_shell(*this,
+                           optMask,
+                           this->mesh_coord_,
+                           this->mesh_coord_index_,
+                           no_color,
+                           no_color_index,
+                           this->generated_normals_.normal(),
+                           this->generated_normals_.normal_index(),
+                           this->mesh_tex_coord_,
+                           this->mesh_tex_coord_index_);
         }
     }
 }
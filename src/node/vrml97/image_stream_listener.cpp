@@ -22,9 +22,11 @@
 #   include <config.h>
 # endif
 
+# include <cstring>
 # include <sstream>
 # include <boost/algorithm/string/predicate.hpp>
 # include <boost/scope_exit.hpp>
+# include <private.h>
 # include "image_stream_listener.h"
 
 openvrml_node_vrml97::image_stream_listener::image_reader::~image_reader()
@@ -33,31 +35,28 @@ openvrml_node_vrml97::image_stream_listener::image_reader::~image_reader()
 
 void
 openvrml_node_vrml97::image_stream_listener::image_reader::
-read(const std::vector<unsigned char> & data)
+read(const unsigned char * const data, const std::size_t size)
 {
-    this->do_read(data);
+    this->do_read(data, size);
+}
+
+//
+// Publish whatever has been decoded, if the decoder has not already done so
+// because the image is complete.
+//
+void openvrml_node_vrml97::image_stream_listener::image_reader::finish()
+{
+    this->do_finish();
 }
 
 # ifdef OPENVRML_ENABLE_PNG_TEXTURES
 void openvrml_png_info_callback(png_structp png_ptr, png_infop info_ptr)
 {
-    using boost::shared_mutex;
-    using boost::unique_lock;
-
     typedef openvrml_node_vrml97::image_stream_listener::png_reader
         png_reader_t;
     png_reader_t & reader =
         *static_cast<png_reader_t *>(png_get_progressive_ptr(png_ptr));
 
-    unique_lock<shared_mutex> lock(reader.stream_listener.image_mutex_);
-
-    openvrml::image & image = reader.stream_listener.image_;
-
-    image.comp(png_get_channels(png_ptr, info_ptr));
-    const size_t width = png_get_image_width(png_ptr, info_ptr);
-    const size_t height = png_get_image_height(png_ptr, info_ptr);
-    image.resize(width, height);
-
     //
     // Strip 16 bit/color files to 8 bit/color.
     //
@@ -76,7 +75,6 @@ void openvrml_png_info_callback(png_structp png_ptr, png_infop info_ptr)
     const png_byte color_type = png_get_color_type(png_ptr, info_ptr);
     if (color_type == PNG_COLOR_TYPE_PALETTE) {
         png_set_expand(png_ptr);
-        image.comp(3);
     } else {
         //
         // Expand grayscale images to the full 8 bits from 1, 2, or
@@ -94,7 +92,6 @@ void openvrml_png_info_callback(png_structp png_ptr, png_infop info_ptr)
     //
     if (png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS)) {
         png_set_expand(png_ptr);
-        image.comp(image.comp() + 1);
     }
 
     if (color_type == PNG_COLOR_TYPE_PALETTE) {
@@ -112,14 +109,6 @@ void openvrml_png_info_callback(png_structp png_ptr, png_infop info_ptr)
         }
     }
 
-    if (reader.gray_palette) {
-        if (image.comp() == 3) {
-            image.comp(1);
-        } else if (image.comp() == 4) {
-            image.comp(2);
-        }
-    }
-
     //
     // Set gamma.
     //
@@ -137,8 +126,20 @@ void openvrml_png_info_callback(png_structp png_ptr, png_infop info_ptr)
     png_read_update_info(png_ptr, info_ptr);
 
     reader.width = png_get_image_width(png_ptr, info_ptr);
+    reader.height = png_get_image_height(png_ptr, info_ptr);
     reader.rowbytes = png_get_rowbytes(png_ptr, info_ptr);
-    reader.old_row.resize(reader.rowbytes);
+    reader.channels = png_get_channels(png_ptr, info_ptr);
+
+    //
+    // Rows are decoded into a private buffer in libpng's own layout, so that
+    // interlaced passes can be combined in place; they are converted to
+    // openvrml::image's layout once, when the image is published.
+    //
+    try {
+        reader.rows.resize(reader.height * reader.rowbytes);
+    } catch (std::bad_alloc &) {
+        png_error(png_ptr, "out of memory");
+    }
 }
 
 void openvrml_png_row_callback(png_structp png_ptr,
@@ -146,9 +147,6 @@ void openvrml_png_row_callback(png_structp png_ptr,
                                png_uint_32 row_num,
                                int /* pass */)
 {
-    using boost::unique_lock;
-    using boost::shared_mutex;
-
     if (!new_row) { return; }
 
     typedef openvrml_node_vrml97::image_stream_listener::png_reader
@@ -156,57 +154,37 @@ void openvrml_png_row_callback(png_structp png_ptr,
     png_reader_t & reader =
         *static_cast<png_reader_t *>(png_get_progressive_ptr(png_ptr));
 
-    unique_lock<shared_mutex> lock(reader.stream_listener.image_mutex_);
-
-    openvrml::image & image = reader.stream_listener.image_;
+    assert(row_num < reader.height);
+    assert(reader.rows.size() == reader.height * reader.rowbytes);
 
-    assert(!reader.old_row.empty());
-
-    png_progressive_combine_row(png_ptr, &reader.old_row.front(), new_row);
+    png_progressive_combine_row(png_ptr,
+                                &reader.rows[row_num * reader.rowbytes],
+                                new_row);
+}
 
-    //
-    // openvrml::image pixels start at the bottom left.
-    //
-    const size_t image_row = (image.y() - 1) - row_num;
-    for (size_t pixel_index = 0, byte_index = 0; pixel_index < reader.width;
-         ++pixel_index) {
-        using openvrml::int32;
-        int32 pixel = 0x00000000;
-        for (size_t component = image.comp();
-             component > 0;
-             --component) {
-            pixel |= int32(new_row[byte_index]) << (8 * (component - 1));
-            if (reader.gray_palette) {
-                if (image.comp() == 1) {
-                    // We just want every third pixel element.
-                    byte_index += 3;
-                } else if (image.comp() == 2) {
-                    // We just want the first and fourth pixel elements.
-                    byte_index += (byte_index % 4 == 0) ? 3 : 1;
-                }
-            } else {
-                ++byte_index;
-            }
-        }
-        image.pixel(image_row * reader.width + pixel_index, pixel);
+void openvrml_png_end_callback(png_structp png_ptr, png_infop)
+{
+    typedef openvrml_node_vrml97::image_stream_listener::png_reader
+        png_reader_t;
+    png_reader_t & reader =
+        *static_cast<png_reader_t *>(png_get_progressive_ptr(png_ptr));
+    try {
+        reader.finish();
+    } catch (std::bad_alloc &) {
+        png_error(png_ptr, "out of memory");
     }
-
-    reader.stream_listener.node_.modified(true);
-
-    assert(reader.old_row.size() >= reader.rowbytes);
-
-    copy(new_row, new_row + reader.rowbytes, reader.old_row.begin());
 }
 
-void openvrml_png_end_callback(png_structp, png_infop)
-{}
-
 openvrml_node_vrml97::image_stream_listener::png_reader::
 png_reader(image_stream_listener & stream_listener):
     png_ptr_(0),
     info_ptr_(0),
     stream_listener(stream_listener),
-    gray_palette(false)
+    gray_palette(false),
+    width(0),
+    height(0),
+    rowbytes(0),
+    channels(0)
 {
     this->png_ptr_ =
         png_create_read_struct(PNG_LIBPNG_VER_STRING, 0, 0, 0);
@@ -237,15 +215,55 @@ openvrml_node_vrml97::image_stream_listener::png_reader::~png_reader()
 
 void
 openvrml_node_vrml97::image_stream_listener::png_reader::
-do_read(const std::vector<unsigned char> & data)
+do_read(const unsigned char * const data, const std::size_t size)
 {
     int jmpval = setjmp(png_jmpbuf(this->png_ptr_));
     if (jmpval != 0) { return; }
 
     png_process_data(this->png_ptr_,
                      this->info_ptr_,
-                     const_cast<png_byte *>(&data[0]),
-                     data.size());
+                     const_cast<png_byte *>(data),
+                     size);
+}
+
+void openvrml_node_vrml97::image_stream_listener::png_reader::do_finish()
+{
+    if (this->rows.empty()) { return; }
+
+    //
+    // A palette that is all grays was expanded to RGB(A); keep only one of
+    // the color channels.
+    //
+    const std::size_t comp = this->gray_palette
+                           ? this->channels - 2
+                           : this->channels;
+
+    std::vector<unsigned char> pixels(this->width * this->height * comp);
+    for (std::size_t row = 0; row < this->height; ++row) {
+        //
+        // openvrml::image pixels start at the bottom left.
+        //
+        const png_byte * const src = &this->rows[row * this->rowbytes];
+        unsigned char * const dst =
+            &pixels[(this->height - 1 - row) * this->width * comp];
+        if (!this->gray_palette) {
+            assert(this->rowbytes == this->width * comp);
+            std::memcpy(dst, src, this->rowbytes);
+        } else if (comp == 1) {
+            for (std::size_t i = 0; i < this->width; ++i) {
+                dst[i] = src[3 * i];
+            }
+        } else {
+            assert(comp == 2);
+            for (std::size_t i = 0; i < this->width; ++i) {
+                dst[2 * i]     = src[4 * i];
+                dst[2 * i + 1] = src[4 * i + 3];
+            }
+        }
+    }
+    std::vector<png_byte>().swap(this->rows);
+
+    this->stream_listener.publish(this->width, this->height, comp, pixels);
 }
 # endif // defined OPENVRML_ENABLE_PNG_TEXTURES
 
@@ -266,9 +284,9 @@ boolean openvrml_jpeg_fill_input_buffer(j_decompress_ptr cinfo)
         *src.reader;
 
     if (reader.reading) {
-        if (reader.buffer.empty()) { return false; /* Suspend. */ }
+        if (reader.bytes_in_buffer == 0) { return false; /* Suspend. */ }
 
-        vector<JOCTET>::const_iterator resume_pos = reader.buffer.begin();
+        const JOCTET * resume_pos = reader.buffer;
 
         vector<JOCTET>::size_type bytes_now_in_buffer =
             reader.bytes_in_buffer;
@@ -287,14 +305,18 @@ boolean openvrml_jpeg_fill_input_buffer(j_decompress_ptr cinfo)
 
         reader.backtrack_buffer_bytes_unread = source_mgr.bytes_in_buffer;
 
-        source_mgr.next_input_byte = &*resume_pos;
+        source_mgr.next_input_byte = resume_pos;
         source_mgr.bytes_in_buffer = bytes_now_in_buffer;
         reader.reading = false;
         return true;
     }
 
-    if (reader.buffer.empty()
-        || source_mgr.next_input_byte != &reader.buffer.front()) {
+    //
+    // libjpeg needs more data.  What it has not consumed is saved in the
+    // backtrack buffer, since the data passed to do_read are gone once it
+    // returns.
+    //
+    if (!reader.buffer || source_mgr.next_input_byte != reader.buffer) {
         reader.bytes_in_backtrack_buffer = 0;
         reader.backtrack_buffer_bytes_unread = 0;
     }
@@ -366,9 +388,7 @@ void openvrml_jpeg_output_message(j_common_ptr cinfo)
     assert(err->stream_listener);
     std::ostringstream msg;
     msg << err->stream_listener->uri_ << ": " << buffer;
-    openvrml::browser & browser =
-        err->stream_listener->node_.type().metatype().browser();
-    browser.err(msg.str());
+    err->stream_listener->browser_.err(msg.str());
 }
 
 openvrml_node_vrml97::image_stream_listener::jpeg_reader::
@@ -377,10 +397,10 @@ jpeg_reader(image_stream_listener & stream_listener):
     reading(true),
     bytes_to_skip(0),
     backtrack_buffer_bytes_unread(0),
+    buffer(0),
     bytes_in_buffer(0),
     bytes_in_backtrack_buffer(0),
     decoder_state(header),
-    scanlines(0),
     progressive_scan_started(false)
 {
     std::memset(&this->cinfo_, 0, sizeof this->cinfo_);
@@ -415,17 +435,14 @@ openvrml_node_vrml97::image_stream_listener::jpeg_reader::~jpeg_reader() OPENVRM
 
 void
 openvrml_node_vrml97::image_stream_listener::jpeg_reader::
-do_read(const std::vector<unsigned char> & data)
+do_read(const unsigned char * const data, const std::size_t size)
 {
-    using boost::unique_lock;
-    using boost::shared_mutex;
-    unique_lock<shared_mutex> lock(this->stream_listener.image_mutex_);
-
-    if (data.size() > this->buffer.size()) {
-        this->buffer.resize(data.size());
-    }
-    copy(data.begin(), data.end(), this->buffer.begin());
-    this->bytes_in_buffer = data.size();
+    //
+    // libjpeg reads the data in place; openvrml_jpeg_fill_input_buffer
+    // saves any it leaves unread when it suspends.
+    //
+    this->buffer = data;
+    this->bytes_in_buffer = size;
 
     int jmpval = setjmp(this->error_mgr_.jmpbuf);
     if (jmpval != 0) { return; }
@@ -440,6 +457,8 @@ do_read(const std::vector<unsigned char> & data)
 
         switch (this->cinfo_.jpeg_color_space) {
         case JCS_GRAYSCALE:
+            this->cinfo_.out_color_space = JCS_GRAYSCALE;
+            break;
         case JCS_RGB:
         case JCS_YCbCr:
             this->cinfo_.out_color_space = JCS_RGB;
@@ -454,9 +473,19 @@ do_read(const std::vector<unsigned char> & data)
 
         jpeg_calc_output_dimensions(&this->cinfo_);
 
-        openvrml::image & image = this->stream_listener.image_;
-        image.comp(this->cinfo_.num_components);
-        image.resize(this->cinfo_.image_width, this->cinfo_.image_height);
+        //
+        // Scanlines are decoded straight into a private buffer in
+        // openvrml::image's layout, which is published once decoding is
+        // finished.
+        //
+        try {
+            this->pixels.resize(this->cinfo_.output_width
+                                * this->cinfo_.output_height
+                                * this->cinfo_.out_color_components);
+        } catch (std::bad_alloc &) {
+            this->decoder_state = jpeg_reader::error;
+            throw;
+        }
 
         this->decoder_state = jpeg_reader::start_decompress;
     }
@@ -472,16 +501,6 @@ do_read(const std::vector<unsigned char> & data)
             return; // Input suspended.
         }
 
-        const JDIMENSION samples_per_row =
-            this->cinfo_.output_width * this->cinfo_.out_color_components;
-        static const JDIMENSION num_rows = 1;
-        this->scanlines =
-            (*this->cinfo_.mem->alloc_sarray)(
-                reinterpret_cast<j_common_ptr>(&this->cinfo_),
-                JPOOL_IMAGE,
-                samples_per_row,
-                num_rows);
-
         this->decoder_state = this->cinfo_.buffered_image
             ? jpeg_reader::decompress_progressive
             : jpeg_reader::decompress_sequential;
@@ -544,6 +563,7 @@ do_read(const std::vector<unsigned char> & data)
             return; // Input suspended.
         }
         this->decoder_state = jpeg_reader::sink_non_jpeg_trailer;
+        this->finish();
         break;
 
     case jpeg_reader::sink_non_jpeg_trailer:
@@ -557,57 +577,96 @@ do_read(const std::vector<unsigned char> & data)
 bool
 openvrml_node_vrml97::image_stream_listener::jpeg_reader::output_scanlines()
 {
-    JDIMENSION top = this->cinfo_.output_scanline;
-    bool result = true;
-
-    openvrml::image & image = this->stream_listener.image_;
+    const std::size_t row_size =
+        this->cinfo_.output_width * this->cinfo_.out_color_components;
 
     while (this->cinfo_.output_scanline < this->cinfo_.output_height) {
-        JDIMENSION scanlines_completed =
-            jpeg_read_scanlines(&this->cinfo_, this->scanlines, 1);
+        //
+        // openvrml::image pixels start at the bottom left.
+        //
+        JSAMPROW row =
+            &this->pixels[(this->cinfo_.output_height - 1
+                           - this->cinfo_.output_scanline) * row_size];
+        const JDIMENSION scanlines_completed =
+            jpeg_read_scanlines(&this->cinfo_, &row, 1);
         if (scanlines_completed != 1) {
-            result = false; // Suspend.
-            break;
+            return false; // Suspend.
         }
-
-        const size_t image_row = image.y() - this->cinfo_.output_scanline;
-        for (size_t pixel_index = 0, byte_index = 0;
-             pixel_index < image.x();
-             ++pixel_index) {
-            using openvrml::int32;
-            int32 pixel = 0x00000000;
-            for (size_t component = image.comp();
-                 component > 0;
-                 --component, ++byte_index) {
-                const JSAMPLE sample = (*this->scanlines)[byte_index];
-                pixel |= int32(sample) << (8 * (component - 1));
-            }
-            image.pixel(image_row * image.x() + pixel_index, pixel);
-        }
-    }
-
-    if (top != this->cinfo_.output_scanline) {
-        this->stream_listener.node_.modified(true);
     }
+    return true;
+}
 
-    return result;
+void openvrml_node_vrml97::image_stream_listener::jpeg_reader::do_finish()
+{
+    if (this->pixels.empty()) { return; }
+    this->stream_listener.publish(this->cinfo_.output_width,
+                                  this->cinfo_.output_height,
+                                  this->cinfo_.out_color_components,
+                                  this->pixels);
 }
 # endif // defined OPENVRML_ENABLE_JPEG_TEXTURES
 
 openvrml_node_vrml97::image_stream_listener::
 image_stream_listener(const std::string & uri,
-                      openvrml::image & image,
-                      openvrml::node & node,
-                      boost::shared_mutex & image_mutex):
+                      const boost::shared_ptr<shared_image> & image,
+                      openvrml::browser & browser):
     uri_(uri),
-    image_mutex_(image_mutex),
     image_(image),
-    node_(node)
+    browser_(browser),
+    published_(false)
 {}
 
+/**
+ * @brief Destroy.
+ *
+ * If the stream ended before the image was completely decoded, what has
+ * been decoded is published; but the image is no longer shared with nodes
+ * that start using its URL later, so that they try again.
+ */
 openvrml_node_vrml97::image_stream_listener::~image_stream_listener()
     OPENVRML_NOTHROW
-{}
+{
+    if (this->published_) { return; }
+    if (this->image_reader_) {
+        try {
+            this->image_reader_->finish();
+        } catch (std::exception & ex) {
+            OPENVRML_PRINT_EXCEPTION_(ex);
+        }
+    }
+    image_registry::instance().abandon(this->image_);
+}
+
+/**
+ * @brief Publish the decoded image.
+ *
+ * Decoding happens in a private buffer; the shared image is locked only to
+ * swap in the result, and the nodes using it are notified once.
+ *
+ * @param[in]     x         the width of the image.
+ * @param[in]     y         the height of the image.
+ * @param[in]     comp      the number of components.
+ * @param[in,out] pixels    the pixels, in @c openvrml::image's layout; left
+ *                          empty.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void
+openvrml_node_vrml97::image_stream_listener::
+publish(const std::size_t x, const std::size_t y, const std::size_t comp,
+        std::vector<unsigned char> & pixels)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    openvrml::image decoded(x, y, comp, pixels.begin(), pixels.end());
+    std::vector<unsigned char>().swap(pixels);
+    {
+        boost::unique_lock<boost::shared_mutex>
+            lock(this->image_->mutex());
+        this->image_->image().swap(decoded);
+    }
+    this->published_ = true;
+    this->image_->modified();
+}
 
 void
 openvrml_node_vrml97::image_stream_listener::
@@ -631,5 +690,13 @@ void
 openvrml_node_vrml97::image_stream_listener::
 do_data_available(const std::vector<unsigned char> & data)
 {
-    if (this->image_reader_) { this->image_reader_->read(data); }
+    if (data.empty()) { return; }
+    this->do_data_available(&data[0], data.size());
+}
+
+void
+openvrml_node_vrml97::image_stream_listener::
+do_data_available(const unsigned char * const data, const std::size_t size)
+{
+    if (this->image_reader_) { this->image_reader_->read(data, size); }
 }
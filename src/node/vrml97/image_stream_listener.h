@@ -31,6 +31,7 @@ extern "C" {
 # endif
 
 # include <openvrml/browser.h>
+# include "shared_image.h"
 
 # ifdef OPENVRML_ENABLE_PNG_TEXTURES
 extern "C" void openvrml_png_info_callback(png_structp png_ptr,
@@ -55,19 +56,24 @@ extern "C" void openvrml_jpeg_output_message(j_common_ptr cinfo);
 
 namespace openvrml_node_vrml97 {
 
-    class image_stream_listener : public openvrml::stream_listener {
+    class OPENVRML_LOCAL image_stream_listener :
+        public openvrml::stream_listener {
         const std::string uri_;
-        boost::shared_mutex & image_mutex_;
-        openvrml::image & image_;
-        openvrml::node & node_;
+        const boost::shared_ptr<shared_image> image_;
+        openvrml::browser & browser_;
+
+        bool published_;
 
         class image_reader {
         public:
             virtual ~image_reader() OPENVRML_NOTHROW = 0;
-            void read(const std::vector<unsigned char> & data);
+            void read(const unsigned char * data, std::size_t size);
+            void finish();
 
         private:
-            virtual void do_read(const std::vector<unsigned char> & data) = 0;
+            virtual void do_read(const unsigned char * data,
+                                 std::size_t size) = 0;
+            virtual void do_finish() = 0;
         };
 
 # ifdef OPENVRML_ENABLE_PNG_TEXTURES
@@ -86,16 +92,19 @@ namespace openvrml_node_vrml97 {
 
         public:
             image_stream_listener & stream_listener;
-            std::vector<png_byte> old_row;
+            std::vector<png_byte> rows;
             bool gray_palette;
-            png_uint_32 width;
+            png_uint_32 width, height;
             png_size_t rowbytes;
+            std::size_t channels;
 
             explicit png_reader(image_stream_listener & stream_listener);
             virtual ~png_reader() OPENVRML_NOTHROW;
 
         private:
-            virtual void do_read(const std::vector<unsigned char> & data);
+            virtual void do_read(const unsigned char * data,
+                                 std::size_t size);
+            virtual void do_finish();
         };
 # endif
 
@@ -131,7 +140,8 @@ namespace openvrml_node_vrml97 {
             bool reading;
             std::vector<JOCTET>::size_type bytes_to_skip;
             std::vector<JOCTET>::size_type backtrack_buffer_bytes_unread;
-            std::vector<JOCTET> buffer, backtrack_buffer;
+            const JOCTET * buffer;
+            std::vector<JOCTET> backtrack_buffer;
             std::vector<JOCTET>::size_type bytes_in_buffer,
                 bytes_in_backtrack_buffer;
             enum decoder_state_t {
@@ -143,14 +153,16 @@ namespace openvrml_node_vrml97 {
                 sink_non_jpeg_trailer,
                 error
             } decoder_state;
-            JSAMPARRAY scanlines;
+            std::vector<unsigned char> pixels;
             bool progressive_scan_started;
 
             explicit jpeg_reader(image_stream_listener & stream_listener);
             virtual ~jpeg_reader() OPENVRML_NOTHROW;
 
         private:
-            virtual void do_read(const std::vector<unsigned char> & data);
+            virtual void do_read(const unsigned char * data,
+                                 std::size_t size);
+            virtual void do_finish();
 
             bool output_scanlines();
         };
@@ -160,18 +172,24 @@ namespace openvrml_node_vrml97 {
 
     public:
         image_stream_listener(const std::string & uri,
-                              openvrml::image & image,
-                              openvrml::node & node,
-                              boost::shared_mutex & image_mutex);
+                              const boost::shared_ptr<shared_image> & image,
+                              openvrml::browser & browser);
         virtual ~image_stream_listener() OPENVRML_NOTHROW;
 
     private:
+        void publish(std::size_t x, std::size_t y, std::size_t comp,
+                     std::vector<unsigned char> & pixels)
+            OPENVRML_THROW1(std::bad_alloc);
+
         virtual void
         do_stream_available(const std::string & uri,
                             const std::string & media_type);
 
         virtual void
         do_data_available(const std::vector<unsigned char> & data);
+
+        virtual void
+        do_data_available(const unsigned char * data, std::size_t size);
     };
 }
 
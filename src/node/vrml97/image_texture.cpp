@@ -55,8 +55,7 @@ namespace {
 
         url_exposedfield url_;
 
-        boost::shared_mutex image_mutex_;
-        openvrml::image image_;
+        boost::shared_ptr<openvrml_node_vrml97::shared_image> image_;
         bool texture_needs_update;
 
     public:
@@ -67,9 +66,15 @@ namespace {
 
     private:
         virtual const openvrml::image & do_image() const OPENVRML_NOTHROW;
+        virtual boost::shared_mutex * do_image_mutex() const
+            OPENVRML_NOTHROW;
         virtual void do_render_texture(openvrml::viewer & v);
 
         void update_texture();
+        void
+        image(const boost::shared_ptr<openvrml_node_vrml97::shared_image> &
+              image)
+            OPENVRML_NOTHROW;
     };
 
     /**
@@ -173,9 +178,12 @@ namespace {
      */
 
     /**
-     * @var openvrml::image image_texture_node::image_
+     * @var boost::shared_ptr<openvrml_node_vrml97::shared_image> image_texture_node::image_
      *
      * @brief Image data.
+     *
+     * The image is shared with the other nodes whose @c url resolves to the
+     * same image; it is decoded only once.
      */
 
     /**
@@ -206,7 +214,7 @@ namespace {
      */
     image_texture_node::~image_texture_node() OPENVRML_NOTHROW
     {
-        // delete texObject...
+        this->image(boost::shared_ptr<openvrml_node_vrml97::shared_image>());
     }
 
     /**
@@ -217,7 +225,21 @@ namespace {
     const openvrml::image &
     image_texture_node::do_image() const OPENVRML_NOTHROW
     {
-        return this->image_;
+        static const openvrml::image null_image;
+        return this->image_ ? this->image_->image() : null_image;
+    }
+
+    /**
+     * @brief The mutex guarding the image.
+     *
+     * The image is decoded, and published, by an I/O thread.
+     *
+     * @return the mutex guarding the image, or 0 if there is no image.
+     */
+    boost::shared_mutex *
+    image_texture_node::do_image_mutex() const OPENVRML_NOTHROW
+    {
+        return this->image_ ? &this->image_->mutex() : 0;
     }
 
     /**
@@ -230,7 +252,8 @@ namespace {
     void image_texture_node::do_render_texture(openvrml::viewer & v)
     {
         this->update_texture();
-        boost::shared_lock<boost::shared_mutex> lock(this->image_mutex_);
+        if (!this->image_) { return; }
+        boost::shared_lock<boost::shared_mutex> lock(this->image_->mutex());
         v.insert_texture(*this, true);
     }
 
@@ -242,20 +265,48 @@ namespace {
         assert(this->scene());
 
         if (this->texture_needs_update) {
+            using openvrml_node_vrml97::image_registry;
             using openvrml_node_vrml97::image_stream_listener;
+            using openvrml_node_vrml97::shared_image;
             try {
-                if (!this->url_.value().empty()) {
+                const std::vector<std::string> & url = this->url_.value();
+                image_registry & registry = image_registry::instance();
+
+                //
+                // If another node has already loaded (or is loading) one of
+                // the alternatives, share its image rather than fetching and
+                // decoding it again.
+                //
+                boost::shared_ptr<shared_image> image;
+                for (std::vector<std::string>::const_iterator u = url.begin();
+                     u != url.end() && !image;
+                     ++u) {
+                    try {
+                        image = registry.find(this->scene()->resolve_url(*u));
+                    } catch (std::runtime_error &) {}
+                }
+
+                if (image) {
+                    this->image(image);
+                } else if (!url.empty()) {
                     using std::auto_ptr;
                     auto_ptr<openvrml::resource_istream> in =
-                        this->scene()->get_resource(this->url_.value());
+                        this->scene()->get_resource(url);
                     if (*in) {
-                        auto_ptr<openvrml::stream_listener> listener(
-                            new image_stream_listener(in->url(),
-                                                      this->image_,
-                                                      *this,
-                                                      this->image_mutex_));
-                        this->scene()->read_stream(in, listener);
+                        bool inserted;
+                        image = registry.insert(in->url(), inserted);
+                        this->image(image);
+                        if (inserted) {
+                            auto_ptr<openvrml::stream_listener> listener(
+                                new image_stream_listener(
+                                    in->url(),
+                                    image,
+                                    this->scene()->browser()));
+                            this->scene()->read_stream(in, listener);
+                        }
                     }
+                } else {
+                    this->image(image);
                 }
             } catch (std::exception & ex) {
                 this->scene()->browser().err(ex.what());
@@ -263,6 +314,30 @@ namespace {
             this->texture_needs_update = false;
         }
     }
+
+    /**
+     * @brief Set the image.
+     *
+     * The node is detached from its previous image, if any, and attached to
+     * @p image so that it is marked modified as @p image is decoded.
+     *
+     * @param[in] image the new image; may be null.
+     */
+    void image_texture_node::
+    image(const boost::shared_ptr<openvrml_node_vrml97::shared_image> & image)
+        OPENVRML_NOTHROW
+    {
+        if (image == this->image_) { return; }
+        if (this->image_) { this->image_->detach(*this); }
+        this->image_ = image;
+        if (this->image_) {
+            try {
+                this->image_->attach(*this);
+            } catch (std::bad_alloc & ex) {
+                OPENVRML_PRINT_EXCEPTION_(ex);
+            }
+        }
+    }
 }
 
 
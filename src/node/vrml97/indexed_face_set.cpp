@@ -22,6 +22,7 @@
 # include "indexed_face_set.h"
 # include "abstract_indexed_set.h"
 # include <private.h>
+# include <openvrml/mesh.h>
 # include <openvrml/viewer.h>
 # include <boost/array.hpp>
 
@@ -77,6 +78,7 @@ namespace {
         openvrml::mfint32 tex_coord_index_;
 
         openvrml::bounding_sphere bsphere;
+        openvrml::normal_cache generated_normals_;
 
     public:
         indexed_face_set_node(
@@ -91,6 +93,7 @@ namespace {
         virtual const openvrml::bounding_volume & do_bounding_volume() const;
         virtual void do_render_geometry(openvrml::viewer & viewer,
                                         openvrml::rendering_context context);
+        virtual void do_coord_index_changed() OPENVRML_NOTHROW;
 
         void recalc_bsphere();
     };
@@ -281,6 +284,12 @@ namespace {
      * @brief Bounding volume.
      */
 
+    /**
+     * @var openvrml::normal_cache indexed_face_set_node::generated_normals_
+     *
+     * @brief Normals generated when the normal field is @c NULL.
+     */
+
     /**
      * @brief Construct.
      *
@@ -332,10 +341,13 @@ namespace {
     /**
      * @brief Insert this geometry into @p viewer's display list.
      *
+     * If the normal field is @c NULL and normalPerVertex is @c TRUE,
+     * per-vertex normals are generated using creaseAngle.
+     *
      * @param v         a viewer.
      * @param context   the rendering context.
      *
-     * @todo stripify, crease angle, generate normals ...
+     * @todo stripify ...
      */
     void
     indexed_face_set_node::
@@ -377,6 +389,17 @@ namespace {
             ? normalNode->vector()
             : vector<vec3f>();
 
+        const bool generate_normals =
+            !normalNode && coordinateNode && this->normal_per_vertex_.value();
+        if (generate_normals
+            && !this->generated_normals_.valid(coordinateNode)) {
+            this->generated_normals_.generate(coordinateNode,
+                                              coord,
+                                              this->coord_index_.value(),
+                                              this->crease_angle_.value(),
+                                              this->ccw_.value());
+        }
+
         openvrml::texture_coordinate_node * const texCoordNode =
             node_cast<openvrml::texture_coordinate_node *>(
                 this->tex_coord_.sfnode::value().get());
@@ -405,7 +428,12 @@ namespace {
                        optMask,
                        coord, this->coord_index_.value(),
                        color, this->color_index_.value(),
-                       normal, this->normal_index_.value(),
+                       generate_normals
+                       ? this->generated_normals_.normal()
+                       : normal,
+                       generate_normals
+                       ? this->generated_normals_.normal_index()
+                       : this->normal_index_.value(),
                        texCoord, this->tex_coord_index_.value());
 
         if (colorNode) { colorNode->modified(false); }
@@ -414,6 +442,14 @@ namespace {
         if (texCoordNode) { texCoordNode->modified(false); }
     }
 
+    /**
+     * @brief Discard the generated normals.
+     */
+    void indexed_face_set_node::do_coord_index_changed() OPENVRML_NOTHROW
+    {
+        this->generated_normals_.invalidate();
+    }
+
     /**
      * @brief Recalculate the bounding volume.
      */
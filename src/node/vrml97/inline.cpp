@@ -39,8 +39,6 @@ namespace {
 
         friend class openvrml_node_vrml97::inline_metatype;
 
-        struct load_inline_scene;
-
         exposedfield<openvrml::mfstring> url_;
         exposedfield<openvrml::sfbool> load_;
         openvrml::sfvec3f bbox_center_;
@@ -48,7 +46,6 @@ namespace {
 
         openvrml::scene * inline_scene_;
         bool loaded_;
-        boost::scoped_ptr<boost::thread> load_inline_scene_thread_;
 
     public:
         inline_node(const openvrml::node_type & type,
@@ -61,7 +58,7 @@ namespace {
         virtual const std::vector<boost::intrusive_ptr<openvrml::node> >
             do_children() const OPENVRML_THROW1(std::bad_alloc);
 
-        void load();
+        void load(const openvrml::rendering_context & context);
     };
 
     /**
@@ -132,11 +129,7 @@ namespace {
      * @brief Destroy.
      */
     inline_node::~inline_node() OPENVRML_NOTHROW
-    {
-        if (this->load_inline_scene_thread_) {
-            this->load_inline_scene_thread_->join();
-        }
-    }
+    {}
 
     /**
      * @brief Render the node.
@@ -149,7 +142,7 @@ namespace {
     void inline_node::do_render_child(openvrml::viewer & viewer,
                                       const openvrml::rendering_context context)
     {
-        this->load();
+        this->load(context);
         if (this->inline_scene_) { this->inline_scene_->render(viewer, context); }
     }
 
@@ -169,58 +162,16 @@ namespace {
             : empty;
     }
 
-    struct OPENVRML_LOCAL inline_node::load_inline_scene {
-
-        load_inline_scene(openvrml::scene & scene,
-                          const std::vector<std::string> & url):
-            inline_scene_(&scene),
-            url_(&url)
-        {}
-
-        void operator()() const OPENVRML_NOTHROW
-        {
-            try {
-                using std::endl;
-                using std::string;
-                using std::vector;
-                using openvrml::unreachable_url;
-
-                openvrml::scene & inline_scene = *this->inline_scene_;
-                const vector<string> & url = *this->url_;
-
-                assert(inline_scene.url().empty());
-
-                vector<boost::intrusive_ptr<node> > nodes;
-                try {
-                    //
-                    // Any relative URLs passed here will be relative to the
-                    // *parent* scene; so we call get_resource on the parent.
-                    //
-                    assert(inline_scene.parent());
-                    std::auto_ptr<openvrml::resource_istream> in =
-                        inline_scene.parent()->get_resource(url);
-                    if (!(*in)) { throw unreachable_url(); }
-                    inline_scene.load(*in);
-                } catch (std::exception & ex) {
-                    inline_scene.browser().err(ex.what());
-                    throw unreachable_url();
-                } catch (...) {
-                    throw unreachable_url();
-                }
-            } catch (std::exception & ex) {
-                this->inline_scene_->browser().err(ex.what());
-            }
-        }
-
-    private:
-        openvrml::scene * const inline_scene_;
-        const std::vector<std::string> * const url_;
-    };
-
     /**
      * @brief Load the children from the URL.
+     *
+     * The scene is loaded by the @c browser's I/O threads; Inlines nearer
+     * the viewer are loaded first.
+     *
+     * @param[in] context   the @c rendering_context in which the Inline is
+     *                      being rendered.
      */
-    void inline_node::load()
+    void inline_node::load(const openvrml::rendering_context & context)
     {
         class inline_scene : public openvrml::scene {
         public:
@@ -246,10 +197,17 @@ namespace {
         assert(this->scene());
         this->inline_scene_ = new inline_scene(this->scene()->browser(),
                                                this->scene());
-        boost::function0<void> f =
-            load_inline_scene(*this->inline_scene_,
-                              this->url_.mfstring::value());
-        this->load_inline_scene_thread_.reset(new boost::thread(f));
+        //
+        // The distance from the viewer to the center of the bounding box.
+        //
+        const openvrml::vec3f center =
+            this->bbox_center_.value() * context.matrix();
+        try {
+            this->inline_scene_->load_async(this->url_.mfstring::value(),
+                                            center.length());
+        } catch (std::exception & ex) {
+            this->scene()->browser().err(ex.what());
+        }
     }
 }
 
@@ -166,7 +166,14 @@ namespace {
 
         vector<intrusive_ptr<openvrml::node> > current_child(1);
         current_child[0] = this->children_.value()[i];
+        //
+        // A subtree that was found to be unmodified was checked with the
+        // previous child; so the change must be treated as a modification.
+        //
+        const bool changed = this->current_children_.value().empty()
+            || this->current_children_.value()[0] != current_child[0];
         this->current_children_.value(current_child);
+        if (changed) { this->modified(true); }
 
         child_node * const child =
             openvrml::node_cast<child_node *>(current_child[0].get());
@@ -0,0 +1,295 @@
+// -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+# include "shared_image.h"
+# include <cassert>
+
+/**
+ * @class openvrml_node_vrml97::shared_image
+ *
+ * @brief A decoded image shared by all the texture nodes that refer to the
+ *        same URL.
+ *
+ * The image is written only while it is being decoded, with @c #mutex held
+ * exclusively; after that it is immutable.  Readers hold @c #mutex shared.
+ *
+ * Nodes that use the image @c #attach themselves to it, so that they are
+ * marked modified as decoding progresses.
+ */
+
+/**
+ * @var const std::string openvrml_node_vrml97::shared_image::url_
+ *
+ * @brief The resolved URL of the image.
+ */
+
+/**
+ * @var boost::shared_mutex openvrml_node_vrml97::shared_image::mutex_
+ *
+ * @brief Guards @c #image_.
+ */
+
+/**
+ * @var openvrml::image openvrml_node_vrml97::shared_image::image_
+ *
+ * @brief The image.
+ */
+
+/**
+ * @var boost::mutex openvrml_node_vrml97::shared_image::nodes_mutex_
+ *
+ * @brief Guards @c #nodes_.
+ */
+
+/**
+ * @var std::set<openvrml::node *> openvrml_node_vrml97::shared_image::nodes_
+ *
+ * @brief The nodes using the image.
+ */
+
+/**
+ * @brief Construct.
+ *
+ * @param[in] url   the resolved URL of the image.
+ */
+openvrml_node_vrml97::shared_image::shared_image(const std::string & url):
+    url_(url)
+{}
+
+/**
+ * @brief Destroy.
+ *
+ * The image is removed from the @c image_registry.
+ */
+openvrml_node_vrml97::shared_image::~shared_image() OPENVRML_NOTHROW
+{
+    image_registry::instance().erase(this->url_);
+}
+
+/**
+ * @brief The resolved URL of the image.
+ *
+ * @return the resolved URL of the image.
+ */
+const std::string & openvrml_node_vrml97::shared_image::url() const
+    OPENVRML_NOTHROW
+{
+    return this->url_;
+}
+
+/**
+ * @brief The mutex guarding the image.
+ *
+ * @return the mutex guarding the image.
+ */
+boost::shared_mutex & openvrml_node_vrml97::shared_image::mutex() const
+    OPENVRML_NOTHROW
+{
+    return this->mutex_;
+}
+
+/**
+ * @brief The image.
+ *
+ * @c #mutex must be held exclusively to modify it.
+ *
+ * @return the image.
+ */
+openvrml::image & openvrml_node_vrml97::shared_image::image()
+    OPENVRML_NOTHROW
+{
+    return this->image_;
+}
+
+/**
+ * @brief The image.
+ *
+ * @c #mutex must be held to read it.
+ *
+ * @return the image.
+ */
+const openvrml::image & openvrml_node_vrml97::shared_image::image() const
+    OPENVRML_NOTHROW
+{
+    return this->image_;
+}
+
+/**
+ * @brief Register a node as using the image.
+ *
+ * @param[in] n a node.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+void openvrml_node_vrml97::shared_image::attach(openvrml::node & n)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    boost::mutex::scoped_lock lock(this->nodes_mutex_);
+    this->nodes_.insert(&n);
+}
+
+/**
+ * @brief Unregister a node.
+ *
+ * @param[in] n a node.
+ */
+void openvrml_node_vrml97::shared_image::detach(openvrml::node & n)
+    OPENVRML_NOTHROW
+{
+    boost::mutex::scoped_lock lock(this->nodes_mutex_);
+    this->nodes_.erase(&n);
+}
+
+/**
+ * @brief Mark the nodes using the image modified.
+ */
+void openvrml_node_vrml97::shared_image::modified() OPENVRML_NOTHROW
+{
+    boost::mutex::scoped_lock lock(this->nodes_mutex_);
+    for (std::set<openvrml::node *>::const_iterator n = this->nodes_.begin();
+         n != this->nodes_.end();
+         ++n) {
+        (*n)->modified(true);
+    }
+}
+
+
+/**
+ * @class openvrml_node_vrml97::image_registry
+ *
+ * @brief The process-wide registry of @c shared_image%s, keyed by resolved
+ *        URL.
+ *
+ * The registry does not own the images; an image is removed from it when
+ * the last node using it lets it go, or when it could not be decoded
+ * completely.
+ */
+
+namespace {
+    openvrml_node_vrml97::image_registry registry;
+}
+
+/**
+ * @brief The registry.
+ *
+ * @return the registry.
+ */
+openvrml_node_vrml97::image_registry &
+openvrml_node_vrml97::image_registry::instance() OPENVRML_NOTHROW
+{
+    return registry;
+}
+
+/**
+ * @brief Find the image for a URL.
+ *
+ * @param[in] url   a resolved URL.
+ *
+ * @return the image for @p url, or a null pointer if there is none.
+ */
+const boost::shared_ptr<openvrml_node_vrml97::shared_image>
+openvrml_node_vrml97::image_registry::find(const std::string & url)
+    OPENVRML_NOTHROW
+{
+    boost::mutex::scoped_lock lock(this->mutex_);
+    const std::map<std::string, boost::weak_ptr<shared_image> >::const_iterator
+        pos = this->images_.find(url);
+    return (pos != this->images_.end())
+        ? pos->second.lock()
+        : boost::shared_ptr<shared_image>();
+}
+
+/**
+ * @brief Get the image for a URL, creating it if necessary.
+ *
+ * @param[in]  url      a resolved URL.
+ * @param[out] inserted @c true if a new image was created, in which case the
+ *                      caller is responsible for decoding it; @c false
+ *                      otherwise.
+ *
+ * @return the image for @p url.
+ *
+ * @exception std::bad_alloc    if memory allocation fails.
+ */
+const boost::shared_ptr<openvrml_node_vrml97::shared_image>
+openvrml_node_vrml97::image_registry::insert(const std::string & url,
+                                             bool & inserted)
+    OPENVRML_THROW1(std::bad_alloc)
+{
+    boost::mutex::scoped_lock lock(this->mutex_);
+    boost::weak_ptr<shared_image> & entry = this->images_[url];
+    boost::shared_ptr<shared_image> image = entry.lock();
+    inserted = !image;
+    if (inserted) {
+        image.reset(new shared_image(url));
+        entry = image;
+    }
+    return image;
+}
+
+/**
+ * @brief Stop sharing an image that could not be decoded completely.
+ *
+ * Nodes already using @p image keep it; the next node to use its URL fetches
+ * and decodes it again.
+ *
+ * @param[in] image an image.
+ */
+void
+openvrml_node_vrml97::image_registry::
+abandon(const boost::shared_ptr<shared_image> & image) OPENVRML_NOTHROW
+{
+    assert(image);
+    boost::mutex::scoped_lock lock(this->mutex_);
+    const std::map<std::string, boost::weak_ptr<shared_image> >::iterator
+        pos = this->images_.find(image->url());
+    //
+    // Compare without locking the entry: if the last reference to its image
+    // were dropped here, the image would call erase with the mutex held.
+    //
+    if (pos != this->images_.end()
+        && !pos->second.owner_before(image)
+        && !image.owner_before(pos->second)) {
+        this->images_.erase(pos);
+    }
+}
+
+/**
+ * @brief Remove the entry for a URL if its image has been destroyed.
+ *
+ * A new image for the same URL may already have replaced it.
+ *
+ * @param[in] url   a resolved URL.
+ */
+void openvrml_node_vrml97::image_registry::erase(const std::string & url)
+    OPENVRML_NOTHROW
+{
+    boost::mutex::scoped_lock lock(this->mutex_);
+    const std::map<std::string, boost::weak_ptr<shared_image> >::iterator
+        pos = this->images_.find(url);
+    if (pos != this->images_.end() && pos->second.expired()) {
+        this->images_.erase(pos);
+    }
+}
@@ -0,0 +1,76 @@
+// -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// OpenVRML
+//
+// Copyright 2012  Braden McDaniel
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# ifndef OPENVRML_NODE_VRML97_SHARED_IMAGE_H
+#   define OPENVRML_NODE_VRML97_SHARED_IMAGE_H
+
+#   include <openvrml/node.h>
+#   include <boost/thread.hpp>
+#   include <boost/weak_ptr.hpp>
+#   include <map>
+#   include <set>
+
+namespace openvrml_node_vrml97 {
+
+    class OPENVRML_LOCAL shared_image : boost::noncopyable {
+        const std::string url_;
+        mutable boost::shared_mutex mutex_;
+        openvrml::image image_;
+        boost::mutex nodes_mutex_;
+        std::set<openvrml::node *> nodes_;
+
+    public:
+        explicit shared_image(const std::string & url);
+        ~shared_image() OPENVRML_NOTHROW;
+
+        const std::string & url() const OPENVRML_NOTHROW;
+        boost::shared_mutex & mutex() const OPENVRML_NOTHROW;
+        openvrml::image & image() OPENVRML_NOTHROW;
+        const openvrml::image & image() const OPENVRML_NOTHROW;
+
+        void attach(openvrml::node & n) OPENVRML_THROW1(std::bad_alloc);
+        void detach(openvrml::node & n) OPENVRML_NOTHROW;
+        void modified() OPENVRML_NOTHROW;
+    };
+
+
+    class OPENVRML_LOCAL image_registry : boost::noncopyable {
+        friend class shared_image;
+
+        boost::mutex mutex_;
+        std::map<std::string, boost::weak_ptr<shared_image> > images_;
+
+    public:
+        static image_registry & instance() OPENVRML_NOTHROW;
+
+        const boost::shared_ptr<shared_image> find(const std::string & url)
+            OPENVRML_NOTHROW;
+        const boost::shared_ptr<shared_image> insert(const std::string & url,
+                                                     bool & inserted)
+            OPENVRML_THROW1(std::bad_alloc);
+        void abandon(const boost::shared_ptr<shared_image> & image)
+            OPENVRML_NOTHROW;
+
+    private:
+        void erase(const std::string & url) OPENVRML_NOTHROW;
+    };
+}
+
+# endif // ifndef OPENVRML_NODE_VRML97_SHARED_IMAGE_H
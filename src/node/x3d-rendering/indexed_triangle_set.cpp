@@ -20,6 +20,9 @@
 
 # include "indexed_triangle_set.h"
 # include <openvrml/node_impl_util.h>
+# include <openvrml/viewer.h>
+# include <openvrml/mesh.h>
+# include <openvrml/local/float.h>
 # include <boost/array.hpp>
 
 # ifdef HAVE_CONFIG_H
@@ -68,6 +71,9 @@ namespace {
         sfbool solid_;
         mfint32 index_;
         bounding_sphere bsphere;
+        std::vector<int32> mesh_coord_index_;
+        bool mesh_dirty_;
+        normal_cache generated_normals_;
 
     public:
         indexed_triangle_set_node(
@@ -156,6 +162,24 @@ namespace {
      * @brief index field
      */
 
+    /**
+     * @var indexed_triangle_set_node::mesh_coord_index_
+     *
+     * @brief Coordinate indices of the triangles.
+     */
+
+    /**
+     * @var indexed_triangle_set_node::mesh_dirty_
+     *
+     * @brief Whether @a mesh_coord_index_ needs to be recomputed.
+     */
+
+    /**
+     * @var indexed_triangle_set_node::generated_normals_
+     *
+     * @brief Normals generated when the normal field is @c NULL.
+     */
+
     indexed_triangle_set_node::set_index_listener::
     set_index_listener(self_t & node):
         node_event_listener(node),
@@ -168,11 +192,13 @@ namespace {
     {}
 
     void indexed_triangle_set_node::set_index_listener::
-    do_process_event(const mfint32 & /* fraction */,
+    do_process_event(const mfint32 & index,
                      const double /* timestamp */)
         OPENVRML_THROW1(std::bad_alloc)
     {
-        //TODO: add logic here
+        self_t & node = dynamic_cast<self_t &>(this->node());
+        node.index_ = index;
+        node.node::modified(true);
     }
 
 
@@ -220,16 +246,106 @@ namespace {
     /**
      * @brief Insert this geometry into @p viewer's display list.
      *
-     * @param viewer    a Viewer.
-     * @param context   the rendering context.
+     * Each triple of indices in the index field is a triangle; a
+     * trailing partial triple is ignored.
+     *
+     * If the normal field is @c NULL and normalPerVertex is @c TRUE,
+     * the normal at each vertex is the average of the normals of the
+     * triangles that share it.
      *
-     * @todo Implement this!
+     * @param v         a @c viewer.
+     * @param context   the rendering context.
      */
     void
     indexed_triangle_set_node::
-    do_render_geometry(openvrml::viewer & /* viewer */,
+    do_render_geometry(openvrml::viewer & v,
                        const rendering_context /* context */)
-    {}
+    {
+        coordinate_node * const coordinateNode =
+            node_cast<coordinate_node *>(this->coord_.sfnode::value().get());
+        const vector<vec3f> & coord = coordinateNode
+            ? coordinateNode->point()
+            : vector<vec3f>();
+
+        color_node * const colorNode =
+            node_cast<color_node *>(this->color_.sfnode::value().get());
+        const vector<openvrml::color> & color = colorNode
+            ? colorNode->color()
+            : vector<openvrml::color>();
+
+        normal_node * const normalNode =
+            node_cast<normal_node *>(this->normal_.sfnode::value().get());
+        const vector<vec3f> & normal = normalNode
+            ? normalNode->vector()
+            : vector<vec3f>();
+
+        texture_coordinate_node * const texCoordNode =
+            node_cast<texture_coordinate_node *>(
+                this->tex_coord_.sfnode::value().get());
+        const vector<vec2f> & texCoord = texCoordNode
+            ? texCoordNode->point()
+            : vector<vec2f>();
+
+        if (this->mesh_dirty_ || this->modified()) {
+            vector<int32> coord_index;
+            const vector<int32> & index = this->index_.value();
+            for (vector<int32>::size_type i = 0; i + 2 < index.size();
+                 i += 3) {
+                coord_index.push_back(index[i]);
+                coord_index.push_back(index[i + 1]);
+                coord_index.push_back(index[i + 2]);
+                coord_index.push_back(-1);
+            }
+            if (coord_index != this->mesh_coord_index_) {
+                this->mesh_coord_index_.swap(coord_index);
+                this->generated_normals_.invalidate();
+            }
+            this->mesh_dirty_ = false;
+        }
+
+        const bool generate_normals =
+            !normalNode && coordinateNode && this->normal_per_vertex_.value();
+        if (generate_normals
+            && !this->generated_normals_.valid(coordinateNode)) {
+            this->generated_normals_.generate(coordinateNode,
+                                              coord,
+                                              this->mesh_coord_index_,
+                                              float(local::pi),
+                                              this->ccw_.value());
+        }
+
+        unsigned int mask = viewer::mask_convex;
+        if (this->ccw_.value()) { mask |= viewer::mask_ccw; }
+        if (this->solid_.value()) { mask |= viewer::mask_solid; }
+        if (this->color_per_vertex_.value()) {
+            mask |= viewer::mask_color_per_vertex;
+        }
+        if (this->normal_per_vertex_.value()) {
+            mask |= viewer::mask_normal_per_vertex;
+        }
+
+        //
+        // Colors, normals, and texture coordinates are given per vertex; so
+        // they are indexed like the coordinates.
+        //
+        const vector<int32> no_index;
+        v.insert_shell(*this,
+                       mask,
+                       coord, this->mesh_coord_index_,
+                       color, no_index,
+                       generate_normals
+                       ? this->generated_normals_.normal()
+                       : normal,
+                       generate_normals
+                       ? this->generated_normals_.normal_index()
+                       : no_index,
+                       texCoord, no_index);
+
+        if (colorNode) { colorNode->modified(false); }
+        if (coordinateNode) { coordinateNode->modified(false); }
+        if (normalNode) { normalNode->modified(false); }
+        if (texCoordNode) { texCoordNode->modified(false); }
+    }
 
 
     /**
@@ -270,7 +386,8 @@ namespace {
         ccw_(true),
         color_per_vertex_(true),
         normal_per_vertex_(true),
-        solid_(true)
+        solid_(true),
+        mesh_dirty_(true)
     {}
 
     /**
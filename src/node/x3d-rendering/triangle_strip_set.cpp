@@ -20,6 +20,9 @@
 
 # include "triangle_strip_set.h"
 # include <openvrml/node_impl_util.h>
+# include <openvrml/viewer.h>
+# include <openvrml/mesh.h>
+# include <openvrml/local/float.h>
 # include <boost/array.hpp>
 
 # ifdef HAVE_CONFIG_H
@@ -33,6 +36,37 @@ using namespace std;
 
 namespace {
 
+    /**
+     * @brief Vertex indices of runs of consecutive vertices.
+     *
+     * @param[in] count     the number of vertices in each run.
+     * @param[in] vertices  the number of vertices available.
+     *
+     * @return the indices of the runs, each terminated by -1.  Runs are
+     *         truncated at @p vertices.
+     *
+     * @exception std::bad_alloc    if memory allocation fails.
+     */
+    OPENVRML_LOCAL const std::vector<openvrml::int32>
+    counted_runs(const std::vector<openvrml::int32> & count,
+                 const std::size_t vertices)
+        OPENVRML_THROW1(std::bad_alloc)
+    {
+        std::vector<openvrml::int32> index;
+        openvrml::int32 next = 0;
+        for (std::vector<openvrml::int32>::const_iterator run = count.begin();
+             run != count.end();
+             ++run) {
+            for (openvrml::int32 i = 0;
+                 i < *run && std::size_t(next) < vertices;
+                 ++i) {
+                index.push_back(next++);
+            }
+            index.push_back(-1);
+        }
+        return index;
+    }
+
     /**
      * @brief Represents TriangleStripSet node instances.
      */
@@ -53,6 +87,9 @@ namespace {
         sfbool normal_per_vertex_;
         sfbool solid_;
         bounding_sphere bsphere;
+        std::vector<int32> mesh_coord_index_;
+        bool mesh_dirty_;
+        normal_cache generated_normals_;
 
     public:
         triangle_strip_set_node(
@@ -135,6 +172,24 @@ namespace {
      * @brief solid field
      */
 
+    /**
+     * @var triangle_strip_set_node::mesh_coord_index_
+     *
+     * @brief Coordinate indices of the triangles.
+     */
+
+    /**
+     * @var triangle_strip_set_node::mesh_dirty_
+     *
+     * @brief Whether @a mesh_coord_index_ needs to be recomputed.
+     */
+
+    /**
+     * @var triangle_strip_set_node::generated_normals_
+     *
+     * @brief Normals generated when the normal field is @c NULL.
+     */
+
 
     /**
      * @brief Get the bounding volume.
@@ -180,16 +235,102 @@ namespace {
     /**
      * @brief Insert this geometry into @p viewer's display list.
      *
-     * @param viewer    a Viewer.
-     * @param context   the rendering context.
+     * The coordinates are consumed in order, stripCount[i] of them for
+     * the i-th strip.
+     *
+     * If the normal field is @c NULL and normalPerVertex is @c TRUE,
+     * the normal at each vertex is the average of the normals of the
+     * triangles that share it.
      *
-     * @todo Implement this!
+     * @param v         a @c viewer.
+     * @param context   the rendering context.
      */
     void
     triangle_strip_set_node::
-    do_render_geometry(openvrml::viewer & /* viewer */,
+    do_render_geometry(openvrml::viewer & v,
                        const rendering_context /* context */)
-    {}
+    {
+        coordinate_node * const coordinateNode =
+            node_cast<coordinate_node *>(this->coord_.sfnode::value().get());
+        const vector<vec3f> & coord = coordinateNode
+            ? coordinateNode->point()
+            : vector<vec3f>();
+
+        color_node * const colorNode =
+            node_cast<color_node *>(this->color_.sfnode::value().get());
+        const vector<openvrml::color> & color = colorNode
+            ? colorNode->color()
+            : vector<openvrml::color>();
+
+        normal_node * const normalNode =
+            node_cast<normal_node *>(this->normal_.sfnode::value().get());
+        const vector<vec3f> & normal = normalNode
+            ? normalNode->vector()
+            : vector<vec3f>();
+
+        texture_coordinate_node * const texCoordNode =
+            node_cast<texture_coordinate_node *>(
+                this->tex_coord_.sfnode::value().get());
+        const vector<vec2f> & texCoord = texCoordNode
+            ? texCoordNode->point()
+            : vector<vec2f>();
+
+        if (this->mesh_dirty_ || this->modified()) {
+            vector<int32> coord_index;
+            triangle_strip_coord_index(
+                counted_runs(this->strip_count_.mfint32::value(),
+                             coord.size()),
+                coord_index);
+            if (coord_index != this->mesh_coord_index_) {
+                this->mesh_coord_index_.swap(coord_index);
+                this->generated_normals_.invalidate();
+            }
+            this->mesh_dirty_ = false;
+        }
+
+        const bool generate_normals =
+            !normalNode && coordinateNode && this->normal_per_vertex_.value();
+        if (generate_normals
+            && !this->generated_normals_.valid(coordinateNode)) {
+            this->generated_normals_.generate(coordinateNode,
+                                              coord,
+                                              this->mesh_coord_index_,
+                                              float(local::pi),
+                                              this->ccw_.value());
+        }
+
+        unsigned int mask = viewer::mask_convex;
+        if (this->ccw_.value()) { mask |= viewer::mask_ccw; }
+        if (this->solid_.value()) { mask |= viewer::mask_solid; }
+        if (this->color_per_vertex_.value()) {
+            mask |= viewer::mask_color_per_vertex;
+        }
+        if (this->normal_per_vertex_.value()) {
+            mask |= viewer::mask_normal_per_vertex;
+        }
+
+        //
+        // Colors, normals, and texture coordinates are given per vertex; so
+        // they are indexed like the coordinates.
+        //
+        const vector<int32> no_index;
+        v.insert_shell(*this,
+                       mask,
+                       coord, this->mesh_coord_index_,
+                       color, no_index,
+                       generate_normals
+                       ? this->generated_normals_.normal()
+                       : normal,
+                       generate_normals
+                       ? this->generated_normals_.normal_index()
+                       : no_index,
+                       texCoord, no_index);
+
+        if (colorNode) { colorNode->modified(false); }
+        if (coordinateNode) { coordinateNode->modified(false); }
+        if (normalNode) { normalNode->modified(false); }
+        if (texCoordNode) { texCoordNode->modified(false); }
+    }
 
 
     /**
@@ -230,7 +371,8 @@ namespace {
         ccw_(true),
         color_per_vertex_(true),
         normal_per_vertex_(true),
-        solid_(true)
+        solid_(true),
+        mesh_dirty_(true)
     {}
 
     /**
@@ -0,0 +1,156 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+//
+// Microbenchmark for event delivery: a single emitter of each field value
+// type sends events to N listeners.
+//
+// Usage: bench-event-fanout [listeners [events]]
+//
+
+# include <cstdlib>
+# include <iomanip>
+# include <iostream>
+# include <boost/lexical_cast.hpp>
+# include <boost/ptr_container/ptr_vector.hpp>
+# include <openvrml/browser.h>
+
+using namespace std;
+using namespace openvrml;
+
+namespace {
+
+    template <typename FieldValue>
+    class bench_emitter : public field_value_emitter<FieldValue> {
+    public:
+        explicit bench_emitter(const FieldValue & value):
+            event_emitter(value),
+            field_value_emitter<FieldValue>(value)
+        {}
+
+        virtual ~bench_emitter() OPENVRML_NOTHROW
+        {}
+
+        void emit(const double timestamp)
+        {
+            openvrml::event_emitter::emit_event<FieldValue>(timestamp);
+        }
+
+    private:
+        virtual const std::string do_eventout_id() const OPENVRML_NOTHROW
+        {
+            return "value_changed";
+        }
+    };
+
+    template <typename FieldValue>
+    class bench_listener : public field_value_listener<FieldValue> {
+        size_t * events_;
+
+    public:
+        explicit bench_listener(size_t & events):
+            events_(&events)
+        {}
+
+        virtual ~bench_listener() OPENVRML_NOTHROW
+        {}
+
+    private:
+        virtual void do_process_event(const FieldValue &, double)
+            OPENVRML_THROW1(std::bad_alloc)
+        {
+            ++*this->events_;
+        }
+    };
+
+    template <typename FieldValue>
+    void fan_out(const char * const name,
+                 const size_t listener_count,
+                 const size_t event_count)
+    {
+        const FieldValue value;
+        bench_emitter<FieldValue> emitter(value);
+
+        size_t delivered = 0;
+        boost::ptr_vector<bench_listener<FieldValue> > listeners;
+        for (size_t i = 0; i < listener_count; ++i) {
+            listeners.push_back(new bench_listener<FieldValue>(delivered));
+            emitter.add(listeners.back());
+        }
+
+        const double start = browser::current_time();
+        for (size_t i = 0; i < event_count; ++i) {
+            emitter.emit(double(i));
+        }
+        const double elapsed = browser::current_time() - start;
+
+        cout << setw(14) << left << name
+             << setw(10) << right << fixed << setprecision(2)
+             << (delivered > 0 ? elapsed / double(delivered) * 1.0e9 : 0.0)
+             << " ns/delivery" << endl;
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    try {
+        using boost::lexical_cast;
+
+        const size_t listeners =
+            (argc > 1) ? lexical_cast<size_t>(argv[1]) : 64;
+        const size_t events =
+            (argc > 2) ? lexical_cast<size_t>(argv[2]) : 100000;
+
+        cout << "listeners: " << listeners << "  events: " << events << '\n';
+
+        fan_out<sfbool>("SFBool", listeners, events);
+        fan_out<sfcolor>("SFColor", listeners, events);
+        fan_out<sfcolorrgba>("SFColorRGBA", listeners, events);
+        fan_out<sfdouble>("SFDouble", listeners, events);
+        fan_out<sffloat>("SFFloat", listeners, events);
+        fan_out<sfimage>("SFImage", listeners, events);
+        fan_out<sfint32>("SFInt32", listeners, events);
+        fan_out<sfnode>("SFNode", listeners, events);
+        fan_out<sfrotation>("SFRotation", listeners, events);
+        fan_out<sfstring>("SFString", listeners, events);
+        fan_out<sftime>("SFTime", listeners, events);
+        fan_out<sfvec2d>("SFVec2d", listeners, events);
+        fan_out<sfvec2f>("SFVec2f", listeners, events);
+        fan_out<sfvec3d>("SFVec3d", listeners, events);
+        fan_out<sfvec3f>("SFVec3f", listeners, events);
+        fan_out<mfbool>("MFBool", listeners, events);
+        fan_out<mfcolor>("MFColor", listeners, events);
+        fan_out<mfcolorrgba>("MFColorRGBA", listeners, events);
+        fan_out<mfdouble>("MFDouble", listeners, events);
+        fan_out<mffloat>("MFFloat", listeners, events);
+        fan_out<mfimage>("MFImage", listeners, events);
+        fan_out<mfint32>("MFInt32", listeners, events);
+        fan_out<mfnode>("MFNode", listeners, events);
+        fan_out<mfrotation>("MFRotation", listeners, events);
+        fan_out<mfstring>("MFString", listeners, events);
+        fan_out<mftime>("MFTime", listeners, events);
+        fan_out<mfvec2d>("MFVec2d", listeners, events);
+        fan_out<mfvec2f>("MFVec2f", listeners, events);
+        fan_out<mfvec3d>("MFVec3d", listeners, events);
+        fan_out<mfvec3f>("MFVec3f", listeners, events);
+    } catch (std::exception & ex) {
+        cerr << argv[0] << ": " << ex.what() << endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,216 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+//
+// First-frame latency benchmark: a world of Transforms holding a smooth
+// IndexedFaceSet grid, an Extrusion, and a Sphere is loaded with
+// browser::set_world and drawn once with browser::render.  The render
+// queue compiles each mesh it does not find in the browser's
+// compiled_mesh_cache, and the viewer copies every mesh as an upload would.
+// The world is loaded with the meshes left to the first frame and then
+// compiled by 1 to N threads; the load time, the first frame time, their
+// sum, and the number of meshes compiled by the first frame are reported for
+// each.
+//
+// Usage: bench-first-frame [subtrees [grid-size [iterations [threads]]]]
+//
+
+# include <cmath>
+# include <cstdlib>
+# include <iomanip>
+# include <iostream>
+# include <sstream>
+# include <boost/lexical_cast.hpp>
+# include <boost/thread.hpp>
+# include <openvrml/compiled_mesh.h>
+# include "string_resource_istream.h"
+# include "test_resource_fetcher.h"
+# include "test_viewer.h"
+
+using namespace std;
+using namespace openvrml;
+
+namespace {
+
+    const char url[] = "file:///bench-first-frame.wrl";
+
+    const std::string world(const size_t subtrees, const size_t grid_size)
+    {
+        ostringstream vrml;
+        vrml << "#VRML V2.0 utf8\n";
+        for (size_t i = 0; i < subtrees; ++i) {
+            vrml << "Transform { translation " << i << " 0 0 children [\n"
+                 << "  Shape { geometry IndexedFaceSet {\n"
+                 << "    creaseAngle 1\n"
+                 << "    coord Coordinate { point [\n";
+            for (size_t z = 0; z <= grid_size; ++z) {
+                for (size_t x = 0; x <= grid_size; ++x) {
+                    vrml << x << ' '
+                         << std::sin(double(x + i) * 0.3)
+                            * std::cos(double(z) * 0.3)
+                         << ' ' << z << ",\n";
+                }
+            }
+            vrml << "    ] }\n"
+                 << "    coordIndex [\n";
+            for (size_t z = 0; z < grid_size; ++z) {
+                for (size_t x = 0; x < grid_size; ++x) {
+                    const size_t v = z * (grid_size + 1) + x;
+                    vrml << v << ' ' << v + grid_size + 1 << ' '
+                         << v + grid_size + 2 << ' ' << v + 1 << " -1\n";
+                }
+            }
+            vrml << "    ]\n"
+                 << "  } }\n"
+                 << "  Shape { geometry Extrusion {\n"
+                 << "    creaseAngle 1\n"
+                 << "    spine [ 0 0 0, 0 1 0, 0.5 2 0, 1 3 0, 1 4 0 ]\n"
+                 << "    scale [ 1 1, 0.8 0.8, 0.6 0.6, 0.8 0.8, 1 1 ]\n"
+                 << "  } }\n"
+                 << "  Shape { geometry Sphere { radius "
+                 << 0.5 + 0.001 * double(i) << " } }\n"
+                 << "] }\n";
+        }
+        return vrml.str();
+    }
+
+    //
+    // Draws nothing.  The meshes the render queue passes to insert_mesh are
+    // copied.
+    //
+    class bench_viewer : public test_viewer {
+        std::vector<float> upload_;
+
+    public:
+        virtual ~bench_viewer() throw ()
+        {}
+
+    private:
+        virtual void do_insert_mesh(const geometry_node &,
+                                    const compiled_mesh & mesh)
+        {
+            this->upload_.clear();
+            for (size_t i = 0; i < mesh.coord.size(); ++i) {
+                this->upload_.insert(this->upload_.end(),
+                                     &mesh.coord[i][0],
+                                     &mesh.coord[i][0] + 3);
+                if (i < mesh.normal.size()) {
+                    this->upload_.insert(this->upload_.end(),
+                                         &mesh.normal[i][0],
+                                         &mesh.normal[i][0] + 3);
+                }
+            }
+        }
+    };
+
+    struct result {
+        double load, first_frame;
+        size_t meshes_compiled;
+    };
+
+    const result time_first_frame(browser & b,
+                                  const std::string & vrml,
+                                  const size_t iterations)
+    {
+        result r = { 0.0, 0.0, 0 };
+        for (size_t i = 0; i < iterations; ++i) {
+            string_resource_istream in(url, vrml);
+            const double start = browser::current_time();
+            b.set_world(in);
+            const double loaded = browser::current_time();
+            const size_t meshes_loaded = b.compiled_meshes().size();
+            b.render();
+            const double drawn = browser::current_time();
+            r.load += loaded - start;
+            r.first_frame += drawn - loaded;
+            r.meshes_compiled +=
+                b.compiled_meshes().size() - meshes_loaded;
+
+            string_resource_istream empty(url, "#VRML V2.0 utf8\n");
+            b.set_world(empty);
+        }
+        return r;
+    }
+
+    void report(const char * const label, const result & r,
+                const size_t iterations)
+    {
+        cout << setw(8) << label
+             << setw(12) << fixed << setprecision(3)
+             << r.load * 1.0e3 / double(iterations)
+             << setw(16) << r.first_frame * 1.0e3 / double(iterations)
+             << setw(12) << (r.load + r.first_frame) * 1.0e3
+                            / double(iterations)
+             << setw(18) << r.meshes_compiled / iterations << '\n';
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    try {
+        using boost::lexical_cast;
+
+        const size_t subtrees =
+            (argc > 1) ? lexical_cast<size_t>(argv[1]) : 200;
+        const size_t grid_size =
+            (argc > 2) ? lexical_cast<size_t>(argv[2]) : 32;
+        const size_t iterations =
+            (argc > 3) ? lexical_cast<size_t>(argv[3]) : 3;
+        size_t max_threads =
+            (argc > 4) ? lexical_cast<size_t>(argv[4])
+                       : boost::thread::hardware_concurrency();
+        if (max_threads == 0) { max_threads = 1; }
+
+        const std::string vrml = world(subtrees, grid_size);
+
+        bench_viewer v;
+        test_resource_fetcher fetcher;
+        browser b(fetcher, cout, cerr);
+        b.viewer(&v);
+
+        cout << "subtrees: " << subtrees
+             << "  grid size: " << grid_size
+             << "  iterations: " << iterations
+             << "  cores: " << boost::thread::hardware_concurrency() << '\n'
+             << setw(8) << "threads"
+             << setw(12) << "load ms"
+             << setw(16) << "first frame ms"
+             << setw(12) << "total ms"
+             << setw(18) << "frame compiled" << '\n';
+
+        //
+        // Warm up, so that the node_types are created and cached.
+        //
+        b.mesh_compile_threads(0);
+        time_first_frame(b, vrml, 1);
+
+        report("frame", time_first_frame(b, vrml, iterations),
+               iterations);
+        for (size_t threads = 1; threads <= max_threads; ++threads) {
+            b.mesh_compile_threads(threads);
+            report(lexical_cast<std::string>(threads).c_str(),
+                   time_first_frame(b, vrml, iterations),
+                   iterations);
+        }
+        cout << flush;
+    } catch (std::exception & ex) {
+        cerr << argv[0] << ": " << ex.what() << endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,105 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+//
+// Microbenchmark for node reference counting: repeatedly copies a large
+// mfnode value, which increments and decrements the reference count of each
+// node in the vector.
+//
+// Usage: bench-mfnode-copy [node-count [iterations [threads]]]
+//
+
+# include <cstdlib>
+# include <iostream>
+# include <sstream>
+# include <boost/lexical_cast.hpp>
+# include <boost/thread.hpp>
+# include "test_resource_fetcher.h"
+
+using namespace std;
+using namespace openvrml;
+
+namespace {
+
+    struct copy_mfnode {
+        copy_mfnode(const mfnode::value_type & nodes,
+                    const size_t iterations):
+            nodes_(&nodes),
+            iterations_(iterations)
+        {}
+
+        void operator()() const
+        {
+            for (size_t i = 0; i < this->iterations_; ++i) {
+                mfnode copy(*this->nodes_);
+                mfnode::value_type value = copy.value();
+                mfnode::value_type(value).swap(value);
+            }
+        }
+
+    private:
+        const mfnode::value_type * nodes_;
+        size_t iterations_;
+    };
+}
+
+int main(int argc, char * argv[])
+{
+    try {
+        using boost::lexical_cast;
+
+        const size_t node_count =
+            (argc > 1) ? lexical_cast<size_t>(argv[1]) : 200000;
+        const size_t iterations =
+            (argc > 2) ? lexical_cast<size_t>(argv[2]) : 20;
+        const size_t threads =
+            (argc > 3) ? lexical_cast<size_t>(argv[3]) : 1;
+
+        test_resource_fetcher fetcher;
+        browser b(fetcher, cout, cerr);
+
+        ostringstream vrml;
+        for (size_t i = 0; i < node_count; ++i) { vrml << "Group {}\n"; }
+        istringstream in(vrml.str());
+        const mfnode::value_type nodes = b.create_vrml_from_stream(in);
+
+        const double start = browser::current_time();
+        boost::thread_group group;
+        for (size_t i = 0; i < threads; ++i) {
+            group.create_thread(copy_mfnode(nodes, iterations));
+        }
+        group.join_all();
+        const double elapsed = browser::current_time() - start;
+
+        //
+        // Each iteration copies the vector three times.
+        //
+        const double copies =
+            3.0 * double(node_count) * double(iterations) * double(threads);
+        cout << "nodes: " << node_count
+             << "  iterations: " << iterations
+             << "  threads: " << threads << '\n'
+             << "elapsed: " << elapsed << " s  ("
+             << (elapsed > 0.0 ? copies / elapsed / 1.0e6 : 0.0)
+             << " M pointer copies/s)" << endl;
+    } catch (std::exception & ex) {
+        cerr << argv[0] << ": " << ex.what() << endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
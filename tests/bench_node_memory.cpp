@@ -0,0 +1,104 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+//
+// Memory benchmark: reports the number of heap bytes retained per node
+// (including its field, eventIn and eventOut storage) for each node type in
+// the VRML97 node set.
+//
+// Usage: bench-node-memory [instances]
+//
+
+# include <cstdlib>
+# include <iomanip>
+# include <iostream>
+# include <sstream>
+# include <boost/lexical_cast.hpp>
+# include "memory_usage.h"
+# include "test_resource_fetcher.h"
+
+using namespace std;
+using namespace openvrml;
+
+namespace {
+
+    const char * const vrml97_node_types[] = {
+        "Anchor", "Appearance", "AudioClip", "Background", "Billboard",
+        "Box", "Collision", "Color", "ColorInterpolator", "Cone",
+        "Coordinate", "CoordinateInterpolator", "Cylinder", "CylinderSensor",
+        "DirectionalLight", "ElevationGrid", "Extrusion", "Fog", "FontStyle",
+        "Group", "ImageTexture", "IndexedFaceSet", "IndexedLineSet", "Inline",
+        "LOD", "Material", "MovieTexture", "NavigationInfo", "Normal",
+        "NormalInterpolator", "OrientationInterpolator", "PixelTexture",
+        "PlaneSensor", "PointLight", "PointSet", "PositionInterpolator",
+        "ProximitySensor", "ScalarInterpolator", "Script", "Shape", "Sound",
+        "Sphere", "SphereSensor", "SpotLight", "Switch", "Text",
+        "TextureCoordinate", "TextureTransform", "TimeSensor", "TouchSensor",
+        "Transform", "Viewpoint", "VisibilitySensor", "WorldInfo"
+    };
+}
+
+int main(int argc, char * argv[])
+{
+    try {
+        const size_t instances =
+            (argc > 1) ? boost::lexical_cast<size_t>(argv[1]) : 1000;
+
+        test_resource_fetcher fetcher;
+        browser b(fetcher, cout, cerr);
+
+        const size_t node_type_count =
+            sizeof vrml97_node_types / sizeof vrml97_node_types[0];
+        double total = 0.0;
+        for (size_t i = 0; i < node_type_count; ++i) {
+            ostringstream vrml;
+            for (size_t j = 0; j < instances; ++j) {
+                vrml << vrml97_node_types[i] << " {}\n";
+            }
+            istringstream in(vrml.str());
+
+            //
+            // Parse once so that the node_type is created and cached; only
+            // the per-instance storage is measured.
+            //
+            {
+                istringstream warm_up(string(vrml97_node_types[i]) + " {}");
+                b.create_vrml_from_stream(warm_up);
+            }
+
+            const size_t before = live_bytes();
+            const vector<boost::intrusive_ptr<node> > nodes =
+                b.create_vrml_from_stream(in);
+            const size_t after = live_bytes();
+
+            const double bytes_per_node =
+                double(after - before) / double(nodes.size());
+            total += bytes_per_node;
+            cout << setw(24) << left << vrml97_node_types[i]
+                 << setw(10) << right << fixed << setprecision(1)
+                 << bytes_per_node << " bytes/node\n";
+        }
+        cout << setw(24) << left << "mean"
+             << setw(10) << right << fixed << setprecision(1)
+             << total / double(node_type_count) << " bytes/node" << endl;
+    } catch (std::exception & ex) {
+        cerr << argv[0] << ": " << ex.what() << endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
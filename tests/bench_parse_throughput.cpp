@@ -0,0 +1,156 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+//
+// Parse throughput benchmark: a world consisting mostly of IndexedFaceSet
+// coordinates and indices is parsed with browser::create_vrml_from_stream,
+// once with the Spirit grammars (OPENVRML_VRML_PARSER=spirit) and once with
+// the hand-written parser.  The hand-written parser is then run again on the
+// same world without DEFs, with browser::parse_threads set to the number of
+// hardware threads.  Throughput is reported in MB/s.
+//
+// Usage: bench-parse-throughput [megabytes [iterations]]
+//
+
+# include <algorithm>
+# include <cstdlib>
+# include <iomanip>
+# include <iostream>
+# include <sstream>
+# include <stdlib.h>
+# include <boost/lexical_cast.hpp>
+# include <boost/thread.hpp>
+# include "test_resource_fetcher.h"
+
+using namespace std;
+using namespace openvrml;
+
+namespace {
+
+    const std::string world(const size_t megabytes, const bool named)
+    {
+        const size_t size = megabytes * 1024 * 1024;
+        ostringstream vrml;
+        vrml << "#VRML V2.0 utf8\n";
+        size_t shape = 0;
+        while (size_t(vrml.tellp()) < size) {
+            if (named) { vrml << "DEF S" << shape << ' '; }
+            ++shape;
+            vrml << "Shape {\n"
+                 << "  geometry IndexedFaceSet {\n"
+                 << "    coord Coordinate {\n"
+                 << "      point [\n";
+            for (size_t i = 0; i < 256; ++i) {
+                vrml << "        " << (i * 0.125) << ' '
+                     << (i % 17) * -0.0625 << ' ' << 1.5e-3 * i << ",\n";
+            }
+            vrml << "      ]\n"
+                 << "    }\n"
+                 << "    coordIndex [\n";
+            for (size_t i = 0; i + 2 < 256; ++i) {
+                vrml << "      " << i << ", " << i + 1 << ", " << i + 2
+                     << ", -1,\n";
+            }
+            vrml << "    ]\n"
+                 << "  }\n"
+                 << "}\n";
+        }
+        return vrml.str();
+    }
+
+    double parse(browser & b, const std::string & vrml,
+                 const size_t iterations)
+    {
+        double elapsed = 0.0;
+        for (size_t i = 0; i < iterations; ++i) {
+            istringstream in(vrml);
+            const double start = browser::current_time();
+            b.create_vrml_from_stream(in);
+            elapsed += browser::current_time() - start;
+        }
+        return elapsed;
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    try {
+        using boost::lexical_cast;
+
+        const size_t megabytes =
+            (argc > 1) ? lexical_cast<size_t>(argv[1]) : 8;
+        const size_t iterations =
+            (argc > 2) ? lexical_cast<size_t>(argv[2]) : 3;
+
+        const std::string vrml = world(megabytes, true);
+        const std::string unnamed_vrml = world(megabytes, false);
+        const double total_mb =
+            double(vrml.size()) * iterations / (1024.0 * 1024.0);
+
+        test_resource_fetcher fetcher;
+        browser b(fetcher, cout, cerr);
+
+        //
+        // Warm up, so that the node_types are created and cached.
+        //
+        {
+            istringstream in("#VRML V2.0 utf8\nShape {}\n");
+            b.create_vrml_from_stream(in);
+        }
+
+        setenv("OPENVRML_VRML_PARSER", "spirit", 1);
+        const double spirit = parse(b, vrml, iterations);
+
+        setenv("OPENVRML_VRML_PARSER", "scanner", 1);
+        const double scanner = parse(b, vrml, iterations);
+
+        const size_t threads =
+            std::max(boost::thread::hardware_concurrency(), 2u);
+        b.parse_threads(threads);
+        const double concurrent = parse(b, unnamed_vrml, iterations);
+        b.parse_threads(0);
+        const double unnamed_total_mb =
+            double(unnamed_vrml.size()) * iterations / (1024.0 * 1024.0);
+        const std::string concurrent_label =
+            "scanner x" + boost::lexical_cast<std::string>(threads);
+
+        cout << "bytes: " << vrml.size()
+             << "  iterations: " << iterations << '\n'
+             << setw(12) << left << "parser"
+             << setw(12) << right << "ms" << setw(12) << "MB/s" << '\n'
+             << fixed << setprecision(1)
+             << setw(12) << left << "spirit"
+             << setw(12) << right << spirit * 1.0e3 / double(iterations)
+             << setw(12) << total_mb / spirit << '\n'
+             << setw(12) << left << "scanner"
+             << setw(12) << right << scanner * 1.0e3 / double(iterations)
+             << setw(12) << total_mb / scanner << '\n'
+             << setw(12) << left << concurrent_label
+             << setw(12) << right << concurrent * 1.0e3 / double(iterations)
+             << setw(12) << unnamed_total_mb / concurrent << '\n'
+             << "speedup: " << setprecision(2) << spirit / scanner << 'x'
+             << '\n'
+             << "concurrent speedup (MB/s): "
+             << (unnamed_total_mb / concurrent) / (total_mb / scanner) << 'x'
+             << endl;
+    } catch (std::exception & ex) {
+        cerr << argv[0] << ": " << ex.what() << endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,146 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+//
+// Render state benchmark: a world of Transforms, each holding a Shape whose
+// Appearance uses one of a few Materials and PixelTextures, is drawn with
+// browser::render.  In draw_mode the browser queues the geometry and draws
+// it sorted by state; in pick_mode it draws in traversal order.  The viewer
+// state changes per frame and the time per frame are reported for each.
+//
+// Usage: bench-render-state [shapes [materials [textures [frames]]]]
+//
+
+# include <cstdlib>
+# include <iomanip>
+# include <iostream>
+# include <sstream>
+# include <boost/lexical_cast.hpp>
+# include "string_resource_istream.h"
+# include "test_resource_fetcher.h"
+# include "test_viewer.h"
+
+using namespace std;
+using namespace openvrml;
+
+namespace {
+
+    const char url[] = "file:///bench-render-state.wrl";
+
+    //
+    // Shape i uses material i % materials and texture i % textures; every
+    // seventh Material is partly transparent.
+    //
+    const std::string world(const size_t shapes,
+                            const size_t materials,
+                            const size_t textures)
+    {
+        ostringstream vrml;
+        vrml << "#VRML V2.0 utf8\n";
+        for (size_t i = 0; i < shapes; ++i) {
+            const size_t m = i % materials, t = i % textures;
+            vrml << "Transform { translation " << i % 32 << ' '
+                 << i / 32 << " 0 children Shape {\n"
+                 << "  appearance Appearance {\n";
+            if (i < materials) {
+                vrml << "    material DEF M" << m << " Material {"
+                     << " diffuseColor " << double(m % 5) / 4.0 << ' '
+                     << double(m % 3) / 2.0 << " 0.5"
+                     << " transparency " << ((m % 7 == 6) ? 0.5 : 0.0)
+                     << " }\n";
+            } else {
+                vrml << "    material USE M" << m << '\n';
+            }
+            if (i < textures) {
+                vrml << "    texture DEF T" << t << " PixelTexture {"
+                     << " image 2 2 3 0x" << hex << (0x10 * (t % 16))
+                     << "0000 0xFFFFFF 0xFFFFFF 0x000000" << dec << " }\n";
+            } else {
+                vrml << "    texture USE T" << t << '\n';
+            }
+            vrml << "  }\n"
+                 << "  geometry " << ((i % 2) ? "Box {}" : "Sphere {}")
+                 << "\n} }\n";
+        }
+        return vrml.str();
+    }
+
+    void report(const char * const label,
+                browser & b,
+                test_viewer & v,
+                const viewer::rendering_mode mode,
+                const size_t frames)
+    {
+        v.rendering = mode;
+        b.render();
+
+        const double start = browser::current_time();
+        for (size_t i = 0; i < frames; ++i) { b.render(); }
+        const double elapsed = browser::current_time() - start;
+
+        cout << setw(16) << label
+             << setw(16) << v.state_changes()
+             << setw(16) << fixed << setprecision(3)
+             << elapsed * 1.0e3 / double(frames) << '\n';
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    try {
+        using boost::lexical_cast;
+
+        const size_t shapes =
+            (argc > 1) ? lexical_cast<size_t>(argv[1]) : 2000;
+        const size_t materials =
+            (argc > 2) ? lexical_cast<size_t>(argv[2]) : 8;
+        const size_t textures =
+            (argc > 3) ? lexical_cast<size_t>(argv[3]) : 4;
+        const size_t frames =
+            (argc > 4) ? lexical_cast<size_t>(argv[4]) : 20;
+        if (materials == 0 || textures == 0) {
+            cerr << argv[0] << ": materials and textures must be nonzero"
+                 << endl;
+            return EXIT_FAILURE;
+        }
+
+        test_viewer v;
+        test_resource_fetcher fetcher;
+        browser b(fetcher, cout, cerr);
+        b.viewer(&v);
+
+        string_resource_istream in(url, world(shapes, materials, textures));
+        b.set_world(in);
+
+        cout << "shapes: " << shapes
+             << "  materials: " << materials
+             << "  textures: " << textures
+             << "  frames: " << frames << '\n'
+             << setw(16) << "order"
+             << setw(16) << "state changes"
+             << setw(16) << "ms per frame" << '\n';
+
+        report("traversal", b, v, viewer::pick_mode, frames);
+        report("sorted", b, v, viewer::draw_mode, frames);
+        cout << flush;
+    } catch (std::exception & ex) {
+        cerr << argv[0] << ": " << ex.what() << endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,179 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+//
+// Scene load benchmark: a world of Transform/Shape subtrees is loaded as the
+// browser's world (whose nodes are placed in the scene's node arena) and
+// with browser::create_vrml_from_stream (whose nodes come from the free
+// store).  The load time, the time to destroy the nodes, and the number of
+// heap allocations made are reported for each.  The world is also loaded
+// repeatedly into the same scene, as an Inline does when its url changes;
+// the resident size after each kind of load shows whether memory is
+// returned, and the peak resident size is reported at the end.
+//
+// Usage: bench-scene-load [subtrees [iterations]]
+//
+
+# include <cstdlib>
+# include <iomanip>
+# include <iostream>
+# include <sstream>
+# include <boost/lexical_cast.hpp>
+# include <openvrml/scene.h>
+# include "memory_usage.h"
+# include "string_resource_istream.h"
+# include "test_resource_fetcher.h"
+
+using namespace std;
+using namespace openvrml;
+
+namespace {
+
+    const char url[] = "file:///bench-scene-load.wrl";
+
+    const std::string world(const size_t subtrees)
+    {
+        ostringstream vrml;
+        vrml << "#VRML V2.0 utf8\n";
+        for (size_t i = 0; i < subtrees; ++i) {
+            vrml << "Transform { translation " << i << " 0 0 children [\n"
+                 << "  Shape {\n"
+                 << "    appearance Appearance {"
+                 << " material Material { diffuseColor 1 0 0 } }\n"
+                 << "    geometry IndexedFaceSet {\n"
+                 << "      coord Coordinate {"
+                 << " point [ 0 0 0, 1 0 0, 1 1 0, 0 1 0 ] }\n"
+                 << "      coordIndex [ 0 1 2 3 -1 ]\n"
+                 << "    }\n"
+                 << "  }\n"
+                 << "  Group { children Shape { geometry Box {} } }\n"
+                 << "] }\n";
+        }
+        return vrml.str();
+    }
+
+    struct result {
+        double load, destroy;
+        size_t allocations;
+        size_t resident;
+    };
+
+    void report(const char * const label, const result & r,
+                const size_t iterations)
+    {
+        cout << setw(24) << left << label
+             << setw(12) << right << fixed << setprecision(3)
+             << r.load * 1.0e3 / double(iterations)
+             << setw(12) << r.destroy * 1.0e3 / double(iterations)
+             << setw(14) << r.allocations / iterations
+             << setw(14) << r.resident << '\n';
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    try {
+        using boost::lexical_cast;
+
+        const size_t subtrees =
+            (argc > 1) ? lexical_cast<size_t>(argv[1]) : 2000;
+        const size_t iterations =
+            (argc > 2) ? lexical_cast<size_t>(argv[2]) : 5;
+
+        const std::string vrml = world(subtrees);
+
+        test_resource_fetcher fetcher;
+        browser b(fetcher, cout, cerr);
+
+        //
+        // Warm up, so that the node_types are created and cached.
+        //
+        {
+            istringstream in(vrml);
+            b.create_vrml_from_stream(in);
+        }
+
+        result arena = { 0.0, 0.0, 0, 0 };
+        result heap = { 0.0, 0.0, 0, 0 };
+        result reload = { 0.0, 0.0, 0, 0 };
+        for (size_t i = 0; i < iterations; ++i) {
+            {
+                string_resource_istream in(url, vrml);
+                const size_t before = allocations();
+                const double start = browser::current_time();
+                b.set_world(in);
+                const double loaded = browser::current_time();
+                arena.allocations += allocations() - before;
+                arena.load += loaded - start;
+
+                string_resource_istream empty(url, "#VRML V2.0 utf8\n");
+                b.set_world(empty);
+                arena.destroy += browser::current_time() - loaded;
+                arena.resident = resident_kib();
+            }
+            {
+                istringstream in(vrml);
+                const size_t before = allocations();
+                const double start = browser::current_time();
+                std::vector<boost::intrusive_ptr<node> > nodes =
+                    b.create_vrml_from_stream(in);
+                const double loaded = browser::current_time();
+                heap.allocations += allocations() - before;
+                heap.load += loaded - start;
+
+                nodes.clear();
+                heap.destroy += browser::current_time() - loaded;
+                heap.resident = resident_kib();
+            }
+        }
+
+        //
+        // Each load replaces the scene's nodes; the time to destroy the
+        // previous ones is part of the load.
+        //
+        {
+            scene inline_scene(b, b.root_scene());
+            for (size_t i = 0; i < iterations; ++i) {
+                string_resource_istream in(url, vrml);
+                const size_t before = allocations();
+                const double start = browser::current_time();
+                inline_scene.load(in);
+                reload.load += browser::current_time() - start;
+                reload.allocations += allocations() - before;
+                reload.resident = resident_kib();
+            }
+        }
+
+        cout << "subtrees: " << subtrees
+             << "  iterations: " << iterations << '\n'
+             << setw(24) << left << "allocator"
+             << setw(12) << right << "load ms"
+             << setw(12) << "destroy ms"
+             << setw(14) << "allocations"
+             << setw(14) << "resident KiB" << '\n';
+        report("scene arena", arena, iterations);
+        report("free store", heap, iterations);
+        report("scene reload", reload, iterations);
+        cout << "peak resident KiB: " << peak_resident_kib() << '\n'
+             << flush;
+    } catch (std::exception & ex) {
+        cerr << argv[0] << ": " << ex.what() << endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
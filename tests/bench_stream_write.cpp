@@ -0,0 +1,126 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+//
+// Throughput benchmark for the openvrml_control::browser
+// new_stream/write/destroy_stream path, which is how openvrml-xembed feeds
+// the initial world to libopenvrml.  The world is mostly comments, so that
+// the time is dominated by moving the data from the writing thread to the
+// reading thread rather than by parsing.  Throughput is reported in MB/s for
+// several write sizes.
+//
+// Usage: bench-stream-write [megabytes [iterations]]
+//
+
+# include <cstdlib>
+# include <iomanip>
+# include <iostream>
+# include <string>
+# include <boost/lexical_cast.hpp>
+# include <openvrml_control/browser.h>
+
+using namespace std;
+
+namespace {
+
+    class null_browser_host : public openvrml_control::browser_host {
+        virtual int do_get_url(const std::string &)
+        {
+            return -1;
+        }
+    };
+
+    const std::string world(const size_t megabytes)
+    {
+        const size_t size = megabytes * 1024 * 1024;
+        std::string vrml = "#VRML V2.0 utf8\n";
+        const std::string line(79, '#');
+        while (vrml.size() < size) {
+            vrml += line;
+            vrml += '\n';
+        }
+        return vrml;
+    }
+
+    double stream(const std::string & vrml, const size_t write_size)
+    {
+        null_browser_host host;
+        const double start = openvrml::browser::current_time();
+        {
+            static const bool expect_initial_stream = true;
+            openvrml_control::browser b(host, expect_initial_stream);
+            static const uint64_t stream_id = 1;
+            b.new_stream(stream_id,
+                         openvrml::vrml_media_type,
+                         "file:///bench-stream-write.wrl");
+            const unsigned char * const data =
+                reinterpret_cast<const unsigned char *>(vrml.data());
+            for (size_t i = 0; i < vrml.size(); i += write_size) {
+                const size_t n = (vrml.size() - i < write_size)
+                               ? vrml.size() - i
+                               : write_size;
+                b.write(stream_id, data + i, n);
+            }
+            b.destroy_stream(stream_id);
+            //
+            // The browser destructor waits for the initial stream to be
+            // read.
+            //
+        }
+        return openvrml::browser::current_time() - start;
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    try {
+        using boost::lexical_cast;
+
+        const size_t megabytes =
+            (argc > 1) ? lexical_cast<size_t>(argv[1]) : 32;
+        const size_t iterations =
+            (argc > 2) ? lexical_cast<size_t>(argv[2]) : 3;
+
+        const std::string vrml = world(megabytes);
+        const double total_mb =
+            double(vrml.size()) * iterations / (1024.0 * 1024.0);
+
+        static const size_t write_sizes[] = { 1024, 8192, 65536, 1048576 };
+
+        cout << "bytes: " << vrml.size()
+             << "  iterations: " << iterations << '\n'
+             << setw(12) << left << "write size"
+             << setw(12) << right << "ms" << setw(12) << "MB/s" << '\n'
+             << fixed << setprecision(1);
+        for (size_t i = 0; i < sizeof write_sizes / sizeof write_sizes[0];
+             ++i) {
+            double elapsed = 0.0;
+            for (size_t j = 0; j < iterations; ++j) {
+                elapsed += stream(vrml, write_sizes[i]);
+            }
+            cout << setw(12) << left << write_sizes[i]
+                 << setw(12) << right << elapsed * 1.0e3 / double(iterations)
+                 << setw(12) << total_mb / elapsed << '\n';
+        }
+        cout << flush;
+    } catch (std::exception & ex) {
+        cerr << argv[0] << ": " << ex.what() << endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,131 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+//
+// Scaling benchmark for browser::update: a world of independent islands,
+// each a TimeSensor driving a chain of PositionInterpolator/Transform pairs,
+// is updated serially and then with 1 to N update threads.
+//
+// Usage: bench-update-islands [islands [chain-length [frames [threads]]]]
+//
+
+# include <cstdlib>
+# include <iomanip>
+# include <iostream>
+# include <sstream>
+# include <boost/lexical_cast.hpp>
+# include <boost/thread.hpp>
+# include "string_resource_istream.h"
+# include "test_resource_fetcher.h"
+
+using namespace std;
+using namespace openvrml;
+
+namespace {
+
+    const char url[] = "file:///bench-update-islands.wrl";
+
+    const std::string world(const size_t islands, const size_t chain_length)
+    {
+        ostringstream vrml;
+        vrml << "#VRML V2.0 utf8\n";
+        for (size_t i = 0; i < islands; ++i) {
+            vrml << "DEF T" << i << " TimeSensor { loop TRUE cycleInterval "
+                 << 1 + i % 7 << " }\n";
+            for (size_t j = 0; j < chain_length; ++j) {
+                vrml << "DEF P" << i << '_' << j
+                     << " PositionInterpolator {"
+                     << " key [ 0 0.5 1 ]"
+                     << " keyValue [ 0 0 0, 1 " << j << " 1, 0 0 0 ] }\n"
+                     << "DEF X" << i << '_' << j << " Transform {}\n"
+                     << "ROUTE T" << i << ".fraction_changed TO P" << i << '_'
+                     << j << ".set_fraction\n"
+                     << "ROUTE P" << i << '_' << j << ".value_changed TO X"
+                     << i << '_' << j << ".set_translation\n";
+            }
+        }
+        return vrml.str();
+    }
+
+    double time_frames(browser & b, const size_t frames, double & now)
+    {
+        const double start = browser::current_time();
+        for (size_t i = 0; i < frames; ++i) {
+            now += 1.0 / 60.0;
+            b.update(now);
+        }
+        return (browser::current_time() - start) / double(frames);
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    try {
+        using boost::lexical_cast;
+
+        const size_t islands =
+            (argc > 1) ? lexical_cast<size_t>(argv[1]) : 2000;
+        const size_t chain_length =
+            (argc > 2) ? lexical_cast<size_t>(argv[2]) : 4;
+        const size_t frames =
+            (argc > 3) ? lexical_cast<size_t>(argv[3]) : 100;
+        size_t max_threads =
+            (argc > 4) ? lexical_cast<size_t>(argv[4])
+                       : boost::thread::hardware_concurrency();
+        if (max_threads == 0) { max_threads = 1; }
+
+        test_resource_fetcher fetcher;
+        browser b(fetcher, cout, cerr);
+        string_resource_istream in(url, world(islands, chain_length));
+        b.set_world(in);
+
+        double now = browser::current_time();
+
+        //
+        // Warm up, and get the serial baseline.
+        //
+        time_frames(b, frames, now);
+        const double serial = time_frames(b, frames, now);
+
+        cout << "islands: " << islands
+             << "  chain length: " << chain_length
+             << "  frames: " << frames
+             << "  cores: " << boost::thread::hardware_concurrency() << '\n'
+             << setw(8) << "threads"
+             << setw(14) << "ms/frame"
+             << setw(10) << "speedup" << '\n'
+             << setw(8) << "serial"
+             << setw(14) << fixed << setprecision(3) << serial * 1.0e3
+             << setw(10) << setprecision(2) << 1.0 << '\n';
+
+        for (size_t threads = 1; threads <= max_threads; ++threads) {
+            b.update_threads(threads);
+            time_frames(b, 1, now);
+            const double parallel = time_frames(b, frames, now);
+            cout << setw(8) << threads
+                 << setw(14) << setprecision(3) << parallel * 1.0e3
+                 << setw(10) << setprecision(2)
+                 << (parallel > 0.0 ? serial / parallel : 0.0) << '\n';
+        }
+        cout << flush;
+    } catch (std::exception & ex) {
+        cerr << argv[0] << ": " << ex.what() << endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
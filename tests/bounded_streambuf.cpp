@@ -0,0 +1,126 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# define BOOST_TEST_MAIN
+# define BOOST_TEST_MODULE bounded_streambuf
+
+# include <boost/bind.hpp>
+# include <boost/test/unit_test.hpp>
+# include <openvrml_control/bounded_buffer.h>
+# include <istream>
+# include <string>
+
+using openvrml_control::bounded_streambuf;
+
+BOOST_AUTO_TEST_CASE(empty_stream_has_no_data)
+{
+    bounded_streambuf buf;
+    BOOST_CHECK(!buf.data_available());
+}
+
+BOOST_AUTO_TEST_CASE(data_in_get_area_is_available)
+{
+    bounded_streambuf buf;
+    std::istream in(&buf);
+    const std::string data = "#VRML V2.0 utf8\n";
+    buf.write(data.data(), data.size());
+    BOOST_CHECK(buf.data_available());
+
+    //
+    // The get moves everything written into the get area, leaving the ring
+    // buffer empty; the rest has still not been read.
+    //
+    BOOST_CHECK_EQUAL(in.get(), '#');
+    BOOST_CHECK(buf.data_available());
+
+    std::string rest(data.size() - 1, '\0');
+    in.read(&rest[0], std::streamsize(rest.size()));
+    BOOST_CHECK_EQUAL(rest, data.substr(1));
+    BOOST_CHECK(!buf.data_available());
+}
+
+BOOST_AUTO_TEST_CASE(readsome_takes_buffered_data)
+{
+    bounded_streambuf buf;
+    std::istream in(&buf);
+    buf.write("abc", 3);
+    BOOST_CHECK_EQUAL(in.get(), 'a');
+    buf.write("def", 3);
+
+    char data[8];
+    std::streamsize n = 0, read = 0;
+    while ((n = in.readsome(data + read, sizeof data - read)) > 0) {
+        read += n;
+    }
+    BOOST_CHECK_EQUAL(std::string(data, read), "bcdef");
+    BOOST_CHECK(!buf.data_available());
+}
+
+BOOST_AUTO_TEST_CASE(eof_is_available)
+{
+    bounded_streambuf buf;
+    std::istream in(&buf);
+    buf.write("a", 1);
+    buf.set_eof();
+    BOOST_CHECK_EQUAL(in.get(), 'a');
+    BOOST_CHECK(buf.data_available());
+    BOOST_CHECK_EQUAL(in.get(), std::istream::traits_type::eof());
+}
+
+namespace {
+
+    void count(size_t & calls)
+    {
+        ++calls;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(write_notifies_once)
+{
+    bounded_streambuf buf;
+    std::istream in(&buf);
+    size_t calls = 0;
+    buf.notify_data_available(boost::bind(count, boost::ref(calls)));
+    BOOST_CHECK_EQUAL(calls, 0U);
+
+    buf.write("ab", 2);
+    BOOST_CHECK_EQUAL(calls, 1U);
+    buf.write("cd", 2);
+    BOOST_CHECK_EQUAL(calls, 1U);
+
+    //
+    // With data unread, the callback is called at once; also with data left
+    // in the get area.
+    //
+    buf.notify_data_available(boost::bind(count, boost::ref(calls)));
+    BOOST_CHECK_EQUAL(calls, 2U);
+    BOOST_CHECK_EQUAL(in.get(), 'a');
+    buf.notify_data_available(boost::bind(count, boost::ref(calls)));
+    BOOST_CHECK_EQUAL(calls, 3U);
+}
+
+BOOST_AUTO_TEST_CASE(eof_notifies)
+{
+    bounded_streambuf buf;
+    size_t calls = 0;
+    buf.notify_data_available(boost::bind(count, boost::ref(calls)));
+    buf.set_eof();
+    BOOST_CHECK_EQUAL(calls, 1U);
+    buf.notify_data_available(boost::bind(count, boost::ref(calls)));
+    BOOST_CHECK_EQUAL(calls, 2U);
+}
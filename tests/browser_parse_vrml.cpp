@@ -29,9 +29,15 @@ int main(int argc, char * argv[])
         cerr << argv[0] << ": missing file name argument" << endl;
         return EXIT_FAILURE;
     }
+
+    //
+    // The optional second argument is the media type; by default the file
+    // is read as VRML97.
+    //
+    const char * const type = (argc > 2) ? argv[2] : vrml_media_type;
     try {
         ifstream in;
-        in.open(argv[1]);
+        in.open(argv[1], ios_base::in | ios_base::binary);
         if (!in.is_open()) {
             cerr << argv[0] << ": could not open file \"" << argv[1]
                  << endl;
@@ -40,7 +46,7 @@ int main(int argc, char * argv[])
 
         test_resource_fetcher fetcher;
         browser b(fetcher, cout, cerr);
-        b.create_vrml_from_stream(in, vrml_media_type);
+        b.create_vrml_from_stream(in, type);
     } catch (invalid_vrml & ex) {
         cerr << ex.url << ':' << ex.line << ':' << ex.column << ": error: "
              << ex.what() << endl;
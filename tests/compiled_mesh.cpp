@@ -0,0 +1,262 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# define BOOST_TEST_MAIN
+# define BOOST_TEST_MODULE compiled_mesh
+
+# include <boost/test/unit_test.hpp>
+# include <openvrml/compiled_mesh.h>
+# include <openvrml/viewer.h>
+# include <cmath>
+
+using namespace std;
+using namespace openvrml;
+
+namespace {
+
+    bool close(const vec3f & a, const vec3f & b)
+    {
+        return (a - b).length() < 1e-5f;
+    }
+
+    //
+    // The normal of triangle i, scaled by twice its area.
+    //
+    const vec3f triangle_normal(const compiled_mesh & mesh, const size_t i)
+    {
+        const vec3f & a = mesh.coord[size_t(mesh.triangle_index[3 * i])];
+        const vec3f & b = mesh.coord[size_t(mesh.triangle_index[3 * i + 1])];
+        const vec3f & c = mesh.coord[size_t(mesh.triangle_index[3 * i + 2])];
+        return (b - a) * (c - a);
+    }
+
+    //
+    // An L-shaped hexagon in the xy plane, counterclockwise seen from +z.
+    // Its area is 3; the corner at (1, 1), next to the first, is reflex.
+    //
+    void make_l_shape(vector<vec3f> & coord, vector<int32> & coord_index)
+    {
+        static const float point[6][2] = {
+            { 2, 1 }, { 1, 1 }, { 1, 2 }, { 0, 2 }, { 0, 0 }, { 2, 0 }
+        };
+        coord.clear();
+        coord_index.clear();
+        for (size_t i = 0; i < 6; ++i) {
+            coord_index.push_back(int32(i));
+            coord.push_back(make_vec3f(point[i][0], point[i][1], 0.0f));
+        }
+        coord_index.push_back(-1);
+    }
+
+    const vector<color> no_color;
+    const vector<vec3f> no_normal;
+    const vector<vec2f> no_tex_coord;
+    const vector<int32> no_index;
+}
+
+BOOST_AUTO_TEST_CASE(box)
+{
+    compiled_mesh mesh;
+    compile_box(make_vec3f(2, 2, 2), mesh);
+
+    BOOST_CHECK(mesh.ccw);
+    BOOST_CHECK(mesh.solid);
+    BOOST_REQUIRE_EQUAL(mesh.coord.size(), 24u);
+    BOOST_REQUIRE_EQUAL(mesh.normal.size(), 24u);
+    BOOST_REQUIRE_EQUAL(mesh.tex_coord.size(), 24u);
+    BOOST_CHECK(mesh.color.empty());
+    BOOST_REQUIRE_EQUAL(mesh.triangle_index.size(), 36u);
+
+    //
+    // Each triangle faces away from the center, along its vertex normals.
+    //
+    for (size_t i = 0; i < 12; ++i) {
+        const vec3f n = triangle_normal(mesh, i).normalize();
+        const size_t v = size_t(mesh.triangle_index[3 * i]);
+        BOOST_CHECK(close(n, mesh.normal[v]));
+        BOOST_CHECK(mesh.coord[v].dot(n) > 0.0f);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(open_cylinder_is_not_solid)
+{
+    compiled_mesh mesh;
+    compile_cylinder(2.0f, 1.0f, false, true, true, mesh);
+    BOOST_CHECK(!mesh.solid);
+    BOOST_CHECK(!mesh.empty());
+
+    compile_cylinder(2.0f, 1.0f, false, false, false, mesh);
+    BOOST_CHECK(mesh.empty());
+}
+
+BOOST_AUTO_TEST_CASE(nonconvex_face_is_triangulated)
+{
+    vector<vec3f> coord;
+    vector<int32> coord_index;
+    make_l_shape(coord, coord_index);
+
+    compiled_mesh mesh;
+    compile_shell(viewer::mask_ccw,
+                  coord, coord_index,
+                  no_color, no_index,
+                  no_normal, no_index,
+                  no_tex_coord, no_index,
+                  mesh);
+
+    BOOST_REQUIRE_EQUAL(mesh.coord.size(), 6u);
+    BOOST_REQUIRE_EQUAL(mesh.triangle_index.size(), 12u);
+
+    //
+    // The triangles cover the face exactly once, with its winding; a fan
+    // from the first corner would cover some of it twice, once reversed.
+    //
+    float area = 0.0f;
+    for (size_t i = 0; i < 4; ++i) {
+        const vec3f n = triangle_normal(mesh, i);
+        BOOST_CHECK(n.z() >= 0.0f);
+        area += n.z() / 2;
+    }
+    BOOST_CHECK_CLOSE(area, 3.0f, 1e-3f);
+
+    for (size_t i = 0; i < mesh.normal.size(); ++i) {
+        BOOST_CHECK(close(mesh.normal[i], make_vec3f(0, 0, 1)));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(clockwise_faces_flip_normals)
+{
+    vector<vec3f> coord;
+    vector<int32> coord_index;
+    make_l_shape(coord, coord_index);
+
+    compiled_mesh mesh;
+    compile_shell(viewer::mask_none,
+                  coord, coord_index,
+                  no_color, no_index,
+                  no_normal, no_index,
+                  no_tex_coord, no_index,
+                  mesh);
+
+    BOOST_CHECK(!mesh.ccw);
+    BOOST_REQUIRE(!mesh.normal.empty());
+    BOOST_CHECK(close(mesh.normal[0], make_vec3f(0, 0, -1)));
+}
+
+BOOST_AUTO_TEST_CASE(per_face_colors)
+{
+    static const int32 index[] = { 0, 1, 2, -1, 0, 2, 3, -1 };
+    vector<vec3f> coord;
+    coord.push_back(make_vec3f(0, 0, 0));
+    coord.push_back(make_vec3f(1, 0, 0));
+    coord.push_back(make_vec3f(1, 1, 0));
+    coord.push_back(make_vec3f(0, 1, 0));
+    vector<color> face_color;
+    face_color.push_back(make_color(1, 0, 0));
+    face_color.push_back(make_color(0, 0, 1));
+
+    compiled_mesh mesh;
+    compile_shell(viewer::mask_ccw | viewer::mask_convex,
+                  coord,
+                  vector<int32>(index, index + sizeof index / sizeof *index),
+                  face_color, no_index,
+                  no_normal, no_index,
+                  no_tex_coord, no_index,
+                  mesh);
+
+    //
+    // The corners the faces share get a vertex for each face.
+    //
+    BOOST_REQUIRE_EQUAL(mesh.coord.size(), 6u);
+    BOOST_REQUIRE_EQUAL(mesh.color.size(), 6u);
+    for (size_t i = 0; i < 3; ++i) {
+        BOOST_CHECK_EQUAL(mesh.color[i], face_color[0]);
+        BOOST_CHECK_EQUAL(mesh.color[i + 3], face_color[1]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(invalid_faces_are_skipped)
+{
+    static const int32 index[] = { 0, 1, 7, -1, 0, 1, -1, 0, 1, 2 };
+    vector<vec3f> coord;
+    coord.push_back(make_vec3f(0, 0, 0));
+    coord.push_back(make_vec3f(1, 0, 0));
+    coord.push_back(make_vec3f(1, 1, 0));
+
+    compiled_mesh mesh;
+    compile_shell(viewer::mask_ccw,
+                  coord,
+                  vector<int32>(index, index + sizeof index / sizeof *index),
+                  no_color, no_index,
+                  no_normal, no_index,
+                  no_tex_coord, no_index,
+                  mesh);
+
+    BOOST_CHECK_EQUAL(mesh.coord.size(), 3u);
+    BOOST_CHECK_EQUAL(mesh.triangle_index.size(), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(flat_elevation_grid)
+{
+    const vector<float> height(9, 0.0f);
+
+    compiled_mesh mesh;
+    compile_elevation_grid(viewer::mask_ccw | viewer::mask_normal_per_vertex,
+                           height, 3, 3, 1.0f, 1.0f,
+                           no_color, no_normal, no_tex_coord,
+                           mesh);
+
+    BOOST_REQUIRE_EQUAL(mesh.triangle_index.size(), 24u);
+    for (size_t i = 0; i < 8; ++i) {
+        BOOST_CHECK(triangle_normal(mesh, i).y() > 0.0f);
+    }
+    for (size_t i = 0; i < mesh.normal.size(); ++i) {
+        BOOST_CHECK(close(mesh.normal[i], make_vec3f(0, 1, 0)));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(extrusion_caps)
+{
+    vector<vec3f> spine;
+    spine.push_back(make_vec3f(0, 0, 0));
+    spine.push_back(make_vec3f(0, 1, 0));
+    vector<vec2f> cross_section;
+    cross_section.push_back(make_vec2f(1, 1));
+    cross_section.push_back(make_vec2f(1, -1));
+    cross_section.push_back(make_vec2f(-1, -1));
+    cross_section.push_back(make_vec2f(-1, 1));
+    cross_section.push_back(make_vec2f(1, 1));
+    const vector<rotation> orientation(1, make_rotation());
+    const vector<vec2f> scale(1, make_vec2f(1, 1));
+
+    compiled_mesh mesh;
+    compile_extrusion(viewer::mask_ccw | viewer::mask_convex
+                      | viewer::mask_solid
+                      | viewer::mask_bottom | viewer::mask_top,
+                      spine, cross_section, orientation, scale,
+                      mesh);
+
+    //
+    // Four sides and two caps, two triangles each.
+    //
+    BOOST_CHECK_EQUAL(mesh.triangle_index.size(), 36u);
+
+    compile_extrusion(viewer::mask_ccw | viewer::mask_convex,
+                      spine, cross_section, orientation, scale,
+                      mesh);
+    BOOST_CHECK_EQUAL(mesh.triangle_index.size(), 24u);
+}
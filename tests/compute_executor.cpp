@@ -0,0 +1,210 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# define BOOST_TEST_MAIN
+# define BOOST_TEST_MODULE compute_executor
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+# include <algorithm>
+# include <vector>
+# include <boost/bind.hpp>
+# include <boost/scoped_ptr.hpp>
+# include <boost/test/unit_test.hpp>
+# include <openvrml/local/compute_executor.h>
+
+using openvrml::local::compute_executor;
+
+namespace {
+
+    const boost::posix_time::seconds timeout(10);
+
+    //
+    // Holds up the jobs that pass through it until it is opened.
+    //
+    class gate {
+        boost::mutex mutex_;
+        boost::condition_variable changed_;
+        size_t waiting_;
+        size_t passed_;
+        bool open_;
+
+    public:
+        gate():
+            waiting_(0),
+            passed_(0),
+            open_(false)
+        {}
+
+        void pass()
+        {
+            boost::mutex::scoped_lock lock(this->mutex_);
+            ++this->waiting_;
+            this->changed_.notify_all();
+            while (!this->open_) { this->changed_.wait(lock); }
+            --this->waiting_;
+            ++this->passed_;
+            this->changed_.notify_all();
+        }
+
+        bool wait_for(const size_t waiting)
+        {
+            const boost::system_time deadline =
+                boost::get_system_time() + timeout;
+            boost::mutex::scoped_lock lock(this->mutex_);
+            while (this->waiting_ < waiting) {
+                if (!this->changed_.timed_wait(lock, deadline)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void open()
+        {
+            boost::mutex::scoped_lock lock(this->mutex_);
+            this->open_ = true;
+            this->changed_.notify_all();
+        }
+
+        size_t passed()
+        {
+            boost::mutex::scoped_lock lock(this->mutex_);
+            return this->passed_;
+        }
+    };
+
+    //
+    // Counts the calls for each item; the batches do not overlap, so each
+    // count is written by one thread.
+    //
+    struct counter {
+        std::vector<int> calls;
+
+        explicit counter(const size_t items):
+            calls(items)
+        {}
+
+        void operator()(const size_t begin, const size_t end)
+        {
+            for (size_t i = begin; i < end; ++i) { ++this->calls[i]; }
+        }
+    };
+
+    void record_current(compute_executor * & current)
+    {
+        current = compute_executor::current();
+    }
+
+    void reset(boost::scoped_ptr<compute_executor> & executor)
+    {
+        executor.reset();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(executor_without_threads_queues_nothing)
+{
+    gate g;
+    compute_executor executor(0);
+    BOOST_CHECK_EQUAL(executor.threads(), 0U);
+    BOOST_CHECK_EQUAL(executor.post(boost::bind(&gate::pass, &g), 2), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(post_queues_a_copy_for_each_worker_at_most)
+{
+    gate g;
+    compute_executor executor(2);
+    BOOST_CHECK_EQUAL(executor.post(boost::bind(&gate::pass, &g), 5), 2U);
+    BOOST_REQUIRE(g.wait_for(2));
+    g.open();
+}
+
+BOOST_AUTO_TEST_CASE(current_is_the_innermost_scope)
+{
+    compute_executor outer(1), inner(1);
+    BOOST_CHECK(!compute_executor::current());
+    {
+        const compute_executor::scope outer_scope(outer);
+        BOOST_CHECK_EQUAL(compute_executor::current(), &outer);
+        {
+            const compute_executor::scope inner_scope(inner);
+            BOOST_CHECK_EQUAL(compute_executor::current(), &inner);
+        }
+        BOOST_CHECK_EQUAL(compute_executor::current(), &outer);
+
+        //
+        // The scope is the calling thread's; a worker has none.
+        //
+        compute_executor * worker_current = &outer;
+        gate g;
+        BOOST_REQUIRE_EQUAL(
+            outer.post(boost::bind(record_current,
+                                   boost::ref(worker_current)),
+                       1),
+            1U);
+        BOOST_REQUIRE_EQUAL(outer.post(boost::bind(&gate::pass, &g), 1),
+                            1U);
+        BOOST_REQUIRE(g.wait_for(1));
+        g.open();
+        BOOST_CHECK(!worker_current);
+    }
+    BOOST_CHECK(!compute_executor::current());
+}
+
+BOOST_AUTO_TEST_CASE(for_each_batch_calls_for_every_item_once)
+{
+    compute_executor executor(3);
+    counter c(1000);
+    for_each_batch(executor, c.calls.size(), 7, 3, c);
+    BOOST_CHECK_EQUAL(std::count(c.calls.begin(), c.calls.end(), 1),
+                      1000);
+}
+
+BOOST_AUTO_TEST_CASE(for_each_batch_with_busy_workers)
+{
+    //
+    // The calling thread does all of the work when the workers are busy
+    // with something else.
+    //
+    gate g;
+    compute_executor executor(1);
+    BOOST_REQUIRE_EQUAL(executor.post(boost::bind(&gate::pass, &g), 1), 1U);
+    BOOST_REQUIRE(g.wait_for(1));
+
+    counter c(100);
+    for_each_batch(executor, c.calls.size(), 1, 1, c);
+    BOOST_CHECK_EQUAL(std::count(c.calls.begin(), c.calls.end(), 1), 100);
+    g.open();
+}
+
+BOOST_AUTO_TEST_CASE(destructor_waits_for_running_jobs)
+{
+    gate g;
+    boost::scoped_ptr<compute_executor> executor(new compute_executor(1));
+    BOOST_REQUIRE_EQUAL(executor->post(boost::bind(&gate::pass, &g), 1),
+                        1U);
+    BOOST_REQUIRE(g.wait_for(1));
+
+    boost::thread destroy(boost::bind(reset, boost::ref(executor)));
+    BOOST_CHECK(!destroy.timed_join(boost::posix_time::milliseconds(50)));
+    g.open();
+    destroy.join();
+    BOOST_CHECK_EQUAL(g.passed(), 1U);
+}
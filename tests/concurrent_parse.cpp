@@ -0,0 +1,225 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+//
+// Streams larger than 256 KiB are parsed on several threads when
+// browser::parse_threads is set.  The result must be the same as that of a
+// serial parse: the same nodes, the same DEF/USE sharing, and the same
+// warnings in the same order.
+//
+
+# define BOOST_TEST_MAIN
+# define BOOST_TEST_MODULE concurrent_parse
+
+# include <sstream>
+# include <boost/test/unit_test.hpp>
+# include <openvrml/browser.h>
+# include <openvrml/node.h>
+# include "test_resource_fetcher.h"
+
+using namespace std;
+using namespace openvrml;
+
+namespace {
+
+    const size_t min_size = 512 * 1024;
+
+    //
+    // Top-level Shapes that refer to no node names, with a DEF, a USE of it
+    // and a ROUTE every so often.  Every 64th Transform has a rotation axis
+    // that is not normalized, which draws a warning.
+    //
+    const string world(const bool proto)
+    {
+        ostringstream vrml;
+        vrml << "#VRML V2.0 utf8\n";
+        if (proto) {
+            vrml << "PROTO Box2 [ field SFVec3f size 2 2 2 ] {\n"
+                 << "  Box { size IS size }\n"
+                 << "}\n";
+        }
+        for (size_t i = 0; size_t(vrml.tellp()) < min_size; ++i) {
+            if (i % 100 == 50) {
+                vrml << "DEF T" << i << " Transform {\n"
+                     << "  children Shape { geometry Sphere {} }\n"
+                     << "}\n"
+                     << "DEF S" << i << " TimeSensor {}\n"
+                     << "DEF I" << i << " PositionInterpolator {\n"
+                     << "  key [ 0 1 ] keyValue [ 0 0 0, 1 1 1 ]\n"
+                     << "}\n"
+                     << "ROUTE S" << i << ".fraction_changed TO I" << i
+                     << ".set_fraction\n"
+                     << "ROUTE I" << i << ".value_changed TO T" << i
+                     << ".set_translation\n"
+                     << "Group { children USE T" << i << " }\n";
+                continue;
+            }
+            vrml << "Transform {\n"
+                 << "  translation " << i << " 0 0\n";
+            if (i % 64 == 0) { vrml << "  rotation 0 0 2 " << i << '\n'; }
+            vrml << "  children Shape {\n"
+                 << "    appearance Appearance {\n"
+                 << "      material Material { diffuseColor 1 0 0 }\n"
+                 << "    }\n";
+            if (proto && i % 10 == 0) {
+                vrml << "    geometry Box2 { size " << i << " 1 1 }\n";
+            } else {
+                vrml << "    geometry IndexedFaceSet {\n"
+                     << "      coord Coordinate {\n"
+                     << "        point [ 0 0 0, " << i << " 0 0, 0 "
+                     << i << " 0, 0 0 " << i << " ]\n"
+                     << "      }\n"
+                     << "      coordIndex [ 0 1 2 -1, 0 2 3 -1 ]\n"
+                     << "    }\n";
+            }
+            vrml << "  }\n"
+                 << "}\n";
+        }
+        return vrml.str();
+    }
+
+    //
+    // Each stream gets a URI of its own; drop it from the warnings so that
+    // those of different parses can be compared.
+    //
+    const string strip_uri(const string & warnings)
+    {
+        static const string uri = "urn:X-openvrml:stream:";
+        string result;
+        istringstream in(warnings);
+        string line;
+        while (getline(in, line)) {
+            if (line.compare(0, uri.size(), uri) == 0) {
+                line.erase(0, line.find(':', uri.size()) + 1);
+            }
+            result += line + '\n';
+        }
+        return result;
+    }
+
+    struct parse_result {
+        vector<boost::intrusive_ptr<node> > nodes;
+        string printed;
+        string warnings;
+    };
+
+    //
+    // The nodes are only good as long as b.
+    //
+    const parse_result parse(browser & b,
+                             const ostringstream & err,
+                             const string & vrml,
+                             const size_t threads)
+    {
+        b.parse_threads(threads);
+        istringstream in(vrml);
+        parse_result result;
+        result.nodes = b.create_vrml_from_stream(in);
+        ostringstream printed;
+        for (vector<boost::intrusive_ptr<node> >::const_iterator n =
+                 result.nodes.begin();
+             n != result.nodes.end();
+             ++n) {
+            printed << **n << '\n';
+        }
+        result.printed = printed.str();
+        result.warnings = strip_uri(err.str());
+        return result;
+    }
+
+    //
+    // The node USEd by the Group that follows each DEF is the DEFed node.
+    //
+    void check_use(const vector<boost::intrusive_ptr<node> > & nodes)
+    {
+        size_t uses = 0;
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            if (nodes[i]->id().empty() || nodes[i]->id()[0] != 'T') {
+                continue;
+            }
+            BOOST_REQUIRE(i + 3 < nodes.size());
+            grouping_node * const group =
+                node_cast<grouping_node *>(nodes[i + 3].get());
+            BOOST_REQUIRE(group);
+            BOOST_REQUIRE_EQUAL(group->children().size(), 1U);
+            BOOST_CHECK(group->children()[0] == nodes[i]);
+            ++uses;
+        }
+        BOOST_CHECK(uses > 0);
+    }
+
+    void check_equivalent(const bool proto)
+    {
+        const string vrml = world(proto);
+        BOOST_REQUIRE(vrml.size() > 256 * 1024);
+
+        test_resource_fetcher fetcher;
+        ostringstream out, serial_err, concurrent_err;
+        browser serial_b(fetcher, out, serial_err),
+            concurrent_b(fetcher, out, concurrent_err);
+        const parse_result serial = parse(serial_b, serial_err, vrml, 0);
+        const parse_result concurrent =
+            parse(concurrent_b, concurrent_err, vrml, 4);
+
+        BOOST_REQUIRE_EQUAL(concurrent.nodes.size(), serial.nodes.size());
+        BOOST_CHECK(concurrent.printed == serial.printed);
+        BOOST_CHECK(!serial.warnings.empty());
+        BOOST_CHECK_EQUAL(concurrent.warnings, serial.warnings);
+        check_use(serial.nodes);
+        check_use(concurrent.nodes);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_parse_matches_serial_parse)
+{
+    check_equivalent(false);
+}
+
+BOOST_AUTO_TEST_CASE(parse_with_proto_matches_serial_parse)
+{
+    //
+    // A stream that declares a PROTO is parsed serially; the result is the
+    // same either way.
+    //
+    check_equivalent(true);
+}
+
+BOOST_AUTO_TEST_CASE(invalid_stream_is_reported_once)
+{
+    //
+    // A batch that fails to parse makes the whole stream be parsed again
+    // serially.  The warnings from the batches that did parse are not
+    // written twice.
+    //
+    string vrml = world(false);
+    vrml += "Transform { rotation 0 0 2 0 children Bogus {} }\n";
+
+    test_resource_fetcher fetcher;
+    ostringstream out, err;
+    browser b(fetcher, out, err);
+    b.parse_threads(4);
+    istringstream in(vrml);
+    BOOST_CHECK_THROW(b.create_vrml_from_stream(in), invalid_vrml);
+
+    ostringstream serial_err;
+    browser serial_b(fetcher, out, serial_err);
+    istringstream serial_in(vrml);
+    BOOST_CHECK_THROW(serial_b.create_vrml_from_stream(serial_in),
+                      invalid_vrml);
+    BOOST_CHECK_EQUAL(strip_uri(err.str()), strip_uri(serial_err.str()));
+}
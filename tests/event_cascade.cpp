@@ -0,0 +1,267 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+//
+// While an event_cascade is current, emitted events are queued and
+// delivered breadth-first when it is drained.  The cascades here are driven
+// directly, with the fraction_changed eventOuts of TimeSensors as emitters.
+//
+
+# define BOOST_TEST_MAIN
+# define BOOST_TEST_MODULE event_cascade
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+# include <sstream>
+# include <boost/bind.hpp>
+# include <boost/function.hpp>
+# include <boost/lexical_cast.hpp>
+# include <boost/ptr_container/ptr_vector.hpp>
+# include <boost/test/unit_test.hpp>
+# include <openvrml/browser.h>
+# include <openvrml/local/event_cascade.h>
+# include "test_resource_fetcher.h"
+
+using namespace std;
+using namespace openvrml;
+using openvrml::local::event_cascade;
+
+namespace {
+
+    //
+    // Records "<id> <timestamp>" for each event it receives, then runs its
+    // response, if any.
+    //
+    class recorder : public field_value_listener<sffloat> {
+        vector<string> & log_;
+        const string id_;
+
+    public:
+        boost::function0<void> response;
+
+        recorder(vector<string> & log, const string & id):
+            log_(log),
+            id_(id)
+        {}
+
+        virtual ~recorder() OPENVRML_NOTHROW
+        {}
+
+    private:
+        virtual void do_process_event(const sffloat &, const double timestamp)
+            OPENVRML_THROW1(std::bad_alloc)
+        {
+            this->log_.push_back(
+                this->id_ + ' ' + boost::lexical_cast<string>(timestamp));
+            if (this->response) { this->response(); }
+        }
+    };
+
+    //
+    // An emitter that belongs to no node.
+    //
+    class free_emitter : public sffloat_emitter {
+    public:
+        explicit free_emitter(const sffloat & value):
+            event_emitter(value),
+            sffloat_emitter(value)
+        {}
+
+        virtual ~free_emitter() OPENVRML_NOTHROW
+        {}
+
+    private:
+        virtual const std::string do_eventout_id() const OPENVRML_NOTHROW
+        {
+            return "value_changed";
+        }
+    };
+
+    //
+    // TimeSensors A, B, C and D, each with a recorder on fraction_changed.
+    //
+    struct sensors {
+        test_resource_fetcher fetcher;
+        browser b;
+        vector<boost::intrusive_ptr<node> > nodes;
+        vector<string> log;
+        boost::ptr_vector<recorder> recorders;
+
+        sensors():
+            b(fetcher, std::cout, std::cerr)
+        {
+            istringstream in("#VRML V2.0 utf8\n"
+                             "DEF A TimeSensor {}\n"
+                             "DEF B TimeSensor {}\n"
+                             "DEF C TimeSensor {}\n"
+                             "DEF D TimeSensor {}\n");
+            this->nodes = this->b.create_vrml_from_stream(in);
+            BOOST_REQUIRE_EQUAL(this->nodes.size(), 4U);
+            for (size_t i = 0; i < this->nodes.size(); ++i) {
+                this->recorders.push_back(
+                    new recorder(this->log, this->nodes[i]->id()));
+                this->emitter(i).add(this->recorders.back());
+            }
+        }
+
+        field_value_emitter<sffloat> & emitter(const size_t i)
+        {
+            return this->nodes[i]->event_emitter<sffloat>("fraction_changed");
+        }
+    };
+
+    void push(event_cascade & cascade,
+              event_emitter & emitter,
+              const double timestamp)
+    {
+        cascade.push(emitter, timestamp);
+    }
+
+    void release(boost::intrusive_ptr<node> & n, node * const raw,
+                 size_t & use_count)
+    {
+        n.reset();
+        use_count = raw->use_count();
+    }
+
+    const vector<string> log_of(const char * const entries[],
+                                const size_t size)
+    {
+        return vector<string>(entries, entries + size);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(events_are_delivered_breadth_first)
+{
+    //
+    // A and B are queued; A's listener emits C, and B's emits D.  Depth
+    // first, C would come before B.
+    //
+    sensors s;
+    event_cascade cascade;
+    s.recorders[0].response =
+        boost::bind(push, boost::ref(cascade), boost::ref(s.emitter(2)), 1.0);
+    s.recorders[1].response =
+        boost::bind(push, boost::ref(cascade), boost::ref(s.emitter(3)), 1.0);
+    cascade.push(s.emitter(0), 1.0);
+    cascade.push(s.emitter(1), 1.0);
+    cascade.drain();
+
+    static const char * const expected[] = { "A 1", "B 1", "C 1", "D 1" };
+    BOOST_CHECK(s.log == log_of(expected, 4));
+    BOOST_CHECK(cascade.empty());
+}
+
+BOOST_AUTO_TEST_CASE(events_with_the_same_timestamp_are_coalesced)
+{
+    sensors s;
+    event_cascade cascade;
+    cascade.push(s.emitter(0), 1.0);
+    cascade.push(s.emitter(1), 1.0);
+    cascade.push(s.emitter(0), 1.0);
+    cascade.drain();
+
+    static const char * const expected[] = { "A 1", "B 1" };
+    BOOST_CHECK(s.log == log_of(expected, 2));
+}
+
+BOOST_AUTO_TEST_CASE(an_event_queued_again_later_is_delivered_in_its_place)
+{
+    //
+    // The emitter's event moves to the back of the queue with the new
+    // timestamp, and is delivered once.
+    //
+    sensors s;
+    event_cascade cascade;
+    cascade.push(s.emitter(0), 1.0);
+    cascade.push(s.emitter(1), 1.0);
+    cascade.push(s.emitter(0), 2.0);
+    cascade.drain();
+
+    static const char * const expected[] = { "B 1", "A 2" };
+    BOOST_CHECK(s.log == log_of(expected, 2));
+}
+
+BOOST_AUTO_TEST_CASE(pending_event_keeps_its_node_alive)
+{
+    //
+    // A's listener lets go of B, as a Script replacing the world or an
+    // Inline unloading its scene would, while B's event is still queued.
+    // The queue keeps B alive until its event has been delivered.
+    //
+    sensors s;
+    node * const b = s.nodes[1].get();
+    const size_t owners = b->use_count();
+
+    event_cascade cascade;
+    cascade.push(s.emitter(0), 1.0);
+    cascade.push(s.emitter(1), 1.0);
+    BOOST_CHECK_EQUAL(b->use_count(), owners + 1);
+
+    size_t use_count_after_release = 0;
+    s.recorders[0].response = boost::bind(release,
+                                          boost::ref(s.nodes[1]),
+                                          b,
+                                          boost::ref(use_count_after_release));
+    cascade.drain();
+
+    BOOST_CHECK_EQUAL(use_count_after_release, owners);
+    static const char * const expected[] = { "A 1", "B 1" };
+    BOOST_CHECK(s.log == log_of(expected, 2));
+}
+
+BOOST_AUTO_TEST_CASE(queue_lets_go_of_nodes_it_did_not_deliver)
+{
+    sensors s;
+    node * const a = s.nodes[0].get();
+    const size_t owners = a->use_count();
+    {
+        event_cascade cascade;
+        cascade.push(s.emitter(0), 1.0);
+        BOOST_CHECK_EQUAL(a->use_count(), owners + 1);
+    }
+    BOOST_CHECK_EQUAL(a->use_count(), owners);
+    BOOST_CHECK(s.log.empty());
+}
+
+BOOST_AUTO_TEST_CASE(cancelled_events_are_not_delivered)
+{
+    //
+    // An emitter that belongs to no node cancels its events when it is
+    // destroyed.
+    //
+    sensors s;
+    vector<string> log;
+    recorder r(log, "F");
+    const sffloat value;
+    {
+        free_emitter f(value);
+        f.add(r);
+
+        event_cascade cascade;
+        cascade.push(f, 1.0);
+        cascade.push(s.emitter(0), 1.0);
+        cascade.cancel(f);
+        cascade.drain();
+    }
+    BOOST_CHECK(log.empty());
+    static const char * const expected[] = { "A 1" };
+    BOOST_CHECK(s.log == log_of(expected, 1));
+}
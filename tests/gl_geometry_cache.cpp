@@ -0,0 +1,271 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+//
+// geometry_cache is tested against a stand-in for OpenGL that reports
+// version 1.1 without GL_ARB_vertex_buffer_object, so the cache must fall
+// back to vertex arrays in client memory.  The stand-in records the
+// triangles glDrawElements would draw.
+//
+
+# define BOOST_TEST_MAIN
+# define BOOST_TEST_MODULE gl_geometry_cache
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+# include <boost/test/unit_test.hpp>
+# include <openvrml/gl/local/geometry_cache.h>
+# include <sstream>
+# include <vector>
+# include "test_resource_fetcher.h"
+# if defined(HAVE_GL_GLX_H) && !defined(_WIN32)
+#   include <GL/glx.h>
+# endif
+
+using namespace std;
+using namespace openvrml;
+using openvrml::gl::local::geometry_cache;
+using openvrml::gl::local::vertex_array_builder;
+
+namespace {
+
+    struct fake_gl {
+        size_t proc_lookups;
+        const GLubyte * vertex_pointer;
+        GLsizei vertex_stride;
+        std::vector<std::vector<vec3f> > draws;
+
+        fake_gl():
+            proc_lookups(0),
+            vertex_pointer(0),
+            vertex_stride(0)
+        {}
+    } gl_state;
+
+    const std::vector<vec3f> & last_draw()
+    {
+        BOOST_REQUIRE(!gl_state.draws.empty());
+        return gl_state.draws.back();
+    }
+
+    //
+    // Box nodes, used only for their addresses.
+    //
+    class geometry_nodes {
+        test_resource_fetcher fetcher_;
+        openvrml::browser browser_;
+        std::vector<boost::intrusive_ptr<node> > nodes_;
+
+    public:
+        geometry_nodes():
+            browser_(this->fetcher_, std::cout, std::cerr)
+        {
+            std::istringstream in("Box {} Box {}");
+            this->nodes_ = this->browser_.create_vrml_from_stream(in);
+            BOOST_REQUIRE_EQUAL(this->nodes_.size(), 2U);
+        }
+
+        const node & operator[](const size_t i) const
+        {
+            return *this->nodes_[i];
+        }
+    };
+
+    void quad(vertex_array_builder & builder, const GLfloat z)
+    {
+        builder.begin(GL_QUADS);
+        builder.vertex(0.0f, 0.0f, z);
+        builder.vertex(1.0f, 0.0f, z);
+        builder.vertex(1.0f, 1.0f, z);
+        builder.vertex(0.0f, 1.0f, z);
+        builder.end();
+    }
+}
+
+extern "C" {
+
+    //
+    // Entry points used by geometry_cache.  None of the buffer object entry
+    // points are defined; they must not be looked up.
+    //
+
+    const GLubyte * APIENTRY glGetString(const GLenum name)
+    {
+        static const GLubyte version[] = "1.1 fallback test";
+        static const GLubyte extensions[] = "GL_EXT_vertex_array";
+        static const GLubyte none[] = "";
+        switch (name) {
+        case GL_VERSION: return version;
+        case GL_EXTENSIONS: return extensions;
+        default: return none;
+        }
+    }
+
+# if defined(HAVE_GL_GLX_H) && !defined(_WIN32)
+    __GLXextFuncPtr glXGetProcAddressARB(const GLubyte *)
+    {
+        ++gl_state.proc_lookups;
+        return 0;
+    }
+# endif
+
+    void APIENTRY glFrontFace(GLenum)
+    {}
+
+    void APIENTRY glShadeModel(GLenum)
+    {}
+
+    void APIENTRY glDisable(GLenum)
+    {}
+
+    void APIENTRY glPushClientAttrib(GLbitfield)
+    {}
+
+    void APIENTRY glPopClientAttrib()
+    {}
+
+    void APIENTRY glEnableClientState(GLenum)
+    {}
+
+    void APIENTRY glVertexPointer(const GLint size,
+                                  const GLenum type,
+                                  const GLsizei stride,
+                                  const GLvoid * const pointer)
+    {
+        BOOST_REQUIRE_EQUAL(size, 3);
+        BOOST_REQUIRE_EQUAL(type, GLenum(GL_FLOAT));
+        gl_state.vertex_pointer = static_cast<const GLubyte *>(pointer);
+        gl_state.vertex_stride = stride;
+    }
+
+    void APIENTRY glColorPointer(GLint, GLenum, GLsizei, const GLvoid *)
+    {}
+
+    void APIENTRY glNormalPointer(GLenum, GLsizei, const GLvoid *)
+    {}
+
+    void APIENTRY glTexCoordPointer(GLint, GLenum, GLsizei, const GLvoid *)
+    {}
+
+    //
+    // Without buffer objects, both pointers must address client memory.
+    //
+    void APIENTRY glDrawElements(const GLenum mode,
+                                 const GLsizei count,
+                                 const GLenum type,
+                                 const GLvoid * const indices)
+    {
+        BOOST_REQUIRE_EQUAL(mode, GLenum(GL_TRIANGLES));
+        BOOST_REQUIRE_EQUAL(type, GLenum(GL_UNSIGNED_INT));
+        BOOST_REQUIRE(gl_state.vertex_pointer);
+        BOOST_REQUIRE(indices);
+        std::vector<vec3f> triangles;
+        for (GLsizei i = 0; i < count; ++i) {
+            const GLuint index = static_cast<const GLuint *>(indices)[i];
+            const GLfloat * const coord =
+                reinterpret_cast<const GLfloat *>(
+                    gl_state.vertex_pointer
+                    + index * gl_state.vertex_stride);
+            triangles.push_back(make_vec3f(coord[0], coord[1], coord[2]));
+        }
+        gl_state.draws.push_back(triangles);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(draws_from_client_memory)
+{
+    const geometry_nodes nodes;
+    geometry_cache cache;
+
+    vertex_array_builder builder;
+    quad(builder, 0.0f);
+    cache.insert(nodes[0], builder);
+    BOOST_REQUIRE(cache.cached(nodes[0]));
+
+    cache.draw(nodes[0]);
+    BOOST_CHECK_EQUAL(gl_state.proc_lookups, 0U);
+    const std::vector<vec3f> & drawn = last_draw();
+    BOOST_REQUIRE_EQUAL(drawn.size(), 6U);
+    BOOST_CHECK_EQUAL(drawn[0], make_vec3f(0.0f, 0.0f, 0.0f));
+    BOOST_CHECK_EQUAL(drawn[1], make_vec3f(1.0f, 0.0f, 0.0f));
+    BOOST_CHECK_EQUAL(drawn[2], make_vec3f(0.0f, 1.0f, 0.0f));
+    BOOST_CHECK_EQUAL(drawn[3], make_vec3f(1.0f, 0.0f, 0.0f));
+    BOOST_CHECK_EQUAL(drawn[4], make_vec3f(1.0f, 1.0f, 0.0f));
+    BOOST_CHECK_EQUAL(drawn[5], make_vec3f(0.0f, 1.0f, 0.0f));
+
+    cache.clear();
+}
+
+BOOST_AUTO_TEST_CASE(updates_in_client_memory)
+{
+    const geometry_nodes nodes;
+    geometry_cache cache;
+
+    {
+        vertex_array_builder builder;
+        quad(builder, 0.0f);
+        cache.insert(nodes[0], builder);
+    }
+    {
+        vertex_array_builder builder;
+        quad(builder, 5.0f);
+        cache.insert(nodes[1], builder);
+    }
+
+    //
+    // Moving the vertices of the first node rewrites them in place; the
+    // second node is unaffected.
+    //
+    cache.remove(nodes[0]);
+    BOOST_CHECK(!cache.cached(nodes[0]));
+    {
+        vertex_array_builder builder;
+        quad(builder, 2.0f);
+        cache.insert(nodes[0], builder);
+    }
+    cache.release_stale();
+    BOOST_REQUIRE(cache.cached(nodes[0]));
+    BOOST_REQUIRE(cache.cached(nodes[1]));
+
+    cache.draw(nodes[0]);
+    BOOST_REQUIRE_EQUAL(last_draw().size(), 6U);
+    for (size_t i = 0; i < last_draw().size(); ++i) {
+        BOOST_CHECK_EQUAL(last_draw()[i].z(), 2.0f);
+    }
+
+    cache.draw(nodes[1]);
+    BOOST_REQUIRE_EQUAL(last_draw().size(), 6U);
+    for (size_t i = 0; i < last_draw().size(); ++i) {
+        BOOST_CHECK_EQUAL(last_draw()[i].z(), 5.0f);
+    }
+
+    //
+    // A node removed and not inserted again is dropped at the end of the
+    // frame.
+    //
+    cache.remove(nodes[1]);
+    cache.release_stale();
+    BOOST_CHECK(!cache.cached(nodes[1]));
+    BOOST_CHECK(cache.cached(nodes[0]));
+
+    cache.clear();
+    BOOST_CHECK(!cache.cached(nodes[0]));
+    BOOST_CHECK_EQUAL(gl_state.proc_lookups, 0U);
+}
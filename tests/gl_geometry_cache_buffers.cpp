@@ -0,0 +1,490 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+//
+// geometry_cache is tested against a stand-in for OpenGL that reports
+// version 1.5, so the cache must keep geometry in buffer objects.  The
+// buffer object entry points are handed out by glXGetProcAddressARB; they
+// record each call and keep the contents of each buffer, and glDrawElements
+// reads the triangles it would draw from the bound buffers.
+//
+// Whether buffer objects are supported is decided once per process, which
+// is why this is not part of the gl_geometry_cache test.
+//
+
+# define BOOST_TEST_MAIN
+# define BOOST_TEST_MODULE gl_geometry_cache_buffers
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+# include <boost/test/unit_test.hpp>
+# include <openvrml/gl/local/geometry_cache.h>
+# include <cstring>
+# include <map>
+# include <sstream>
+# include <vector>
+# include "test_resource_fetcher.h"
+# if defined(HAVE_GL_GLX_H) && !defined(_WIN32)
+#   include <GL/glx.h>
+# endif
+
+using namespace std;
+using namespace openvrml;
+using openvrml::gl::local::geometry_cache;
+using openvrml::gl::local::vertex_array_builder;
+
+# ifndef GL_ARRAY_BUFFER
+#   define GL_ARRAY_BUFFER 0x8892
+# endif
+# ifndef GL_ELEMENT_ARRAY_BUFFER
+#   define GL_ELEMENT_ARRAY_BUFFER 0x8893
+# endif
+
+# if defined(HAVE_GL_GLX_H) && !defined(_WIN32)
+namespace {
+
+    struct sub_data_call {
+        GLenum target;
+        GLuint buffer;
+        size_t offset;
+        size_t size;
+    };
+
+    struct fake_gl {
+        size_t proc_lookups;
+        GLuint next_name;
+        map<GLuint, vector<unsigned char> > buffers;
+        map<GLenum, GLuint> bound;
+        vector<GLuint> generated;
+        vector<GLuint> deleted;
+        size_t buffer_data_calls;
+        vector<sub_data_call> sub_data_calls;
+        GLuint vertex_buffer;
+        size_t vertex_offset;
+        GLsizei vertex_stride;
+        vector<vector<vec3f> > draws;
+
+        fake_gl():
+            proc_lookups(0),
+            next_name(1),
+            buffer_data_calls(0),
+            vertex_buffer(0),
+            vertex_offset(0),
+            vertex_stride(0)
+        {}
+
+        //
+        // Forget the calls made so far; the buffers are kept.
+        //
+        void reset_calls()
+        {
+            this->generated.clear();
+            this->deleted.clear();
+            this->buffer_data_calls = 0;
+            this->sub_data_calls.clear();
+            this->draws.clear();
+        }
+    } gl_state;
+
+    const vector<vec3f> & last_draw()
+    {
+        BOOST_REQUIRE(!gl_state.draws.empty());
+        return gl_state.draws.back();
+    }
+
+    size_t sub_data_calls(const GLenum target)
+    {
+        size_t n = 0;
+        for (size_t i = 0; i < gl_state.sub_data_calls.size(); ++i) {
+            if (gl_state.sub_data_calls[i].target == target) { ++n; }
+        }
+        return n;
+    }
+
+    //
+    // Box nodes, used only for their addresses.
+    //
+    class geometry_nodes {
+        test_resource_fetcher fetcher_;
+        openvrml::browser browser_;
+        vector<boost::intrusive_ptr<node> > nodes_;
+
+    public:
+        geometry_nodes():
+            browser_(this->fetcher_, std::cout, std::cerr)
+        {
+            istringstream in("Box {} Box {}");
+            this->nodes_ = this->browser_.create_vrml_from_stream(in);
+            BOOST_REQUIRE_EQUAL(this->nodes_.size(), 2U);
+        }
+
+        const node & operator[](const size_t i) const
+        {
+            return *this->nodes_[i];
+        }
+    };
+
+    void quad(vertex_array_builder & builder, const GLfloat z)
+    {
+        builder.begin(GL_QUADS);
+        builder.vertex(0.0f, 0.0f, z);
+        builder.vertex(1.0f, 0.0f, z);
+        builder.vertex(1.0f, 1.0f, z);
+        builder.vertex(0.0f, 1.0f, z);
+        builder.end();
+    }
+
+    void check_quad(const vector<vec3f> & drawn, const GLfloat z)
+    {
+        BOOST_REQUIRE_EQUAL(drawn.size(), 6U);
+        BOOST_CHECK_EQUAL(drawn[0], make_vec3f(0.0f, 0.0f, z));
+        BOOST_CHECK_EQUAL(drawn[1], make_vec3f(1.0f, 0.0f, z));
+        BOOST_CHECK_EQUAL(drawn[2], make_vec3f(0.0f, 1.0f, z));
+        BOOST_CHECK_EQUAL(drawn[3], make_vec3f(1.0f, 0.0f, z));
+        BOOST_CHECK_EQUAL(drawn[4], make_vec3f(1.0f, 1.0f, z));
+        BOOST_CHECK_EQUAL(drawn[5], make_vec3f(0.0f, 1.0f, z));
+    }
+}
+
+extern "C" {
+
+    void APIENTRY test_gen_buffers(const GLsizei n, GLuint * const buffers)
+    {
+        for (GLsizei i = 0; i < n; ++i) {
+            buffers[i] = gl_state.next_name++;
+            gl_state.buffers[buffers[i]];
+            gl_state.generated.push_back(buffers[i]);
+        }
+    }
+
+    void APIENTRY test_delete_buffers(const GLsizei n,
+                                      const GLuint * const buffers)
+    {
+        for (GLsizei i = 0; i < n; ++i) {
+            BOOST_CHECK_EQUAL(gl_state.buffers.erase(buffers[i]), 1U);
+            gl_state.deleted.push_back(buffers[i]);
+        }
+    }
+
+    void APIENTRY test_bind_buffer(const GLenum target, const GLuint buffer)
+    {
+        BOOST_REQUIRE(buffer == 0 || gl_state.buffers.count(buffer));
+        gl_state.bound[target] = buffer;
+    }
+
+    void APIENTRY test_buffer_data(const GLenum target,
+                                   const std::ptrdiff_t size,
+                                   const GLvoid *,
+                                   GLenum)
+    {
+        const GLuint buffer = gl_state.bound[target];
+        BOOST_REQUIRE(buffer);
+        gl_state.buffers[buffer].assign(size, 0);
+        ++gl_state.buffer_data_calls;
+    }
+
+    void APIENTRY test_buffer_sub_data(const GLenum target,
+                                       const std::ptrdiff_t offset,
+                                       const std::ptrdiff_t size,
+                                       const GLvoid * const data)
+    {
+        const GLuint buffer = gl_state.bound[target];
+        BOOST_REQUIRE(buffer);
+        vector<unsigned char> & contents = gl_state.buffers[buffer];
+        BOOST_REQUIRE(size_t(offset + size) <= contents.size());
+        std::memcpy(&contents[offset], data, size);
+        const sub_data_call call = { target, buffer, offset, size };
+        gl_state.sub_data_calls.push_back(call);
+    }
+
+    const GLubyte * APIENTRY glGetString(const GLenum name)
+    {
+        static const GLubyte version[] = "1.5 buffer object test";
+        static const GLubyte none[] = "";
+        return (name == GL_VERSION) ? version : none;
+    }
+
+    __GLXextFuncPtr glXGetProcAddressARB(const GLubyte * const name)
+    {
+        ++gl_state.proc_lookups;
+        static const struct {
+            const char * name;
+            __GLXextFuncPtr proc;
+        } procs[] = {
+            { "glGenBuffers",
+              reinterpret_cast<__GLXextFuncPtr>(test_gen_buffers) },
+            { "glDeleteBuffers",
+              reinterpret_cast<__GLXextFuncPtr>(test_delete_buffers) },
+            { "glBindBuffer",
+              reinterpret_cast<__GLXextFuncPtr>(test_bind_buffer) },
+            { "glBufferData",
+              reinterpret_cast<__GLXextFuncPtr>(test_buffer_data) },
+            { "glBufferSubData",
+              reinterpret_cast<__GLXextFuncPtr>(test_buffer_sub_data) }
+        };
+        for (size_t i = 0; i < sizeof procs / sizeof procs[0]; ++i) {
+            if (std::strcmp(reinterpret_cast<const char *>(name),
+                            procs[i].name) == 0) {
+                return procs[i].proc;
+            }
+        }
+        return 0;
+    }
+
+    void APIENTRY glFrontFace(GLenum)
+    {}
+
+    void APIENTRY glShadeModel(GLenum)
+    {}
+
+    void APIENTRY glDisable(GLenum)
+    {}
+
+    void APIENTRY glPushClientAttrib(GLbitfield)
+    {}
+
+    void APIENTRY glPopClientAttrib()
+    {}
+
+    void APIENTRY glEnableClientState(GLenum)
+    {}
+
+    //
+    // With a buffer bound, the pointer is an offset into it.
+    //
+    void APIENTRY glVertexPointer(const GLint size,
+                                  const GLenum type,
+                                  const GLsizei stride,
+                                  const GLvoid * const pointer)
+    {
+        BOOST_REQUIRE_EQUAL(size, 3);
+        BOOST_REQUIRE_EQUAL(type, GLenum(GL_FLOAT));
+        gl_state.vertex_buffer = gl_state.bound[GL_ARRAY_BUFFER];
+        BOOST_REQUIRE(gl_state.vertex_buffer);
+        gl_state.vertex_offset = reinterpret_cast<size_t>(pointer);
+        gl_state.vertex_stride = stride;
+    }
+
+    void APIENTRY glColorPointer(GLint, GLenum, GLsizei, const GLvoid *)
+    {}
+
+    void APIENTRY glNormalPointer(GLenum, GLsizei, const GLvoid *)
+    {}
+
+    void APIENTRY glTexCoordPointer(GLint, GLenum, GLsizei, const GLvoid *)
+    {}
+
+    void APIENTRY glDrawElements(const GLenum mode,
+                                 const GLsizei count,
+                                 const GLenum type,
+                                 const GLvoid * const indices)
+    {
+        BOOST_REQUIRE_EQUAL(mode, GLenum(GL_TRIANGLES));
+        BOOST_REQUIRE_EQUAL(type, GLenum(GL_UNSIGNED_INT));
+        const GLuint index_buffer = gl_state.bound[GL_ELEMENT_ARRAY_BUFFER];
+        BOOST_REQUIRE(index_buffer);
+        const vector<unsigned char> & index_data =
+            gl_state.buffers[index_buffer];
+        const vector<unsigned char> & vertex_data =
+            gl_state.buffers[gl_state.vertex_buffer];
+        const size_t index_offset = reinterpret_cast<size_t>(indices);
+        BOOST_REQUIRE(index_offset + count * sizeof (GLuint)
+                      <= index_data.size());
+        vector<vec3f> triangles;
+        for (GLsizei i = 0; i < count; ++i) {
+            GLuint index;
+            std::memcpy(&index,
+                        &index_data[index_offset + i * sizeof index],
+                        sizeof index);
+            const size_t offset = gl_state.vertex_offset
+                + index * gl_state.vertex_stride;
+            BOOST_REQUIRE(offset + 3 * sizeof (GLfloat)
+                          <= vertex_data.size());
+            GLfloat coord[3];
+            std::memcpy(coord, &vertex_data[offset], sizeof coord);
+            triangles.push_back(make_vec3f(coord[0], coord[1], coord[2]));
+        }
+        gl_state.draws.push_back(triangles);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(creates_buffers_and_draws_from_them)
+{
+    gl_state.reset_calls();
+    const geometry_nodes nodes;
+    geometry_cache cache;
+
+    vertex_array_builder builder;
+    quad(builder, 0.0f);
+    cache.insert(nodes[0], builder);
+    BOOST_REQUIRE(cache.cached(nodes[0]));
+
+    //
+    // A vertex page and an index page, each filled once.
+    //
+    BOOST_CHECK_EQUAL(gl_state.generated.size(), 2U);
+    BOOST_CHECK_EQUAL(gl_state.buffer_data_calls, 2U);
+    BOOST_CHECK_EQUAL(sub_data_calls(GL_ARRAY_BUFFER), 1U);
+    BOOST_CHECK_EQUAL(sub_data_calls(GL_ELEMENT_ARRAY_BUFFER), 1U);
+    BOOST_CHECK_EQUAL(gl_state.bound[GL_ARRAY_BUFFER], 0U);
+    BOOST_CHECK_EQUAL(gl_state.bound[GL_ELEMENT_ARRAY_BUFFER], 0U);
+
+    cache.draw(nodes[0]);
+    check_quad(last_draw(), 0.0f);
+    BOOST_CHECK_EQUAL(gl_state.bound[GL_ARRAY_BUFFER], 0U);
+    BOOST_CHECK_EQUAL(gl_state.bound[GL_ELEMENT_ARRAY_BUFFER], 0U);
+
+    cache.clear();
+    BOOST_CHECK(gl_state.deleted == gl_state.generated);
+    BOOST_CHECK(gl_state.buffers.empty());
+}
+
+BOOST_AUTO_TEST_CASE(unchanged_geometry_reuses_buffers)
+{
+    gl_state.reset_calls();
+    const geometry_nodes nodes;
+    geometry_cache cache;
+
+    {
+        vertex_array_builder builder;
+        quad(builder, 0.0f);
+        cache.insert(nodes[0], builder);
+    }
+    {
+        vertex_array_builder builder;
+        quad(builder, 5.0f);
+        cache.insert(nodes[1], builder);
+    }
+    //
+    // The indices are written first, then the vertices.
+    //
+    BOOST_REQUIRE(gl_state.sub_data_calls.size() >= 2);
+    const sub_data_call first_vertices = gl_state.sub_data_calls[1];
+    BOOST_REQUIRE_EQUAL(first_vertices.target, GLenum(GL_ARRAY_BUFFER));
+
+    //
+    // The same primitives with moved vertices: the vertices are written
+    // over the old ones, and nothing else is created or written.
+    //
+    gl_state.reset_calls();
+    cache.remove(nodes[0]);
+    {
+        vertex_array_builder builder;
+        quad(builder, 2.0f);
+        cache.insert(nodes[0], builder);
+    }
+    cache.release_stale();
+
+    BOOST_CHECK(gl_state.generated.empty());
+    BOOST_CHECK(gl_state.deleted.empty());
+    BOOST_CHECK_EQUAL(gl_state.buffer_data_calls, 0U);
+    BOOST_REQUIRE_EQUAL(gl_state.sub_data_calls.size(), 1U);
+    const sub_data_call & update = gl_state.sub_data_calls.front();
+    BOOST_CHECK_EQUAL(update.target, GLenum(GL_ARRAY_BUFFER));
+    BOOST_CHECK_EQUAL(update.buffer, first_vertices.buffer);
+    BOOST_CHECK_EQUAL(update.offset, first_vertices.offset);
+    BOOST_CHECK_EQUAL(update.size, first_vertices.size);
+
+    cache.draw(nodes[0]);
+    check_quad(last_draw(), 2.0f);
+    cache.draw(nodes[1]);
+    check_quad(last_draw(), 5.0f);
+
+    //
+    // Different primitives get new ranges in the existing pages.
+    //
+    gl_state.reset_calls();
+    cache.remove(nodes[0]);
+    {
+        vertex_array_builder builder;
+        builder.begin(GL_TRIANGLES);
+        builder.vertex(0.0f, 0.0f, 3.0f);
+        builder.vertex(1.0f, 0.0f, 3.0f);
+        builder.vertex(0.0f, 1.0f, 3.0f);
+        builder.end();
+        cache.insert(nodes[0], builder);
+    }
+    BOOST_CHECK(gl_state.generated.empty());
+    BOOST_CHECK_EQUAL(sub_data_calls(GL_ARRAY_BUFFER), 1U);
+    BOOST_CHECK_EQUAL(sub_data_calls(GL_ELEMENT_ARRAY_BUFFER), 1U);
+    cache.draw(nodes[0]);
+    BOOST_REQUIRE_EQUAL(last_draw().size(), 3U);
+    BOOST_CHECK_EQUAL(last_draw()[2], make_vec3f(0.0f, 1.0f, 3.0f));
+
+    gl_state.reset_calls();
+    cache.clear();
+    BOOST_CHECK_EQUAL(gl_state.deleted.size(), 2U);
+    BOOST_CHECK(gl_state.buffers.empty());
+}
+
+BOOST_AUTO_TEST_CASE(page_of_released_geometry_is_deleted)
+{
+    gl_state.reset_calls();
+    const geometry_nodes nodes;
+    geometry_cache cache;
+
+    {
+        vertex_array_builder builder;
+        quad(builder, 0.0f);
+        cache.insert(nodes[0], builder);
+    }
+
+    //
+    // Geometry larger than a vertex page gets a page of its own, which is
+    // deleted when the geometry is released.
+    //
+    gl_state.reset_calls();
+    {
+        vertex_array_builder builder;
+        for (size_t i = 0; i < 8192; ++i) { quad(builder, GLfloat(i)); }
+        BOOST_REQUIRE(builder.vertices().size()
+                      * sizeof (openvrml::gl::local::interleaved_vertex)
+                      > 1024 * 1024);
+        cache.insert(nodes[1], builder);
+    }
+    BOOST_REQUIRE_EQUAL(gl_state.generated.size(), 1U);
+    const GLuint own_page = gl_state.generated.front();
+    cache.draw(nodes[1]);
+    BOOST_CHECK_EQUAL(last_draw().size(), 8192U * 6);
+    BOOST_CHECK_EQUAL(last_draw().back().z(), 8191.0f);
+
+    gl_state.reset_calls();
+    cache.remove(nodes[1]);
+    cache.release_stale();
+    BOOST_REQUIRE_EQUAL(gl_state.deleted.size(), 1U);
+    BOOST_CHECK_EQUAL(gl_state.deleted.front(), own_page);
+    BOOST_CHECK(cache.cached(nodes[0]));
+    cache.draw(nodes[0]);
+    check_quad(last_draw(), 0.0f);
+
+    cache.clear();
+    BOOST_CHECK(gl_state.buffers.empty());
+    BOOST_CHECK_EQUAL(gl_state.proc_lookups, 5U);
+}
+# else
+//
+// The buffer object entry points can only be substituted where they are
+// looked up with glXGetProcAddressARB.
+//
+BOOST_AUTO_TEST_CASE(buffer_objects_need_glx)
+{
+    BOOST_TEST_MESSAGE("glXGetProcAddressARB is not used; skipped");
+}
+# endif
@@ -0,0 +1,227 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+//
+// image_stream_listener decodes a texture into a private buffer and swaps
+// it into the shared_image once it is complete; only then are the nodes
+// using the image marked modified.  The fixtures are 13x9 Adam7-interlaced
+// PNGs without a gAMA chunk, so that their pixels come out unchanged:
+//
+//   interlaced_rgb_png             8-bit RGB; pixel (x, y) from the top left
+//                                  is (20x, 28y, 255 - 10(x + y)).
+//   interlaced_gray_palette_png    4-bit palette of eight grays, 36i, with
+//                                  tRNS alpha 255 - 30i; pixel (x, y) is
+//                                  index (x + 3y) mod 8.
+//
+
+# define BOOST_TEST_MAIN
+# define BOOST_TEST_MODULE image_stream_listener
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+# include <sstream>
+# include <boost/test/unit_test.hpp>
+# include <openvrml/browser.h>
+# include <openvrml/node.h>
+# include "image_stream_listener.h"
+# include "test_resource_fetcher.h"
+
+using namespace std;
+using namespace openvrml;
+using openvrml_node_vrml97::image_stream_listener;
+using openvrml_node_vrml97::shared_image;
+
+namespace {
+
+    const unsigned char interlaced_rgb_png[] = {
+        0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d,
+        0x49, 0x48, 0x44, 0x52, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x09,
+        0x08, 0x02, 0x00, 0x00, 0x01, 0x11, 0x1f, 0x01, 0xab, 0x00, 0x00, 0x01,
+        0x27, 0x49, 0x44, 0x41, 0x54, 0x78, 0xda, 0x05, 0xc1, 0xa1, 0xb6, 0xac,
+        0x20, 0x18, 0x06, 0xd0, 0xef, 0x21, 0x88, 0x3c, 0x00, 0x6f, 0x70, 0x09,
+        0x96, 0x93, 0xa7, 0x10, 0x98, 0x6c, 0xb1, 0xd8, 0x58, 0xcb, 0x42, 0x31,
+        0x53, 0xfe, 0x42, 0xa6, 0x50, 0x5c, 0x8b, 0x66, 0xb1, 0x98, 0x25, 0x50,
+        0xcc, 0x16, 0x02, 0x93, 0xa7, 0x50, 0x4e, 0x3e, 0x77, 0x6f, 0x00, 0x7f,
+        0x11, 0x3b, 0xd0, 0xf6, 0xd8, 0x46, 0x28, 0x3c, 0x1d, 0x0e, 0xaa, 0xb9,
+        0xde, 0xfe, 0x01, 0xe6, 0x51, 0x66, 0x8f, 0xc6, 0x75, 0x33, 0x42, 0xe0,
+        0x6b, 0x71, 0x15, 0x04, 0x08, 0x73, 0x59, 0x13, 0x8a, 0x59, 0x20, 0x5a,
+        0xb0, 0x6d, 0x29, 0xed, 0x05, 0xc8, 0xaf, 0x90, 0x8f, 0x92, 0x97, 0x95,
+        0x7b, 0x94, 0xa1, 0x48, 0xd7, 0xe5, 0x02, 0xa4, 0x4b, 0xa4, 0x5d, 0xa5,
+        0x60, 0x93, 0x8b, 0x69, 0x29, 0x69, 0xec, 0xe9, 0x05, 0x86, 0xdf, 0x01,
+        0x9f, 0x09, 0x37, 0xe1, 0x3c, 0xb0, 0x55, 0x78, 0x30, 0xf9, 0x19, 0xe4,
+        0x3d, 0xc9, 0x93, 0xe4, 0x76, 0x48, 0x5f, 0xe5, 0x0a, 0x66, 0xee, 0xc1,
+        0x9c, 0x93, 0xd9, 0xc8, 0xf8, 0xc3, 0xac, 0xd5, 0xcc, 0x60, 0xe9, 0x1c,
+        0xd2, 0x36, 0x25, 0x4f, 0x69, 0x3d, 0xd2, 0x5c, 0xd3, 0x1b, 0xac, 0x6d,
+        0x43, 0xf3, 0x53, 0x5b, 0xa9, 0xcd, 0x47, 0x7b, 0xd7, 0xf6, 0x03, 0xf0,
+        0x5f, 0xc6, 0xbf, 0x82, 0x7f, 0x06, 0xfe, 0x28, 0x7e, 0x4f, 0xfc, 0xb2,
+        0xfc, 0x24, 0xbe, 0x47, 0xbe, 0x1d, 0x3c, 0x14, 0xee, 0x2b, 0x77, 0x9d,
+        0xaf, 0x80, 0xfe, 0x30, 0xfd, 0x08, 0x7d, 0x0f, 0xfa, 0x52, 0xfa, 0x9c,
+        0xf4, 0x6e, 0xf5, 0x46, 0x3a, 0x44, 0xed, 0x0f, 0xed, 0x8a, 0x5e, 0xab,
+        0x5e, 0xba, 0x9e, 0x01, 0xba, 0x19, 0x5d, 0x82, 0xce, 0x81, 0x76, 0x45,
+        0xdb, 0x44, 0xc1, 0x92, 0x27, 0x72, 0x91, 0xd6, 0x83, 0x96, 0x42, 0x73,
+        0xa5, 0xb1, 0xd3, 0x1b, 0xc8, 0x27, 0xcb, 0xbb, 0xc8, 0xdb, 0x90, 0x83,
+        0xca, 0x7e, 0xca, 0xce, 0xe6, 0x95, 0xf2, 0x12, 0xf3, 0x7c, 0xe4, 0xb1,
+        0xe4, 0x77, 0xcd, 0xaf, 0x9e, 0x7f, 0xfe, 0x03, 0xe1, 0xc4, 0xb0, 0xe0,
+        0x18, 0xcd, 0x59, 0xe0, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44,
+        0xae, 0x42, 0x60, 0x82
+    };
+
+    const unsigned char interlaced_gray_palette_png[] = {
+        0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d,
+        0x49, 0x48, 0x44, 0x52, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x09,
+        0x04, 0x03, 0x00, 0x00, 0x01, 0x6c, 0x53, 0x8b, 0xcf, 0x00, 0x00, 0x00,
+        0x18, 0x50, 0x4c, 0x54, 0x45, 0x00, 0x00, 0x00, 0x24, 0x24, 0x24, 0x48,
+        0x48, 0x48, 0x6c, 0x6c, 0x6c, 0x90, 0x90, 0x90, 0xb4, 0xb4, 0xb4, 0xd8,
+        0xd8, 0xd8, 0xfc, 0xfc, 0xfc, 0xc5, 0x0f, 0x89, 0xb8, 0x00, 0x00, 0x00,
+        0x08, 0x74, 0x52, 0x4e, 0x53, 0xff, 0xe1, 0xc3, 0xa5, 0x87, 0x69, 0x4b,
+        0x2d, 0x7a, 0x1a, 0x31, 0x8e, 0x00, 0x00, 0x00, 0x44, 0x49, 0x44, 0x41,
+        0x54, 0x78, 0xda, 0x63, 0x60, 0x00, 0x02, 0x17, 0x20, 0x74, 0x70, 0x60,
+        0x50, 0x53, 0x60, 0x48, 0x4a, 0x00, 0x91, 0x09, 0x2a, 0x09, 0x0a, 0x0c,
+        0x2a, 0x40, 0x92, 0x41, 0x38, 0x5c, 0x98, 0xa1, 0xd0, 0xb4, 0x90, 0x21,
+        0x5c, 0x38, 0x9c, 0xc1, 0xb4, 0xd0, 0x14, 0xcc, 0x37, 0x09, 0x2b, 0x10,
+        0x02, 0x62, 0x06, 0x21, 0x30, 0x23, 0x80, 0x01, 0xcc, 0x13, 0x32, 0x60,
+        0x80, 0x08, 0x0b, 0x00, 0x00, 0x29, 0xb8, 0x0f, 0x58, 0xf3, 0x59, 0xae,
+        0x22, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60,
+        0x82
+    };
+
+    void rgb_pixel(const size_t x, const size_t y, unsigned char * const p)
+    {
+        p[0] = 20 * x;
+        p[1] = 28 * y;
+        p[2] = 255 - 10 * (x + y);
+    }
+
+    void gray_alpha_pixel(const size_t x, const size_t y,
+                          unsigned char * const p)
+    {
+        const size_t index = (x + 3 * y) % 8;
+        p[0] = 36 * index;
+        p[1] = 255 - 30 * index;
+    }
+
+    //
+    // openvrml::image pixels start at the bottom left.
+    //
+    const openvrml::image
+    expected_image(const size_t comp,
+                   void (*pixel)(size_t x, size_t y, unsigned char * p))
+    {
+        const size_t x = 13, y = 9;
+        vector<unsigned char> pixels(x * y * comp);
+        for (size_t row = 0; row < y; ++row) {
+            for (size_t col = 0; col < x; ++col) {
+                pixel(col, row, &pixels[((y - 1 - row) * x + col) * comp]);
+            }
+        }
+        return openvrml::image(x, y, comp, pixels.begin(), pixels.end());
+    }
+
+    //
+    // Feed the PNG to an image_stream_listener chunk_size bytes at a time.
+    // After each chunk, the shared image must either be empty, with the node
+    // using it not yet marked modified, or be the expected image.
+    //
+    const openvrml::image decode(const unsigned char * const png,
+                                 const size_t size,
+                                 const size_t chunk_size,
+                                 const openvrml::image & expected)
+    {
+        test_resource_fetcher fetcher;
+        ostringstream out, err;
+        browser b(fetcher, out, err);
+        istringstream vrml("#VRML V2.0 utf8\nGroup {}\n");
+        const boost::intrusive_ptr<node> n =
+            b.create_vrml_from_stream(vrml).at(0);
+        n->modified(false);
+
+        static const string uri = "urn:X-openvrml:test:image";
+        const boost::shared_ptr<shared_image> image(new shared_image(uri));
+        image->attach(*n);
+        {
+            image_stream_listener listener(uri, image, b);
+            listener.stream_available(uri, "image/png");
+            for (size_t pos = 0; pos < size; pos += chunk_size) {
+                listener.data_available(png + pos,
+                                        min(chunk_size, size - pos));
+                boost::shared_lock<boost::shared_mutex>
+                    lock(image->mutex());
+                if (image->image().array().empty()) {
+                    BOOST_REQUIRE(!n->modified());
+                } else {
+                    BOOST_REQUIRE(image->image() == expected);
+                    BOOST_REQUIRE(n->modified());
+                }
+            }
+            BOOST_CHECK(n->modified());
+        }
+        image->detach(*n);
+        BOOST_CHECK(err.str().empty());
+        return image->image();
+    }
+
+    void check_decoded(const unsigned char * const png,
+                       const size_t size,
+                       const size_t chunk_size,
+                       const openvrml::image & expected)
+    {
+        const openvrml::image decoded =
+            decode(png, size, chunk_size, expected);
+        BOOST_CHECK_EQUAL(decoded.x(), expected.x());
+        BOOST_CHECK_EQUAL(decoded.y(), expected.y());
+        BOOST_CHECK_EQUAL(decoded.comp(), expected.comp());
+        BOOST_CHECK_EQUAL_COLLECTIONS(decoded.array().begin(),
+                                      decoded.array().end(),
+                                      expected.array().begin(),
+                                      expected.array().end());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(interlaced_png_is_decoded)
+{
+    check_decoded(interlaced_rgb_png, sizeof interlaced_rgb_png,
+                  sizeof interlaced_rgb_png,
+                  expected_image(3, rgb_pixel));
+}
+
+BOOST_AUTO_TEST_CASE(interlaced_gray_palette_png_is_decoded_as_gray)
+{
+    //
+    // A palette of grays is expanded to RGBA by libpng; only one of the
+    // color channels is kept.
+    //
+    check_decoded(interlaced_gray_palette_png,
+                  sizeof interlaced_gray_palette_png,
+                  sizeof interlaced_gray_palette_png,
+                  expected_image(2, gray_alpha_pixel));
+}
+
+BOOST_AUTO_TEST_CASE(image_is_published_once_it_is_complete)
+{
+    //
+    // One byte at a time, decoding suspends in every pass of the interlaced
+    // image; none of the passes may be seen before the last one is done.
+    //
+    check_decoded(interlaced_rgb_png, sizeof interlaced_rgb_png, 1,
+                  expected_image(3, rgb_pixel));
+    check_decoded(interlaced_gray_palette_png,
+                  sizeof interlaced_gray_palette_png, 1,
+                  expected_image(2, gray_alpha_pixel));
+}
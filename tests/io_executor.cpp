@@ -0,0 +1,346 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+//
+// The executors here have a single worker, which is held up by a gate job
+// while the jobs under test are queued.
+//
+
+# define BOOST_TEST_MAIN
+# define BOOST_TEST_MODULE io_executor
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+# include <boost/bind.hpp>
+# include <boost/scoped_ptr.hpp>
+# include <boost/test/unit_test.hpp>
+# include <openvrml/local/io_executor.h>
+
+using openvrml::local::io_executor;
+using openvrml::local::io_job;
+
+namespace {
+
+    const boost::posix_time::seconds timeout(10);
+
+    //
+    // Records the jobs that have run, in order.
+    //
+    class recorder {
+        mutable boost::mutex mutex_;
+        mutable boost::condition_variable changed_;
+        std::vector<int> ran_;
+
+    public:
+        void record(const int id)
+        {
+            {
+                boost::mutex::scoped_lock lock(this->mutex_);
+                this->ran_.push_back(id);
+            }
+            this->changed_.notify_all();
+        }
+
+        bool wait_for(const size_t n) const
+        {
+            const boost::system_time deadline =
+                boost::get_system_time() + timeout;
+            boost::mutex::scoped_lock lock(this->mutex_);
+            while (this->ran_.size() < n) {
+                if (!this->changed_.timed_wait(lock, deadline)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        const std::vector<int> ran() const
+        {
+            boost::mutex::scoped_lock lock(this->mutex_);
+            return this->ran_;
+        }
+    };
+
+    //
+    // A job that blocks the worker running it until it is opened.
+    //
+    class gate {
+        boost::mutex mutex_;
+        boost::condition_variable changed_;
+        bool entered_, open_;
+
+    public:
+        gate():
+            entered_(false),
+            open_(false)
+        {}
+
+        void pass()
+        {
+            boost::mutex::scoped_lock lock(this->mutex_);
+            this->entered_ = true;
+            this->changed_.notify_all();
+            while (!this->open_) { this->changed_.wait(lock); }
+        }
+
+        bool wait_entered()
+        {
+            const boost::system_time deadline =
+                boost::get_system_time() + timeout;
+            boost::mutex::scoped_lock lock(this->mutex_);
+            while (!this->entered_) {
+                if (!this->changed_.timed_wait(lock, deadline)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void open()
+        {
+            {
+                boost::mutex::scoped_lock lock(this->mutex_);
+                this->open_ = true;
+            }
+            this->changed_.notify_all();
+        }
+    };
+
+    const std::vector<int> sequence(const int * const ids, const size_t n)
+    {
+        return std::vector<int>(ids, ids + n);
+    }
+
+    const boost::shared_ptr<io_job>
+    post(io_executor & executor, recorder & r, const int id,
+         const float priority)
+    {
+        return executor.post(boost::bind(&recorder::record, &r, id),
+                             priority,
+                             true);
+    }
+
+    //
+    // Open g once job has finished or been cancelled.
+    //
+    void open_when_finished(gate & g, const boost::shared_ptr<io_job> & job)
+    {
+        const boost::system_time deadline =
+            boost::get_system_time() + timeout;
+        while (!job->finished() && boost::get_system_time() < deadline) {
+            boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+        }
+        g.open();
+    }
+
+    const boost::shared_ptr<io_job>
+    block(io_executor & executor, gate & g)
+    {
+        const boost::shared_ptr<io_job> job =
+            executor.post(boost::bind(&gate::pass, &g), 0.0f, true);
+        BOOST_REQUIRE(g.wait_entered());
+        return job;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(jobs_run_in_priority_order)
+{
+    io_executor executor(1);
+    recorder r;
+    gate g;
+    block(executor, g);
+
+    post(executor, r, 3, 3.0f);
+    post(executor, r, 1, 1.0f);
+    post(executor, r, 2, 2.0f);
+    post(executor, r, 11, 1.0f);
+    g.open();
+
+    BOOST_REQUIRE(r.wait_for(4));
+    static const int expected[] = { 1, 11, 2, 3 };
+    BOOST_CHECK(r.ran() == sequence(expected, 4));
+}
+
+BOOST_AUTO_TEST_CASE(deferred_job_is_queued_behind_queued_jobs)
+{
+    io_executor executor(1);
+    recorder r;
+    gate g;
+    block(executor, g);
+
+    //
+    // The deferred job is due at once, but its priority is raised to that
+    // of the last job in the queue when it is queued.
+    //
+    executor.defer(boost::bind(&recorder::record, &r, 0),
+                   0.0f,
+                   true,
+                   boost::posix_time::milliseconds(0));
+    post(executor, r, 5, 5.0f);
+    boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    g.open();
+
+    BOOST_REQUIRE(r.wait_for(2));
+    static const int expected[] = { 5, 0 };
+    BOOST_CHECK(r.ran() == sequence(expected, 2));
+}
+
+BOOST_AUTO_TEST_CASE(deferred_job_waits_for_its_delay)
+{
+    io_executor executor(1);
+    recorder r;
+
+    const boost::system_time start = boost::get_system_time();
+    executor.defer(boost::bind(&recorder::record, &r, 1),
+                   0.0f,
+                   true,
+                   boost::posix_time::milliseconds(50));
+    BOOST_REQUIRE(r.wait_for(1));
+    BOOST_CHECK(boost::get_system_time() - start
+                >= boost::posix_time::milliseconds(50));
+}
+
+BOOST_AUTO_TEST_CASE(job_deferred_until_resumed)
+{
+    io_executor executor(1);
+    recorder r;
+
+    const boost::shared_ptr<io_job> job =
+        executor.defer(boost::bind(&recorder::record, &r, 1),
+                       0.0f,
+                       true,
+                       boost::posix_time::time_duration(
+                           boost::posix_time::pos_infin));
+    post(executor, r, 2, 0.0f);
+    BOOST_REQUIRE(r.wait_for(1));
+    boost::this_thread::sleep(boost::posix_time::milliseconds(20));
+    BOOST_CHECK(!job->finished());
+
+    BOOST_CHECK(job->resume());
+    BOOST_REQUIRE(r.wait_for(2));
+    static const int expected[] = { 2, 1 };
+    BOOST_CHECK(r.ran() == sequence(expected, 2));
+    job->wait();
+    BOOST_CHECK(job->finished());
+    BOOST_CHECK(!job->resume());
+}
+
+BOOST_AUTO_TEST_CASE(cancelled_jobs_do_not_run)
+{
+    io_executor executor(1);
+    recorder r;
+    gate g;
+    const boost::shared_ptr<io_job> running = block(executor, g);
+
+    const boost::shared_ptr<io_job> queued = post(executor, r, 1, 0.0f);
+    const boost::shared_ptr<io_job> deferred =
+        executor.defer(boost::bind(&recorder::record, &r, 2),
+                       0.0f,
+                       true,
+                       boost::posix_time::time_duration(
+                           boost::posix_time::pos_infin));
+    post(executor, r, 3, 0.0f);
+
+    BOOST_CHECK(queued->cancel());
+    BOOST_CHECK(deferred->cancel());
+    BOOST_CHECK(queued->finished());
+    BOOST_CHECK(!deferred->resume());
+    BOOST_CHECK(!running->cancel());
+    g.open();
+
+    BOOST_REQUIRE(r.wait_for(1));
+    running->wait();
+    BOOST_CHECK(running->finished());
+    static const int expected[] = { 3 };
+    BOOST_CHECK(r.ran() == sequence(expected, 1));
+}
+
+BOOST_AUTO_TEST_CASE(cancel_all_waits_for_running_jobs)
+{
+    io_executor executor(1);
+    recorder r;
+    gate g;
+    const boost::shared_ptr<io_job> running = block(executor, g);
+
+    const boost::shared_ptr<io_job> queued = post(executor, r, 1, 0.0f);
+    const boost::shared_ptr<io_job> deferred =
+        executor.defer(boost::bind(&recorder::record, &r, 2),
+                       0.0f,
+                       true,
+                       boost::posix_time::milliseconds(0));
+
+    boost::thread canceller(boost::bind(&io_executor::cancel_all,
+                                        &executor));
+
+    //
+    // The queued and deferred jobs are cancelled at once; cancel_all then
+    // waits for the running one.
+    //
+    const boost::system_time deadline = boost::get_system_time() + timeout;
+    while (!(queued->finished() && deferred->finished())
+           && boost::get_system_time() < deadline) {
+        boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+    }
+    BOOST_CHECK(queued->finished());
+    BOOST_CHECK(deferred->finished());
+    BOOST_CHECK(!running->finished());
+    BOOST_CHECK(!canceller.timed_join(boost::posix_time::milliseconds(20)));
+
+    g.open();
+    canceller.join();
+    BOOST_CHECK(running->finished());
+    BOOST_CHECK(r.ran().empty());
+
+    //
+    // The executor is still usable.
+    //
+    post(executor, r, 3, 0.0f);
+    BOOST_REQUIRE(r.wait_for(1));
+}
+
+BOOST_AUTO_TEST_CASE(destruction_cancels_pending_jobs)
+{
+    recorder r;
+    gate g;
+    boost::scoped_ptr<io_executor> executor(new io_executor(1));
+    block(*executor, g);
+
+    executor->defer(boost::bind(&recorder::record, &r, 1),
+                    0.0f,
+                    true,
+                    boost::posix_time::milliseconds(0));
+    executor->defer(boost::bind(&recorder::record, &r, 2),
+                    0.0f,
+                    true,
+                    boost::posix_time::time_duration(
+                        boost::posix_time::pos_infin));
+    const boost::shared_ptr<io_job> queued = post(*executor, r, 3, 0.0f);
+
+    //
+    // The destructor waits for the gate job; open it once the destructor
+    // has cancelled the others.
+    //
+    boost::thread opener(boost::bind(open_when_finished,
+                                     boost::ref(g),
+                                     queued));
+    executor.reset();
+    opener.join();
+    BOOST_CHECK(r.ran().empty());
+}
@@ -0,0 +1,140 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# include "memory_usage.h"
+# include <cstdlib>
+# include <fstream>
+# include <new>
+# include <boost/smart_ptr/detail/spinlock.hpp>
+# include <sys/resource.h>
+# include <unistd.h>
+
+namespace {
+
+    //
+    // Every allocation is prefixed with its size so that operator delete can
+    // keep track of the number of live bytes.  The counts are updated from
+    // any thread; the lock is statically initialized, so it can be used
+    // before any constructor has run.
+    //
+    const std::size_t header_size = 2 * sizeof (void *);
+    boost::detail::spinlock count_lock = BOOST_DETAIL_SPINLOCK_INIT;
+    std::size_t allocation_count = 0;
+    std::size_t live_byte_count = 0;
+
+    void * allocate(const std::size_t size) throw ()
+    {
+        char * const p =
+            static_cast<char *>(std::malloc(header_size + size));
+        if (!p) { return 0; }
+        *reinterpret_cast<std::size_t *>(p) = size;
+        {
+            boost::detail::spinlock::scoped_lock lock(count_lock);
+            ++allocation_count;
+            live_byte_count += size;
+        }
+        return p + header_size;
+    }
+
+    void deallocate(void * const ptr) throw ()
+    {
+        if (!ptr) { return; }
+        char * const p = static_cast<char *>(ptr) - header_size;
+        {
+            boost::detail::spinlock::scoped_lock lock(count_lock);
+            live_byte_count -= *reinterpret_cast<std::size_t *>(p);
+        }
+        std::free(p);
+    }
+}
+
+std::size_t allocations()
+{
+    boost::detail::spinlock::scoped_lock lock(count_lock);
+    return allocation_count;
+}
+
+std::size_t live_bytes()
+{
+    boost::detail::spinlock::scoped_lock lock(count_lock);
+    return live_byte_count;
+}
+
+std::size_t resident_kib()
+{
+    std::ifstream statm("/proc/self/statm");
+    std::size_t size = 0, resident = 0;
+    if (!(statm >> size >> resident)) { return 0; }
+    return resident * std::size_t(sysconf(_SC_PAGESIZE)) / 1024;
+}
+
+std::size_t peak_resident_kib()
+{
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) { return 0; }
+# ifdef __APPLE__
+    return std::size_t(usage.ru_maxrss) / 1024;
+# else
+    return std::size_t(usage.ru_maxrss);
+# endif
+}
+
+void * operator new(const std::size_t size) throw (std::bad_alloc)
+{
+    void * const p = allocate(size);
+    if (!p) { throw std::bad_alloc(); }
+    return p;
+}
+
+void * operator new[](const std::size_t size) throw (std::bad_alloc)
+{
+    void * const p = allocate(size);
+    if (!p) { throw std::bad_alloc(); }
+    return p;
+}
+
+void * operator new(const std::size_t size, const std::nothrow_t &) throw ()
+{
+    return allocate(size);
+}
+
+void * operator new[](const std::size_t size, const std::nothrow_t &)
+    throw ()
+{
+    return allocate(size);
+}
+
+void operator delete(void * const ptr) throw ()
+{
+    deallocate(ptr);
+}
+
+void operator delete[](void * const ptr) throw ()
+{
+    deallocate(ptr);
+}
+
+void operator delete(void * const ptr, const std::nothrow_t &) throw ()
+{
+    deallocate(ptr);
+}
+
+void operator delete[](void * const ptr, const std::nothrow_t &) throw ()
+{
+    deallocate(ptr);
+}
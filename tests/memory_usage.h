@@ -0,0 +1,50 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# ifndef MEMORY_USAGE
+#   define MEMORY_USAGE
+
+#   include <cstddef>
+
+//
+// Linking with libtest-openvrml replaces the global operator new and
+// operator delete with ones that keep count of the heap allocations made and
+// the number of bytes live.
+//
+
+//
+// The number of heap allocations made so far.
+//
+std::size_t allocations();
+
+//
+// The number of bytes allocated from the heap and not yet freed.
+//
+std::size_t live_bytes();
+
+//
+// The resident size of the process in KiB, or 0 if it is not known.
+//
+std::size_t resident_kib();
+
+//
+// The peak resident size of the process in KiB, or 0 if it is not known.
+//
+std::size_t peak_resident_kib();
+
+# endif
@@ -0,0 +1,195 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# define BOOST_TEST_MAIN
+# define BOOST_TEST_MODULE mesh
+
+# include <boost/test/unit_test.hpp>
+# include <openvrml/mesh.h>
+# include <cmath>
+
+using namespace std;
+using namespace openvrml;
+
+namespace {
+
+    //
+    // A unit cube whose faces do not share coordinate indices, as written
+    // by tools that split vertices along texture seams.
+    //
+    void make_split_cube(vector<vec3f> & coord, vector<int32> & coord_index)
+    {
+        static const float face[6][4][3] = {
+            { { 0, 0, 1 }, { 1, 0, 1 }, { 1, 1, 1 }, { 0, 1, 1 } },
+            { { 0, 0, 0 }, { 0, 1, 0 }, { 1, 1, 0 }, { 1, 0, 0 } },
+            { { 0, 0, 0 }, { 0, 0, 1 }, { 0, 1, 1 }, { 0, 1, 0 } },
+            { { 1, 0, 0 }, { 1, 1, 0 }, { 1, 1, 1 }, { 1, 0, 1 } },
+            { { 0, 1, 0 }, { 0, 1, 1 }, { 1, 1, 1 }, { 1, 1, 0 } },
+            { { 0, 0, 0 }, { 1, 0, 0 }, { 1, 0, 1 }, { 0, 0, 1 } }
+        };
+        coord.clear();
+        coord_index.clear();
+        for (size_t f = 0; f < 6; ++f) {
+            for (size_t v = 0; v < 4; ++v) {
+                coord_index.push_back(int32(coord.size()));
+                coord.push_back(
+                    make_vec3f(face[f][v][0], face[f][v][1], face[f][v][2]));
+            }
+            coord_index.push_back(-1);
+        }
+    }
+
+    bool close(const vec3f & a, const vec3f & b)
+    {
+        return (a - b).length() < 1e-5f;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(normal_index_parallels_coord_index)
+{
+    vector<vec3f> coord;
+    vector<int32> coord_index;
+    make_split_cube(coord, coord_index);
+
+    vector<vec3f> normal;
+    vector<int32> normal_index;
+    generate_normals(coord, coord_index, 0.5f, true, normal, normal_index);
+
+    BOOST_REQUIRE_EQUAL(normal_index.size(), coord_index.size());
+    BOOST_REQUIRE_EQUAL(normal.size(), 24u);
+    for (size_t i = 0; i < coord_index.size(); ++i) {
+        BOOST_CHECK_EQUAL(normal_index[i] == -1, coord_index[i] == -1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(crease_keeps_cube_faceted)
+{
+    vector<vec3f> coord;
+    vector<int32> coord_index;
+    make_split_cube(coord, coord_index);
+
+    vector<vec3f> normal;
+    vector<int32> normal_index;
+    generate_normals(coord, coord_index, 0.5f, true, normal, normal_index);
+
+    BOOST_CHECK(close(normal[size_t(normal_index[0])],
+                      make_vec3f(0, 0, 1)));
+    BOOST_CHECK(close(normal[size_t(normal_index[5])],
+                      make_vec3f(0, 0, -1)));
+}
+
+BOOST_AUTO_TEST_CASE(smoothing_welds_split_coordinates)
+{
+    vector<vec3f> coord;
+    vector<int32> coord_index;
+    make_split_cube(coord, coord_index);
+
+    vector<vec3f> normal;
+    vector<int32> normal_index;
+    generate_normals(coord, coord_index, 3.2f, true, normal, normal_index);
+
+    //
+    // The corner at the origin is shared by three faces of equal area.
+    //
+    const float c = -1.0f / std::sqrt(3.0f);
+    BOOST_CHECK(close(normal[size_t(normal_index[5])], make_vec3f(c, c, c)));
+}
+
+BOOST_AUTO_TEST_CASE(clockwise_faces_flip_normals)
+{
+    vector<vec3f> coord;
+    vector<int32> coord_index;
+    make_split_cube(coord, coord_index);
+
+    vector<vec3f> normal;
+    vector<int32> normal_index;
+    generate_normals(coord, coord_index, 0.0f, false, normal, normal_index);
+
+    BOOST_CHECK(close(normal[size_t(normal_index[0])],
+                      make_vec3f(0, 0, -1)));
+}
+
+BOOST_AUTO_TEST_CASE(large_mesh)
+{
+    //
+    // Large enough to be split across a browser's compute threads; with no
+    // browser here, the normals are generated on the calling thread.
+    //
+    static const int32 n = 200;
+    vector<vec3f> coord;
+    vector<int32> coord_index;
+    for (int32 j = 0; j < n; ++j) {
+        for (int32 i = 0; i < n; ++i) {
+            coord.push_back(make_vec3f(float(i), 0.0f, float(j)));
+        }
+    }
+    for (int32 j = 0; j < n - 1; ++j) {
+        for (int32 i = 0; i < n - 1; ++i) {
+            coord_index.push_back(j * n + i);
+            coord_index.push_back((j + 1) * n + i);
+            coord_index.push_back((j + 1) * n + i + 1);
+            coord_index.push_back(j * n + i + 1);
+            coord_index.push_back(-1);
+        }
+    }
+
+    vector<vec3f> normal;
+    vector<int32> normal_index;
+    generate_normals(coord, coord_index, 1.0f, true, normal, normal_index);
+
+    BOOST_REQUIRE_EQUAL(normal_index.size(), coord_index.size());
+    for (size_t i = 0; i < coord_index.size(); ++i) {
+        if (coord_index[i] == -1) { continue; }
+        BOOST_REQUIRE(close(normal[size_t(normal_index[i])],
+                            make_vec3f(0, 1, 0)));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(triangle_fan)
+{
+    static const int32 index[] = { 0, 1, 2, 3, -1, 4, 5, -1 };
+    vector<int32> coord_index;
+    triangle_fan_coord_index(
+        vector<int32>(index, index + sizeof index / sizeof index[0]),
+        coord_index);
+
+    static const int32 expected[] = { 0, 1, 2, -1, 0, 2, 3, -1 };
+    BOOST_CHECK_EQUAL_COLLECTIONS(coord_index.begin(), coord_index.end(),
+                                  expected,
+                                  expected + sizeof expected
+                                             / sizeof expected[0]);
+}
+
+BOOST_AUTO_TEST_CASE(triangle_strip)
+{
+    static const int32 index[] = { 0, 1, 2, 3, 4 };
+    vector<int32> coord_index;
+    triangle_strip_coord_index(
+        vector<int32>(index, index + sizeof index / sizeof index[0]),
+        coord_index);
+
+    static const int32 expected[] = {
+        0, 1, 2, -1,
+        2, 1, 3, -1,
+        2, 3, 4, -1
+    };
+    BOOST_CHECK_EQUAL_COLLECTIONS(coord_index.begin(), coord_index.end(),
+                                  expected,
+                                  expected + sizeof expected
+                                             / sizeof expected[0]);
+}
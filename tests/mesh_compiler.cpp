@@ -0,0 +1,225 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+//
+// browser::set_world compiles the meshes of the world's geometry before the
+// first frame.  A geometry node changed after its mesh has been compiled
+// must be compiled again when it is drawn, not drawn with the mesh it had.
+//
+
+# define BOOST_TEST_MAIN
+# define BOOST_TEST_MODULE mesh_compiler
+
+# include <algorithm>
+# include <map>
+# include <sstream>
+# include <boost/test/unit_test.hpp>
+# include <openvrml/browser.h>
+# include <openvrml/compiled_mesh.h>
+# include <openvrml/scene.h>
+# include <openvrml/scope.h>
+# include "string_resource_istream.h"
+# include "test_resource_fetcher.h"
+# include "test_viewer.h"
+
+using namespace std;
+using namespace openvrml;
+
+namespace {
+
+    const char url[] = "file:///mesh-compiler-test.wrl";
+
+    const char triangles[] =
+        "#VRML V2.0 utf8\n"
+        "Shape {\n"
+        "  geometry DEF F IndexedFaceSet {\n"
+        "    coord DEF C Coordinate { point [ 0 0 0, 1 0 0, 0 1 0 ] }\n"
+        "    coordIndex [ 0 1 2 -1 ]\n"
+        "  }\n"
+        "}\n"
+        "Shape {\n"
+        "  geometry DEF G IndexedFaceSet {\n"
+        "    coord Coordinate { point [ 0 0 0, 0 0 1, 0 1 0 ] }\n"
+        "    coordIndex [ 0 1 2 -1 ]\n"
+        "  }\n"
+        "}\n";
+
+    //
+    // Keeps the meshes that reach it, by the DEF name of their node.
+    //
+    class mesh_viewer : public test_viewer {
+    public:
+        std::map<std::string, compiled_mesh> meshes;
+
+        virtual ~mesh_viewer() throw ()
+        {}
+
+    private:
+        virtual bounding_volume::intersection
+        do_intersect_view_volume(const bounding_volume &) const
+        {
+            return bounding_volume::inside;
+        }
+
+        virtual void do_insert_mesh(const geometry_node & n,
+                                    const compiled_mesh & mesh)
+        {
+            this->meshes[n.id()] = mesh;
+        }
+    };
+
+    void load(browser & b, const std::string & vrml)
+    {
+        string_resource_istream in(url, vrml);
+        b.set_world(in);
+    }
+
+    node & find_node(browser & b, const std::string & id)
+    {
+        BOOST_REQUIRE(!b.root_scene()->nodes().empty());
+        node * const n =
+            b.root_scene()->nodes().front()->scope().find_node(id);
+        BOOST_REQUIRE(n);
+        return *n;
+    }
+
+    geometry_node & find_geometry(browser & b, const std::string & id)
+    {
+        geometry_node * const n =
+            node_cast<geometry_node *>(&find_node(b, id));
+        BOOST_REQUIRE(n);
+        return *n;
+    }
+
+    bool has_coord(const compiled_mesh & mesh, const vec3f & coord)
+    {
+        return std::find(mesh.coord.begin(), mesh.coord.end(), coord)
+            != mesh.coord.end();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(geometry_is_compiled_when_the_world_is_loaded)
+{
+    test_resource_fetcher fetcher;
+    browser b(fetcher, std::cout, std::cerr);
+    b.mesh_compile_threads(4);
+    load(b, triangles);
+
+    BOOST_CHECK_EQUAL(b.compiled_meshes().size(), 2U);
+    const boost::shared_ptr<const compiled_mesh> mesh =
+        b.compiled_meshes().find(find_geometry(b, "F"));
+    BOOST_REQUIRE(mesh);
+    BOOST_CHECK(has_coord(*mesh, make_vec3f(1, 0, 0)));
+}
+
+BOOST_AUTO_TEST_CASE(geometry_is_left_to_the_viewer_without_threads)
+{
+    test_resource_fetcher fetcher;
+    browser b(fetcher, std::cout, std::cerr);
+    b.mesh_compile_threads(0);
+    load(b, triangles);
+
+    BOOST_CHECK_EQUAL(b.compiled_meshes().size(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(geometry_modified_after_compilation_is_compiled_again)
+{
+    mesh_viewer v;
+    test_resource_fetcher fetcher;
+    browser b(fetcher, std::cout, std::cerr);
+    b.mesh_compile_threads(4);
+    b.viewer(&v);
+    load(b, triangles);
+
+    geometry_node & f = find_geometry(b, "F");
+    const boost::shared_ptr<const compiled_mesh> stale =
+        b.compiled_meshes().find(f);
+    BOOST_REQUIRE(stale);
+
+    vector<vec3f> point;
+    point.push_back(make_vec3f(0, 0, 0));
+    point.push_back(make_vec3f(2, 0, 0));
+    point.push_back(make_vec3f(0, 2, 0));
+    find_node(b, "C").event_listener<mfvec3f>("set_point")
+        .process_event(mfvec3f(point), browser::current_time());
+    BOOST_REQUIRE(f.modified());
+
+    b.render();
+    b.viewer(0);
+
+    BOOST_REQUIRE_EQUAL(v.meshes.count("F"), 1U);
+    BOOST_CHECK(has_coord(v.meshes["F"], make_vec3f(2, 0, 0)));
+    BOOST_CHECK(!has_coord(v.meshes["F"], make_vec3f(1, 0, 0)));
+
+    const boost::shared_ptr<const compiled_mesh> mesh =
+        b.compiled_meshes().find(f);
+    BOOST_REQUIRE(mesh);
+    BOOST_CHECK(mesh != stale);
+    BOOST_CHECK(has_coord(*mesh, make_vec3f(2, 0, 0)));
+
+    //
+    // The geometry that was not changed is drawn with the mesh compiled for
+    // it.
+    //
+    BOOST_REQUIRE_EQUAL(v.meshes.count("G"), 1U);
+    BOOST_CHECK(has_coord(v.meshes["G"], make_vec3f(0, 0, 1)));
+}
+
+BOOST_AUTO_TEST_CASE(normals_of_a_large_mesh_are_generated)
+{
+    //
+    // A single node is compiled on the loading thread, and its normals are
+    // generated with the help of the browser's compute threads.
+    //
+    static const int32 n = 100;
+    ostringstream vrml;
+    vrml << "#VRML V2.0 utf8\n"
+         << "Shape {\n"
+         << "  geometry DEF F IndexedFaceSet {\n"
+         << "    creaseAngle 1\n"
+         << "    coord Coordinate { point [\n";
+    for (int32 j = 0; j < n; ++j) {
+        for (int32 i = 0; i < n; ++i) {
+            vrml << i << " 0 " << j << ",\n";
+        }
+    }
+    vrml << "    ] }\n"
+         << "    coordIndex [\n";
+    for (int32 j = 0; j < n - 1; ++j) {
+        for (int32 i = 0; i < n - 1; ++i) {
+            vrml << j * n + i << ' ' << (j + 1) * n + i << ' '
+                 << (j + 1) * n + i + 1 << ' ' << j * n + i + 1 << " -1\n";
+        }
+    }
+    vrml << "    ]\n"
+         << "  }\n"
+         << "}\n";
+
+    test_resource_fetcher fetcher;
+    browser b(fetcher, std::cout, std::cerr);
+    b.mesh_compile_threads(4);
+    load(b, vrml.str());
+
+    const boost::shared_ptr<const compiled_mesh> mesh =
+        b.compiled_meshes().find(find_geometry(b, "F"));
+    BOOST_REQUIRE(mesh);
+    BOOST_REQUIRE(!mesh->normal.empty());
+    for (size_t i = 0; i < mesh->normal.size(); ++i) {
+        BOOST_REQUIRE(mesh->normal[i] == make_vec3f(0, 1, 0));
+    }
+}
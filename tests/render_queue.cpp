@@ -0,0 +1,274 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+//
+// browser::render queues the geometry in draw_mode and submits it sorted by
+// rendering state.  The viewer here records the material, texture and mesh
+// calls that reach it, in order.
+//
+
+# define BOOST_TEST_MAIN
+# define BOOST_TEST_MODULE render_queue
+
+# include <sstream>
+# include <boost/test/unit_test.hpp>
+# include <openvrml/browser.h>
+# include <openvrml/compiled_mesh.h>
+# include "string_resource_istream.h"
+# include "test_resource_fetcher.h"
+# include "test_viewer.h"
+
+using namespace std;
+using namespace openvrml;
+
+namespace {
+
+    const char url[] = "file:///render-queue-test.wrl";
+
+    //
+    // Records "material <red>", "texture <id>" and "mesh <id>" for the
+    // calls of the same names, where <id> is the node's DEF name.  Geometry
+    // inserted other than as a mesh is recorded as "node <id>".
+    //
+    class recording_viewer : public test_viewer {
+    public:
+        std::vector<std::string> calls;
+
+        virtual ~recording_viewer() throw ()
+        {}
+
+    private:
+        void record(const std::string & call, const node & n)
+        {
+            this->calls.push_back(call + ' ' + n.id());
+        }
+
+        virtual bounding_volume::intersection
+        do_intersect_view_volume(const bounding_volume &) const
+        {
+            return bounding_volume::inside;
+        }
+
+        virtual void do_set_material(float,
+                                     const openvrml::color & diffuse_color,
+                                     const openvrml::color &,
+                                     float,
+                                     const openvrml::color &,
+                                     float)
+        {
+            ostringstream call;
+            call << "material " << diffuse_color.r();
+            this->calls.push_back(call.str());
+        }
+
+        virtual void do_insert_texture(const texture_node & n, bool)
+        {
+            this->record("texture", n);
+        }
+
+        virtual void do_insert_mesh(const geometry_node & n,
+                                    const compiled_mesh &)
+        {
+            this->record("mesh", n);
+        }
+
+        virtual void do_insert_box(const geometry_node & n, const vec3f &)
+        {
+            this->record("node", n);
+        }
+
+        virtual void do_insert_sphere(const geometry_node & n, float)
+        {
+            this->record("node", n);
+        }
+
+        virtual void
+        do_insert_shell(const geometry_node & n,
+                        unsigned int,
+                        const std::vector<vec3f> &,
+                        const std::vector<int32> &,
+                        const std::vector<openvrml::color> &,
+                        const std::vector<int32> &,
+                        const std::vector<vec3f> &,
+                        const std::vector<int32> &,
+                        const std::vector<vec2f> &,
+                        const std::vector<int32> &)
+        {
+            this->record("node", n);
+        }
+    };
+
+    //
+    // Draw the world in vrml and return the calls recorded.
+    //
+    const std::vector<std::string> render(const std::string & vrml,
+                                          const size_t frames = 1)
+    {
+        recording_viewer v;
+        test_resource_fetcher fetcher;
+        browser b(fetcher, std::cout, std::cerr);
+        b.viewer(&v);
+        string_resource_istream in(url, vrml);
+        b.set_world(in);
+        for (size_t i = 0; i < frames; ++i) { b.render(); }
+        b.viewer(0);
+        return v.calls;
+    }
+
+    const std::vector<std::string> calls(const char * const expected[],
+                                         const size_t size)
+    {
+        return std::vector<std::string>(expected, expected + size);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(opaque_geometry_is_grouped_by_material)
+{
+    const std::vector<std::string> drawn = render(
+        "#VRML V2.0 utf8\n"
+        "Shape {\n"
+        "  appearance Appearance {"
+        " material DEF M0 Material { diffuseColor 0.25 0 0 } }\n"
+        "  geometry DEF A Box {}\n"
+        "}\n"
+        "Shape {\n"
+        "  appearance Appearance {"
+        " material DEF M1 Material { diffuseColor 0.75 0 0 } }\n"
+        "  geometry DEF B Sphere {}\n"
+        "}\n"
+        "Shape {\n"
+        "  appearance Appearance { material USE M0 }\n"
+        "  geometry DEF C Sphere {}\n"
+        "}\n"
+        "Shape {\n"
+        "  appearance Appearance { material USE M1 }\n"
+        "  geometry DEF D Box {}\n"
+        "}\n");
+
+    static const char * const expected[] = {
+        "material 0.25", "mesh A", "mesh C",
+        "material 0.75", "mesh B", "mesh D"
+    };
+    BOOST_CHECK(drawn == calls(expected, 6));
+}
+
+BOOST_AUTO_TEST_CASE(transparent_geometry_is_drawn_last_back_to_front)
+{
+    const std::vector<std::string> drawn = render(
+        "#VRML V2.0 utf8\n"
+        "Transform { translation 0 0 5 children Shape {\n"
+        "  appearance Appearance {"
+        " material DEF NEAR Material {"
+        " diffuseColor 0.5 0 0 transparency 0.5 } }\n"
+        "  geometry DEF N Sphere {}\n"
+        "} }\n"
+        "Shape {\n"
+        "  appearance Appearance {"
+        " material DEF OPAQUE Material { diffuseColor 1 0 0 } }\n"
+        "  geometry DEF O Box {}\n"
+        "}\n"
+        "Transform { translation 0 0 -5 children Shape {\n"
+        "  appearance Appearance {"
+        " material DEF FAR Material {"
+        " diffuseColor 0.25 0 0 transparency 0.5 } }\n"
+        "  geometry DEF F Sphere {}\n"
+        "} }\n");
+
+    static const char * const expected[] = {
+        "material 1", "mesh O",
+        "material 0.25", "mesh F",
+        "material 0.5", "mesh N"
+    };
+    BOOST_CHECK(drawn == calls(expected, 6));
+}
+
+BOOST_AUTO_TEST_CASE(textured_geometry_is_grouped_by_texture)
+{
+    const std::vector<std::string> drawn = render(
+        "#VRML V2.0 utf8\n"
+        "DEF M Material { diffuseColor 0.5 0 0 }\n"
+        "Shape {\n"
+        "  appearance Appearance {\n"
+        "    material USE M\n"
+        "    texture DEF T0 PixelTexture { image 1 1 3 0xFF0000 }\n"
+        "  }\n"
+        "  geometry DEF A Box {}\n"
+        "}\n"
+        "Shape {\n"
+        "  appearance Appearance {\n"
+        "    material USE M\n"
+        "    texture DEF T1 PixelTexture { image 1 1 3 0x00FF00 }\n"
+        "  }\n"
+        "  geometry DEF B Box {}\n"
+        "}\n"
+        "Shape {\n"
+        "  appearance Appearance { material USE M texture USE T0 }\n"
+        "  geometry DEF C Sphere {}\n"
+        "}\n"
+        "Shape {\n"
+        "  appearance Appearance { material USE M texture USE T1 }\n"
+        "  geometry DEF D Sphere {}\n"
+        "}\n");
+
+    //
+    // The two textures are grouped in the order of their images' addresses.
+    // Both are RGB, so they replace the diffuse color of the Material with
+    // white.
+    //
+    BOOST_REQUIRE_EQUAL(drawn.size(), 7U);
+    BOOST_CHECK_EQUAL(drawn[0], "material 1");
+    BOOST_CHECK(drawn[1] == "texture T0" || drawn[1] == "texture T1");
+    const bool t0_first = drawn[1] == "texture T0";
+    static const char * const t0[] = { "mesh A", "mesh C" };
+    static const char * const t1[] = { "mesh B", "mesh D" };
+    const std::vector<std::string> first(drawn.begin() + 2,
+                                         drawn.begin() + 4);
+    const std::vector<std::string> second(drawn.begin() + 5, drawn.end());
+    BOOST_CHECK(first == calls(t0_first ? t0 : t1, 2));
+    BOOST_CHECK_EQUAL(drawn[4], t0_first ? "texture T1" : "texture T0");
+    BOOST_CHECK(second == calls(t0_first ? t1 : t0, 2));
+}
+
+BOOST_AUTO_TEST_CASE(recorded_meshes_are_replayed)
+{
+    //
+    // The geometry reaches the viewer only as the meshes the queue recorded;
+    // the nodes are not rendered to it again.  A second frame draws the same.
+    //
+    const std::vector<std::string> drawn = render(
+        "#VRML V2.0 utf8\n"
+        "Shape {\n"
+        "  appearance Appearance {"
+        " material DEF M Material { diffuseColor 0.5 0 0 } }\n"
+        "  geometry DEF A Box {}\n"
+        "}\n"
+        "Shape {\n"
+        "  appearance Appearance { material USE M }\n"
+        "  geometry DEF B IndexedFaceSet {\n"
+        "    coord Coordinate { point [ 0 0 0, 1 0 0, 1 1 0 ] }\n"
+        "    coordIndex [ 0 1 2 -1 ]\n"
+        "  }\n"
+        "}\n",
+        2);
+
+    static const char * const expected[] = {
+        "material 0.5", "mesh A", "mesh B",
+        "material 0.5", "mesh A", "mesh B"
+    };
+    BOOST_CHECK(drawn == calls(expected, 6));
+}
@@ -0,0 +1,216 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# define BOOST_TEST_MAIN
+# define BOOST_TEST_MODULE resource_cache
+
+# include <boost/test/unit_test.hpp>
+# include <boost/bind.hpp>
+# include <boost/ptr_container/ptr_vector.hpp>
+# include <boost/thread.hpp>
+# include <openvrml/browser.h>
+# include <iterator>
+# include <map>
+# include "string_resource_istream.h"
+
+using namespace openvrml;
+
+namespace {
+
+    //
+    // Serves the strings in resources, counting the fetches of each.
+    //
+    class counting_fetcher : public resource_fetcher {
+        boost::mutex mutex_;
+        std::map<std::string, size_t> fetches_;
+
+    public:
+        std::map<std::string, std::string> resources;
+
+        virtual ~counting_fetcher() throw ()
+        {}
+
+        size_t fetches(const std::string & uri)
+        {
+            boost::mutex::scoped_lock lock(this->mutex_);
+            return this->fetches_[uri];
+        }
+
+    private:
+        virtual std::auto_ptr<resource_istream>
+        do_get_resource(const std::string & uri)
+        {
+            {
+                boost::mutex::scoped_lock lock(this->mutex_);
+                ++this->fetches_[uri];
+            }
+            return std::auto_ptr<resource_istream>(
+                new string_resource_istream(uri, this->resources[uri]));
+        }
+    };
+
+    const std::string read_all(resource_istream & in)
+    {
+        return std::string(std::istreambuf_iterator<char>(in),
+                           std::istreambuf_iterator<char>());
+    }
+
+    const std::string get(resource_fetcher & fetcher, const std::string & uri)
+    {
+        std::auto_ptr<resource_istream> in = fetcher.get_resource(uri);
+        BOOST_REQUIRE(in.get());
+        return read_all(*in);
+    }
+
+    void read_into(resource_istream & in, std::string & result)
+    {
+        result = read_all(in);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(hit)
+{
+    counting_fetcher fetcher;
+    fetcher.resources["http://example.com/a"] = "aaaa";
+    resource_cache cache(fetcher);
+
+    BOOST_CHECK_EQUAL(get(cache, "http://example.com/a"), "aaaa");
+    BOOST_CHECK_EQUAL(get(cache, "http://example.com/a"), "aaaa");
+    BOOST_CHECK_EQUAL(fetcher.fetches("http://example.com/a"), 1U);
+    BOOST_CHECK_EQUAL(cache.size(), 4U);
+}
+
+BOOST_AUTO_TEST_CASE(miss)
+{
+    counting_fetcher fetcher;
+    fetcher.resources["http://example.com/a"] = "aaaa";
+    fetcher.resources["http://example.com/b"] = "bbbbbb";
+    resource_cache cache(fetcher);
+
+    BOOST_CHECK_EQUAL(get(cache, "http://example.com/a"), "aaaa");
+    BOOST_CHECK_EQUAL(get(cache, "http://example.com/b"), "bbbbbb");
+    BOOST_CHECK_EQUAL(fetcher.fetches("http://example.com/a"), 1U);
+    BOOST_CHECK_EQUAL(fetcher.fetches("http://example.com/b"), 1U);
+    BOOST_CHECK_EQUAL(cache.size(), 10U);
+
+    cache.clear();
+    BOOST_CHECK_EQUAL(cache.size(), 0U);
+    BOOST_CHECK_EQUAL(get(cache, "http://example.com/a"), "aaaa");
+    BOOST_CHECK_EQUAL(fetcher.fetches("http://example.com/a"), 2U);
+}
+
+BOOST_AUTO_TEST_CASE(identical_content_is_counted_once)
+{
+    counting_fetcher fetcher;
+    fetcher.resources["http://example.com/a"] = "same";
+    fetcher.resources["http://example.com/b"] = "same";
+    resource_cache cache(fetcher);
+
+    get(cache, "http://example.com/a");
+    get(cache, "http://example.com/b");
+    BOOST_CHECK_EQUAL(cache.size(), 4U);
+
+    //
+    // Dropping one URI leaves the buffer in use by the other.
+    //
+    cache.budget(4);
+    BOOST_CHECK_EQUAL(cache.size(), 4U);
+    BOOST_CHECK_EQUAL(get(cache, "http://example.com/b"), "same");
+    BOOST_CHECK_EQUAL(fetcher.fetches("http://example.com/b"), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(eviction)
+{
+    counting_fetcher fetcher;
+    fetcher.resources["http://example.com/a"] = "aaaa";
+    fetcher.resources["http://example.com/b"] = "bbbb";
+    fetcher.resources["http://example.com/c"] = "cccc";
+    resource_cache cache(fetcher, 8);
+
+    get(cache, "http://example.com/a");
+    get(cache, "http://example.com/b");
+    get(cache, "http://example.com/a");  // b is now least recently used.
+    get(cache, "http://example.com/c");
+    BOOST_CHECK_EQUAL(cache.size(), 8U);
+
+    get(cache, "http://example.com/a");
+    get(cache, "http://example.com/c");
+    BOOST_CHECK_EQUAL(fetcher.fetches("http://example.com/a"), 1U);
+    BOOST_CHECK_EQUAL(fetcher.fetches("http://example.com/c"), 1U);
+
+    BOOST_CHECK_EQUAL(get(cache, "http://example.com/b"), "bbbb");
+    BOOST_CHECK_EQUAL(fetcher.fetches("http://example.com/b"), 2U);
+    BOOST_CHECK(cache.size() <= 8U);
+}
+
+BOOST_AUTO_TEST_CASE(resource_over_budget_is_not_cached)
+{
+    counting_fetcher fetcher;
+    const std::string big(200 * 1024, 'x');
+    fetcher.resources["http://example.com/big"] = big;
+    resource_cache cache(fetcher, 100 * 1024);
+
+    std::auto_ptr<resource_istream> first =
+        cache.get_resource("http://example.com/big");
+    std::auto_ptr<resource_istream> second =
+        cache.get_resource("http://example.com/big");
+    BOOST_CHECK(read_all(*first) == big);
+    BOOST_CHECK(read_all(*second) == big);
+    BOOST_CHECK_EQUAL(cache.size(), 0U);
+
+    BOOST_CHECK(get(cache, "http://example.com/big") == big);
+    BOOST_CHECK_EQUAL(fetcher.fetches("http://example.com/big"), 3U);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_access)
+{
+    counting_fetcher fetcher;
+    std::string data;
+    for (size_t i = 0; i < 300 * 1024; ++i) {
+        data.push_back(char('a' + i % 26));
+    }
+    fetcher.resources["http://example.com/a"] = data;
+    resource_cache cache(fetcher);
+
+    //
+    // The first stream does the fetching; the others read what it fetches
+    // as it arrives.
+    //
+    std::auto_ptr<resource_istream> first =
+        cache.get_resource("http://example.com/a");
+    boost::ptr_vector<resource_istream> others;
+    for (size_t i = 0; i < 8; ++i) {
+        others.push_back(cache.get_resource("http://example.com/a"));
+    }
+
+    std::vector<std::string> results(others.size());
+    boost::thread_group readers;
+    for (size_t i = 0; i < others.size(); ++i) {
+        readers.create_thread(boost::bind(read_into,
+                                          boost::ref(others[i]),
+                                          boost::ref(results[i])));
+    }
+    BOOST_CHECK(read_all(*first) == data);
+    readers.join_all();
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        BOOST_CHECK(results[i] == data);
+    }
+    BOOST_CHECK_EQUAL(fetcher.fetches("http://example.com/a"), 1U);
+    BOOST_CHECK_EQUAL(cache.size(), data.size());
+}
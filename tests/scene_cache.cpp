@@ -0,0 +1,125 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# define BOOST_TEST_MAIN
+# define BOOST_TEST_MODULE scene_cache
+
+# include <cstdlib>
+# include <fstream>
+# include <iostream>
+# include <iterator>
+# include <sstream>
+# include <boost/filesystem/operations.hpp>
+# include <boost/next_prior.hpp>
+# include <boost/scope_exit.hpp>
+# include <boost/test/unit_test.hpp>
+# include <openvrml/scene.h>
+# include "string_resource_istream.h"
+# include "test_resource_fetcher.h"
+
+using namespace std;
+using namespace openvrml;
+
+namespace {
+
+    const char url[] = "file:///scene-cache-test.wrl";
+
+    //
+    // A world big enough to be cached; the last Transform is translated by
+    // last_x.
+    //
+    const std::string world(const int last_x)
+    {
+        ostringstream vrml;
+        vrml << "#VRML V2.0 utf8\n"
+             << "DEF B Box { size 1 2 3 }\n";
+        for (size_t i = 0; i < 2000; ++i) {
+            vrml << "Transform { translation " << i << " 0 0"
+                 << " children Shape { geometry USE B } }\n";
+        }
+        vrml << "Transform { translation " << last_x << " 0 0 }\n";
+        return vrml.str();
+    }
+
+    //
+    // Load str and return the x translation of its last node.
+    //
+    float load(const std::string & str, size_t & node_count)
+    {
+        test_resource_fetcher fetcher;
+        browser b(fetcher, std::cout, std::cerr);
+        string_resource_istream in(url, str);
+        b.set_world(in);
+        BOOST_REQUIRE(b.root_scene());
+        const std::vector<boost::intrusive_ptr<node> > nodes =
+            b.root_scene()->nodes();
+        node_count = nodes.size();
+        BOOST_REQUIRE(!nodes.empty());
+        return nodes.back()->field<sfvec3f>("translation").value().x();
+    }
+
+    const std::string cache_file(const boost::filesystem::path & dir)
+    {
+        using boost::filesystem::directory_iterator;
+        const directory_iterator file(dir);
+        BOOST_REQUIRE(file != directory_iterator());
+        BOOST_CHECK(boost::next(file) == directory_iterator());
+        std::ifstream in(file->path().string().c_str(),
+                         std::ios_base::in | std::ios_base::binary);
+        return std::string(std::istreambuf_iterator<char>(in),
+                           std::istreambuf_iterator<char>());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(round_trip_and_invalidation)
+{
+    namespace fs = boost::filesystem;
+    const fs::path dir =
+        fs::temp_directory_path() / fs::unique_path("ovsc-%%%%-%%%%");
+    fs::create_directories(dir);
+    BOOST_SCOPE_EXIT((&dir)) {
+        fs::remove_all(dir);
+    } BOOST_SCOPE_EXIT_END
+    BOOST_REQUIRE(setenv("OPENVRML_SCENE_CACHE", dir.string().c_str(), 1)
+                  == 0);
+
+    size_t parsed_count = 0, replayed_count = 0;
+
+    //
+    // The first load parses the stream and records it; the second replays
+    // the recording.
+    //
+    BOOST_CHECK_EQUAL(load(world(7), parsed_count), 7.0f);
+    const std::string recorded = cache_file(dir);
+    BOOST_CHECK(!recorded.empty());
+
+    BOOST_CHECK_EQUAL(load(world(7), replayed_count), 7.0f);
+    BOOST_CHECK_EQUAL(replayed_count, parsed_count);
+    BOOST_CHECK(cache_file(dir) == recorded);
+
+    //
+    // Changed content under the same URI must not be replayed from the old
+    // recording; it is parsed and recorded afresh.
+    //
+    BOOST_CHECK_EQUAL(load(world(9), replayed_count), 9.0f);
+    BOOST_CHECK_EQUAL(replayed_count, parsed_count);
+    BOOST_CHECK(cache_file(dir) != recorded);
+    BOOST_CHECK_EQUAL(load(world(9), replayed_count), 9.0f);
+
+    unsetenv("OPENVRML_SCENE_CACHE");
+}
@@ -0,0 +1,44 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# include "string_resource_istream.h"
+
+string_resource_istream::string_resource_istream(const std::string & url,
+                                                 const std::string & str):
+    openvrml::resource_istream(&this->buf_),
+    url_(url),
+    buf_(str)
+{}
+
+string_resource_istream::~string_resource_istream() throw ()
+{}
+
+const std::string string_resource_istream::do_url() const throw ()
+{
+    return this->url_;
+}
+
+const std::string string_resource_istream::do_type() const throw ()
+{
+    return openvrml::vrml_media_type;
+}
+
+bool string_resource_istream::do_data_available() const throw ()
+{
+    return !!(*this);
+}
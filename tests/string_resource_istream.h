@@ -0,0 +1,42 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# ifndef STRING_RESOURCE_ISTREAM
+#   define STRING_RESOURCE_ISTREAM
+
+#   include <sstream>
+#   include <openvrml/browser.h>
+
+//
+// A VRML resource read from a string.
+//
+class string_resource_istream : public openvrml::resource_istream {
+    const std::string url_;
+    std::stringbuf buf_;
+
+public:
+    string_resource_istream(const std::string & url, const std::string & str);
+    virtual ~string_resource_istream() throw ();
+
+private:
+    virtual const std::string do_url() const throw ();
+    virtual const std::string do_type() const throw ();
+    virtual bool do_data_available() const throw ();
+};
+
+# endif
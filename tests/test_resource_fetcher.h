@@ -21,10 +21,9 @@
 
 #   include <openvrml/browser.h>
 
-class test_resource_fetcher : public openvrml::resource_fetcher {
-private:
-    virtual std::auto_ptr<openvrml::resource_istream>
-    do_get_resource(const std::string & uri);
+class test_resource_fetcher : public openvrml::file_resource_fetcher {
+public:
+    virtual ~test_resource_fetcher() throw ();
 };
 
 # endif
@@ -0,0 +1,212 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# include "test_viewer.h"
+
+test_viewer::test_viewer():
+    rendering(draw_mode)
+{}
+
+test_viewer::~test_viewer() throw ()
+{}
+
+test_viewer::rendering_mode test_viewer::do_mode()
+{
+    return this->rendering;
+}
+
+double test_viewer::do_frame_rate()
+{
+    return 0.0;
+}
+
+void test_viewer::do_reset_user_navigation()
+{}
+
+void test_viewer::do_begin_object(const char *, bool)
+{}
+
+void test_viewer::do_end_object()
+{}
+
+void test_viewer::do_insert_background(const openvrml::background_node &)
+{}
+
+void
+test_viewer::do_insert_box(const openvrml::geometry_node &,
+                           const openvrml::vec3f &)
+{}
+
+void
+test_viewer::do_insert_cone(const openvrml::geometry_node &,
+                            float,
+                            float,
+                            bool,
+                            bool)
+{}
+
+void
+test_viewer::do_insert_cylinder(const openvrml::geometry_node &,
+                                float,
+                                float,
+                                bool,
+                                bool,
+                                bool)
+{}
+
+void
+test_viewer::do_insert_elevation_grid(const openvrml::geometry_node &,
+                                      unsigned int,
+                                      const std::vector<float> &,
+                                      openvrml::int32,
+                                      openvrml::int32,
+                                      float,
+                                      float,
+                                      const std::vector<openvrml::color> &,
+                                      const std::vector<openvrml::vec3f> &,
+                                      const std::vector<openvrml::vec2f> &)
+{}
+
+void
+test_viewer::do_insert_extrusion(const openvrml::geometry_node &,
+                                 unsigned int,
+                                 const std::vector<openvrml::vec3f> &,
+                                 const std::vector<openvrml::vec2f> &,
+                                 const std::vector<openvrml::rotation> &,
+                                 const std::vector<openvrml::vec2f> &)
+{}
+
+void
+test_viewer::do_insert_line_set(const openvrml::geometry_node &,
+                                const std::vector<openvrml::vec3f> &,
+                                const std::vector<openvrml::int32> &,
+                                bool,
+                                const std::vector<openvrml::color> &,
+                                const std::vector<openvrml::int32> &)
+{}
+
+void
+test_viewer::do_insert_point_set(const openvrml::geometry_node &,
+                                 const std::vector<openvrml::vec3f> &,
+                                 const std::vector<openvrml::color> &)
+{}
+
+void
+test_viewer::do_insert_shell(const openvrml::geometry_node &,
+                             unsigned int,
+                             const std::vector<openvrml::vec3f> &,
+                             const std::vector<openvrml::int32> &,
+                             const std::vector<openvrml::color> &,
+                             const std::vector<openvrml::int32> &,
+                             const std::vector<openvrml::vec3f> &,
+                             const std::vector<openvrml::int32> &,
+                             const std::vector<openvrml::vec2f> &,
+                             const std::vector<openvrml::int32> &)
+{}
+
+void test_viewer::do_insert_sphere(const openvrml::geometry_node &, float)
+{}
+
+void
+test_viewer::do_insert_dir_light(float,
+                                 float,
+                                 const openvrml::color &,
+                                 const openvrml::vec3f &)
+{}
+
+void
+test_viewer::do_insert_point_light(float,
+                                   const openvrml::vec3f &,
+                                   const openvrml::color &,
+                                   float,
+                                   const openvrml::vec3f &,
+                                   float)
+{}
+
+void
+test_viewer::do_insert_spot_light(float,
+                                  const openvrml::vec3f &,
+                                  float,
+                                  const openvrml::color &,
+                                  float,
+                                  const openvrml::vec3f &,
+                                  float,
+                                  const openvrml::vec3f &,
+                                  float)
+{}
+
+void test_viewer::do_remove_object(const openvrml::node &)
+{}
+
+void test_viewer::do_enable_lighting(bool)
+{}
+
+void test_viewer::do_set_fog(const openvrml::color &, float, const char *)
+{}
+
+void test_viewer::do_set_color(const openvrml::color &, float)
+{}
+
+void
+test_viewer::do_set_material(float,
+                             const openvrml::color &,
+                             const openvrml::color &,
+                             float,
+                             const openvrml::color &,
+                             float)
+{}
+
+void test_viewer::do_set_material_mode(size_t, bool)
+{}
+
+void test_viewer::do_set_sensitive(openvrml::node *)
+{}
+
+void test_viewer::do_insert_texture(const openvrml::texture_node &, bool)
+{}
+
+void test_viewer::do_remove_texture_object(const openvrml::texture_node &)
+{}
+
+void
+test_viewer::do_set_texture_transform(const openvrml::vec2f &,
+                                      float,
+                                      const openvrml::vec2f &,
+                                      const openvrml::vec2f &)
+{}
+
+void test_viewer::do_set_frustum(float, float, float)
+{}
+
+void
+test_viewer::do_set_viewpoint(const openvrml::vec3f &,
+                              const openvrml::rotation &,
+                              float,
+                              float)
+{}
+
+void test_viewer::do_transform(const openvrml::mat4f &)
+{}
+
+void test_viewer::do_transform_points(size_t, openvrml::vec3f *) const
+{}
+
+void
+test_viewer::do_draw_bounding_sphere(const openvrml::bounding_sphere &,
+                                     openvrml::bounding_volume::intersection)
+{}
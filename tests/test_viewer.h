@@ -0,0 +1,156 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# ifndef TEST_VIEWER
+#   define TEST_VIEWER
+
+#   include <openvrml/viewer.h>
+
+//
+// Draws nothing.  The rendering mode is that of the rendering member; it is
+// draw_mode unless changed.
+//
+class test_viewer : public openvrml::viewer {
+public:
+    rendering_mode rendering;
+
+    test_viewer();
+    virtual ~test_viewer() throw ();
+
+protected:
+    virtual rendering_mode do_mode();
+    virtual double do_frame_rate();
+    virtual void do_reset_user_navigation();
+    virtual void do_begin_object(const char * id, bool retain);
+    virtual void do_end_object();
+    virtual void do_insert_background(const openvrml::background_node & n);
+    virtual void do_insert_box(const openvrml::geometry_node & n,
+                               const openvrml::vec3f & size);
+    virtual void do_insert_cone(const openvrml::geometry_node & n,
+                                float height,
+                                float radius,
+                                bool bottom,
+                                bool side);
+    virtual void do_insert_cylinder(const openvrml::geometry_node & n,
+                                    float height,
+                                    float radius,
+                                    bool bottom,
+                                    bool side,
+                                    bool top);
+    virtual void
+    do_insert_elevation_grid(const openvrml::geometry_node & n,
+                             unsigned int mask,
+                             const std::vector<float> & height,
+                             openvrml::int32 x_dimension,
+                             openvrml::int32 z_dimension,
+                             float x_spacing,
+                             float z_spacing,
+                             const std::vector<openvrml::color> & color,
+                             const std::vector<openvrml::vec3f> & normal,
+                             const std::vector<openvrml::vec2f> & tex_coord);
+    virtual void
+    do_insert_extrusion(const openvrml::geometry_node & n,
+                        unsigned int mask,
+                        const std::vector<openvrml::vec3f> & spine,
+                        const std::vector<openvrml::vec2f> & cross_section,
+                        const std::vector<openvrml::rotation> & orientation,
+                        const std::vector<openvrml::vec2f> & scale);
+    virtual void
+    do_insert_line_set(const openvrml::geometry_node & n,
+                       const std::vector<openvrml::vec3f> & coord,
+                       const std::vector<openvrml::int32> & coord_index,
+                       bool color_per_vertex,
+                       const std::vector<openvrml::color> & color,
+                       const std::vector<openvrml::int32> & color_index);
+    virtual void
+    do_insert_point_set(const openvrml::geometry_node & n,
+                        const std::vector<openvrml::vec3f> & coord,
+                        const std::vector<openvrml::color> & color);
+    virtual void
+    do_insert_shell(const openvrml::geometry_node & n,
+                    unsigned int mask,
+                    const std::vector<openvrml::vec3f> & coord,
+                    const std::vector<openvrml::int32> & coord_index,
+                    const std::vector<openvrml::color> & color,
+                    const std::vector<openvrml::int32> & color_index,
+                    const std::vector<openvrml::vec3f> & normal,
+                    const std::vector<openvrml::int32> & normal_index,
+                    const std::vector<openvrml::vec2f> & tex_coord,
+                    const std::vector<openvrml::int32> & tex_coord_index);
+    virtual void do_insert_sphere(const openvrml::geometry_node & n,
+                                  float radius);
+    virtual void do_insert_dir_light(float ambient_intensity,
+                                     float intensity,
+                                     const openvrml::color & color,
+                                     const openvrml::vec3f & direction);
+    virtual void do_insert_point_light(float ambient_intensity,
+                                       const openvrml::vec3f & attenuation,
+                                       const openvrml::color & color,
+                                       float intensity,
+                                       const openvrml::vec3f & location,
+                                       float radius);
+    virtual void do_insert_spot_light(float ambient_intensity,
+                                      const openvrml::vec3f & attenuation,
+                                      float beam_width,
+                                      const openvrml::color & color,
+                                      float cut_off_angle,
+                                      const openvrml::vec3f & direction,
+                                      float intensity,
+                                      const openvrml::vec3f & location,
+                                      float radius);
+    virtual void do_remove_object(const openvrml::node & ref);
+    virtual void do_enable_lighting(bool val);
+    virtual void do_set_fog(const openvrml::color & color,
+                            float visibility_range,
+                            const char * type);
+    virtual void do_set_color(const openvrml::color & rgb, float a);
+    virtual void do_set_material(float ambient_intensity,
+                                 const openvrml::color & diffuse_color,
+                                 const openvrml::color & emissive_color,
+                                 float shininess,
+                                 const openvrml::color & specular_color,
+                                 float transparency);
+    virtual void do_set_material_mode(size_t tex_components,
+                                      bool geometry_color);
+    virtual void do_set_sensitive(openvrml::node * object);
+    virtual void do_insert_texture(const openvrml::texture_node & n,
+                                   bool retain);
+    virtual void
+    do_remove_texture_object(const openvrml::texture_node & ref);
+    virtual void
+    do_set_texture_transform(const openvrml::vec2f & center,
+                             float rotation,
+                             const openvrml::vec2f & scale,
+                             const openvrml::vec2f & translation);
+    virtual void do_set_frustum(float field_of_view,
+                                float avatar_size,
+                                float visibility_limit);
+    virtual void do_set_viewpoint(const openvrml::vec3f & position,
+                                  const openvrml::rotation & orientation,
+                                  float avatar_size,
+                                  float visibility_limit);
+    virtual void do_transform(const openvrml::mat4f & mat);
+    virtual void do_transform_points(size_t nPoints,
+                                     openvrml::vec3f * point) const;
+    virtual void
+    do_draw_bounding_sphere(const openvrml::bounding_sphere & bs,
+                            openvrml::bounding_volume::intersection
+                            intersection);
+};
+
+# endif
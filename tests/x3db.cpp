@@ -0,0 +1,766 @@
+// -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 4; fill-column: 78 -*-
+//
+// Copyright 2012  Braden McDaniel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this library; if not, see <http://www.gnu.org/licenses/>.
+//
+
+# define BOOST_TEST_MAIN
+# define BOOST_TEST_MODULE x3db
+
+# ifdef HAVE_CONFIG_H
+#   include <config.h>
+# endif
+
+# include <boost/cstdint.hpp>
+# include <boost/test/unit_test.hpp>
+# include <openvrml/local/x3d_vocabulary.h>
+# include <algorithm>
+# include <cmath>
+# include <cstring>
+# include <iostream>
+# include <sstream>
+# include "test_resource_fetcher.h"
+
+# ifdef OPENVRML_ENABLE_GZIP
+#   include <zlib.h>
+# endif
+
+using namespace std;
+using namespace openvrml;
+
+namespace {
+
+    //
+    // The built-in encoding algorithms of ISO/IEC 24824-1, and the index of
+    // the first one in the document's encoding algorithm table.
+    //
+    enum algorithm {
+        short_algorithm = 2,
+        int_algorithm = 3,
+        long_algorithm = 4,
+        float_algorithm = 6,
+        double_algorithm = 7,
+        application_algorithm = 32
+    };
+
+    //
+    // An attribute value: literal UTF-8 text, or octets encoded with an
+    // encoding algorithm.
+    //
+    struct attribute_value {
+        static const size_t text = size_t(-1);
+
+        size_t algorithm;
+        string octets;
+
+        attribute_value(const char * const text):
+            algorithm(attribute_value::text),
+            octets(text)
+        {}
+
+        attribute_value(const size_t algorithm, const string & octets):
+            algorithm(algorithm),
+            octets(octets)
+        {}
+    };
+
+    struct element {
+        typedef vector<pair<string, attribute_value> > attribute_list;
+
+        string name;
+        attribute_list attributes;
+        vector<element> children;
+
+        explicit element(const string & name):
+            name(name)
+        {}
+
+        element & attribute(const string & name,
+                            const attribute_value & value)
+        {
+            this->attributes.push_back(make_pair(name, value));
+            return *this;
+        }
+
+        element & child(const element & e)
+        {
+            this->children.push_back(e);
+            return *this;
+        }
+    };
+
+    //
+    // Encodes a document as Fast Infoset, the way an X3D encoder would:
+    // names are written as indices into the name tables where they can be.
+    // Application encoding algorithms are listed in the initial vocabulary;
+    // the first is application_algorithm.
+    //
+    class fi_encoder {
+        string out_;
+        vector<string> element_names_;
+        vector<string> attribute_names_;
+
+    public:
+        explicit fi_encoder(const bool x3d_vocabulary,
+                            const vector<string> & algorithms =
+                            vector<string>())
+        {
+            using openvrml::local::x3d_element_names;
+            using openvrml::local::x3d_element_names_size;
+            using openvrml::local::x3d_attribute_names;
+            using openvrml::local::x3d_attribute_names_size;
+
+            static const char header[] = { '\xE0', '\x00', '\x00', '\x01' };
+            this->out_.assign(header, header + sizeof header);
+            if (!x3d_vocabulary && algorithms.empty()) {
+                this->out_ += '\x00';
+                return;
+            }
+            this->out_ += '\x20';
+            this->byte((x3d_vocabulary ? 0x10 : 0x00)
+                       | (algorithms.empty() ? 0x00 : 0x04));
+            this->out_ += '\x00';
+            if (x3d_vocabulary) {
+                this->literal(local::x3d_external_vocabulary_uri);
+                this->element_names_.assign(
+                    x3d_element_names,
+                    x3d_element_names + x3d_element_names_size);
+                this->attribute_names_.assign(
+                    x3d_attribute_names,
+                    x3d_attribute_names + x3d_attribute_names_size);
+            }
+            if (!algorithms.empty()) {
+                BOOST_REQUIRE(algorithms.size() <= 128);
+                this->byte(algorithms.size() - 1);
+                for (vector<string>::const_iterator uri = algorithms.begin();
+                     uri != algorithms.end();
+                     ++uri) {
+                    this->literal(*uri);
+                }
+            }
+        }
+
+        const string document(const element & root)
+        {
+            this->write(root);
+            this->out_ += '\xF0';
+            return this->out_;
+        }
+
+    private:
+        void byte(const size_t b)
+        {
+            this->out_ += char(b & 0xFF);
+        }
+
+        //
+        // A literal octet string starting on the second bit.
+        //
+        void literal(const string & s)
+        {
+            BOOST_REQUIRE(!s.empty() && s.size() <= 320);
+            if (s.size() <= 64) {
+                this->byte(s.size() - 1);
+            } else {
+                this->byte(0x40);
+                this->byte(s.size() - 65);
+            }
+            this->out_ += s;
+        }
+
+        //
+        // A length starting on the fifth bit, after the four bits in high.
+        //
+        void length(const size_t high, const size_t n)
+        {
+            BOOST_REQUIRE(n > 0);
+            if (n <= 8) {
+                this->byte(high | (n - 1));
+            } else if (n <= 264) {
+                this->byte(high | 0x08);
+                this->byte(n - 9);
+            } else {
+                this->byte(high | 0x0C);
+                for (int shift = 24; shift >= 0; shift -= 8) {
+                    this->byte((n - 265) >> shift);
+                }
+            }
+        }
+
+        //
+        // A literal non-identifying string that is not added to the
+        // attribute value table.
+        //
+        void value(const attribute_value & v)
+        {
+            if (v.algorithm == attribute_value::text) {
+                this->length(0x00, v.octets.size());
+            } else {
+                BOOST_REQUIRE(v.algorithm < 256);
+                this->byte(0x30 | (v.algorithm >> 4));
+                this->length((v.algorithm & 0x0F) << 4, v.octets.size());
+            }
+            this->out_ += v.octets;
+        }
+
+        void write(const element & e)
+        {
+            const size_t has_attributes = e.attributes.empty() ? 0x00 : 0x40;
+            const vector<string>::const_iterator name =
+                find(this->element_names_.begin(), this->element_names_.end(),
+                     e.name);
+            if (name != this->element_names_.end()) {
+                const size_t index = name - this->element_names_.begin();
+                if (index < 32) {
+                    this->byte(has_attributes | index);
+                } else {
+                    BOOST_REQUIRE(index < 2080);
+                    this->byte(has_attributes | 0x20 | ((index - 32) >> 8));
+                    this->byte(index - 32);
+                }
+            } else {
+                this->byte(has_attributes | 0x3C);
+                this->literal(e.name);
+                this->element_names_.push_back(e.name);
+            }
+
+            for (element::attribute_list::const_iterator attr =
+                     e.attributes.begin();
+                 attr != e.attributes.end();
+                 ++attr) {
+                const vector<string>::const_iterator name =
+                    find(this->attribute_names_.begin(),
+                         this->attribute_names_.end(),
+                         attr->first);
+                if (name != this->attribute_names_.end()) {
+                    const size_t index = name - this->attribute_names_.begin();
+                    if (index < 64) {
+                        this->byte(index);
+                    } else {
+                        BOOST_REQUIRE(index < 8256);
+                        this->byte(0x40 | ((index - 64) >> 8));
+                        this->byte(index - 64);
+                    }
+                } else {
+                    this->byte(0x78);
+                    this->literal(attr->first);
+                    this->attribute_names_.push_back(attr->first);
+                }
+                this->value(attr->second);
+            }
+            if (!e.attributes.empty()) { this->out_ += '\xF0'; }
+
+            for (vector<element>::const_iterator child = e.children.begin();
+                 child != e.children.end();
+                 ++child) {
+                this->write(*child);
+            }
+            this->out_ += '\xF0';
+        }
+    };
+
+    //
+    // An X3D document with scene.  LineSet is not implemented, so the
+    // profiles that include it cannot be used; Core with the VRML97
+    // component has the nodes these tests need.
+    //
+    const element document(const element & scene)
+    {
+        return element("X3D")
+            .attribute("profile", "Core")
+            .attribute("version", "3.0")
+            .child(element("head")
+                   .child(element("component")
+                          .attribute("name", "VRML97")
+                          .attribute("level", "1")))
+            .child(scene);
+    }
+
+    const element world()
+    {
+        return document(
+            element("Scene")
+            .child(element("Transform")
+                   .attribute("DEF", "T")
+                   .attribute("translation", "1 2 3")
+                   .child(element("Shape")
+                          .child(element("Box")
+                                 .attribute("size", "4 5 6"))))
+            .child(element("Group"))
+            .child(element("Group")));
+    }
+
+    //
+    // The nodes decoded are only good as long as the decoder.
+    //
+    class decoder {
+        test_resource_fetcher fetcher_;
+        browser browser_;
+
+    public:
+        decoder():
+            browser_(fetcher_, std::cout, std::cerr)
+        {}
+
+        const vector<boost::intrusive_ptr<node> >
+        decode(const string & data)
+        {
+            istringstream in(data);
+            return this->browser_.create_vrml_from_stream(
+                in,
+                x3d_binary_media_type);
+        }
+    };
+
+    void check_world(const vector<boost::intrusive_ptr<node> > & nodes)
+    {
+        BOOST_REQUIRE_EQUAL(nodes.size(), 3u);
+        BOOST_CHECK_EQUAL(nodes[0]->type().id(), "Transform");
+        BOOST_CHECK_EQUAL(nodes[0]->id(), "T");
+        BOOST_CHECK(nodes[0]->field<sfvec3f>("translation").value()
+                    == make_vec3f(1, 2, 3));
+        const vector<boost::intrusive_ptr<node> > children =
+            nodes[0]->field<mfnode>("children").value();
+        BOOST_REQUIRE_EQUAL(children.size(), 1u);
+        BOOST_CHECK_EQUAL(children[0]->type().id(), "Shape");
+        const boost::intrusive_ptr<node> box =
+            children[0]->field<sfnode>("geometry").value();
+        BOOST_REQUIRE(box);
+        BOOST_CHECK_EQUAL(box->type().id(), "Box");
+        BOOST_CHECK(box->field<sfvec3f>("size").value()
+                    == make_vec3f(4, 5, 6));
+        BOOST_CHECK_EQUAL(nodes[1]->type().id(), "Group");
+        BOOST_CHECK_EQUAL(nodes[2]->type().id(), "Group");
+    }
+
+    //
+    // The application encoding algorithms of ISO/IEC 19776-3.
+    //
+    const size_t quantized_algorithm = application_algorithm,
+        delta_algorithm = application_algorithm + 1;
+
+    const vector<string> x3d_algorithms()
+    {
+        vector<string> result;
+        result.push_back(
+            "encoder://web3d.org/QuantizedzlibFloatArrayEncoder");
+        result.push_back("encoder://web3d.org/DeltazlibIntArrayEncoder");
+        return result;
+    }
+
+    //
+    // The n least significant octets of value, most significant first.
+    //
+    const string big_endian(const boost::uint64_t value, const size_t n)
+    {
+        string result;
+        for (size_t i = n; i > 0; --i) {
+            result += char((value >> ((i - 1) * 8)) & 0xFF);
+        }
+        return result;
+    }
+
+    const string int32s(const int32 * const values, const size_t n,
+                        const size_t size)
+    {
+        string result;
+        for (size_t i = 0; i < n; ++i) {
+            result += big_endian(boost::uint64_t(boost::int64_t(values[i])),
+                                 size);
+        }
+        return result;
+    }
+
+    const string floats(const float * const values, const size_t n)
+    {
+        string result;
+        for (size_t i = 0; i < n; ++i) {
+            boost::uint32_t bits;
+            memcpy(&bits, &values[i], sizeof bits);
+            result += big_endian(bits, 4);
+        }
+        return result;
+    }
+
+    const string doubles(const double * const values, const size_t n)
+    {
+        string result;
+        for (size_t i = 0; i < n; ++i) {
+            boost::uint64_t bits;
+            memcpy(&bits, &values[i], sizeof bits);
+            result += big_endian(bits, 8);
+        }
+        return result;
+    }
+
+    const element face_set(const attribute_value & coord_index,
+                           const attribute_value & point)
+    {
+        return document(
+            element("Scene")
+            .child(element("Shape")
+                   .child(element("IndexedFaceSet")
+                          .attribute("coordIndex", coord_index)
+                          .child(element("Coordinate")
+                                 .attribute("point", point)))));
+    }
+
+    //
+    // Encode a document that lists the X3D encoding algorithms.
+    //
+    const string encode(const element & root)
+    {
+        return fi_encoder(true, x3d_algorithms()).document(root);
+    }
+
+    const int32 coord_index[] = { 0, 1, 2, -1 };
+    const size_t coord_index_size =
+        sizeof coord_index / sizeof coord_index[0];
+    const float point[] = { 0, 0, 0, 1.5f, 0, 0, 0, -2, 0.25f };
+    const size_t point_size = sizeof point / sizeof point[0];
+
+    //
+    // Decode a face set and check that it has coord_index and point.
+    //
+    void check_face_set(const attribute_value & coord_index_value,
+                        const attribute_value & point_value)
+    {
+        decoder d;
+        const vector<boost::intrusive_ptr<node> > nodes =
+            d.decode(encode(face_set(coord_index_value, point_value)));
+        BOOST_REQUIRE_EQUAL(nodes.size(), 1u);
+        const boost::intrusive_ptr<node> geometry =
+            nodes[0]->field<sfnode>("geometry").value();
+        BOOST_REQUIRE(geometry);
+        BOOST_CHECK(geometry->field<mfint32>("coordIndex").value()
+                    == vector<int32>(coord_index,
+                                     coord_index + coord_index_size));
+        const boost::intrusive_ptr<node> coord =
+            geometry->field<sfnode>("coord").value();
+        BOOST_REQUIRE(coord);
+        const vector<vec3f> & points = coord->field<mfvec3f>("point").value();
+        BOOST_REQUIRE_EQUAL(points.size(), point_size / 3);
+        for (size_t i = 0; i < points.size(); ++i) {
+            BOOST_CHECK(points[i] == make_vec3f(point[i * 3],
+                                                point[i * 3 + 1],
+                                                point[i * 3 + 2]));
+        }
+    }
+
+    void check_rejected(const attribute_value & coord_index_value,
+                        const attribute_value & point_value)
+    {
+        decoder d;
+        BOOST_CHECK_THROW(
+            d.decode(encode(face_set(coord_index_value, point_value))),
+            invalid_vrml);
+    }
+
+# ifdef OPENVRML_ENABLE_GZIP
+    const string compressed(const string & octets)
+    {
+        uLongf size = compressBound(uLong(octets.size()));
+        vector<Bytef> out(size);
+        BOOST_REQUIRE_EQUAL(
+            compress(&out[0], &size,
+                     reinterpret_cast<const Bytef *>(octets.data()),
+                     uLong(octets.size())),
+            Z_OK);
+        return string(out.begin(), out.begin() + size);
+    }
+
+    //
+    // The quantized float array encoding of values, which must be zero or
+    // normal numbers in the format given.
+    //
+    const string quantized(const unsigned exponent_bits,
+                           const unsigned mantissa_bits,
+                           const float * const values,
+                           const size_t n)
+    {
+        const size_t bits = 1 + exponent_bits + mantissa_bits;
+        const int bias = (1 << (exponent_bits - 1)) - 1;
+        string packed((n * bits + 7) / 8, '\0');
+        size_t pos = 0;
+        for (size_t i = 0; i < n; ++i) {
+            boost::uint64_t value = 0;
+            if (values[i] != 0) {
+                int exponent;
+                const double fraction = frexp(fabs(values[i]), &exponent);
+                value = (values[i] < 0) ? 1 : 0;
+                value = (value << exponent_bits)
+                    | boost::uint64_t(exponent - 1 + bias);
+                value = (value << mantissa_bits)
+                    | boost::uint64_t(ldexp(2 * fraction - 1,
+                                            mantissa_bits));
+            }
+            for (size_t bit = bits; bit > 0; --bit, ++pos) {
+                if ((value >> (bit - 1)) & 1) {
+                    packed[pos >> 3] |= char(0x80 >> (pos & 7));
+                }
+            }
+        }
+        return string(1, char(exponent_bits)) + char(mantissa_bits)
+            + big_endian(n, 4) + compressed(packed);
+    }
+
+    //
+    // The delta integer array encoding of values.
+    //
+    const string delta(const int32 * const values, const size_t n,
+                       const size_t span)
+    {
+        string deltas;
+        for (size_t i = 0; i < n; ++i) {
+            const int32 base = (i >= span) ? values[i - span] : 0;
+            deltas += big_endian(boost::uint32_t(values[i] - base), 4);
+        }
+        return big_endian(n, 4) + char(span) + compressed(deltas);
+    }
+# endif // defined OPENVRML_ENABLE_GZIP
+}
+
+BOOST_AUTO_TEST_CASE(literal_names_round_trip)
+{
+    decoder d;
+    check_world(d.decode(fi_encoder(false).document(world())));
+}
+
+BOOST_AUTO_TEST_CASE(x3d_vocabulary_round_trip)
+{
+    decoder d;
+    check_world(d.decode(fi_encoder(true).document(world())));
+}
+
+//
+// Names written as indices into the tables of ISO/IEC 19776-3, with the
+// profile attribute, which is not in the first 64, as a literal.  The
+// comments give the one-based indices of the standard.
+//
+BOOST_AUTO_TEST_CASE(decode_x3d_vocabulary_indices)
+{
+    static const unsigned char data[] = {
+        0xE0, 0x00, 0x00, 0x01,
+        0x20, 0x10, 0x00,
+        22, 'u', 'r', 'n', ':', 'e', 'x', 't', 'e', 'r', 'n', 'a', 'l', '-',
+            'v', 'o', 'c', 'a', 'b', 'u', 'l', 'a', 'r', 'y',
+        0x60, 106,                      // X3D (139), with attributes
+        0x78, 6, 'p', 'r', 'o', 'f', 'i', 'l', 'e',
+        0x03, 'C', 'o', 'r', 'e',
+        0xF0,
+        0x20, 110,                      // head (143)
+        0x60, 107,                      // component (140), with attributes
+        0x07, 0x05, 'V', 'R', 'M', 'L', '9', '7', // name (8)
+        0x40, 87, 0x00, '1',            // level (152)
+        0xF0,
+        0xF0,                           // end of component
+        0xF0,                           // end of head
+        0x20, 86,                       // Scene (119)
+        0x45,                           // Transform (6), with attributes
+        0x11, 4, '1', ' ', '2', ' ', '3', // translation (18)
+        0xF0,
+        0x00,                           // Shape (1)
+        0xF0,
+        0xF0,                           // end of Transform
+        0xFF,                           // end of Scene and X3D
+        0xF0
+    };
+    decoder d;
+    const vector<boost::intrusive_ptr<node> > nodes =
+        d.decode(string(data, data + sizeof data));
+    BOOST_REQUIRE_EQUAL(nodes.size(), 1u);
+    BOOST_CHECK_EQUAL(nodes[0]->type().id(), "Transform");
+    BOOST_CHECK(nodes[0]->field<sfvec3f>("translation").value()
+                == make_vec3f(1, 2, 3));
+    const vector<boost::intrusive_ptr<node> > children =
+        nodes[0]->field<mfnode>("children").value();
+    BOOST_REQUIRE_EQUAL(children.size(), 1u);
+    BOOST_CHECK_EQUAL(children[0]->type().id(), "Shape");
+}
+
+BOOST_AUTO_TEST_CASE(unknown_external_vocabulary_is_rejected)
+{
+    static const unsigned char data[] = {
+        0xE0, 0x00, 0x00, 0x01,
+        0x20, 0x10, 0x00,
+        8, 'u', 'r', 'n', ':', 'o', 't', 'h', 'e', 'r',
+        0x00,
+        0xF0
+    };
+    decoder d;
+    BOOST_CHECK_THROW(d.decode(string(data, data + sizeof data)),
+                      invalid_vrml);
+}
+
+BOOST_AUTO_TEST_CASE(builtin_algorithm_arrays_decode)
+{
+    check_face_set(
+        attribute_value(int_algorithm,
+                        int32s(coord_index, coord_index_size, 4)),
+        attribute_value(float_algorithm, floats(point, point_size)));
+
+    const vector<double> double_point(point, point + point_size);
+    check_face_set(
+        attribute_value(short_algorithm,
+                        int32s(coord_index, coord_index_size, 2)),
+        attribute_value(double_algorithm,
+                        doubles(&double_point[0], double_point.size())));
+    check_face_set(
+        attribute_value(long_algorithm,
+                        int32s(coord_index, coord_index_size, 8)),
+        "0 0 0 1.5 0 0 0 -2 0.25");
+}
+
+BOOST_AUTO_TEST_CASE(truncated_arrays_are_rejected)
+{
+    const string ints = int32s(coord_index, coord_index_size, 4);
+    const string point_floats = floats(point, point_size);
+    check_rejected(attribute_value(short_algorithm, ints.substr(0, 3)),
+                   attribute_value(float_algorithm, point_floats));
+    check_rejected(attribute_value(int_algorithm, ints.substr(0, 6)),
+                   attribute_value(float_algorithm, point_floats));
+    check_rejected(attribute_value(long_algorithm, ints.substr(0, 12)),
+                   attribute_value(float_algorithm, point_floats));
+    check_rejected(attribute_value(int_algorithm, ints),
+                   attribute_value(float_algorithm,
+                                   point_floats.substr(0, 6)));
+    check_rejected(attribute_value(int_algorithm, ints),
+                   attribute_value(double_algorithm,
+                                   point_floats.substr(0, 12)));
+}
+
+BOOST_AUTO_TEST_CASE(out_of_range_numbers_are_rejected)
+{
+    const attribute_value point_floats(float_algorithm,
+                                       floats(point, point_size));
+
+    static const boost::int64_t too_big[] = {
+        0, 1, boost::int64_t(1) << 40, -1
+    };
+    string too_big_octets;
+    for (size_t i = 0; i < 4; ++i) {
+        too_big_octets += big_endian(boost::uint64_t(too_big[i]), 8);
+    }
+    check_rejected(attribute_value(long_algorithm, too_big_octets),
+                   point_floats);
+
+    static const double fraction[] = { 0, 1, 1.5, -1 };
+    check_rejected(attribute_value(double_algorithm, doubles(fraction, 4)),
+                   point_floats);
+
+    static const double overflow[] = { 0, 0, 1.0e300 };
+    check_rejected(attribute_value(int_algorithm,
+                                   int32s(coord_index, coord_index_size, 4)),
+                   attribute_value(double_algorithm, doubles(overflow, 3)));
+}
+
+BOOST_AUTO_TEST_CASE(unknown_algorithm_is_rejected)
+{
+    const attribute_value point_floats(float_algorithm,
+                                       floats(point, point_size));
+    check_rejected(attribute_value(application_algorithm + 2,
+                                   int32s(coord_index, coord_index_size, 4)),
+                   point_floats);
+
+    vector<string> algorithms;
+    algorithms.push_back("encoder://example.org/UnknownEncoder");
+    decoder d;
+    BOOST_CHECK_THROW(
+        d.decode(fi_encoder(true, algorithms).document(
+                     face_set(attribute_value(int_algorithm,
+                                              int32s(coord_index,
+                                                     coord_index_size,
+                                                     4)),
+                              attribute_value(application_algorithm,
+                                              floats(point, point_size))))),
+        invalid_vrml);
+}
+
+# ifdef OPENVRML_ENABLE_GZIP
+BOOST_AUTO_TEST_CASE(quantized_float_array_decodes)
+{
+    const attribute_value ints(int_algorithm,
+                               int32s(coord_index, coord_index_size, 4));
+
+    //
+    // Single precision, and a 12-bit format whose values straddle octets.
+    //
+    check_face_set(ints,
+                   attribute_value(quantized_algorithm,
+                                   quantized(8, 23, point, point_size)));
+    check_face_set(ints,
+                   attribute_value(quantized_algorithm,
+                                   quantized(5, 6, point, point_size)));
+}
+
+BOOST_AUTO_TEST_CASE(corrupt_quantized_float_array_is_rejected)
+{
+    const attribute_value ints(int_algorithm,
+                               int32s(coord_index, coord_index_size, 4));
+    const string valid = quantized(5, 6, point, point_size);
+
+    check_rejected(ints, attribute_value(quantized_algorithm,
+                                         valid.substr(0, 5)));
+    check_rejected(ints, attribute_value(quantized_algorithm,
+                                         valid.substr(0, valid.size() - 4)));
+
+    string too_many_exponent_bits = valid;
+    too_many_exponent_bits[0] = 12;
+    check_rejected(ints, attribute_value(quantized_algorithm,
+                                         too_many_exponent_bits));
+
+    //
+    // A count that claims more values than the stream inflates to.
+    //
+    string wrong_count = valid;
+    wrong_count.replace(2, 4, big_endian(point_size + 3, 4));
+    check_rejected(ints, attribute_value(quantized_algorithm, wrong_count));
+}
+
+BOOST_AUTO_TEST_CASE(delta_int_array_decodes)
+{
+    const attribute_value point_floats(float_algorithm,
+                                       floats(point, point_size));
+    check_face_set(attribute_value(delta_algorithm,
+                                   delta(coord_index, coord_index_size, 1)),
+                   point_floats);
+    check_face_set(attribute_value(delta_algorithm,
+                                   delta(coord_index, coord_index_size, 2)),
+                   point_floats);
+}
+
+BOOST_AUTO_TEST_CASE(corrupt_delta_int_array_is_rejected)
+{
+    const attribute_value point_floats(float_algorithm,
+                                       floats(point, point_size));
+    const string valid = delta(coord_index, coord_index_size, 1);
+
+    check_rejected(attribute_value(delta_algorithm, valid.substr(0, 4)),
+                   point_floats);
+    check_rejected(attribute_value(delta_algorithm,
+                                   valid.substr(0, valid.size() - 4)),
+                   point_floats);
+
+    string zero_span = valid;
+    zero_span[4] = 0;
+    check_rejected(attribute_value(delta_algorithm, zero_span),
+                   point_floats);
+
+    string wrong_count = valid;
+    wrong_count.replace(0, 4, big_endian(coord_index_size + 1, 4));
+    check_rejected(attribute_value(delta_algorithm, wrong_count),
+                   point_floats);
+}
+# endif // defined OPENVRML_ENABLE_GZIP